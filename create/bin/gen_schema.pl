@@ -722,9 +722,9 @@ sub unix_timestamp()
 	}
 }
 
-sub open_trigger($)
+sub open_trigger($;$)
 {
-	my $type = shift;
+	my ($type, $condition) = @_;
 	my $out;
 
 	$out = "create trigger ${table_name}_${type} ";
@@ -742,30 +742,41 @@ sub open_trigger($)
 	}
 
 	$out .= " on ${table_name}${eol}\n";
-	$out .= "for each row${eol}\n";
 
 	if ($output{"database"} eq "mysql")
 	{
+		$out .= "for each row${eol}\n";
+
+		if ($condition)
+		{
+			$out .= "begin${eol}\n";
+			$out .= "if ${condition} then${eol}\n";
+		}
+
 		$out .= "insert into changelog (object,objectid,operation,clock)${eol}\n";
 	}
 	elsif ($output{"database"} eq "sqlite3")
 	{
+		$out .= "for each row" . ($condition ? " when ${condition}" : "") . "${eol}\n";
 		$out .= "begin${eol}\n";
 		$out .= "insert into changelog (object,objectid,operation,clock)${eol}\n";
 	}
 	elsif ($output{"database"} eq "postgresql")
 	{
+		$out .= "for each row" . ($condition ? " when (${condition})" : "") . "${eol}\n";
 		$out .= "execute procedure changelog_${table_name}_${type}();${eol}\n";
 	}
 
 	return $out;
 }
 
-sub close_trigger()
+sub close_trigger(;$)
 {
+	my $condition = shift;
+
 	if ($output{"database"} eq "mysql")
 	{
-		return "\$\$${eol}\n";
+		return ($condition ? "end if;${eol}\nend" : "") . "\$\$${eol}\n";
 	}
 	elsif ($output{"database"} eq "postgresql")
 	{
@@ -810,15 +821,29 @@ sub close_function($)
 	return $out;
 }
 
+# CHANGELOG|<object>[|<flags>[|<columns>]]
+#   flags   - CASCADE: allow foreign keys with cascade delete, the rows deleted by cascade
+#             are not guaranteed to be logged and must be handled by parent object removal
+#   columns - comma separated list of columns, log row updates only when these columns
+#             are changed (all updates are logged by default)
 sub process_changelog($)
 {
-	my $table_type = shift;
+	my ($table_type, $flags, $columns) = split(/\|/, shift, 3);
+	my $condition;
 
-	if ($delete_cascade)
+	$flags = rtrim($flags);
+	$columns = rtrim($columns);
+
+	if ($delete_cascade && (not $flags or $flags ne "CASCADE"))
 	{
 		die("table '$table_name' foreign keys without RESTRICT flag are not compatible with table CHANGELOG token");
 	}
 
+	if ($columns)
+	{
+		$condition = join(" or ", map { "old.$_<>new.$_" } split(/,/, $columns));
+	}
+
 	if (exists($table_types{$table_type}) && $table_types{$table_type} ne $table_name)
 	{
 		die("cannot use table type '$table_type' for table '$table_name', it was already used for table '$table_types{$table_type}'");
@@ -837,9 +862,9 @@ sub process_changelog($)
 		$triggers .= "values (${table_type},new.${pkey_name},1,${unix_timestamp});${eol}\n";
 		$triggers .= close_trigger();
 
-		$triggers .= open_trigger('update');
+		$triggers .= open_trigger('update', $condition);
 		$triggers .= "values (${table_type},old.${pkey_name},2,${unix_timestamp});${eol}\n";
-		$triggers .= close_trigger();
+		$triggers .= close_trigger($condition);
 
 		$triggers .= open_trigger('delete');
 		$triggers .= "values (${table_type},old.${pkey_name},3,${unix_timestamp});${eol}\n";
@@ -856,7 +881,7 @@ sub process_changelog($)
 		$triggers .= open_function('update');
 		$triggers .= "values (${table_type},old.${pkey_name},2,${unix_timestamp});${eol}\n";
 		$triggers .= close_function('update');
-		$triggers .= open_trigger('update');
+		$triggers .= open_trigger('update', $condition);
 		$triggers .= close_trigger();
 
 		$triggers .= open_function('delete');
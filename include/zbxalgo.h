@@ -244,6 +244,7 @@ void	zbx_hashmap_clear(zbx_hashmap_t *hm);
 
 #define ZBX_BINARY_HEAP_OPTION_EMPTY	0
 #define ZBX_BINARY_HEAP_OPTION_DIRECT	(1<<0)	/* support for direct update() and remove() operations */
+#define ZBX_BINARY_HEAP_OPTION_INDEX	(1<<1)	/* direct operations with position stored in element data */
 
 typedef struct
 {
@@ -260,6 +261,7 @@ typedef struct
 	int			options;
 	zbx_compare_func_t	compare_func;
 	zbx_hashmap_t		*key_index;
+	size_t			index_offset;
 
 	/* The binary heap is designed to work correctly only with memory allocation functions */
 	/* that return pointer to the allocated memory or quit. Functions that can return NULL */
@@ -277,6 +279,10 @@ void			zbx_binary_heap_create_ext(zbx_binary_heap_t *heap, zbx_compare_func_t co
 							int options, zbx_mem_malloc_func_t mem_malloc_func,
 							zbx_mem_realloc_func_t mem_realloc_func,
 							zbx_mem_free_func_t mem_free_func);
+void			zbx_binary_heap_create_index_ext(zbx_binary_heap_t *heap, zbx_compare_func_t compare_func,
+							size_t index_offset, zbx_mem_malloc_func_t mem_malloc_func,
+							zbx_mem_realloc_func_t mem_realloc_func,
+							zbx_mem_free_func_t mem_free_func);
 void			zbx_binary_heap_destroy(zbx_binary_heap_t *heap);
 
 int			zbx_binary_heap_empty(const zbx_binary_heap_t *heap);
@@ -285,6 +291,7 @@ void			zbx_binary_heap_insert(zbx_binary_heap_t *heap, zbx_binary_heap_elem_t *e
 void			zbx_binary_heap_update_direct(zbx_binary_heap_t *heap, zbx_binary_heap_elem_t *elem);
 void			zbx_binary_heap_remove_min(zbx_binary_heap_t *heap);
 void			zbx_binary_heap_remove_direct(zbx_binary_heap_t *heap, zbx_uint64_t key);
+void			zbx_binary_heap_remove_index(zbx_binary_heap_t *heap, const zbx_binary_heap_elem_t *elem);
 
 void			zbx_binary_heap_clear(zbx_binary_heap_t *heap);
 
@@ -245,6 +245,27 @@ typedef struct
 }
 zbx_history_sync_item_t;
 
+/* item data used to enrich exported history and trends */
+typedef struct
+{
+	zbx_uint64_t		itemid;
+	char			*name;
+	zbx_vector_tags_ptr_t	item_tags;	/* sorted item tags */
+}
+zbx_history_export_item_t;
+
+ZBX_PTR_VECTOR_DECL(history_export_item_ptr, zbx_history_export_item_t *)
+
+/* host data used to enrich exported history and trends */
+typedef struct
+{
+	zbx_uint64_t		hostid;
+	zbx_vector_str_t	groups;		/* sorted host group names */
+}
+zbx_history_export_host_t;
+
+ZBX_PTR_VECTOR_DECL(history_export_host_ptr, zbx_history_export_host_t *)
+
 typedef struct
 {
 	zbx_uint64_t	hostid;
@@ -779,8 +800,11 @@ void	zbx_dc_sync_kvs_paths(const struct zbx_json_parse *jp_kvs_paths, const zbx_
 		const char *config_source_ip, const char *config_ssl_ca_location, const char *config_ssl_cert_location,
 		const char *config_ssl_key_location);
 void	zbx_dc_config_get_hostids_by_revision(zbx_uint64_t new_revision, zbx_vector_uint64_t *hostids);
+int	zbx_dc_get_host_revision(zbx_uint64_t hostid, zbx_uint64_t *revision);
+zbx_uint64_t	zbx_dc_get_lld_prototypes_revision(void);
 int	zbx_init_configuration_cache(zbx_get_program_type_f get_program_type, zbx_get_config_forks_f get_config_forks,
-		zbx_uint64_t conf_cache_size, const char *hostname, char **error);
+		zbx_uint64_t conf_cache_size, const char *hostname, const char *snapshot_file, int cache_slabs,
+		char **error);
 void	zbx_free_configuration_cache(void);
 
 void	zbx_dc_config_get_triggers_by_triggerids(zbx_dc_trigger_t *triggers, const zbx_uint64_t *triggerids,
@@ -801,6 +825,9 @@ void	zbx_dc_config_history_sync_get_triggers_by_itemids(zbx_hashset_t *trigger_i
 		int itemids_num);
 void	zbx_dc_config_clean_history_sync_items(zbx_history_sync_item_t *items, int *errcodes, size_t num);
 void	zbx_dc_config_history_sync_unset_existing_itemids(zbx_vector_uint64_t *itemids);
+zbx_uint64_t	zbx_dc_config_history_sync_get_revision(void);
+void	zbx_dc_config_history_sync_get_export_data(zbx_vector_history_export_item_ptr_t *items,
+		zbx_vector_history_export_host_ptr_t *hosts);
 int	zbx_dc_config_history_get_trends_sec(const char *trends_period, int trends_global, int hk_trends);
 
 void	zbx_dc_config_history_recv_get_items_by_keys(zbx_history_recv_item_t *items, const zbx_host_key_t *keys,
@@ -872,7 +899,8 @@ int	zbx_dc_config_get_ipmi_poller_items(int now, int items_num, int config_timeo
 		int *nextcheck);
 #endif
 int	zbx_dc_config_get_snmp_interfaceids_by_addr(const char *addr, zbx_uint64_t **interfaceids);
-size_t	zbx_dc_config_get_snmp_items_by_interfaceid(zbx_uint64_t interfaceid, zbx_dc_item_t **items);
+size_t	zbx_dc_config_get_snmp_items_by_interfaceid(zbx_uint64_t interfaceid, zbx_dc_item_t **items,
+		zbx_uint64_t *revision);
 
 void	zbx_dc_config_update_autoreg_host(const char *host, const char *listen_ip, const char *listen_dns,
 		unsigned short listen_port, const char *host_metadata, zbx_conn_flags_t flags, int now);
@@ -1082,6 +1110,7 @@ typedef struct
 	zbx_uint64_t	connector;
 	zbx_uint64_t	proxy_group;		/* summary revision of all proxy groups */
 	zbx_uint64_t	proxy;			/* summary revision of all proxies */
+	zbx_uint64_t	lld_prototypes;		/* revision of changelog tracked LLD prototype objects */
 }
 zbx_dc_revision_t;
 
@@ -30,6 +30,10 @@
 /* the maximum number of items in one synchronization batch */
 #define ZBX_HC_SYNC_MAX		1000
 #define ZBX_HC_TIMER_MAX	(ZBX_HC_SYNC_MAX / 2)
+
+/* the maximum number of independently locked history cache partitions, */
+/* the actual number is based on the number of history syncers          */
+#define ZBX_HC_SHARDS_MAX	8
 #define ZBX_HC_TIMER_SOFT_MAX	(ZBX_HC_TIMER_MAX - 10)
 
 #define ZBX_SYNC_DONE		0
@@ -137,6 +141,7 @@ void	zbx_dc_add_history(zbx_uint64_t itemid, unsigned char item_value_type, unsi
 void	zbx_dc_add_history_variant(zbx_uint64_t itemid, unsigned char value_type, unsigned char item_flags,
 		zbx_variant_t *value, zbx_timespec_t ts, const zbx_pp_value_opt_t *value_opt);
 size_t	zbx_dc_flush_history(void);
+void	zbx_hc_set_sync_shard(int process_num);
 void	zbx_hc_pop_items(zbx_vector_hc_item_ptr_t *history_items);
 void	zbx_hc_get_item_values(zbx_dc_history_t *history, zbx_vector_hc_item_ptr_t *history_items);
 void	zbx_hc_push_items(zbx_vector_hc_item_ptr_t *history_items);
@@ -148,7 +153,7 @@ typedef void (*zbx_history_sync_f)(int *values_num, int *triggers_num, const zbx
 
 int	zbx_init_database_cache(zbx_get_program_type_f get_program_type, zbx_history_sync_f sync_history,
 		zbx_uint64_t history_cache_size, zbx_uint64_t history_index_cache_size, zbx_uint64_t *trends_cache_size,
-		char **error);
+		int history_syncers_num, int cache_slabs, char **error);
 
 void	zbx_free_database_cache(int sync, const zbx_events_funcs_t *events_cbs, int config_history_storage_pipelines);
 
@@ -158,6 +163,40 @@ void	zbx_dc_update_interfaces_availability(void);
 void	zbx_hc_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num);
 void	zbx_hc_get_mem_stats(zbx_shmem_stats_t *data, zbx_shmem_stats_t *index);
 void	zbx_hc_get_items(zbx_vector_uint64_pair_t *items);
+
+/* history cache partition statistics */
+typedef struct
+{
+	zbx_uint64_t	items_num;	/* the number of cached items */
+	zbx_uint64_t	values_num;	/* the number of cached values */
+	zbx_uint64_t	queue_num;	/* the number of items queued for synchronization */
+	zbx_uint64_t	mem_used;	/* the used value memory size */
+	zbx_uint64_t	mem_total;	/* the total value memory size */
+}
+zbx_hc_shard_stats_t;
+
+int	zbx_hc_get_shard_stats(zbx_hc_shard_stats_t *stats);
+
+/* history synchronization stages, used to account time spent by history syncers */
+#define ZBX_HC_SYNC_STAGE_PREPARE	0
+#define ZBX_HC_SYNC_STAGE_HISTORY	1
+#define ZBX_HC_SYNC_STAGE_TRENDS	2
+#define ZBX_HC_SYNC_STAGE_ITEMS		3
+#define ZBX_HC_SYNC_STAGE_TRIGGERS	4
+#define ZBX_HC_SYNC_STAGE_EXPORT	5
+#define ZBX_HC_SYNC_STAGE_COUNT		6
+
+void	zbx_hc_add_sync_stage_time(const double *stage_time);
+double	zbx_hc_get_sync_stage_time(int stage);
+
+/* trigger function counters, used to show the evaluations saved by sharing function results */
+#define ZBX_HC_TRIGGER_FUNCS_REFERENCES	0
+#define ZBX_HC_TRIGGER_FUNCS_UNIQUE	1
+#define ZBX_HC_TRIGGER_FUNCS_EVALUATED	2
+#define ZBX_HC_TRIGGER_FUNCS_COUNT	3
+
+void	zbx_hc_add_trigger_funcs_stats(const zbx_uint64_t *stats);
+zbx_uint64_t	zbx_hc_get_trigger_funcs_stats(int counter);
 int	zbx_db_trigger_queue_locked(void);
 void	zbx_db_trigger_queue_unlock(void);
 zbx_uint64_t	zbx_hc_proxyqueue_peek(void);
@@ -169,7 +208,7 @@ void	zbx_dbcache_unlock(void);
 void	zbx_dbcache_set_history_num(int num);
 int	zbx_dbcache_get_history_num(void);
 
-zbx_shmem_info_t	*zbx_dbcache_get_hc_mem(void);
+double	zbx_dbcache_get_hc_pused(void);
 
 void	zbx_dbcache_setproxyqueue_state(int proxyqueue_state);
 int	zbx_dbcache_getproxyqueue_state(void);
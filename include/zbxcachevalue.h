@@ -45,6 +45,9 @@
  *   either zbx_history_record_vector_destroy() function (free the zbx_vc_get_values()
  *   call output) or zbx_history_record_clear() function (free the zbx_vc_get_value() call output).
  *
+ *   Functions needing only the number of values or their minimum, maximum, sum or average
+ *   should use zbx_vc_get_aggregate() which aggregates values in place without copying them.
+ *
  * Locking
  *
  *   The cache ensures synchronization between processes by using automatic locks whenever
@@ -89,9 +92,22 @@ zbx_vc_item_stats_t;
 
 ZBX_PTR_VECTOR_DECL(vc_item_stats_ptr, zbx_vc_item_stats_t *)
 
+/* aggregated item history values, see zbx_vc_get_aggregate() */
+typedef struct
+{
+	int			values_num;
+
+	/* minimum, maximum, sum and average are set only for numeric items */
+	zbx_history_value_t	min;
+	zbx_history_value_t	max;
+	zbx_history_value_t	sum;
+	double			avg;
+}
+zbx_vc_aggregate_t;
+
 void	zbx_vc_item_stats_free(zbx_vc_item_stats_t *vc_item_stats);
 
-int	zbx_vc_init(zbx_uint64_t value_cache_size, char **error);
+int	zbx_vc_init(zbx_uint64_t value_cache_size, int value_cache_compression, int cache_slabs, char **error);
 
 void	zbx_vc_destroy(void);
 
@@ -104,6 +120,9 @@ void	zbx_vc_disable(void);
 int	zbx_vc_get_values(zbx_uint64_t itemid, unsigned char value_type, zbx_vector_history_record_t *values,
 		int seconds, int count, const zbx_timespec_t *ts);
 
+int	zbx_vc_get_aggregate(zbx_uint64_t itemid, unsigned char value_type, int seconds, int count,
+		const zbx_timespec_t *ts, zbx_vc_aggregate_t *aggregate);
+
 int	zbx_vc_get_value(zbx_uint64_t itemid, unsigned char value_type, const zbx_timespec_t *ts,
 		zbx_history_record_t *value);
 
@@ -17,6 +17,7 @@
 
 #include "zbxalgo.h"
 #include "zbxtime.h"
+#include "zbxcompress.h"
 
 #define ZBX_IPV4_MAX_CIDR_PREFIX	32	/* max number of bits in IPv4 CIDR prefix */
 #define ZBX_IPV6_MAX_CIDR_PREFIX	128	/* max number of bits in IPv6 CIDR prefix */
@@ -172,8 +173,13 @@ typedef struct
 	char	psk_buf[HOST_TLS_PSK_LEN / 2];
 	int	psk_len;
 	size_t	identity_len;
+	/* PSK identity captured from server callback function for incoming connection */
+	int	incoming_has_psk;
+	char	incoming_psk_id[PSK_MAX_IDENTITY_LEN + 1];
 #endif
 #endif
+	/* if PSK of incoming connection was found among host PSKs or autoregistration PSK */
+	unsigned int	psk_usage;
 } zbx_tls_context_t;
 #endif
 
@@ -216,6 +222,8 @@ typedef struct
 	unsigned char	expect;
 	int		protocol_version;
 	size_t		allocated;
+	/* decompresses large compressed messages as they arrive, kept between non-blocking reads */
+	zbx_uncompress_stream_t	*stream;
 }
 zbx_tcp_recv_context_t;
 
@@ -292,7 +300,10 @@ int	zbx_tcp_listen(zbx_socket_t *s, const char *listen_ip, unsigned short listen
 void	zbx_tcp_unlisten(zbx_socket_t *s);
 
 int	zbx_tcp_accept(zbx_socket_t *s, unsigned int tls_accept, int poll_timeout);
+int	zbx_tcp_accept_socket(zbx_socket_t *s, int poll_timeout);
+int	zbx_tcp_accept_handshake(zbx_socket_t *s, unsigned int tls_accept, short *events);
 void	zbx_tcp_unaccept(zbx_socket_t *s);
+void	zbx_tcp_accept_detach(zbx_socket_t *s, zbx_socket_t *conn);
 
 #define ZBX_TCP_READ_UNTIL_CLOSE 0x01
 
@@ -308,6 +319,7 @@ ssize_t		zbx_tcp_recv_raw_ext(zbx_socket_t *s, int timeout);
 const char	*zbx_tcp_recv_line(zbx_socket_t *s);
 
 void	zbx_tcp_recv_context_init(zbx_socket_t *s, zbx_tcp_recv_context_t *tcp_recv_context, unsigned char flags);
+void	zbx_tcp_recv_context_clear(zbx_tcp_recv_context_t *tcp_recv_context);
 ssize_t	zbx_tcp_recv_context(zbx_socket_t *s, zbx_tcp_recv_context_t *context, unsigned char flags, short *events);
 ssize_t	zbx_tcp_recv_context_raw(zbx_socket_t *s, zbx_tcp_recv_context_t *context, short *events, int once);
 const char	*zbx_tcp_recv_context_line(zbx_socket_t *s, zbx_tcp_recv_context_t *context, short *events);
@@ -454,7 +466,7 @@ int		zbx_tls_validate_attr(const zbx_tls_conn_attr_t *attr, const char *tls_issu
 				const char *tls_psk_identity, const char **msg);
 int		zbx_check_server_issuer_subject(const zbx_socket_t *sock, const char *allowed_issuer,
 				const char *allowed_subject, char **error);
-unsigned int	zbx_tls_get_psk_usage(void);
+unsigned int	zbx_tls_get_psk_usage(const zbx_socket_t *s);
 
 /* TLS BLOCK END */
 
@@ -73,6 +73,7 @@ int	zbx_curl_setopt_ssl_version(CURL *easyhandle, char **error);
 int	zbx_curl_has_ssl(char **error);
 int	zbx_curl_has_bearer(char **error);
 int	zbx_curl_has_smtp_auth(char **error);
+int	zbx_curl_has_multi_wait(char **error);
 int	zbx_curl_good_for_elasticsearch(char **error);
 
 #endif /* HAVE_LIBCURL */
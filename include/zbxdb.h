@@ -55,6 +55,7 @@ typedef struct
 	char	*config_db_tls_cipher_13;
 	int	config_dbport;
 	int	read_only_recoverable;
+	int	config_db_bulk_copy;
 }
 zbx_config_dbhigh_t;
 
@@ -105,6 +106,10 @@ zbx_err_codes_t	zbx_db_last_errcode(void);
 
 #ifdef HAVE_POSTGRESQL
 int	zbx_tsdb_get_version(void);
+
+int	zbx_db_copy_start_basic(const char *table, const char *fields, char **error);
+int	zbx_db_copy_put_basic(const char *data, size_t len);
+int	zbx_db_copy_end_basic(char **error);
 #endif
 
 #if defined (HAVE_MYSQL)
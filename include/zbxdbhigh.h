@@ -669,6 +669,8 @@ typedef struct
 	int				autoincrement;
 	/* the last id assigned by autoincrement */
 	zbx_uint64_t			lastid;
+	/* 1 - rows are inserted with binary COPY, string values are stored unescaped */
+	unsigned char			copy;
 }
 zbx_db_insert_t;
 
@@ -680,6 +682,7 @@ void	zbx_db_insert_add_values(zbx_db_insert_t *self, ...);
 int	zbx_db_insert_execute(zbx_db_insert_t *self);
 void	zbx_db_insert_clean(zbx_db_insert_t *self);
 void	zbx_db_insert_autoincrement(zbx_db_insert_t *self, const char *field_name);
+void	zbx_db_insert_enable_copy(zbx_db_insert_t *self);
 zbx_uint64_t	zbx_db_insert_get_lastid(zbx_db_insert_t *self);
 
 int	zbx_db_get_database_type(void);
@@ -21,6 +21,7 @@
 #include "zbxshmem.h"
 
 #define ZBX_DIAG_PREPROC_INFO	0x00000001
+#define ZBX_DIAG_PREPROC_QUEUE	0x00000002
 #define ZBX_DIAG_PREPROC_SIMPLE	(ZBX_DIAG_PREPROC_INFO)
 
 typedef enum
@@ -51,7 +51,18 @@ typedef enum
 	ZBX_MUTEX_TREND_FUNC,
 	ZBX_MUTEX_REMOTE_COMMANDS,
 	ZBX_MUTEX_PROXY_BUFFER,
+	ZBX_MUTEX_PROXY_BUFFER_FILE,
 	ZBX_MUTEX_VPS_MONITOR,
+	ZBX_MUTEX_CACHE_INDEX,
+	/* history cache shard locks, the number must match ZBX_HC_SHARDS_MAX */
+	ZBX_MUTEX_CACHE_SHARD_0,
+	ZBX_MUTEX_CACHE_SHARD_1,
+	ZBX_MUTEX_CACHE_SHARD_2,
+	ZBX_MUTEX_CACHE_SHARD_3,
+	ZBX_MUTEX_CACHE_SHARD_4,
+	ZBX_MUTEX_CACHE_SHARD_5,
+	ZBX_MUTEX_CACHE_SHARD_6,
+	ZBX_MUTEX_CACHE_SHARD_7,
 	/* NOTE: Do not forget to sync changes here with mutex names in diag_add_locks_info()! */
 	ZBX_MUTEX_COUNT
 }
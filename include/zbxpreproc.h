@@ -25,6 +25,7 @@
 #include "zbxjson.h"
 #include "zbxstats.h"
 #include "zbxcachehistory.h"
+#include "zbxregexp.h"
 
 #define ZBX_PREPROCESSING_BATCH_SIZE	256
 
@@ -99,6 +100,20 @@ zbx_pp_sequence_stats_t;
 
 ZBX_PTR_VECTOR_DECL(pp_sequence_stats_ptr, zbx_pp_sequence_stats_t *)
 
+/* preprocessing task queue contention statistics */
+typedef struct
+{
+	zbx_uint64_t	shards_num;
+	zbx_uint64_t	locks_num;			/* task shard lock acquisitions */
+	zbx_uint64_t	locks_contended_num;		/* task shard lock acquisitions that had to wait */
+	zbx_uint64_t	steals_num;			/* tasks taken by workers from other worker shards */
+	zbx_uint64_t	finished_locks_num;		/* finished task list lock acquisitions */
+	zbx_uint64_t	finished_locks_contended_num;	/* finished task list lock acquisitions that had to */
+							/* wait                                             */
+	zbx_uint64_t	waits_num;			/* times workers went idle waiting for new tasks */
+}
+zbx_pp_queue_stats_t;
+
 int	zbx_diag_add_preproc_info(const struct zbx_json_parse *jp, struct zbx_json *json, char **error);
 void zbx_preproc_stats_ext_get(struct zbx_json *json, const void *arg);
 zbx_uint64_t	zbx_preprocessor_get_queue_size(void);
@@ -113,6 +128,8 @@ int	zbx_preprocessor_test(unsigned char value_type, const char *value, const zbx
 		unsigned char state, const zbx_vector_pp_step_ptr_t *steps, zbx_vector_pp_result_ptr_t *results,
 		zbx_pp_history_t *history, char **error);
 int	zbx_preprocessor_get_usage_stats(zbx_vector_dbl_t *usage, int *count, char **error);
+int	zbx_preprocessor_get_regexp_cache_stats(zbx_regexp_cache_stats_t *stats, char **error);
+int	zbx_preprocessor_get_queue_stats(zbx_pp_queue_stats_t *stats, char **error);
 
 ZBX_THREAD_ENTRY(zbx_pp_manager_thread, args);
 
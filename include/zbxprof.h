@@ -25,6 +25,7 @@ typedef int zbx_prof_scope_t;
 
 void	zbx_prof_enable(zbx_prof_scope_t scope);
 void	zbx_prof_disable(void);
+void	zbx_prof_dump(void);
 void	zbx_prof_start(const char *func_name, zbx_prof_scope_t scope);
 void	zbx_prof_end_wait(void);
 void	zbx_prof_end(void);
@@ -37,9 +37,11 @@ zbx_pb_state_info_t;
 #define ZBX_PB_MODE_DISK	0
 #define ZBX_PB_MODE_MEMORY	1
 #define ZBX_PB_MODE_HYBRID	2
+#define ZBX_PB_MODE_FILE	3
 
 int	zbx_pb_parse_mode(const char *str, int *mode);
-int	zbx_pb_create(int mode, zbx_uint64_t size, int age, int offline_buffer, char **error);
+int	zbx_pb_create(int mode, zbx_uint64_t size, int age, int offline_buffer, const char *file_dir,
+		char **error);
 void	zbx_pb_init(void);
 void	zbx_pb_destroy(void);
 
@@ -23,6 +23,9 @@
 #define SHMEM_MAX_BUCKET_SIZE		256 /* starting from this size all free chunks are put into the same bucket */
 #define ZBX_SHMEM_BUCKET_COUNT		((SHMEM_MAX_BUCKET_SIZE - ZBX_SHMEM_MIN_BUCKET_SIZE) / 8 + 1)
 
+#define ZBX_SHMEM_SLAB_MAX_OBJECT	512 /* larger objects are always allocated from the heap */
+#define ZBX_SHMEM_SLAB_CLASS_COUNT	((ZBX_SHMEM_SLAB_MAX_OBJECT - SHMEM_MIN_ALLOC) / 8 + 1)
+
 typedef struct
 {
 	void		*base;
@@ -42,9 +45,21 @@ typedef struct
 
 	const char	*mem_descr;
 	const char	*mem_param;
+
+	/* size classes of small object slabs, NULL if slab allocation is disabled */
+	void		*slabs;
 }
 zbx_shmem_info_t;
 
+typedef struct
+{
+	zbx_uint64_t	object_size;
+	unsigned int	slabs_num;
+	unsigned int	used_objects;
+	unsigned int	free_objects;
+}
+zbx_shmem_slab_stats_t;
+
 typedef struct
 {
 	zbx_uint64_t	free_size;
@@ -55,6 +70,18 @@ typedef struct
 	unsigned int	chunks_num[ZBX_SHMEM_BUCKET_COUNT];
 	unsigned int	free_chunks;
 	unsigned int	used_chunks;
+
+	/* slab statistics, valid only if slabs_enabled is set */
+	unsigned char		slabs_enabled;
+	unsigned int		slabs_num;
+	zbx_uint64_t		slab_size;
+	zbx_uint64_t		slab_free_size;
+	zbx_shmem_slab_stats_t	slab_classes[ZBX_SHMEM_SLAB_CLASS_COUNT];
+
+	/* percentage of free heap memory outside the largest free chunk */
+	double		heap_fragmentation;
+	/* percentage of slab memory in free objects */
+	double		slab_fragmentation;
 }
 zbx_shmem_stats_t;
 
@@ -63,6 +90,7 @@ int	zbx_shmem_create(zbx_shmem_info_t **info, zbx_uint64_t size, const char *des
 int	zbx_shmem_create_min(zbx_shmem_info_t **info, zbx_uint64_t size, const char *descr, const char *param,
 		int allow_oom, char **error);
 void	zbx_shmem_destroy(zbx_shmem_info_t *info);
+void	zbx_shmem_enable_slabs(zbx_shmem_info_t *info);
 
 #define	zbx_shmem_malloc(info, old, size) __zbx_shmem_malloc(__FILE__, __LINE__, info, old, size)
 #define	zbx_shmem_realloc(info, old, size) __zbx_shmem_realloc(__FILE__, __LINE__, info, old, size)
@@ -21,6 +21,7 @@ typedef struct
 {
 	const char	*config_snmptrap_file;
 	const char	*config_ha_node_name;
+	int		workers_num;
 }
 zbx_thread_snmptrapper_args;
 
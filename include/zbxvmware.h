@@ -585,6 +585,20 @@ struct zbx_vmware_job
 	zbx_vmware_service_t		*service;
 };
 
+/* performance counter collection statistics, accumulated since collector start */
+typedef struct
+{
+	/* number of performance data (QueryPerf) requests and received response bytes */
+	zbx_uint64_t	requests;
+	zbx_uint64_t	bytes;
+
+	/* time spent in performance data collection, waiting for responses and parsing them */
+	double		time_total;
+	double		time_transfer;
+	double		time_parse;
+}
+zbx_vmware_perf_stats_t;
+
 /* vmware collector data */
 typedef struct
 {
@@ -592,14 +606,16 @@ typedef struct
 	zbx_hashset_t			strpool;
 	zbx_uint64_t			strpool_sz;
 	zbx_binary_heap_t		jobs_queue;
+	zbx_vmware_perf_stats_t		perf_stats;
 }
 zbx_vmware_t;
 
 /* vmware collector statistics */
 typedef struct
 {
-	zbx_uint64_t	memory_used;
-	zbx_uint64_t	memory_total;
+	zbx_uint64_t		memory_used;
+	zbx_uint64_t		memory_total;
+	zbx_vmware_perf_stats_t	perf;
 }
 zbx_vmware_stats_t;
 
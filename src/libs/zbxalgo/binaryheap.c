@@ -25,9 +25,36 @@ static int	__binary_heap_bubble_down(zbx_binary_heap_t *heap, int index);
 #define	ARRAY_GROWTH_FACTOR	3/2
 
 #define	HAS_DIRECT_OPTION(heap)	(0 != (heap->options & ZBX_BINARY_HEAP_OPTION_DIRECT))
+#define	HAS_INDEX_OPTION(heap)	(0 != (heap->options & ZBX_BINARY_HEAP_OPTION_INDEX))
+
+#define	ELEM_INDEX(heap, data)	(*(int *)((char *)(data) + (heap)->index_offset))
 
 /* helper functions */
 
+static void	set_index(zbx_binary_heap_t *heap, int index)
+{
+	if (HAS_INDEX_OPTION(heap))
+		ELEM_INDEX(heap, heap->elems[index].data) = index;
+	else if (HAS_DIRECT_OPTION(heap))
+		zbx_hashmap_set(heap->key_index, heap->elems[index].key, index);
+}
+
+static int	get_index(const zbx_binary_heap_t *heap, const zbx_binary_heap_elem_t *elem)
+{
+	if (HAS_INDEX_OPTION(heap))
+	{
+		int	index = ELEM_INDEX(heap, elem->data);
+
+		/* the stored index is not reset when element leaves the heap, so it must be validated */
+		if (0 <= index && index < heap->elems_num && heap->elems[index].data == elem->data)
+			return index;
+
+		return FAIL;
+	}
+
+	return zbx_hashmap_get(heap->key_index, elem->key);
+}
+
 static void	swap(zbx_binary_heap_t *heap, int index_1, int index_2)
 {
 	zbx_binary_heap_elem_t	tmp;
@@ -36,11 +63,8 @@ static void	swap(zbx_binary_heap_t *heap, int index_1, int index_2)
 	heap->elems[index_1] = heap->elems[index_2];
 	heap->elems[index_2] = tmp;
 
-	if (HAS_DIRECT_OPTION(heap))
-	{
-		zbx_hashmap_set(heap->key_index, heap->elems[index_1].key, index_1);
-		zbx_hashmap_set(heap->key_index, heap->elems[index_2].key, index_2);
-	}
+	set_index(heap, index_1);
+	set_index(heap, index_2);
 }
 
 /* private binary heap functions */
@@ -156,6 +180,7 @@ void	zbx_binary_heap_create_ext(zbx_binary_heap_t *heap, zbx_compare_func_t comp
 	heap->elems_alloc = 0;
 	heap->compare_func = compare_func;
 	heap->options = options;
+	heap->index_offset = 0;
 
 	if (HAS_DIRECT_OPTION(heap))
 	{
@@ -175,6 +200,36 @@ void	zbx_binary_heap_create_ext(zbx_binary_heap_t *heap, zbx_compare_func_t comp
 	heap->mem_free_func = mem_free_func;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates heap supporting direct update and remove operations       *
+ *          without key index                                                 *
+ *                                                                            *
+ * Parameters: heap             - [OUT]                                       *
+ *             compare_func     - [IN]                                        *
+ *             index_offset     - [IN] offset of int field in element data    *
+ *                                     used to store element position         *
+ *             mem_malloc_func  - [IN]                                        *
+ *             mem_realloc_func - [IN]                                        *
+ *             mem_free_func    - [IN]                                        *
+ *                                                                            *
+ * Comments: Element position is kept in the element data itself instead of  *
+ *           key index hashmap, which saves a hashmap lookup and update for   *
+ *           every element move. Each element data can be stored in only one *
+ *           such heap at a time.                                             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_binary_heap_create_index_ext(zbx_binary_heap_t *heap, zbx_compare_func_t compare_func,
+					size_t index_offset, zbx_mem_malloc_func_t mem_malloc_func,
+					zbx_mem_realloc_func_t mem_realloc_func,
+					zbx_mem_free_func_t mem_free_func)
+{
+	zbx_binary_heap_create_ext(heap, compare_func, ZBX_BINARY_HEAP_OPTION_INDEX, mem_malloc_func,
+			mem_realloc_func, mem_free_func);
+
+	heap->index_offset = index_offset;
+}
+
 void	zbx_binary_heap_destroy(zbx_binary_heap_t *heap)
 {
 	if (NULL != heap->elems)
@@ -192,9 +247,10 @@ void	zbx_binary_heap_destroy(zbx_binary_heap_t *heap)
 		zbx_hashmap_destroy(heap->key_index);
 		heap->mem_free_func(heap->key_index);
 		heap->key_index = NULL;
-		heap->options = 0;
 	}
 
+	heap->options = 0;
+
 	heap->mem_malloc_func = NULL;
 	heap->mem_realloc_func = NULL;
 	heap->mem_free_func = NULL;
@@ -220,7 +276,7 @@ void	zbx_binary_heap_insert(zbx_binary_heap_t *heap, zbx_binary_heap_elem_t *ele
 {
 	int	index;
 
-	if (HAS_DIRECT_OPTION(heap) && FAIL != zbx_hashmap_get(heap->key_index, elem->key))
+	if ((HAS_DIRECT_OPTION(heap) || HAS_INDEX_OPTION(heap)) && FAIL != get_index(heap, elem))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "inserting a duplicate key into a heap with direct option");
 		exit(EXIT_FAILURE);
@@ -233,21 +289,21 @@ void	zbx_binary_heap_insert(zbx_binary_heap_t *heap, zbx_binary_heap_elem_t *ele
 
 	index = __binary_heap_bubble_up(heap, index);
 
-	if (HAS_DIRECT_OPTION(heap) && index == heap->elems_num - 1)
-		zbx_hashmap_set(heap->key_index, elem->key, index);
+	if (index == heap->elems_num - 1)
+		set_index(heap, index);
 }
 
 void	zbx_binary_heap_update_direct(zbx_binary_heap_t *heap, zbx_binary_heap_elem_t *elem)
 {
 	int	index;
 
-	if (!HAS_DIRECT_OPTION(heap))
+	if (!HAS_DIRECT_OPTION(heap) && !HAS_INDEX_OPTION(heap))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "direct update operation is not supported for this heap");
 		exit(EXIT_FAILURE);
 	}
 
-	if (FAIL != (index = zbx_hashmap_get(heap->key_index, elem->key)))
+	if (FAIL != (index = get_index(heap, elem)))
 	{
 		heap->elems[index] = *elem;
 
@@ -279,8 +335,8 @@ void	zbx_binary_heap_remove_min(zbx_binary_heap_t *heap)
 		heap->elems[0] = heap->elems[heap->elems_num];
 		index = __binary_heap_bubble_down(heap, 0);
 
-		if (HAS_DIRECT_OPTION(heap) && index == 0)
-			zbx_hashmap_set(heap->key_index, heap->elems[index].key, index);
+		if (index == 0)
+			set_index(heap, index);
 	}
 }
 
@@ -314,6 +370,40 @@ void	zbx_binary_heap_remove_direct(zbx_binary_heap_t *heap, zbx_uint64_t key)
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes element from heap created with index option               *
+ *                                                                            *
+ * Parameters: heap - [IN/OUT]                                                *
+ *             elem - [IN] element to remove, only data is used               *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_binary_heap_remove_index(zbx_binary_heap_t *heap, const zbx_binary_heap_elem_t *elem)
+{
+	int	index;
+
+	if (!HAS_INDEX_OPTION(heap))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "index remove operation is not supported for this heap");
+		exit(EXIT_FAILURE);
+	}
+
+	if (FAIL == (index = get_index(heap, elem)))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "element with key " ZBX_FS_UI64 " not found in heap for remove", elem->key);
+		exit(EXIT_FAILURE);
+	}
+
+	if (index != (--heap->elems_num))
+	{
+		heap->elems[index] = heap->elems[heap->elems_num];
+
+		if (index == __binary_heap_bubble_up(heap, index))
+			if (index == __binary_heap_bubble_down(heap, index))
+				set_index(heap, index);
+	}
+}
+
 void	zbx_binary_heap_clear(zbx_binary_heap_t *heap)
 {
 	heap->elems_num = 0;
@@ -116,6 +116,9 @@ int	zbx_trigger_dep_compare_func(const void *d1, const void *d2)
 
 int	sync_in_progress = 0;
 
+/* Configuration sync compares database rows without locking and takes the write lock only to apply  */
+/* a group of related changes. The lock is released only between groups, because readers must not    */
+/* see partially applied groups (for example triggers without their relinked functions).             */
 #define START_SYNC	do { WRLOCK_CACHE_CONFIG_HISTORY; WRLOCK_CACHE; sync_in_progress = 1; } while(0)
 #define FINISH_SYNC	do { sync_in_progress = 0; UNLOCK_CACHE; UNLOCK_CACHE_CONFIG_HISTORY; } while(0)
 
@@ -945,10 +948,13 @@ static void	DCupdate_item_queue(ZBX_DC_ITEM *item, unsigned char old_poller_type
 	if (ZBX_LOC_POLLER == item->location)
 		return;
 
+	elem.key = item->itemid;
+	elem.data = (void *)item;
+
 	if (ZBX_LOC_QUEUE == item->location && old_poller_type != item->poller_type)
 	{
 		item->location = ZBX_LOC_NOWHERE;
-		zbx_binary_heap_remove_direct(&config->queues[old_poller_type], item->itemid);
+		zbx_binary_heap_remove_index(&config->queues[old_poller_type], &elem);
 	}
 
 	if (item->poller_type == ZBX_NO_POLLER)
@@ -957,9 +963,6 @@ static void	DCupdate_item_queue(ZBX_DC_ITEM *item, unsigned char old_poller_type
 	if (ZBX_LOC_QUEUE == item->location && old_nextcheck == item->nextcheck)
 		return;
 
-	elem.key = item->itemid;
-	elem.data = (void *)item;
-
 	if (ZBX_LOC_QUEUE != item->location)
 	{
 		item->location = ZBX_LOC_QUEUE;
@@ -3728,6 +3731,7 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 		ZBX_DBROW2UINT64(interfaceid, row[19]);
 
 		dc_strpool_replace(found, &item->history_period, row[22]);
+		dc_strpool_replace(found, &item->name, row[50]);
 
 		ZBX_STR2UCHAR(item->inventory_link, row[24]);
 		ZBX_DBROW2UINT64(item->valuemapid, row[25]);
@@ -3748,6 +3752,7 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 			dc_strpool_replace(found, &item->error, row[27]);
 			item->data_expected_from = now;
 			item->location = ZBX_LOC_NOWHERE;
+			item->queue_index = -1;
 			item->poller_type = ZBX_NO_POLLER;
 			item->queue_priority = ZBX_QUEUE_PRIORITY_NORMAL;
 			item->delay_ex = NULL;
@@ -4006,12 +4011,17 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 		}
 
 		if (ZBX_LOC_QUEUE == item->location)
-			zbx_binary_heap_remove_direct(&config->queues[item->poller_type], item->itemid);
+		{
+			zbx_binary_heap_elem_t	elem = {item->itemid, (void *)item};
+
+			zbx_binary_heap_remove_index(&config->queues[item->poller_type], &elem);
+		}
 
 		dc_strpool_release(item->key);
 		dc_strpool_release(item->error);
 		dc_strpool_release(item->delay);
 		dc_strpool_release(item->history_period);
+		dc_strpool_release(item->name);
 
 		if (NULL != item->delay_ex)
 			dc_strpool_release(item->delay_ex);
@@ -4037,7 +4047,7 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 static void	DCsync_item_discovery(zbx_dbsync_t *sync)
 {
 	char			**row;
-	zbx_uint64_t		rowid, itemid;
+	zbx_uint64_t		rowid, itemid, parent_itemid;
 	unsigned char		tag;
 	zbx_hashset_uniq_t	uniq = ZBX_HASHSET_UNIQ_FALSE;
 	int			ret, found;
@@ -4069,12 +4079,19 @@ static void	DCsync_item_discovery(zbx_dbsync_t *sync)
 
 	for (; SUCCEED == ret; ret = zbx_dbsync_next(sync, &rowid, &row, &tag))
 	{
+		ZBX_STR2UINT64(itemid, row[0]);
+
 		if (NULL == (item_discovery = (ZBX_DC_ITEM_DISCOVERY *)zbx_hashset_search(&config->item_discovery,
-				&rowid)))
+				&itemid)))
 		{
 			continue;
 		}
 
+		/* the item might have been linked to another prototype in the same changeset */
+		ZBX_STR2UINT64(parent_itemid, row[1]);
+		if (item_discovery->parent_itemid != parent_itemid)
+			continue;
+
 		zbx_hashset_remove_direct(&config->item_discovery, item_discovery);
 	}
 
@@ -4291,6 +4308,13 @@ static void	DCsync_trigdeps(zbx_dbsync_t *sync)
 		trigdep_down = (ZBX_DC_TRIGGER_DEPLIST *)DCfind_id(&config->trigdeps, triggerid_down,
 				sizeof(ZBX_DC_TRIGGER_DEPLIST), &found);
 
+		/* skip already synced dependencies */
+		if (0 != found && FAIL != zbx_vector_ptr_search(&trigdep_down->dependencies, &triggerid_up,
+				ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC))
+		{
+			continue;
+		}
+
 		if (0 == found)
 			dc_trigger_deplist_init(trigdep_down, trigger_down);
 		else
@@ -4318,6 +4342,14 @@ static void	DCsync_trigdeps(zbx_dbsync_t *sync)
 		}
 
 		ZBX_STR2UINT64(triggerid_up, row[1]);
+
+		/* the dependency might not have been synced if any of the triggers was missing */
+		if (FAIL == (index = zbx_vector_ptr_search(&trigdep_down->dependencies, &triggerid_up,
+				ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC)))
+		{
+			continue;
+		}
+
 		if (NULL != (trigdep_up = (ZBX_DC_TRIGGER_DEPLIST *)zbx_hashset_search(&config->trigdeps,
 				&triggerid_up)))
 		{
@@ -4326,12 +4358,6 @@ static void	DCsync_trigdeps(zbx_dbsync_t *sync)
 
 		if (SUCCEED != dc_trigger_deplist_release(trigdep_down))
 		{
-			if (FAIL == (index = zbx_vector_ptr_search(&trigdep_down->dependencies, &triggerid_up,
-					ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC)))
-			{
-				continue;
-			}
-
 			if (1 == trigdep_down->dependencies.values_num)
 				dc_trigger_deplist_reset(trigdep_down);
 			else
@@ -7616,6 +7642,57 @@ void	zbx_dc_config_get_hostids_by_revision(zbx_uint64_t new_revision, zbx_vector
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets host configuration revision, including revisions of global,  *
+ *          host and linked template user macros                              *
+ *                                                                            *
+ * Parameters: hostid   - [IN]                                                *
+ *             revision - [OUT]                                               *
+ *                                                                            *
+ * Return value: SUCCEED - the host revision was returned                     *
+ *               FAIL    - the host was not found                             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dc_get_host_revision(zbx_uint64_t hostid, zbx_uint64_t *revision)
+{
+	const ZBX_DC_HOST	*dc_host;
+	int			ret = FAIL;
+
+	RDLOCK_CACHE;
+
+	if (NULL != (dc_host = (const ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &hostid)))
+	{
+		*revision = MAX(dc_host->revision, config->revision.expression);
+
+		um_cache_get_host_revision(config->um_cache, ZBX_UM_CACHE_GLOBAL_MACRO_HOSTID, revision);
+		um_cache_get_host_revision(config->um_cache, hostid, revision);
+
+		ret = SUCCEED;
+	}
+
+	UNLOCK_CACHE;
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets revision of changelog tracked objects LLD prototypes consist *
+ *          of (items, triggers, host prototypes and their child objects)     *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint64_t	zbx_dc_get_lld_prototypes_revision(void)
+{
+	zbx_uint64_t	revision;
+
+	RDLOCK_CACHE;
+	revision = config->revision.lld_prototypes;
+	UNLOCK_CACHE;
+
+	return revision;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: add new items with triggers to value cache                        *
@@ -7758,6 +7835,10 @@ zbx_uint64_t	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config
 	{
 		zbx_hashset_create(&trend_queue, 1000, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 		dc_load_trigger_queue(&trend_queue);
+
+		/* objects using changelog are synced from configuration snapshot and changes since it was written */
+		if (SUCCEED == zbx_dbsync_env_load_snapshot())
+			changelog_sync_mode = ZBX_DBSYNC_UPDATE;
 	}
 	else if (ZBX_DBSYNC_STATUS_INITIALIZED != sync_status)
 	{
@@ -7769,7 +7850,8 @@ zbx_uint64_t	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config
 		pnew_items = &new_items;
 	}
 
-	if (ZBX_DBSYNC_INIT != changelog_sync_mode && 0 != (get_program_type_cb() & ZBX_PROGRAM_TYPE_SERVER))
+	if (ZBX_DBSYNC_INIT != mode && ZBX_DBSYNC_INIT != changelog_sync_mode &&
+			0 != (get_program_type_cb() & ZBX_PROGRAM_TYPE_SERVER))
 	{
 		/* track host - proxy group relocations only during incremental sync */
 		zbx_vector_objmove_create(&pg_host_reloc);
@@ -7791,15 +7873,15 @@ zbx_uint64_t	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config
 	zbx_dbsync_init_changelog(&proxy_group_sync, changelog_sync_mode);
 	zbx_dbsync_init_changelog(&hosts_sync, changelog_sync_mode);
 	zbx_dbsync_init_changelog(&hp_sync, changelog_sync_mode);
-	zbx_dbsync_init(&hi_sync, mode);
-	zbx_dbsync_init(&htmpl_sync, mode);
-	zbx_dbsync_init(&gmacro_sync, mode);
-	zbx_dbsync_init(&hmacro_sync, mode);
-	zbx_dbsync_init(&if_sync, mode);
+	zbx_dbsync_init_changelog(&hi_sync, changelog_sync_mode);
+	zbx_dbsync_init_changelog(&htmpl_sync, changelog_sync_mode);
+	zbx_dbsync_init_changelog(&gmacro_sync, changelog_sync_mode);
+	zbx_dbsync_init_changelog(&hmacro_sync, changelog_sync_mode);
+	zbx_dbsync_init_changelog(&if_sync, changelog_sync_mode);
 	zbx_dbsync_init_changelog(&items_sync, changelog_sync_mode);
-	zbx_dbsync_init(&item_discovery_sync, mode);
+	zbx_dbsync_init_changelog(&item_discovery_sync, changelog_sync_mode);
 	zbx_dbsync_init_changelog(&triggers_sync, changelog_sync_mode);
-	zbx_dbsync_init(&tdep_sync, mode);
+	zbx_dbsync_init_changelog(&tdep_sync, changelog_sync_mode);
 	zbx_dbsync_init_changelog(&func_sync, changelog_sync_mode);
 	zbx_dbsync_init(&expr_sync, mode);
 	zbx_dbsync_init(&action_sync, mode);
@@ -8289,6 +8371,9 @@ zbx_uint64_t	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config
 
 	config->revision.config = new_revision;
 
+	if (ZBX_DBSYNC_INIT == changelog_sync_mode || SUCCEED == zbx_dbsync_env_lld_prototypes_changed())
+		config->revision.lld_prototypes = new_revision;
+
 	if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_DEBUG))
 	{
 		total = csec + hsec + hisec + htsec + gmsec + hmsec + ifsec + idsec + isec  + tsec +
@@ -8612,6 +8697,10 @@ out:
 			if (ZBX_DBSYNC_INIT != changelog_sync_mode)
 			{
 				zbx_dbsync_env_flush_changelog();
+
+				/* changelog objects were loaded from configuration snapshot */
+				if (ZBX_DBSYNC_INIT == mode)
+					sync_status = ZBX_DBSYNC_STATUS_INITIALIZED;
 			}
 			else
 			{
@@ -8620,6 +8709,7 @@ out:
 				if (SUCCEED == zbx_dbsync_env_changelog_dbsyncs_new_records())
 				{
 					sync_status = ZBX_DBSYNC_STATUS_INITIALIZED;
+					zbx_dbsync_env_flush_snapshot();
 					zabbix_log(LOG_LEVEL_DEBUG, "initialized changelog support");
 				}
 				else
@@ -9079,7 +9169,8 @@ size_t	zbx_maintenance_update_flags_num(void)
  *                                                                            *
  ******************************************************************************/
 int	zbx_init_configuration_cache(zbx_get_program_type_f get_program_type, zbx_get_config_forks_f get_config_forks,
-		zbx_uint64_t conf_cache_size, const char *hostname, char **error)
+		zbx_uint64_t conf_cache_size, const char *hostname, const char *snapshot_file, int cache_slabs,
+		char **error)
 {
 	int	i, ret;
 
@@ -9100,6 +9191,9 @@ int	zbx_init_configuration_cache(zbx_get_program_type_f get_program_type, zbx_ge
 		goto out;
 	}
 
+	if (0 != cache_slabs)
+		zbx_shmem_enable_slabs(config_mem);
+
 	config = (zbx_dc_config_t *)__config_shmem_malloc_func(NULL, sizeof(zbx_dc_config_t) +
 			(size_t)get_config_forks_cb(ZBX_PROCESS_TYPE_TIMER) * sizeof(zbx_vector_ptr_t));
 
@@ -9186,25 +9280,25 @@ int	zbx_init_configuration_cache(zbx_get_program_type_f get_program_type, zbx_ge
 		switch (i)
 		{
 			case ZBX_POLLER_TYPE_JAVA:
-				zbx_binary_heap_create_ext(&config->queues[i],
+				zbx_binary_heap_create_index_ext(&config->queues[i],
 						__config_java_elem_compare,
-						ZBX_BINARY_HEAP_OPTION_DIRECT,
+						offsetof(ZBX_DC_ITEM, queue_index),
 						__config_shmem_malloc_func,
 						__config_shmem_realloc_func,
 						__config_shmem_free_func);
 				break;
 			case ZBX_POLLER_TYPE_PINGER:
-				zbx_binary_heap_create_ext(&config->queues[i],
+				zbx_binary_heap_create_index_ext(&config->queues[i],
 						__config_pinger_elem_compare,
-						ZBX_BINARY_HEAP_OPTION_DIRECT,
+						offsetof(ZBX_DC_ITEM, queue_index),
 						__config_shmem_malloc_func,
 						__config_shmem_realloc_func,
 						__config_shmem_free_func);
 				break;
 			default:
-				zbx_binary_heap_create_ext(&config->queues[i],
+				zbx_binary_heap_create_index_ext(&config->queues[i],
 						__config_heap_elem_compare,
-						ZBX_BINARY_HEAP_OPTION_DIRECT,
+						offsetof(ZBX_DC_ITEM, queue_index),
 						__config_shmem_malloc_func,
 						__config_shmem_realloc_func,
 						__config_shmem_free_func);
@@ -9294,7 +9388,7 @@ int	zbx_init_configuration_cache(zbx_get_program_type_f get_program_type, zbx_ge
 	config->proxy_failover_delay = ZBX_PG_DEFAULT_FAILOVER_DELAY;
 	config->proxy_lastonline = 0;
 
-	zbx_dbsync_env_init(config);
+	zbx_dbsync_env_init(config, snapshot_file, get_program_type_cb());
 
 #undef CREATE_HASHSET
 #undef CREATE_HASHSET_EXT
@@ -11849,10 +11943,17 @@ unlock:
  *                                                                            *
  * Purpose: get array of snmp trap items for the specified interfaceid        *
  *                                                                            *
+ * Parameters: interfaceid - [IN]                                             *
+ *             items       - [OUT] the snmp trap items                        *
+ *             revision    - [OUT] revision of the interface host items,      *
+ *                                 global regular expressions and global,     *
+ *                                 host and linked template user macros       *
+ *                                                                            *
  * Return value: number of items returned                                     *
  *                                                                            *
  ******************************************************************************/
-size_t	zbx_dc_config_get_snmp_items_by_interfaceid(zbx_uint64_t interfaceid, zbx_dc_item_t **items)
+size_t	zbx_dc_config_get_snmp_items_by_interfaceid(zbx_uint64_t interfaceid, zbx_dc_item_t **items,
+		zbx_uint64_t *revision)
 {
 	size_t				items_num = 0, items_alloc = 8;
 	int				i;
@@ -11863,6 +11964,8 @@ size_t	zbx_dc_config_get_snmp_items_by_interfaceid(zbx_uint64_t interfaceid, zbx
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() interfaceid:" ZBX_FS_UI64, __func__, interfaceid);
 
+	*revision = 0;
+
 	RDLOCK_CACHE;
 
 	if (NULL == (dc_interface = (const ZBX_DC_INTERFACE *)zbx_hashset_search(&config->interfaces, &interfaceid)))
@@ -11871,6 +11974,12 @@ size_t	zbx_dc_config_get_snmp_items_by_interfaceid(zbx_uint64_t interfaceid, zbx
 	if (NULL == (dc_host = (const ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &dc_interface->hostid)))
 		goto unlock;
 
+	/* host revision is updated with revisions of its items */
+	*revision = MAX(dc_host->revision, config->revision.expression);
+
+	um_cache_get_host_revision(config->um_cache, ZBX_UM_CACHE_GLOBAL_MACRO_HOSTID, revision);
+	um_cache_get_host_revision(config->um_cache, dc_host->hostid, revision);
+
 	if (HOST_STATUS_MONITORED != dc_host->status)
 		goto unlock;
 
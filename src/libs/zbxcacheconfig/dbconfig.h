@@ -272,6 +272,7 @@ typedef struct
 	zbx_uint64_t		lastlogsize;
 	zbx_uint64_t		valuemapid;
 	const char		*key;
+	const char		*name;
 	const char		*port;
 	const char		*error;
 	const char		*delay;
@@ -289,6 +290,7 @@ typedef struct
 	int			nextcheck;
 	int			mtime;
 	int			data_expected_from;
+	int			queue_index;	/* position in poller queue, valid only when queued */
 	unsigned char		type;
 	unsigned char		value_type;
 	unsigned char		poller_type;
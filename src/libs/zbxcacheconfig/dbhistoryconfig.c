@@ -30,6 +30,8 @@
 ZBX_PTR_VECTOR_IMPL(connector_filter, zbx_connector_filter_t)
 ZBX_PTR_VECTOR_IMPL(action_eval_ptr, zbx_action_eval_t *)
 ZBX_PTR_VECTOR_IMPL(queue_item_ptr, zbx_queue_item_t *)
+ZBX_PTR_VECTOR_IMPL(history_export_item_ptr, zbx_history_export_item_t *)
+ZBX_PTR_VECTOR_IMPL(history_export_host_ptr, zbx_history_export_host_t *)
 
 static void	dc_get_history_sync_host(zbx_history_sync_host_t *dst_host, const ZBX_DC_HOST *src_host,
 		unsigned int mode)
@@ -261,6 +263,97 @@ void	zbx_dc_config_history_sync_unset_existing_itemids(zbx_vector_uint64_t *item
 	UNLOCK_CACHE_CONFIG_HISTORY;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get configuration cache revision                                  *
+ *                                                                            *
+ * Comments: The revision is changed by every configuration cache sync and    *
+ *           can be used to invalidate data cached from configuration cache.  *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint64_t	zbx_dc_config_history_sync_get_revision(void)
+{
+	zbx_uint64_t	revision;
+
+	RDLOCK_CACHE_CONFIG_HISTORY;
+	revision = get_dc_config()->revision.config;
+	UNLOCK_CACHE_CONFIG_HISTORY;
+
+	return revision;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get item names, item tags and host group names used to enrich     *
+ *          exported history and trends                                       *
+ *                                                                            *
+ * Parameters: items - [IN/OUT] the items with itemid set, names and tags are *
+ *                              added to items found in configuration cache   *
+ *             hosts - [IN/OUT] the hosts with hostid set, host group names   *
+ *                              are added                                     *
+ *                                                                            *
+ * Comments: Data is retrieved using history read lock that must be write     *
+ *           locked only when configuration sync occurs to avoid processes    *
+ *           blocking each other.                                             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_config_history_sync_get_export_data(zbx_vector_history_export_item_ptr_t *items,
+		zbx_vector_history_export_host_ptr_t *hosts)
+{
+	const ZBX_DC_ITEM		*dc_item;
+	zbx_dc_hostgroup_t		*group;
+	zbx_hashset_iter_t		iter;
+	zbx_dc_config_t			*dc_config = get_dc_config();
+	int				i, j;
+
+	RDLOCK_CACHE_CONFIG_HISTORY;
+
+	for (i = 0; i < items->values_num; i++)
+	{
+		zbx_history_export_item_t	*item = items->values[i];
+
+		if (NULL == (dc_item = (const ZBX_DC_ITEM *)zbx_hashset_search(&dc_config->items, &item->itemid)))
+			continue;
+
+		item->name = zbx_strdup(item->name, dc_item->name);
+
+		for (j = 0; j < dc_item->tags.values_num; j++)
+		{
+			const zbx_dc_item_tag_t	*dc_tag = (const zbx_dc_item_tag_t *)dc_item->tags.values[j];
+			zbx_tag_t		*tag;
+
+			tag = (zbx_tag_t *)zbx_malloc(NULL, sizeof(zbx_tag_t));
+			tag->tag = zbx_strdup(NULL, dc_tag->tag);
+			tag->value = zbx_strdup(NULL, dc_tag->value);
+			zbx_vector_tags_ptr_append(&item->item_tags, tag);
+		}
+	}
+
+	if (0 != hosts->values_num)
+	{
+		zbx_hashset_iter_reset(&dc_config->hostgroups, &iter);
+
+		while (NULL != (group = (zbx_dc_hostgroup_t *)zbx_hashset_iter_next(&iter)))
+		{
+			for (i = 0; i < hosts->values_num; i++)
+			{
+				zbx_history_export_host_t	*host = hosts->values[i];
+
+				if (NULL != zbx_hashset_search(&group->hostids, &host->hostid))
+					zbx_vector_str_append(&host->groups, zbx_strdup(NULL, group->name));
+			}
+		}
+	}
+
+	UNLOCK_CACHE_CONFIG_HISTORY;
+
+	for (i = 0; i < items->values_num; i++)
+		zbx_vector_tags_ptr_sort(&items->values[i]->item_tags, zbx_compare_tags);
+
+	for (i = 0; i < hosts->values_num; i++)
+		zbx_vector_str_sort(&hosts->values[i]->groups, ZBX_DEFAULT_STR_COMPARE_FUNC);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: Get functions by IDs                                              *
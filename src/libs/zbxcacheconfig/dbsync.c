@@ -14,6 +14,7 @@
 
 #include "zbxcacheconfig.h"
 #include "dbsync.h"
+#include "dbsync_snapshot.h"
 #include "user_macro.h"
 
 #include "zbx_host_constants.h"
@@ -53,14 +54,25 @@
 #define ZBX_DBSYNC_OBJ_PROXY		19
 #define ZBX_DBSYNC_OBJ_PROXY_GROUP	20
 #define ZBX_DBSYNC_OBJ_HOST_PROXY	21
+#define ZBX_DBSYNC_OBJ_GLOBAL_MACRO	22
+#define ZBX_DBSYNC_OBJ_HOST_MACRO	23
+#define ZBX_DBSYNC_OBJ_HOST_TEMPLATE	24
+#define ZBX_DBSYNC_OBJ_HOST_INVENTORY	25
+#define ZBX_DBSYNC_OBJ_INTERFACE	26
+#define ZBX_DBSYNC_OBJ_INTERFACE_SNMP	27
+#define ZBX_DBSYNC_OBJ_ITEM_DISCOVERY	28
+#define ZBX_DBSYNC_OBJ_TRIGGER_DEPENDENCY	29
 /* number of dbsync objects - keep in sync with above defines */
-#define ZBX_DBSYNC_OBJ_COUNT		21
+#define ZBX_DBSYNC_OBJ_COUNT		29
 
 #define ZBX_DBSYNC_JOURNAL(X)		(X - 1)
 
 #define ZBX_DBSYNC_CHANGELOG_PRUNE_INTERVAL	SEC_PER_MIN * 10
 #define ZBX_DBSYNC_CHANGELOG_MAX_AGE		SEC_PER_HOUR
 
+/* the snapshot changelog state must not be older than the retained changelog records */
+#define ZBX_DBSYNC_SNAPSHOT_MAX_AGE		(ZBX_DBSYNC_CHANGELOG_MAX_AGE - ZBX_DBSYNC_CHANGELOG_PRUNE_INTERVAL)
+
 #define ZBX_DBSYNC_BATCH_SIZE			1000
 
 typedef struct
@@ -97,6 +109,31 @@ typedef struct
 }
 zbx_dbsync_journal_t;
 
+/* link table row, mapping the row identifier to the linked object identifiers */
+typedef struct
+{
+	zbx_uint64_t	linkid;
+	zbx_uint64_t	first;
+	zbx_uint64_t	second;
+}
+zbx_dbsync_link_t;
+
+ZBX_VECTOR_DECL(dbsync_link, zbx_dbsync_link_t)
+ZBX_VECTOR_IMPL(dbsync_link, zbx_dbsync_link_t)
+
+/* Link tables (hosts_templates, item_discovery, trigger_depends) are cached as object */
+/* pairs without the row identifiers, so the row identifiers of the synced links are   */
+/* indexed locally to resolve changelog delete records into the removed pairs.         */
+typedef struct
+{
+	zbx_hashset_t			links;
+
+	/* index changes, applied after the changelog has been successfully flushed */
+	zbx_vector_dbsync_link_t	updates;
+	zbx_vector_uint64_t		deletes;
+}
+zbx_dbsync_links_t;
+
 typedef struct
 {
 	zbx_hashset_t			strpool;
@@ -107,6 +144,20 @@ typedef struct
 	zbx_dbsync_journal_t		journals[ZBX_DBSYNC_OBJ_COUNT];
 
 	zbx_vector_dbsync_t		changelog_dbsyncs;
+
+	zbx_dbsync_links_t		host_templates;
+	zbx_dbsync_links_t		item_discovery;
+	zbx_dbsync_links_t		trigger_deps;
+
+	/* user macro cache revision used to resolve interface addresses */
+	zbx_uint64_t			interface_um_revision;
+	zbx_uint64_t			interface_um_revision_new;
+
+	/* the configuration snapshot loaded at startup, used by the first sync */
+	zbx_dbsync_snapshot_t		*snapshot;
+
+	/* the database time when changelog was read, used as snapshot commit time */
+	int				snapshot_clock;
 }
 zbx_dbsync_env_t;
 
@@ -269,6 +320,58 @@ static void	dbsync_prepare(zbx_dbsync_t *sync, int columns_num, zbx_dbsync_prepr
 	memset(sync->row, 0, sizeof(char *) * (size_t)columns_num);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepares changeset of object synced with changelog                *
+ *                                                                            *
+ * Parameter: sync             - [IN] the changeset                           *
+ *            object           - [IN] the changelog object (see               *
+ *                                    ZBX_DBSYNC_OBJ_* defines)               *
+ *            columns_num      - [IN] the number of columns in the changeset  *
+ *            preproc_row_func - [IN] the row preprocessing callback          *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_prepare_changelog(zbx_dbsync_t *sync, unsigned char object, int columns_num,
+		zbx_dbsync_preproc_row_func_t preproc_row_func)
+{
+	dbsync_prepare(sync, columns_num, preproc_row_func);
+	sync->object = object;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets index of the row identifier column of changelog object       *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_rowid_column(unsigned char object)
+{
+	switch (object)
+	{
+		case ZBX_DBSYNC_OBJ_HOST_TEMPLATE:
+		case ZBX_DBSYNC_OBJ_ITEM_DISCOVERY:
+		case ZBX_DBSYNC_OBJ_TRIGGER_DEPENDENCY:
+			/* link tables are selected as first, second and link identifiers */
+			return 2;
+		default:
+			return 0;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes database row into configuration snapshot                   *
+ *                                                                            *
+ * Parameter: sync  - [IN] the changeset                                      *
+ *            rowid - [IN] the row identifier                                 *
+ *            dbrow - [IN] the row contents before preprocessing              *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_write_snapshot_row(const zbx_dbsync_t *sync, zbx_uint64_t rowid, char **dbrow)
+{
+	if (0 != sync->object)
+		dbsync_snapshot_write_row(sync->object, rowid, dbrow, sync->columns_num);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: applies necessary pre-processing before row is compared/used      *
@@ -324,10 +427,71 @@ static void	dbsync_journal_destroy(zbx_dbsync_journal_t *journal)
 	zbx_vector_dbsync_obj_changelog_destroy(&journal->changelog);
 }
 
-void	zbx_dbsync_env_init(zbx_dc_config_t *cache)
+void	zbx_dbsync_env_init(zbx_dc_config_t *cache, const char *snapshot_file, unsigned char program_type)
 {
 	dbsync_env.cache = cache;
+	dbsync_snapshot_init(snapshot_file, program_type, ZBX_DBSYNC_OBJ_COUNT, ZBX_DBSYNC_CHANGELOG_MAX_AGE);
+
 	zbx_hashset_create(&dbsync_env.changelog, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	zbx_hashset_create(&dbsync_env.host_templates.links, 100, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_hashset_create(&dbsync_env.item_discovery.links, 100, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_hashset_create(&dbsync_env.trigger_deps.links, 100, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+}
+
+static void	dbsync_links_prepare(zbx_dbsync_links_t *links, unsigned char mode)
+{
+	if (ZBX_DBSYNC_INIT == mode)
+		zbx_hashset_clear(&links->links);
+
+	zbx_vector_dbsync_link_create(&links->updates);
+	zbx_vector_uint64_create(&links->deletes);
+}
+
+static void	dbsync_links_flush(zbx_dbsync_links_t *links)
+{
+	int	i;
+
+	for (i = 0; i < links->updates.values_num; i++)
+	{
+		zbx_dbsync_link_t	*link = &links->updates.values[i], *plink;
+
+		if (NULL != (plink = (zbx_dbsync_link_t *)zbx_hashset_search(&links->links, &link->linkid)))
+			*plink = *link;
+		else
+			zbx_hashset_insert(&links->links, link, sizeof(zbx_dbsync_link_t));
+	}
+
+	for (i = 0; i < links->deletes.values_num; i++)
+		zbx_hashset_remove(&links->links, &links->deletes.values[i]);
+}
+
+static void	dbsync_links_clear(zbx_dbsync_links_t *links)
+{
+	zbx_vector_dbsync_link_destroy(&links->updates);
+	zbx_vector_uint64_destroy(&links->deletes);
+}
+
+static int	dbsync_get_db_time(int *now)
+{
+	zbx_db_row_t	row;
+	zbx_db_result_t	result;
+	int		ret = FAIL;
+
+	result = zbx_db_select("select %s", ZBX_DB_TIMESTAMP());
+
+	if (NULL != (row = zbx_db_fetch(result)))
+	{
+		*now = atoi(row[0]);
+		ret = SUCCEED;
+	}
+
+	zbx_db_free_result(result);
+
+	return ret;
 }
 
 /******************************************************************************
@@ -341,8 +505,6 @@ static void	dbsync_prune_changelog(void)
 	static int		last_prune_time;
 	int			now;
 	zbx_dbsync_changelog_t	*changelog;
-	zbx_db_row_t		row;
-	zbx_db_result_t		result;
 
 	now = time(NULL);
 
@@ -357,14 +519,11 @@ static void	dbsync_prune_changelog(void)
 
 	last_prune_time = now;
 
-	result = zbx_db_select("select %s", ZBX_DB_TIMESTAMP());
-
-	if (NULL != (row = zbx_db_fetch(result)))
+	if (SUCCEED == dbsync_get_db_time(&now))
 	{
 		int	changelog_num;
 
 		changelog_num = dbsync_env.changelog.num_data;
-		now = atoi(row[0]);
 
 		if (ZBX_DB_OK <= zbx_db_execute("delete from changelog where clock<%d", now - ZBX_DBSYNC_CHANGELOG_MAX_AGE))
 		{
@@ -381,8 +540,6 @@ static void	dbsync_prune_changelog(void)
 					changelog_num - dbsync_env.changelog.num_data);
 		}
 	}
-
-	zbx_db_free_result(result);
 }
 
 /******************************************************************************
@@ -447,6 +604,16 @@ int	zbx_dbsync_env_prepare(unsigned char mode)
 	for (i = 0; i < ARRSIZE(dbsync_env.journals); i++)
 		dbsync_journal_init(&dbsync_env.journals[i]);
 
+	dbsync_links_prepare(&dbsync_env.host_templates, mode);
+	dbsync_links_prepare(&dbsync_env.item_discovery, mode);
+	dbsync_links_prepare(&dbsync_env.trigger_deps, mode);
+
+	dbsync_env.interface_um_revision_new = dbsync_env.interface_um_revision;
+
+	/* snapshot commit time is compared with changelog record time when loading snapshot */
+	if (SUCCEED == dbsync_snapshot_begin(mode) && SUCCEED != dbsync_get_db_time(&dbsync_env.snapshot_clock))
+		dbsync_env.snapshot_clock = 0;
+
 	if (ZBX_DBSYNC_INIT == mode)
 	{
 		result = zbx_db_select("select changelogid,clock from changelog");
@@ -456,6 +623,7 @@ int	zbx_dbsync_env_prepare(unsigned char mode)
 			ZBX_DBROW2UINT64(changelog_local.changelogid, row[0]);
 			changelog_local.clock = atoi(row[1]);
 			zbx_hashset_insert(&dbsync_env.changelog, &changelog_local, sizeof(changelog_local));
+			dbsync_snapshot_write_changelog(changelog_local.changelogid, changelog_local.clock);
 			changelog_num++;
 		}
 	}
@@ -528,7 +696,7 @@ static void	dbsync_env_flush_journal(zbx_dbsync_journal_t *journal)
 	if (0 == journal->changelog.values_num)
 		return;
 
-	objects_num = journal->inserts.values_num + journal->updates.values_num;
+	objects_num = journal->inserts.values_num + journal->updates.values_num + journal->deletes.values_num;
 
 	for (i = 0; i < journal->syncs.values_num; i++)
 		objects_num += journal->syncs.values[i]->rows.values_num;
@@ -552,12 +720,24 @@ static void	dbsync_env_flush_journal(zbx_dbsync_journal_t *journal)
 	for (i = 0; i < journal->updates.values_num; i++)
 		zbx_hashset_insert(&objectids, &journal->updates.values[i], sizeof(journal->updates.values[i]));
 
+	/* deleted objects are processed once the journal has been read */
+	if (0 != journal->syncs.values_num)
+	{
+		for (i = 0; i < journal->deletes.values_num; i++)
+		{
+			zbx_hashset_insert(&objectids, &journal->deletes.values[i],
+					sizeof(journal->deletes.values[i]));
+		}
+	}
+
 	for (i = 0; i < journal->changelog.values_num; i++)
 	{
 		if (NULL != zbx_hashset_search(&objectids, &journal->changelog.values[i].objectid))
 		{
-			zbx_hashset_insert(&dbsync_env.changelog, &journal->changelog.values[i].changelog,
-					sizeof(zbx_dbsync_changelog_t));
+			zbx_dbsync_changelog_t	*changelog = &journal->changelog.values[i].changelog;
+
+			zbx_hashset_insert(&dbsync_env.changelog, changelog, sizeof(zbx_dbsync_changelog_t));
+			dbsync_snapshot_write_changelog(changelog->changelogid, changelog->clock);
 		}
 	}
 
@@ -571,15 +751,91 @@ void	zbx_dbsync_env_flush_changelog(void)
 	for (i = 0; i < (int)ARRSIZE(dbsync_env.journals); i++)
 		dbsync_env_flush_journal(&dbsync_env.journals[i]);
 
+	dbsync_links_flush(&dbsync_env.host_templates);
+	dbsync_links_flush(&dbsync_env.item_discovery);
+	dbsync_links_flush(&dbsync_env.trigger_deps);
+
+	dbsync_env.interface_um_revision = dbsync_env.interface_um_revision_new;
+
 	zabbix_log(LOG_LEVEL_DEBUG, "%s() changelog  : %d (%d slots)", __func__,
 			dbsync_env.changelog.num_data, dbsync_env.changelog.num_slots);
 
+	zbx_dbsync_env_flush_snapshot();
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: commit the synced changes to configuration snapshot               *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dbsync_env_flush_snapshot(void)
+{
+	for (int i = 0; i < dbsync_env.changelog_dbsyncs.values_num; i++)
+	{
+		zbx_dbsync_t	*sync = dbsync_env.changelog_dbsyncs.values[i];
+
+		if (ZBX_DBSYNC_UPDATE != sync->mode || 0 == sync->object)
+			continue;
+
+		for (int j = 0; j < sync->rows.values_num; j++)
+		{
+			zbx_dbsync_row_t	*row = (zbx_dbsync_row_t *)sync->rows.values[j];
+
+			if (ZBX_DBSYNC_ROW_REMOVE == row->tag)
+				dbsync_snapshot_write_delete(sync->object, row->rowid);
+		}
+	}
+
+	dbsync_snapshot_commit(dbsync_env.snapshot_clock);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: load configuration snapshot to be used instead of full sync of    *
+ *          changelog objects                                                 *
+ *                                                                            *
+ * Return value: SUCCEED - the snapshot was loaded, the changelog objects     *
+ *                         must be synced in update mode                      *
+ *               FAIL    - there is no valid snapshot                         *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dbsync_env_load_snapshot(void)
+{
+	const zbx_vector_uint64_pair_t	*changelog;
+	int				now;
+
+	if (SUCCEED != dbsync_get_db_time(&now) ||
+			SUCCEED != dbsync_snapshot_load(now, ZBX_DBSYNC_SNAPSHOT_MAX_AGE, &dbsync_env.snapshot))
+	{
+		return FAIL;
+	}
+
+	changelog = dbsync_snapshot_get_changelog(dbsync_env.snapshot);
+
+	for (int i = 0; i < changelog->values_num; i++)
+	{
+		zbx_dbsync_changelog_t	changelog_local;
+
+		changelog_local.changelogid = changelog->values[i].first;
+		changelog_local.clock = (int)changelog->values[i].second;
+		zbx_hashset_insert(&dbsync_env.changelog, &changelog_local, sizeof(changelog_local));
+	}
+
+	return SUCCEED;
 }
 
 void	zbx_dbsync_env_clear(void)
 {
 	size_t	i;
 
+	dbsync_snapshot_rollback();
+
+	if (NULL != dbsync_env.snapshot)
+	{
+		dbsync_snapshot_free(dbsync_env.snapshot);
+		dbsync_env.snapshot = NULL;
+	}
+
 	zbx_vector_dbsync_destroy(&dbsync_env.changelog_dbsyncs);
 
 	dbsync_prune_changelog();
@@ -588,6 +844,10 @@ void	zbx_dbsync_env_clear(void)
 
 	for (i = 0; i < ARRSIZE(dbsync_env.journals); i++)
 		dbsync_journal_destroy(&dbsync_env.journals[i]);
+
+	dbsync_links_clear(&dbsync_env.host_templates);
+	dbsync_links_clear(&dbsync_env.item_discovery);
+	dbsync_links_clear(&dbsync_env.trigger_deps);
 }
 
 int	zbx_dbsync_env_changelog_num(void)
@@ -619,6 +879,37 @@ int	zbx_dbsync_env_changelog_dbsyncs_new_records(void)
 	return FAIL;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check if changelog has records for objects discovery prototypes  *
+ *          consist of                                                        *
+ *                                                                            *
+ * Return value: SUCCEED - there are changelog records for prototype objects  *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Graph prototypes, item parameters and host group prototypes are  *
+ *           not tracked by changelog and must be checked by the caller.      *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dbsync_env_lld_prototypes_changed(void)
+{
+	static const int	objects[] = {ZBX_DBSYNC_OBJ_HOST, ZBX_DBSYNC_OBJ_HOST_TAG, ZBX_DBSYNC_OBJ_ITEM,
+					ZBX_DBSYNC_OBJ_ITEM_TAG, ZBX_DBSYNC_OBJ_TRIGGER, ZBX_DBSYNC_OBJ_TRIGGER_TAG,
+					ZBX_DBSYNC_OBJ_FUNCTION, ZBX_DBSYNC_OBJ_ITEM_PREPROC, ZBX_DBSYNC_OBJ_HOST_MACRO,
+					ZBX_DBSYNC_OBJ_HOST_TEMPLATE, ZBX_DBSYNC_OBJ_HOST_INVENTORY,
+					ZBX_DBSYNC_OBJ_INTERFACE, ZBX_DBSYNC_OBJ_INTERFACE_SNMP,
+					ZBX_DBSYNC_OBJ_ITEM_DISCOVERY, ZBX_DBSYNC_OBJ_TRIGGER_DEPENDENCY};
+	size_t			i;
+
+	for (i = 0; i < ARRSIZE(objects); i++)
+	{
+		if (0 != dbsync_env.journals[ZBX_DBSYNC_JOURNAL(objects[i])].changelog.values_num)
+			return SUCCEED;
+	}
+
+	return FAIL;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: get rows changed since last sync                                  *
@@ -653,6 +944,8 @@ static int	dbsync_get_rows(zbx_dbsync_t *sync, char **sql, size_t *sql_alloc, si
 		while (NULL != (dbrow = zbx_db_fetch(result)))
 		{
 			ZBX_STR2UINT64(rowid, dbrow[0]);
+			dbsync_write_snapshot_row(sync, rowid, dbrow);
+
 			if (NULL != (row = dbsync_preproc_row(sync, dbrow)))
 				dbsync_add_row(sync, rowid, tag, row);
 
@@ -664,110 +957,541 @@ static int	dbsync_get_rows(zbx_dbsync_t *sync, char **sql, size_t *sql_alloc, si
 	zbx_vector_uint64_sort(&read_ids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 	dbsync_remove_duplicate_ids(ids, &read_ids);
 
+	/* the rows that were not read are either removed or do not match query filter anymore */
+	if (0 != sync->object)
+	{
+		for (int i = 0; i < ids->values_num; i++)
+			dbsync_snapshot_write_delete(sync->object, ids->values[i]);
+	}
+
 	zbx_vector_uint64_destroy(&read_ids);
 
 	return SUCCEED;
 }
 
+/* parent object of snapshot rows, changes of which can affect the row without being registered in changelog */
+typedef struct
+{
+	unsigned char	object;
+	unsigned char	parent;
+	int		columns_num;
+	int		columns[2];	/* the parent identifier columns */
+}
+zbx_dbsync_snapshot_parent_t;
+
+static const zbx_dbsync_snapshot_parent_t	dbsync_snapshot_parents[] = {
+	{ZBX_DBSYNC_OBJ_HOST_MACRO, ZBX_DBSYNC_OBJ_HOST, 1, {1}},
+	{ZBX_DBSYNC_OBJ_HOST_INVENTORY, ZBX_DBSYNC_OBJ_HOST, 1, {0}},
+	{ZBX_DBSYNC_OBJ_INTERFACE, ZBX_DBSYNC_OBJ_HOST, 1, {1}},
+	{ZBX_DBSYNC_OBJ_HOST_PROXY, ZBX_DBSYNC_OBJ_HOST, 1, {1}},
+	{ZBX_DBSYNC_OBJ_HOST_TEMPLATE, ZBX_DBSYNC_OBJ_HOST, 2, {0, 1}},
+	{ZBX_DBSYNC_OBJ_ITEM_DISCOVERY, ZBX_DBSYNC_OBJ_ITEM, 2, {0, 1}},
+	{ZBX_DBSYNC_OBJ_TRIGGER_DEPENDENCY, ZBX_DBSYNC_OBJ_TRIGGER, 2, {0, 1}}
+};
+
+/* runtime columns of snapshot rows, which are not tracked by changelog */
+typedef struct
+{
+	unsigned char	object;
+	const char	*sql;		/* the runtime data query, ordered by row identifier */
+	int		columns_num;
+	int		columns[4];	/* the runtime columns in the snapshot row */
+	int		reread;		/* read rows without runtime data from database */
+}
+zbx_dbsync_snapshot_rtdata_t;
+
+static const zbx_dbsync_snapshot_rtdata_t	dbsync_snapshot_rtdata[] = {
+	{ZBX_DBSYNC_OBJ_ITEM, "select itemid,state,lastlogsize,mtime,error from item_rtdata order by itemid",
+			4, {12, 20, 21, 27}, 0},
+	{ZBX_DBSYNC_OBJ_INTERFACE, "select interfaceid,available,disable_until,error,errors_from from interface"
+			" order by interfaceid", 4, {8, 9, 10, 11}, 1},
+	{ZBX_DBSYNC_OBJ_PROXY, "select proxyid,lastaccess from proxy_rtdata order by proxyid", 1, {12}, 0}
+};
+
 /******************************************************************************
  *                                                                            *
- * Purpose: read query data based on changelog journal                        *
+ * Purpose: checks if any parent object of snapshot row was changed           *
+ *                                                                            *
+ * Parameter: parent    - [IN] the parent object definition                   *
+ *            parentids - [IN] the sorted identifiers of changed parents      *
+ *            row       - [IN] the snapshot row                               *
+ *                                                                            *
+ * Return value: SUCCEED - a parent object was changed                        *
+ *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	dbsync_read_journal(zbx_dbsync_t *sync, char **sql, size_t *sql_alloc, size_t *sql_offset,
-		const char *field, const char *keyword, const char *order_field, zbx_dbsync_journal_t *journal)
+static int	dbsync_snapshot_parent_changed(const zbx_dbsync_snapshot_parent_t *parent,
+		const zbx_vector_uint64_t *parentids, char **row)
 {
-	int	i, inserts_num, updates_num;
-
-	if (ZBX_DBSYNC_TYPE_CHANGELOG != sync->type)
+	for (int i = 0; i < parent->columns_num; i++)
 	{
-		/* sync objects using changelog must be initialized with zbx_dbsync_init_changelog() */
-		THIS_SHOULD_NEVER_HAPPEN;
-		exit(EXIT_FAILURE);
-	}
-
-	zbx_vector_dbsync_append(&journal->syncs, sync);
-
-	inserts_num = journal->inserts.values_num;
-	updates_num = journal->updates.values_num;
+		zbx_uint64_t	parentid;
 
-	if (0 != journal->inserts.values_num || 0 != journal->updates.values_num)
-	{
-		zbx_chrcpy_alloc(sql, sql_alloc, sql_offset, ' ');
-		zbx_strcpy_alloc(sql, sql_alloc, sql_offset, keyword);
+		if (NULL == row[parent->columns[i]])
+			continue;
 
-		if (0 != journal->inserts.values_num)
-		{
-			if (FAIL == dbsync_get_rows(sync, sql, sql_alloc, sql_offset, field, order_field,
-					&journal->inserts, ZBX_DBSYNC_ROW_ADD))
-			{
-				return FAIL;
-			}
-		}
+		ZBX_STR2UINT64(parentid, row[parent->columns[i]]);
 
-		if (0 != journal->updates.values_num)
-		{
-			if (FAIL == dbsync_get_rows(sync, sql, sql_alloc, sql_offset, field, order_field,
-					&journal->updates, ZBX_DBSYNC_ROW_UPDATE))
-			{
-				return FAIL;
-			}
-		}
+		if (FAIL != zbx_vector_uint64_bsearch(parentids, parentid, ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+			return SUCCEED;
 	}
 
-	for (i = 0; i < journal->deletes.values_num; i++)
-		dbsync_add_row(sync, journal->deletes.values[i], ZBX_DBSYNC_ROW_REMOVE, NULL);
-
-	/* the obtained object identifiers are removed from journal */
-	sync->add_num = (zbx_uint64_t)(inserts_num - journal->inserts.values_num);
-	sync->update_num = (zbx_uint64_t)(updates_num - journal->updates.values_num);
-
-	sync->remove_num = (zbx_uint64_t)journal->deletes.values_num;
-
-	return SUCCEED;
+	return FAIL;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: initializes changeset                                             *
+ * Purpose: adds rows of configuration snapshot to the changeset              *
+ *                                                                            *
+ * Parameter: sync    - [OUT] the changeset                                   *
+ *            journal - [IN/OUT] the changelog journal                        *
+ *            links   - [IN/OUT] the synced link index for link tables,       *
+ *                               NULL otherwise                               *
+ *            num     - [OUT] the number of added rows                        *
+ *                                                                            *
+ * Return value: SUCCEED - the snapshot rows were added                       *
+ *               FAIL    - database error                                     *
+ *                                                                            *
+ * Comments: The configuration cache is empty when snapshot is used, so the   *
+ *           journal updates are converted to inserts. Snapshot rows of the   *
+ *           objects changed since snapshot and rows that might have been     *
+ *           affected by changes of parent objects are replaced with database *
+ *           rows by adding them to journal inserts.                          *
  *                                                                            *
  ******************************************************************************/
-static void	dbsync_init(zbx_dbsync_t *sync, unsigned char mode)
+static int	dbsync_add_snapshot_rows(zbx_dbsync_t *sync, zbx_dbsync_journal_t *journal,
+		zbx_dbsync_links_t *links, int *num)
 {
-	sync->columns_num = 0;
-	sync->mode = mode;
+	const zbx_dbsync_snapshot_parent_t	*parent = NULL;
+	const zbx_dbsync_snapshot_rtdata_t	*rtdata = NULL;
+	zbx_vector_uint64_t			parentids, rereadids;
+	zbx_db_result_t				result = NULL;
+	zbx_db_row_t				rtrow = NULL;
+	zbx_uint64_t				rtid = 0;
+	char					**row;
+	int					rows_num;
+
+	*num = 0;
+
+	if (NULL == dbsync_env.snapshot || 0 == sync->object)
+		return SUCCEED;
 
-	sync->add_num = 0;
-	sync->update_num = 0;
-	sync->remove_num = 0;
+	zbx_vector_uint64_append_array(&journal->inserts, journal->updates.values, journal->updates.values_num);
+	zbx_vector_uint64_sort(&journal->inserts, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_clear(&journal->updates);
 
-	sync->row = NULL;
-	sync->preproc_row_func = NULL;
-	zbx_vector_ptr_create(&sync->columns);
+	if (0 == (rows_num = dbsync_snapshot_get_rows_num(dbsync_env.snapshot, sync->object)))
+		return SUCCEED;
 
-	if (ZBX_DBSYNC_UPDATE == sync->mode)
+	for (size_t i = 0; i < ARRSIZE(dbsync_snapshot_parents); i++)
 	{
-		zbx_vector_ptr_create(&sync->rows);
-		sync->row_index = -1;
+		if (dbsync_snapshot_parents[i].object == sync->object)
+			parent = &dbsync_snapshot_parents[i];
 	}
-	else
-		sync->dbresult = NULL;
-}
 
-/******************************************************************************
- *                                                                            *
- * Purpose: initializes changeset                                             *
- *                                                                            *
- ******************************************************************************/
-void	zbx_dbsync_init(zbx_dbsync_t *sync, unsigned char mode)
-{
-	dbsync_init(sync, mode);
-	sync->type = ZBX_DBSYNC_TYPE_DIFF;
-}
+	for (size_t i = 0; i < ARRSIZE(dbsync_snapshot_rtdata); i++)
+	{
+		if (dbsync_snapshot_rtdata[i].object == sync->object)
+			rtdata = &dbsync_snapshot_rtdata[i];
+	}
 
-/******************************************************************************
- *                                                                            *
- * Purpose: initializes changeset for tables using changelog                  *
+	if (NULL != rtdata)
+	{
+		if (NULL == (result = zbx_db_select("%s", rtdata->sql)))
+			return FAIL;
+
+		if (NULL != (rtrow = zbx_db_fetch(result)))
+			ZBX_STR2UINT64(rtid, rtrow[0]);
+	}
+
+	zbx_vector_uint64_create(&parentids);
+	zbx_vector_uint64_create(&rereadids);
+
+	if (NULL != parent)
+	{
+		zbx_dbsync_journal_t	*journal_parent = &dbsync_env.journals[ZBX_DBSYNC_JOURNAL(parent->parent)];
+
+		for (int i = 0; i < journal_parent->changelog.values_num; i++)
+			zbx_vector_uint64_append(&parentids, journal_parent->changelog.values[i].objectid);
+
+		zbx_vector_uint64_sort(&parentids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_uniq(&parentids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	}
+
+	row = (char **)zbx_malloc(NULL, sizeof(char *) * (size_t)sync->columns_num);
+
+	for (int i = 0; i < rows_num; i++)
+	{
+		zbx_uint64_t	rowid;
+		char		**prow;
+
+		if (SUCCEED != dbsync_snapshot_get_row(dbsync_env.snapshot, sync->object, i, &rowid, row,
+				sync->columns_num))
+		{
+			zbx_vector_uint64_append(&rereadids, rowid);
+			continue;
+		}
+
+		if (FAIL != zbx_vector_uint64_bsearch(&journal->inserts, rowid, ZBX_DEFAULT_UINT64_COMPARE_FUNC) ||
+				FAIL != zbx_vector_uint64_bsearch(&journal->deletes, rowid,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+		{
+			continue;
+		}
+
+		if (NULL != parent && SUCCEED == dbsync_snapshot_parent_changed(parent, &parentids, row))
+		{
+			zbx_vector_uint64_append(&rereadids, rowid);
+			continue;
+		}
+
+		if (NULL != rtdata)
+		{
+			while (NULL != rtrow && rtid < rowid)
+			{
+				if (NULL != (rtrow = zbx_db_fetch(result)))
+					ZBX_STR2UINT64(rtid, rtrow[0]);
+			}
+
+			if (NULL != rtrow && rtid == rowid)
+			{
+				for (int j = 0; j < rtdata->columns_num; j++)
+					row[rtdata->columns[j]] = rtrow[j + 1];
+			}
+			else if (0 != rtdata->reread)
+			{
+				zbx_vector_uint64_append(&rereadids, rowid);
+				continue;
+			}
+			else
+			{
+				for (int j = 0; j < rtdata->columns_num; j++)
+					row[rtdata->columns[j]] = NULL;
+			}
+		}
+
+		if (NULL == (prow = dbsync_preproc_row(sync, row)))
+			continue;
+
+		dbsync_add_row(sync, rowid, ZBX_DBSYNC_ROW_ADD, prow);
+
+		if (NULL != links)
+		{
+			zbx_dbsync_link_t	link;
+
+			ZBX_STR2UINT64(link.first, row[0]);
+			ZBX_STR2UINT64(link.second, row[1]);
+			link.linkid = rowid;
+			zbx_vector_dbsync_link_append(&links->updates, link);
+		}
+
+		(*num)++;
+	}
+
+	zbx_free(row);
+
+	if (0 != rereadids.values_num)
+	{
+		zbx_vector_uint64_append_array(&journal->inserts, rereadids.values, rereadids.values_num);
+		zbx_vector_uint64_sort(&journal->inserts, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	}
+
+	zbx_vector_uint64_destroy(&rereadids);
+	zbx_vector_uint64_destroy(&parentids);
+
+	zbx_db_free_result(result);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: read query data based on changelog journal                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_read_journal(zbx_dbsync_t *sync, char **sql, size_t *sql_alloc, size_t *sql_offset,
+		const char *field, const char *keyword, const char *order_field, zbx_dbsync_journal_t *journal)
+{
+	int	i, inserts_num, updates_num, snapshot_num;
+
+	if (ZBX_DBSYNC_TYPE_CHANGELOG != sync->type)
+	{
+		/* sync objects using changelog must be initialized with zbx_dbsync_init_changelog() */
+		THIS_SHOULD_NEVER_HAPPEN;
+		exit(EXIT_FAILURE);
+	}
+
+	zbx_vector_dbsync_append(&journal->syncs, sync);
+
+	if (FAIL == dbsync_add_snapshot_rows(sync, journal, NULL, &snapshot_num))
+		return FAIL;
+
+	inserts_num = journal->inserts.values_num;
+	updates_num = journal->updates.values_num;
+
+	if (0 != journal->inserts.values_num || 0 != journal->updates.values_num)
+	{
+		zbx_chrcpy_alloc(sql, sql_alloc, sql_offset, ' ');
+		zbx_strcpy_alloc(sql, sql_alloc, sql_offset, keyword);
+
+		if (0 != journal->inserts.values_num)
+		{
+			if (FAIL == dbsync_get_rows(sync, sql, sql_alloc, sql_offset, field, order_field,
+					&journal->inserts, ZBX_DBSYNC_ROW_ADD))
+			{
+				return FAIL;
+			}
+		}
+
+		if (0 != journal->updates.values_num)
+		{
+			if (FAIL == dbsync_get_rows(sync, sql, sql_alloc, sql_offset, field, order_field,
+					&journal->updates, ZBX_DBSYNC_ROW_UPDATE))
+			{
+				return FAIL;
+			}
+		}
+	}
+
+	for (i = 0; i < journal->deletes.values_num; i++)
+		dbsync_add_row(sync, journal->deletes.values[i], ZBX_DBSYNC_ROW_REMOVE, NULL);
+
+	/* the obtained object identifiers are removed from journal */
+	sync->add_num = (zbx_uint64_t)(inserts_num - journal->inserts.values_num + snapshot_num);
+	sync->update_num = (zbx_uint64_t)(updates_num - journal->updates.values_num);
+
+	sync->remove_num = (zbx_uint64_t)journal->deletes.values_num;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds link table row to the synced link index                      *
+ *                                                                            *
+ * Parameter: links - [IN/OUT] the link index                                 *
+ *            row   - [IN] the link row (first, second, link identifiers)     *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_links_add_row(zbx_dbsync_links_t *links, char **row)
+{
+	zbx_dbsync_link_t	link;
+
+	ZBX_STR2UINT64(link.first, row[0]);
+	ZBX_STR2UINT64(link.second, row[1]);
+	ZBX_STR2UINT64(link.linkid, row[2]);
+
+	zbx_hashset_insert(&links->links, &link, sizeof(link));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: read link table changes based on changelog journal                *
+ *                                                                            *
+ * Parameter: sync       - [OUT] the changeset                                *
+ *            sql_select - [IN] the link table query, returning first and     *
+ *                              second object identifiers and link identifier *
+ *            field      - [IN] the link identifier field                     *
+ *            journal    - [IN] the link table changelog journal              *
+ *            links      - [IN/OUT] the synced link index                     *
+ *            parentids  - [IN] the sorted identifiers of deleted linked      *
+ *                              objects                                       *
+ *                                                                            *
+ * Return value: SUCCEED - the changeset was successfully calculated          *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Removed links are added at the end of changeset with the old     *
+ *           object pair as row data. Links removed by cascaded delete of     *
+ *           linked objects are resolved from the deleted object identifiers, *
+ *           because not all databases fire triggers for cascaded deletes.    *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_read_link_journal(zbx_dbsync_t *sync, const char *sql_select, const char *field,
+		zbx_dbsync_journal_t *journal, zbx_dbsync_links_t *links, const zbx_vector_uint64_t *parentids)
+{
+	char				*sql = NULL, first_s[MAX_ID_LEN + 1], second_s[MAX_ID_LEN + 1],
+					linkid_s[MAX_ID_LEN + 1];
+	char				*del_row[3] = {first_s, second_s, linkid_s};
+	size_t				sql_alloc = 0, sql_offset = 0;
+	zbx_uint64_t			*batch;
+	zbx_vector_uint64_t		ids, read_ids;
+	zbx_vector_dbsync_link_t	removes;
+	zbx_dbsync_link_t		*link;
+	zbx_hashset_iter_t		iter;
+	int				i, batch_size, snapshot_num, ret = SUCCEED;
+
+	if (ZBX_DBSYNC_TYPE_CHANGELOG != sync->type)
+	{
+		/* sync objects using changelog must be initialized with zbx_dbsync_init_changelog() */
+		THIS_SHOULD_NEVER_HAPPEN;
+		exit(EXIT_FAILURE);
+	}
+
+	zbx_vector_dbsync_append(&journal->syncs, sync);
+
+	if (FAIL == dbsync_add_snapshot_rows(sync, journal, links, &snapshot_num))
+		return FAIL;
+
+	zbx_vector_uint64_create(&ids);
+	zbx_vector_uint64_create(&read_ids);
+	zbx_vector_dbsync_link_create(&removes);
+
+	zbx_vector_uint64_append_array(&ids, journal->inserts.values, journal->inserts.values_num);
+	zbx_vector_uint64_append_array(&ids, journal->updates.values, journal->updates.values_num);
+
+	for (batch = ids.values; batch < ids.values + ids.values_num; batch += ZBX_DBSYNC_BATCH_SIZE)
+	{
+		zbx_db_result_t	result;
+		zbx_db_row_t	dbrow;
+
+		batch_size = MIN(ZBX_DBSYNC_BATCH_SIZE, ids.values + ids.values_num - batch);
+
+		sql_offset = 0;
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "%s where", sql_select);
+		zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, field, batch, batch_size);
+
+		if (NULL == (result = zbx_db_select("%s", sql)))
+		{
+			ret = FAIL;
+			goto out;
+		}
+
+		while (NULL != (dbrow = zbx_db_fetch(result)))
+		{
+			zbx_dbsync_link_t	link_local;
+			unsigned char		tag = ZBX_DBSYNC_ROW_ADD;
+
+			ZBX_STR2UINT64(link_local.first, dbrow[0]);
+			ZBX_STR2UINT64(link_local.second, dbrow[1]);
+			ZBX_STR2UINT64(link_local.linkid, dbrow[2]);
+
+			zbx_vector_uint64_append(&read_ids, link_local.linkid);
+			dbsync_write_snapshot_row(sync, link_local.linkid, dbrow);
+
+			if (NULL != (link = (zbx_dbsync_link_t *)zbx_hashset_search(&links->links, &link_local.linkid)))
+			{
+				if (link->first == link_local.first && link->second == link_local.second)
+					continue;
+
+				/* linked objects were changed - replace the old link with the new one */
+				zbx_vector_dbsync_link_append(&removes, *link);
+				tag = ZBX_DBSYNC_ROW_UPDATE;
+			}
+
+			dbsync_add_row(sync, link_local.linkid, tag, dbrow);
+			zbx_vector_dbsync_link_append(&links->updates, link_local);
+		}
+		zbx_db_free_result(result);
+	}
+
+	zbx_vector_uint64_sort(&read_ids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	/* the links that were not read have been removed */
+	if (0 != sync->object)
+	{
+		zbx_vector_uint64_sort(&ids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		dbsync_remove_duplicate_ids(&ids, &read_ids);
+
+		for (i = 0; i < ids.values_num; i++)
+			dbsync_snapshot_write_delete(sync->object, ids.values[i]);
+	}
+
+	for (i = 0; i < journal->deletes.values_num; i++)
+	{
+		if (NULL == (link = (zbx_dbsync_link_t *)zbx_hashset_search(&links->links,
+				&journal->deletes.values[i])))
+		{
+			continue;
+		}
+
+		zbx_vector_dbsync_link_append(&removes, *link);
+		zbx_vector_uint64_append(&links->deletes, link->linkid);
+	}
+
+	if (0 != parentids->values_num)
+	{
+		zbx_hashset_iter_reset(&links->links, &iter);
+		while (NULL != (link = (zbx_dbsync_link_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (FAIL == zbx_vector_uint64_bsearch(parentids, link->first,
+					ZBX_DEFAULT_UINT64_COMPARE_FUNC) && FAIL == zbx_vector_uint64_bsearch(parentids,
+					link->second, ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+			{
+				continue;
+			}
+
+			if (FAIL != zbx_vector_uint64_bsearch(&journal->deletes, link->linkid,
+					ZBX_DEFAULT_UINT64_COMPARE_FUNC) ||
+					FAIL != zbx_vector_uint64_bsearch(&read_ids, link->linkid,
+					ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+			{
+				continue;
+			}
+
+			zbx_vector_dbsync_link_append(&removes, *link);
+			zbx_vector_uint64_append(&links->deletes, link->linkid);
+		}
+	}
+
+	/* removed rows must be added at the end of changeset */
+	for (i = 0; i < removes.values_num; i++)
+	{
+		zbx_snprintf(first_s, sizeof(first_s), ZBX_FS_UI64, removes.values[i].first);
+		zbx_snprintf(second_s, sizeof(second_s), ZBX_FS_UI64, removes.values[i].second);
+		zbx_snprintf(linkid_s, sizeof(linkid_s), ZBX_FS_UI64, removes.values[i].linkid);
+		dbsync_add_row(sync, removes.values[i].linkid, ZBX_DBSYNC_ROW_REMOVE, del_row);
+	}
+out:
+	zbx_vector_dbsync_link_destroy(&removes);
+	zbx_vector_uint64_destroy(&read_ids);
+	zbx_vector_uint64_destroy(&ids);
+	zbx_free(sql);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initializes changeset                                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_init(zbx_dbsync_t *sync, unsigned char mode)
+{
+	sync->columns_num = 0;
+	sync->mode = mode;
+	sync->object = 0;
+
+	sync->add_num = 0;
+	sync->update_num = 0;
+	sync->remove_num = 0;
+
+	sync->row = NULL;
+	sync->preproc_row_func = NULL;
+	zbx_vector_ptr_create(&sync->columns);
+
+	if (ZBX_DBSYNC_UPDATE == sync->mode)
+	{
+		zbx_vector_ptr_create(&sync->rows);
+		sync->row_index = -1;
+	}
+	else
+		sync->dbresult = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initializes changeset                                             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dbsync_init(zbx_dbsync_t *sync, unsigned char mode)
+{
+	dbsync_init(sync, mode);
+	sync->type = ZBX_DBSYNC_TYPE_DIFF;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initializes changeset for tables using changelog                  *
  *                                                                            *
  ******************************************************************************/
 void	zbx_dbsync_init_changelog(zbx_dbsync_t *sync, unsigned char mode)
@@ -877,6 +1601,14 @@ int	zbx_dbsync_next(zbx_dbsync_t *sync, zbx_uint64_t *rowid, char ***row, unsign
 			return FAIL;
 		}
 
+		if (0 != sync->object)
+		{
+			zbx_uint64_t	dbrowid;
+
+			ZBX_STR2UINT64(dbrowid, dbrow[dbsync_rowid_column(sync->object)]);
+			dbsync_write_snapshot_row(sync, dbrowid, dbrow);
+		}
+
 		*row = dbsync_preproc_row(sync, dbrow);
 
 		*rowid = 0;
@@ -1087,7 +1819,7 @@ int	zbx_dbsync_compare_hosts(zbx_dbsync_t *sync)
 			" where status in (%d,%d) and flags<>%d",
 			HOST_STATUS_MONITORED, HOST_STATUS_NOT_MONITORED, ZBX_FLAG_DISCOVERY_PROTOTYPE);
 
-	dbsync_prepare(sync, 21, NULL);
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_HOST, 21, NULL);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -1104,33 +1836,6 @@ out:
 	return ret;
 }
 
-/******************************************************************************
- *                                                                            *
- * Purpose: compares host inventory table row with cached configuration data  *
- *                                                                            *
- * Parameter: hi    - [IN] the cached host inventory data                     *
- *            dbrow - [IN] the database row                                   *
- *                                                                            *
- * Return value: SUCCEED - the row matches configuration data                 *
- *               FAIL    - otherwise                                          *
- *                                                                            *
- ******************************************************************************/
-static int	dbsync_compare_host_inventory(const ZBX_DC_HOST_INVENTORY *hi, const zbx_db_row_t dbrow)
-{
-	int	i;
-
-	if (SUCCEED != dbsync_compare_uchar(dbrow[1], hi->inventory_mode))
-		return FAIL;
-
-	for (i = 0; i < HOST_INVENTORY_FIELD_COUNT; i++)
-	{
-		if (FAIL == dbsync_compare_str(dbrow[i + 2], hi->values[i]))
-			return FAIL;
-	}
-
-	return SUCCEED;
-}
-
 /******************************************************************************
  *                                                                            *
  * Purpose: compares host_inventory table with cached configuration data      *
@@ -1143,15 +1848,13 @@ static int	dbsync_compare_host_inventory(const ZBX_DC_HOST_INVENTORY *hi, const
  ******************************************************************************/
 int	zbx_dbsync_compare_host_inventory(zbx_dbsync_t *sync)
 {
-	zbx_db_row_t		dbrow;
-	zbx_db_result_t		result;
-	zbx_hashset_t		ids;
-	zbx_hashset_iter_t	iter;
-	zbx_uint64_t		rowid;
-	ZBX_DC_HOST_INVENTORY	*hi;
-	const char		*sql;
+	char			*sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	int			i, ret = SUCCEED;
+	zbx_dbsync_journal_t	*journal, *journal_hosts;
 
-	sql = "select hostid,inventory_mode,type,type_full,name,alias,os,os_full,os_short,serialno_a,"
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset,
+			"select hostid,inventory_mode,type,type_full,name,alias,os,os_full,os_short,serialno_a,"
 			"serialno_b,tag,asset_tag,macaddress_a,macaddress_b,hardware,hardware_full,software,"
 			"software_full,software_app_a,software_app_b,software_app_c,software_app_d,"
 			"software_app_e,contact,location,location_lat,location_lon,notes,chassis,model,"
@@ -1162,199 +1865,63 @@ int	zbx_dbsync_compare_host_inventory(zbx_dbsync_t *sync)
 			"site_notes,poc_1_name,poc_1_email,poc_1_phone_a,poc_1_phone_b,poc_1_cell,"
 			"poc_1_screen,poc_1_notes,poc_2_name,poc_2_email,poc_2_phone_a,poc_2_phone_b,"
 			"poc_2_cell,poc_2_screen,poc_2_notes"
-			" from host_inventory";
+			" from host_inventory");
 
-	if (NULL == (result = zbx_db_select("%s", sql)))
-		return FAIL;
-
-	dbsync_prepare(sync, 72, NULL);
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_HOST_INVENTORY, 72, NULL);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		sync->dbresult = result;
-		return SUCCEED;
-	}
-
-	zbx_hashset_create(&ids, (size_t)dbsync_env.cache->host_inventories.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
-			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-
-	while (NULL != (dbrow = zbx_db_fetch(result)))
-	{
-		unsigned char	tag = ZBX_DBSYNC_ROW_NONE;
-
-		ZBX_STR2UINT64(rowid, dbrow[0]);
-		zbx_hashset_insert(&ids, &rowid, sizeof(rowid));
-
-		if (NULL == (hi = (ZBX_DC_HOST_INVENTORY *)zbx_hashset_search(&dbsync_env.cache->host_inventories,
-				&rowid)))
-		{
-			tag = ZBX_DBSYNC_ROW_ADD;
-		}
-		else if (FAIL == dbsync_compare_host_inventory(hi, dbrow))
-			tag = ZBX_DBSYNC_ROW_UPDATE;
-
-		if (ZBX_DBSYNC_ROW_NONE != tag)
-			dbsync_add_row(sync, rowid, tag, dbrow);
-
-	}
-
-	zbx_hashset_iter_reset(&dbsync_env.cache->host_inventories, &iter);
-	while (NULL != (hi = (ZBX_DC_HOST_INVENTORY *)zbx_hashset_iter_next(&iter)))
-	{
-		if (NULL == zbx_hashset_search(&ids, &hi->hostid))
-			dbsync_add_row(sync, hi->hostid, ZBX_DBSYNC_ROW_REMOVE, NULL);
-	}
-
-	zbx_hashset_destroy(&ids);
-	zbx_db_free_result(result);
-
-	return SUCCEED;
-}
-
-/******************************************************************************
- *                                                                            *
- * Purpose: compares hosts_templates table with cached configuration data     *
- *                                                                            *
- * Parameter: sync - [OUT] the changeset                                      *
- *                                                                            *
- * Return value: SUCCEED - the changeset was successfully calculated          *
- *               FAIL    - otherwise                                          *
- *                                                                            *
- ******************************************************************************/
-int	zbx_dbsync_compare_host_templates(zbx_dbsync_t *sync)
-{
-	zbx_db_row_t		dbrow;
-	zbx_db_result_t		result;
-	zbx_hashset_iter_t	iter;
-	zbx_um_host_t		**phost;
-	zbx_hashset_t		htmpls;
-	int			i;
-	zbx_uint64_pair_t	ht_local, *ht;
-	char			hostid_s[MAX_ID_LEN + 1], templateid_s[MAX_ID_LEN + 1];
-	char			*del_row[2] = {hostid_s, templateid_s};
-
-	if (NULL == (result = zbx_db_select(
-			"select hostid,templateid"
-			" from hosts_templates"
-			" order by hostid")))
-	{
-		return FAIL;
+		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+			ret = FAIL;
+		goto out;
 	}
 
-	dbsync_prepare(sync, 2, NULL);
+	journal = &dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_HOST_INVENTORY)];
 
-	if (ZBX_DBSYNC_INIT == sync->mode)
+	if (FAIL == (ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "hostid", "where", NULL,
+			journal)))
 	{
-		sync->dbresult = result;
-		return SUCCEED;
+		goto out;
 	}
 
-	zbx_hashset_create(&htmpls, 100, ZBX_DEFAULT_UINT64_PAIR_HASH_FUNC, ZBX_DEFAULT_UINT64_PAIR_COMPARE_FUNC);
+	/* remove inventory of deleted hosts, the cascaded deletes might not be registered in changelog */
+	journal_hosts = &dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_HOST)];
 
-	/* index all host->template links */
-	zbx_hashset_iter_reset(&dbsync_env.cache->um_cache->hosts, &iter);
-	while (NULL != (phost = (zbx_um_host_t **)zbx_hashset_iter_next(&iter)))
+	for (i = 0; i < journal_hosts->deletes.values_num; i++)
 	{
-		ht_local.first = (*phost)->hostid;
-
-		for (i = 0; i < (*phost)->templateids.values_num; i++)
-		{
-			ht_local.second = (*phost)->templateids.values[i];
-			zbx_hashset_insert(&htmpls, &ht_local, sizeof(ht_local));
-		}
-	}
+		zbx_uint64_t	hostid = journal_hosts->deletes.values[i];
 
-	/* add new rows, remove existing rows from index */
-	while (NULL != (dbrow = zbx_db_fetch(result)))
-	{
-		ZBX_STR2UINT64(ht_local.first, dbrow[0]);
-		ZBX_STR2UINT64(ht_local.second, dbrow[1]);
+		if (NULL == zbx_hashset_search(&dbsync_env.cache->host_inventories, &hostid))
+			continue;
 
-		if (NULL == (ht = (zbx_uint64_pair_t *)zbx_hashset_search(&htmpls, &ht_local)))
-			dbsync_add_row(sync, 0, ZBX_DBSYNC_ROW_ADD, dbrow);
-		else
-			zbx_hashset_remove_direct(&htmpls, ht);
-	}
+		if (FAIL != zbx_vector_uint64_bsearch(&journal->deletes, hostid, ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+			continue;
 
-	/* add removed rows */
-	zbx_hashset_iter_reset(&htmpls, &iter);
-	while (NULL != (ht = (zbx_uint64_pair_t *)zbx_hashset_iter_next(&iter)))
-	{
-		zbx_snprintf(hostid_s, sizeof(hostid_s), ZBX_FS_UI64, ht->first);
-		zbx_snprintf(templateid_s, sizeof(templateid_s), ZBX_FS_UI64, ht->second);
-		dbsync_add_row(sync, 0, ZBX_DBSYNC_ROW_REMOVE, del_row);
+		dbsync_add_row(sync, hostid, ZBX_DBSYNC_ROW_REMOVE, NULL);
 	}
+out:
+	zbx_free(sql);
 
-	zbx_db_free_result(result);
-	zbx_hashset_destroy(&htmpls);
-
-	return SUCCEED;
+	return ret;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: compares global macro table row with cached configuration data    *
- *                                                                            *
- * Parameter: gmacro - [IN] the cached global macro data                      *
- *            dbrow    - [IN] the database row                                *
- *                                                                            *
- * Return value: SUCCEED - the row matches configuration data                 *
- *               FAIL    - otherwise                                          *
+ * Purpose: indexes host template links during initial sync                   *
  *                                                                            *
  ******************************************************************************/
-static int	dbsync_compare_global_macro(const zbx_um_macro_t *gmacro, const zbx_db_row_t dbrow)
+static char	**dbsync_host_template_preproc_row(zbx_dbsync_t *sync, char **row)
 {
-	char	*macro = NULL, *context = NULL;
-	int	ret = FAIL;
-	unsigned char	context_op;
-
-	if (FAIL == dbsync_compare_uchar(dbrow[3], gmacro->type))
-		return FAIL;
-
-	if (ZBX_MACRO_VALUE_VAULT == atoi(dbrow[3]))
-	{
-		if (FAIL == um_macro_check_vault_location(gmacro, dbrow[2]))
-			return FAIL;
-	}
-	else
-	{
-		if (FAIL == dbsync_compare_str(dbrow[2], gmacro->value))
-			return FAIL;
-	}
-
-	if (SUCCEED != zbx_user_macro_parse_dyn(dbrow[1], &macro, &context, NULL, &context_op))
-		return FAIL;
+	ZBX_UNUSED(sync);
 
-	if (0 != strcmp(gmacro->name, macro))
-		goto out;
-
-	if (NULL == context)
-	{
-		if (NULL != gmacro->context)
-			goto out;
-
-		ret = SUCCEED;
-		goto out;
-	}
+	dbsync_links_add_row(&dbsync_env.host_templates, row);
 
-	if (NULL == gmacro->context)
-		goto out;
-
-	if (gmacro->context_op != context_op)
-		goto out;
-
-	if (0 == strcmp(gmacro->context, context))
-		ret = SUCCEED;
-out:
-	zbx_free(macro);
-	zbx_free(context);
-
-	return ret;
+	return row;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: compares global macros table with cached configuration data       *
+ * Purpose: compares hosts_templates table with cached configuration data     *
  *                                                                            *
  * Parameter: sync - [OUT] the changeset                                      *
  *                                                                            *
@@ -1362,122 +1929,59 @@ out:
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-int	zbx_dbsync_compare_global_macros(zbx_dbsync_t *sync)
+int	zbx_dbsync_compare_host_templates(zbx_dbsync_t *sync)
 {
-	zbx_db_row_t		dbrow;
-	zbx_db_result_t		result;
-	zbx_hashset_t		ids;
-	zbx_hashset_iter_t	iter;
-	zbx_uint64_t		rowid, *prowid = &rowid;
-	zbx_um_macro_t		**pmacro;
-
-	if (NULL == (result = zbx_db_select(
-			"select globalmacroid,macro,value,type"
-			" from globalmacro")))
-	{
-		return FAIL;
-	}
-
-	dbsync_prepare(sync, 4, NULL);
+	const char	*sql = "select hostid,templateid,hosttemplateid from hosts_templates";
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		sync->dbresult = result;
-		return SUCCEED;
-	}
-
-	zbx_hashset_create(&ids, (size_t)dbsync_env.cache->gmacros.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
-			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_HOST_TEMPLATE, 3, dbsync_host_template_preproc_row);
 
-	while (NULL != (dbrow = zbx_db_fetch(result)))
-	{
-		unsigned char	tag = ZBX_DBSYNC_ROW_NONE;
-
-		ZBX_STR2UINT64(rowid, dbrow[0]);
-		zbx_hashset_insert(&ids, &rowid, sizeof(rowid));
-
-		if (NULL == (pmacro = (zbx_um_macro_t **)zbx_hashset_search(&dbsync_env.cache->gmacros, &prowid)))
-			tag = ZBX_DBSYNC_ROW_ADD;
-		else if (FAIL == dbsync_compare_global_macro(*pmacro, dbrow))
-			tag = ZBX_DBSYNC_ROW_UPDATE;
-
-		if (ZBX_DBSYNC_ROW_NONE != tag)
-			dbsync_add_row(sync, rowid, tag, dbrow);
-	}
+		if (NULL == (sync->dbresult = zbx_db_select("%s order by hostid", sql)))
+			return FAIL;
 
-	zbx_hashset_iter_reset(&dbsync_env.cache->gmacros, &iter);
-	while (NULL != (pmacro = (zbx_um_macro_t **)zbx_hashset_iter_next(&iter)))
-	{
-		if (NULL == zbx_hashset_search(&ids, &(*pmacro)->macroid))
-			dbsync_add_row(sync, (*pmacro)->macroid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		return SUCCEED;
 	}
 
-	zbx_hashset_destroy(&ids);
-	zbx_db_free_result(result);
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_HOST_TEMPLATE, 3, NULL);
 
-	return SUCCEED;
+	return dbsync_read_link_journal(sync, sql, "hosttemplateid",
+			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_HOST_TEMPLATE)],
+			&dbsync_env.host_templates,
+			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_HOST)].deletes);
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: compares host macro table row with cached configuration data      *
- *                                                                            *
- * Parameter: hmacro - [IN] the cached host macro data                        *
- *            dbrow  - [IN] the database row                                  *
- *                                                                            *
- * Return value: SUCCEED - the row matches configuration data                 *
- *               FAIL    - otherwise                                          *
- *                                                                            *
- ******************************************************************************/
-static int	dbsync_compare_host_macro(const zbx_um_macro_t *hmacro, const zbx_db_row_t dbrow)
-{
-	char		*macro = NULL, *context = NULL;
-	int		ret = FAIL;
-	unsigned char	context_op;
-
-	if (FAIL == dbsync_compare_uchar(dbrow[4], hmacro->type))
-		return FAIL;
-
-	if (ZBX_MACRO_VALUE_VAULT == atoi(dbrow[4]))
-	{
-		if (FAIL == um_macro_check_vault_location(hmacro, dbrow[3]))
-			return FAIL;
-	}
-	else
-	{
-		if (FAIL == dbsync_compare_str(dbrow[3], hmacro->value))
-			return FAIL;
-	}
-
-	if (FAIL == dbsync_compare_uint64(dbrow[1], hmacro->hostid))
-		return FAIL;
+ * Purpose: compares global macros table with cached configuration data       *
+ *                                                                            *
+ * Parameter: sync - [OUT] the changeset                                      *
+ *                                                                            *
+ * Return value: SUCCEED - the changeset was successfully calculated          *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dbsync_compare_global_macros(zbx_dbsync_t *sync)
+{
+	char	*sql = NULL;
+	size_t	sql_alloc = 0, sql_offset = 0;
+	int	ret = SUCCEED;
 
-	if (SUCCEED != zbx_user_macro_parse_dyn(dbrow[2], &macro, &context, NULL, &context_op))
-		return FAIL;
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "select globalmacroid,macro,value,type from globalmacro");
 
-	if (0 != strcmp(hmacro->name, macro))
-		goto out;
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_GLOBAL_MACRO, 4, NULL);
 
-	if (NULL == context)
+	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		if (NULL != hmacro->context)
-			goto out;
-
-		ret = SUCCEED;
+		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+			ret = FAIL;
 		goto out;
 	}
 
-	if (NULL == hmacro->context)
-		goto out;
-
-	if (context_op != hmacro->context_op)
-		goto  out;
-
-	if (0 == strcmp(hmacro->context, context))
-		ret = SUCCEED;
+	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "globalmacroid", "where", NULL,
+			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_GLOBAL_MACRO)]);
 out:
-	zbx_free(macro);
-	zbx_free(context);
+	zbx_free(sql);
 
 	return ret;
 }
@@ -1494,54 +1998,61 @@ out:
  ******************************************************************************/
 int	zbx_dbsync_compare_host_macros(zbx_dbsync_t *sync)
 {
-	zbx_db_row_t		dbrow;
-	zbx_db_result_t		result;
-	zbx_hashset_t		ids;
-	zbx_hashset_iter_t	iter;
-	zbx_uint64_t		rowid, *prowid = &rowid;
-	zbx_um_macro_t		**pmacro;
+	char			*sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	int			i, j, ret = SUCCEED;
+	zbx_dbsync_journal_t	*journal, *journal_hosts;
 
-	if (NULL == (result = zbx_db_select("select hostmacroid,hostid,macro,value,type from hostmacro")))
-		return FAIL;
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "select hostmacroid,hostid,macro,value,type from hostmacro");
 
-	dbsync_prepare(sync, 5, NULL);
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_HOST_MACRO, 5, NULL);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		sync->dbresult = result;
-		return SUCCEED;
+		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+			ret = FAIL;
+		goto out;
 	}
 
-	zbx_hashset_create(&ids, (size_t)dbsync_env.cache->hmacros.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
-			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	journal = &dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_HOST_MACRO)];
 
-	while (NULL != (dbrow = zbx_db_fetch(result)))
+	if (FAIL == (ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "hostmacroid", "where", NULL,
+			journal)))
 	{
-		unsigned char	tag = ZBX_DBSYNC_ROW_NONE;
+		goto out;
+	}
 
-		ZBX_STR2UINT64(rowid, dbrow[0]);
-		zbx_hashset_insert(&ids, &rowid, sizeof(rowid));
+	/* remove macros of deleted hosts, the cascaded deletes might not be registered in changelog */
+	journal_hosts = &dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_HOST)];
 
-		if (NULL == (pmacro = (zbx_um_macro_t **)zbx_hashset_search(&dbsync_env.cache->hmacros, &prowid)))
-			tag = ZBX_DBSYNC_ROW_ADD;
-		else if (FAIL == dbsync_compare_host_macro(*pmacro, dbrow))
-			tag = ZBX_DBSYNC_ROW_UPDATE;
+	for (i = 0; i < journal_hosts->deletes.values_num; i++)
+	{
+		zbx_uint64_t	*phostid = &journal_hosts->deletes.values[i];
+		zbx_um_host_t	**phost;
 
-		if (ZBX_DBSYNC_ROW_NONE != tag)
-			dbsync_add_row(sync, rowid, tag, dbrow);
-	}
+		if (NULL == (phost = (zbx_um_host_t **)zbx_hashset_search(&dbsync_env.cache->um_cache->hosts,
+				&phostid)))
+		{
+			continue;
+		}
 
-	zbx_hashset_iter_reset(&dbsync_env.cache->hmacros, &iter);
-	while (NULL != (pmacro = (zbx_um_macro_t **)zbx_hashset_iter_next(&iter)))
-	{
-		if (NULL == zbx_hashset_search(&ids, &(*pmacro)->macroid))
-			dbsync_add_row(sync, (*pmacro)->macroid, ZBX_DBSYNC_ROW_REMOVE, NULL);
-	}
+		for (j = 0; j < (*phost)->macros.values_num; j++)
+		{
+			zbx_uint64_t	macroid = (*phost)->macros.values[j]->macroid;
 
-	zbx_hashset_destroy(&ids);
-	zbx_db_free_result(result);
+			if (FAIL != zbx_vector_uint64_bsearch(&journal->deletes, macroid,
+					ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+			{
+				continue;
+			}
 
-	return SUCCEED;
+			dbsync_add_row(sync, macroid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		}
+	}
+out:
+	zbx_free(sql);
+
+	return ret;
 }
 
 /******************************************************************************
@@ -1689,6 +2200,66 @@ static char	**dbsync_interface_preproc_row(zbx_dbsync_t *sync, char **row)
 	return sync->row;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds interfaces with changed macro resolving results to changeset *
+ *                                                                            *
+ * Parameter: sync       - [OUT] the changeset                                *
+ *            sql_select - [IN] the interface query                           *
+ *            journal    - [IN] the interface changelog journal               *
+ *            update_num - [OUT] the number of updated interfaces             *
+ *                                                                            *
+ * Return value: SUCCEED - the interfaces were successfully compared          *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Interface addresses can depend on user macros and host data,     *
+ *           which are not tracked by interface changelog, so interfaces with *
+ *           macros in address fields are compared with cached data.          *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_compare_interface_macros(zbx_dbsync_t *sync, const char *sql_select,
+		const zbx_dbsync_journal_t *journal, int *update_num)
+{
+	zbx_db_row_t		dbrow;
+	zbx_db_result_t		result;
+	zbx_uint64_t		rowid;
+	ZBX_DC_INTERFACE	*interface;
+	char			**row;
+
+	if (NULL == (result = zbx_db_select("%s where i.ip like '%%{%%' or i.dns like '%%{%%'", sql_select)))
+		return FAIL;
+
+	while (NULL != (dbrow = zbx_db_fetch(result)))
+	{
+		ZBX_STR2UINT64(rowid, dbrow[0]);
+
+		/* changed interfaces will be read from journal */
+		if (FAIL != zbx_vector_uint64_bsearch(&journal->inserts, rowid, ZBX_DEFAULT_UINT64_COMPARE_FUNC) ||
+				FAIL != zbx_vector_uint64_bsearch(&journal->updates, rowid,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+		{
+			continue;
+		}
+
+		if (NULL == (interface = (ZBX_DC_INTERFACE *)zbx_hashset_search(&dbsync_env.cache->interfaces, &rowid)))
+			continue;
+
+		row = dbsync_preproc_row(sync, dbrow);
+
+		if (FAIL == dbsync_compare_interface(interface, row))
+		{
+			dbsync_add_row(sync, rowid, ZBX_DBSYNC_ROW_UPDATE, row);
+			(*update_num)++;
+		}
+	}
+
+	zbx_db_free_result(result);
+
+	dbsync_env.interface_um_revision_new = dbsync_env.cache->um_cache->revision;
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: compares interfaces table with cached configuration data          *
@@ -1701,65 +2272,95 @@ static char	**dbsync_interface_preproc_row(zbx_dbsync_t *sync, char **row)
  ******************************************************************************/
 int	zbx_dbsync_compare_interfaces(zbx_dbsync_t *sync)
 {
-	zbx_db_row_t		dbrow;
-	zbx_db_result_t		result;
-	zbx_hashset_t		ids;
+	char			*sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	int			ret = SUCCEED, update_num = 0;
+	zbx_dbsync_journal_t	*journal, *journal_snmp, *journal_hosts;
 	zbx_hashset_iter_t	iter;
-	zbx_uint64_t		rowid;
 	ZBX_DC_INTERFACE	*interface;
 
-	if (NULL == (result = zbx_db_select(
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset,
 			"select i.interfaceid,i.hostid,i.type,i.main,i.useip,i.ip,i.dns,i.port,"
 			"i.available,i.disable_until,i.error,i.errors_from,"
 			"s.version,s.bulk,s.community,s.securityname,s.securitylevel,s.authpassphrase,s.privpassphrase,"
 			"s.authprotocol,s.privprotocol,s.contextname,s.max_repetitions"
 			" from interface i"
-			" left join interface_snmp s on i.interfaceid=s.interfaceid")))
-	{
-		return FAIL;
-	}
+			" left join interface_snmp s on i.interfaceid=s.interfaceid");
 
-	dbsync_prepare(sync, 23, dbsync_interface_preproc_row);
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_INTERFACE, 23, dbsync_interface_preproc_row);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		sync->dbresult = result;
-		return SUCCEED;
+		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+			ret = FAIL;
+
+		dbsync_env.interface_um_revision = dbsync_env.cache->um_cache->revision;
+		goto out;
 	}
 
-	zbx_hashset_create(&ids, (size_t)dbsync_env.cache->interfaces.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
-			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	journal = &dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_INTERFACE)];
+	journal_snmp = &dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_INTERFACE_SNMP)];
+	journal_hosts = &dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_HOST)];
 
-	while (NULL != (dbrow = zbx_db_fetch(result)))
+	/* SNMP interface data is synced together with interface */
+	if (0 != journal_snmp->changelog.values_num)
 	{
-		unsigned char	tag = ZBX_DBSYNC_ROW_NONE;
-		char		**row;
+		zbx_vector_uint64_append_array(&journal->updates, journal_snmp->inserts.values,
+				journal_snmp->inserts.values_num);
+		zbx_vector_uint64_append_array(&journal->updates, journal_snmp->updates.values,
+				journal_snmp->updates.values_num);
+		zbx_vector_uint64_append_array(&journal->updates, journal_snmp->deletes.values,
+				journal_snmp->deletes.values_num);
 
-		ZBX_STR2UINT64(rowid, dbrow[0]);
-		zbx_hashset_insert(&ids, &rowid, sizeof(rowid));
+		zbx_vector_uint64_sort(&journal->updates, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_uniq(&journal->updates, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
-		row = dbsync_preproc_row(sync, dbrow);
+		dbsync_remove_duplicate_ids(&journal->updates, &journal->deletes);
+		dbsync_remove_duplicate_ids(&journal->updates, &journal->inserts);
+	}
 
-		if (NULL == (interface = (ZBX_DC_INTERFACE *)zbx_hashset_search(&dbsync_env.cache->interfaces, &rowid)))
-			tag = ZBX_DBSYNC_ROW_ADD;
-		else if (FAIL == dbsync_compare_interface(interface, row))
-			tag = ZBX_DBSYNC_ROW_UPDATE;
+	zbx_vector_dbsync_append(&journal_snmp->syncs, sync);
 
-		if (ZBX_DBSYNC_ROW_NONE != tag)
-			dbsync_add_row(sync, rowid, tag, row);
+	if (dbsync_env.cache->um_cache->revision != dbsync_env.interface_um_revision ||
+			0 != journal->changelog.values_num || 0 != journal_hosts->changelog.values_num)
+	{
+		if (FAIL == (ret = dbsync_compare_interface_macros(sync, sql, journal, &update_num)))
+			goto out;
 	}
 
-	zbx_hashset_iter_reset(&dbsync_env.cache->interfaces, &iter);
-	while (NULL != (interface = (ZBX_DC_INTERFACE *)zbx_hashset_iter_next(&iter)))
+	if (FAIL == (ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "i.interfaceid", "where", NULL,
+			journal)))
 	{
-		if (NULL == zbx_hashset_search(&ids, &interface->interfaceid))
-			dbsync_add_row(sync, interface->interfaceid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		goto out;
 	}
 
-	zbx_hashset_destroy(&ids);
-	zbx_db_free_result(result);
+	sync->update_num += (zbx_uint64_t)update_num;
 
-	return SUCCEED;
+	/* remove interfaces of deleted hosts, the cascaded deletes might not be registered in changelog */
+	if (0 != journal_hosts->deletes.values_num)
+	{
+		zbx_hashset_iter_reset(&dbsync_env.cache->interfaces, &iter);
+		while (NULL != (interface = (ZBX_DC_INTERFACE *)zbx_hashset_iter_next(&iter)))
+		{
+			if (FAIL == zbx_vector_uint64_bsearch(&journal_hosts->deletes, interface->hostid,
+					ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+			{
+				continue;
+			}
+
+			if (FAIL != zbx_vector_uint64_bsearch(&journal->deletes, interface->interfaceid,
+					ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+			{
+				continue;
+			}
+
+			dbsync_add_row(sync, interface->interfaceid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		}
+	}
+out:
+	zbx_free(sql);
+
+	return ret;
 }
 
 /******************************************************************************
@@ -1830,11 +2431,11 @@ int	zbx_dbsync_compare_items(zbx_dbsync_t *sync)
 				"i.master_itemid,i.timeout,i.url,i.query_fields,i.posts,i.status_codes,"
 				"i.follow_redirects,i.post_type,i.http_proxy,i.headers,i.retrieve_mode,"
 				"i.request_method,i.output_format,i.ssl_cert_file,i.ssl_key_file,i.ssl_key_password,"
-				"i.verify_peer,i.verify_host,i.allow_traps,i.templateid,null"
+				"i.verify_peer,i.verify_host,i.allow_traps,i.templateid,null,i.name"
 			" from items i"
 			" left join item_rtdata ir on i.itemid=ir.itemid");
 
-	dbsync_prepare(sync, 50, dbsync_item_preproc_row);
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_ITEM, 51, dbsync_item_preproc_row);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -1851,9 +2452,18 @@ out:
 	return ret;
 }
 
-static int	dbsync_compare_item_discovery(const ZBX_DC_ITEM_DISCOVERY *item_discovery, const zbx_db_row_t dbrow)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: indexes item discovery links during initial sync                  *
+ *                                                                            *
+ ******************************************************************************/
+static char	**dbsync_item_discovery_preproc_row(zbx_dbsync_t *sync, char **row)
 {
-	return dbsync_compare_uint64(dbrow[1], item_discovery->parent_itemid);
+	ZBX_UNUSED(sync);
+
+	dbsync_links_add_row(&dbsync_env.item_discovery, row);
+
+	return row;
 }
 
 /******************************************************************************
@@ -1867,60 +2477,24 @@ static int	dbsync_compare_item_discovery(const ZBX_DC_ITEM_DISCOVERY *item_disco
  ******************************************************************************/
 int	zbx_dbsync_compare_item_discovery(zbx_dbsync_t *sync)
 {
-	zbx_db_row_t		dbrow;
-	zbx_db_result_t		result;
-	zbx_hashset_t		ids;
-	zbx_hashset_iter_t	iter;
-	zbx_uint64_t		rowid;
-	ZBX_DC_ITEM_DISCOVERY	*item_discovery;
-	char			**row;
-
-	if (NULL == (result = zbx_db_select("select itemid,parent_itemid from item_discovery")))
-		return FAIL;
-
-	dbsync_prepare(sync, 2, NULL);
+	const char	*sql = "select itemid,parent_itemid,itemdiscoveryid from item_discovery";
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		sync->dbresult = result;
-		return SUCCEED;
-	}
-
-	zbx_hashset_create(&ids, (size_t)dbsync_env.cache->item_discovery.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
-			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-
-	while (NULL != (dbrow = zbx_db_fetch(result)))
-	{
-		unsigned char	tag = ZBX_DBSYNC_ROW_NONE;
-
-		ZBX_STR2UINT64(rowid, dbrow[0]);
-		zbx_hashset_insert(&ids, &rowid, sizeof(rowid));
-
-		row = dbsync_preproc_row(sync, dbrow);
-
-		if (NULL == (item_discovery = (ZBX_DC_ITEM_DISCOVERY *)zbx_hashset_search(
-				&dbsync_env.cache->item_discovery, &rowid)))
-		{
-			tag = ZBX_DBSYNC_ROW_ADD;
-		}
-		else if (FAIL == dbsync_compare_item_discovery(item_discovery, row))
-			tag = ZBX_DBSYNC_ROW_UPDATE;
+		dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_ITEM_DISCOVERY, 3, dbsync_item_discovery_preproc_row);
 
-		if (ZBX_DBSYNC_ROW_NONE != tag)
-			dbsync_add_row(sync, rowid, tag, row);
-	}
+		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+			return FAIL;
 
-	zbx_hashset_iter_reset(&dbsync_env.cache->item_discovery, &iter);
-	while (NULL != (item_discovery = (ZBX_DC_ITEM_DISCOVERY *)zbx_hashset_iter_next(&iter)))
-	{
-		if (NULL == zbx_hashset_search(&ids, &item_discovery->itemid))
-			dbsync_add_row(sync, item_discovery->itemid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		return SUCCEED;
 	}
 
-	zbx_hashset_destroy(&ids);
-	zbx_db_free_result(result);
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_ITEM_DISCOVERY, 3, NULL);
 
-	return SUCCEED;
+	return dbsync_read_link_journal(sync, sql, "itemdiscoveryid",
+			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_ITEM_DISCOVERY)],
+			&dbsync_env.item_discovery,
+			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_ITEM)].deletes);
 }
 
 /******************************************************************************
@@ -2022,7 +2596,7 @@ int	zbx_dbsync_compare_triggers(zbx_dbsync_t *sync)
 			"null,null,flags"
 			" from triggers");
 
-	dbsync_prepare(sync, 20, dbsync_trigger_preproc_row);
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_TRIGGER, 20, dbsync_trigger_preproc_row);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -2039,6 +2613,20 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: indexes trigger dependencies during initial sync                  *
+ *                                                                            *
+ ******************************************************************************/
+static char	**dbsync_trigger_dependency_preproc_row(zbx_dbsync_t *sync, char **row)
+{
+	ZBX_UNUSED(sync);
+
+	dbsync_links_add_row(&dbsync_env.trigger_deps, row);
+
+	return row;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: compares trigger_depends table with cached configuration data     *
@@ -2051,68 +2639,25 @@ out:
  ******************************************************************************/
 int	zbx_dbsync_compare_trigger_dependency(zbx_dbsync_t *sync)
 {
-	zbx_db_row_t		dbrow;
-	zbx_db_result_t		result;
-	zbx_hashset_t		deps;
-	zbx_hashset_iter_t	iter;
-	ZBX_DC_TRIGGER_DEPLIST	*dep_down, *dep_up;
-	zbx_uint64_pair_t	*dep, dep_local;
-	char			down_s[MAX_ID_LEN + 1], up_s[MAX_ID_LEN + 1];
-	char			*del_row[2] = {down_s, up_s};
-	int			i;
-
-	if (NULL == (result = zbx_db_select("select triggerid_down,triggerid_up from trigger_depends")))
-		return FAIL;
-
-	dbsync_prepare(sync, 2, NULL);
+	const char	*sql = "select triggerid_down,triggerid_up,triggerdepid from trigger_depends";
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
-		sync->dbresult = result;
-		return SUCCEED;
-	}
-
-	zbx_hashset_create(&deps, 100, ZBX_DEFAULT_UINT64_PAIR_HASH_FUNC, ZBX_DEFAULT_UINT64_PAIR_COMPARE_FUNC);
-
-	/* index all host->template links */
-	zbx_hashset_iter_reset(&dbsync_env.cache->trigdeps, &iter);
-	while (NULL != (dep_down = (ZBX_DC_TRIGGER_DEPLIST *)zbx_hashset_iter_next(&iter)))
-	{
-		dep_local.first = dep_down->triggerid;
-
-		for (i = 0; i < dep_down->dependencies.values_num; i++)
-		{
-			dep_up = (ZBX_DC_TRIGGER_DEPLIST *)dep_down->dependencies.values[i];
-			dep_local.second = dep_up->triggerid;
-			zbx_hashset_insert(&deps, &dep_local, sizeof(dep_local));
-		}
-	}
-
-	/* add new rows, remove existing rows from index */
-	while (NULL != (dbrow = zbx_db_fetch(result)))
-	{
-		ZBX_STR2UINT64(dep_local.first, dbrow[0]);
-		ZBX_STR2UINT64(dep_local.second, dbrow[1]);
+		dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_TRIGGER_DEPENDENCY, 3,
+				dbsync_trigger_dependency_preproc_row);
 
-		if (NULL == (dep = (zbx_uint64_pair_t *)zbx_hashset_search(&deps, &dep_local)))
-			dbsync_add_row(sync, 0, ZBX_DBSYNC_ROW_ADD, dbrow);
-		else
-			zbx_hashset_remove_direct(&deps, dep);
-	}
+		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
+			return FAIL;
 
-	/* add removed rows */
-	zbx_hashset_iter_reset(&deps, &iter);
-	while (NULL != (dep = (zbx_uint64_pair_t *)zbx_hashset_iter_next(&iter)))
-	{
-		zbx_snprintf(down_s, sizeof(down_s), ZBX_FS_UI64, dep->first);
-		zbx_snprintf(up_s, sizeof(up_s), ZBX_FS_UI64, dep->second);
-		dbsync_add_row(sync, 0, ZBX_DBSYNC_ROW_REMOVE, del_row);
+		return SUCCEED;
 	}
 
-	zbx_db_free_result(result);
-	zbx_hashset_destroy(&deps);
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_TRIGGER_DEPENDENCY, 3, NULL);
 
-	return SUCCEED;
+	return dbsync_read_link_journal(sync, sql, "triggerdepid",
+			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_TRIGGER_DEPENDENCY)],
+			&dbsync_env.trigger_deps,
+			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_TRIGGER)].deletes);
 }
 
 /******************************************************************************
@@ -2164,7 +2709,7 @@ int	zbx_dbsync_compare_functions(zbx_dbsync_t *sync)
 	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
 			"select functionid,itemid,name,parameter,triggerid from functions");
 
-	dbsync_prepare(sync, 5, dbsync_function_preproc_row);
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_FUNCTION, 5, dbsync_function_preproc_row);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -2593,7 +3138,7 @@ int	zbx_dbsync_compare_trigger_tags(zbx_dbsync_t *sync)
 
 	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select triggertagid,triggerid,tag,value from trigger_tag");
 
-	dbsync_prepare(sync, 4, NULL);
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_TRIGGER_TAG, 4, NULL);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -2628,7 +3173,7 @@ int	zbx_dbsync_compare_item_tags(zbx_dbsync_t *sync)
 
 	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select itemtagid,itemid,tag,value from item_tag");
 
-	dbsync_prepare(sync, 4, NULL);
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_ITEM_TAG, 4, NULL);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -2663,7 +3208,7 @@ int	zbx_dbsync_compare_host_tags(zbx_dbsync_t *sync)
 
 	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select hosttagid,hostid,tag,value from host_tag");
 
-	dbsync_prepare(sync, 4, NULL);
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_HOST_TAG, 4, NULL);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -3109,7 +3654,7 @@ int	zbx_dbsync_compare_item_preprocs(zbx_dbsync_t *sync)
 			"select item_preprocid,itemid,type,params,step,error_handler,error_handler_params"
 			" from item_preproc");
 
-	dbsync_prepare(sync, 7, NULL);
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_ITEM_PREPROC, 7, NULL);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -3788,7 +4333,7 @@ int	zbx_dbsync_prepare_drules(zbx_dbsync_t *sync)
 	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
 			"select druleid,proxyid,delay,name,iprange,status,concurrency_max from drules");
 
-	dbsync_prepare(sync, 7, NULL);
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_DRULE, 7, NULL);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -3828,7 +4373,7 @@ int	zbx_dbsync_prepare_dchecks(zbx_dbsync_t *sync)
 				"snmpv3_authprotocol,snmpv3_privprotocol,snmpv3_contextname,allow_redirect"
 			" from dchecks");
 
-	dbsync_prepare(sync, 15, NULL);
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_DCHECK, 15, NULL);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -3863,7 +4408,7 @@ int	zbx_dbsync_prepare_httptests(zbx_dbsync_t *sync)
 
 	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select httptestid,hostid,delay,status from httptest");
 
-	dbsync_prepare(sync, 4, NULL);
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_HTTPTEST, 4, NULL);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -3898,7 +4443,7 @@ int	zbx_dbsync_prepare_httptest_fields(zbx_dbsync_t *sync)
 
 	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select httptest_fieldid,httptestid from httptest_field");
 
-	dbsync_prepare(sync, 2, NULL);
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_HTTPTEST_FIELD, 2, NULL);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -3932,7 +4477,7 @@ int	zbx_dbsync_prepare_httpsteps(zbx_dbsync_t *sync)
 	int	ret = SUCCEED;
 
 	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select httpstepid,httptestid from httpstep");
-	dbsync_prepare(sync, 2, NULL);
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_HTTPSTEP, 2, NULL);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -3966,7 +4511,7 @@ int	zbx_dbsync_prepare_httpstep_fields(zbx_dbsync_t *sync)
 	int	ret = SUCCEED;
 
 	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select httpstep_fieldid,httpstepid from httpstep_field");
-	dbsync_prepare(sync, 2, NULL);
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_HTTPSTEP_FIELD, 2, NULL);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -4006,7 +4551,7 @@ int	zbx_dbsync_compare_connectors(zbx_dbsync_t *sync)
 			"tags_evaltype,item_value_type,attempt_interval"
 		" from connector");
 
-	dbsync_prepare(sync, 22, NULL);
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_CONNECTOR, 22, NULL);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -4033,7 +4578,7 @@ int	zbx_dbsync_compare_connector_tags(zbx_dbsync_t *sync)
 	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select connector_tagid,connectorid,operator,tag,value"
 			" from connector_tag");
 
-	dbsync_prepare(sync, 5, NULL);
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_CONNECTOR_TAG, 5, NULL);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -4067,7 +4612,7 @@ int	zbx_dbsync_compare_proxies(zbx_dbsync_t *sync)
 			" left join proxy_rtdata pr"
 				" on p.proxyid=pr.proxyid");
 
-	dbsync_prepare(sync, 27, NULL);
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_PROXY, 27, NULL);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -4103,7 +4648,7 @@ int	zbx_dbsync_prepare_proxy_group(zbx_dbsync_t *sync)
 	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
 			"select proxy_groupid,failover_delay,min_online,name from proxy_group");
 
-	dbsync_prepare(sync, 4, NULL);
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_PROXY_GROUP, 4, NULL);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -4143,7 +4688,7 @@ int	zbx_dbsync_prepare_host_proxy(zbx_dbsync_t *sync)
 			" left join hosts h"
 				" on hp.hostid=h.hostid");
 
-	dbsync_prepare(sync, 11, NULL);
+	dbsync_prepare_changelog(sync, ZBX_DBSYNC_OBJ_HOST_PROXY, 11, NULL);
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -79,6 +79,9 @@ struct zbx_dbsync
 
 	unsigned char			type;
 
+	/* the changelog object (see ZBX_DBSYNC_OBJ_* defines), 0 if not set */
+	unsigned char			object;
+
 	/* the number of columns in diff */
 	int				columns_num;
 
@@ -106,12 +109,15 @@ struct zbx_dbsync
 	zbx_uint64_t	remove_num;
 };
 
-void	zbx_dbsync_env_init(zbx_dc_config_t *cache);
+void	zbx_dbsync_env_init(zbx_dc_config_t *cache, const char *snapshot_file, unsigned char program_type);
+int	zbx_dbsync_env_load_snapshot(void);
 int	zbx_dbsync_env_prepare(unsigned char mode);
 void	zbx_dbsync_env_flush_changelog(void);
+void	zbx_dbsync_env_flush_snapshot(void);
 void	zbx_dbsync_env_clear(void);
 int	zbx_dbsync_env_changelog_num(void);
 int	zbx_dbsync_env_changelog_dbsyncs_new_records(void);
+int	zbx_dbsync_env_lld_prototypes_changed(void);
 
 void	zbx_dbsync_init(zbx_dbsync_t *sync, unsigned char mode);
 void	zbx_dbsync_init_changelog(zbx_dbsync_t *sync, unsigned char mode);
@@ -0,0 +1,1327 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "dbsync_snapshot.h"
+
+#include "zbxalgo.h"
+#include "zbxcacheconfig.h"
+#include "zbxcommon.h"
+#include "zbxserialize.h"
+#include "zbxstr.h"
+#include "zbxthreads.h"
+#include "version.h"
+
+#include <sys/mman.h>
+
+/******************************************************************************
+ *                                                                            *
+ *                  Configuration snapshot file layout                        *
+ *               -----------------------------------------                    *
+ *                                                                            *
+ * Snapshot file keeps raw database rows of the changelog synchronized        *
+ * objects as they were read during configuration sync, together with ids of  *
+ * the processed changelog records. The file consists of records:             *
+ *                                                                            *
+ *   | payload length (4 bytes) | payload checksum (4 bytes) | payload |      *
+ *                                                                            *
+ * where the first payload byte is the record type:                           *
+ *                                                                            *
+ *   header    - | signature (8) | version (4) | program type (1) | build |   *
+ *   row       - | object (1) | rowid (8) | columns (4) | columns... |        *
+ *   delete    - | object (1) | rowid (8) |                                   *
+ *   changelog - | count (4) | (changelogid (8) | clock (4))... |             *
+ *   commit    - | clock (4) |                                                *
+ *                                                                            *
+ * Full sync writes the header and all rows into temporary file which is      *
+ * renamed over the snapshot file when the sync is committed. Incremental     *
+ * syncs append blocks of row, delete and changelog records terminated by     *
+ * commit record. Blocks without commit record are ignored when loading and   *
+ * the file is truncated after the last committed block.                      *
+ *                                                                            *
+ * When the appended blocks grow much larger than the live data the snapshot  *
+ * is compacted by forked process, which writes the last version of every     *
+ * row into separate file. The blocks committed meanwhile are copied to the   *
+ * compacted file before it replaces the snapshot.                            *
+ *                                                                            *
+ * The file is renamed only after its data has been flushed to disk. The      *
+ * appended blocks are not flushed - the changes of blocks lost on system     *
+ * crash are synced again from changelog, because the changelog records       *
+ * stored in the snapshot are lost with them.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#define DBSYNC_SNAPSHOT_SIGNATURE		"ZBXCFSNP"
+#define DBSYNC_SNAPSHOT_SIGNATURE_LEN		8
+#define DBSYNC_SNAPSHOT_VERSION			1
+#define DBSYNC_SNAPSHOT_BUILD			ZABBIX_VERSION " " ZABBIX_REVISION
+
+#define DBSYNC_SNAPSHOT_RECORD_HEADER_SIZE	(2 * sizeof(zbx_uint32_t))
+
+#define DBSYNC_SNAPSHOT_RECORD_HEADER		0
+#define DBSYNC_SNAPSHOT_RECORD_ROW		1
+#define DBSYNC_SNAPSHOT_RECORD_DELETE		2
+#define DBSYNC_SNAPSHOT_RECORD_CHANGELOG	3
+#define DBSYNC_SNAPSHOT_RECORD_COMMIT		4
+
+/* payload sizes without variable length data */
+#define DBSYNC_SNAPSHOT_ROW_SIZE		(2 + sizeof(zbx_uint64_t) + sizeof(zbx_uint32_t))
+#define DBSYNC_SNAPSHOT_DELETE_SIZE		(2 + sizeof(zbx_uint64_t))
+#define DBSYNC_SNAPSHOT_CHANGELOG_SIZE		(1 + sizeof(zbx_uint32_t))
+#define DBSYNC_SNAPSHOT_CHANGELOG_ENTRY_SIZE	(sizeof(zbx_uint64_t) + sizeof(int))
+#define DBSYNC_SNAPSHOT_COMMIT_SIZE		(1 + sizeof(int))
+
+#define DBSYNC_SNAPSHOT_CHANGELOG_BATCH		1000
+#define DBSYNC_SNAPSHOT_BUFFER_SIZE		ZBX_MEBIBYTE
+
+/* the minimum size of appended blocks to compact snapshot */
+#define DBSYNC_SNAPSHOT_COMPACT_SIZE		(16 * ZBX_MEBIBYTE)
+
+/* empty blocks are committed with this interval to keep snapshot time recent */
+#define DBSYNC_SNAPSHOT_HEARTBEAT		SEC_PER_MIN
+
+#define DBSYNC_SNAPSHOT_COPY_SIZE		(16 * ZBX_KIBIBYTE)
+
+struct zbx_dbsync_snapshot
+{
+	unsigned char			*map;
+	size_t				map_size;
+
+	/* (rowid, record offset) pairs of every object, sorted by rowid */
+	zbx_vector_uint64_pair_t	*rows;
+	int				objects_num;
+
+	/* (changelogid, clock) pairs of the processed changelog records */
+	zbx_vector_uint64_pair_t	changelog;
+
+	int				clock;		/* the last commit time */
+	zbx_uint64_t			end;		/* the position after the last committed block */
+	zbx_uint64_t			rows_size;	/* the size of live row records */
+};
+
+typedef struct
+{
+	char				*path;
+	unsigned char			program_type;
+	int				objects_num;
+	int				changelog_max_age;
+
+	int				fd;
+	int				init;		/* full sync is written into temporary file */
+	int				active;		/* a block is being written */
+	zbx_uint64_t			offset;		/* the file write position */
+	zbx_uint64_t			block_offset;	/* the start of the current block */
+	zbx_uint64_t			base_size;	/* the snapshot size after full sync or compaction */
+	int				records_num;	/* the row and delete records in the current block */
+	int				commit_clock;
+
+	pid_t				compact_pid;	/* the compaction process, 0 if not running */
+	zbx_uint64_t			compact_offset;	/* the end of compacted part of the file */
+
+	unsigned char			*buf;
+	size_t				buf_alloc;
+	size_t				buf_offset;
+
+	/* (changelogid, clock) pairs processed by the current sync */
+	zbx_vector_uint64_pair_t	changelog;
+}
+dbsync_snapshot_writer_t;
+
+static dbsync_snapshot_writer_t	writer;
+
+static zbx_uint32_t	dbsync_snapshot_checksum(const unsigned char *data, size_t len)
+{
+	return (zbx_uint32_t)zbx_hash_modfnv(data, len, ZBX_DEFAULT_HASH_SEED);
+}
+
+static char	*dbsync_snapshot_tmp_path(void)
+{
+	return zbx_dsprintf(NULL, "%s.tmp", writer.path);
+}
+
+static char	*dbsync_snapshot_compact_path(void)
+{
+	return zbx_dsprintf(NULL, "%s.compact", writer.path);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: flush snapshot directory entries to disk                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_snapshot_sync_dir(void)
+{
+	char	*dir, *ptr;
+	int	fd;
+
+	dir = zbx_strdup(NULL, writer.path);
+
+	if (NULL != (ptr = strrchr(dir, '/')))
+		*(dir == ptr ? ptr + 1 : ptr) = '\0';
+	else
+		dir = zbx_strdup(dir, ".");
+
+	if (-1 == (fd = open(dir, O_RDONLY)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot open configuration snapshot directory \"%s\": %s", dir,
+				zbx_strerror(errno));
+		zbx_free(dir);
+		return;
+	}
+
+	if (0 != fsync(fd))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot flush configuration snapshot directory \"%s\": %s", dir,
+				zbx_strerror(errno));
+	}
+
+	close(fd);
+	zbx_free(dir);
+}
+
+static int	dbsync_snapshot_write_all(int fd, const unsigned char *buf, size_t len, zbx_uint64_t offset)
+{
+	while (0 < len)
+	{
+		ssize_t	n;
+
+		if (-1 == (n = pwrite(fd, buf, len, (off_t)offset)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			return FAIL;
+		}
+
+		buf += n;
+		len -= (size_t)n;
+		offset += (zbx_uint64_t)n;
+	}
+
+	return SUCCEED;
+}
+
+static int	dbsync_snapshot_copy(int fd_src, zbx_uint64_t offset, zbx_uint64_t end, int fd_dst,
+		zbx_uint64_t offset_dst)
+{
+	unsigned char	buf[DBSYNC_SNAPSHOT_COPY_SIZE];
+
+	while (offset < end)
+	{
+		ssize_t	n;
+
+		if (-1 == (n = pread(fd_src, buf, (size_t)MIN(sizeof(buf), end - offset), (off_t)offset)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			return FAIL;
+		}
+
+		if (0 == n)
+		{
+			errno = EIO;
+			return FAIL;
+		}
+
+		if (SUCCEED != dbsync_snapshot_write_all(fd_dst, buf, (size_t)n, offset_dst))
+			return FAIL;
+
+		offset += (zbx_uint64_t)n;
+		offset_dst += (zbx_uint64_t)n;
+	}
+
+	return SUCCEED;
+}
+
+static void	dbsync_snapshot_close(void)
+{
+	if (-1 != writer.fd)
+	{
+		close(writer.fd);
+		writer.fd = -1;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: stop running compaction and remove its file                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_snapshot_compact_abort(void)
+{
+	char	*path_compact;
+
+	if (0 == writer.compact_pid)
+		return;
+
+	(void)kill(writer.compact_pid, SIGKILL);
+	(void)waitpid(writer.compact_pid, NULL, 0);
+	writer.compact_pid = 0;
+
+	path_compact = dbsync_snapshot_compact_path();
+	(void)unlink(path_compact);
+	zbx_free(path_compact);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: stop writing snapshot after file operation failure                *
+ *                                                                            *
+ * Parameters: action - [IN] the failed operation                             *
+ *             error  - [IN]                                                  *
+ *                                                                            *
+ * Comments: The snapshot file is removed because it would miss configuration *
+ *           changes. Writing is resumed by the next full configuration sync. *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_snapshot_fail(const char *action, const char *error)
+{
+	char	*path_tmp = dbsync_snapshot_tmp_path();
+
+	zabbix_log(LOG_LEVEL_WARNING, "cannot %s configuration snapshot file \"%s\": %s", action,
+			0 != writer.init ? path_tmp : writer.path, error);
+
+	dbsync_snapshot_close();
+	dbsync_snapshot_compact_abort();
+
+	if (0 != writer.init)
+		(void)unlink(path_tmp);
+
+	(void)unlink(writer.path);
+	zbx_free(path_tmp);
+
+	writer.init = 0;
+	writer.active = 0;
+	writer.buf_offset = 0;
+	zbx_vector_uint64_pair_clear(&writer.changelog);
+}
+
+static int	dbsync_snapshot_flush(void)
+{
+	if (SUCCEED != dbsync_snapshot_write_all(writer.fd, writer.buf, writer.buf_offset, writer.offset))
+	{
+		dbsync_snapshot_fail("write", zbx_strerror(errno));
+		return FAIL;
+	}
+
+	writer.offset += writer.buf_offset;
+	writer.buf_offset = 0;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reserve space in write buffer                                     *
+ *                                                                            *
+ * Parameters: size - [IN] the number of bytes to reserve                     *
+ *                                                                            *
+ * Return value: pointer to the reserved space                                *
+ *                                                                            *
+ ******************************************************************************/
+static unsigned char	*dbsync_snapshot_reserve(size_t size)
+{
+	if (writer.buf_alloc - writer.buf_offset < size)
+	{
+		while (writer.buf_alloc - writer.buf_offset < size)
+			writer.buf_alloc = (0 == writer.buf_alloc ? 64 * ZBX_KIBIBYTE : writer.buf_alloc * 2);
+
+		writer.buf = (unsigned char *)zbx_realloc(writer.buf, writer.buf_alloc);
+	}
+
+	return writer.buf + writer.buf_offset;
+}
+
+static void	dbsync_snapshot_advance(size_t size)
+{
+	writer.buf_offset += size;
+
+	if (DBSYNC_SNAPSHOT_BUFFER_SIZE <= writer.buf_offset)
+		(void)dbsync_snapshot_flush();
+}
+
+static unsigned char	*dbsync_snapshot_reserve_record(zbx_uint32_t len)
+{
+	return dbsync_snapshot_reserve(DBSYNC_SNAPSHOT_RECORD_HEADER_SIZE + len) + DBSYNC_SNAPSHOT_RECORD_HEADER_SIZE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: complete record with serialized payload in write buffer           *
+ *                                                                            *
+ * Parameters: len - [IN] the payload length                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_snapshot_add_record(zbx_uint32_t len)
+{
+	unsigned char	*ptr = writer.buf + writer.buf_offset;
+	zbx_uint32_t	checksum;
+
+	checksum = dbsync_snapshot_checksum(ptr + DBSYNC_SNAPSHOT_RECORD_HEADER_SIZE, len);
+
+	ptr += zbx_serialize_value(ptr, len);
+	(void)zbx_serialize_value(ptr, checksum);
+
+	dbsync_snapshot_advance(DBSYNC_SNAPSHOT_RECORD_HEADER_SIZE + len);
+}
+
+static void	dbsync_snapshot_write_header(void)
+{
+	zbx_uint32_t	len = 1 + DBSYNC_SNAPSHOT_SIGNATURE_LEN + sizeof(zbx_uint32_t) + 1, build_len,
+			version = DBSYNC_SNAPSHOT_VERSION;
+	const char	*build = DBSYNC_SNAPSHOT_BUILD;
+	unsigned char	*ptr;
+
+	zbx_serialize_prepare_str_len(len, build, build_len);
+
+	ptr = dbsync_snapshot_reserve_record(len);
+	ptr += zbx_serialize_char(ptr, DBSYNC_SNAPSHOT_RECORD_HEADER);
+	memcpy(ptr, DBSYNC_SNAPSHOT_SIGNATURE, DBSYNC_SNAPSHOT_SIGNATURE_LEN);
+	ptr += DBSYNC_SNAPSHOT_SIGNATURE_LEN;
+	ptr += zbx_serialize_value(ptr, version);
+	ptr += zbx_serialize_char(ptr, writer.program_type);
+	(void)zbx_serialize_str(ptr, build, build_len);
+
+	dbsync_snapshot_add_record(len);
+}
+
+static void	dbsync_snapshot_write_changelog_records(void)
+{
+	for (int i = 0; i < writer.changelog.values_num && 0 != writer.active; i += DBSYNC_SNAPSHOT_CHANGELOG_BATCH)
+	{
+		zbx_uint32_t	num, len;
+		unsigned char	*ptr;
+
+		num = (zbx_uint32_t)MIN(DBSYNC_SNAPSHOT_CHANGELOG_BATCH, writer.changelog.values_num - i);
+		len = DBSYNC_SNAPSHOT_CHANGELOG_SIZE + num * DBSYNC_SNAPSHOT_CHANGELOG_ENTRY_SIZE;
+
+		ptr = dbsync_snapshot_reserve_record(len);
+		ptr += zbx_serialize_char(ptr, DBSYNC_SNAPSHOT_RECORD_CHANGELOG);
+		ptr += zbx_serialize_value(ptr, num);
+
+		for (int j = i; j < i + (int)num; j++)
+		{
+			int	clock = (int)writer.changelog.values[j].second;
+
+			ptr += zbx_serialize_uint64(ptr, writer.changelog.values[j].first);
+			ptr += zbx_serialize_int(ptr, clock);
+		}
+
+		dbsync_snapshot_add_record(len);
+	}
+
+	zbx_vector_uint64_pair_clear(&writer.changelog);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: validate record at the specified offset                           *
+ *                                                                            *
+ * Parameters: data   - [IN] the mapped file                                  *
+ *             offset - [IN] the record offset                                *
+ *             size   - [IN] the mapped file size                             *
+ *             len    - [OUT] the payload length                              *
+ *                                                                            *
+ * Return value: SUCCEED - the record is complete and has valid checksum      *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_snapshot_check_record(const unsigned char *data, zbx_uint64_t offset, zbx_uint64_t size,
+		zbx_uint32_t *len)
+{
+	zbx_uint32_t	checksum;
+
+	if (offset + DBSYNC_SNAPSHOT_RECORD_HEADER_SIZE > size)
+		return FAIL;
+
+	memcpy(len, data + offset, sizeof(zbx_uint32_t));
+	memcpy(&checksum, data + offset + sizeof(zbx_uint32_t), sizeof(zbx_uint32_t));
+
+	if (0 == *len || offset + DBSYNC_SNAPSHOT_RECORD_HEADER_SIZE + *len > size)
+		return FAIL;
+
+	if (checksum != dbsync_snapshot_checksum(data + offset + DBSYNC_SNAPSHOT_RECORD_HEADER_SIZE, *len))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+static int	dbsync_snapshot_check_header(const unsigned char *data, zbx_uint32_t len, char **error)
+{
+	const unsigned char	*ptr = data, *end = data + len;
+	const char		*build = DBSYNC_SNAPSHOT_BUILD;
+	zbx_uint32_t		version, build_len;
+
+	if (1 + DBSYNC_SNAPSHOT_SIGNATURE_LEN + 2 * sizeof(zbx_uint32_t) + 1 > len ||
+			DBSYNC_SNAPSHOT_RECORD_HEADER != *ptr ||
+			0 != memcmp(ptr + 1, DBSYNC_SNAPSHOT_SIGNATURE, DBSYNC_SNAPSHOT_SIGNATURE_LEN))
+	{
+		*error = zbx_strdup(NULL, "invalid file signature");
+		return FAIL;
+	}
+
+	ptr += 1 + DBSYNC_SNAPSHOT_SIGNATURE_LEN;
+	ptr += zbx_deserialize_value(ptr, &version);
+
+	if (DBSYNC_SNAPSHOT_VERSION != version)
+	{
+		*error = zbx_dsprintf(NULL, "unsupported file version %u", version);
+		return FAIL;
+	}
+
+	if (*ptr++ != writer.program_type)
+	{
+		*error = zbx_strdup(NULL, "file was written by different program type");
+		return FAIL;
+	}
+
+	ptr += zbx_deserialize_value(ptr, &build_len);
+
+	if (build_len != strlen(build) + 1 || (size_t)(end - ptr) < build_len || 0 != memcmp(ptr, build, build_len))
+	{
+		*error = zbx_strdup(NULL, "file was written by different Zabbix version");
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: leave only the last committed record of every row                 *
+ *                                                                            *
+ * Parameters: snapshot - [IN/OUT]                                            *
+ *             rows     - [IN/OUT] (rowid, position) pairs, where position    *
+ *                                 is record offset << 1 | 1 for rows and     *
+ *                                 block offset << 1 for deletes              *
+ *                                                                            *
+ * Comments: Deletes are positioned at the start of block, so the rows        *
+ *           written in the same block have precedence over them.             *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_snapshot_index_rows(zbx_dbsync_snapshot_t *snapshot, zbx_vector_uint64_pair_t *rows)
+{
+	int	k = 0;
+
+	zbx_vector_uint64_pair_sort(rows, ZBX_DEFAULT_UINT64_PAIR_COMPARE_FUNC);
+
+	for (int i = 0; i < rows->values_num; i++)
+	{
+		zbx_uint32_t	len;
+
+		if (i + 1 < rows->values_num && rows->values[i + 1].first == rows->values[i].first)
+			continue;
+
+		if (0 == (rows->values[i].second & 1))
+			continue;
+
+		rows->values[k].first = rows->values[i].first;
+		rows->values[k].second = rows->values[i].second >> 1;
+
+		memcpy(&len, snapshot->map + rows->values[k].second, sizeof(len));
+		snapshot->rows_size += DBSYNC_SNAPSHOT_RECORD_HEADER_SIZE + len;
+		k++;
+	}
+
+	rows->values_num = k;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: map snapshot file and index its committed rows                    *
+ *                                                                            *
+ * Parameters: path     - [IN] the snapshot file                              *
+ *             max_size - [IN] the size of file part to read, 0 to read the   *
+ *                             whole file                                     *
+ *             snapshot - [OUT]                                               *
+ *             error    - [OUT]                                               *
+ *                                                                            *
+ * Return value: SUCCEED - the snapshot was read successfully                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_snapshot_read(const char *path, zbx_uint64_t max_size, zbx_dbsync_snapshot_t **snapshot,
+		char **error)
+{
+	int			fd, ret = FAIL, changelog_num = 0, *rows_num;
+	zbx_stat_t		st;
+	void			*map;
+	zbx_dbsync_snapshot_t	*snap;
+	zbx_uint64_t		offset, block_offset, size;
+	zbx_uint32_t		len;
+
+	if (-1 == (fd = open(path, O_RDONLY)))
+	{
+		*error = zbx_dsprintf(NULL, "cannot open file: %s", zbx_strerror(errno));
+		return FAIL;
+	}
+
+	if (0 != zbx_fstat(fd, &st))
+	{
+		*error = zbx_dsprintf(NULL, "cannot obtain file information: %s", zbx_strerror(errno));
+		close(fd);
+		return FAIL;
+	}
+
+	if (0 == st.st_size)
+	{
+		*error = zbx_strdup(NULL, "empty file");
+		close(fd);
+		return FAIL;
+	}
+
+	map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (MAP_FAILED == map)
+	{
+		*error = zbx_dsprintf(NULL, "cannot map file: %s", zbx_strerror(errno));
+		return FAIL;
+	}
+
+	snap = (zbx_dbsync_snapshot_t *)zbx_malloc(NULL, sizeof(zbx_dbsync_snapshot_t));
+	snap->map = (unsigned char *)map;
+	snap->map_size = (size_t)st.st_size;
+	snap->objects_num = writer.objects_num;
+	snap->rows = (zbx_vector_uint64_pair_t *)zbx_malloc(NULL,
+			sizeof(zbx_vector_uint64_pair_t) * (size_t)snap->objects_num);
+
+	for (int i = 0; i < snap->objects_num; i++)
+		zbx_vector_uint64_pair_create(&snap->rows[i]);
+
+	zbx_vector_uint64_pair_create(&snap->changelog);
+	snap->clock = 0;
+	snap->end = 0;
+	snap->rows_size = 0;
+
+	/* the number of rows of every object after the last committed block */
+	rows_num = (int *)zbx_calloc(NULL, (size_t)snap->objects_num, sizeof(int));
+
+	size = snap->map_size;
+
+	if (0 != max_size && max_size < size)
+		size = max_size;
+
+	if (SUCCEED != dbsync_snapshot_check_record(snap->map, 0, size, &len))
+	{
+		*error = zbx_strdup(NULL, "invalid file header");
+		goto out;
+	}
+
+	if (SUCCEED != dbsync_snapshot_check_header(snap->map + DBSYNC_SNAPSHOT_RECORD_HEADER_SIZE, len, error))
+		goto out;
+
+	offset = block_offset = DBSYNC_SNAPSHOT_RECORD_HEADER_SIZE + len;
+
+	while (SUCCEED == dbsync_snapshot_check_record(snap->map, offset, size, &len))
+	{
+		unsigned char		*ptr = snap->map + offset + DBSYNC_SNAPSHOT_RECORD_HEADER_SIZE;
+		unsigned char		object;
+		zbx_uint64_pair_t	pair;
+		zbx_uint32_t		num;
+
+		switch (*ptr)
+		{
+			case DBSYNC_SNAPSHOT_RECORD_ROW:
+			case DBSYNC_SNAPSHOT_RECORD_DELETE:
+				if (DBSYNC_SNAPSHOT_DELETE_SIZE > len)
+					goto stop;
+
+				if (0 == (object = ptr[1]) || snap->objects_num < object)
+					goto stop;
+
+				(void)zbx_deserialize_uint64(ptr + 2, &pair.first);
+
+				if (DBSYNC_SNAPSHOT_RECORD_ROW == *ptr)
+				{
+					if (DBSYNC_SNAPSHOT_ROW_SIZE > len)
+						goto stop;
+
+					pair.second = offset << 1 | 1;
+				}
+				else
+					pair.second = block_offset << 1;
+
+				zbx_vector_uint64_pair_append(&snap->rows[object - 1], pair);
+				break;
+			case DBSYNC_SNAPSHOT_RECORD_CHANGELOG:
+				if (DBSYNC_SNAPSHOT_CHANGELOG_SIZE > len)
+					goto stop;
+
+				ptr++;
+				ptr += zbx_deserialize_value(ptr, &num);
+
+				if (DBSYNC_SNAPSHOT_CHANGELOG_SIZE + num * DBSYNC_SNAPSHOT_CHANGELOG_ENTRY_SIZE != len)
+					goto stop;
+
+				for (zbx_uint32_t i = 0; i < num; i++)
+				{
+					int	clock;
+
+					ptr += zbx_deserialize_uint64(ptr, &pair.first);
+					ptr += zbx_deserialize_int(ptr, &clock);
+					pair.second = (zbx_uint64_t)clock;
+					zbx_vector_uint64_pair_append(&snap->changelog, pair);
+				}
+				break;
+			case DBSYNC_SNAPSHOT_RECORD_COMMIT:
+				if (DBSYNC_SNAPSHOT_COMMIT_SIZE != len)
+					goto stop;
+
+				(void)zbx_deserialize_int(ptr + 1, &snap->clock);
+
+				offset += DBSYNC_SNAPSHOT_RECORD_HEADER_SIZE + len;
+				snap->end = block_offset = offset;
+
+				for (int i = 0; i < snap->objects_num; i++)
+					rows_num[i] = snap->rows[i].values_num;
+
+				changelog_num = snap->changelog.values_num;
+				continue;
+			default:
+				goto stop;
+		}
+
+		offset += DBSYNC_SNAPSHOT_RECORD_HEADER_SIZE + len;
+	}
+stop:
+	/* discard the last block without commit record */
+	for (int i = 0; i < snap->objects_num; i++)
+		snap->rows[i].values_num = rows_num[i];
+
+	snap->changelog.values_num = changelog_num;
+
+	if (0 == snap->end)
+	{
+		*error = zbx_strdup(NULL, "no committed data");
+		goto out;
+	}
+
+	for (int i = 0; i < snap->objects_num; i++)
+		dbsync_snapshot_index_rows(snap, &snap->rows[i]);
+
+	ret = SUCCEED;
+out:
+	zbx_free(rows_num);
+
+	if (SUCCEED == ret)
+		*snapshot = snap;
+	else
+		dbsync_snapshot_free(snap);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: write changelog and commit records terminating the current block  *
+ *                                                                            *
+ * Parameters: now - [IN] the commit time                                     *
+ *                                                                            *
+ * Return value: SUCCEED - the block was written to file                      *
+ *               FAIL    - the snapshot writing has failed                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_snapshot_write_commit(int now)
+{
+	zbx_uint32_t	len = DBSYNC_SNAPSHOT_COMMIT_SIZE;
+	unsigned char	*ptr;
+
+	dbsync_snapshot_write_changelog_records();
+
+	if (0 == writer.active)
+		return FAIL;
+
+	ptr = dbsync_snapshot_reserve_record(len);
+	ptr += zbx_serialize_char(ptr, DBSYNC_SNAPSHOT_RECORD_COMMIT);
+	(void)zbx_serialize_int(ptr, now);
+	dbsync_snapshot_add_record(len);
+
+	if (0 == writer.active || SUCCEED != dbsync_snapshot_flush())
+		return FAIL;
+
+	writer.active = 0;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: write the last version of live rows and recent changelog records  *
+ *          into compacted snapshot file                                      *
+ *                                                                            *
+ * Parameters: now - [IN] the time of the last committed block                *
+ *                                                                            *
+ * Return value: SUCCEED - the compacted file was written                     *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: This function is executed by the compaction process, which       *
+ *           writes compacted file using its own copy of the writer.          *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_snapshot_compact(int now)
+{
+	zbx_dbsync_snapshot_t	*snapshot;
+	char			*error = NULL;
+
+	if (SUCCEED != dbsync_snapshot_read(writer.path, writer.compact_offset, &snapshot, &error))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot compact configuration snapshot file \"%s\": %s", writer.path,
+				error);
+		zbx_free(error);
+
+		return FAIL;
+	}
+
+	/* write failures must remove the compacted file instead of snapshot */
+	writer.path = dbsync_snapshot_compact_path();
+
+	dbsync_snapshot_close();
+
+	if (-1 == (writer.fd = open(writer.path, O_WRONLY | O_CREAT | O_TRUNC, 0600)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot create configuration snapshot file \"%s\": %s", writer.path,
+				zbx_strerror(errno));
+		dbsync_snapshot_free(snapshot);
+
+		return FAIL;
+	}
+
+	writer.init = 0;
+	writer.offset = 0;
+	writer.buf_offset = 0;
+	writer.active = 1;
+	dbsync_snapshot_write_header();
+
+	for (int i = 0; i < snapshot->objects_num && 0 != writer.active; i++)
+	{
+		for (int j = 0; j < snapshot->rows[i].values_num && 0 != writer.active; j++)
+		{
+			const unsigned char	*record = snapshot->map + snapshot->rows[i].values[j].second;
+			zbx_uint32_t		len;
+			size_t			size;
+
+			memcpy(&len, record, sizeof(len));
+			size = DBSYNC_SNAPSHOT_RECORD_HEADER_SIZE + len;
+			memcpy(dbsync_snapshot_reserve(size), record, size);
+			dbsync_snapshot_advance(size);
+		}
+	}
+
+	for (int i = 0; i < snapshot->changelog.values_num; i++)
+	{
+		if (now - (int)snapshot->changelog.values[i].second <= writer.changelog_max_age)
+			zbx_vector_uint64_pair_append(&writer.changelog, snapshot->changelog.values[i]);
+	}
+
+	dbsync_snapshot_free(snapshot);
+
+	if (SUCCEED != dbsync_snapshot_write_commit(now))
+		return FAIL;
+
+	if (0 != fsync(writer.fd))
+	{
+		dbsync_snapshot_fail("flush", zbx_strerror(errno));
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: start snapshot compaction in forked process                       *
+ *                                                                            *
+ * Parameters: now - [IN] the time of the last committed block                *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_snapshot_compact_start(int now)
+{
+	pid_t	pid;
+
+	writer.compact_offset = writer.offset;
+
+	if (-1 == (pid = zbx_fork()))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot start configuration snapshot file \"%s\" compaction: %s",
+				writer.path, zbx_strerror(errno));
+		return;
+	}
+
+	if (0 == pid)
+		_exit(SUCCEED == dbsync_snapshot_compact(now) ? EXIT_SUCCESS : EXIT_FAILURE);
+
+	writer.compact_pid = pid;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: replace snapshot with compacted file when compaction is finished  *
+ *                                                                            *
+ * Parameters: options - [IN] waitpid() options, WNOHANG to return without    *
+ *                            waiting for running compaction                  *
+ *                                                                            *
+ * Comments: The blocks committed after compaction was started are appended   *
+ *           to the compacted file. The original snapshot is kept if          *
+ *           compaction fails.                                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_snapshot_compact_finish(int options)
+{
+	char		*path_compact;
+	int		status, fd = -1;
+	pid_t		pid;
+	zbx_stat_t	st;
+	zbx_uint64_t	size;
+
+	if (0 == writer.compact_pid || 0 == (pid = waitpid(writer.compact_pid, &status, options)))
+		return;
+
+	writer.compact_pid = 0;
+	path_compact = dbsync_snapshot_compact_path();
+
+	if (-1 == pid || !WIFEXITED(status) || EXIT_SUCCESS != WEXITSTATUS(status))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "configuration snapshot file \"%s\" compaction failed", writer.path);
+		goto out;
+	}
+
+	if (-1 == (fd = open(path_compact, O_RDWR)) || 0 != zbx_fstat(fd, &st))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot open configuration snapshot file \"%s\": %s", path_compact,
+				zbx_strerror(errno));
+		goto out;
+	}
+
+	size = (zbx_uint64_t)st.st_size;
+
+	if (SUCCEED != dbsync_snapshot_copy(writer.fd, writer.compact_offset, writer.offset, fd, size) ||
+			0 != fsync(fd))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot write configuration snapshot file \"%s\": %s", path_compact,
+				zbx_strerror(errno));
+		goto out;
+	}
+
+	if (0 != rename(path_compact, writer.path))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot rename configuration snapshot file \"%s\": %s", path_compact,
+				zbx_strerror(errno));
+		goto out;
+	}
+
+	dbsync_snapshot_sync_dir();
+
+	zabbix_log(LOG_LEVEL_DEBUG, "compacted configuration snapshot file \"%s\" from " ZBX_FS_UI64 " to "
+			ZBX_FS_UI64 " bytes", writer.path, writer.compact_offset, size);
+
+	dbsync_snapshot_close();
+	writer.fd = fd;
+	writer.offset = size + writer.offset - writer.compact_offset;
+	writer.base_size = size;
+	zbx_free(path_compact);
+
+	return;
+out:
+	if (-1 != fd)
+		close(fd);
+
+	(void)unlink(path_compact);
+	zbx_free(path_compact);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initialize configuration snapshot writer                          *
+ *                                                                            *
+ * Parameters: path              - [IN] the snapshot file, NULL to disable    *
+ *                                      snapshots                             *
+ *             program_type      - [IN]                                       *
+ *             objects_num       - [IN] the number of snapshot objects, which *
+ *                                      are identified by 1..objects_num      *
+ *             changelog_max_age - [IN] the changelog record retention time   *
+ *                                                                            *
+ ******************************************************************************/
+void	dbsync_snapshot_init(const char *path, unsigned char program_type, int objects_num, int changelog_max_age)
+{
+	writer.path = (NULL != path ? zbx_strdup(NULL, path) : NULL);
+	writer.program_type = program_type;
+	writer.objects_num = objects_num;
+	writer.changelog_max_age = changelog_max_age;
+	writer.fd = -1;
+
+	zbx_vector_uint64_pair_create(&writer.changelog);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: load configuration snapshot                                       *
+ *                                                                            *
+ * Parameters: now      - [IN] the current database time                      *
+ *             max_age  - [IN] the maximum snapshot age in seconds            *
+ *             snapshot - [OUT]                                               *
+ *                                                                            *
+ * Return value: SUCCEED - the snapshot was loaded                            *
+ *               FAIL    - there is no valid snapshot                         *
+ *                                                                            *
+ * Comments: After successful load the following syncs are appended to the    *
+ *           loaded snapshot file.                                            *
+ *                                                                            *
+ ******************************************************************************/
+int	dbsync_snapshot_load(int now, int max_age, zbx_dbsync_snapshot_t **snapshot)
+{
+	zbx_dbsync_snapshot_t	*snap;
+	zbx_stat_t		st;
+	char			*error = NULL, *path_compact;
+	int			age;
+
+	if (NULL == writer.path)
+		return FAIL;
+
+	/* remove compacted file left by interrupted compaction */
+	path_compact = dbsync_snapshot_compact_path();
+	(void)unlink(path_compact);
+	zbx_free(path_compact);
+
+	if (0 != zbx_stat(writer.path, &st))
+	{
+		if (ENOENT != errno)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot load configuration snapshot file \"%s\": %s", writer.path,
+					zbx_strerror(errno));
+		}
+
+		return FAIL;
+	}
+
+	if (SUCCEED != dbsync_snapshot_read(writer.path, 0, &snap, &error))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot load configuration snapshot file \"%s\": %s", writer.path, error);
+		zbx_free(error);
+
+		return FAIL;
+	}
+
+	if (max_age < (age = now - snap->clock))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "configuration snapshot file \"%s\" is too old (%d seconds),"
+				" performing full configuration sync", writer.path, age);
+		dbsync_snapshot_free(snap);
+
+		return FAIL;
+	}
+
+	dbsync_snapshot_close();
+
+	if (-1 == (writer.fd = open(writer.path, O_RDWR)) || 0 != ftruncate(writer.fd, (off_t)snap->end))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot open configuration snapshot file \"%s\" for writing: %s",
+				writer.path, zbx_strerror(errno));
+		dbsync_snapshot_close();
+		dbsync_snapshot_free(snap);
+
+		return FAIL;
+	}
+
+	writer.offset = snap->end;
+	writer.base_size = snap->rows_size;
+	writer.commit_clock = snap->clock;
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "loaded configuration snapshot file \"%s\" written %d seconds ago",
+			writer.path, age);
+
+	*snapshot = snap;
+
+	return SUCCEED;
+}
+
+void	dbsync_snapshot_free(zbx_dbsync_snapshot_t *snapshot)
+{
+	for (int i = 0; i < snapshot->objects_num; i++)
+		zbx_vector_uint64_pair_destroy(&snapshot->rows[i]);
+
+	zbx_free(snapshot->rows);
+	zbx_vector_uint64_pair_destroy(&snapshot->changelog);
+
+	if (NULL != snapshot->map)
+		(void)munmap(snapshot->map, snapshot->map_size);
+
+	zbx_free(snapshot);
+}
+
+int	dbsync_snapshot_get_rows_num(const zbx_dbsync_snapshot_t *snapshot, unsigned char object)
+{
+	return snapshot->rows[object - 1].values_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get snapshot row                                                  *
+ *                                                                            *
+ * Parameters: snapshot    - [IN]                                             *
+ *             object      - [IN]                                             *
+ *             index       - [IN] the row index, rows are sorted by rowid     *
+ *             rowid       - [OUT]                                            *
+ *             row         - [OUT] the row columns pointing to the mapped     *
+ *                                 snapshot file                              *
+ *             columns_num - [IN] the expected number of columns              *
+ *                                                                            *
+ * Return value: SUCCEED - the row was decoded                                *
+ *               FAIL    - the row format does not match                      *
+ *                                                                            *
+ ******************************************************************************/
+int	dbsync_snapshot_get_row(const zbx_dbsync_snapshot_t *snapshot, unsigned char object, int index,
+		zbx_uint64_t *rowid, char **row, int columns_num)
+{
+	unsigned char	*ptr, *end;
+	zbx_uint32_t	len, columns;
+
+	ptr = snapshot->map + snapshot->rows[object - 1].values[index].second;
+	memcpy(&len, ptr, sizeof(len));
+	ptr += DBSYNC_SNAPSHOT_RECORD_HEADER_SIZE;
+	end = ptr + len;
+
+	ptr += 2;
+	ptr += zbx_deserialize_uint64(ptr, rowid);
+	ptr += zbx_deserialize_value(ptr, &columns);
+
+	if ((zbx_uint32_t)columns_num != columns)
+		return FAIL;
+
+	for (int i = 0; i < columns_num; i++)
+	{
+		zbx_uint32_t	value_len;
+
+		if ((size_t)(end - ptr) < sizeof(zbx_uint32_t))
+			return FAIL;
+
+		ptr += zbx_deserialize_value(ptr, &value_len);
+
+		if (0 == value_len)
+		{
+			row[i] = NULL;
+			continue;
+		}
+
+		if ((size_t)(end - ptr) < value_len || '\0' != ptr[value_len - 1])
+			return FAIL;
+
+		row[i] = (char *)ptr;
+		ptr += value_len;
+	}
+
+	return SUCCEED;
+}
+
+const zbx_vector_uint64_pair_t	*dbsync_snapshot_get_changelog(const zbx_dbsync_snapshot_t *snapshot)
+{
+	return &snapshot->changelog;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: start writing configuration sync into snapshot                    *
+ *                                                                            *
+ * Parameters: mode - [IN] the configuration sync mode                        *
+ *                                                                            *
+ * Return value: SUCCEED - the sync is written into snapshot                  *
+ *               FAIL    - snapshot is disabled or cannot be written          *
+ *                                                                            *
+ * Comments: Full sync starts a new snapshot, while incremental syncs are     *
+ *           appended to the existing snapshot if there is one.               *
+ *                                                                            *
+ ******************************************************************************/
+int	dbsync_snapshot_begin(unsigned char mode)
+{
+	if (NULL == writer.path)
+		return FAIL;
+
+	if (ZBX_DBSYNC_INIT == mode)
+	{
+		char	*path_tmp = dbsync_snapshot_tmp_path();
+
+		dbsync_snapshot_close();
+		dbsync_snapshot_compact_abort();
+
+		if (-1 == (writer.fd = open(path_tmp, O_RDWR | O_CREAT | O_TRUNC, 0600)))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot create configuration snapshot file \"%s\": %s", path_tmp,
+					zbx_strerror(errno));
+			zbx_free(path_tmp);
+
+			return FAIL;
+		}
+
+		zbx_free(path_tmp);
+
+		writer.init = 1;
+		writer.offset = 0;
+		writer.active = 1;
+		dbsync_snapshot_write_header();
+	}
+	else if (-1 == writer.fd)
+		return FAIL;
+
+	writer.block_offset = writer.offset;
+	writer.records_num = 0;
+	writer.active = 1;
+
+	return SUCCEED;
+}
+
+void	dbsync_snapshot_write_row(unsigned char object, zbx_uint64_t rowid, char **row, int columns_num)
+{
+	zbx_uint32_t	len = DBSYNC_SNAPSHOT_ROW_SIZE, columns = (zbx_uint32_t)columns_num;
+	unsigned char	*ptr;
+
+	if (0 == writer.active)
+		return;
+
+	for (int i = 0; i < columns_num; i++)
+		len += sizeof(zbx_uint32_t) + (NULL != row[i] ? (zbx_uint32_t)strlen(row[i]) + 1 : 0);
+
+	ptr = dbsync_snapshot_reserve_record(len);
+	ptr += zbx_serialize_char(ptr, DBSYNC_SNAPSHOT_RECORD_ROW);
+	ptr += zbx_serialize_char(ptr, object);
+	ptr += zbx_serialize_uint64(ptr, rowid);
+	ptr += zbx_serialize_value(ptr, columns);
+
+	for (int i = 0; i < columns_num; i++)
+	{
+		zbx_uint32_t	value_len = (NULL != row[i] ? (zbx_uint32_t)strlen(row[i]) + 1 : 0);
+
+		ptr += zbx_serialize_str(ptr, row[i], value_len);
+	}
+
+	writer.records_num++;
+	dbsync_snapshot_add_record(len);
+}
+
+void	dbsync_snapshot_write_delete(unsigned char object, zbx_uint64_t rowid)
+{
+	zbx_uint32_t	len = DBSYNC_SNAPSHOT_DELETE_SIZE;
+	unsigned char	*ptr;
+
+	if (0 == writer.active)
+		return;
+
+	ptr = dbsync_snapshot_reserve_record(len);
+	ptr += zbx_serialize_char(ptr, DBSYNC_SNAPSHOT_RECORD_DELETE);
+	ptr += zbx_serialize_char(ptr, object);
+	(void)zbx_serialize_uint64(ptr, rowid);
+
+	writer.records_num++;
+	dbsync_snapshot_add_record(len);
+}
+
+void	dbsync_snapshot_write_changelog(zbx_uint64_t changelogid, int clock)
+{
+	zbx_uint64_pair_t	pair = {changelogid, (zbx_uint64_t)clock};
+
+	if (0 == writer.active)
+		return;
+
+	zbx_vector_uint64_pair_append(&writer.changelog, pair);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: commit the current configuration sync block                       *
+ *                                                                            *
+ * Parameters: now - [IN] the database time when the changelog was read       *
+ *                                                                            *
+ ******************************************************************************/
+void	dbsync_snapshot_commit(int now)
+{
+	if (0 == writer.active)
+		return;
+
+	if (0 == writer.init && 0 == writer.records_num && 0 == writer.changelog.values_num &&
+			DBSYNC_SNAPSHOT_HEARTBEAT > now - writer.commit_clock)
+	{
+		writer.active = 0;
+	}
+	else
+	{
+		if (SUCCEED != dbsync_snapshot_write_commit(now))
+			return;
+
+		writer.commit_clock = now;
+
+		if (0 != writer.init)
+		{
+			char	*path_tmp = dbsync_snapshot_tmp_path();
+
+			if (0 != fsync(writer.fd))
+				dbsync_snapshot_fail("flush", zbx_strerror(errno));
+			else if (0 != rename(path_tmp, writer.path))
+				dbsync_snapshot_fail("rename", zbx_strerror(errno));
+			else
+				dbsync_snapshot_sync_dir();
+
+			zbx_free(path_tmp);
+
+			writer.init = 0;
+			writer.base_size = writer.offset;
+
+			return;
+		}
+	}
+
+	if (0 != writer.compact_pid)
+		dbsync_snapshot_compact_finish(WNOHANG);
+	else if (DBSYNC_SNAPSHOT_COMPACT_SIZE < writer.offset - writer.base_size &&
+			writer.offset > writer.base_size * 2)
+	{
+		dbsync_snapshot_compact_start(now);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: discard the current configuration sync block                      *
+ *                                                                            *
+ ******************************************************************************/
+void	dbsync_snapshot_rollback(void)
+{
+	if (0 == writer.active)
+		return;
+
+	writer.active = 0;
+	writer.buf_offset = 0;
+	zbx_vector_uint64_pair_clear(&writer.changelog);
+
+	if (0 != writer.init)
+	{
+		char	*path_tmp = dbsync_snapshot_tmp_path();
+
+		dbsync_snapshot_close();
+		(void)unlink(path_tmp);
+		zbx_free(path_tmp);
+		writer.init = 0;
+
+		return;
+	}
+
+	if (writer.offset != writer.block_offset)
+	{
+		if (0 != ftruncate(writer.fd, (off_t)writer.block_offset))
+		{
+			dbsync_snapshot_fail("truncate", zbx_strerror(errno));
+			return;
+		}
+
+		writer.offset = writer.block_offset;
+	}
+}
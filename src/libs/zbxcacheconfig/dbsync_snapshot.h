@@ -0,0 +1,39 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#ifndef ZABBIX_DBSYNC_SNAPSHOT_H
+#define ZABBIX_DBSYNC_SNAPSHOT_H
+
+#include "zbxalgo.h"
+#include "zbxtypes.h"
+
+typedef struct zbx_dbsync_snapshot zbx_dbsync_snapshot_t;
+
+void	dbsync_snapshot_init(const char *path, unsigned char program_type, int objects_num, int changelog_max_age);
+
+int	dbsync_snapshot_load(int now, int max_age, zbx_dbsync_snapshot_t **snapshot);
+void	dbsync_snapshot_free(zbx_dbsync_snapshot_t *snapshot);
+int	dbsync_snapshot_get_rows_num(const zbx_dbsync_snapshot_t *snapshot, unsigned char object);
+int	dbsync_snapshot_get_row(const zbx_dbsync_snapshot_t *snapshot, unsigned char object, int index,
+		zbx_uint64_t *rowid, char **row, int columns_num);
+const zbx_vector_uint64_pair_t	*dbsync_snapshot_get_changelog(const zbx_dbsync_snapshot_t *snapshot);
+
+int	dbsync_snapshot_begin(unsigned char mode);
+void	dbsync_snapshot_write_row(unsigned char object, zbx_uint64_t rowid, char **row, int columns_num);
+void	dbsync_snapshot_write_delete(unsigned char object, zbx_uint64_t rowid);
+void	dbsync_snapshot_write_changelog(zbx_uint64_t changelogid, int clock);
+void	dbsync_snapshot_commit(int now);
+void	dbsync_snapshot_rollback(void);
+
+#endif
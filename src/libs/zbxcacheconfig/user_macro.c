@@ -567,43 +567,6 @@ static void	um_macro_deregister_kvs(zbx_um_macro_t *macro)
 	}
 }
 
-/*********************************************************************************
- *                                                                               *
- * Purpose: check if the macro vault location has not changed                    *
- *                                                                               *
- *********************************************************************************/
-int	um_macro_check_vault_location(const zbx_um_macro_t *macro, const char *location)
-{
-	zbx_dc_config_t		*config = get_dc_config();
-	zbx_hashset_t		*macro_kv = (0 == macro->hostid ? &config->gmacro_kv : &config->hmacro_kv);
-	zbx_dc_macro_kv_t	*mkv;
-	char			*path, *key;
-	int			i, ret = FAIL;
-	zbx_dc_kvs_path_t	*kvs_path, kvs_path_local;
-	zbx_dc_kv_t		*kv, kv_local;
-
-	if (NULL == (mkv = zbx_hashset_search(macro_kv, &macro->macroid)))
-		return FAIL;
-
-	zbx_strsplit_first(location, ':', &path, &key);
-
-	kvs_path_local.path = path;
-	if (FAIL == (i = zbx_vector_ptr_search(&config->kvs_paths, &kvs_path_local, dc_compare_kvs_path)))
-		goto out;
-
-	kvs_path = (zbx_dc_kvs_path_t *)config->kvs_paths.values[i];
-	kv_local.key = key;
-
-	kv = (zbx_dc_kv_t *)zbx_hashset_search(&kvs_path->kvs, &kv_local);
-	if (kv == mkv->kv)
-		ret = SUCCEED;
-out:
-	zbx_free(path);
-	zbx_free(key);
-
-	return ret;
-}
-
 /*********************************************************************************
  *                                                                               *
  * Purpose: sync global/host user macros                                         *
@@ -814,7 +777,10 @@ static void	um_cache_sync_hosts(zbx_um_cache_t *cache, zbx_dbsync_t *sync)
 			host = um_cache_create_host(cache, hostid);
 
 		ZBX_DBROW2UINT64(templateid, row[1]);
-		zbx_vector_uint64_append(&host->templateids, templateid);
+
+		/* link might be already synced when the full table is read again */
+		if (FAIL == zbx_vector_uint64_search(&host->templateids, templateid, ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+			zbx_vector_uint64_append(&host->templateids, templateid);
 	}
 
 	/* handle removed host template links */
@@ -65,8 +65,6 @@ void	um_macro_release(zbx_um_macro_t *macro);
 zbx_um_cache_t	*um_cache_set_value_to_macros(zbx_um_cache_t *cache, zbx_uint64_t revision,
 		const zbx_vector_uint64_pair_t *host_macro_ids, const char *value);
 
-int	um_macro_check_vault_location(const zbx_um_macro_t *macro, const char *location);
-
 void	um_cache_resolve_const(const zbx_um_cache_t *cache, const zbx_uint64_t *hostids, int hostids_num,
 		const char *macro, int env, const char **value);
 void	um_cache_resolve(const zbx_um_cache_t *cache, const zbx_uint64_t *hostids, int hostids_num, const char *macro,
@@ -39,11 +39,16 @@
 #include "zbxipcservice.h"
 
 static zbx_shmem_info_t	*hc_index_mem = NULL;
-static zbx_shmem_info_t	*hc_mem = NULL;
+static zbx_shmem_info_t	*hc_shard_index_mem[ZBX_HC_SHARDS_MAX];
+static zbx_shmem_info_t	*hc_mem[ZBX_HC_SHARDS_MAX];
 static zbx_shmem_info_t	*trend_mem = NULL;
 
 #define	LOCK_CACHE	zbx_mutex_lock(cache_lock)
 #define	UNLOCK_CACHE	zbx_mutex_unlock(cache_lock)
+#define	LOCK_CACHE_INDEX	zbx_mutex_lock(cache_index_lock)
+#define	UNLOCK_CACHE_INDEX	zbx_mutex_unlock(cache_index_lock)
+#define	LOCK_SHARD(index)	zbx_mutex_lock(shard_locks[index])
+#define	UNLOCK_SHARD(index)	zbx_mutex_unlock(shard_locks[index])
 #define	LOCK_TRENDS	zbx_mutex_lock(trends_lock)
 #define	UNLOCK_TRENDS	zbx_mutex_unlock(trends_lock)
 #define	LOCK_CACHE_IDS		zbx_mutex_lock(cache_ids_lock)
@@ -52,6 +57,14 @@ static zbx_shmem_info_t	*trend_mem = NULL;
 static zbx_mutex_t	cache_lock = ZBX_MUTEX_NULL;
 static zbx_mutex_t	trends_lock = ZBX_MUTEX_NULL;
 static zbx_mutex_t	cache_ids_lock = ZBX_MUTEX_NULL;
+static zbx_mutex_t	cache_index_lock = ZBX_MUTEX_NULL;
+static zbx_mutex_t	shard_locks[ZBX_HC_SHARDS_MAX];
+
+/* the number of history cache shards, set during cache initialization */
+static int		hc_shards_num = 0;
+
+/* the shard history syncer pops items from first, see zbx_hc_set_sync_shard() */
+static int		hc_sync_shard = 0;
 
 static char		*sql = NULL;
 static size_t		sql_alloc = 4 * ZBX_KIBIBYTE;
@@ -63,6 +76,12 @@ static zbx_history_sync_f	sync_history_cb = NULL;
 
 #define ZBX_HC_ITEMS_INIT_SIZE	1000
 
+/* the minimum value memory size of history cache shard */
+#define ZBX_HC_SHARD_SIZE_MIN	(4 * ZBX_MEBIBYTE)
+
+/* the minimum index memory size of history cache shard and of the shared index part */
+#define ZBX_HC_INDEX_SHARD_SIZE_MIN	(64 * ZBX_KIBIBYTE)
+
 #define ZBX_TRENDS_CLEANUP_TIME	(SEC_PER_MIN * 55)
 
 /* the maximum number of characters for history cache values (except binary) */
@@ -91,13 +110,22 @@ typedef struct
 }
 zbx_hc_proxyqueue_t;
 
+/* History cache partition, items are assigned to shards by itemid. Shard data is protected by */
+/* the corresponding shard lock while item values are stored in the shard's own value memory.  */
 typedef struct
 {
-	zbx_hashset_t		trends;
-	zbx_dc_stats_t		stats;
-
 	zbx_hashset_t		history_items;
 	zbx_binary_heap_t	history_queue;
+	zbx_dc_stats_t		stats;
+	int			values_num;
+}
+zbx_hc_shard_t;
+
+typedef struct
+{
+	zbx_hashset_t		trends;
+
+	zbx_hc_shard_t		shards[ZBX_HC_SHARDS_MAX];
 
 	int			history_num;
 	int			trends_num;
@@ -109,11 +137,58 @@ typedef struct
 
 	zbx_hc_proxyqueue_t	proxyqueue;
 	int			processing_num;
+
+	/* total time spent by history syncers in each synchronization stage */
+	double			sync_stage_time[ZBX_HC_SYNC_STAGE_COUNT];
+
+	/* trigger function references, unique functions and evaluated functions of synced triggers */
+	zbx_uint64_t		trigger_funcs_stats[ZBX_HC_TRIGGER_FUNCS_COUNT];
 }
 ZBX_DC_CACHE;
 
 static ZBX_DC_CACHE	*cache = NULL;
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns index of history cache shard the item belongs to          *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_shard_index(zbx_uint64_t itemid)
+{
+	return (int)(itemid % (zbx_uint64_t)hc_shards_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: groups objects by history cache shard preserving their order      *
+ *          within shard                                                      *
+ *                                                                            *
+ * Parameters: shard_index - [IN] the shard index of each object              *
+ *             num         - [IN] the number of objects                       *
+ *             order       - [OUT] the object indexes grouped by shard        *
+ *             offsets     - [OUT] the start of each shard group in order     *
+ *                                 array, hc_shards_num + 1 entries           *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_group_by_shard(const int *shard_index, int num, int *order, int *offsets)
+{
+	int	i, pos[ZBX_HC_SHARDS_MAX];
+
+	memset(offsets, 0, sizeof(int) * (size_t)(hc_shards_num + 1));
+
+	for (i = 0; i < num; i++)
+		offsets[shard_index[i] + 1]++;
+
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		offsets[i + 1] += offsets[i];
+		pos[i] = offsets[i];
+	}
+
+	for (i = 0; i < num; i++)
+		order[pos[shard_index[i]]++] = i;
+}
+
 /* local history cache */
 #define ZBX_MAX_VALUES_LOCAL	256
 #define ZBX_STRUCT_REALLOC_STEP	8
@@ -156,9 +231,11 @@ static char		*string_values = NULL;
 static size_t		string_values_alloc = 0, string_values_offset = 0;
 static dc_item_value_t	*item_values = NULL;
 static size_t		item_values_alloc = 0, item_values_num = 0;
+static int		*item_values_shards = NULL, *item_values_order = NULL;
+static size_t		item_values_shards_alloc = 0;
 
-static void	hc_add_item_values(dc_item_value_t *values, int values_num);
-static void	hc_queue_item(zbx_hc_item_t *item);
+static int	hc_add_item_values(int index, dc_item_value_t *values, const int *order, int order_num);
+static void	hc_queue_item(zbx_hc_shard_t *shard, zbx_hc_item_t *item);
 static int	hc_queue_elem_compare_func(const void *d1, const void *d2);
 
 void	zbx_pp_value_opt_clear(zbx_pp_value_opt_t *opt)
@@ -167,6 +244,72 @@ void	zbx_pp_value_opt_clear(zbx_pp_value_opt_t *opt)
 		zbx_free(opt->source);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sums index memory usage of history cache shards and shared index  *
+ *                                                                            *
+ * Parameters: mem_total - [OUT] the total index memory size                  *
+ *             mem_free  - [OUT] the free index memory size                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_get_index_totals(zbx_uint64_t *mem_total, zbx_uint64_t *mem_free)
+{
+	int	i;
+
+	LOCK_CACHE_INDEX;
+	*mem_total = hc_index_mem->total_size;
+	*mem_free = hc_index_mem->free_size;
+	UNLOCK_CACHE_INDEX;
+
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		LOCK_SHARD(i);
+		*mem_total += hc_shard_index_mem[i]->total_size;
+		*mem_free += hc_shard_index_mem[i]->free_size;
+		UNLOCK_SHARD(i);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sums value counters and value memory usage of history cache       *
+ *          shards                                                            *
+ *                                                                            *
+ * Parameters: stats     - [OUT] the value counters                           *
+ *             mem_total - [OUT] the total value memory size                  *
+ *             mem_free  - [OUT] the free value memory size                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_get_shards_totals(zbx_dc_stats_t *stats, zbx_uint64_t *mem_total, zbx_uint64_t *mem_free)
+{
+	int	i;
+
+	memset(stats, 0, sizeof(zbx_dc_stats_t));
+	*mem_total = 0;
+	*mem_free = 0;
+
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		const zbx_dc_stats_t	*shard_stats = &cache->shards[i].stats;
+
+		LOCK_SHARD(i);
+
+		stats->history_counter += shard_stats->history_counter;
+		stats->history_float_counter += shard_stats->history_float_counter;
+		stats->history_uint_counter += shard_stats->history_uint_counter;
+		stats->history_str_counter += shard_stats->history_str_counter;
+		stats->history_log_counter += shard_stats->history_log_counter;
+		stats->history_text_counter += shard_stats->history_text_counter;
+		stats->history_bin_counter += shard_stats->history_bin_counter;
+		stats->notsupported_counter += shard_stats->notsupported_counter;
+
+		*mem_total += hc_mem[i]->total_size;
+		*mem_free += hc_mem[i]->free_size;
+
+		UNLOCK_SHARD(i);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: retrieves all internal metrics of the database cache              *
@@ -176,13 +319,10 @@ void	zbx_pp_value_opt_clear(zbx_pp_value_opt_t *opt)
  ******************************************************************************/
 void	zbx_dc_get_stats_all(zbx_wcache_info_t *wcache_info)
 {
-	LOCK_CACHE;
+	hc_get_shards_totals(&wcache_info->stats, &wcache_info->history_total, &wcache_info->history_free);
+	hc_get_index_totals(&wcache_info->index_total, &wcache_info->index_free);
 
-	wcache_info->stats = cache->stats;
-	wcache_info->history_free = hc_mem->free_size;
-	wcache_info->history_total = hc_mem->total_size;
-	wcache_info->index_free = hc_index_mem->free_size;
-	wcache_info->index_total = hc_index_mem->total_size;
+	LOCK_CACHE;
 
 	if (0 != (get_program_type_cb() & ZBX_PROGRAM_TYPE_SERVER))
 	{
@@ -203,57 +343,62 @@ void	*zbx_dc_get_stats(int request)
 	static zbx_uint64_t	value_uint;
 	static double		value_double;
 	void			*ret;
+	zbx_dc_stats_t		stats;
+	zbx_uint64_t		history_total, history_free, index_total, index_free;
+
+	hc_get_shards_totals(&stats, &history_total, &history_free);
+	hc_get_index_totals(&index_total, &index_free);
 
 	LOCK_CACHE;
 
 	switch (request)
 	{
 		case ZBX_STATS_HISTORY_COUNTER:
-			value_uint = cache->stats.history_counter;
+			value_uint = stats.history_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_FLOAT_COUNTER:
-			value_uint = cache->stats.history_float_counter;
+			value_uint = stats.history_float_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_UINT_COUNTER:
-			value_uint = cache->stats.history_uint_counter;
+			value_uint = stats.history_uint_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_STR_COUNTER:
-			value_uint = cache->stats.history_str_counter;
+			value_uint = stats.history_str_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_LOG_COUNTER:
-			value_uint = cache->stats.history_log_counter;
+			value_uint = stats.history_log_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_TEXT_COUNTER:
-			value_uint = cache->stats.history_text_counter;
+			value_uint = stats.history_text_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_NOTSUPPORTED_COUNTER:
-			value_uint = cache->stats.notsupported_counter;
+			value_uint = stats.notsupported_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_TOTAL:
-			value_uint = hc_mem->total_size;
+			value_uint = history_total;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_USED:
-			value_uint = hc_mem->total_size - hc_mem->free_size;
+			value_uint = history_total - history_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_FREE:
-			value_uint = hc_mem->free_size;
+			value_uint = history_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_PUSED:
-			value_double = 100 * (double)(hc_mem->total_size - hc_mem->free_size) / hc_mem->total_size;
+			value_double = 100 * (double)(history_total - history_free) / history_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_PFREE:
-			value_double = 100 * (double)hc_mem->free_size / hc_mem->total_size;
+			value_double = 100 * (double)history_free / history_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_TREND_TOTAL:
@@ -278,28 +423,27 @@ void	*zbx_dc_get_stats(int request)
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_TOTAL:
-			value_uint = hc_index_mem->total_size;
+			value_uint = index_total;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_USED:
-			value_uint = hc_index_mem->total_size - hc_index_mem->free_size;
+			value_uint = index_total - index_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_FREE:
-			value_uint = hc_index_mem->free_size;
+			value_uint = index_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_PUSED:
-			value_double = 100 * (double)(hc_index_mem->total_size - hc_index_mem->free_size) /
-					hc_index_mem->total_size;
+			value_double = 100 * (double)(index_total - index_free) / index_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_PFREE:
-			value_double = 100 * (double)hc_index_mem->free_size / hc_index_mem->total_size;
+			value_double = 100 * (double)index_free / index_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_BIN_COUNTER:
-			value_uint = cache->stats.history_bin_counter;
+			value_uint = stats.history_bin_counter;
 			ret = (void *)&value_uint;
 			break;
 		default:
@@ -389,6 +533,7 @@ static void	dc_insert_trends_in_db(ZBX_DC_TREND *trends, int trends_num, unsigne
 
 	zbx_db_insert_prepare(&db_insert, table_name, "itemid", "clock", "num", "value_min", "value_avg",
 			"value_max", (char *)NULL);
+	zbx_db_insert_enable_copy(&db_insert);
 
 	for (i = 0; i < trends_num; i++)
 	{
@@ -946,211 +1091,120 @@ int	zbx_trend_compare(const void *d1, const void *d2)
 	return 0;
 }
 
+/* item names, item tags and host groups used to enrich exported history and trends, */
+/* cached from configuration cache until configuration cache revision changes        */
 typedef struct
 {
-	zbx_uint64_t		hostid;
-	zbx_vector_ptr_t	groups;
+	zbx_uint64_t	revision;
+	zbx_hashset_t	items;
+	zbx_hashset_t	hosts;
 }
-zbx_host_info_t;
+zbx_export_cache_t;
 
-/******************************************************************************
- *                                                                            *
- * Purpose: frees resources allocated to store host groups names              *
- *                                                                            *
- * Parameters: host_info - [IN] host information                              *
- *                                                                            *
- ******************************************************************************/
-static void	zbx_host_info_clean(zbx_host_info_t *host_info)
+static zbx_export_cache_t	*export_cache = NULL;
+
+typedef struct
 {
-	zbx_vector_ptr_clear_ext(&host_info->groups, zbx_ptr_free);
-	zbx_vector_ptr_destroy(&host_info->groups);
+	zbx_uint64_t				itemid;
+	const zbx_history_sync_item_t		*item;
+	const zbx_history_export_item_t	*export_item;
+	const zbx_history_export_host_t	*export_host;
 }
+zbx_item_info_t;
 
-/******************************************************************************
- *                                                                            *
- * Purpose: get hosts groups names                                            *
- *                                                                            *
- * Parameters: hosts_info - [IN/OUT] output names of host groups for a host   *
- *             hostids    - [IN] hosts identifiers                            *
- *                                                                            *
- ******************************************************************************/
-static void	db_get_hosts_info_by_hostid(zbx_hashset_t *hosts_info, const zbx_vector_uint64_t *hostids)
+static void	export_item_clean(zbx_history_export_item_t *export_item)
 {
-	int		i;
-	size_t		sql_offset = 0;
-	zbx_db_result_t	result;
-	zbx_db_row_t	row;
-	zbx_host_info_t		*host_info;
-	zbx_hashset_iter_t	iter;
-
-	for (i = 0; i < hostids->values_num; i++)
-	{
-		zbx_host_info_t	host_info_new = {.hostid = hostids->values[i]};
-
-		zbx_vector_ptr_create(&host_info_new.groups);
-		zbx_hashset_insert(hosts_info, &host_info_new, sizeof(host_info_new));
-	}
-
-	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
-				"select distinct hg.hostid,g.name"
-				" from hstgrp g,hosts_groups hg"
-				" where g.groupid=hg.groupid"
-					" and");
-
-	zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "hg.hostid", hostids->values, hostids->values_num);
-
-	result = zbx_db_select("%s", sql);
-
-	while (NULL != (row = zbx_db_fetch(result)))
-	{
-		zbx_uint64_t	hostid;
-
-		ZBX_DBROW2UINT64(hostid, row[0]);
-
-		if (NULL == (host_info = (zbx_host_info_t *)zbx_hashset_search(hosts_info, &hostid)))
-		{
-			THIS_SHOULD_NEVER_HAPPEN;
-			continue;
-		}
-
-		zbx_vector_ptr_append(&host_info->groups, zbx_strdup(NULL, row[1]));
-	}
-
-	zbx_hashset_iter_reset(hosts_info, &iter);
-	while (NULL != (host_info = (zbx_host_info_t *)zbx_hashset_iter_next(&iter)))
-		zbx_vector_ptr_sort(&host_info->groups, ZBX_DEFAULT_STR_COMPARE_FUNC);
-
-	zbx_db_free_result(result);
+	zbx_vector_tags_ptr_clear_ext(&export_item->item_tags, zbx_free_tag);
+	zbx_vector_tags_ptr_destroy(&export_item->item_tags);
+	zbx_free(export_item->name);
 }
 
-typedef struct
+static void	export_host_clean(zbx_history_export_host_t *export_host)
 {
-	zbx_uint64_t		itemid;
-	char			*name;
-	zbx_history_sync_item_t	*item;
-	zbx_vector_tags_ptr_t	item_tags;
+	zbx_vector_str_clear_ext(&export_host->groups, zbx_str_free);
+	zbx_vector_str_destroy(&export_host->groups);
 }
-zbx_item_info_t;
 
 /******************************************************************************
  *                                                                            *
- * Purpose: get item names                                                    *
+ * Purpose: get item names, item tags and host groups for exported items      *
  *                                                                            *
- * Parameters: items_info - [IN/OUT] output item names                        *
- *             itemids    - [IN] the item identifiers                         *
+ * Parameters: items_info - [IN/OUT] the exported items                       *
+ *                                                                            *
+ * Comments: The data is cached locally and requested from configuration      *
+ *           cache only for items and hosts that are not cached yet, so       *
+ *           export does not need database access.                            *
  *                                                                            *
  ******************************************************************************/
-static void	db_get_item_names_by_itemid(zbx_hashset_t *items_info, const zbx_vector_uint64_t *itemids)
+static void	export_cache_get_items_info(zbx_hashset_t *items_info)
 {
-	size_t		sql_offset = 0;
-	zbx_db_result_t	result;
-	zbx_db_row_t	row;
-
-	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select itemid,name from items where");
-	zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "itemid", itemids->values, itemids->values_num);
+	zbx_uint64_t				revision;
+	zbx_hashset_iter_t			iter;
+	zbx_item_info_t				*item_info;
+	zbx_vector_history_export_item_ptr_t	new_items;
+	zbx_vector_history_export_host_ptr_t	new_hosts;
 
-	result = zbx_db_select("%s", sql);
-
-	while (NULL != (row = zbx_db_fetch(result)))
+	if (NULL == export_cache)
 	{
-		zbx_uint64_t	itemid;
-		zbx_item_info_t	*item_info;
-
-		ZBX_DBROW2UINT64(itemid, row[0]);
-
-		if (NULL == (item_info = (zbx_item_info_t *)zbx_hashset_search(items_info, &itemid)))
-		{
-			THIS_SHOULD_NEVER_HAPPEN;
-			continue;
-		}
-
-		item_info->name = zbx_strdup(item_info->name, row[1]);
+		export_cache = (zbx_export_cache_t *)zbx_malloc(NULL, sizeof(zbx_export_cache_t));
+		export_cache->revision = 0;
+
+		zbx_hashset_create_ext(&export_cache->items, ZBX_HC_SYNC_MAX, ZBX_DEFAULT_UINT64_HASH_FUNC,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC, (zbx_clean_func_t)export_item_clean,
+				ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+		zbx_hashset_create_ext(&export_cache->hosts, ZBX_HC_SYNC_MAX, ZBX_DEFAULT_UINT64_HASH_FUNC,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC, (zbx_clean_func_t)export_host_clean,
+				ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
 	}
 
-	zbx_db_free_result(result);
-}
-
-/******************************************************************************
- *                                                                            *
- * Purpose: get item tags                                                     *
- *                                                                            *
- * Parameters: items_info - [IN/OUT] output item tags                         *
- *             itemids    - [IN] the item identifiers                         *
- *                                                                            *
- ******************************************************************************/
-static void	db_get_item_tags_by_itemid(zbx_hashset_t *items_info, const zbx_vector_uint64_t *itemids)
-{
-	size_t		sql_offset = 0;
-	zbx_db_result_t	result;
-	zbx_db_row_t	row;
-	zbx_item_info_t	*item_info = NULL;
+	if (export_cache->revision != (revision = zbx_dc_config_history_sync_get_revision()))
+	{
+		zbx_hashset_clear(&export_cache->items);
+		zbx_hashset_clear(&export_cache->hosts);
+		export_cache->revision = revision;
+	}
 
-	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select itemid,tag,value from item_tag where");
-	zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "itemid", itemids->values, itemids->values_num);
-	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " order by itemid");
+	zbx_vector_history_export_item_ptr_create(&new_items);
+	zbx_vector_history_export_host_ptr_create(&new_hosts);
 
-	result = zbx_db_select("%s", sql);
+	zbx_hashset_iter_reset(items_info, &iter);
 
-	while (NULL != (row = zbx_db_fetch(result)))
+	while (NULL != (item_info = (zbx_item_info_t *)zbx_hashset_iter_next(&iter)))
 	{
-		zbx_uint64_t	itemid;
-		zbx_tag_t	*item_tag;
+		zbx_history_export_item_t	*export_item;
+		zbx_history_export_host_t	*export_host;
+
+		if (NULL == (export_item = (zbx_history_export_item_t *)zbx_hashset_search(&export_cache->items,
+				&item_info->itemid)))
+		{
+			zbx_history_export_item_t	export_item_local = {.itemid = item_info->itemid};
 
-		ZBX_DBROW2UINT64(itemid, row[0]);
+			zbx_vector_tags_ptr_create(&export_item_local.item_tags);
+			export_item = (zbx_history_export_item_t *)zbx_hashset_insert(&export_cache->items,
+					&export_item_local, sizeof(export_item_local));
+			zbx_vector_history_export_item_ptr_append(&new_items, export_item);
+		}
 
-		if (NULL == item_info || item_info->itemid != itemid)
+		if (NULL == (export_host = (zbx_history_export_host_t *)zbx_hashset_search(&export_cache->hosts,
+				&item_info->item->host.hostid)))
 		{
-			if (NULL != item_info)
-			{
-				zbx_vector_tags_ptr_sort(&item_info->item_tags, zbx_compare_tags);
-			}
-			if (NULL == (item_info = (zbx_item_info_t *)zbx_hashset_search(items_info, &itemid)))
-			{
-				THIS_SHOULD_NEVER_HAPPEN;
-				continue;
-			}
+			zbx_history_export_host_t	export_host_local = {.hostid = item_info->item->host.hostid};
+
+			zbx_vector_str_create(&export_host_local.groups);
+			export_host = (zbx_history_export_host_t *)zbx_hashset_insert(&export_cache->hosts,
+					&export_host_local, sizeof(export_host_local));
+			zbx_vector_history_export_host_ptr_append(&new_hosts, export_host);
 		}
 
-		item_tag = (zbx_tag_t *)zbx_malloc(NULL, sizeof(*item_tag));
-		item_tag->tag = zbx_strdup(NULL, row[1]);
-		item_tag->value = zbx_strdup(NULL, row[2]);
-		zbx_vector_tags_ptr_append(&item_info->item_tags, item_tag);
+		item_info->export_item = export_item;
+		item_info->export_host = export_host;
 	}
 
-	if (NULL != item_info)
-	{
-		zbx_vector_tags_ptr_sort(&item_info->item_tags, zbx_compare_tags);
-	}
+	if (0 != new_items.values_num || 0 != new_hosts.values_num)
+		zbx_dc_config_history_sync_get_export_data(&new_items, &new_hosts);
 
-	zbx_db_free_result(result);
-}
-
-/******************************************************************************
- *                                                                            *
- * Purpose: get item names and item tags                                      *
- *                                                                            *
- * Parameters: items_info - [IN/OUT] output item name and item tags           *
- *             itemids    - [IN] the item identifiers                         *
- *                                                                            *
- ******************************************************************************/
-static void	db_get_items_info_by_itemid(zbx_hashset_t *items_info, const zbx_vector_uint64_t *itemids)
-{
-	db_get_item_names_by_itemid(items_info, itemids);
-	db_get_item_tags_by_itemid(items_info, itemids);
-}
-
-/******************************************************************************
- *                                                                            *
- * Purpose: frees resources allocated to store item tags and name             *
- *                                                                            *
- * Parameters: item_info - [IN] item information                              *
- *                                                                            *
- ******************************************************************************/
-static void	zbx_item_info_clean(zbx_item_info_t *item_info)
-{
-	zbx_vector_tags_ptr_clear_ext(&item_info->item_tags, zbx_free_tag);
-	zbx_vector_tags_ptr_destroy(&item_info->item_tags);
-	zbx_free(item_info->name);
+	zbx_vector_history_export_host_ptr_destroy(&new_hosts);
+	zbx_vector_history_export_item_ptr_destroy(&new_items);
 }
 
 /******************************************************************************
@@ -1159,18 +1213,15 @@ static void	zbx_item_info_clean(zbx_item_info_t *item_info)
  *                                                                            *
  * Parameters: trends     - [IN] trends from cache                            *
  *             trends_num - [IN] number of trends                             *
- *             hosts_info - [IN] hosts groups names                           *
- *             items_info - [IN] item names and tags                          *
+ *             items_info - [IN] item names, tags and host groups             *
  *                                                                            *
  ******************************************************************************/
-static void	DCexport_trends(const ZBX_DC_TREND *trends, int trends_num, zbx_hashset_t *hosts_info,
-		zbx_hashset_t *items_info)
+static void	DCexport_trends(const ZBX_DC_TREND *trends, int trends_num, zbx_hashset_t *items_info)
 {
 	struct zbx_json			json;
 	const ZBX_DC_TREND		*trend = NULL;
 	int				i, j;
 	const zbx_history_sync_item_t	*item;
-	zbx_host_info_t			*host_info;
 	zbx_item_info_t			*item_info;
 	zbx_uint128_t			avg;	/* calculate the trend average value */
 
@@ -1185,12 +1236,6 @@ static void	DCexport_trends(const ZBX_DC_TREND *trends, int trends_num, zbx_hash
 
 		item = item_info->item;
 
-		if (NULL == (host_info = (zbx_host_info_t *)zbx_hashset_search(hosts_info, &item->host.hostid)))
-		{
-			THIS_SHOULD_NEVER_HAPPEN;
-			continue;
-		}
-
 		zbx_json_clean(&json);
 
 		zbx_json_addobject(&json,ZBX_PROTO_TAG_HOST);
@@ -1200,16 +1245,19 @@ static void	DCexport_trends(const ZBX_DC_TREND *trends, int trends_num, zbx_hash
 
 		zbx_json_addarray(&json, ZBX_PROTO_TAG_GROUPS);
 
-		for (j = 0; j < host_info->groups.values_num; j++)
-			zbx_json_addstring(&json, NULL, host_info->groups.values[j], ZBX_JSON_TYPE_STRING);
+		for (j = 0; j < item_info->export_host->groups.values_num; j++)
+		{
+			zbx_json_addstring(&json, NULL, item_info->export_host->groups.values[j],
+					ZBX_JSON_TYPE_STRING);
+		}
 
 		zbx_json_close(&json);
 
 		zbx_json_addarray(&json, ZBX_PROTO_TAG_ITEM_TAGS);
 
-		for (j = 0; j < item_info->item_tags.values_num; j++)
+		for (j = 0; j < item_info->export_item->item_tags.values_num; j++)
 		{
-			zbx_tag_t	*item_tag = item_info->item_tags.values[j];
+			zbx_tag_t	*item_tag = item_info->export_item->item_tags.values[j];
 
 			zbx_json_addobject(&json, NULL);
 			zbx_json_addstring(&json, ZBX_PROTO_TAG_TAG, item_tag->tag, ZBX_JSON_TYPE_STRING);
@@ -1220,8 +1268,11 @@ static void	DCexport_trends(const ZBX_DC_TREND *trends, int trends_num, zbx_hash
 		zbx_json_close(&json);
 		zbx_json_adduint64(&json, ZBX_PROTO_TAG_ITEMID, item->itemid);
 
-		if (NULL != item_info->name)
-			zbx_json_addstring(&json, ZBX_PROTO_TAG_NAME, item_info->name, ZBX_JSON_TYPE_STRING);
+		if (NULL != item_info->export_item->name)
+		{
+			zbx_json_addstring(&json, ZBX_PROTO_TAG_NAME, item_info->export_item->name,
+					ZBX_JSON_TYPE_STRING);
+		}
 
 		zbx_json_addint64(&json, ZBX_PROTO_TAG_CLOCK, trend->clock);
 		zbx_json_addint64(&json, ZBX_PROTO_TAG_COUNT, trend->num);
@@ -1265,18 +1316,16 @@ static int	match_item_value_type_by_mask(int mask, const zbx_history_sync_item_t
  *                                                                            *
  * Parameters: history     - [IN/OUT] array of history data                   *
  *             history_num - [IN] number of history structures                *
- *             hosts_info  - [IN] hosts groups names                          *
- *             items_info  - [IN] item names and tags                         *
+ *             items_info  - [IN] item names, tags and host groups            *
  *                                                                            *
  ******************************************************************************/
-static void	DCexport_history(const zbx_dc_history_t *history, int history_num, zbx_hashset_t *hosts_info,
-		zbx_hashset_t *items_info, int history_export_enabled, zbx_vector_connector_filter_t *connector_filters,
+static void	DCexport_history(const zbx_dc_history_t *history, int history_num, zbx_hashset_t *items_info,
+		int history_export_enabled, zbx_vector_connector_filter_t *connector_filters,
 		unsigned char **data, size_t *data_alloc, size_t *data_offset)
 {
 	const zbx_dc_history_t		*h;
 	const zbx_history_sync_item_t	*item;
 	int				i, j;
-	zbx_host_info_t			*host_info;
 	zbx_item_info_t			*item_info;
 	struct zbx_json			json;
 	zbx_connector_object_t		connector_object;
@@ -1305,12 +1354,6 @@ static void	DCexport_history(const zbx_dc_history_t *history, int history_num, z
 
 		item = item_info->item;
 
-		if (NULL == (host_info = (zbx_host_info_t *)zbx_hashset_search(hosts_info, &item->host.hostid)))
-		{
-			THIS_SHOULD_NEVER_HAPPEN;
-			continue;
-		}
-
 		if (0 != connector_filters->values_num)
 		{
 			int	k;
@@ -1320,7 +1363,8 @@ static void	DCexport_history(const zbx_dc_history_t *history, int history_num, z
 				if (SUCCEED == match_item_value_type_by_mask(connector_filters->values[k].
 						item_value_type, item) && SUCCEED ==
 						zbx_match_tags(connector_filters->values[k].tags_evaltype,
-						&connector_filters->values[k].connector_tags, &item_info->item_tags))
+						&connector_filters->values[k].connector_tags,
+						&item_info->export_item->item_tags))
 				{
 					zbx_vector_uint64_append(&connector_object.ids,
 							connector_filters->values[k].connectorid);
@@ -1340,16 +1384,19 @@ static void	DCexport_history(const zbx_dc_history_t *history, int history_num, z
 
 		zbx_json_addarray(&json, ZBX_PROTO_TAG_GROUPS);
 
-		for (j = 0; j < host_info->groups.values_num; j++)
-			zbx_json_addstring(&json, NULL, host_info->groups.values[j], ZBX_JSON_TYPE_STRING);
+		for (j = 0; j < item_info->export_host->groups.values_num; j++)
+		{
+			zbx_json_addstring(&json, NULL, item_info->export_host->groups.values[j],
+					ZBX_JSON_TYPE_STRING);
+		}
 
 		zbx_json_close(&json);
 
 		zbx_json_addarray(&json, ZBX_PROTO_TAG_ITEM_TAGS);
 
-		for (j = 0; j < item_info->item_tags.values_num; j++)
+		for (j = 0; j < item_info->export_item->item_tags.values_num; j++)
 		{
-			zbx_tag_t	*item_tag = item_info->item_tags.values[j];
+			zbx_tag_t	*item_tag = item_info->export_item->item_tags.values[j];
 
 			zbx_json_addobject(&json, NULL);
 			zbx_json_addstring(&json, ZBX_PROTO_TAG_TAG, item_tag->tag, ZBX_JSON_TYPE_STRING);
@@ -1360,8 +1407,11 @@ static void	DCexport_history(const zbx_dc_history_t *history, int history_num, z
 		zbx_json_close(&json);
 		zbx_json_adduint64(&json, ZBX_PROTO_TAG_ITEMID, item->itemid);
 
-		if (NULL != item_info->name)
-			zbx_json_addstring(&json, ZBX_PROTO_TAG_NAME, item_info->name, ZBX_JSON_TYPE_STRING);
+		if (NULL != item_info->export_item->name)
+		{
+			zbx_json_addstring(&json, ZBX_PROTO_TAG_NAME, item_info->export_item->name,
+					ZBX_JSON_TYPE_STRING);
+		}
 
 		zbx_json_addint64(&json, ZBX_PROTO_TAG_CLOCK, h->ts.sec);
 		zbx_json_addint64(&json, ZBX_PROTO_TAG_NS, h->ts.ns);
@@ -1441,8 +1491,8 @@ void	zbx_dc_export_history_and_trends(const zbx_dc_history_t *history, int histo
 		size_t *data_offset)
 {
 	int			i, index, *trend_errcodes = NULL;
-	zbx_vector_uint64_t	hostids, item_info_ids, trend_itemids;
-	zbx_hashset_t		hosts_info, items_info;
+	zbx_vector_uint64_t	trend_itemids;
+	zbx_hashset_t		items_info;
 	zbx_history_sync_item_t	*item;
 	zbx_item_info_t		item_info;
 	zbx_history_sync_item_t	*trend_items = NULL;
@@ -1450,11 +1500,8 @@ void	zbx_dc_export_history_and_trends(const zbx_dc_history_t *history, int histo
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d trends_num:%d", __func__, history_num, trends_num);
 
 	zbx_vector_uint64_create(&trend_itemids);
-	zbx_vector_uint64_create(&hostids);
-	zbx_vector_uint64_create(&item_info_ids);
-	zbx_hashset_create_ext(&items_info, itemids->values_num, ZBX_DEFAULT_UINT64_HASH_FUNC,
-			ZBX_DEFAULT_UINT64_COMPARE_FUNC, (zbx_clean_func_t)zbx_item_info_clean,
-			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+	zbx_hashset_create(&items_info, (size_t)itemids->values_num, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
 	for (i = 0; i < history_num; i++)
 	{
@@ -1474,13 +1521,10 @@ void	zbx_dc_export_history_and_trends(const zbx_dc_history_t *history, int histo
 
 		item = &items[index];
 
-		zbx_vector_uint64_append(&hostids, item->host.hostid);
-		zbx_vector_uint64_append(&item_info_ids, item->itemid);
-
 		item_info.itemid = item->itemid;
-		item_info.name = NULL;
 		item_info.item = item;
-		zbx_vector_tags_ptr_create(&item_info.item_tags);
+		item_info.export_item = NULL;
+		item_info.export_host = NULL;
 		zbx_hashset_insert(&items_info, &item_info, sizeof(item_info));
 	}
 
@@ -1532,46 +1576,29 @@ void	zbx_dc_export_history_and_trends(const zbx_dc_history_t *history, int histo
 		if (SUCCEED != errcode)
 			continue;
 
-		zbx_vector_uint64_append(&hostids, item->host.hostid);
-		zbx_vector_uint64_append(&item_info_ids, item->itemid);
-
 		item_info.itemid = item->itemid;
-		item_info.name = NULL;
 		item_info.item = item;
-		zbx_vector_tags_ptr_create(&item_info.item_tags);
+		item_info.export_item = NULL;
+		item_info.export_host = NULL;
 		zbx_hashset_insert(&items_info, &item_info, sizeof(item_info));
 	}
 
-	if (0 == item_info_ids.values_num)
+	if (0 == items_info.num_data)
 		goto clean;
 
-	zbx_vector_uint64_sort(&item_info_ids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-	zbx_vector_uint64_sort(&hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-	zbx_vector_uint64_uniq(&hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-
-	zbx_hashset_create_ext(&hosts_info, hostids.values_num, ZBX_DEFAULT_UINT64_HASH_FUNC,
-			ZBX_DEFAULT_UINT64_COMPARE_FUNC, (zbx_clean_func_t)zbx_host_info_clean,
-			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
-
-	db_get_hosts_info_by_hostid(&hosts_info, &hostids);
-
-	db_get_items_info_by_itemid(&items_info, &item_info_ids);
+	export_cache_get_items_info(&items_info);
 
 	if (0 != history_num)
 	{
-		DCexport_history(history, history_num, &hosts_info, &items_info, history_export_enabled,
-				connector_filters, data, data_alloc, data_offset);
+		DCexport_history(history, history_num, &items_info, history_export_enabled, connector_filters, data,
+				data_alloc, data_offset);
 	}
 
 	if (0 != trends_num)
-		DCexport_trends(trends, trends_num, &hosts_info, &items_info);
-
-	zbx_hashset_destroy(&hosts_info);
+		DCexport_trends(trends, trends_num, &items_info);
 clean:
 	zbx_dc_config_clean_history_sync_items(trend_items, trend_errcodes, (size_t)trend_itemids.values_num);
 	zbx_hashset_destroy(&items_info);
-	zbx_vector_uint64_destroy(&item_info_ids);
-	zbx_vector_uint64_destroy(&hostids);
 	zbx_vector_uint64_destroy(&trend_itemids);
 	zbx_free(trend_items);
 	zbx_free(trend_errcodes);
@@ -1797,10 +1824,10 @@ void	zbx_db_mass_update_items(const zbx_vector_item_diff_ptr_t *item_diff,
  ******************************************************************************/
 static void	sync_history_cache_full(const zbx_events_funcs_t *events_cbs, int config_history_storage_pipelines)
 {
-	int			values_num = 0, triggers_num = 0, more;
+	int			values_num = 0, triggers_num = 0, more, i;
 	zbx_hashset_iter_t	iter;
 	zbx_hc_item_t		*item;
-	zbx_binary_heap_t	tmp_history_queue;
+	zbx_binary_heap_t	tmp_history_queue[ZBX_HC_SHARDS_MAX];
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, cache->history_num);
 
@@ -1821,18 +1848,24 @@ static void	sync_history_cache_full(const zbx_events_funcs_t *events_cbs, int co
 		zbx_dc_config_unlock_all_triggers();
 	}
 
-	tmp_history_queue = cache->history_queue;
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		zbx_hc_shard_t	*shard = &cache->shards[i];
 
-	zbx_binary_heap_create(&cache->history_queue, hc_queue_elem_compare_func, ZBX_BINARY_HEAP_OPTION_EMPTY);
-	zbx_hashset_iter_reset(&cache->history_items, &iter);
+		tmp_history_queue[i] = shard->history_queue;
 
-	/* add all items from history index to the new history queue */
-	while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
-	{
-		if (NULL != item->tail)
+		zbx_binary_heap_create(&shard->history_queue, hc_queue_elem_compare_func,
+				ZBX_BINARY_HEAP_OPTION_EMPTY);
+		zbx_hashset_iter_reset(&shard->history_items, &iter);
+
+		/* add all items from history index to the new history queue */
+		while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
 		{
-			item->status = ZBX_HC_ITEM_STATUS_NORMAL;
-			hc_queue_item(item);
+			if (NULL != item->tail)
+			{
+				item->status = ZBX_HC_ITEM_STATUS_NORMAL;
+				hc_queue_item(shard, item);
+			}
 		}
 	}
 
@@ -1853,8 +1886,11 @@ static void	sync_history_cache_full(const zbx_events_funcs_t *events_cbs, int co
 		zabbix_log(LOG_LEVEL_WARNING, "syncing history data done");
 	}
 
-	zbx_binary_heap_destroy(&cache->history_queue);
-	cache->history_queue = tmp_history_queue;
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		zbx_binary_heap_destroy(&cache->shards[i].history_queue);
+		cache->shards[i].history_queue = tmp_history_queue[i];
+	}
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
@@ -2435,20 +2471,49 @@ void	zbx_dc_add_history_variant(zbx_uint64_t itemid, unsigned char value_type, u
 
 size_t	zbx_dc_flush_history(void)
 {
-	int	processing_num;
+	int	processing_num, i, offsets[ZBX_HC_SHARDS_MAX + 1], dropped_num = 0;
 
 	if (0 == item_values_num)
 		return 0;
 
+	/* account values before making them visible to history syncers */
 	LOCK_CACHE;
 
-	hc_add_item_values(item_values, item_values_num);
-
 	cache->history_num += item_values_num;
 	processing_num = cache->processing_num;
 
 	UNLOCK_CACHE;
 
+	if (item_values_shards_alloc < item_values_num)
+	{
+		item_values_shards_alloc = item_values_alloc;
+		item_values_shards = (int *)zbx_realloc(item_values_shards, sizeof(int) * item_values_shards_alloc);
+		item_values_order = (int *)zbx_realloc(item_values_order, sizeof(int) * item_values_shards_alloc);
+	}
+
+	for (i = 0; i < (int)item_values_num; i++)
+		item_values_shards[i] = hc_shard_index(item_values[i].itemid);
+
+	hc_group_by_shard(item_values_shards, (int)item_values_num, item_values_order, offsets);
+
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		if (offsets[i] == offsets[i + 1])
+			continue;
+
+		LOCK_SHARD(i);
+		dropped_num += hc_add_item_values(i, item_values, item_values_order + offsets[i],
+				offsets[i + 1] - offsets[i]);
+		UNLOCK_SHARD(i);
+	}
+
+	if (0 != dropped_num)
+	{
+		LOCK_CACHE;
+		cache->history_num -= dropped_num;
+		UNLOCK_CACHE;
+	}
+
 	zbx_vps_monitor_add_collected((zbx_uint64_t)item_values_num);
 
 	size_t	count = item_values_num;
@@ -2468,7 +2533,86 @@ size_t	zbx_dc_flush_history(void)
  *                                                                            *
  ******************************************************************************/
 ZBX_SHMEM_FUNC_IMPL(__hc_index, hc_index_mem)
-ZBX_SHMEM_FUNC_IMPL(__hc, hc_mem)
+
+/* Each shard keeps its items and queue in its own index memory, so the shard lock */
+/* protects the allocator as well. The function sets are listed for every shard,  */
+/* their number must match ZBX_HC_SHARDS_MAX.                                     */
+#if 8 != ZBX_HC_SHARDS_MAX
+#	error "history cache shard index memory functions do not match ZBX_HC_SHARDS_MAX"
+#endif
+
+#define HC_SHARD_INDEX_FUNC_IMPL(index)	ZBX_SHMEM_FUNC_IMPL(__hc_shard_index ## index, hc_shard_index_mem[index])
+
+HC_SHARD_INDEX_FUNC_IMPL(0)
+HC_SHARD_INDEX_FUNC_IMPL(1)
+HC_SHARD_INDEX_FUNC_IMPL(2)
+HC_SHARD_INDEX_FUNC_IMPL(3)
+HC_SHARD_INDEX_FUNC_IMPL(4)
+HC_SHARD_INDEX_FUNC_IMPL(5)
+HC_SHARD_INDEX_FUNC_IMPL(6)
+HC_SHARD_INDEX_FUNC_IMPL(7)
+
+#undef HC_SHARD_INDEX_FUNC_IMPL
+
+typedef struct
+{
+	zbx_mem_malloc_func_t	malloc_func;
+	zbx_mem_realloc_func_t	realloc_func;
+	zbx_mem_free_func_t	free_func;
+}
+zbx_hc_shard_index_funcs_t;
+
+#define HC_SHARD_INDEX_FUNCS(index)						\
+	{									\
+		__hc_shard_index ## index ## _shmem_malloc_func,		\
+		__hc_shard_index ## index ## _shmem_realloc_func,		\
+		__hc_shard_index ## index ## _shmem_free_func			\
+	}
+
+static const zbx_hc_shard_index_funcs_t	hc_shard_index_funcs[ZBX_HC_SHARDS_MAX] = {
+	HC_SHARD_INDEX_FUNCS(0), HC_SHARD_INDEX_FUNCS(1), HC_SHARD_INDEX_FUNCS(2), HC_SHARD_INDEX_FUNCS(3),
+	HC_SHARD_INDEX_FUNCS(4), HC_SHARD_INDEX_FUNCS(5), HC_SHARD_INDEX_FUNCS(6), HC_SHARD_INDEX_FUNCS(7)
+};
+
+#undef HC_SHARD_INDEX_FUNCS
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: shared history index memory allocation functions                  *
+ *                                                                            *
+ * Comments: Shared history index memory holds cache header and proxy queue.  *
+ *           Allocations are serialized with a separate lock held only for    *
+ *           the duration of allocator call.                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	*hc_index_malloc_func(void *old, size_t size)
+{
+	void	*ptr;
+
+	LOCK_CACHE_INDEX;
+	ptr = __hc_index_shmem_malloc_func(old, size);
+	UNLOCK_CACHE_INDEX;
+
+	return ptr;
+}
+
+static void	*hc_index_realloc_func(void *old, size_t size)
+{
+	void	*ptr;
+
+	LOCK_CACHE_INDEX;
+	ptr = __hc_index_shmem_realloc_func(old, size);
+	UNLOCK_CACHE_INDEX;
+
+	return ptr;
+}
+
+static void	hc_index_free_func(void *ptr)
+{
+	LOCK_CACHE_INDEX;
+	__hc_index_shmem_free_func(ptr);
+	UNLOCK_CACHE_INDEX;
+}
 
 /******************************************************************************
  *                                                                            *
@@ -2491,14 +2635,15 @@ static int	hc_queue_elem_compare_func(const void *d1, const void *d2)
  *                                                                            *
  * Purpose: free history item data allocated in history cache                 *
  *                                                                            *
- * Parameters: data - [IN] history item data                                  *
+ * Parameters: mem  - [IN] the shard value memory                             *
+ *             data - [IN] history item data                                  *
  *                                                                            *
  ******************************************************************************/
-static void	hc_free_data(zbx_hc_data_t *data)
+static void	hc_free_data(zbx_shmem_info_t *mem, zbx_hc_data_t *data)
 {
 	if (ITEM_STATE_NOTSUPPORTED == data->state)
 	{
-		__hc_shmem_free_func(data->value.str);
+		zbx_shmem_free(mem, data->value.str);
 	}
 	else
 	{
@@ -2509,15 +2654,15 @@ static void	hc_free_data(zbx_hc_data_t *data)
 				case ITEM_VALUE_TYPE_STR:
 				case ITEM_VALUE_TYPE_TEXT:
 				case ITEM_VALUE_TYPE_BIN:
-					__hc_shmem_free_func(data->value.str);
+					zbx_shmem_free(mem, data->value.str);
 					break;
 				case ITEM_VALUE_TYPE_LOG:
-					__hc_shmem_free_func(data->value.log->value);
+					zbx_shmem_free(mem, data->value.log->value);
 
 					if (NULL != data->value.log->source)
-						__hc_shmem_free_func(data->value.log->source);
+						zbx_shmem_free(mem, data->value.log->source);
 
-					__hc_shmem_free_func(data->value.log);
+					zbx_shmem_free(mem, data->value.log);
 					break;
 				case ITEM_VALUE_TYPE_UINT64:
 				case ITEM_VALUE_TYPE_FLOAT:
@@ -2530,69 +2675,73 @@ static void	hc_free_data(zbx_hc_data_t *data)
 		}
 	}
 
-	__hc_shmem_free_func(data);
+	zbx_shmem_free(mem, data);
 }
 
 /******************************************************************************
  *                                                                            *
  * Purpose: put back item into history queue                                  *
  *                                                                            *
- * Parameters: data - [IN] history item data                                  *
+ * Parameters: shard - [IN] the history cache shard                           *
+ *             item  - [IN] the history item                                  *
  *                                                                            *
  ******************************************************************************/
-static void	hc_queue_item(zbx_hc_item_t *item)
+static void	hc_queue_item(zbx_hc_shard_t *shard, zbx_hc_item_t *item)
 {
 	zbx_binary_heap_elem_t	elem = {item->itemid, (void *)item};
 
-	zbx_binary_heap_insert(&cache->history_queue, &elem);
+	zbx_binary_heap_insert(&shard->history_queue, &elem);
 }
 
 /******************************************************************************
  *                                                                            *
  * Purpose: returns history item by itemid                                    *
  *                                                                            *
- * Parameters: itemid - [IN] the item id                                      *
+ * Parameters: shard  - [IN] the history cache shard                          *
+ *             itemid - [IN] the item id                                      *
  *                                                                            *
  * Return value: the history item or NULL if the requested item is not in     *
  *               history cache                                                *
  *                                                                            *
  ******************************************************************************/
-static zbx_hc_item_t	*hc_get_item(zbx_uint64_t itemid)
+static zbx_hc_item_t	*hc_get_item(zbx_hc_shard_t *shard, zbx_uint64_t itemid)
 {
-	return (zbx_hc_item_t *)zbx_hashset_search(&cache->history_items, &itemid);
+	return (zbx_hc_item_t *)zbx_hashset_search(&shard->history_items, &itemid);
 }
 
 /******************************************************************************
  *                                                                            *
  * Purpose: adds a new item to history cache                                  *
  *                                                                            *
- * Parameters: itemid - [IN] the item id                                      *
- *                      [IN] the item data                                    *
+ * Parameters: shard  - [IN] the history cache shard                          *
+ *             itemid - [IN] the item id                                      *
+ *             data   - [IN] the item data                                    *
  *                                                                            *
  * Return value: the added history item                                       *
  *                                                                            *
  ******************************************************************************/
-static zbx_hc_item_t	*hc_add_item(zbx_uint64_t itemid, zbx_hc_data_t *data)
+static zbx_hc_item_t	*hc_add_item(zbx_hc_shard_t *shard, zbx_uint64_t itemid, zbx_hc_data_t *data)
 {
 	zbx_hc_item_t	item_local = {itemid, ZBX_HC_ITEM_STATUS_NORMAL, 0, data, data};
 
-	return (zbx_hc_item_t *)zbx_hashset_insert(&cache->history_items, &item_local, sizeof(item_local));
+	return (zbx_hc_item_t *)zbx_hashset_insert(&shard->history_items, &item_local, sizeof(item_local));
 }
 
 /******************************************************************************
  *                                                                            *
  * Purpose: copies string value to history cache                              *
  *                                                                            *
- * Parameters: str - [IN] the string value                                    *
+ * Parameters: mem - [IN] the shard value memory                              *
+ *             str - [IN] the string value                                    *
  *                                                                            *
  * Return value: the copied string or NULL if there was not enough memory     *
  *                                                                            *
  ******************************************************************************/
-static char	*hc_mem_value_str_dup(const dc_value_str_t *str)
+static char	*hc_mem_value_str_dup(zbx_shmem_info_t *mem, const dc_value_str_t *str)
 {
 	char	*ptr;
 
-	if (NULL == (ptr = (char *)__hc_shmem_malloc_func(NULL, str->len)))
+	if (NULL == (ptr = (char *)zbx_shmem_malloc(mem, NULL, str->len)))
 		return NULL;
 
 	memcpy(ptr, &string_values[str->pvalue], str->len - 1);
@@ -2605,7 +2754,8 @@ static char	*hc_mem_value_str_dup(const dc_value_str_t *str)
  *                                                                            *
  * Purpose: clones string value into history data memory                      *
  *                                                                            *
- * Parameters: dst - [IN/OUT] a reference to the cloned value                 *
+ * Parameters: mem - [IN] the shard value memory                              *
+ *             dst - [IN/OUT] a reference to the cloned value                 *
  *             str - [IN] the string value to clone                           *
  *                                                                            *
  * Return value: SUCCESS - either there was no need to clone the string       *
@@ -2617,7 +2767,7 @@ static char	*hc_mem_value_str_dup(const dc_value_str_t *str)
  *           until it finishes cloning string value.                          *
  *                                                                            *
  ******************************************************************************/
-static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
+static int	hc_clone_history_str_data(zbx_shmem_info_t *mem, char **dst, const dc_value_str_t *str)
 {
 	if (0 == str->len)
 		return SUCCEED;
@@ -2625,7 +2775,7 @@ static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
 	if (NULL != *dst)
 		return SUCCEED;
 
-	if (NULL != (*dst = hc_mem_value_str_dup(str)))
+	if (NULL != (*dst = hc_mem_value_str_dup(mem, str)))
 		return SUCCEED;
 
 	return FAIL;
@@ -2635,7 +2785,8 @@ static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
  *                                                                            *
  * Purpose: clones log value into history data memory                         *
  *                                                                            *
- * Parameters: dst        - [IN/OUT] a reference to the cloned value          *
+ * Parameters: mem        - [IN] the shard value memory                       *
+ *             dst        - [IN/OUT] a reference to the cloned value          *
  *             item_value - [IN] the log value to clone                       *
  *                                                                            *
  * Return value: SUCCESS - the log value was cloned successfully              *
@@ -2645,21 +2796,21 @@ static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
  *           until it finishes cloning log value.                             *
  *                                                                            *
  ******************************************************************************/
-static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_t *item_value)
+static int	hc_clone_history_log_data(zbx_shmem_info_t *mem, zbx_log_value_t **dst,
+		const dc_item_value_t *item_value)
 {
 	if (NULL == *dst)
 	{
-		/* using realloc instead of malloc just to suppress 'not used' warning for realloc */
-		if (NULL == (*dst = (zbx_log_value_t *)__hc_shmem_realloc_func(NULL, sizeof(zbx_log_value_t))))
+		if (NULL == (*dst = (zbx_log_value_t *)zbx_shmem_malloc(mem, NULL, sizeof(zbx_log_value_t))))
 			return FAIL;
 
 		memset(*dst, 0, sizeof(zbx_log_value_t));
 	}
 
-	if (SUCCEED != hc_clone_history_str_data(&(*dst)->value, &item_value->value.value_str))
+	if (SUCCEED != hc_clone_history_str_data(mem, &(*dst)->value, &item_value->value.value_str))
 		return FAIL;
 
-	if (SUCCEED != hc_clone_history_str_data(&(*dst)->source, &item_value->source))
+	if (SUCCEED != hc_clone_history_str_data(mem, &(*dst)->source, &item_value->source))
 		return FAIL;
 
 	(*dst)->logeventid = item_value->logeventid;
@@ -2673,7 +2824,9 @@ static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_
  *                                                                            *
  * Purpose: clones item value from local cache into history cache             *
  *                                                                            *
- * Parameters: data       - [IN/OUT] a reference to the cloned value          *
+ * Parameters: mem        - [IN] the shard value memory                       *
+ *             stats      - [IN/OUT] the shard value counters                 *
+ *             data       - [IN/OUT] a reference to the cloned value          *
  *             item_value - [IN] the item value                               *
  *                                                                            *
  * Return value: SUCCESS - the item value was cloned successfully             *
@@ -2683,11 +2836,12 @@ static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_
  *           until it finishes cloning item value.                            *
  *                                                                            *
  ******************************************************************************/
-static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *item_value)
+static int	hc_clone_history_data(zbx_shmem_info_t *mem, zbx_dc_stats_t *stats, zbx_hc_data_t **data,
+		const dc_item_value_t *item_value)
 {
 	if (NULL == *data)
 	{
-		if (NULL == (*data = (zbx_hc_data_t *)__hc_shmem_malloc_func(NULL, sizeof(zbx_hc_data_t))))
+		if (NULL == (*data = (zbx_hc_data_t *)zbx_shmem_malloc(mem, NULL, sizeof(zbx_hc_data_t))))
 			return FAIL;
 
 		memset(*data, 0, sizeof(zbx_hc_data_t));
@@ -2705,24 +2859,24 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 
 	if (ITEM_STATE_NOTSUPPORTED == item_value->state)
 	{
-		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(&item_value->value.value_str)))
+		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(mem, &item_value->value.value_str)))
 			return FAIL;
 
 		(*data)->value_type = item_value->value_type;
-		cache->stats.notsupported_counter++;
+		stats->notsupported_counter++;
 
 		return SUCCEED;
 	}
 
 	if (0 != (ZBX_DC_FLAG_LLD & item_value->flags))
 	{
-		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(&item_value->value.value_str)))
+		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(mem, &item_value->value.value_str)))
 			return FAIL;
 
 		(*data)->value_type = ITEM_VALUE_TYPE_TEXT;
 
-		cache->stats.history_text_counter++;
-		cache->stats.history_counter++;
+		stats->history_text_counter++;
+		stats->history_counter++;
 
 		return SUCCEED;
 	}
@@ -2740,14 +2894,14 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 			case ITEM_VALUE_TYPE_STR:
 			case ITEM_VALUE_TYPE_TEXT:
 			case ITEM_VALUE_TYPE_BIN:
-				if (SUCCEED != hc_clone_history_str_data(&(*data)->value.str,
+				if (SUCCEED != hc_clone_history_str_data(mem, &(*data)->value.str,
 						&item_value->value.value_str))
 				{
 					return FAIL;
 				}
 				break;
 			case ITEM_VALUE_TYPE_LOG:
-				if (SUCCEED != hc_clone_history_log_data(&(*data)->value.log, item_value))
+				if (SUCCEED != hc_clone_history_log_data(mem, &(*data)->value.log, item_value))
 					return FAIL;
 				break;
 			case ITEM_VALUE_TYPE_NONE:
@@ -2759,22 +2913,22 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 		switch (item_value->item_value_type)
 		{
 			case ITEM_VALUE_TYPE_FLOAT:
-				cache->stats.history_float_counter++;
+				stats->history_float_counter++;
 				break;
 			case ITEM_VALUE_TYPE_UINT64:
-				cache->stats.history_uint_counter++;
+				stats->history_uint_counter++;
 				break;
 			case ITEM_VALUE_TYPE_STR:
-				cache->stats.history_str_counter++;
+				stats->history_str_counter++;
 				break;
 			case ITEM_VALUE_TYPE_TEXT:
-				cache->stats.history_text_counter++;
+				stats->history_text_counter++;
 				break;
 			case ITEM_VALUE_TYPE_LOG:
-				cache->stats.history_log_counter++;
+				stats->history_log_counter++;
 				break;
 			case ITEM_VALUE_TYPE_BIN:
-				cache->stats.history_bin_counter++;
+				stats->history_bin_counter++;
 				break;
 			case ITEM_VALUE_TYPE_NONE:
 			default:
@@ -2782,7 +2936,7 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 				exit(EXIT_FAILURE);
 		}
 
-		cache->stats.history_counter++;
+		stats->history_counter++;
 	}
 
 	(*data)->value_type = item_value->value_type;
@@ -2792,31 +2946,86 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 
 /******************************************************************************
  *                                                                            *
- * Purpose: adds item values to the history cache                             *
+ * Purpose: frees partially cloned item value                                 *
  *                                                                            *
- * Parameters: values     - [IN] the item values to add                       *
- *             values_num - [IN] the number of item values to add             *
+ * Parameters: mem        - [IN] the shard value memory                       *
+ *             data       - [IN] the partially cloned value                   *
+ *             item_value - [IN] the item value being cloned                  *
  *                                                                            *
- * Comments: If the history cache is full this function will wait until       *
- *           history syncers processes values freeing enough space to store   *
- *           the new value.                                                   *
+ ******************************************************************************/
+static void	hc_free_partial_data(zbx_shmem_info_t *mem, zbx_hc_data_t *data, const dc_item_value_t *item_value)
+{
+	if (ITEM_STATE_NOTSUPPORTED == item_value->state || 0 != (ZBX_DC_FLAG_LLD & item_value->flags))
+	{
+		if (NULL != data->value.str)
+			zbx_shmem_free(mem, data->value.str);
+	}
+	else if (0 == (ZBX_DC_FLAG_NOVALUE & item_value->flags))
+	{
+		switch (item_value->value_type)
+		{
+			case ITEM_VALUE_TYPE_STR:
+			case ITEM_VALUE_TYPE_TEXT:
+			case ITEM_VALUE_TYPE_BIN:
+				if (NULL != data->value.str)
+					zbx_shmem_free(mem, data->value.str);
+				break;
+			case ITEM_VALUE_TYPE_LOG:
+				if (NULL == data->value.log)
+					break;
+
+				if (NULL != data->value.log->value)
+					zbx_shmem_free(mem, data->value.log->value);
+
+				if (NULL != data->value.log->source)
+					zbx_shmem_free(mem, data->value.log->source);
+
+				zbx_shmem_free(mem, data->value.log);
+				break;
+			default:
+				break;
+		}
+	}
+
+	zbx_shmem_free(mem, data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds item values belonging to the specified shard to the history *
+ *          cache                                                             *
+ *                                                                            *
+ * Parameters: index     - [IN] the history cache shard index                 *
+ *             values    - [IN] the item values                               *
+ *             order     - [IN] the indexes of values to add                  *
+ *             order_num - [IN] the number of values to add                   *
+ *                                                                            *
+ * Comments: The shard must be locked by the caller.                          *
+ *           If the shard is full this function will wait until history       *
+ *           syncers processes values freeing enough space to store the new   *
+ *           value. Values that do not fit into the shard memory without any  *
+ *           other values are dropped.                                        *
+ *                                                                            *
+ * Return value: the number of dropped values                                 *
  *                                                                            *
  ******************************************************************************/
-static void	hc_add_item_values(dc_item_value_t *values, int values_num)
+static int	hc_add_item_values(int index, dc_item_value_t *values, const int *order, int order_num)
 {
 	dc_item_value_t	*item_value;
-	int		i;
+	int		i, dropped_num = 0;
 	zbx_hc_item_t	*item;
+	zbx_hc_shard_t	*shard = &cache->shards[index];
 
-	for (i = 0; i < values_num; i++)
+	for (i = 0; i < order_num; i++)
 	{
 		zbx_hc_data_t	*data = NULL;
 
-		item_value = &values[i];
+		item_value = &values[order[i]];
 
 		/* a record with metadata and no value can be dropped if  */
 		/* the metadata update is copied to the last queued value */
-		if (NULL != (item = hc_get_item(item_value->itemid)) && 0 != (item_value->flags & ZBX_DC_FLAG_NOVALUE))
+		if (NULL != (item = hc_get_item(shard, item_value->itemid)) &&
+				0 != (item_value->flags & ZBX_DC_FLAG_NOVALUE))
 		{
 			/* skip metadata updates when only one value is queued, */
 			/* because the item might be already being processed    */
@@ -2833,26 +3042,47 @@ static void	hc_add_item_values(dc_item_value_t *values, int values_num)
 			}
 		}
 
-		if (SUCCEED != hc_clone_history_data(&data, item_value))
+		if (SUCCEED != hc_clone_history_data(hc_mem[index], &shard->stats, &data, item_value))
 		{
-			do
+			int	ret = FAIL;
+
+			/* waiting makes sense only while there are values to be freed by history syncers */
+			while (0 != shard->values_num)
 			{
-				UNLOCK_CACHE;
+				UNLOCK_SHARD(index);
 
 				zabbix_log(LOG_LEVEL_DEBUG, "History cache is full. Sleeping for 1 second.");
 				sleep(1);
 
-				LOCK_CACHE;
+				LOCK_SHARD(index);
+
+				if (SUCCEED == (ret = hc_clone_history_data(hc_mem[index], &shard->stats, &data,
+						item_value)))
+				{
+					break;
+				}
+			}
+
+			if (SUCCEED != ret)
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "cannot store value of item " ZBX_FS_UI64 " in history"
+						" cache: value does not fit into history cache partition of "
+						ZBX_FS_UI64 " bytes", item_value->itemid, hc_mem[index]->total_size);
+
+				if (NULL != data)
+					hc_free_partial_data(hc_mem[index], data, item_value);
+
+				dropped_num++;
+				continue;
 			}
-			while (SUCCEED != hc_clone_history_data(&data, item_value));
 
-			item = hc_get_item(item_value->itemid);
+			item = hc_get_item(shard, item_value->itemid);
 		}
 
 		if (NULL == item)
 		{
-			item = hc_add_item(item_value->itemid, data);
-			hc_queue_item(item);
+			item = hc_add_item(shard, item_value->itemid, data);
+			hc_queue_item(shard, item);
 		}
 		else
 		{
@@ -2860,7 +3090,10 @@ static void	hc_add_item_values(dc_item_value_t *values, int values_num)
 			item->head = data;
 		}
 		item->values_num++;
+		shard->values_num++;
 	}
+
+	return dropped_num;
 }
 
 /******************************************************************************
@@ -2930,6 +3163,22 @@ static void	hc_copy_history_data(zbx_dc_history_t *history, zbx_uint64_t itemid,
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sets the history cache shard the calling history syncer pops      *
+ *          items from first                                                  *
+ *                                                                            *
+ * Parameters: process_num - [IN] the history syncer process number           *
+ *                                                                            *
+ * Comments: Shards are created per history syncer, so every shard is         *
+ *           preferred by at least one syncer.                                *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_hc_set_sync_shard(int process_num)
+{
+	hc_sync_shard = MAX(process_num - 1, 0);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: pops the next batch of history items from cache for processing    *
@@ -2937,25 +3186,43 @@ static void	hc_copy_history_data(zbx_dc_history_t *history, zbx_uint64_t itemid,
  * Parameters: history_items - [OUT] the locked history items                 *
  *                                                                            *
  * Comments: The history_items must be returned back to history cache with    *
- *           zbx_hc_push_items() function after they have been processed.         *
+ *           zbx_hc_push_items() function after they have been processed.     *
+ *           Items with the oldest values are taken from the syncer's own     *
+ *           shard first, then the remaining batch is filled from the other   *
+ *           shards in turn. Only one shard is locked at a time.              *
+ *           The history cache shards are locked internally.                  *
  *                                                                            *
  ******************************************************************************/
 void	zbx_hc_pop_items(zbx_vector_hc_item_ptr_t *history_items)
 {
 	zbx_binary_heap_elem_t	*elem;
-	zbx_hc_item_t		*item;
+	int			i, index;
 
-	while (ZBX_HC_SYNC_MAX > history_items->values_num && FAIL == zbx_binary_heap_empty(&cache->history_queue))
+	for (i = 0; i < hc_shards_num && ZBX_HC_SYNC_MAX > history_items->values_num; i++)
 	{
-		elem = zbx_binary_heap_find_min(&cache->history_queue);
-		item = elem->data;
-		zbx_vector_hc_item_ptr_append(history_items, item);
+		zbx_binary_heap_t	*queue;
+
+		index = (hc_sync_shard + i) % hc_shards_num;
+		queue = &cache->shards[index].history_queue;
+
+		LOCK_SHARD(index);
+
+		while (ZBX_HC_SYNC_MAX > history_items->values_num && SUCCEED != zbx_binary_heap_empty(queue))
+		{
+			elem = zbx_binary_heap_find_min(queue);
+			zbx_vector_hc_item_ptr_append(history_items, (zbx_hc_item_t *)elem->data);
+			zbx_binary_heap_remove_min(queue);
+		}
 
-		zbx_binary_heap_remove_min(&cache->history_queue);
+		UNLOCK_SHARD(index);
 	}
 
 	if (0 != history_items->values_num)
+	{
+		LOCK_CACHE;
 		cache->processing_num++;
+		UNLOCK_CACHE;
+	}
 }
 
 /******************************************************************************
@@ -2994,39 +3261,65 @@ void	zbx_hc_get_item_values(zbx_dc_history_t *history, zbx_vector_hc_item_ptr_t
  * Comments: This function removes processed value from history cache.        *
  *           If there is no more data for this item, then the item itself is  *
  *           removed from history index.                                      *
+ *           The history cache shards are locked internally.                  *
  *                                                                            *
  ******************************************************************************/
 void	zbx_hc_push_items(zbx_vector_hc_item_ptr_t *history_items)
 {
-	int		i;
+	int		i, index, *shards, *order, offsets[ZBX_HC_SHARDS_MAX + 1];
 	zbx_hc_item_t	*item;
 	zbx_hc_data_t	*data_free;
 
+	shards = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)history_items->values_num * 2);
+	order = shards + history_items->values_num;
+
 	for (i = 0; i < history_items->values_num; i++)
+		shards[i] = hc_shard_index(history_items->values[i]->itemid);
+
+	hc_group_by_shard(shards, history_items->values_num, order, offsets);
+
+	for (index = 0; index < hc_shards_num; index++)
 	{
-		item = history_items->values[i];
+		zbx_hc_shard_t	*shard = &cache->shards[index];
+
+		if (offsets[index] == offsets[index + 1])
+			continue;
+
+		LOCK_SHARD(index);
 
-		switch (item->status)
+		for (i = offsets[index]; i < offsets[index + 1]; i++)
 		{
-			case ZBX_HC_ITEM_STATUS_BUSY:
-				/* reset item status before returning it to queue */
-				item->status = ZBX_HC_ITEM_STATUS_NORMAL;
-				hc_queue_item(item);
-				break;
-			case ZBX_HC_ITEM_STATUS_NORMAL:
-				item->values_num--;
-				data_free = item->tail;
-				item->tail = item->tail->next;
-				hc_free_data(data_free);
-				if (NULL == item->tail)
-					zbx_hashset_remove(&cache->history_items, item);
-				else
-					hc_queue_item(item);
-				break;
+			item = history_items->values[order[i]];
+
+			switch (item->status)
+			{
+				case ZBX_HC_ITEM_STATUS_BUSY:
+					/* reset item status before returning it to queue */
+					item->status = ZBX_HC_ITEM_STATUS_NORMAL;
+					hc_queue_item(shard, item);
+					break;
+				case ZBX_HC_ITEM_STATUS_NORMAL:
+					item->values_num--;
+					shard->values_num--;
+					data_free = item->tail;
+					item->tail = item->tail->next;
+					hc_free_data(hc_mem[index], data_free);
+					if (NULL == item->tail)
+						zbx_hashset_remove(&shard->history_items, item);
+					else
+						hc_queue_item(shard, item);
+					break;
+			}
 		}
+
+		UNLOCK_SHARD(index);
 	}
 
+	zbx_free(shards);
+
+	LOCK_CACHE;
 	cache->processing_num--;
+	UNLOCK_CACHE;
 }
 
 /******************************************************************************
@@ -3036,7 +3329,16 @@ void	zbx_hc_push_items(zbx_vector_hc_item_ptr_t *history_items)
  ******************************************************************************/
 int	zbx_hc_queue_get_size(void)
 {
-	return cache->history_queue.elems_num;
+	int	i, size = 0;
+
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		LOCK_SHARD(i);
+		size += cache->shards[i].history_queue.elems_num;
+		UNLOCK_SHARD(i);
+	}
+
+	return size;
 }
 
 int	zbx_hc_get_history_compression_age(void)
@@ -3114,9 +3416,10 @@ out:
  ******************************************************************************/
 int	zbx_init_database_cache(zbx_get_program_type_f get_program_type, zbx_history_sync_f sync_history,
 		zbx_uint64_t history_cache_size, zbx_uint64_t history_index_cache_size,zbx_uint64_t *trends_cache_size,
-		char **error)
+		int history_syncers_num, int cache_slabs, char **error)
 {
-	int	ret;
+	int		ret, i;
+	zbx_uint64_t	index_shared_size, index_shards_size;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -3135,14 +3438,54 @@ int	zbx_init_database_cache(zbx_get_program_type_f get_program_type, zbx_history
 	if (SUCCEED != (ret = zbx_mutex_create(&cache_ids_lock, ZBX_MUTEX_CACHE_IDS, error)))
 		goto out;
 
-	if (SUCCEED != (ret = zbx_shmem_create(&hc_mem, history_cache_size, "history cache",
-			"HistoryCacheSize", 1, error)))
-	{
+	if (SUCCEED != (ret = zbx_mutex_create(&cache_index_lock, ZBX_MUTEX_CACHE_INDEX, error)))
 		goto out;
+
+	/* use a shard per history syncer, unless shards would get too small to hold larger values */
+	hc_shards_num = MIN(MAX(history_syncers_num, 1), ZBX_HC_SHARDS_MAX);
+
+	/* a part of index memory is kept for the cache header and proxy queue shared by all shards */
+	index_shared_size = MAX(history_index_cache_size / 16, ZBX_HC_INDEX_SHARD_SIZE_MIN);
+	index_shards_size = history_index_cache_size - MIN(index_shared_size, history_index_cache_size / 2);
+
+	while (1 < hc_shards_num && (history_cache_size / (zbx_uint64_t)hc_shards_num < ZBX_HC_SHARD_SIZE_MIN ||
+			index_shards_size / (zbx_uint64_t)hc_shards_num < ZBX_HC_INDEX_SHARD_SIZE_MIN))
+	{
+		hc_shards_num--;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() history cache shards:%d", __func__, hc_shards_num);
+
+	/* history cache memory is split evenly between shards, so that */
+	/* values can be allocated under the corresponding shard lock   */
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		if (SUCCEED != (ret = zbx_mutex_create(&shard_locks[i], (zbx_mutex_name_t)(ZBX_MUTEX_CACHE_SHARD_0 + i),
+				error)))
+		{
+			goto out;
+		}
+
+		if (SUCCEED != (ret = zbx_shmem_create(&hc_mem[i], history_cache_size / (zbx_uint64_t)hc_shards_num,
+				"history cache", "HistoryCacheSize", 1, error)))
+		{
+			goto out;
+		}
+
+		if (0 != cache_slabs)
+			zbx_shmem_enable_slabs(hc_mem[i]);
+
+		/* item index is split between shards as well, so it can be updated under the shard lock */
+		if (SUCCEED != (ret = zbx_shmem_create(&hc_shard_index_mem[i],
+				index_shards_size / (zbx_uint64_t)hc_shards_num, "history index cache",
+				"HistoryIndexCacheSize", 0, error)))
+		{
+			goto out;
+		}
 	}
 
-	if (SUCCEED != (ret = zbx_shmem_create(&hc_index_mem, history_index_cache_size, "history index cache",
-			"HistoryIndexCacheSize", 0, error)))
+	if (SUCCEED != (ret = zbx_shmem_create(&hc_index_mem, history_index_cache_size - index_shards_size,
+			"history index cache", "HistoryIndexCacheSize", 0, error)))
 	{
 		goto out;
 	}
@@ -3153,21 +3496,26 @@ int	zbx_init_database_cache(zbx_get_program_type_f get_program_type, zbx_history
 	ids = (ZBX_DC_IDS *)__hc_index_shmem_malloc_func(NULL, sizeof(ZBX_DC_IDS));
 	memset(ids, 0, sizeof(ZBX_DC_IDS));
 
-	zbx_hashset_create_ext(&cache->history_items, ZBX_HC_ITEMS_INIT_SIZE,
-			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
-			__hc_index_shmem_malloc_func, __hc_index_shmem_realloc_func, __hc_index_shmem_free_func);
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		const zbx_hc_shard_index_funcs_t	*funcs = &hc_shard_index_funcs[i];
 
-	zbx_binary_heap_create_ext(&cache->history_queue, hc_queue_elem_compare_func, ZBX_BINARY_HEAP_OPTION_EMPTY,
-			__hc_index_shmem_malloc_func, __hc_index_shmem_realloc_func, __hc_index_shmem_free_func);
+		zbx_hashset_create_ext(&cache->shards[i].history_items, ZBX_HC_ITEMS_INIT_SIZE / hc_shards_num,
+				ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
+				funcs->malloc_func, funcs->realloc_func, funcs->free_func);
+
+		zbx_binary_heap_create_ext(&cache->shards[i].history_queue, hc_queue_elem_compare_func,
+				ZBX_BINARY_HEAP_OPTION_EMPTY, funcs->malloc_func, funcs->realloc_func,
+				funcs->free_func);
+	}
 
 	if (0 != (get_program_type_cb() & ZBX_PROGRAM_TYPE_SERVER))
 	{
 		zbx_hashset_create_ext(&(cache->proxyqueue.index), ZBX_HC_SYNC_MAX,
 			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
-			__hc_index_shmem_malloc_func, __hc_index_shmem_realloc_func, __hc_index_shmem_free_func);
+			hc_index_malloc_func, hc_index_realloc_func, hc_index_free_func);
 
-		zbx_list_create_ext(&(cache->proxyqueue.list), __hc_index_shmem_malloc_func,
-				__hc_index_shmem_free_func);
+		zbx_list_create_ext(&(cache->proxyqueue.list), hc_index_malloc_func, hc_index_free_func);
 
 		cache->proxyqueue.state = ZBX_HC_PROXYQUEUE_STATE_NORMAL;
 
@@ -3179,6 +3527,12 @@ int	zbx_init_database_cache(zbx_get_program_type_f get_program_type, zbx_history
 	cache->history_num_total = 0;
 	cache->history_progress_ts = 0;
 
+	for (i = 0; i < ZBX_HC_SYNC_STAGE_COUNT; i++)
+		cache->sync_stage_time[i] = 0;
+
+	for (i = 0; i < ZBX_HC_TRIGGER_FUNCS_COUNT; i++)
+		cache->trigger_funcs_stats[i] = 0;
+
 	cache->db_trigger_queue_lock = 1;
 
 	if (NULL == sql)
@@ -3213,6 +3567,8 @@ static void	DCsync_all(const zbx_events_funcs_t *events_cbs, int config_history_
  ******************************************************************************/
 void	zbx_free_database_cache(int sync, const zbx_events_funcs_t *events_cbs, int config_history_storage_pipelines)
 {
+	int	i;
+
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	if (ZBX_SYNC_ALL == sync)
@@ -3220,13 +3576,21 @@ void	zbx_free_database_cache(int sync, const zbx_events_funcs_t *events_cbs, int
 
 	cache = NULL;
 
-	zbx_shmem_destroy(hc_mem);
-	hc_mem = NULL;
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		zbx_shmem_destroy(hc_mem[i]);
+		hc_mem[i] = NULL;
+		zbx_shmem_destroy(hc_shard_index_mem[i]);
+		hc_shard_index_mem[i] = NULL;
+		zbx_mutex_destroy(&shard_locks[i]);
+	}
+
 	zbx_shmem_destroy(hc_index_mem);
 	hc_index_mem = NULL;
 
 	zbx_mutex_destroy(&cache_lock);
 	zbx_mutex_destroy(&cache_ids_lock);
+	zbx_mutex_destroy(&cache_index_lock);
 
 	if (0 != (get_program_type_cb() & ZBX_PROGRAM_TYPE_SERVER))
 	{
@@ -3346,30 +3710,131 @@ out:
  ******************************************************************************/
 void	zbx_hc_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num)
 {
-	LOCK_CACHE;
+	int	i;
 
-	*values_num = cache->history_num;
-	*items_num = cache->history_items.num_data;
+	*items_num = 0;
 
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		LOCK_SHARD(i);
+		*items_num += cache->shards[i].history_items.num_data;
+		UNLOCK_SHARD(i);
+	}
+
+	LOCK_CACHE;
+	*values_num = cache->history_num;
 	UNLOCK_CACHE;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds shared memory allocator statistics of one memory segment to  *
+ *          the statistics of other segments                                  *
+ *                                                                            *
+ * Parameters: total     - [IN/OUT] the summary statistics                    *
+ *             stats     - [IN] the segment statistics                        *
+ *             heap_free - [IN/OUT] the free heap memory of summed segments   *
+ *             heap_frag - [IN/OUT] the free heap memory outside the largest  *
+ *                                  free chunks of summed segments            *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_shmem_stats_add(zbx_shmem_stats_t *total, const zbx_shmem_stats_t *stats, double *heap_free,
+		double *heap_frag)
+{
+	int	i;
+	double	free_size;
+
+	total->free_size += stats->free_size;
+	total->used_size += stats->used_size;
+	total->overhead += stats->overhead;
+	total->free_chunks += stats->free_chunks;
+	total->used_chunks += stats->used_chunks;
+
+	if (0 != stats->free_chunks && (0 == total->min_chunk_size || stats->min_chunk_size < total->min_chunk_size))
+		total->min_chunk_size = stats->min_chunk_size;
+
+	total->max_chunk_size = MAX(total->max_chunk_size, stats->max_chunk_size);
+
+	for (i = 0; i < ZBX_SHMEM_BUCKET_COUNT; i++)
+		total->chunks_num[i] += stats->chunks_num[i];
+
+	free_size = (double)(stats->free_size - stats->slab_free_size);
+	*heap_free += free_size;
+	*heap_frag += free_size * stats->heap_fragmentation / 100;
+
+	if (0 == stats->slabs_enabled)
+		return;
+
+	total->slabs_enabled = 1;
+	total->slabs_num += stats->slabs_num;
+	total->slab_size += stats->slab_size;
+	total->slab_free_size += stats->slab_free_size;
+
+	for (i = 0; i < ZBX_SHMEM_SLAB_CLASS_COUNT; i++)
+	{
+		total->slab_classes[i].object_size = stats->slab_classes[i].object_size;
+		total->slab_classes[i].slabs_num += stats->slab_classes[i].slabs_num;
+		total->slab_classes[i].used_objects += stats->slab_classes[i].used_objects;
+		total->slab_classes[i].free_objects += stats->slab_classes[i].free_objects;
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: get shared memory allocator statistics                            *
  *                                                                            *
+ * Comments: The data statistics are summed over all history cache shards,    *
+ *           the index statistics also include the shared index memory.       *
+ *                                                                            *
  ******************************************************************************/
 void	zbx_hc_get_mem_stats(zbx_shmem_stats_t *data, zbx_shmem_stats_t *index)
 {
-	LOCK_CACHE;
+	int			i;
+	zbx_shmem_stats_t	stats;
+	double			heap_free = 0, heap_frag = 0;
 
 	if (NULL != data)
-		zbx_shmem_get_stats(hc_mem, data);
+	{
+		memset(data, 0, sizeof(zbx_shmem_stats_t));
+
+		for (i = 0; i < hc_shards_num; i++)
+		{
+			LOCK_SHARD(i);
+			zbx_shmem_get_stats(hc_mem[i], &stats);
+			UNLOCK_SHARD(i);
+
+			hc_shmem_stats_add(data, &stats, &heap_free, &heap_frag);
+		}
+
+		data->heap_fragmentation = (0 != heap_free ? 100 * heap_frag / heap_free : 0);
+
+		if (0 != data->slab_size)
+			data->slab_fragmentation = 100.0 * (double)data->slab_free_size / data->slab_size;
+	}
 
 	if (NULL != index)
-		zbx_shmem_get_stats(hc_index_mem, index);
+	{
+		memset(index, 0, sizeof(zbx_shmem_stats_t));
+		heap_free = 0;
+		heap_frag = 0;
 
-	UNLOCK_CACHE;
+		LOCK_CACHE_INDEX;
+		zbx_shmem_get_stats(hc_index_mem, &stats);
+		UNLOCK_CACHE_INDEX;
+
+		hc_shmem_stats_add(index, &stats, &heap_free, &heap_frag);
+
+		for (i = 0; i < hc_shards_num; i++)
+		{
+			LOCK_SHARD(i);
+			zbx_shmem_get_stats(hc_shard_index_mem[i], &stats);
+			UNLOCK_SHARD(i);
+
+			hc_shmem_stats_add(index, &stats, &heap_free, &heap_frag);
+		}
+
+		index->heap_fragmentation = (0 != heap_free ? 100 * heap_frag / heap_free : 0);
+	}
 }
 
 /******************************************************************************
@@ -3381,21 +3846,136 @@ void	zbx_hc_get_items(zbx_vector_uint64_pair_t *items)
 {
 	zbx_hashset_iter_t	iter;
 	zbx_hc_item_t		*item;
+	int			i;
 
-	LOCK_CACHE;
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		zbx_hc_shard_t	*shard = &cache->shards[i];
+
+		LOCK_SHARD(i);
 
-	zbx_vector_uint64_pair_reserve(items, cache->history_items.num_data);
+		zbx_vector_uint64_pair_reserve(items, (size_t)(items->values_num + shard->history_items.num_data));
 
-	zbx_hashset_iter_reset(&cache->history_items, &iter);
-	while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
+		zbx_hashset_iter_reset(&shard->history_items, &iter);
+		while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
+		{
+			zbx_uint64_pair_t	pair = {item->itemid, item->values_num};
+			zbx_vector_uint64_pair_append_ptr(items, &pair);
+		}
+
+		UNLOCK_SHARD(i);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get fill levels of history cache shards                           *
+ *                                                                            *
+ * Parameters: stats - [OUT] the shard statistics, ZBX_HC_SHARDS_MAX entries  *
+ *                                                                            *
+ * Return value: the number of history cache shards                           *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_hc_get_shard_stats(zbx_hc_shard_stats_t *stats)
+{
+	int	i;
+
+	for (i = 0; i < hc_shards_num; i++)
 	{
-		zbx_uint64_pair_t	pair = {item->itemid, item->values_num};
-		zbx_vector_uint64_pair_append_ptr(items, &pair);
+		zbx_hc_shard_t	*shard = &cache->shards[i];
+
+		LOCK_SHARD(i);
+
+		stats[i].items_num = (zbx_uint64_t)shard->history_items.num_data;
+		stats[i].values_num = (zbx_uint64_t)shard->values_num;
+		stats[i].queue_num = (zbx_uint64_t)shard->history_queue.elems_num;
+		stats[i].mem_used = hc_mem[i]->total_size - hc_mem[i]->free_size;
+		stats[i].mem_total = hc_mem[i]->total_size;
+
+		UNLOCK_SHARD(i);
 	}
 
+	return hc_shards_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds time spent in history synchronization stages                 *
+ *                                                                            *
+ * Parameters: stage_time - [IN] the time in seconds spent in each stage,     *
+ *                               ZBX_HC_SYNC_STAGE_COUNT entries              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_hc_add_sync_stage_time(const double *stage_time)
+{
+	int	i;
+
+	LOCK_CACHE;
+
+	for (i = 0; i < ZBX_HC_SYNC_STAGE_COUNT; i++)
+		cache->sync_stage_time[i] += stage_time[i];
+
+	UNLOCK_CACHE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets total time spent by history syncers in the specified         *
+ *          synchronization stage                                             *
+ *                                                                            *
+ * Parameters: stage - [IN] the synchronization stage (ZBX_HC_SYNC_STAGE_*)   *
+ *                                                                            *
+ * Return value: the time in seconds                                          *
+ *                                                                            *
+ ******************************************************************************/
+double	zbx_hc_get_sync_stage_time(int stage)
+{
+	double	value;
+
+	LOCK_CACHE;
+	value = cache->sync_stage_time[stage];
+	UNLOCK_CACHE;
+
+	return value;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds trigger function counters of a synchronized trigger batch    *
+ *                                                                            *
+ * Parameters: stats - [IN] the counters, ZBX_HC_TRIGGER_FUNCS_COUNT entries  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_hc_add_trigger_funcs_stats(const zbx_uint64_t *stats)
+{
+	int	i;
+
+	LOCK_CACHE;
+
+	for (i = 0; i < ZBX_HC_TRIGGER_FUNCS_COUNT; i++)
+		cache->trigger_funcs_stats[i] += stats[i];
+
 	UNLOCK_CACHE;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets total trigger function counter of history syncers            *
+ *                                                                            *
+ * Parameters: counter - [IN] the counter (ZBX_HC_TRIGGER_FUNCS_*)            *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint64_t	zbx_hc_get_trigger_funcs_stats(int counter)
+{
+	zbx_uint64_t	value;
+
+	LOCK_CACHE;
+	value = cache->trigger_funcs_stats[counter];
+	UNLOCK_CACHE;
+
+	return value;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: checks if database trigger queue table is locked                  *
@@ -3513,9 +4093,30 @@ int	zbx_dbcache_get_history_num(void)
 	return cache->history_num;
 }
 
-zbx_shmem_info_t	*zbx_dbcache_get_hc_mem(void)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns the highest history cache shard memory usage in percent   *
+ *                                                                            *
+ * Comments: Values are stored in the shard memory of the item, so incoming   *
+ *           data can be blocked as soon as any of the shards gets full.      *
+ *                                                                            *
+ ******************************************************************************/
+double	zbx_dbcache_get_hc_pused(void)
 {
-	return hc_mem;
+	int	i;
+	double	pused, pused_max = 0;
+
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		LOCK_SHARD(i);
+		pused = 100 * (double)(hc_mem[i]->total_size - hc_mem[i]->free_size) / hc_mem[i]->total_size;
+		UNLOCK_SHARD(i);
+
+		if (pused > pused_max)
+			pused_max = pused;
+	}
+
+	return pused_max;
 }
 
 void	zbx_dbcache_setproxyqueue_state(int proxyqueue_state)
@@ -105,11 +105,26 @@ typedef struct zbx_vc_chunk
 	/* the number of item value slots in chunk */
 	int			slots_num;
 
+	/* The size of encoded value data for compact chunks or 0 for   */
+	/* chunks storing history records in slots. Compact chunks hold */
+	/* delta-of-delta encoded timestamps and XOR/delta encoded      */
+	/* numeric values in place of slots and are never modified,     */
+	/* except for removing values from the beginning.               */
+	int			data_size;
+
+	/* the compact chunk identifier, used to validate decoded data  */
+	zbx_uint64_t		id;
+
+	/* the value type of compact chunk data                         */
+	unsigned char		value_type;
+
 	/* the item value data */
 	zbx_history_record_t	slots[1];
 }
 zbx_vc_chunk_t;
 
+#define vch_chunk_is_compact(chunk)	(0 != (chunk)->data_size)
+
 /* min/max number of item history values to store in chunk */
 
 #define ZBX_VC_MIN_CHUNK_RECORDS	2
@@ -118,6 +133,9 @@ zbx_vc_chunk_t;
 #define ZBX_VC_MAX_CHUNK_RECORDS	((64 * ZBX_KIBIBYTE - sizeof(zbx_vc_chunk_t)) / \
 		sizeof(zbx_history_record_t) + 1)
 
+/* the minimum number of values in chunk to be compacted, smaller chunks are kept as is */
+#define ZBX_VC_MIN_COMPACT_RECORDS	16
+
 /* the value cache item data */
 typedef struct
 {
@@ -209,6 +227,12 @@ typedef struct
 
 	/* the string pool for str, text and log item values */
 	zbx_hashset_t	strpool;
+
+	/* 1 - numeric item history chunks are compacted, 0 - otherwise */
+	int		compression;
+
+	/* the last assigned compact chunk identifier */
+	zbx_uint64_t	last_chunkid;
 }
 zbx_vc_cache_t;
 
@@ -925,6 +949,69 @@ static void	vc_history_record_vector_append(zbx_vector_history_record_t *vector,
 	zbx_vector_history_record_append_ptr(vector, &record);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds value to the aggregate                                       *
+ *                                                                            *
+ * Parameters: aggregate  - [IN/OUT]                                          *
+ *             value_type - [IN] the value type (see ITEM_VALUE_TYPE_* defs)  *
+ *             value      - [IN] the value to add                             *
+ *                                                                            *
+ * Comments: Values must be added in descending timestamp order, so results   *
+ *           match aggregation of the zbx_vc_get_values() output. For         *
+ *           unsigned values the average field holds the sum of values until  *
+ *           aggregation is finished by vc_aggregate_finish().                *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_aggregate_add(zbx_vc_aggregate_t *aggregate, int value_type, const zbx_history_value_t *value)
+{
+	int	num = aggregate->values_num++;
+
+	switch (value_type)
+	{
+		case ITEM_VALUE_TYPE_FLOAT:
+			if (0 == num || value->dbl < aggregate->min.dbl)
+				aggregate->min.dbl = value->dbl;
+
+			if (0 == num || value->dbl > aggregate->max.dbl)
+				aggregate->max.dbl = value->dbl;
+
+			aggregate->sum.dbl += value->dbl;
+			aggregate->avg += value->dbl / (num + 1) - aggregate->avg / (num + 1);
+			break;
+		case ITEM_VALUE_TYPE_UINT64:
+			if (0 == num || value->ui64 < aggregate->min.ui64)
+				aggregate->min.ui64 = value->ui64;
+
+			if (0 == num || value->ui64 > aggregate->max.ui64)
+				aggregate->max.ui64 = value->ui64;
+
+			aggregate->sum.ui64 += value->ui64;
+			aggregate->avg += (double)value->ui64;
+			break;
+	}
+}
+
+static void	vc_aggregate_finish(zbx_vc_aggregate_t *aggregate, int value_type)
+{
+	if (ITEM_VALUE_TYPE_UINT64 == value_type && 0 != aggregate->values_num)
+		aggregate->avg /= aggregate->values_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds value either to value vector or to the aggregate             *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_values_add(zbx_vector_history_record_t *values, zbx_vc_aggregate_t *aggregate, int value_type,
+		zbx_history_record_t *value)
+{
+	if (NULL != values)
+		vc_history_record_vector_append(values, value_type, value);
+	else
+		vc_aggregate_add(aggregate, value_type, &value->value);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: allocate cache memory to store item's resources                   *
@@ -1265,8 +1352,541 @@ static void	vc_item_update_db_cached_from(zbx_vc_item_t *item, int timestamp)
  *
  * After adding a new chunk, the older chunks (outside the largest request
  * range) are automatically removed from cache.
+ *
+ * When value cache compression is enabled the full chunks of numeric items,
+ * except the head chunk, are replaced with compact chunks. Compact chunks store
+ * values as a bit stream:
+ *   first value    - 32 bits seconds, 30 bits nanoseconds, 64 bits value
+ *   next values    - seconds as zigzag encoded delta-of-delta:
+ *                      '0'                - 0
+ *                      '10'   + 7 bits    - less than 2^7
+ *                      '110'  + 9 bits    - less than 2^9
+ *                      '1110' + 12 bits   - less than 2^12
+ *                      '1111' + 64 bits   - otherwise
+ *                    nanoseconds:
+ *                      '0'                - same as the previous value
+ *                      '1'    + 30 bits   - otherwise
+ *                    float values XOR-ed with the previous value:
+ *                      '0'                - same as the previous value
+ *                      '10'   + N bits    - meaningful bits within the previous leading/trailing
+ *                                           zero bit window
+ *                      '11'   + 6 bits leading zero count + 6 bits meaningful bit count - 1 +
+ *                               meaningful bits
+ *                    unsigned values as zigzag encoded delta-of-delta with the same prefixes
+ *                    as seconds and 8, 16, 32 and 64 bit values
+ *
+ * Compact chunks are decoded on read into a small process local LRU cache of
+ * decoded chunks, so alternating accesses to a few chunks (for example head and
+ * tail) do not decode them again. Compact chunks are expanded back to history
+ * record slots if values must be inserted in them.
  */
 
+typedef struct
+{
+	unsigned char	*data;
+	size_t		data_alloc;
+	size_t		bits_num;
+}
+zbx_vc_bitstream_t;
+
+/* decoded compact chunk */
+typedef struct
+{
+	zbx_uint64_t		chunkid;
+	zbx_uint64_t		lastaccess;
+	zbx_history_record_t	*slots;
+	int			slots_alloc;
+}
+zbx_vc_chunk_decoded_t;
+
+#define VC_DECODED_CHUNKS_NUM	4
+
+/* the recently decoded compact chunks, the least recently accessed chunk is replaced on miss */
+static ZBX_THREAD_LOCAL zbx_vc_chunk_decoded_t	vc_decoded[VC_DECODED_CHUNKS_NUM];
+static ZBX_THREAD_LOCAL zbx_uint64_t		vc_decoded_access;
+
+static const int	vc_ts_buckets[] = {7, 9, 12};
+static const int	vc_ui64_buckets[] = {8, 16, 32};
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: resets bit stream for writing                                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_bitstream_reset(zbx_vc_bitstream_t *bs)
+{
+	if (0 != bs->bits_num)
+		memset(bs->data, 0, (bs->bits_num + 7) / 8);
+
+	bs->bits_num = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes the specified number of lowest value bits into bit stream  *
+ *                                                                            *
+ * Parameters: bs    - [IN/OUT] the bit stream                                *
+ *             value - [IN] the value to write                                *
+ *             bits  - [IN] the number of bits to write (1-64)                *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_bitstream_write(zbx_vc_bitstream_t *bs, zbx_uint64_t value, int bits)
+{
+	while (0 < bits)
+	{
+		size_t	byte = bs->bits_num >> 3;
+		int	offset = (int)(bs->bits_num & 7), n = MIN(8 - offset, bits);
+
+		if (byte >= bs->data_alloc)
+		{
+			size_t	data_alloc = bs->data_alloc;
+
+			bs->data_alloc = (0 == data_alloc ? ZBX_KIBIBYTE : data_alloc * 2);
+			bs->data = (unsigned char *)zbx_realloc(bs->data, bs->data_alloc);
+			memset(bs->data + data_alloc, 0, bs->data_alloc - data_alloc);
+		}
+
+		bits -= n;
+		bs->data[byte] |= (unsigned char)(((value >> bits) & ((1u << n) - 1)) << (8 - offset - n));
+		bs->bits_num += (size_t)n;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads the specified number of bits from bit stream                *
+ *                                                                            *
+ * Parameters: data   - [IN] the bit stream data                              *
+ *             offset - [IN/OUT] the bit offset in stream                     *
+ *             bits   - [IN] the number of bits to read (1-64)                *
+ *                                                                            *
+ * Return value: the read value                                               *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	vc_bitstream_read(const unsigned char *data, size_t *offset, int bits)
+{
+	zbx_uint64_t	value = 0;
+
+	while (0 < bits)
+	{
+		int	off = (int)(*offset & 7), n = MIN(8 - off, bits);
+
+		value = (value << n) | (zbx_uint64_t)((data[*offset >> 3] >> (8 - off - n)) & ((1u << n) - 1));
+		bits -= n;
+		*offset += (size_t)n;
+	}
+
+	return value;
+}
+
+static zbx_uint64_t	vc_zigzag_encode(zbx_int64_t value)
+{
+	return 0 > value ? ~((zbx_uint64_t)value << 1) : (zbx_uint64_t)value << 1;
+}
+
+static zbx_int64_t	vc_zigzag_decode(zbx_uint64_t value)
+{
+	return (zbx_int64_t)((value >> 1) ^ (~(value & 1) + 1));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes unsigned value with variable length prefix                 *
+ *                                                                            *
+ * Parameters: bs      - [IN/OUT] the bit stream                              *
+ *             value   - [IN] the value to write                              *
+ *             buckets - [IN] the value bit sizes for '10', '110' and '1110'  *
+ *                            prefixes                                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_bitstream_write_bucket(zbx_vc_bitstream_t *bs, zbx_uint64_t value, const int *buckets)
+{
+	int	i;
+
+	if (0 == value)
+	{
+		vc_bitstream_write(bs, 0, 1);
+		return;
+	}
+
+	for (i = 0; i < 3; i++)
+	{
+		if (value < (__UINT64_C(1) << buckets[i]))
+		{
+			/* write i + 1 set bits followed by zero bit */
+			vc_bitstream_write(bs, ((__UINT64_C(1) << (i + 1)) - 1) << 1, i + 2);
+			vc_bitstream_write(bs, value, buckets[i]);
+			return;
+		}
+	}
+
+	vc_bitstream_write(bs, 0xf, 4);
+	vc_bitstream_write(bs, value, 64);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads unsigned value with variable length prefix                  *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	vc_bitstream_read_bucket(const unsigned char *data, size_t *offset, const int *buckets)
+{
+	int	i;
+
+	for (i = 0; i < 4; i++)
+	{
+		if (0 == vc_bitstream_read(data, offset, 1))
+			break;
+	}
+
+	if (0 == i)
+		return 0;
+
+	return vc_bitstream_read(data, offset, 4 == i ? 64 : buckets[i - 1]);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: encodes numeric history values into bit stream                    *
+ *                                                                            *
+ * Parameters: bs         - [OUT] the bit stream                              *
+ *             value_type - [IN] the value type (ITEM_VALUE_TYPE_FLOAT or     *
+ *                               ITEM_VALUE_TYPE_UINT64)                      *
+ *             values     - [IN] the values to encode                         *
+ *             values_num - [IN] the number of values to encode               *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_chunk_encode(zbx_vc_bitstream_t *bs, unsigned char value_type, const zbx_history_record_t *values,
+		int values_num)
+{
+	zbx_int64_t	delta_prev = 0;
+	zbx_uint64_t	value_prev, value_delta_prev = 0;
+	int		i, lz_prev = -1, tz_prev = 0;
+
+	vc_bitstream_reset(bs);
+
+	if (ITEM_VALUE_TYPE_FLOAT == value_type)
+		memcpy(&value_prev, &values[0].value.dbl, sizeof(value_prev));
+	else
+		value_prev = values[0].value.ui64;
+
+	vc_bitstream_write(bs, (zbx_uint64_t)values[0].timestamp.sec, 32);
+	vc_bitstream_write(bs, (zbx_uint64_t)values[0].timestamp.ns, 30);
+	vc_bitstream_write(bs, value_prev, 64);
+
+	for (i = 1; i < values_num; i++)
+	{
+		zbx_int64_t	delta;
+		zbx_uint64_t	value;
+
+		delta = (zbx_int64_t)values[i].timestamp.sec - values[i - 1].timestamp.sec;
+		vc_bitstream_write_bucket(bs, vc_zigzag_encode(delta - delta_prev), vc_ts_buckets);
+		delta_prev = delta;
+
+		if (values[i].timestamp.ns == values[i - 1].timestamp.ns)
+		{
+			vc_bitstream_write(bs, 0, 1);
+		}
+		else
+		{
+			vc_bitstream_write(bs, 1, 1);
+			vc_bitstream_write(bs, (zbx_uint64_t)values[i].timestamp.ns, 30);
+		}
+
+		if (ITEM_VALUE_TYPE_FLOAT == value_type)
+		{
+			zbx_uint64_t	xor;
+			int		lz, tz;
+
+			memcpy(&value, &values[i].value.dbl, sizeof(value));
+
+			if (0 == (xor = value ^ value_prev))
+			{
+				vc_bitstream_write(bs, 0, 1);
+			}
+			else
+			{
+				for (lz = 0; 0 == (xor & (__UINT64_C(1) << (63 - lz))); lz++)
+					;
+
+				for (tz = 0; 0 == (xor & (__UINT64_C(1) << tz)); tz++)
+					;
+
+				if (-1 != lz_prev && lz >= lz_prev && tz >= tz_prev)
+				{
+					vc_bitstream_write(bs, 2, 2);
+					vc_bitstream_write(bs, xor >> tz_prev, 64 - lz_prev - tz_prev);
+				}
+				else
+				{
+					vc_bitstream_write(bs, 3, 2);
+					vc_bitstream_write(bs, (zbx_uint64_t)lz, 6);
+					vc_bitstream_write(bs, (zbx_uint64_t)(64 - lz - tz - 1), 6);
+					vc_bitstream_write(bs, xor >> tz, 64 - lz - tz);
+
+					lz_prev = lz;
+					tz_prev = tz;
+				}
+			}
+		}
+		else
+		{
+			zbx_uint64_t	value_delta;
+
+			value = values[i].value.ui64;
+			value_delta = value - value_prev;
+			vc_bitstream_write_bucket(bs, vc_zigzag_encode((zbx_int64_t)(value_delta - value_delta_prev)),
+					vc_ui64_buckets);
+			value_delta_prev = value_delta;
+		}
+
+		value_prev = value;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: decodes numeric history values from bit stream                    *
+ *                                                                            *
+ * Parameters: data       - [IN] the encoded data                             *
+ *             value_type - [IN] the value type (ITEM_VALUE_TYPE_FLOAT or     *
+ *                               ITEM_VALUE_TYPE_UINT64)                      *
+ *             values     - [OUT] the decoded values                          *
+ *             values_num - [IN] the number of values to decode               *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_chunk_decode(const unsigned char *data, unsigned char value_type, zbx_history_record_t *values,
+		int values_num)
+{
+	zbx_int64_t	delta = 0;
+	zbx_uint64_t	value, value_delta = 0;
+	size_t		offset = 0;
+	int		i, lz = 0, tz = 0;
+
+	values[0].timestamp.sec = (int)vc_bitstream_read(data, &offset, 32);
+	values[0].timestamp.ns = (int)vc_bitstream_read(data, &offset, 30);
+	value = vc_bitstream_read(data, &offset, 64);
+
+	if (ITEM_VALUE_TYPE_FLOAT == value_type)
+		memcpy(&values[0].value.dbl, &value, sizeof(value));
+	else
+		values[0].value.ui64 = value;
+
+	for (i = 1; i < values_num; i++)
+	{
+		delta += vc_zigzag_decode(vc_bitstream_read_bucket(data, &offset, vc_ts_buckets));
+		values[i].timestamp.sec = (int)(values[i - 1].timestamp.sec + delta);
+
+		if (0 == vc_bitstream_read(data, &offset, 1))
+			values[i].timestamp.ns = values[i - 1].timestamp.ns;
+		else
+			values[i].timestamp.ns = (int)vc_bitstream_read(data, &offset, 30);
+
+		if (ITEM_VALUE_TYPE_FLOAT == value_type)
+		{
+			if (0 != vc_bitstream_read(data, &offset, 1))
+			{
+				if (0 != vc_bitstream_read(data, &offset, 1))
+				{
+					lz = (int)vc_bitstream_read(data, &offset, 6);
+					tz = 64 - lz - (int)vc_bitstream_read(data, &offset, 6) - 1;
+				}
+
+				value ^= vc_bitstream_read(data, &offset, 64 - lz - tz) << tz;
+			}
+
+			memcpy(&values[i].value.dbl, &value, sizeof(value));
+		}
+		else
+		{
+			value_delta += (zbx_uint64_t)vc_zigzag_decode(vc_bitstream_read_bucket(data, &offset,
+					vc_ui64_buckets));
+			value += value_delta;
+			values[i].value.ui64 = value;
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets chunk history record slots                                   *
+ *                                                                            *
+ * Parameters: chunk - [IN] the chunk                                         *
+ *                                                                            *
+ * Return value: The chunk slots.                                             *
+ *                                                                            *
+ * Comments: Compact chunks are decoded into process local LRU cache, so the   *
+ *           returned slots are valid only until VC_DECODED_CHUNKS_NUM other  *
+ *           compact chunks are accessed.                                     *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_history_record_t	*vch_chunk_slots(const zbx_vc_chunk_t *chunk)
+{
+	zbx_vc_chunk_decoded_t	*decoded = &vc_decoded[0];
+
+	if (!vch_chunk_is_compact(chunk))
+		return (zbx_history_record_t *)chunk->slots;
+
+	for (int i = 0; i < VC_DECODED_CHUNKS_NUM; i++)
+	{
+		if (chunk->id == vc_decoded[i].chunkid)
+		{
+			decoded = &vc_decoded[i];
+			goto out;
+		}
+
+		if (vc_decoded[i].lastaccess < decoded->lastaccess)
+			decoded = &vc_decoded[i];
+	}
+
+	if (decoded->slots_alloc < chunk->slots_num)
+	{
+		decoded->slots_alloc = chunk->slots_num;
+		decoded->slots = (zbx_history_record_t *)zbx_realloc(decoded->slots,
+				sizeof(zbx_history_record_t) * (size_t)decoded->slots_alloc);
+	}
+
+	vc_chunk_decode((const unsigned char *)chunk->slots, chunk->value_type, decoded->slots, chunk->slots_num);
+	decoded->chunkid = chunk->id;
+out:
+	decoded->lastaccess = ++vc_decoded_access;
+
+	return decoded->slots;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees decoded compact chunk cache                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_decoded_clear(void)
+{
+	for (int i = 0; i < VC_DECODED_CHUNKS_NUM; i++)
+	{
+		zbx_free(vc_decoded[i].slots);
+		vc_decoded[i].slots_alloc = 0;
+		vc_decoded[i].chunkid = 0;
+		vc_decoded[i].lastaccess = 0;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets the size of chunk in cache                                   *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	vch_chunk_size(const zbx_vc_chunk_t *chunk)
+{
+	if (vch_chunk_is_compact(chunk))
+		return offsetof(zbx_vc_chunk_t, slots) + (size_t)chunk->data_size;
+
+	return sizeof(zbx_vc_chunk_t) + (size_t)(chunk->slots_num - 1) * sizeof(zbx_history_record_t);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: replaces item history data chunk with another chunk               *
+ *                                                                            *
+ * Parameters: item  - [IN/OUT] the chunk owner item                          *
+ *             chunk - [IN] the chunk to replace, it is freed afterwards      *
+ *             dst   - [IN] the new chunk                                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_replace_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk, zbx_vc_chunk_t *dst)
+{
+	dst->prev = chunk->prev;
+	dst->next = chunk->next;
+
+	if (NULL != chunk->prev)
+		chunk->prev->next = dst;
+	else
+		item->tail = dst;
+
+	if (NULL != chunk->next)
+		chunk->next->prev = dst;
+	else
+		item->head = dst;
+
+	__vc_shmem_free_func(chunk);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: replaces numeric item history data chunk with compact chunk       *
+ *                                                                            *
+ * Parameters: item  - [IN/OUT] the chunk owner item                          *
+ *             chunk - [IN] the chunk to compact                              *
+ *                                                                            *
+ * Comments: The chunk is left as is if compression is disabled, the chunk is *
+ *           too small or there is not enough memory for compact chunk.       *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_compact_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
+{
+	static ZBX_THREAD_LOCAL zbx_vc_bitstream_t	bs;
+	zbx_vc_chunk_t					*compact;
+	int						values_num;
+	size_t						size;
+
+	if (0 == vc_cache->compression || vch_chunk_is_compact(chunk))
+		return;
+
+	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
+		return;
+
+	if (ZBX_VC_MIN_COMPACT_RECORDS > (values_num = chunk->last_value - chunk->first_value + 1))
+		return;
+
+	vc_chunk_encode(&bs, item->value_type, chunk->slots + chunk->first_value, values_num);
+
+	if ((size = offsetof(zbx_vc_chunk_t, slots) + (bs.bits_num + 7) / 8) >= vch_chunk_size(chunk))
+		return;
+
+	if (NULL == (compact = (zbx_vc_chunk_t *)__vc_shmem_malloc_func(NULL, size)))
+		return;
+
+	compact->first_value = 0;
+	compact->last_value = values_num - 1;
+	compact->slots_num = values_num;
+	compact->data_size = (int)((bs.bits_num + 7) / 8);
+	compact->id = ++vc_cache->last_chunkid;
+	compact->value_type = item->value_type;
+	memcpy(compact->slots, bs.data, (size_t)compact->data_size);
+
+	vch_item_replace_chunk(item, chunk, compact);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: replaces compact chunk with chunk storing history record slots    *
+ *                                                                            *
+ * Parameters: item  - [IN/OUT] the chunk owner item                          *
+ *             chunk - [IN] the compact chunk                                 *
+ *                                                                            *
+ * Return value: The expanded chunk or NULL if there is not enough memory.    *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_vc_chunk_t	*vch_item_expand_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
+{
+	zbx_vc_chunk_t	*expanded;
+
+	if (NULL == (expanded = (zbx_vc_chunk_t *)vc_item_malloc(item, sizeof(zbx_vc_chunk_t) +
+			sizeof(zbx_history_record_t) * (size_t)(chunk->slots_num - 1))))
+	{
+		return NULL;
+	}
+
+	memset(expanded, 0, sizeof(zbx_vc_chunk_t));
+	expanded->first_value = chunk->first_value;
+	expanded->last_value = chunk->last_value;
+	expanded->slots_num = chunk->slots_num;
+	memcpy(expanded->slots, vch_chunk_slots(chunk), sizeof(zbx_history_record_t) * (size_t)chunk->slots_num);
+
+	vch_item_replace_chunk(item, chunk, expanded);
+
+	return expanded;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: updates item range with current request range                     *
@@ -1293,7 +1913,7 @@ static void	vch_item_update_range(zbx_vc_item_t *item, int range, int now)
 		diff += 0xff;
 
 	if (NULL != item->head)
-		last_value_timestamp = item->head->slots[item->head->last_value].timestamp.sec;
+		last_value_timestamp = vch_chunk_slots(item->head)[item->head->last_value].timestamp.sec;
 	else
 		last_value_timestamp = now;
 
@@ -1412,10 +2032,11 @@ static int	vch_item_add_chunk(zbx_vc_item_t *item, int nslots, zbx_vc_chunk_t *i
  ******************************************************************************/
 static int	vch_chunk_find_last_value_before(const zbx_vc_chunk_t *chunk, const zbx_timespec_t *ts)
 {
-	int	start = chunk->first_value, end = chunk->last_value, middle;
+	int			start = chunk->first_value, end = chunk->last_value, middle;
+	zbx_history_record_t	*slots = vch_chunk_slots(chunk);
 
 	/* check if the last value timestamp is already greater or equal to the specified timestamp */
-	if (0 >= zbx_timespec_compare(&chunk->slots[end].timestamp, ts))
+	if (0 >= zbx_timespec_compare(&slots[end].timestamp, ts))
 		return end;
 
 	/* chunk contains only one value, which did not pass the above check, return failure */
@@ -1427,13 +2048,13 @@ static int	vch_chunk_find_last_value_before(const zbx_vc_chunk_t *chunk, const z
 	{
 		middle = start + (end - start) / 2;
 
-		if (0 < zbx_timespec_compare(&chunk->slots[middle].timestamp, ts))
+		if (0 < zbx_timespec_compare(&slots[middle].timestamp, ts))
 		{
 			end = middle;
 			continue;
 		}
 
-		if (0 >= zbx_timespec_compare(&chunk->slots[middle + 1].timestamp, ts))
+		if (0 >= zbx_timespec_compare(&slots[middle + 1].timestamp, ts))
 		{
 			start = middle;
 			continue;
@@ -1475,9 +2096,9 @@ static int	vch_item_get_last_value(const zbx_vc_item_t *item, const zbx_timespec
 
 	index = chunk->last_value;
 
-	if (0 < zbx_timespec_compare(&chunk->slots[index].timestamp, ts))
+	if (0 < zbx_timespec_compare(&vch_chunk_slots(chunk)[index].timestamp, ts))
 	{
-		while (0 < zbx_timespec_compare(&chunk->slots[chunk->first_value].timestamp, ts))
+		while (0 < zbx_timespec_compare(&vch_chunk_slots(chunk)[chunk->first_value].timestamp, ts))
 		{
 			chunk = chunk->prev;
 			/* there are no values for requested range, return failure */
@@ -1615,7 +2236,7 @@ static size_t	vch_item_free_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
 {
 	size_t	freed;
 
-	freed = sizeof(zbx_vc_chunk_t) + (size_t)(chunk->slots_num - 1) * sizeof(zbx_history_record_t);
+	freed = vch_chunk_size(chunk);
 	freed += vc_item_free_values(item, chunk->slots, chunk->first_value, chunk->last_value);
 
 	__vc_shmem_free_func(chunk);
@@ -1665,16 +2286,20 @@ static void	vch_item_clean_cache(zbx_vc_item_t *item, int timestamp)
 	{
 		zbx_vc_chunk_t	*tail = item->tail;
 		zbx_vc_chunk_t	*chunk = tail;
+		int		head_sec, last_sec;
 
 		timestamp -= item->active_range;
+		head_sec = vch_chunk_slots(item->head)[item->head->last_value].timestamp.sec;
 
 		/* Try to remove chunks with all history values older than maximum request range, maximum */
 		/* request range should be calculated from last received value with which active range    */
 		/* was calculated to avoid dropping of chunks that might be still used in count request.  */
-		while (NULL != chunk && chunk->slots[chunk->last_value].timestamp.sec < timestamp &&
-				chunk->slots[chunk->last_value].timestamp.sec !=
-						item->head->slots[item->head->last_value].timestamp.sec)
+		while (NULL != chunk &&
+				(last_sec = vch_chunk_slots(chunk)[chunk->last_value].timestamp.sec) < timestamp &&
+				last_sec != head_sec)
 		{
+			zbx_history_record_t	*slots;
+
 			/* don't remove the head chunk */
 			if (NULL == (next = chunk->next))
 				break;
@@ -1687,10 +2312,11 @@ static void	vch_item_clean_cache(zbx_vc_item_t *item, int timestamp)
 			/* In this case increase the first value index of the next chunk until the first  */
 			/* value timestamp is greater.                                                    */
 
-			if (next->slots[next->first_value].timestamp.sec != next->slots[next->last_value].timestamp.sec)
+			slots = vch_chunk_slots(next);
+
+			if (slots[next->first_value].timestamp.sec != slots[next->last_value].timestamp.sec)
 			{
-				while (next->slots[next->first_value].timestamp.sec ==
-						chunk->slots[chunk->last_value].timestamp.sec)
+				while (slots[next->first_value].timestamp.sec == last_sec)
 				{
 					vc_item_free_values(item, next->slots, next->first_value, next->first_value);
 					next->first_value++;
@@ -1698,7 +2324,7 @@ static void	vch_item_clean_cache(zbx_vc_item_t *item, int timestamp)
 			}
 
 			/* set the database cached from timestamp to the last (oldest) removed value timestamp + 1 */
-			item->db_cached_from = chunk->slots[chunk->last_value].timestamp.sec + 1;
+			item->db_cached_from = last_sec + 1;
 
 			vch_item_remove_chunk(item, chunk);
 
@@ -1729,16 +2355,17 @@ static void	vch_item_remove_values(zbx_vc_item_t *item, int timestamp)
 		item->status = 0;
 
 	/* try to remove chunks with all history values older than the timestamp */
-	while (NULL != chunk && chunk->slots[chunk->first_value].timestamp.sec < timestamp)
+	while (NULL != chunk && vch_chunk_slots(chunk)[chunk->first_value].timestamp.sec < timestamp)
 	{
-		zbx_vc_chunk_t	*next;
+		zbx_vc_chunk_t		*next;
+		zbx_history_record_t	*slots = vch_chunk_slots(chunk);
 
 		/* If chunk contains values with timestamp greater or equal - remove */
 		/* only the values with less timestamp. Otherwise remove the while   */
 		/* chunk and check next one.                                         */
-		if (chunk->slots[chunk->last_value].timestamp.sec >= timestamp)
+		if (slots[chunk->last_value].timestamp.sec >= timestamp)
 		{
-			while (chunk->slots[chunk->first_value].timestamp.sec < timestamp)
+			while (slots[chunk->first_value].timestamp.sec < timestamp)
 			{
 				vc_item_free_values(item, chunk->slots, chunk->first_value, chunk->first_value);
 				chunk->first_value++;
@@ -1771,12 +2398,14 @@ static void	vch_item_remove_values(zbx_vc_item_t *item, int timestamp)
 static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_record_t *value)
 {
 	int		ret = FAIL, index, sindex, nslots = 0;
-	zbx_vc_chunk_t	*chunk, *schunk;
+	zbx_vc_chunk_t	*chunk, *schunk, *full = NULL;
 
 	if (NULL != item->head &&
-			0 < zbx_history_record_compare_asc_func(&item->head->slots[item->head->last_value], value))
+			0 < zbx_history_record_compare_asc_func(&vch_chunk_slots(item->head)[item->head->last_value],
+			value))
 	{
-		if (0 < zbx_history_record_compare_asc_func(&item->tail->slots[item->tail->first_value], value))
+		if (0 < zbx_history_record_compare_asc_func(&vch_chunk_slots(item->tail)[item->tail->first_value],
+				value))
 		{
 			/* If the added value has the same or older timestamp as the first value in cache */
 			/* we can't add it to keep cache consistency. Additionally we must make sure no   */
@@ -1797,6 +2426,19 @@ static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_rec
 			goto out;
 		}
 
+		/* expand compact chunks with values that must be moved to insert the new value */
+		for (chunk = item->head; NULL != chunk; chunk = chunk->prev)
+		{
+			if (0 >= zbx_timespec_compare(&vch_chunk_slots(chunk)[chunk->last_value].timestamp,
+					&value->timestamp))
+			{
+				break;
+			}
+
+			if (vch_chunk_is_compact(chunk) && NULL == (chunk = vch_item_expand_chunk(item, chunk)))
+				goto out;
+		}
+
 		sindex = item->head->last_value;
 		schunk = item->head;
 
@@ -1804,6 +2446,8 @@ static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_rec
 		{
 			if (FAIL == vch_item_add_chunk(item, vch_item_chunk_slot_count(item, 1), NULL))
 				goto out;
+
+			full = schunk;
 		}
 		else
 			item->head->last_value++;
@@ -1833,7 +2477,7 @@ static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_rec
 				sindex = schunk->last_value;
 			}
 		}
-		while (0 < zbx_timespec_compare(&schunk->slots[sindex].timestamp, &value->timestamp));
+		while (0 < zbx_timespec_compare(&vch_chunk_slots(schunk)[sindex].timestamp, &value->timestamp));
 	}
 	else
 	{
@@ -1843,6 +2487,8 @@ static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_rec
 
 		if (0 == nslots)
 		{
+			full = item->head;
+
 			if (FAIL == vch_item_add_chunk(item, vch_item_chunk_slot_count(item, 1), NULL))
 				goto out;
 		}
@@ -1858,6 +2504,10 @@ static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_rec
 	if (SUCCEED != vch_item_copy_value(item, chunk, index, value))
 		goto out;
 
+	/* the previous head chunk is full after adding a new head chunk */
+	if (NULL != full)
+		vch_item_compact_chunk(item, full);
+
 	ret = SUCCEED;
 out:
 	return ret;
@@ -1886,7 +2536,7 @@ static int	vch_item_add_values_at_tail(zbx_vc_item_t *item, const zbx_history_re
 	/* skip values already added to the item cache by another process */
 	if (NULL != item->tail)
 	{
-		int	sec = item->tail->slots[item->tail->first_value].timestamp.sec;
+		int	sec = vch_chunk_slots(item->tail)[item->tail->first_value].timestamp.sec;
 
 		while (--count >= 0 && values[count].timestamp.sec >= sec)
 			;
@@ -1897,8 +2547,9 @@ static int	vch_item_add_values_at_tail(zbx_vc_item_t *item, const zbx_history_re
 	{
 		int	copy_slots, nslots = 0;
 
-		/* find the number of free slots on the left side in first (tail) chunk */
-		if (NULL != item->tail)
+		/* find the number of free slots on the left side in first (tail) chunk, */
+		/* compact chunks have no free slots                                     */
+		if (NULL != item->tail && !vch_chunk_is_compact(item->tail))
 			nslots = item->tail->first_value;
 
 		if (0 == nslots)
@@ -1918,6 +2569,9 @@ static int	vch_item_add_values_at_tail(zbx_vc_item_t *item, const zbx_history_re
 
 		if (FAIL == vch_item_copy_values_at_tail(item, values + count, copy_slots))
 			goto out;
+
+		if (0 == item->tail->first_value && item->tail != item->head)
+			vch_item_compact_chunk(item, item->tail);
 	}
 
 	ret = SUCCEED;
@@ -1957,7 +2611,7 @@ static int	vch_item_cache_values_by_time(zbx_vc_item_t **item, int range_start)
 	if (NULL != (*item)->tail)
 	{
 		/* we need to get item values before the first cached value, but not including it */
-		range_end = (*item)->tail->slots[(*item)->tail->first_value].timestamp.sec - 1;
+		range_end = vch_chunk_slots((*item)->tail)[(*item)->tail->first_value].timestamp.sec - 1;
 	}
 	else
 		range_end = ZBX_JAN_2038;
@@ -2066,7 +2720,7 @@ static int	vch_item_cache_values_by_time_and_count(zbx_vc_item_t **item, int ran
 
 	/* get the end timestamp to which (including) the values should be cached */
 	if (NULL != (*item)->head)
-		range_end = (*item)->tail->slots[(*item)->tail->first_value].timestamp.sec - 1;
+		range_end = vch_chunk_slots((*item)->tail)[(*item)->tail->first_value].timestamp.sec - 1;
 	else
 		range_end = ZBX_JAN_2038;
 
@@ -2125,7 +2779,7 @@ static int	vch_item_cache_values_by_time_and_count(zbx_vc_item_t **item, int ran
 	if ((count <= records.values_num || 0 == range_start) && 0 != records.values_num)
 	{
 		vc_item_update_db_cached_from(*item,
-				(*item)->tail->slots[(*item)->tail->first_value].timestamp.sec);
+				vch_chunk_slots((*item)->tail)[(*item)->tail->first_value].timestamp.sec);
 	}
 	else if (0 != range_start)
 		vc_item_update_db_cached_from(*item, range_start);
@@ -2142,17 +2796,20 @@ out:
  *                                                                            *
  * Parameters: item      - [IN] the item                                      *
  *             values    - [OUT] the item history data stored time/value      *
- *                         pairs in undefined order                           *
+ *                         pairs in descending order, optional                *
+ *             aggregate - [OUT] the aggregated values, used if values is     *
+ *                         null                                               *
  *             seconds   - [IN] the time period to retrieve data for          *
  *             ts        - [IN] the requested period end timestamp            *
  *                                                                            *
  ******************************************************************************/
-static void	vch_item_get_values_by_time(const zbx_vc_item_t *item, zbx_vector_history_record_t *values, int seconds,
-		const zbx_timespec_t *ts)
+static void	vch_item_get_values_by_time(const zbx_vc_item_t *item, zbx_vector_history_record_t *values,
+		zbx_vc_aggregate_t *aggregate, int seconds, const zbx_timespec_t *ts)
 {
-	int		index, now;
-	zbx_timespec_t	start = {ts->sec - seconds, ts->ns};
-	zbx_vc_chunk_t	*chunk;
+	int			index, now;
+	zbx_timespec_t		start = {ts->sec - seconds, ts->ns};
+	zbx_vc_chunk_t		*chunk;
+	zbx_history_record_t	*slots;
 
 	now = (int)time(NULL);
 	/* add another second to include nanosecond shifts */
@@ -2166,15 +2823,18 @@ static void	vch_item_get_values_by_time(const zbx_vc_item_t *item, zbx_vector_hi
 	}
 
 	/* fill the values vector with item history values until the start timestamp is reached */
-	while (0 < zbx_timespec_compare(&chunk->slots[chunk->last_value].timestamp, &start))
+	slots = vch_chunk_slots(chunk);
+
+	while (0 < zbx_timespec_compare(&slots[chunk->last_value].timestamp, &start))
 	{
-		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&chunk->slots[index].timestamp, &start))
-			vc_history_record_vector_append(values, item->value_type, &chunk->slots[index--]);
+		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&slots[index].timestamp, &start))
+			vc_values_add(values, aggregate, item->value_type, &slots[index--]);
 
 		if (NULL == (chunk = chunk->prev))
 			break;
 
 		index = chunk->last_value;
+		slots = vch_chunk_slots(chunk);
 	}
 }
 
@@ -2184,21 +2844,21 @@ static void	vch_item_get_values_by_time(const zbx_vc_item_t *item, zbx_vector_hi
  *                                                                            *
  * Parameters: item      - [IN] the item                                      *
  *             values    - [OUT] the item history data stored time/value      *
- *                         pairs in undefined order, optional                 *
- *                         If null then cache is updated if necessary, but no *
- *                         values are returned. Used to ensure that cache     *
- *                         contains a value of the specified timestamp.       *
+ *                         pairs in descending order, optional                *
+ *             aggregate - [OUT] the aggregated values, used if values is     *
+ *                         null                                               *
  *             seconds   - [IN] the time period                               *
  *             count     - [IN] the number of history values to retrieve      *
  *             timestamp - [IN] the target timestamp                          *
  *                                                                            *
  ******************************************************************************/
 static void	vch_item_get_values_by_time_and_count(zbx_vc_item_t *item, zbx_vector_history_record_t *values,
-		int seconds, int count, const zbx_timespec_t *ts)
+		zbx_vc_aggregate_t *aggregate, int seconds, int count, const zbx_timespec_t *ts)
 {
-	int		index, now, range_timestamp;
-	zbx_vc_chunk_t	*chunk;
-	zbx_timespec_t	start;
+	int			index, now, range_timestamp, values_num = 0, oldest_sec = 0;
+	zbx_vc_chunk_t		*chunk;
+	zbx_timespec_t		start;
+	zbx_history_record_t	*slots;
 
 	/* set start timestamp of the requested time period */
 	if (0 != seconds)
@@ -2221,13 +2881,16 @@ static void	vch_item_get_values_by_time_and_count(zbx_vc_item_t *item, zbx_vecto
 	/* fill the values vector with item history values until the <count> values are read    */
 	/* or no more values within specified time period                                       */
 	/* fill the values vector with item history values until the start timestamp is reached */
-	while (0 < zbx_timespec_compare(&chunk->slots[chunk->last_value].timestamp, &start))
+	slots = vch_chunk_slots(chunk);
+
+	while (0 < zbx_timespec_compare(&slots[chunk->last_value].timestamp, &start))
 	{
-		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&chunk->slots[index].timestamp, &start))
+		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&slots[index].timestamp, &start))
 		{
-			vc_history_record_vector_append(values, item->value_type, &chunk->slots[index--]);
+			oldest_sec = slots[index].timestamp.sec;
+			vc_values_add(values, aggregate, item->value_type, &slots[index--]);
 
-			if (values->values_num == count)
+			if (++values_num == count)
 				goto out;
 		}
 
@@ -2235,9 +2898,10 @@ static void	vch_item_get_values_by_time_and_count(zbx_vc_item_t *item, zbx_vecto
 			break;
 
 		index = chunk->last_value;
+		slots = vch_chunk_slots(chunk);
 	}
 out:
-	if (count > values->values_num)
+	if (count > values_num)
 	{
 		if (0 == seconds)
 			return;
@@ -2248,7 +2912,7 @@ out:
 	else
 	{
 		/* the requested number of values was retrieved, set the range to the oldest value timestamp */
-		range_timestamp = values->values[values->values_num - 1].timestamp.sec - 1;
+		range_timestamp = oldest_sec - 1;
 	}
 
 	now = (int)time(NULL);
@@ -2261,10 +2925,9 @@ out:
  *                                                                            *
  * Parameters: item      - [IN] the item                                      *
  *             values    - [OUT] the item history data stored time/value      *
- *                         pairs in undefined order, optional                 *
- *                         If null then cache is updated if necessary, but no *
- *                         values are returned. Used to ensure that cache     *
- *                         contains a value of the specified timestamp.       *
+ *                         pairs in descending order, optional                *
+ *             aggregate - [OUT] the aggregated values, used if values is     *
+ *                         null                                               *
  *             seconds   - [IN] the time period to retrieve data for          *
  *             count     - [IN] the number of history values to retrieve      *
  *             ts        - [IN] the target timestamp                          *
@@ -2281,12 +2944,15 @@ out:
  *           seconds before <timestamp>.                                      *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_get_values(zbx_vc_item_t *item, zbx_vector_history_record_t *values, int seconds,
-		int count, const zbx_timespec_t *ts)
+static int	vch_item_get_values(zbx_vc_item_t *item, zbx_vector_history_record_t *values,
+		zbx_vc_aggregate_t *aggregate, int seconds, int count, const zbx_timespec_t *ts)
 {
-	int	ret, records_read, hits, misses, range_start;
+	int	ret, records_read, hits, misses, range_start, values_num;
 
-	zbx_vector_history_record_clear(values);
+	if (NULL != values)
+		zbx_vector_history_record_clear(values);
+	else
+		memset(aggregate, 0, sizeof(zbx_vc_aggregate_t));
 
 	if (0 == count)
 	{
@@ -2298,10 +2964,7 @@ static int	vch_item_get_values(zbx_vc_item_t *item, zbx_vector_history_record_t
 
 		records_read = ret;
 
-		vch_item_get_values_by_time(item, values, seconds, ts);
-
-		if (records_read > values->values_num)
-			records_read = values->values_num;
+		vch_item_get_values_by_time(item, values, aggregate, seconds, ts);
 	}
 	else
 	{
@@ -2312,13 +2975,15 @@ static int	vch_item_get_values(zbx_vc_item_t *item, zbx_vector_history_record_t
 
 		records_read = ret;
 
-		vch_item_get_values_by_time_and_count(item, values, seconds, count, ts);
-
-		if (records_read > values->values_num)
-			records_read = values->values_num;
+		vch_item_get_values_by_time_and_count(item, values, aggregate, seconds, count, ts);
 	}
 
-	hits = values->values_num - records_read;
+	values_num = (NULL != values ? values->values_num : aggregate->values_num);
+
+	if (records_read > values_num)
+		records_read = values_num;
+
+	hits = values_num - records_read;
 	misses = records_read;
 
 	vc_cache_item_update(item->itemid, ZBX_VC_UPDATE_STATS, hits, misses);
@@ -2367,8 +3032,18 @@ static size_t	vch_item_free_cache(zbx_vc_item_t *item)
  *                                                                            *
  * Purpose: initializes value cache                                           *
  *                                                                            *
+ * Parameters: value_cache_size        - [IN] the value cache size            *
+ *             value_cache_compression - [IN] 1 - store numeric item history  *
+ *                                            in compact chunks               *
+ *                                            0 - otherwise                   *
+ *             cache_slabs             - [IN] 1 - allocate small objects from *
+ *                                            slabs, see                      *
+ *                                            zbx_shmem_enable_slabs()        *
+ *                                            0 - otherwise                   *
+ *             error                   - [OUT] the error message              *
+ *                                                                            *
  ******************************************************************************/
-int	zbx_vc_init(zbx_uint64_t value_cache_size, char **error)
+int	zbx_vc_init(zbx_uint64_t value_cache_size, int value_cache_compression, int cache_slabs, char **error)
 {
 	zbx_uint64_t	size_reserved;
 	int		ret = FAIL;
@@ -2389,6 +3064,9 @@ int	zbx_vc_init(zbx_uint64_t value_cache_size, char **error)
 		goto out;
 	}
 
+	if (0 != cache_slabs)
+		zbx_shmem_enable_slabs(vc_mem);
+
 	value_cache_size -= size_reserved;
 
 	vc_cache = (zbx_vc_cache_t *)__vc_shmem_malloc_func(vc_cache, sizeof(zbx_vc_cache_t));
@@ -2399,6 +3077,8 @@ int	zbx_vc_init(zbx_uint64_t value_cache_size, char **error)
 		goto out;
 	}
 	memset(vc_cache, 0, sizeof(zbx_vc_cache_t));
+	vc_cache->compression = value_cache_compression;
+	vc_decoded_clear();
 
 	zbx_hashset_create_ext(&vc_cache->items, VC_ITEMS_INIT_SIZE,
 			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
@@ -2459,6 +3139,8 @@ void	zbx_vc_destroy(void)
 		zbx_shmem_destroy(vc_mem);
 		vc_mem = NULL;
 		zbx_rwlock_destroy(&vc_lock);
+
+		vc_decoded_clear();
 	}
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -2556,7 +3238,7 @@ int	zbx_vc_add_values(zbx_vector_dc_history_ptr_t *history, int *ret_flush, int
 			int			last_value_timestamp;
 
 			if (NULL != head)
-				last_value_timestamp = head->slots[head->last_value].timestamp.sec;
+				last_value_timestamp = vch_chunk_slots(head)[head->last_value].timestamp.sec;
 			else
 				last_value_timestamp = (int)time(NULL);
 
@@ -2585,38 +3267,32 @@ int	zbx_vc_add_values(zbx_vector_dc_history_ptr_t *history, int *ret_flush, int
 
 /******************************************************************************
  *                                                                            *
- * Purpose: get item history data for the specified time period               *
+ * Purpose: get item history data or its aggregate for the specified time     *
+ *          period                                                            *
  *                                                                            *
  * Parameters: itemid     - [IN] the item id                                  *
  *             value_type - [IN] the item value type                          *
  *             values     - [OUT] the item history data stored time/value     *
- *                          pairs in descending order                         *
+ *                          pairs in descending order, optional               *
+ *             aggregate  - [OUT] the aggregated item history data, used if   *
+ *                          values is null                                    *
  *             seconds    - [IN] the time period to retrieve data for         *
  *             count      - [IN] the number of history values to retrieve     *
  *             ts         - [IN] the period end timestamp                     *
+ *             cache_used - [OUT] 1 - data was retrieved from cache,          *
+ *                                0 - from database                           *
  *                                                                            *
  * Return value:  SUCCEED - the item history data was retrieved successfully  *
  *                FAIL    - the item history data was not retrieved           *
  *                                                                            *
- * Comments: If the data is not in cache, it's read from DB, so this function *
- *           will always return the requested data, unless some error occurs. *
- *                                                                            *
- *           If <count> is set then value range is defined as <count> values  *
- *           before <timestamp>. Otherwise the range is defined as <seconds>  *
- *           seconds before <timestamp>.                                      *
- *                                                                            *
  ******************************************************************************/
-int	zbx_vc_get_values(zbx_uint64_t itemid, unsigned char value_type, zbx_vector_history_record_t *values,
-		int seconds, int count, const zbx_timespec_t *ts)
+static int	vc_get_values(zbx_uint64_t itemid, unsigned char value_type, zbx_vector_history_record_t *values,
+		zbx_vc_aggregate_t *aggregate, int seconds, int count, const zbx_timespec_t *ts, int *cache_used)
 {
 	zbx_vc_item_t	*item, new_item;
-	int 		ret = FAIL, cache_used = 1;
+	int 		ret = FAIL;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " value_type:%d count:%d period:%d end_timestamp"
-			" '%s'", __func__, itemid, value_type, count, seconds, zbx_timespec_str(ts));
-
-	if (ITEM_VALUE_TYPE_BIN == value_type)
-		return FAIL;
+	*cache_used = 1;
 
 	RDLOCK_CACHE;
 
@@ -2639,31 +3315,131 @@ int	zbx_vc_get_values(zbx_uint64_t itemid, unsigned char value_type, zbx_vector_
 	else if (item->value_type != value_type)
 		goto out;
 
-	ret = vch_item_get_values(item, values, seconds, count, ts);
+	ret = vch_item_get_values(item, values, aggregate, seconds, count, ts);
 out:
 	if (FAIL == ret)
 	{
-		cache_used = 0;
+		zbx_vector_history_record_t	db_values;
+		int				i;
+
+		*cache_used = 0;
+
+		if (NULL == values)
+		{
+			zbx_history_record_vector_create(&db_values);
+			memset(aggregate, 0, sizeof(zbx_vc_aggregate_t));
+		}
 
 		UNLOCK_CACHE;
-		ret = vc_db_get_values(itemid, value_type, values, seconds, count, ts);
+		ret = vc_db_get_values(itemid, value_type, NULL != values ? values : &db_values, seconds, count, ts);
 		WRLOCK_CACHE;
 
 		if (ZBX_VC_DISABLED != vc_state)
 			vc_remove_item_by_id(itemid);
 
+		if (NULL == values)
+		{
+			for (i = 0; SUCCEED == ret && i < db_values.values_num; i++)
+				vc_aggregate_add(aggregate, value_type, &db_values.values[i].value);
+
+			zbx_history_record_vector_destroy(&db_values, value_type);
+		}
+
 		if (SUCCEED == ret)
-			vc_update_statistics(NULL, 0, values->values_num, (int)time(NULL));
+		{
+			vc_update_statistics(NULL, 0, NULL != values ? values->values_num : aggregate->values_num,
+					(int)time(NULL));
+		}
 	}
 
 	UNLOCK_CACHE;
 
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get item history data for the specified time period               *
+ *                                                                            *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *             values     - [OUT] the item history data stored time/value     *
+ *                          pairs in descending order                         *
+ *             seconds    - [IN] the time period to retrieve data for         *
+ *             count      - [IN] the number of history values to retrieve     *
+ *             ts         - [IN] the period end timestamp                     *
+ *                                                                            *
+ * Return value:  SUCCEED - the item history data was retrieved successfully  *
+ *                FAIL    - the item history data was not retrieved           *
+ *                                                                            *
+ * Comments: If the data is not in cache, it's read from DB, so this function *
+ *           will always return the requested data, unless some error occurs. *
+ *                                                                            *
+ *           If <count> is set then value range is defined as <count> values  *
+ *           before <timestamp>. Otherwise the range is defined as <seconds>  *
+ *           seconds before <timestamp>.                                      *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vc_get_values(zbx_uint64_t itemid, unsigned char value_type, zbx_vector_history_record_t *values,
+		int seconds, int count, const zbx_timespec_t *ts)
+{
+	int	ret, cache_used;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " value_type:%d count:%d period:%d end_timestamp"
+			" '%s'", __func__, itemid, value_type, count, seconds, zbx_timespec_str(ts));
+
+	if (ITEM_VALUE_TYPE_BIN == value_type)
+		return FAIL;
+
+	ret = vc_get_values(itemid, value_type, values, NULL, seconds, count, ts, &cache_used);
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s count:%d cached:%d",
 			__func__, zbx_result_string(ret), values->values_num, cache_used);
 
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: aggregate item history data for the specified time period without *
+ *          copying it out of the cache                                       *
+ *                                                                            *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *             seconds    - [IN] the time period to aggregate data for        *
+ *             count      - [IN] the number of history values to aggregate    *
+ *             ts         - [IN] the period end timestamp                     *
+ *             aggregate  - [OUT] the number of values and, for numeric       *
+ *                          items, their minimum, maximum, sum and average    *
+ *                                                                            *
+ * Return value:  SUCCEED - the item history data was aggregated successfully *
+ *                FAIL    - the item history data was not retrieved           *
+ *                                                                            *
+ * Comments: The range is defined the same way as for zbx_vc_get_values() and *
+ *           values are aggregated in the same (descending) order, so the     *
+ *           results match aggregation of zbx_vc_get_values() output.         *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vc_get_aggregate(zbx_uint64_t itemid, unsigned char value_type, int seconds, int count,
+		const zbx_timespec_t *ts, zbx_vc_aggregate_t *aggregate)
+{
+	int	ret, cache_used;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " value_type:%d count:%d period:%d end_timestamp"
+			" '%s'", __func__, itemid, value_type, count, seconds, zbx_timespec_str(ts));
+
+	if (ITEM_VALUE_TYPE_BIN == value_type)
+		return FAIL;
+
+	if (SUCCEED == (ret = vc_get_values(itemid, value_type, NULL, aggregate, seconds, count, ts, &cache_used)))
+		vc_aggregate_finish(aggregate, value_type);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s count:%d cached:%d",
+			__func__, zbx_result_string(ret), aggregate->values_num, cache_used);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: get the last history value with a timestamp less or equal to the  *
@@ -1205,7 +1205,7 @@ int	zbx_socket_poll(zbx_pollfd_t* fds, unsigned long fds_num, int timeout)
  * Purpose: inspect data in socket buffer without reading it                  *
  *                                                                            *
  ******************************************************************************/
-static ssize_t	tcp_peek(zbx_socket_t *s, char *buffer, size_t size)
+static ssize_t	tcp_peek(zbx_socket_t *s, char *buffer, size_t size, short *events)
 {
 	ssize_t		n;
 	zbx_pollfd_t	pd;
@@ -1216,6 +1216,12 @@ static ssize_t	tcp_peek(zbx_socket_t *s, char *buffer, size_t size)
 	if (SUCCEED != zbx_socket_had_nonblocking_error())
 		return FAIL;
 
+	if (NULL != events)
+	{
+		*events = POLLIN;
+		return FAIL;
+	}
+
 	pd.fd = s->socket;
 	pd.events = POLLIN;
 
@@ -1576,10 +1582,10 @@ void	zbx_tcp_unlisten(zbx_socket_t *s)
 
 /******************************************************************************
  *                                                                            *
- * Purpose: permits an incoming connection attempt on a socket                *
+ * Purpose: permits an incoming TCP connection attempt on a socket without    *
+ *          reading any data from the connection                              *
  *                                                                            *
  * Parameters: s              - [IN/OUT] socket to listen                     *
- *             tls_accept     - [IN] TLS configuration                        *
  *             poll_timeout   - [IN] milliseconds to wait for connection      *
  *                                  (0 - don't wait, -1 - wait forever        *
  *                                                                            *
@@ -1587,15 +1593,16 @@ void	zbx_tcp_unlisten(zbx_socket_t *s)
  *               FAIL          - an error occurred                            *
  *               TIMEOUT_ERROR - no connections for the timeout period        *
  *                                                                            *
+ * Comments: Connection type is not known until zbx_tcp_accept_handshake()    *
+ *           succeeds.                                                        *
+ *                                                                            *
  ******************************************************************************/
-int	zbx_tcp_accept(zbx_socket_t *s, unsigned int tls_accept, int poll_timeout)
+int	zbx_tcp_accept_socket(zbx_socket_t *s, int poll_timeout)
 {
 	ZBX_SOCKADDR	serv_addr;
 	ZBX_SOCKET	accepted_socket;
 	ZBX_SOCKLEN_T	nlen;
 	int		i, ret = FAIL;
-	ssize_t		res;
-	char		buf;	/* 1 byte buffer */
 	zbx_pollfd_t	*pds;
 
 	zbx_tcp_unaccept(s);
@@ -1672,14 +1679,68 @@ int	zbx_tcp_accept(zbx_socket_t *s, unsigned int tls_accept, int poll_timeout)
 		goto out;
 	}
 
-	zbx_socket_set_deadline(s, s->timeout);
+	ret = SUCCEED;
+out:
+	zbx_free(pds);
+
+	return ret;
+}
 
-	if (FAIL == (res = tcp_peek(s, &buf, 1)) || TIMEOUT_ERROR == res)
+#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+static int	tcp_accept_tls(zbx_socket_t *s, unsigned int tls_accept, short *events)
+{
+	char	*error = NULL;
+
+	if (SUCCEED == zbx_tls_accept(s, tls_accept, events, &error))
+		return SUCCEED;
+
+	if (NULL == events || 0 == *events)
+		zbx_set_socket_strerror("from %s: %s", s->peer, ZBX_NULL2EMPTY_STR(error));
+
+	zbx_free(error);
+
+	return FAIL;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: determines type of accepted connection and performs TLS handshake *
+ *          if connection is encrypted                                        *
+ *                                                                            *
+ * Parameters: s          - [IN/OUT] accepted connection                      *
+ *             tls_accept - [IN] TLS configuration                            *
+ *             events     - [OUT] may be NULL for blocking handshake bounded  *
+ *                                by socket deadline, otherwise informs       *
+ *                                caller to wait for POLLIN or POLLOUT and    *
+ *                                retry function to complete the handshake    *
+ *                                                                            *
+ * Return value: SUCCEED - connection is ready for data exchange              *
+ *               FAIL    - an error occurred or retry is needed if events is  *
+ *                         filled                                             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tcp_accept_handshake(zbx_socket_t *s, unsigned int tls_accept, short *events)
+{
+	ssize_t	res;
+	char	buf;	/* 1 byte buffer */
+
+	if (NULL != events)
+		*events = 0;
+
+#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+	/* TLS handshake was started by the previous call */
+	if (NULL != s->tls_ctx)
+		return tcp_accept_tls(s, tls_accept, events);
+#endif
+	if (FAIL == (res = tcp_peek(s, &buf, 1, events)) || TIMEOUT_ERROR == res)
 	{
+		if (NULL != events && 0 != *events)
+			return FAIL;
+
 		zbx_set_socket_strerror("from %s: reading first byte from connection failed: %s", s->peer,
 				zbx_strerror_from_system(zbx_socket_last_error()));
-		zbx_tcp_unaccept(s);
-		goto out;
+		return FAIL;
 	}
 
 	/* if the 1st byte is 0x16 then assume it's a TLS connection */
@@ -1687,48 +1748,58 @@ int	zbx_tcp_accept(zbx_socket_t *s, unsigned int tls_accept, int poll_timeout)
 	{
 #if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
 		if (0 != (tls_accept & (ZBX_TCP_SEC_TLS_CERT | ZBX_TCP_SEC_TLS_PSK)))
-		{
-			char	*error = NULL;
+			return tcp_accept_tls(s, tls_accept, events);
 
-			if (SUCCEED != zbx_tls_accept(s, tls_accept, &error))
-			{
-				zbx_set_socket_strerror("from %s: %s", s->peer, error);
-				zbx_tcp_unaccept(s);
-				zbx_free(error);
-				goto out;
-			}
-		}
-		else
-		{
-			zbx_set_socket_strerror("from %s: TLS connections are not allowed", s->peer);
-			zbx_tcp_unaccept(s);
-			goto out;
-		}
+		zbx_set_socket_strerror("from %s: TLS connections are not allowed", s->peer);
 #else
 		zbx_set_socket_strerror("from %s: support for TLS was not compiled in", s->peer);
-		zbx_tcp_unaccept(s);
-		goto out;
 #endif
+		return FAIL;
 	}
-	else
+
+	if (0 == (tls_accept & ZBX_TCP_SEC_UNENCRYPTED))
 	{
-		if (0 == (tls_accept & ZBX_TCP_SEC_UNENCRYPTED))
-		{
-			zbx_set_socket_strerror("from %s: unencrypted connections are not allowed", s->peer);
-			zbx_tcp_unaccept(s);
-			goto out;
-		}
+		zbx_set_socket_strerror("from %s: unencrypted connections are not allowed", s->peer);
+		return FAIL;
+	}
+
+	s->connection_type = ZBX_TCP_SEC_UNENCRYPTED;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: permits an incoming connection attempt on a socket                *
+ *                                                                            *
+ * Parameters: s              - [IN/OUT] socket to listen                     *
+ *             tls_accept     - [IN] TLS configuration                        *
+ *             poll_timeout   - [IN] milliseconds to wait for connection      *
+ *                                  (0 - don't wait, -1 - wait forever        *
+ *                                                                            *
+ * Return value: SUCCEED       - success                                      *
+ *               FAIL          - an error occurred                            *
+ *               TIMEOUT_ERROR - no connections for the timeout period        *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tcp_accept(zbx_socket_t *s, unsigned int tls_accept, int poll_timeout)
+{
+	int	ret;
+
+	if (SUCCEED != (ret = zbx_tcp_accept_socket(s, poll_timeout)))
+		return ret;
 
-		s->connection_type = ZBX_TCP_SEC_UNENCRYPTED;
+	zbx_socket_set_deadline(s, s->timeout);
+
+	if (SUCCEED != zbx_tcp_accept_handshake(s, tls_accept, NULL))
+	{
+		zbx_tcp_unaccept(s);
+		return FAIL;
 	}
 
 	zbx_socket_set_deadline(s, 0);
 
-	ret = SUCCEED;
-out:
-	zbx_free(pds);
-
-	return ret;
+	return SUCCEED;
 }
 
 /******************************************************************************
@@ -1753,6 +1824,34 @@ void	zbx_tcp_unaccept(zbx_socket_t *s)
 	s->accepted = 0;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: moves accepted connection to separate socket, leaving listening   *
+ *          socket ready to accept the next connection                        *
+ *                                                                            *
+ * Parameters: s    - [IN/OUT] the listening socket with accepted connection  *
+ *             conn - [OUT] the accepted connection                           *
+ *                                                                            *
+ * Comments: The accepted connection must be closed with zbx_tcp_unaccept().  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_tcp_accept_detach(zbx_socket_t *s, zbx_socket_t *conn)
+{
+	memcpy(conn, s, sizeof(zbx_socket_t));
+
+	/* connection buffer was released when accepting, so static buffer is used */
+	conn->buf_type = ZBX_BUF_TYPE_STAT;
+	conn->buffer = conn->buf_stat;
+	conn->next_line = NULL;
+
+#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+	s->tls_ctx = NULL;
+#endif
+	s->socket = s->socket_orig;
+	s->socket_orig = ZBX_SOCKET_ERROR;
+	s->accepted = 0;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: finds the next line in socket data buffer                         *
@@ -1986,11 +2085,32 @@ void	zbx_tcp_recv_context_init(zbx_socket_t *s, zbx_tcp_recv_context_t *tcp_recv
 #endif
 	zbx_socket_free(s);
 	tcp_recv_context->allocated = 0;
+	tcp_recv_context->stream = NULL;
 
 	s->buf_type = ZBX_BUF_TYPE_STAT;
 	s->buffer = s->buf_stat;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: releases resources of unfinished receiving                        *
+ *                                                                            *
+ * Comments: Must be called when non-blocking receiving initialized with      *
+ *           zbx_tcp_recv_context_init() is abandoned before the message has  *
+ *           been received completely.                                        *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_tcp_recv_context_clear(zbx_tcp_recv_context_t *tcp_recv_context)
+{
+	if (NULL != tcp_recv_context->stream)
+	{
+		size_t	out_size;
+
+		(void)zbx_uncompress_stream_close(tcp_recv_context->stream, &out_size);
+		tcp_recv_context->stream = NULL;
+	}
+}
+
 ssize_t	zbx_tcp_recv_context(zbx_socket_t *s, zbx_tcp_recv_context_t *context, unsigned char flags, short *events)
 {
 	ssize_t	nbytes;
@@ -2009,7 +2129,19 @@ ssize_t	zbx_tcp_recv_context(zbx_socket_t *s, zbx_tcp_recv_context_t *context, u
 		else
 		{
 			if (context->buf_dyn_bytes + (size_t)nbytes <= context->expected_len)
-				memcpy(s->buffer + context->buf_dyn_bytes, s->buf_stat, (size_t)nbytes);
+			{
+				if (NULL == context->stream)
+				{
+					memcpy(s->buffer + context->buf_dyn_bytes, s->buf_stat, (size_t)nbytes);
+				}
+				else if (SUCCEED != zbx_uncompress_stream_write(context->stream, s->buf_stat,
+						(size_t)nbytes))
+				{
+					zbx_set_socket_strerror("cannot uncompress data: %s", zbx_compress_strerror());
+					nbytes = ZBX_PROTO_ERROR;
+					goto out;
+				}
+			}
 			context->buf_dyn_bytes += (size_t)nbytes;
 		}
 
@@ -2117,10 +2249,34 @@ ssize_t	zbx_tcp_recv_context(zbx_socket_t *s, zbx_tcp_recv_context_t *context, u
 			else
 			{
 				s->buf_type = ZBX_BUF_TYPE_DYN;
-				s->buffer = (char *)zbx_malloc(NULL, context->expected_len + 1);
 				context->buf_dyn_bytes = context->buf_stat_bytes - context->offset;
 				context->buf_stat_bytes = 0;
-				memcpy(s->buffer, s->buf_stat + context->offset, context->buf_dyn_bytes);
+
+				/* decompress data as it arrives instead of keeping both */
+				/* compressed and uncompressed copies of large messages  */
+				if (0 != (context->protocol_version & ZBX_TCP_COMPRESS))
+				{
+					s->buffer = (char *)zbx_malloc(NULL, context->reserved + 1);
+
+					if (NULL == (context->stream = zbx_uncompress_stream_open(s->buffer,
+							context->reserved)))
+					{
+						s->buffer = (char *)zbx_realloc(s->buffer, context->expected_len + 1);
+					}
+					else if (SUCCEED != zbx_uncompress_stream_write(context->stream,
+							s->buf_stat + context->offset, context->buf_dyn_bytes))
+					{
+						zbx_set_socket_strerror("cannot uncompress data: %s",
+								zbx_compress_strerror());
+						nbytes = ZBX_PROTO_ERROR;
+						goto out;
+					}
+				}
+				else
+					s->buffer = (char *)zbx_malloc(NULL, context->expected_len + 1);
+
+				if (NULL == context->stream)
+					memcpy(s->buffer, s->buf_stat + context->offset, context->buf_dyn_bytes);
 			}
 
 			context->expect = ZBX_TCP_EXPECT_SIZE;
@@ -2134,7 +2290,31 @@ ssize_t	zbx_tcp_recv_context(zbx_socket_t *s, zbx_tcp_recv_context_t *context, u
 	{
 		if (context->buf_stat_bytes + context->buf_dyn_bytes == context->expected_len)
 		{
-			if (0 != (context->protocol_version & ZBX_TCP_COMPRESS))
+			if (NULL != context->stream)
+			{
+				size_t	out_size;
+				int	ret;
+
+				ret = zbx_uncompress_stream_close(context->stream, &out_size);
+				context->stream = NULL;
+
+				if (SUCCEED != ret)
+				{
+					zbx_set_socket_strerror("cannot uncompress data: %s", zbx_compress_strerror());
+					nbytes = ZBX_PROTO_ERROR;
+					goto out;
+				}
+
+				if (out_size != context->reserved)
+				{
+					zbx_set_socket_strerror("size of uncompressed data is less than expected");
+					nbytes = ZBX_PROTO_ERROR;
+					goto out;
+				}
+
+				s->read_bytes = context->reserved;
+			}
+			else if (0 != (context->protocol_version & ZBX_TCP_COMPRESS))
 			{
 				char	*out;
 				size_t	out_size = context->reserved;
@@ -2221,6 +2401,10 @@ ssize_t	zbx_tcp_recv_context(zbx_socket_t *s, zbx_tcp_recv_context_t *context, u
 		s->buffer[s->read_bytes] = '\0';
 	}
 out:
+	/* keep decompression stream if non-blocking receiving will be resumed */
+	if (ZBX_PROTO_ERROR != nbytes || NULL == events || 0 == *events)
+		zbx_tcp_recv_context_clear(context);
+
 	return (ZBX_PROTO_ERROR == nbytes ? FAIL : (ssize_t)(s->read_bytes + context->offset));
 
 #undef ZBX_TCP_EXPECT_HEADER
@@ -189,9 +189,6 @@ static ZBX_THREAD_LOCAL size_t		my_psk_len		= 0;
 /* but other components (e.g. agent) do not link dbconfig.o. */
 static zbx_find_psk_in_cache_f	find_psk_in_cache_cb = NULL;
 
-/* variable for passing information from callback functions if PSK was found among host PSKs or autoregistration PSK */
-static unsigned int	psk_usage;
-
 static zbx_tls_status_t	tls_status = ZBX_TLS_INIT_NONE;
 
 static ZBX_THREAD_LOCAL const SSL_METHOD	*method			= NULL;
@@ -205,11 +202,6 @@ static ZBX_THREAD_LOCAL size_t			psk_identity_len_for_cb	= 0;
 static ZBX_THREAD_LOCAL char			*psk_for_cb		= NULL;
 static ZBX_THREAD_LOCAL size_t			psk_len_for_cb		= 0;
 #endif
-#ifdef HAVE_OPENSSL_WITH_PSK
-/* variables for capturing PSK identity from server callback function */
-static ZBX_THREAD_LOCAL int			incoming_connection_has_psk = 0;
-static ZBX_THREAD_LOCAL char			incoming_connection_psk_id[PSK_MAX_IDENTITY_LEN + 1];
-#endif
 /* buffer for messages produced by zbx_openssl_info_cb() */
 ZBX_THREAD_LOCAL char				info_buf[256];
 
@@ -416,7 +408,8 @@ static unsigned int	zbx_psk_client_cb(SSL *ssl, const char *hint, char *identity
  *     set pre-shared key for incoming TLS connection upon OpenSSL request    *
  *                                                                            *
  * Parameters:                                                                *
- *     ssl              - [IN] not used                                       *
+ *     ssl              - [IN] connection, its application data is TLS        *
+ *                             context of the accepted socket                 *
  *     identity         - [IN] PSK identity sent by client                    *
  *     psk              - [OUT] buffer to write PSK into                      *
  *     max_psk_len      - [IN] size of the 'psk' buffer                       *
@@ -433,22 +426,22 @@ static unsigned int	zbx_psk_client_cb(SSL *ssl, const char *hint, char *identity
 static unsigned int	zbx_psk_server_cb(SSL *ssl, const char *identity, unsigned char *psk,
 		unsigned int max_psk_len)
 {
-	const char	*psk_loc;
-	size_t		psk_len = 0;
-	int		psk_bin_len;
-	unsigned char	tls_psk_hex[HOST_TLS_PSK_LEN_MAX], psk_buf[HOST_TLS_PSK_LEN / 2];
-
-	ZBX_UNUSED(ssl);
+	const char		*psk_loc;
+	size_t			psk_len = 0;
+	int			psk_bin_len;
+	unsigned char		tls_psk_hex[HOST_TLS_PSK_LEN_MAX], psk_buf[HOST_TLS_PSK_LEN / 2];
+	zbx_tls_context_t	*tls_ctx = (zbx_tls_context_t *)SSL_get_app_data(ssl);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "%s() requested PSK identity \"%s\"", __func__, identity);
 
-	incoming_connection_has_psk = 1;
-	psk_usage = 0;
+	/* several connections can be accepted concurrently, so PSK information is kept in their contexts */
+	tls_ctx->incoming_has_psk = 1;
+	tls_ctx->psk_usage = 0;
 
 	if (0 != (zbx_get_program_type_cb() & (ZBX_PROGRAM_TYPE_PROXY | ZBX_PROGRAM_TYPE_SERVER)))
 	{
 		/* call the function zbx_dc_get_psk_by_identity() by pointer */
-		if (0 < find_psk_in_cache_cb((const unsigned char *)identity, tls_psk_hex, &psk_usage))
+		if (0 < find_psk_in_cache_cb((const unsigned char *)identity, tls_psk_hex, &tls_ctx->psk_usage))
 		{
 			/* The PSK is in configuration cache. Convert PSK to binary form. */
 			if (0 >= (psk_bin_len = zbx_hex2bin(tls_psk_hex, psk_buf, sizeof(psk_buf))))
@@ -468,13 +461,13 @@ static unsigned int	zbx_psk_server_cb(SSL *ssl, const char *identity, unsigned c
 				0 == strcmp(my_psk_identity, identity))
 		{
 			/* the PSK is in proxy configuration file */
-			psk_usage |= ZBX_PSK_FOR_PROXY;
+			tls_ctx->psk_usage |= ZBX_PSK_FOR_PROXY;
 
 			if (0 < psk_len && (psk_len != my_psk_len || 0 != memcmp(psk_loc, my_psk, psk_len)))
 			{
 				/* PSK was also found in configuration cache but with different value */
 				zbx_psk_warn_misconfig(identity);
-				psk_usage &= ~(unsigned int)ZBX_PSK_FOR_AUTOREG;
+				tls_ctx->psk_usage &= ~(unsigned int)ZBX_PSK_FOR_AUTOREG;
 			}
 
 			psk_loc = my_psk;	/* prefer PSK from proxy configuration file */
@@ -515,12 +508,12 @@ static unsigned int	zbx_psk_server_cb(SSL *ssl, const char *identity, unsigned c
 		}
 
 		memcpy(psk, psk_loc, psk_len);
-		zbx_strlcpy(incoming_connection_psk_id, identity, sizeof(incoming_connection_psk_id));
+		zbx_strlcpy(tls_ctx->incoming_psk_id, identity, sizeof(tls_ctx->incoming_psk_id));
 
 		return (unsigned int)psk_len;	/* success */
 	}
 fail:
-	incoming_connection_psk_id[0] = '\0';
+	tls_ctx->incoming_psk_id[0] = '\0';
 	return 0;	/* PSK not found */
 }
 #endif
@@ -1815,37 +1808,32 @@ out1:
 
 /******************************************************************************
  *                                                                            *
- * Purpose: establish a TLS connection over an accepted TCP connection        *
+ * Purpose: create TLS context for accepted TCP connection                    *
  *                                                                            *
  * Parameters:                                                                *
  *     s          - [IN] socket with opened connection                        *
+ *     tls_accept - [IN] type of connection to accept                         *
  *     error      - [OUT] dynamically allocated memory with error message     *
- *     tls_accept - [IN] type of connection to accept. Can be be either       *
- *                       ZBX_TCP_SEC_TLS_CERT or ZBX_TCP_SEC_TLS_PSK, or      *
- *                       a bitwise 'OR' of both.                              *
  *                                                                            *
  * Return value:                                                              *
- *     SUCCEED - successful TLS handshake with a valid certificate or PSK     *
- *     FAIL - an error occurred                                               *
+ *     SUCCEED - TLS context was created                                      *
+ *     FAIL - an error occurred, partially created context must be freed      *
  *                                                                            *
  ******************************************************************************/
-int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
+static int	tls_accept_context_create(zbx_socket_t *s, unsigned int tls_accept, char **error)
 {
-	const char	*cipher_name;
-	int		ret = FAIL, res;
 	size_t		error_alloc = 0, error_offset = 0;
-	long		verify_result;
-
 #if OPENSSL_VERSION_NUMBER >= 0x1010100fL	/* OpenSSL 1.1.1 or newer, or LibreSSL */
 	const unsigned char	session_id_context[] = {'Z', 'b', 'x'};
 #endif
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	s->tls_ctx = zbx_malloc(s->tls_ctx, sizeof(zbx_tls_context_t));
 	s->tls_ctx->ctx = NULL;
 
+	s->tls_ctx->psk_usage = 0;
 #if defined(HAVE_OPENSSL_WITH_PSK)
-	incoming_connection_has_psk = 0;	/* assume certificate-based connection by default */
+	s->tls_ctx->incoming_has_psk = 0;	/* assume certificate-based connection by default */
+	s->tls_ctx->incoming_psk_id[0] = '\0';
 #endif
 	if ((ZBX_TCP_SEC_TLS_CERT | ZBX_TCP_SEC_TLS_PSK) == (tls_accept & (ZBX_TCP_SEC_TLS_CERT | ZBX_TCP_SEC_TLS_PSK)))
 	{
@@ -1860,7 +1848,7 @@ int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
 				zbx_snprintf_alloc(error, &error_alloc, &error_offset, "cannot create context to accept"
 						" connection:");
 				zbx_tls_error_msg(error, &error_alloc, &error_offset);
-				goto out;
+				return FAIL;
 			}
 		}
 #else
@@ -1874,21 +1862,21 @@ int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
 					zbx_snprintf_alloc(error, &error_alloc, &error_offset, "cannot create context"
 							" to accept connection:");
 					zbx_tls_error_msg(error, &error_alloc, &error_offset);
-					goto out;
+					return FAIL;
 				}
 			}
 			else
 			{
 				*error = zbx_strdup(*error, "not ready for certificate-based incoming connection:"
 						" certificate not loaded. PSK support not compiled in.");
-				goto out;
+				return FAIL;
 			}
 		}
 #endif
 		else if (0 != (zbx_get_program_type_cb() & ZBX_PROGRAM_TYPE_AGENTD))
 		{
 			THIS_SHOULD_NEVER_HAPPEN;
-			goto out;
+			return FAIL;
 		}
 #if defined(HAVE_OPENSSL_WITH_PSK)
 		else if (NULL != ctx_psk)
@@ -1901,13 +1889,13 @@ int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
 				zbx_snprintf_alloc(error, &error_alloc, &error_offset, "cannot create context to accept"
 						" connection:");
 				zbx_tls_error_msg(error, &error_alloc, &error_offset);
-				goto out;
+				return FAIL;
 			}
 		}
 		else
 		{
 			THIS_SHOULD_NEVER_HAPPEN;
-			goto out;
+			return FAIL;
 		}
 #endif
 	}
@@ -1920,14 +1908,14 @@ int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
 				zbx_snprintf_alloc(error, &error_alloc, &error_offset, "cannot create context to accept"
 						" connection:");
 				zbx_tls_error_msg(error, &error_alloc, &error_offset);
-				goto out;
+				return FAIL;
 			}
 		}
 		else
 		{
 			*error = zbx_strdup(*error, "not ready for certificate-based incoming connection: certificate"
 					" not loaded");
-			goto out;
+			return FAIL;
 		}
 	}
 	else	/* PSK */
@@ -1940,17 +1928,17 @@ int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
 				zbx_snprintf_alloc(error, &error_alloc, &error_offset, "cannot create context to accept"
 						" connection:");
 				zbx_tls_error_msg(error, &error_alloc, &error_offset);
-				goto out;
+				return FAIL;
 			}
 		}
 		else
 		{
 			*error = zbx_strdup(*error, "not ready for PSK-based incoming connection: PSK not loaded");
-			goto out;
+			return FAIL;
 		}
 #else
 		*error = zbx_strdup(*error, "support for PSK was not compiled in");
-		goto out;
+		return FAIL;
 #endif
 	}
 
@@ -1958,18 +1946,61 @@ int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
 	if (1 != SSL_set_session_id_context(s->tls_ctx->ctx, session_id_context, sizeof(session_id_context)))
 	{
 		*error = zbx_strdup(*error, "cannot set session_id_context");
-		goto out;
+		return FAIL;
 	}
 #endif
 	if (1 != SSL_set_fd(s->tls_ctx->ctx, s->socket))
 	{
 		*error = zbx_strdup(*error, "cannot set socket for TLS context");
-		goto out;
+		return FAIL;
 	}
 
-	/* TLS handshake */
+	/* let server callback function find context of this connection */
+	SSL_set_app_data(s->tls_ctx->ctx, s->tls_ctx);
 
-	info_buf[0] = '\0';	/* empty buffer for zbx_openssl_info_cb() messages */
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: establish a TLS connection over an accepted TCP connection        *
+ *                                                                            *
+ * Parameters:                                                                *
+ *     s          - [IN] socket with opened connection                        *
+ *     tls_accept - [IN] type of connection to accept. Can be be either       *
+ *                       ZBX_TCP_SEC_TLS_CERT or ZBX_TCP_SEC_TLS_PSK, or      *
+ *                       a bitwise 'OR' of both.                              *
+ *     event      - [OUT] may be NULL for blocking TLS handshake, otherwise   *
+ *                        informs caller to wait for POLLIN or POLLOUT and    *
+ *                        retry function to complete async TLS handshake      *
+ *     error      - [OUT] dynamically allocated memory with error message     *
+ *                                                                            *
+ * Return value:                                                              *
+ *     SUCCEED - successful TLS handshake with a valid certificate or PSK     *
+ *     FAIL - an error occurred or retry is needed if event is filled         *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, short *event, char **error)
+{
+	const char	*cipher_name;
+	int		ret = FAIL, res;
+	size_t		error_alloc = 0, error_offset = 0;
+	long		verify_result;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (NULL != event)
+		*event = 0;
+
+	if (NULL == s->tls_ctx)
+	{
+		if (SUCCEED != tls_accept_context_create(s, tls_accept, error))
+			goto out;
+
+		info_buf[0] = '\0';	/* empty buffer for zbx_openssl_info_cb() messages */
+	}
+
+	/* TLS handshake */
 
 	while (-1 == (res = SSL_accept(s->tls_ctx->ctx)))
 	{
@@ -1980,6 +2011,15 @@ int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
 		if (SSL_ERROR_WANT_READ != ssl_err && SSL_ERROR_WANT_WRITE != ssl_err)
 			break;
 
+		if (NULL != event)
+		{
+			tls_socket_event(s->tls_ctx->ctx, ssl_err, event);
+
+			zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s %s", __func__, tls_error_string(ssl_err),
+					zbx_result_string(ret));
+			return FAIL;
+		}
+
 		if (FAIL == tls_socket_wait(s->socket, s->tls_ctx->ctx, ssl_err))
 		{
 			*error = zbx_dsprintf(*error, "cannot wait for TLS handshake: %s",
@@ -2039,7 +2079,7 @@ int	zbx_tls_accept(zbx_socket_t *s, unsigned int tls_accept, char **error)
 	cipher_name = SSL_get_cipher(s->tls_ctx->ctx);
 
 #if defined(HAVE_OPENSSL_WITH_PSK)
-	if (1 == incoming_connection_has_psk)
+	if (1 == s->tls_ctx->incoming_has_psk)
 	{
 		s->connection_type = ZBX_TCP_SEC_TLS_PSK;
 	}
@@ -2331,14 +2371,12 @@ int	zbx_tls_get_attr_cert(const zbx_socket_t *s, zbx_tls_conn_attr_t *attr)
 #if defined(HAVE_OPENSSL_WITH_PSK)
 int	zbx_tls_get_attr_psk(const zbx_socket_t *s, zbx_tls_conn_attr_t *attr)
 {
-	ZBX_UNUSED(s);
-
 	/* SSL_get_psk_identity() is not used here. It works with TLS 1.2, */
 	/* but returns NULL with TLS 1.3 in OpenSSL 1.1.1 */
-	if ('\0' == incoming_connection_psk_id[0])
+	if ('\0' == s->tls_ctx->incoming_psk_id[0])
 		return FAIL;
 
-	attr->psk_identity = incoming_connection_psk_id;
+	attr->psk_identity = s->tls_ctx->incoming_psk_id;
 	attr->psk_identity_len = strlen(attr->psk_identity);
 	return SUCCEED;
 }
@@ -2479,9 +2517,9 @@ void	zbx_tls_take_vars(ZBX_THREAD_SENDVAL_TLS_ARGS *args)
 }
 #endif
 
-unsigned int	zbx_tls_get_psk_usage(void)
+unsigned int	zbx_tls_get_psk_usage(const zbx_socket_t *s)
 {
-	return	psk_usage;
+	return	s->tls_ctx->psk_usage;
 }
 
 /******************************************************************************
@@ -115,6 +115,125 @@ int	zbx_uncompress(const char *in, size_t size_in, char *out, size_t *size_out)
 	return SUCCEED;
 }
 
+struct zbx_uncompress_stream
+{
+	z_stream	zs;
+	size_t		size_out;
+	size_t		left_out;
+	int		finished;
+};
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: starts incremental decompression into preallocated buffer         *
+ *                                                                            *
+ * Parameters: out      - [OUT] the output buffer                             *
+ *             size_out - [IN] the output buffer size                         *
+ *                                                                            *
+ * Return value: the decompression stream or NULL on error                    *
+ *                                                                            *
+ * Comments: The stream allows to decompress data as it arrives, without      *
+ *           keeping the whole compressed data in memory.                     *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uncompress_stream_t	*zbx_uncompress_stream_open(char *out, size_t size_out)
+{
+	zbx_uncompress_stream_t	*stream;
+
+	stream = (zbx_uncompress_stream_t *)zbx_malloc(NULL, sizeof(zbx_uncompress_stream_t));
+	memset(stream, 0, sizeof(zbx_uncompress_stream_t));
+
+	if (Z_OK != (zbx_zlib_errno = inflateInit(&stream->zs)))
+	{
+		zbx_free(stream);
+		return NULL;
+	}
+
+	stream->zs.next_out = (Bytef *)out;
+	stream->size_out = size_out;
+	stream->left_out = size_out;
+
+	return stream;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: decompresses next chunk of data                                   *
+ *                                                                            *
+ * Parameters: stream  - [IN] the decompression stream                        *
+ *             in      - [IN] the compressed data chunk                       *
+ *             size_in - [IN] the chunk size                                  *
+ *                                                                            *
+ * Return value: SUCCEED - the chunk was decompressed successfully            *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Data after the end of compressed stream is ignored.              *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_uncompress_stream_write(zbx_uncompress_stream_t *stream, const char *in, size_t size_in)
+{
+	if (0 != stream->finished)
+		return SUCCEED;
+
+	while (0 != size_in)
+	{
+		uInt	chunk_in, chunk_out;
+
+		chunk_in = (uInt)MIN(size_in, UINT_MAX);
+		chunk_out = (uInt)MIN(stream->left_out, UINT_MAX);
+
+		stream->zs.next_in = (Bytef *)in;
+		stream->zs.avail_in = chunk_in;
+		stream->zs.avail_out = chunk_out;
+
+		zbx_zlib_errno = inflate(&stream->zs, Z_NO_FLUSH);
+
+		stream->left_out -= chunk_out - stream->zs.avail_out;
+		in += chunk_in - stream->zs.avail_in;
+		size_in -= chunk_in - stream->zs.avail_in;
+
+		if (Z_STREAM_END == zbx_zlib_errno)
+		{
+			stream->finished = 1;
+			break;
+		}
+
+		if (Z_OK != zbx_zlib_errno)
+			return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finishes incremental decompression and frees the stream           *
+ *                                                                            *
+ * Parameters: stream   - [IN] the decompression stream                       *
+ *             size_out - [OUT] the decompressed data size                    *
+ *                                                                            *
+ * Return value: SUCCEED - the whole compressed stream was decompressed       *
+ *               FAIL    - the compressed stream is incomplete                *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_uncompress_stream_close(zbx_uncompress_stream_t *stream, size_t *size_out)
+{
+	int	ret = FAIL;
+
+	if (0 != stream->finished)
+	{
+		*size_out = stream->size_out - stream->left_out;
+		ret = SUCCEED;
+	}
+	else
+		zbx_zlib_errno = Z_DATA_ERROR;
+
+	inflateEnd(&stream->zs);
+	zbx_free(stream);
+
+	return ret;
+}
+
 #else
 
 int	zbx_compress(const char *in, size_t size_in, char **out, size_t *size_out)
@@ -135,6 +254,28 @@ int	zbx_uncompress(const char *in, size_t size_in, char *out, size_t *size_out)
 	return FAIL;
 }
 
+zbx_uncompress_stream_t	*zbx_uncompress_stream_open(char *out, size_t size_out)
+{
+	ZBX_UNUSED(out);
+	ZBX_UNUSED(size_out);
+	return NULL;
+}
+
+int	zbx_uncompress_stream_write(zbx_uncompress_stream_t *stream, const char *in, size_t size_in)
+{
+	ZBX_UNUSED(stream);
+	ZBX_UNUSED(in);
+	ZBX_UNUSED(size_in);
+	return FAIL;
+}
+
+int	zbx_uncompress_stream_close(zbx_uncompress_stream_t *stream, size_t *size_out)
+{
+	ZBX_UNUSED(stream);
+	ZBX_UNUSED(size_out);
+	return FAIL;
+}
+
 const char	*zbx_compress_strerror(void)
 {
 	return "";
@@ -371,6 +371,23 @@ int	zbx_curl_has_smtp_auth(char **error)
 	return SUCCEED;
 }
 
+int	zbx_curl_has_multi_wait(char **error)
+{
+	/* curl_multi_wait() was added in 7.28.0 (0x071c00) */
+	if (libcurl_version_num() < 0x071c00)
+	{
+		if (NULL != error)
+		{
+			*error = zbx_dsprintf(*error, "cURL library version %s does not support curl_multi_wait(),"
+					" 7.28.0 or newer is required", libcurl_version_str());
+		}
+
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
 int	zbx_curl_good_for_elasticsearch(char **error)
 {
 	/* Elasticsearch needs curl_multi_wait() which was added in 7.28.0 (0x071c00) */
@@ -1088,6 +1088,205 @@ clean:
 	return ret;
 }
 
+#if defined(HAVE_POSTGRESQL)
+#define ZBX_PG_COPY_SAVEPOINT	"zbx_copy"
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: executes savepoint management statement during COPY               *
+ *                                                                            *
+ * Return value: ZBX_DB_OK   - statement was executed successfully            *
+ *               ZBX_DB_FAIL - statement failed                               *
+ *               ZBX_DB_DOWN - connection to database was lost                *
+ *                                                                            *
+ ******************************************************************************/
+static int	db_copy_exec_savepoint(const char *sql)
+{
+	PGresult	*result;
+	char		*error = NULL;
+	int		ret = ZBX_DB_OK;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "query [txnlev:%d] [%s]", txn_level, sql);
+
+	result = PQexec(conn, sql);
+
+	if (NULL == result || PGRES_COMMAND_OK != PQresultStatus(result))
+	{
+		zbx_postgresql_error(&error, result);
+		zbx_db_errlog(ERR_Z3005, 0, error, sql);
+		zbx_free(error);
+
+		ret = (CONNECTION_OK == PQstatus(conn) ? ZBX_DB_FAIL : ZBX_DB_DOWN);
+	}
+
+	PQclear(result);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: rolls back failed COPY to make the transaction usable again       *
+ *                                                                            *
+ * Return value: ZBX_DB_FAIL - COPY was rolled back                           *
+ *               ZBX_DB_DOWN - connection to database was lost                *
+ *                                                                            *
+ ******************************************************************************/
+static int	db_copy_rollback(void)
+{
+	int	ret;
+
+	if (ZBX_DB_DOWN == (ret = db_copy_exec_savepoint("rollback to savepoint " ZBX_PG_COPY_SAVEPOINT)))
+		return ZBX_DB_DOWN;
+
+	if (ZBX_DB_OK != ret)
+		txn_error = ZBX_DB_FAIL;
+
+	return ZBX_DB_FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: starts binary COPY data transfer into the specified table         *
+ *                                                                            *
+ * Parameters: table  - [IN] target table name                                *
+ *             fields - [IN] comma separated list of target fields            *
+ *             error  - [OUT] the error message when COPY cannot be started   *
+ *                                                                            *
+ * Return value: ZBX_DB_OK   - COPY was started, data can be sent with        *
+ *                             zbx_db_copy_put_basic()                        *
+ *               ZBX_DB_FAIL - COPY cannot be started                         *
+ *               ZBX_DB_DOWN - connection to database was lost                *
+ *                                                                            *
+ * Comments: COPY is executed within a savepoint, so its failure does not     *
+ *           abort the surrounding transaction. Every successful call must be *
+ *           followed by zbx_db_copy_end_basic().                             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_copy_start_basic(const char *table, const char *fields, char **error)
+{
+	PGresult	*result;
+	char		*sql;
+	int		ret;
+
+	if (0 == txn_level || ZBX_DB_OK != txn_error)
+	{
+		*error = zbx_strdup(*error, "COPY can be used only in a successful transaction");
+		return ZBX_DB_FAIL;
+	}
+
+	if (ZBX_DB_OK != (ret = db_copy_exec_savepoint("savepoint " ZBX_PG_COPY_SAVEPOINT)))
+	{
+		if (ZBX_DB_FAIL == ret)
+		{
+			txn_error = ZBX_DB_FAIL;
+			*error = zbx_strdup(*error, "cannot create savepoint");
+		}
+
+		return ret;
+	}
+
+	sql = zbx_dsprintf(NULL, "copy %s (%s) from stdin (format binary)", table, fields);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "query [txnlev:%d] [%s]", txn_level, sql);
+
+	result = PQexec(conn, sql);
+
+	if (NULL == result || PGRES_COPY_IN != PQresultStatus(result))
+	{
+		if (CONNECTION_OK != PQstatus(conn))
+		{
+			zbx_db_errlog(ERR_Z3005, 0, PQerrorMessage(conn), sql);
+			ret = ZBX_DB_DOWN;
+		}
+		else
+		{
+			zbx_postgresql_error(error, result);
+			ret = db_copy_rollback();
+		}
+	}
+
+	PQclear(result);
+	zbx_free(sql);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sends binary COPY data                                            *
+ *                                                                            *
+ * Parameters: data - [IN] COPY data in PostgreSQL binary format              *
+ *             len  - [IN] data length                                        *
+ *                                                                            *
+ * Return value: ZBX_DB_OK   - data was sent                                  *
+ *               ZBX_DB_DOWN - connection to database was lost                *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_copy_put_basic(const char *data, size_t len)
+{
+	if (1 != PQputCopyData(conn, data, (int)len))
+	{
+		zbx_db_errlog(ERR_Z3005, 0, PQerrorMessage(conn), "COPY data");
+		return ZBX_DB_DOWN;
+	}
+
+	return ZBX_DB_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finishes binary COPY data transfer                                *
+ *                                                                            *
+ * Parameters: error - [OUT] the error message when data was not copied       *
+ *                                                                            *
+ * Return value: ZBX_DB_OK   - data was copied                                *
+ *               ZBX_DB_FAIL - data was not copied, the transaction is still  *
+ *                             usable                                         *
+ *               ZBX_DB_DOWN - connection to database was lost                *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_copy_end_basic(char **error)
+{
+	PGresult	*result;
+	int		ret = ZBX_DB_OK;
+
+	if (1 != PQputCopyEnd(conn, NULL))
+	{
+		zbx_db_errlog(ERR_Z3005, 0, PQerrorMessage(conn), "COPY end");
+		return ZBX_DB_DOWN;
+	}
+
+	while (NULL != (result = PQgetResult(conn)))
+	{
+		if (PGRES_COMMAND_OK != PQresultStatus(result) && ZBX_DB_OK == ret)
+		{
+			zbx_postgresql_error(error, result);
+			ret = ZBX_DB_FAIL;
+		}
+
+		PQclear(result);
+	}
+
+	if (CONNECTION_OK != PQstatus(conn))
+	{
+		zbx_db_errlog(ERR_Z3005, 0, PQerrorMessage(conn), "COPY");
+		return ZBX_DB_DOWN;
+	}
+
+	if (ZBX_DB_OK == ret)
+	{
+		if (ZBX_DB_OK == (ret = db_copy_exec_savepoint("release savepoint " ZBX_PG_COPY_SAVEPOINT)))
+			return ZBX_DB_OK;
+
+		*error = zbx_strdup(*error, "cannot release savepoint");
+	}
+
+	return ZBX_DB_DOWN == ret ? ZBX_DB_DOWN : db_copy_rollback();
+}
+#undef ZBX_PG_COPY_SAVEPOINT
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Purpose: execute a select statement                                        *
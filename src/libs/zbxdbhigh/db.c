@@ -132,6 +132,11 @@ int	zbx_db_validate_config_features(unsigned char program_type, const zbx_config
 			"MySQL library version that support configuration of TLSv1.3 ciphersuites"));
 #endif
 
+#if !defined(HAVE_POSTGRESQL)
+	err |= (FAIL == zbx_check_cfg_feature_int("DBBulkCopy", config_dbhigh->config_db_bulk_copy,
+			"PostgreSQL"));
+#endif
+
 	return 0 != err ? FAIL : SUCCEED;
 }
 
@@ -2239,6 +2244,7 @@ void	zbx_db_insert_prepare_dyn(zbx_db_insert_t *self, const zbx_db_table_t *tabl
 
 	self->autoincrement = -1;
 	self->lastid = 0;
+	self->copy = 0;
 
 	zbx_vector_db_field_ptr_create(&self->fields);
 	zbx_vector_db_value_ptr_create(&self->rows);
@@ -2337,7 +2343,8 @@ void	zbx_db_insert_add_values_dyn(zbx_db_insert_t *self, zbx_db_value_t **values
 			case ZBX_TYPE_TEXT:
 			case ZBX_TYPE_CUID:
 			case ZBX_TYPE_BLOB:
-				row[i].str = DBdyn_escape_field_len(field, value->str, ESCAPE_SEQUENCE_ON);
+				row[i].str = DBdyn_escape_field_len(field, value->str,
+						0 == self->copy ? ESCAPE_SEQUENCE_ON : ESCAPE_SEQUENCE_OFF);
 				break;
 			case ZBX_TYPE_INT:
 			case ZBX_TYPE_FLOAT:
@@ -2454,6 +2461,336 @@ static void	decode_and_escape_binary_value_for_sql(char **sql_insert_data)
 }
 #endif
 
+#ifdef HAVE_POSTGRESQL
+/* PostgreSQL binary COPY format signature, flags field and header extension length */
+static const char	copy_header[] = {'P', 'G', 'C', 'O', 'P', 'Y', '\n', '\377', '\r', '\n', '\0',
+		0, 0, 0, 0, 0, 0, 0, 0};
+
+#define ZBX_DB_COPY_BUFFER_SIZE	(ZBX_MEBIBYTE)
+
+static void	copy_buffer_reserve(char **buf, size_t *buf_alloc, size_t buf_offset, size_t len)
+{
+	if (*buf_alloc - buf_offset < len)
+	{
+		while (*buf_alloc - buf_offset < len)
+			*buf_alloc *= 2;
+
+		*buf = (char *)zbx_realloc(*buf, *buf_alloc);
+	}
+}
+
+static void	copy_buffer_add_int16(char **buf, size_t *buf_alloc, size_t *buf_offset, zbx_uint32_t value)
+{
+	unsigned char	*ptr;
+
+	copy_buffer_reserve(buf, buf_alloc, *buf_offset, 2);
+	ptr = (unsigned char *)*buf + *buf_offset;
+
+	ptr[0] = (unsigned char)(value >> 8);
+	ptr[1] = (unsigned char)value;
+
+	*buf_offset += 2;
+}
+
+static void	copy_buffer_add_int32(char **buf, size_t *buf_alloc, size_t *buf_offset, zbx_uint32_t value)
+{
+	unsigned char	*ptr;
+
+	copy_buffer_reserve(buf, buf_alloc, *buf_offset, 4);
+	ptr = (unsigned char *)*buf + *buf_offset;
+
+	for (int i = 3; 0 <= i; i--, value >>= 8)
+		ptr[i] = (unsigned char)value;
+
+	*buf_offset += 4;
+}
+
+static void	copy_buffer_add_int64(char **buf, size_t *buf_alloc, size_t *buf_offset, zbx_uint64_t value)
+{
+	unsigned char	*ptr;
+
+	copy_buffer_reserve(buf, buf_alloc, *buf_offset, 8);
+	ptr = (unsigned char *)*buf + *buf_offset;
+
+	for (int i = 7; 0 <= i; i--, value >>= 8)
+		ptr[i] = (unsigned char)value;
+
+	*buf_offset += 8;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: serializes unsigned 64 bit integer into PostgreSQL binary numeric *
+ *          format                                                            *
+ *                                                                            *
+ * Comments: numeric is stored as base 10000 digits with the weight of the    *
+ *           first digit, sign and display scale.                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	copy_buffer_add_numeric(char **buf, size_t *buf_alloc, size_t *buf_offset, zbx_uint64_t value)
+{
+#define NBASE		10000
+#define NUMERIC_POS	0x0000
+	zbx_uint32_t	digits[5];	/* 2^64 has 20 decimal digits - 5 base 10000 digits */
+	int		digits_num = 0, weight, skip = 0;
+
+	for (; 0 != value; value /= NBASE)
+		digits[digits_num++] = (zbx_uint32_t)(value % NBASE);
+
+	weight = digits_num - 1;
+
+	/* trailing zero digits are not stored */
+	while (skip < digits_num && 0 == digits[skip])
+		skip++;
+
+	copy_buffer_add_int32(buf, buf_alloc, buf_offset, (zbx_uint32_t)(8 + (digits_num - skip) * 2));
+	copy_buffer_add_int16(buf, buf_alloc, buf_offset, (zbx_uint32_t)(digits_num - skip));
+	copy_buffer_add_int16(buf, buf_alloc, buf_offset, (zbx_uint32_t)(0 > weight ? 0 : weight));
+	copy_buffer_add_int16(buf, buf_alloc, buf_offset, NUMERIC_POS);
+	copy_buffer_add_int16(buf, buf_alloc, buf_offset, 0);
+
+	for (int i = digits_num - 1; i >= skip; i--)
+		copy_buffer_add_int16(buf, buf_alloc, buf_offset, digits[i]);
+#undef NUMERIC_POS
+#undef NBASE
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: serializes bulk insert row into PostgreSQL binary COPY format     *
+ *                                                                            *
+ ******************************************************************************/
+static void	copy_buffer_add_row(char **buf, size_t *buf_alloc, size_t *buf_offset,
+		const zbx_vector_db_field_ptr_t *fields, const zbx_db_value_t *values)
+{
+	copy_buffer_add_int16(buf, buf_alloc, buf_offset, (zbx_uint32_t)fields->values_num);
+
+	for (int i = 0; i < fields->values_num; i++)
+	{
+		const zbx_db_value_t	*value = &values[i];
+		size_t			len;
+		zbx_uint64_t		dbl_bits;
+
+		switch (fields->values[i]->type)
+		{
+			case ZBX_TYPE_CHAR:
+			case ZBX_TYPE_TEXT:
+			case ZBX_TYPE_LONGTEXT:
+			case ZBX_TYPE_CUID:
+				len = strlen(value->str);
+				copy_buffer_add_int32(buf, buf_alloc, buf_offset, (zbx_uint32_t)len);
+				copy_buffer_reserve(buf, buf_alloc, *buf_offset, len);
+				memcpy(*buf + *buf_offset, value->str, len);
+				*buf_offset += len;
+				break;
+			case ZBX_TYPE_INT:
+				copy_buffer_add_int32(buf, buf_alloc, buf_offset, 4);
+				copy_buffer_add_int32(buf, buf_alloc, buf_offset, (zbx_uint32_t)value->i32);
+				break;
+			case ZBX_TYPE_FLOAT:
+				memcpy(&dbl_bits, &value->dbl, sizeof(dbl_bits));
+				copy_buffer_add_int32(buf, buf_alloc, buf_offset, 8);
+				copy_buffer_add_int64(buf, buf_alloc, buf_offset, dbl_bits);
+				break;
+			case ZBX_TYPE_UINT:
+				copy_buffer_add_numeric(buf, buf_alloc, buf_offset, value->ui64);
+				break;
+			case ZBX_TYPE_ID:
+				if (0 == value->ui64)
+				{
+					/* zero identifier is stored as NULL, see zbx_db_sql_id_ins() */
+					copy_buffer_add_int32(buf, buf_alloc, buf_offset, (zbx_uint32_t)-1);
+					break;
+				}
+				ZBX_FALLTHROUGH;
+			case ZBX_TYPE_SERIAL:
+				copy_buffer_add_int32(buf, buf_alloc, buf_offset, 8);
+				copy_buffer_add_int64(buf, buf_alloc, buf_offset, value->ui64);
+				break;
+			default:
+				THIS_SHOULD_NEVER_HAPPEN;
+				exit(EXIT_FAILURE);
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: executes bulk insert with PostgreSQL binary COPY                  *
+ *                                                                            *
+ * Parameters: self  - [IN] the bulk insert data                              *
+ *             error - [OUT] the error message when rows were not copied      *
+ *                                                                            *
+ * Return value: ZBX_DB_OK   - the rows were copied                           *
+ *               ZBX_DB_FAIL - the rows were not copied, insert can be used   *
+ *               ZBX_DB_DOWN - connection to database was lost                *
+ *                                                                            *
+ * Comments: Data is streamed to server in ZBX_DB_COPY_BUFFER_SIZE chunks to  *
+ *           bound memory usage.                                              *
+ *                                                                            *
+ ******************************************************************************/
+static int	db_insert_execute_copy(zbx_db_insert_t *self, char **error)
+{
+	char	*fields = NULL, *buf;
+	size_t	fields_alloc = 0, fields_offset = 0, buf_alloc = ZBX_DB_COPY_BUFFER_SIZE, buf_offset = 0;
+	int	ret;
+
+	for (int i = 0; i < self->fields.values_num; i++)
+	{
+		if (0 != i)
+			zbx_chrcpy_alloc(&fields, &fields_alloc, &fields_offset, ',');
+
+		zbx_strcpy_alloc(&fields, &fields_alloc, &fields_offset, self->fields.values[i]->name);
+	}
+
+	ret = zbx_db_copy_start_basic(self->table->table, fields, error);
+	zbx_free(fields);
+
+	if (ZBX_DB_OK != ret)
+		return ret;
+
+	buf = (char *)zbx_malloc(NULL, buf_alloc);
+	memcpy(buf, copy_header, sizeof(copy_header));
+	buf_offset = sizeof(copy_header);
+
+	for (int i = 0; i < self->rows.values_num; i++)
+	{
+		copy_buffer_add_row(&buf, &buf_alloc, &buf_offset, &self->fields, self->rows.values[i]);
+
+		if (ZBX_DB_COPY_BUFFER_SIZE <= buf_offset)
+		{
+			if (ZBX_DB_OK != (ret = zbx_db_copy_put_basic(buf, buf_offset)))
+				goto out;
+
+			buf_offset = 0;
+		}
+	}
+
+	/* file trailer */
+	copy_buffer_add_int16(&buf, &buf_alloc, &buf_offset, 0xffff);
+
+	ret = zbx_db_copy_put_basic(buf, buf_offset);
+out:
+	zbx_free(buf);
+
+	if (ZBX_DB_OK == ret)
+		ret = zbx_db_copy_end_basic(error);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() table:%s rows:%d ret:%d", __func__, self->table->table,
+			self->rows.values_num, ret);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: escapes string values of rows prepared for COPY so they can be    *
+ *          inserted with SQL statements                                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_insert_escape_rows(zbx_db_insert_t *self)
+{
+	for (int i = 0; i < self->rows.values_num; i++)
+	{
+		zbx_db_value_t	*row = self->rows.values[i];
+
+		for (int j = 0; j < self->fields.values_num; j++)
+		{
+			const zbx_db_field_t	*field = self->fields.values[j];
+			char			*str;
+
+			switch (field->type)
+			{
+				case ZBX_TYPE_CHAR:
+				case ZBX_TYPE_TEXT:
+				case ZBX_TYPE_LONGTEXT:
+				case ZBX_TYPE_CUID:
+					str = DBdyn_escape_field_len(field, row[j].str, ESCAPE_SEQUENCE_ON);
+					zbx_free(row[j].str);
+					row[j].str = str;
+					break;
+			}
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: logs COPY failure                                                 *
+ *                                                                            *
+ * Parameters: table - [IN] the target table                                  *
+ *             error - [IN] the error message                                 *
+ *                                                                            *
+ * Comments: COPY usually fails for the same reason on every insert, so the   *
+ *           warning is logged at most once per ZBX_DB_COPY_LOG_INTERVAL      *
+ *           seconds together with the number of failures since the last      *
+ *           warning. The rest of the failures are logged on debug level.     *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_insert_copy_log_failure(const char *table, const char *error)
+{
+#define ZBX_DB_COPY_LOG_INTERVAL	SEC_PER_MIN
+
+	static time_t	last_log_time = 0;
+	static int	failures_num = 0;
+	time_t		now;
+
+	failures_num++;
+	now = time(NULL);
+
+	if (ZBX_DB_COPY_LOG_INTERVAL <= now - last_log_time)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot copy data into table \"%s\": %s, falling back to insert"
+				" (failed %d times since the last message)", table, ZBX_NULL2EMPTY_STR(error),
+				failures_num);
+		last_log_time = now;
+		failures_num = 0;
+	}
+	else
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot copy data into table \"%s\": %s, falling back to insert",
+				table, ZBX_NULL2EMPTY_STR(error));
+	}
+
+#undef ZBX_DB_COPY_LOG_INTERVAL
+}
+
+#undef ZBX_DB_COPY_BUFFER_SIZE
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: enables binary COPY for bulk insert if it is supported by         *
+ *          database and enabled in configuration                             *
+ *                                                                            *
+ * Parameters: self - [IN] the bulk insert data                               *
+ *                                                                            *
+ * Comments: Must be called before adding values. If COPY fails the rows are  *
+ *           inserted with SQL statements.                                    *
+ *           Tables with binary or upper case converted fields are always     *
+ *           inserted with SQL statements.                                    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_db_insert_enable_copy(zbx_db_insert_t *self)
+{
+#ifdef HAVE_POSTGRESQL
+	if (NULL == zbx_cfg_dbhigh || 0 == zbx_cfg_dbhigh->config_db_bulk_copy || 0 != self->rows.values_num)
+		return;
+
+	for (int i = 0; i < self->fields.values_num; i++)
+	{
+		const zbx_db_field_t	*field = self->fields.values[i];
+
+		if (ZBX_TYPE_BLOB == field->type || 0 != (field->flags & ZBX_UPPER))
+			return;
+	}
+
+	self->copy = 1;
+#else
+	ZBX_UNUSED(self);
+#endif
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: executes the prepared database bulk insert operation              *
@@ -2497,6 +2834,31 @@ int	zbx_db_insert_execute(zbx_db_insert_t *self)
 		/* reset autoincrement so execute could be retried with the same ids */
 		self->autoincrement = -1;
 	}
+#ifdef HAVE_POSTGRESQL
+	/* COPY is rolled back to savepoint on failure, so it can be used only inside transaction */
+	if (0 != self->copy && 0 != zbx_db_txn_level() && ZBX_DB_OK == zbx_db_txn_error())
+	{
+		char	*error = NULL;
+
+		switch (db_insert_execute_copy(self, &error))
+		{
+			case ZBX_DB_OK:
+				return SUCCEED;
+			case ZBX_DB_DOWN:
+				zbx_free(error);
+				return FAIL;
+		}
+
+		db_insert_copy_log_failure(self->table->table, error);
+		zbx_free(error);
+	}
+
+	if (0 != self->copy)
+	{
+		db_insert_escape_rows(self);
+		self->copy = 0;
+	}
+#endif
 
 	sql = (char *)zbx_malloc(NULL, sql_alloc);
 	sql_command = (char *)zbx_malloc(NULL, sql_command_alloc);
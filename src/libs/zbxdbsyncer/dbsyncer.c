@@ -150,6 +150,8 @@ ZBX_THREAD_ENTRY(zbx_dbsyncer_thread, args)
 
 	zbx_rtc_subscribe(process_type, process_num, rtc_msgs, ARRSIZE(rtc_msgs), dbsyncer_args->config_timeout, &rtc);
 
+	zbx_hc_set_sync_shard(process_num);
+
 	for (;;)
 	{
 		sec = zbx_time();
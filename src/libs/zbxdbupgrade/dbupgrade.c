@@ -1137,10 +1137,24 @@ int	DBcreate_changelog_insert_trigger(const char *table_name, const char *field_
 	return ret;
 }
 
-int	DBcreate_changelog_update_trigger(const char *table_name, const char *field_name)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates changelog update trigger                                  *
+ *                                                                            *
+ * Parameters: table_name - [IN]                                              *
+ *             field_name - [IN] object identifier field                      *
+ *             columns    - [IN] comma separated list of columns, changes of  *
+ *                               which are registered in changelog (can be    *
+ *                               NULL to register all updates)                *
+ *                                                                            *
+ * Return value: SUCCEED - trigger was created successfully                   *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	DBcreate_changelog_update_trigger_ext(const char *table_name, const char *field_name, const char *columns)
 {
-	char	*sql = NULL;
-	size_t	sql_alloc = 0, sql_offset = 0;
+	char	*sql = NULL, *condition = NULL;
+	size_t	sql_alloc = 0, sql_offset = 0, condition_alloc = 0, condition_offset = 0;
 	int	table_type, ret = FAIL;
 
 	if (FAIL == (table_type = DBget_changelog_table_by_name(table_name)))
@@ -1149,13 +1163,51 @@ int	DBcreate_changelog_update_trigger(const char *table_name, const char *field_
 		return FAIL;
 	}
 
+	if (NULL != columns)
+	{
+		const char	*column, *next;
+
+		for (column = columns; NULL != column; column = (NULL != next ? next + 1 : NULL))
+		{
+			size_t	len;
+
+			if (NULL == (next = strchr(column, ',')))
+				len = strlen(column);
+			else
+				len = (size_t)(next - column);
+
+			if (0 != condition_offset)
+				zbx_strcpy_alloc(&condition, &condition_alloc, &condition_offset, " or ");
+
+			zbx_snprintf_alloc(&condition, &condition_alloc, &condition_offset, "old.%.*s<>new.%.*s",
+					(int)len, column, (int)len, column);
+		}
+	}
+
 #if HAVE_MYSQL
-	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
-			"create trigger %s_update after update on %s\n"
-				"for each row\n"
-					"insert into changelog (object,objectid,operation,clock)\n"
-						"values (%d,old.%s,%d,unix_timestamp())",
-				table_name, table_name, table_type, field_name, ZBX_CHANGELOG_OP_UPDATE);
+	if (NULL == condition)
+	{
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+				"create trigger %s_update after update on %s\n"
+					"for each row\n"
+						"insert into changelog (object,objectid,operation,clock)\n"
+							"values (%d,old.%s,%d,unix_timestamp())",
+					table_name, table_name, table_type, field_name, ZBX_CHANGELOG_OP_UPDATE);
+	}
+	else
+	{
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+				"create trigger %s_update after update on %s\n"
+					"for each row\n"
+					"begin\n"
+						"if %s then\n"
+							"insert into changelog (object,objectid,operation,clock)\n"
+								"values (%d,old.%s,%d,unix_timestamp());\n"
+						"end if;\n"
+					"end",
+					table_name, table_name, condition, table_type, field_name,
+					ZBX_CHANGELOG_OP_UPDATE);
+	}
 #elif HAVE_POSTGRESQL
 	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
 			"create or replace function changelog_%s_update() returns trigger as $$\n"
@@ -1166,20 +1218,29 @@ int	DBcreate_changelog_update_trigger(const char *table_name, const char *field_
 			"end;\n"
 			"$$ language plpgsql;\n"
 			"create trigger %s_update after update on %s\n"
-				"for each row\n"
-					"execute procedure changelog_%s_update();",
-				table_name, table_type, field_name, ZBX_CHANGELOG_OP_UPDATE, table_name, table_name,
-				table_name);
+				"for each row\n",
+				table_name, table_type, field_name, ZBX_CHANGELOG_OP_UPDATE, table_name, table_name);
+
+	if (NULL != condition)
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "when (%s)\n", condition);
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "execute procedure changelog_%s_update();", table_name);
 #endif
 
 	if (ZBX_DB_OK <= zbx_db_execute("%s", sql))
 		ret = SUCCEED;
 
+	zbx_free(condition);
 	zbx_free(sql);
 
 	return ret;
 }
 
+int	DBcreate_changelog_update_trigger(const char *table_name, const char *field_name)
+{
+	return DBcreate_changelog_update_trigger_ext(table_name, field_name, NULL);
+}
+
 int	DBcreate_changelog_delete_trigger(const char *table_name, const char *field_name)
 {
 	char	*sql = NULL;
@@ -74,6 +74,7 @@ int	DBcheck_field_type(const char *table_name, const zbx_db_field_t *field);
 
 int	DBcreate_changelog_insert_trigger(const char *table_name, const char *field_name);
 int	DBcreate_changelog_update_trigger(const char *table_name, const char *field_name);
+int	DBcreate_changelog_update_trigger_ext(const char *table_name, const char *field_name, const char *columns);
 int	DBcreate_changelog_delete_trigger(const char *table_name, const char *field_name);
 
 int	zbx_dbupgrade_attach_trigger_with_function_on_insert(const char *table_name,
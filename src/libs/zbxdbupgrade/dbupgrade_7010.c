@@ -171,6 +171,126 @@ static int	DBpatch_7010013(void)
 	return SUCCEED;
 }
 
+static int	DBpatch_7010014(void)
+{
+	return DBcreate_changelog_insert_trigger("globalmacro", "globalmacroid");
+}
+
+static int	DBpatch_7010015(void)
+{
+	return DBcreate_changelog_update_trigger("globalmacro", "globalmacroid");
+}
+
+static int	DBpatch_7010016(void)
+{
+	return DBcreate_changelog_delete_trigger("globalmacro", "globalmacroid");
+}
+
+static int	DBpatch_7010017(void)
+{
+	return DBcreate_changelog_insert_trigger("hostmacro", "hostmacroid");
+}
+
+static int	DBpatch_7010018(void)
+{
+	return DBcreate_changelog_update_trigger("hostmacro", "hostmacroid");
+}
+
+static int	DBpatch_7010019(void)
+{
+	return DBcreate_changelog_delete_trigger("hostmacro", "hostmacroid");
+}
+
+static int	DBpatch_7010020(void)
+{
+	return DBcreate_changelog_insert_trigger("hosts_templates", "hosttemplateid");
+}
+
+static int	DBpatch_7010021(void)
+{
+	return DBcreate_changelog_update_trigger_ext("hosts_templates", "hosttemplateid", "hostid,templateid");
+}
+
+static int	DBpatch_7010022(void)
+{
+	return DBcreate_changelog_delete_trigger("hosts_templates", "hosttemplateid");
+}
+
+static int	DBpatch_7010023(void)
+{
+	return DBcreate_changelog_insert_trigger("host_inventory", "hostid");
+}
+
+static int	DBpatch_7010024(void)
+{
+	return DBcreate_changelog_update_trigger("host_inventory", "hostid");
+}
+
+static int	DBpatch_7010025(void)
+{
+	return DBcreate_changelog_delete_trigger("host_inventory", "hostid");
+}
+
+static int	DBpatch_7010026(void)
+{
+	return DBcreate_changelog_insert_trigger("interface", "interfaceid");
+}
+
+static int	DBpatch_7010027(void)
+{
+	return DBcreate_changelog_update_trigger_ext("interface", "interfaceid", "hostid,main,type,useip,ip,dns,port");
+}
+
+static int	DBpatch_7010028(void)
+{
+	return DBcreate_changelog_delete_trigger("interface", "interfaceid");
+}
+
+static int	DBpatch_7010029(void)
+{
+	return DBcreate_changelog_insert_trigger("interface_snmp", "interfaceid");
+}
+
+static int	DBpatch_7010030(void)
+{
+	return DBcreate_changelog_update_trigger("interface_snmp", "interfaceid");
+}
+
+static int	DBpatch_7010031(void)
+{
+	return DBcreate_changelog_delete_trigger("interface_snmp", "interfaceid");
+}
+
+static int	DBpatch_7010032(void)
+{
+	return DBcreate_changelog_insert_trigger("item_discovery", "itemdiscoveryid");
+}
+
+static int	DBpatch_7010033(void)
+{
+	return DBcreate_changelog_update_trigger_ext("item_discovery", "itemdiscoveryid", "itemid,parent_itemid");
+}
+
+static int	DBpatch_7010034(void)
+{
+	return DBcreate_changelog_delete_trigger("item_discovery", "itemdiscoveryid");
+}
+
+static int	DBpatch_7010035(void)
+{
+	return DBcreate_changelog_insert_trigger("trigger_depends", "triggerdepid");
+}
+
+static int	DBpatch_7010036(void)
+{
+	return DBcreate_changelog_update_trigger("trigger_depends", "triggerdepid");
+}
+
+static int	DBpatch_7010037(void)
+{
+	return DBcreate_changelog_delete_trigger("trigger_depends", "triggerdepid");
+}
+
 #endif
 
 DBPATCH_START(7010)
@@ -191,5 +311,29 @@ DBPATCH_ADD(7010010, 0, 1)
 DBPATCH_ADD(7010011, 0, 1)
 DBPATCH_ADD(7010012, 0, 1)
 DBPATCH_ADD(7010013, 0, 1)
+DBPATCH_ADD(7010014, 0, 1)
+DBPATCH_ADD(7010015, 0, 1)
+DBPATCH_ADD(7010016, 0, 1)
+DBPATCH_ADD(7010017, 0, 1)
+DBPATCH_ADD(7010018, 0, 1)
+DBPATCH_ADD(7010019, 0, 1)
+DBPATCH_ADD(7010020, 0, 1)
+DBPATCH_ADD(7010021, 0, 1)
+DBPATCH_ADD(7010022, 0, 1)
+DBPATCH_ADD(7010023, 0, 1)
+DBPATCH_ADD(7010024, 0, 1)
+DBPATCH_ADD(7010025, 0, 1)
+DBPATCH_ADD(7010026, 0, 1)
+DBPATCH_ADD(7010027, 0, 1)
+DBPATCH_ADD(7010028, 0, 1)
+DBPATCH_ADD(7010029, 0, 1)
+DBPATCH_ADD(7010030, 0, 1)
+DBPATCH_ADD(7010031, 0, 1)
+DBPATCH_ADD(7010032, 0, 1)
+DBPATCH_ADD(7010033, 0, 1)
+DBPATCH_ADD(7010034, 0, 1)
+DBPATCH_ADD(7010035, 0, 1)
+DBPATCH_ADD(7010036, 0, 1)
+DBPATCH_ADD(7010037, 0, 1)
 
 DBPATCH_END()
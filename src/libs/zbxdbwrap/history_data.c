@@ -0,0 +1,436 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "history_data.h"
+
+#include "zbxjson.h"
+#include "zbxnum.h"
+#include "zbxstr.h"
+#include "zbxtime.h"
+#include "zbx_item_constants.h"
+
+/* locations of the history data row field values */
+typedef struct
+{
+	const char	*clock;
+	const char	*ns;
+	const char	*state;
+	const char	*lastlogsize;
+	const char	*mtime;
+	const char	*value;
+	const char	*timestamp;
+	const char	*source;
+	const char	*severity;
+	const char	*logeventid;
+	const char	*id;
+	const char	*itemid;
+	const char	*host;
+	const char	*key;
+}
+zbx_history_data_row_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: locates history data row fields in a single pass                  *
+ *                                                                            *
+ * Parameters: jp_row - [IN] JSON with history data row                       *
+ *             row    - [OUT] pointers to the row field values                *
+ *                                                                            *
+ * Comments: Looking up each field by name rescans the whole row, including   *
+ *           long values, once per field and for every missing optional       *
+ *           field. Instead the row is scanned once and the value locations   *
+ *           are remembered. The first occurrence of a field is used.         *
+ *                                                                            *
+ ******************************************************************************/
+static void	parse_history_data_row(const struct zbx_json_parse *jp_row, zbx_history_data_row_t *row)
+{
+	char		name[MAX_STRING_LEN];
+	const char	*p = NULL, **field;
+
+	memset(row, 0, sizeof(zbx_history_data_row_t));
+
+	while (NULL != (p = zbx_json_pair_next(jp_row, p, name, sizeof(name))))
+	{
+		switch (*name)
+		{
+			case 'c':
+				field = (0 == strcmp(name, ZBX_PROTO_TAG_CLOCK) ? &row->clock : NULL);
+				break;
+			case 'e':
+				field = (0 == strcmp(name, ZBX_PROTO_TAG_LOGEVENTID) ? &row->logeventid : NULL);
+				break;
+			case 'h':
+				field = (0 == strcmp(name, ZBX_PROTO_TAG_HOST) ? &row->host : NULL);
+				break;
+			case 'i':
+				if (0 == strcmp(name, ZBX_PROTO_TAG_ITEMID))
+					field = &row->itemid;
+				else
+					field = (0 == strcmp(name, ZBX_PROTO_TAG_ID) ? &row->id : NULL);
+				break;
+			case 'k':
+				field = (0 == strcmp(name, ZBX_PROTO_TAG_KEY) ? &row->key : NULL);
+				break;
+			case 'l':
+				field = (0 == strcmp(name, ZBX_PROTO_TAG_LASTLOGSIZE) ? &row->lastlogsize : NULL);
+				break;
+			case 'm':
+				field = (0 == strcmp(name, ZBX_PROTO_TAG_MTIME) ? &row->mtime : NULL);
+				break;
+			case 'n':
+				field = (0 == strcmp(name, ZBX_PROTO_TAG_NS) ? &row->ns : NULL);
+				break;
+			case 's':
+				if (0 == strcmp(name, ZBX_PROTO_TAG_STATE))
+					field = &row->state;
+				else if (0 == strcmp(name, ZBX_PROTO_TAG_LOGSOURCE))
+					field = &row->source;
+				else
+					field = (0 == strcmp(name, ZBX_PROTO_TAG_LOGSEVERITY) ? &row->severity : NULL);
+				break;
+			case 't':
+				field = (0 == strcmp(name, ZBX_PROTO_TAG_LOGTIMESTAMP) ? &row->timestamp : NULL);
+				break;
+			case 'v':
+				field = (0 == strcmp(name, ZBX_PROTO_TAG_VALUE) ? &row->value : NULL);
+				break;
+			default:
+				field = NULL;
+		}
+
+		if (NULL != field && NULL == *field)
+			*field = p;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: decodes history data row field value                              *
+ *                                                                            *
+ * Parameters: p            - [IN] the field value location, can be NULL      *
+ *             string       - [IN/OUT] the decoded value                      *
+ *             string_alloc - [IN/OUT] the decoded value buffer size          *
+ *                                                                            *
+ * Return value:  SUCCEED - the value was decoded successfully                *
+ *                FAIL    - the field is missing or has invalid value         *
+ *                                                                            *
+ ******************************************************************************/
+static int	history_data_row_field(const char *p, char **string, size_t *string_alloc)
+{
+	if (NULL == p || NULL == zbx_json_decodevalue_dyn(p, string, string_alloc, NULL))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: parses agent value from history data json row                     *
+ *                                                                            *
+ * Parameters: row          - [IN] the history data row fields                *
+ *             unique_shift - [IN/OUT] auto increment nanoseconds to ensure   *
+ *                                     unique value of timestamps             *
+ *             av           - [OUT] the agent value                           *
+ *                                                                            *
+ * Return value:  SUCCEED - the value was parsed successfully                 *
+ *                FAIL    - otherwise                                         *
+ *                                                                            *
+ ******************************************************************************/
+static int	parse_history_data_row_value(const zbx_history_data_row_t *row, zbx_timespec_t *unique_shift,
+		zbx_agent_value_t *av)
+{
+	char	*tmp = NULL;
+	size_t	tmp_alloc = 0;
+	int	ret = FAIL;
+
+	memset(av, 0, sizeof(zbx_agent_value_t));
+
+	if (SUCCEED == history_data_row_field(row->clock, &tmp, &tmp_alloc))
+	{
+		if (FAIL == zbx_is_uint31(tmp, &av->ts.sec))
+			goto out;
+
+		if (SUCCEED == history_data_row_field(row->ns, &tmp, &tmp_alloc))
+		{
+			if (FAIL == zbx_is_uint_n_range(tmp, tmp_alloc, &av->ts.ns, sizeof(av->ts.ns),
+				0LL, 999999999LL))
+			{
+				goto out;
+			}
+		}
+		else
+		{
+			/* ensure unique value timestamp (clock, ns) if only clock is available */
+
+			av->ts.sec += unique_shift->sec;
+			av->ts.ns = unique_shift->ns++;
+
+			if (unique_shift->ns > 999999999)
+			{
+				unique_shift->sec++;
+				unique_shift->ns = 0;
+			}
+		}
+	}
+	else
+		zbx_timespec(&av->ts);
+
+	if (SUCCEED == history_data_row_field(row->state, &tmp, &tmp_alloc))
+		av->state = (unsigned char)atoi(tmp);
+
+	/* Unsupported item meta information must be ignored for backwards compatibility. */
+	/* New agents will not send meta information for items in unsupported state.      */
+	if (ITEM_STATE_NOTSUPPORTED != av->state)
+	{
+		if (SUCCEED == history_data_row_field(row->lastlogsize, &tmp, &tmp_alloc))
+		{
+			av->meta = 1;	/* contains meta information */
+
+			zbx_is_uint64(tmp, &av->lastlogsize);
+
+			if (SUCCEED == history_data_row_field(row->mtime, &tmp, &tmp_alloc))
+				av->mtime = atoi(tmp);
+		}
+	}
+
+	if (SUCCEED == history_data_row_field(row->value, &tmp, &tmp_alloc))
+		av->value = zbx_strdup(av->value, tmp);
+
+	if (SUCCEED == history_data_row_field(row->timestamp, &tmp, &tmp_alloc))
+		av->timestamp = atoi(tmp);
+
+	if (SUCCEED == history_data_row_field(row->source, &tmp, &tmp_alloc))
+		av->source = zbx_strdup(av->source, tmp);
+
+	if (SUCCEED == history_data_row_field(row->severity, &tmp, &tmp_alloc))
+		av->severity = atoi(tmp);
+
+	if (SUCCEED == history_data_row_field(row->logeventid, &tmp, &tmp_alloc))
+		av->logeventid = atoi(tmp);
+
+	if (SUCCEED != history_data_row_field(row->id, &tmp, &tmp_alloc) || SUCCEED != zbx_is_uint64(tmp, &av->id))
+		av->id = 0;
+
+	ret = SUCCEED;
+out:
+	zbx_free(tmp);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: parses item identifier from history data json row                 *
+ *                                                                            *
+ * Parameters: row    - [IN] the history data row fields                      *
+ *             itemid - [OUT] the item identifier                             *
+ *                                                                            *
+ * Return value:  SUCCEED - the item identifier was parsed successfully       *
+ *                FAIL    - otherwise                                         *
+ *                                                                            *
+ ******************************************************************************/
+static int	parse_history_data_row_itemid(const zbx_history_data_row_t *row, zbx_uint64_t *itemid)
+{
+	char	buffer[MAX_ID_LEN + 1];
+
+	if (NULL == row->itemid || NULL == zbx_json_decodevalue(row->itemid, buffer, sizeof(buffer), NULL))
+		return FAIL;
+
+	if (SUCCEED != zbx_is_uint64(buffer, itemid))
+		return FAIL;
+
+	return SUCCEED;
+}
+/******************************************************************************
+ *                                                                            *
+ * Purpose: parses host,key pair from history data json row                   *
+ *                                                                            *
+ * Parameters: row - [IN] the history data row fields                         *
+ *             hk  - [OUT] the host,key pair                                  *
+ *                                                                            *
+ * Return value:  SUCCEED - the host,key pair was parsed successfully         *
+ *                FAIL    - otherwise                                         *
+ *                                                                            *
+ ******************************************************************************/
+static int	parse_history_data_row_hostkey(const zbx_history_data_row_t *row, zbx_host_key_t *hk)
+{
+	size_t str_alloc;
+
+	str_alloc = 0;
+	zbx_free(hk->host);
+
+	if (SUCCEED != history_data_row_field(row->host, &hk->host, &str_alloc))
+		return FAIL;
+
+	str_alloc = 0;
+	zbx_free(hk->key);
+
+	if (SUCCEED != history_data_row_field(row->key, &hk->key, &str_alloc))
+	{
+		zbx_free(hk->host);
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: parses up to ZBX_HISTORY_VALUES_MAX item values and host,key      *
+ *          pairs from history data json                                      *
+ *                                                                            *
+ * Parameters: jp_data      - [IN] JSON with history data array               *
+ *             pnext        - [IN/OUT] the pointer to the next item in json,  *
+ *                                     NULL - no more data left               *
+ *             values       - [OUT] the item values                           *
+ *             hostkeys     - [OUT] the corresponding host,key pairs          *
+ *             values_num   - [OUT] number of elements in values and hostkeys *
+ *                                  arrays                                    *
+ *             parsed_num   - [OUT] the number of values parsed               *
+ *             unique_shift - [IN/OUT] auto increment nanoseconds to ensure   *
+ *                                     unique value of timestamps             *
+ *                                                                            *
+ * Return value:  SUCCEED - values were parsed successfully                   *
+ *                FAIL    - an error occurred                                 *
+ *                                                                            *
+ ******************************************************************************/
+int	parse_history_data(struct zbx_json_parse *jp_data, const char **pnext, zbx_agent_value_t *values,
+		zbx_host_key_t *hostkeys, int *values_num, int *parsed_num, zbx_timespec_t *unique_shift)
+{
+	struct zbx_json_parse	jp_row;
+	zbx_history_data_row_t	row;
+	int			ret = FAIL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	*values_num = 0;
+	*parsed_num = 0;
+
+	if (NULL == *pnext)
+	{
+		if (NULL == (*pnext = zbx_json_next(jp_data, *pnext)) && *values_num < ZBX_HISTORY_VALUES_MAX)
+		{
+			ret = SUCCEED;
+			goto out;
+		}
+	}
+
+	/* iterate the history data rows */
+	do
+	{
+		if (FAIL == zbx_json_brackets_open(*pnext, &jp_row))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "%s", zbx_json_strerror());
+			goto out;
+		}
+
+		(*parsed_num)++;
+
+		parse_history_data_row(&jp_row, &row);
+
+		if (SUCCEED != parse_history_data_row_hostkey(&row, &hostkeys[*values_num]))
+			continue;
+
+		if (SUCCEED != parse_history_data_row_value(&row, unique_shift, &values[*values_num]))
+			continue;
+
+		(*values_num)++;
+	}
+	while (NULL != (*pnext = zbx_json_next(jp_data, *pnext)) && *values_num < ZBX_HISTORY_VALUES_MAX);
+
+	ret = SUCCEED;
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s processed:%d/%d", __func__, zbx_result_string(ret),
+			*values_num, *parsed_num);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: parses up to ZBX_HISTORY_VALUES_MAX item values and item          *
+ *          identifiers from history data json                                *
+ *                                                                            *
+ * Parameters: jp_data      - [IN] JSON with history data array               *
+ *             pnext        - [IN/OUT] the pointer to the next item in        *
+ *                                        json, NULL - no more data left      *
+ *             values       - [OUT] the item values                           *
+ *             itemids      - [OUT] the corresponding item identifiers        *
+ *             values_num   - [OUT] number of elements in values and itemids  *
+ *                                  arrays                                    *
+ *             parsed_num   - [OUT] the number of values parsed               *
+ *             unique_shift - [IN/OUT] auto increment nanoseconds to ensure   *
+ *                                     unique value of timestamps             *
+ *             info         - [OUT] address of a pointer to the info string   *
+ *                                  (should be freed by the caller)           *
+ *                                                                            *
+ * Return value:  SUCCEED - values were parsed successfully                   *
+ *                FAIL    - an error occurred                                 *
+ *                                                                            *
+ * Comments: This function is used to parse the new proxy history data        *
+ *           protocol introduced in Zabbix v3.3.                              *
+ *                                                                            *
+ ******************************************************************************/
+int	parse_history_data_by_itemids(struct zbx_json_parse *jp_data, const char **pnext,
+		zbx_agent_value_t *values, zbx_uint64_t *itemids, int *values_num, int *parsed_num,
+		zbx_timespec_t *unique_shift, char **error)
+{
+	struct zbx_json_parse	jp_row;
+	zbx_history_data_row_t	row;
+	int			ret = FAIL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	*values_num = 0;
+	*parsed_num = 0;
+
+	if (NULL == *pnext)
+	{
+		if (NULL == (*pnext = zbx_json_next(jp_data, *pnext)) && *values_num < ZBX_HISTORY_VALUES_MAX)
+		{
+			ret = SUCCEED;
+			goto out;
+		}
+	}
+
+	/* iterate the history data rows */
+	do
+	{
+		if (FAIL == zbx_json_brackets_open(*pnext, &jp_row))
+		{
+			*error = zbx_strdup(*error, zbx_json_strerror());
+			goto out;
+		}
+
+		(*parsed_num)++;
+
+		parse_history_data_row(&jp_row, &row);
+
+		if (SUCCEED != parse_history_data_row_itemid(&row, &itemids[*values_num]))
+			continue;
+
+		if (SUCCEED != parse_history_data_row_value(&row, unique_shift, &values[*values_num]))
+			continue;
+
+		(*values_num)++;
+	}
+	while (NULL != (*pnext = zbx_json_next(jp_data, *pnext)) && *values_num < ZBX_HISTORY_VALUES_MAX);
+
+	ret = SUCCEED;
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s processed:%d/%d", __func__, zbx_result_string(ret),
+			*values_num, *parsed_num);
+
+	return ret;
+}
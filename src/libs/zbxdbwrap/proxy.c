@@ -13,6 +13,7 @@
 **/
 
 #include "zbxdbwrap.h"
+#include "history_data.h"
 
 #include "zbxdbhigh.h"
 #include "zbxsysinfo.h"
@@ -49,7 +50,6 @@
 #define ZBX_DATA_JSON_BATCH_LIMIT	((ZBX_MAX_RECV_DATA_SIZE - ZBX_DATA_JSON_RESERVED) / 2)
 
 /* the maximum number of values processed in one batch */
-#define ZBX_HISTORY_VALUES_MAX		256
 
 typedef struct
 {
@@ -395,7 +395,7 @@ int	zbx_check_access_passive_proxy(zbx_socket_t *sock, int send_response, const
 	}
 	else if (ZBX_TCP_SEC_TLS_PSK == sock->connection_type)
 	{
-		if (0 != (ZBX_PSK_FOR_PROXY & zbx_tls_get_psk_usage()))
+		if (0 != (ZBX_PSK_FOR_PROXY & zbx_tls_get_psk_usage(sock)))
 			return SUCCEED;
 
 		zabbix_log(LOG_LEVEL_WARNING, "%s from server \"%s\" is not allowed: it used PSK which is not"
@@ -868,304 +868,6 @@ static void	log_client_timediff(int level, struct zbx_json_parse *jp, const zbx_
 	}
 }
 
-/******************************************************************************
- *                                                                            *
- * Purpose: parses agent value from history data json row                     *
- *                                                                            *
- * Parameters: jp_row       - [IN] JSON with history data row                 *
- *             unique_shift - [IN/OUT] auto increment nanoseconds to ensure   *
- *                                     unique value of timestamps             *
- *             av           - [OUT] the agent value                           *
- *                                                                            *
- * Return value:  SUCCEED - the value was parsed successfully                 *
- *                FAIL    - otherwise                                         *
- *                                                                            *
- ******************************************************************************/
-static int	parse_history_data_row_value(const struct zbx_json_parse *jp_row, zbx_timespec_t *unique_shift,
-		zbx_agent_value_t *av)
-{
-	char	*tmp = NULL;
-	size_t	tmp_alloc = 0;
-	int	ret = FAIL;
-
-	memset(av, 0, sizeof(zbx_agent_value_t));
-
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_CLOCK, &tmp, &tmp_alloc, NULL))
-	{
-		if (FAIL == zbx_is_uint31(tmp, &av->ts.sec))
-			goto out;
-
-		if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_NS, &tmp, &tmp_alloc, NULL))
-		{
-			if (FAIL == zbx_is_uint_n_range(tmp, tmp_alloc, &av->ts.ns, sizeof(av->ts.ns),
-				0LL, 999999999LL))
-			{
-				goto out;
-			}
-		}
-		else
-		{
-			/* ensure unique value timestamp (clock, ns) if only clock is available */
-
-			av->ts.sec += unique_shift->sec;
-			av->ts.ns = unique_shift->ns++;
-
-			if (unique_shift->ns > 999999999)
-			{
-				unique_shift->sec++;
-				unique_shift->ns = 0;
-			}
-		}
-	}
-	else
-		zbx_timespec(&av->ts);
-
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_STATE, &tmp, &tmp_alloc, NULL))
-		av->state = (unsigned char)atoi(tmp);
-
-	/* Unsupported item meta information must be ignored for backwards compatibility. */
-	/* New agents will not send meta information for items in unsupported state.      */
-	if (ITEM_STATE_NOTSUPPORTED != av->state)
-	{
-		if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_LASTLOGSIZE, &tmp, &tmp_alloc, NULL))
-		{
-			av->meta = 1;	/* contains meta information */
-
-			zbx_is_uint64(tmp, &av->lastlogsize);
-
-			if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_MTIME, &tmp, &tmp_alloc, NULL))
-				av->mtime = atoi(tmp);
-		}
-	}
-
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_VALUE, &tmp, &tmp_alloc, NULL))
-		av->value = zbx_strdup(av->value, tmp);
-
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_LOGTIMESTAMP, &tmp, &tmp_alloc, NULL))
-		av->timestamp = atoi(tmp);
-
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_LOGSOURCE, &tmp, &tmp_alloc, NULL))
-		av->source = zbx_strdup(av->source, tmp);
-
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_LOGSEVERITY, &tmp, &tmp_alloc, NULL))
-		av->severity = atoi(tmp);
-
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_LOGEVENTID, &tmp, &tmp_alloc, NULL))
-		av->logeventid = atoi(tmp);
-
-	if (SUCCEED != zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_ID, &tmp, &tmp_alloc, NULL) ||
-			SUCCEED != zbx_is_uint64(tmp, &av->id))
-	{
-		av->id = 0;
-	}
-
-	zbx_free(tmp);
-
-	ret = SUCCEED;
-out:
-	return ret;
-}
-
-/******************************************************************************
- *                                                                            *
- * Purpose: parses item identifier from history data json row                 *
- *                                                                            *
- * Parameters: jp_row - [IN] JSON with history data row                       *
- *             itemid - [OUT] the item identifier                             *
- *                                                                            *
- * Return value:  SUCCEED - the item identifier was parsed successfully       *
- *                FAIL    - otherwise                                         *
- *                                                                            *
- ******************************************************************************/
-static int	parse_history_data_row_itemid(const struct zbx_json_parse *jp_row, zbx_uint64_t *itemid)
-{
-	char	buffer[MAX_ID_LEN + 1];
-
-	if (SUCCEED != zbx_json_value_by_name(jp_row, ZBX_PROTO_TAG_ITEMID, buffer, sizeof(buffer), NULL))
-		return FAIL;
-
-	if (SUCCEED != zbx_is_uint64(buffer, itemid))
-		return FAIL;
-
-	return SUCCEED;
-}
-/******************************************************************************
- *                                                                            *
- * Purpose: parses host,key pair from history data json row                   *
- *                                                                            *
- * Parameters: jp_row - [IN] JSON with history data row                       *
- *             hk     - [OUT] the host,key pair                               *
- *                                                                            *
- * Return value:  SUCCEED - the host,key pair was parsed successfully         *
- *                FAIL    - otherwise                                         *
- *                                                                            *
- ******************************************************************************/
-static int	parse_history_data_row_hostkey(const struct zbx_json_parse *jp_row, zbx_host_key_t *hk)
-{
-	size_t str_alloc;
-
-	str_alloc = 0;
-	zbx_free(hk->host);
-
-	if (SUCCEED != zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_HOST, &hk->host, &str_alloc, NULL))
-		return FAIL;
-
-	str_alloc = 0;
-	zbx_free(hk->key);
-
-	if (SUCCEED != zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_KEY, &hk->key, &str_alloc, NULL))
-	{
-		zbx_free(hk->host);
-		return FAIL;
-	}
-
-	return SUCCEED;
-}
-
-/******************************************************************************
- *                                                                            *
- * Purpose: parses up to ZBX_HISTORY_VALUES_MAX item values and host,key      *
- *          pairs from history data json                                      *
- *                                                                            *
- * Parameters: jp_data      - [IN] JSON with history data array               *
- *             pnext        - [IN/OUT] the pointer to the next item in json,  *
- *                                     NULL - no more data left               *
- *             values       - [OUT] the item values                           *
- *             hostkeys     - [OUT] the corresponding host,key pairs          *
- *             values_num   - [OUT] number of elements in values and hostkeys *
- *                                  arrays                                    *
- *             parsed_num   - [OUT] the number of values parsed               *
- *             unique_shift - [IN/OUT] auto increment nanoseconds to ensure   *
- *                                     unique value of timestamps             *
- *                                                                            *
- * Return value:  SUCCEED - values were parsed successfully                   *
- *                FAIL    - an error occurred                                 *
- *                                                                            *
- ******************************************************************************/
-static int	parse_history_data(struct zbx_json_parse *jp_data, const char **pnext, zbx_agent_value_t *values,
-		zbx_host_key_t *hostkeys, int *values_num, int *parsed_num, zbx_timespec_t *unique_shift)
-{
-	struct zbx_json_parse	jp_row;
-	int			ret = FAIL;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
-
-	*values_num = 0;
-	*parsed_num = 0;
-
-	if (NULL == *pnext)
-	{
-		if (NULL == (*pnext = zbx_json_next(jp_data, *pnext)) && *values_num < ZBX_HISTORY_VALUES_MAX)
-		{
-			ret = SUCCEED;
-			goto out;
-		}
-	}
-
-	/* iterate the history data rows */
-	do
-	{
-		if (FAIL == zbx_json_brackets_open(*pnext, &jp_row))
-		{
-			zabbix_log(LOG_LEVEL_WARNING, "%s", zbx_json_strerror());
-			goto out;
-		}
-
-		(*parsed_num)++;
-
-		if (SUCCEED != parse_history_data_row_hostkey(&jp_row, &hostkeys[*values_num]))
-			continue;
-
-		if (SUCCEED != parse_history_data_row_value(&jp_row, unique_shift, &values[*values_num]))
-			continue;
-
-		(*values_num)++;
-	}
-	while (NULL != (*pnext = zbx_json_next(jp_data, *pnext)) && *values_num < ZBX_HISTORY_VALUES_MAX);
-
-	ret = SUCCEED;
-out:
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s processed:%d/%d", __func__, zbx_result_string(ret),
-			*values_num, *parsed_num);
-
-	return ret;
-}
-
-/******************************************************************************
- *                                                                            *
- * Purpose: parses up to ZBX_HISTORY_VALUES_MAX item values and item          *
- *          identifiers from history data json                                *
- *                                                                            *
- * Parameters: jp_data      - [IN] JSON with history data array               *
- *             pnext        - [IN/OUT] the pointer to the next item in        *
- *                                        json, NULL - no more data left      *
- *             values       - [OUT] the item values                           *
- *             itemids      - [OUT] the corresponding item identifiers        *
- *             values_num   - [OUT] number of elements in values and itemids  *
- *                                  arrays                                    *
- *             parsed_num   - [OUT] the number of values parsed               *
- *             unique_shift - [IN/OUT] auto increment nanoseconds to ensure   *
- *                                     unique value of timestamps             *
- *             info         - [OUT] address of a pointer to the info string   *
- *                                  (should be freed by the caller)           *
- *                                                                            *
- * Return value:  SUCCEED - values were parsed successfully                   *
- *                FAIL    - an error occurred                                 *
- *                                                                            *
- * Comments: This function is used to parse the new proxy history data        *
- *           protocol introduced in Zabbix v3.3.                              *
- *                                                                            *
- ******************************************************************************/
-static int	parse_history_data_by_itemids(struct zbx_json_parse *jp_data, const char **pnext,
-		zbx_agent_value_t *values, zbx_uint64_t *itemids, int *values_num, int *parsed_num,
-		zbx_timespec_t *unique_shift, char **error)
-{
-	struct zbx_json_parse	jp_row;
-	int			ret = FAIL;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
-
-	*values_num = 0;
-	*parsed_num = 0;
-
-	if (NULL == *pnext)
-	{
-		if (NULL == (*pnext = zbx_json_next(jp_data, *pnext)) && *values_num < ZBX_HISTORY_VALUES_MAX)
-		{
-			ret = SUCCEED;
-			goto out;
-		}
-	}
-
-	/* iterate the history data rows */
-	do
-	{
-		if (FAIL == zbx_json_brackets_open(*pnext, &jp_row))
-		{
-			*error = zbx_strdup(*error, zbx_json_strerror());
-			goto out;
-		}
-
-		(*parsed_num)++;
-
-		if (SUCCEED != parse_history_data_row_itemid(&jp_row, &itemids[*values_num]))
-			continue;
-
-		if (SUCCEED != parse_history_data_row_value(&jp_row, unique_shift, &values[*values_num]))
-			continue;
-
-		(*values_num)++;
-	}
-	while (NULL != (*pnext = zbx_json_next(jp_data, *pnext)) && *values_num < ZBX_HISTORY_VALUES_MAX);
-
-	ret = SUCCEED;
-out:
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s processed:%d/%d", __func__, zbx_result_string(ret),
-			*values_num, *parsed_num);
-
-	return ret;
-}
-
 /******************************************************************************
  *                                                                            *
  * Purpose: validates item received from proxy                                *
@@ -32,6 +32,7 @@
 #define ZBX_DIAG_HISTORYCACHE_VALUES		0x00000002
 #define ZBX_DIAG_HISTORYCACHE_MEMORY_DATA	0x00000004
 #define ZBX_DIAG_HISTORYCACHE_MEMORY_INDEX	0x00000008
+#define ZBX_DIAG_HISTORYCACHE_SHARDS		0x00000010
 
 #define ZBX_DIAG_HISTORYCACHE_SIMPLE	(ZBX_DIAG_HISTORYCACHE_ITEMS | \
 					ZBX_DIAG_HISTORYCACHE_VALUES)
@@ -197,6 +198,43 @@ void	zbx_diag_add_mem_stats(struct zbx_json *json, const char *name, const zbx_s
 
 	zbx_json_close(json);
 	zbx_json_close(json);
+
+	zbx_json_addobject(json, "fragmentation");
+	zbx_json_addfloat(json, "heap", stats->heap_fragmentation);
+
+	if (0 != stats->slabs_enabled)
+		zbx_json_addfloat(json, "slabs", stats->slab_fragmentation);
+
+	zbx_json_close(json);
+
+	if (0 != stats->slabs_enabled)
+	{
+		zbx_json_addobject(json, "slabs");
+		zbx_json_adduint64(json, "num", stats->slabs_num);
+		zbx_json_adduint64(json, "size", stats->slab_size);
+		zbx_json_adduint64(json, "free", stats->slab_free_size);
+
+		zbx_json_addarray(json, "classes");
+
+		for (i = 0; i < ZBX_SHMEM_SLAB_CLASS_COUNT; i++)
+		{
+			const zbx_shmem_slab_stats_t	*class_stats = &stats->slab_classes[i];
+
+			if (0 == class_stats->slabs_num)
+				continue;
+
+			zbx_json_addobject(json, NULL);
+			zbx_json_adduint64(json, "size", class_stats->object_size);
+			zbx_json_adduint64(json, "slabs", class_stats->slabs_num);
+			zbx_json_adduint64(json, "used", class_stats->used_objects);
+			zbx_json_adduint64(json, "free", class_stats->free_objects);
+			zbx_json_close(json);
+		}
+
+		zbx_json_close(json);
+		zbx_json_close(json);
+	}
+
 	zbx_json_close(json);
 }
 
@@ -260,12 +298,14 @@ int	zbx_diag_add_historycache_info(const struct zbx_json_parse *jp, struct zbx_j
 	zbx_uint64_t			fields;
 	zbx_diag_map_t			field_map[] = {
 							{"", ZBX_DIAG_HISTORYCACHE_SIMPLE |
-								ZBX_DIAG_HISTORYCACHE_MEMORY},
+								ZBX_DIAG_HISTORYCACHE_MEMORY |
+								ZBX_DIAG_HISTORYCACHE_SHARDS},
 							{"items", ZBX_DIAG_HISTORYCACHE_ITEMS},
 							{"values", ZBX_DIAG_HISTORYCACHE_VALUES},
 							{"memory", ZBX_DIAG_HISTORYCACHE_MEMORY},
 							{"memory.data", ZBX_DIAG_HISTORYCACHE_MEMORY_DATA},
 							{"memory.index", ZBX_DIAG_HISTORYCACHE_MEMORY_INDEX},
+							{"shards", ZBX_DIAG_HISTORYCACHE_SHARDS},
 							{NULL, 0}
 						};
 
@@ -310,6 +350,34 @@ int	zbx_diag_add_historycache_info(const struct zbx_json_parse *jp, struct zbx_j
 			zbx_json_close(json);
 		}
 
+		if (0 != (fields & ZBX_DIAG_HISTORYCACHE_SHARDS))
+		{
+			zbx_hc_shard_stats_t	shards[ZBX_HC_SHARDS_MAX];
+			int			shards_num;
+
+			time1 = zbx_time();
+			shards_num = zbx_hc_get_shard_stats(shards);
+			time2 = zbx_time();
+			time_total += time2 - time1;
+
+			zbx_json_addarray(json, "shards");
+
+			for (i = 0; i < shards_num; i++)
+			{
+				zbx_json_addobject(json, NULL);
+				zbx_json_adduint64(json, "items", shards[i].items_num);
+				zbx_json_adduint64(json, "values", shards[i].values_num);
+				zbx_json_adduint64(json, "queue", shards[i].queue_num);
+				zbx_json_adduint64(json, "used", shards[i].mem_used);
+				zbx_json_adduint64(json, "total", shards[i].mem_total);
+				zbx_json_addfloat(json, "pused", 100 * (double)shards[i].mem_used /
+						shards[i].mem_total);
+				zbx_json_close(json);
+			}
+
+			zbx_json_close(json);
+		}
+
 		if (0 != tops.values_num)
 		{
 			zbx_json_addobject(json, "top");
@@ -416,14 +484,20 @@ void	zbx_diag_add_locks_info(struct zbx_json *json)
 				"ZBX_MUTEX_VALUECACHE", "ZBX_MUTEX_VMWARE", "ZBX_MUTEX_SQLITE3",
 				"ZBX_MUTEX_PROCSTAT", "ZBX_MUTEX_PROXY_HISTORY", "ZBX_MUTEX_KSTAT", "ZBX_MUTEX_MODBUS",
 				"ZBX_MUTEX_TREND_FUNC", "ZBX_MUTEX_REMOTE_COMMANDS", "ZBX_MUTEX_PROXY_BUFFER",
-				"ZBX_MUTEX_VPS_MONITOR"};
+				"ZBX_MUTEX_PROXY_BUFFER_FILE", "ZBX_MUTEX_VPS_MONITOR", "ZBX_MUTEX_CACHE_INDEX",
+				"ZBX_MUTEX_CACHE_SHARD_0", "ZBX_MUTEX_CACHE_SHARD_1", "ZBX_MUTEX_CACHE_SHARD_2",
+				"ZBX_MUTEX_CACHE_SHARD_3", "ZBX_MUTEX_CACHE_SHARD_4", "ZBX_MUTEX_CACHE_SHARD_5",
+				"ZBX_MUTEX_CACHE_SHARD_6", "ZBX_MUTEX_CACHE_SHARD_7"};
 #else
 	const char	*names[ZBX_MUTEX_COUNT] = {"ZBX_MUTEX_LOG", "ZBX_MUTEX_CACHE", "ZBX_MUTEX_TRENDS",
 				"ZBX_MUTEX_CACHE_IDS", "ZBX_MUTEX_SELFMON", "ZBX_MUTEX_CPUSTATS", "ZBX_MUTEX_DISKSTATS",
 				"ZBX_MUTEX_VALUECACHE", "ZBX_MUTEX_VMWARE", "ZBX_MUTEX_SQLITE3",
 				"ZBX_MUTEX_PROCSTAT", "ZBX_MUTEX_PROXY_HISTORY", "ZBX_MUTEX_MODBUS",
 				"ZBX_MUTEX_TREND_FUNC", "ZBX_MUTEX_REMOTE_COMMANDS", "ZBX_MUTEX_PROXY_BUFFER",
-				"ZBX_MUTEX_VPS_MONITOR"};
+				"ZBX_MUTEX_PROXY_BUFFER_FILE", "ZBX_MUTEX_VPS_MONITOR", "ZBX_MUTEX_CACHE_INDEX",
+				"ZBX_MUTEX_CACHE_SHARD_0", "ZBX_MUTEX_CACHE_SHARD_1", "ZBX_MUTEX_CACHE_SHARD_2",
+				"ZBX_MUTEX_CACHE_SHARD_3", "ZBX_MUTEX_CACHE_SHARD_4", "ZBX_MUTEX_CACHE_SHARD_5",
+				"ZBX_MUTEX_CACHE_SHARD_6", "ZBX_MUTEX_CACHE_SHARD_7"};
 #endif
 	zbx_json_addarray(json, ZBX_DIAG_LOCKS);
 
@@ -701,6 +775,7 @@ static void	diag_log_history_cache(struct zbx_json_parse *jp, char **out, size_t
 	diag_log_memory_info(jp, "memory.data", "$.memory.data", out, out_alloc, out_offset);
 	diag_log_memory_info(jp, "memory.index", "$.memory.index", out, out_alloc, out_offset);
 
+	diag_log_top_view(jp, "shards", "$.shards", out, out_alloc, out_offset);
 	diag_log_top_view(jp, "top.values", "$.top.values", out, out_alloc, out_offset);
 
 	zbx_strlog_alloc(LOG_LEVEL_INFORMATION, out, out_alloc, out_offset, "==");
@@ -736,7 +811,8 @@ static void	diag_log_value_cache(struct zbx_json_parse *jp, char **out, size_t *
  ******************************************************************************/
 static void	diag_log_preprocessing(struct zbx_json_parse *jp, char **out, size_t *out_alloc, size_t *out_offset)
 {
-	char	*msg = NULL;
+	char			*msg = NULL;
+	struct zbx_json_parse	jp_queue;
 
 	zbx_strlog_alloc(LOG_LEVEL_INFORMATION, out, out_alloc, out_offset, "== preprocessing diagnostic information ==");
 
@@ -744,6 +820,13 @@ static void	diag_log_preprocessing(struct zbx_json_parse *jp, char **out, size_t
 	zbx_strlog_alloc(LOG_LEVEL_INFORMATION, out, out_alloc, out_offset, "%s", msg);
 	zbx_free(msg);
 
+	if (SUCCEED == zbx_json_brackets_by_name(jp, "queue", &jp_queue))
+	{
+		diag_get_simple_values(&jp_queue, &msg);
+		zbx_strlog_alloc(LOG_LEVEL_INFORMATION, out, out_alloc, out_offset, "queue: %s", msg);
+		zbx_free(msg);
+	}
+
 	diag_log_top_view(jp, "top.sequences", "$.top.sequences", out, out_alloc, out_offset);
 
 	zbx_strlog_alloc(LOG_LEVEL_INFORMATION, out, out_alloc, out_offset, "==");
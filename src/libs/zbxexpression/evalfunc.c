@@ -1111,55 +1111,73 @@ static int	evaluate_COUNT(zbx_variant_t *value, const zbx_dc_evaluate_item_t *it
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (COUNT_ALL == unique && OP_ANY == pdata.op)
 	{
-		*error = zbx_strdup(*error, "cannot get values from value cache");
-		goto clean;
-	}
+		zbx_vc_aggregate_t	aggregate;
 
-	if (COUNT_UNIQUE == unique)
-	{
-		switch (item->value_type)
+		/* only the number of values is required, count them without copying from value cache */
+		if (FAIL == zbx_vc_get_aggregate(item->itemid, item->value_type, seconds, nvalues, &ts_end,
+				&aggregate))
 		{
-			case ITEM_VALUE_TYPE_UINT64:
-				zbx_vector_history_record_sort(&values,
-						(zbx_compare_func_t)history_record_uint64_compare);
-				zbx_vector_history_record_uniq(&values,
-						(zbx_compare_func_t)history_record_uint64_compare);
-				break;
-			case ITEM_VALUE_TYPE_FLOAT:
-				zbx_vector_history_record_sort(&values,
-						(zbx_compare_func_t)zbx_history_record_float_compare);
-				zbx_vector_history_record_uniq(&values,
-						(zbx_compare_func_t)zbx_history_record_float_compare);
-				break;
-			case ITEM_VALUE_TYPE_LOG:
-				zbx_vector_history_record_sort(&values,
-						(zbx_compare_func_t)history_record_log_compare);
-				zbx_vector_history_record_log_uniq(&values,
-						(zbx_compare_func_t)history_record_log_compare);
-				break;
-			default:
-				zbx_vector_history_record_sort(&values,
-						(zbx_compare_func_t)history_record_str_compare);
-				zbx_vector_history_record_str_uniq(&values,
-						(zbx_compare_func_t)history_record_str_compare);
+			*error = zbx_strdup(*error, "cannot get values from value cache");
+			goto clean;
 		}
-	}
 
-	/* skip counting values one by one if filter matches any value */
-	if (OP_ANY != pdata.op)
+		if ((count = aggregate.values_num) > limit)
+			count = limit;
+	}
+	else
 	{
-		if (FAIL == zbx_execute_count_with_pattern(pattern, item->value_type, &pdata, &values, limit, &count,
-				error))
+		if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
 		{
+			*error = zbx_strdup(*error, "cannot get values from value cache");
 			goto clean;
 		}
-	}
-	else
-	{
-		if ((count = values.values_num) > limit)
-			count = limit;
+
+		if (COUNT_UNIQUE == unique)
+		{
+			switch (item->value_type)
+			{
+				case ITEM_VALUE_TYPE_UINT64:
+					zbx_vector_history_record_sort(&values,
+							(zbx_compare_func_t)history_record_uint64_compare);
+					zbx_vector_history_record_uniq(&values,
+							(zbx_compare_func_t)history_record_uint64_compare);
+					break;
+				case ITEM_VALUE_TYPE_FLOAT:
+					zbx_vector_history_record_sort(&values,
+							(zbx_compare_func_t)zbx_history_record_float_compare);
+					zbx_vector_history_record_uniq(&values,
+							(zbx_compare_func_t)zbx_history_record_float_compare);
+					break;
+				case ITEM_VALUE_TYPE_LOG:
+					zbx_vector_history_record_sort(&values,
+							(zbx_compare_func_t)history_record_log_compare);
+					zbx_vector_history_record_log_uniq(&values,
+							(zbx_compare_func_t)history_record_log_compare);
+					break;
+				default:
+					zbx_vector_history_record_sort(&values,
+							(zbx_compare_func_t)history_record_str_compare);
+					zbx_vector_history_record_str_uniq(&values,
+							(zbx_compare_func_t)history_record_str_compare);
+			}
+		}
+
+		/* skip counting values one by one if filter matches any value */
+		if (OP_ANY != pdata.op)
+		{
+			if (FAIL == zbx_execute_count_with_pattern(pattern, item->value_type, &pdata, &values, limit,
+					&count, error))
+			{
+				goto clean;
+			}
+		}
+		else
+		{
+			if ((count = values.values_num) > limit)
+				count = limit;
+		}
 	}
 
 	zbx_variant_set_dbl(value, count);
@@ -1196,16 +1214,13 @@ out:
 static int	evaluate_SUM(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item, const char *parameters,
 		const zbx_timespec_t *ts, char **error)
 {
-	int				arg1, i, ret = FAIL, seconds = 0, nvalues = 0, time_shift;
-	zbx_value_type_t		arg1_type;
-	zbx_vector_history_record_t	values;
-	zbx_history_value_t		result;
-	zbx_timespec_t			ts_end = *ts;
+	int			arg1, ret = FAIL, seconds = 0, nvalues = 0, time_shift;
+	zbx_value_type_t	arg1_type;
+	zbx_vc_aggregate_t	aggregate;
+	zbx_timespec_t		ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -1239,31 +1254,15 @@ static int	evaluate_SUM(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (FAIL == zbx_vc_get_aggregate(item->itemid, item->value_type, seconds, nvalues, &ts_end, &aggregate))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		goto out;
 	}
 
-	if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
-	{
-		result.dbl = 0;
-
-		for (i = 0; i < values.values_num; i++)
-			result.dbl += values.values[i].value.dbl;
-	}
-	else
-	{
-		result.ui64 = 0;
-
-		for (i = 0; i < values.values_num; i++)
-			result.ui64 += values.values[i].value.ui64;
-	}
-
-	zbx_history_value2variant(&result, item->value_type, value);
+	zbx_history_value2variant(&aggregate.sum, item->value_type, value);
 	ret = SUCCEED;
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
@@ -1288,15 +1287,13 @@ out:
 static int	evaluate_AVG(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item, const char *parameters,
 		const zbx_timespec_t *ts, char **error)
 {
-	int				arg1, ret = FAIL, i, seconds = 0, nvalues = 0, time_shift;
-	zbx_value_type_t		arg1_type;
-	zbx_vector_history_record_t	values;
-	zbx_timespec_t			ts_end = *ts;
+	int			arg1, ret = FAIL, seconds = 0, nvalues = 0, time_shift;
+	zbx_value_type_t	arg1_type;
+	zbx_vc_aggregate_t	aggregate;
+	zbx_timespec_t		ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -1330,29 +1327,15 @@ static int	evaluate_AVG(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (FAIL == zbx_vc_get_aggregate(item->itemid, item->value_type, seconds, nvalues, &ts_end, &aggregate))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		goto out;
 	}
 
-	if (0 < values.values_num)
+	if (0 < aggregate.values_num)
 	{
-		double	avg = 0;
-
-		if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
-		{
-			for (i = 0; i < values.values_num; i++)
-				avg += values.values[i].value.dbl / (i + 1) - avg / (i + 1);
-		}
-		else
-		{
-			for (i = 0; i < values.values_num; i++)
-				avg += (double)values.values[i].value.ui64;
-
-			avg = avg / values.values_num;
-		}
-		zbx_variant_set_dbl(value, avg);
+		zbx_variant_set_dbl(value, aggregate.avg);
 
 		ret = SUCCEED;
 	}
@@ -1362,8 +1345,6 @@ static int	evaluate_AVG(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item
 		*error = zbx_strdup(*error, "not enough data");
 	}
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -1406,17 +1387,6 @@ static int	evaluate_LAST(zbx_variant_t *value, const zbx_dc_evaluate_item_t *ite
 #define EVALUATE_MIN	0
 #define EVALUATE_MAX	1
 
-#define LOOP_FIND_MIN_OR_MAX(type, mode_op)							\
-	do											\
-	{											\
-		for (i = 1; i < values.values_num; i++)							\
-		{											\
-			if (values.values[i].value.type mode_op values.values[index].value.type)	\
-				index = i;								\
-		}											\
-	}												\
-	while(0)
-
 /******************************************************************************
  *                                                                            *
  * Purpose: evaluate function 'min' or 'max' for the item.                    *
@@ -1436,15 +1406,13 @@ static int	evaluate_LAST(zbx_variant_t *value, const zbx_dc_evaluate_item_t *ite
 static int	evaluate_MIN_or_MAX(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item, const char *parameters,
 		const zbx_timespec_t *ts, char **error, int min_or_max)
 {
-	int				arg1, i, ret = FAIL, seconds = 0, nvalues = 0, time_shift;
-	zbx_value_type_t		arg1_type;
-	zbx_vector_history_record_t	values;
-	zbx_timespec_t			ts_end = *ts;
+	int			arg1, ret = FAIL, seconds = 0, nvalues = 0, time_shift;
+	zbx_value_type_t	arg1_type;
+	zbx_vc_aggregate_t	aggregate;
+	zbx_timespec_t		ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -1478,40 +1446,16 @@ static int	evaluate_MIN_or_MAX(zbx_variant_t *value, const zbx_dc_evaluate_item_
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (FAIL == zbx_vc_get_aggregate(item->itemid, item->value_type, seconds, nvalues, &ts_end, &aggregate))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		goto out;
 	}
 
-	if (0 < values.values_num)
+	if (0 < aggregate.values_num)
 	{
-		int	index = 0;
-
-		if (ITEM_VALUE_TYPE_UINT64 == item->value_type)
-		{
-			if (EVALUATE_MIN == min_or_max)
-			{
-				LOOP_FIND_MIN_OR_MAX(ui64, <);
-			}
-			else
-			{
-				LOOP_FIND_MIN_OR_MAX(ui64, >);
-			}
-		}
-		else
-		{
-			if (EVALUATE_MIN == min_or_max)
-			{
-				LOOP_FIND_MIN_OR_MAX(dbl, <);
-			}
-			else
-			{
-				LOOP_FIND_MIN_OR_MAX(dbl, >);
-			}
-		}
-
-		zbx_history_value2variant(&values.values[index].value, item->value_type, value);
+		zbx_history_value2variant(EVALUATE_MIN == min_or_max ? &aggregate.min : &aggregate.max,
+				item->value_type, value);
 		ret = SUCCEED;
 	}
 	else
@@ -1520,8 +1464,6 @@ static int	evaluate_MIN_or_MAX(zbx_variant_t *value, const zbx_dc_evaluate_item_
 		*error = zbx_strdup(*error, "not enough data");
 	}
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -14,6 +14,10 @@
 
 #include "zbxfile.h"
 
+#if defined(__SSE2__)
+#	include <emmintrin.h>
+#endif
+
 void	zbx_find_cr_lf_szbyte(const char *encoding, const char **cr, const char **lf, size_t *szbyte)
 {
 	/* default is single-byte character set */
@@ -207,6 +211,88 @@ int	zbx_write_all(int fd, const char *buf, size_t n)
 
 #endif	/* not _WINDOWS */
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: skips buffer contents that contain no newline and no NULL         *
+ *          characters 16 bytes at a time                                     *
+ *                                                                            *
+ * Parameters: p       - [IN] pointer to buffer (nonnull)                     *
+ *             p_end   - [IN] pointer to end of buffer p                      *
+ *             cr      - [IN] carriage return string                          *
+ *             lf      - [IN] line feed string                                *
+ *             szbyte  - [IN] size of newline strings                         *
+ *                                                                            *
+ * Return value: pointer to the first 16 byte block which might contain       *
+ *               newline or NULL characters or to the last incomplete block,  *
+ *               the remaining data must be examined character by character   *
+ *                                                                            *
+ * Comments: Without SSE2 support the buffer is returned as is.               *
+ *                                                                            *
+ ******************************************************************************/
+static char	*buf_skip_plain_text(char *p, const char *p_end, const char *cr, const char *lf, size_t szbyte)
+{
+#if defined(__SSE2__)
+	const __m128i	zero = _mm_setzero_si128();
+	__m128i		v_cr, v_lf, v;
+	unsigned short	cr16, lf16;
+	zbx_uint32_t	cr32, lf32;
+	int		mask;
+
+	switch (szbyte)
+	{
+		case 1:
+			v_cr = _mm_set1_epi8(*cr);
+			v_lf = _mm_set1_epi8(*lf);
+			break;
+		case 2:
+			/* code units are compared in memory byte order, so endianness does not matter */
+			memcpy(&cr16, cr, sizeof(cr16));
+			memcpy(&lf16, lf, sizeof(lf16));
+			v_cr = _mm_set1_epi16((short)cr16);
+			v_lf = _mm_set1_epi16((short)lf16);
+			break;
+		case 4:
+			memcpy(&cr32, cr, sizeof(cr32));
+			memcpy(&lf32, lf, sizeof(lf32));
+			v_cr = _mm_set1_epi32((int)cr32);
+			v_lf = _mm_set1_epi32((int)lf32);
+			break;
+		default:
+			return p;
+	}
+
+	/* block size is a multiple of character size, so p stays on character boundary */
+	for (; 16 <= p_end - p; p += 16)
+	{
+		v = _mm_loadu_si128((const __m128i *)(const void *)p);
+
+		switch (szbyte)
+		{
+			case 1:
+				mask = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, v_cr),
+						_mm_cmpeq_epi8(v, v_lf)), _mm_cmpeq_epi8(v, zero)));
+				break;
+			case 2:
+				mask = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(v, v_cr),
+						_mm_cmpeq_epi16(v, v_lf)), _mm_cmpeq_epi16(v, zero)));
+				break;
+			default:
+				mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi32(v, v_cr),
+						_mm_cmpeq_epi32(v, v_lf)));
+		}
+
+		if (0 != mask)
+			break;
+	}
+#else
+	ZBX_UNUSED(p_end);
+	ZBX_UNUSED(cr);
+	ZBX_UNUSED(lf);
+	ZBX_UNUSED(szbyte);
+#endif
+	return p;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: find next newline in buffer using newline encoding                *
@@ -226,6 +312,8 @@ int	zbx_write_all(int fd, const char *buf, size_t n)
  ******************************************************************************/
 char	*zbx_find_buf_newline(char *p, char **p_next, const char *p_end, const char *cr, const char *lf, size_t szbyte)
 {
+	p = buf_skip_plain_text(p, p_end, cr, lf, szbyte);
+
 	if (1 == szbyte)	/* single-byte character set */
 	{
 		for (; p < p_end; p++)
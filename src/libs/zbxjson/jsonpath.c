@@ -1907,17 +1907,16 @@ static void	jsonpath_variant_to_boolean(zbx_variant_t *value)
  ******************************************************************************/
 static int	jsonpath_regexp_match(const char *text, const char *pattern, double *result)
 {
-	zbx_regexp_t	*rxp;
-	char		*error = NULL;
+	const zbx_regexp_t	*rxp;
+	char			*error = NULL;
 
-	if (FAIL == zbx_regexp_compile(pattern, &rxp, &error))
+	if (FAIL == zbx_regexp_compile_cached(pattern, &rxp, &error))
 	{
 		zbx_set_json_strerror("invalid regular expression in JSON path: %s", error);
 		zbx_free(error);
 		return FAIL;
 	}
 	*result = (0 == zbx_regexp_match_precompiled(text, rxp) ? 1.0 : 0.0);
-	zbx_regexp_free(rxp);
 
 	return SUCCEED;
 }
@@ -57,6 +57,9 @@ static void	common_sigusr_handler(int flags)
 		case ZBX_RTC_PROF_DISABLE:
 			zbx_prof_disable();
 			break;
+		case ZBX_RTC_PROF_DUMP:
+			zbx_prof_dump();
+			break;
 		case ZBX_RTC_LOG_LEVEL_DECREASE:
 			zabbix_decrease_log_level();
 			break;
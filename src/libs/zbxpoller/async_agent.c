@@ -257,6 +257,9 @@ static int	agent_task_process(short event, void *data, int *fd, const char *addr
 			break;
 	}
 stop:
+	if (ZABBIX_AGENT_STEP_RECV == agent_context->step)
+		zbx_tcp_recv_context_clear(&agent_context->tcp_recv_context);
+
 	zbx_tcp_close(&agent_context->s);
 out:
 	zbx_tcp_send_context_clear(&agent_context->tcp_send_context);
@@ -945,6 +945,62 @@ int	get_value_internal(const zbx_dc_item_t *item, AGENT_RESULT *result, const zb
 
 		SET_UI64_RESULT(result, zbx_preprocessor_get_queue_size());
 	}
+	else if (0 == strcmp(tmp, "preprocessing_regexp_cache"))	/* zabbix[preprocessing_regexp_cache,<parameter>] */
+	{
+		char				*error = NULL;
+		zbx_regexp_cache_stats_t	stats;
+		zbx_uint64_t			total;
+
+		if (2 < nparams)
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters."));
+			goto out;
+		}
+
+		tmp = get_rparam(&request, 1);
+
+		if (FAIL == zbx_preprocessor_get_regexp_cache_stats(&stats, &error))
+		{
+			SET_MSG_RESULT(result, error);
+			goto out;
+		}
+
+		total = stats.hits + stats.misses;
+
+		if (NULL == tmp || '\0' == *tmp || 0 == strcmp(tmp, "all"))
+		{
+			SET_UI64_RESULT(result, total);
+		}
+		else if (0 == strcmp(tmp, "hits"))
+		{
+			SET_UI64_RESULT(result, stats.hits);
+		}
+		else if (0 == strcmp(tmp, "misses"))
+		{
+			SET_UI64_RESULT(result, stats.misses);
+		}
+		else if (0 == strcmp(tmp, "evictions"))
+		{
+			SET_UI64_RESULT(result, stats.evictions);
+		}
+		else if (0 == strcmp(tmp, "items"))
+		{
+			SET_UI64_RESULT(result, stats.items_num);
+		}
+		else if (0 == strcmp(tmp, "phits"))
+		{
+			SET_DBL_RESULT(result, (0 == total ? 0 : (double)stats.hits / (double)total * 100));
+		}
+		else if (0 == strcmp(tmp, "pmisses"))
+		{
+			SET_DBL_RESULT(result, (0 == total ? 0 : (double)stats.misses / (double)total * 100));
+		}
+		else
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
+			goto out;
+		}
+	}
 	else if (0 == strcmp(tmp, "discovery_queue"))			/* zabbix[discovery_queue] */
 	{
 		zbx_uint64_t	size;
@@ -64,7 +64,8 @@ int	zbx_diag_add_preproc_info(const struct zbx_json_parse *jp, struct zbx_json *
 	double				time1, time2, time_total = 0;
 	zbx_uint64_t			fields;
 	zbx_diag_map_t			field_map[] = {
-							{"", ZBX_DIAG_PREPROC_INFO},
+							{"", ZBX_DIAG_PREPROC_INFO | ZBX_DIAG_PREPROC_QUEUE},
+							{"queue", ZBX_DIAG_PREPROC_QUEUE},
 							{NULL, 0}
 						};
 
@@ -97,6 +98,28 @@ int	zbx_diag_add_preproc_info(const struct zbx_json_parse *jp, struct zbx_json *
 			}
 		}
 
+		if (0 != (fields & ZBX_DIAG_PREPROC_QUEUE))
+		{
+			zbx_pp_queue_stats_t	stats;
+
+			time1 = zbx_time();
+			if (FAIL == (ret = zbx_preprocessor_get_queue_stats(&stats, error)))
+				goto out;
+
+			time2 = zbx_time();
+			time_total += time2 - time1;
+
+			zbx_json_addobject(json, "queue");
+			zbx_json_adduint64(json, "shards", stats.shards_num);
+			zbx_json_adduint64(json, "locks", stats.locks_num);
+			zbx_json_adduint64(json, "contended locks", stats.locks_contended_num);
+			zbx_json_adduint64(json, "steals", stats.steals_num);
+			zbx_json_adduint64(json, "finished locks", stats.finished_locks_num);
+			zbx_json_adduint64(json, "finished contended locks", stats.finished_locks_contended_num);
+			zbx_json_adduint64(json, "idle waits", stats.waits_num);
+			zbx_json_close(json);
+		}
+
 		if (0 != tops.values_num)
 		{
 			int	i;
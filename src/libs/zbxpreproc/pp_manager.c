@@ -144,7 +144,7 @@ static zbx_pp_manager_t	*zbx_pp_manager_create(int workers_num, zbx_pp_notify_cb
 	manager = (zbx_pp_manager_t *)zbx_malloc(NULL, sizeof(zbx_pp_manager_t));
 	memset(manager, 0, sizeof(zbx_pp_manager_t));
 
-	if (SUCCEED != pp_task_queue_init(&manager->queue, error))
+	if (SUCCEED != pp_task_queue_init(&manager->queue, workers_num, error))
 		goto out;
 
 	manager->timekeeper = zbx_timekeeper_create(workers_num, NULL);
@@ -196,8 +196,18 @@ static zbx_pp_manager_t	*zbx_pp_manager_create(int workers_num, zbx_pp_notify_cb
 out:
 	if (FAIL == ret)
 	{
-		for (i = 0; i < manager->workers_num; i++)
-			pp_worker_stop(&manager->workers[i]);
+		if (NULL != manager->workers)
+		{
+			for (i = 0; i < manager->workers_num; i++)
+				pp_worker_stop(&manager->workers[i]);
+
+			pp_task_queue_notify_all(&manager->queue);
+
+			for (i = 0; i < manager->workers_num; i++)
+				pp_worker_destroy(&manager->workers[i]);
+
+			zbx_free(manager->workers);
+		}
 
 		pp_task_queue_destroy(&manager->queue);
 		zbx_free(manager);
@@ -220,12 +230,10 @@ static void	zbx_pp_manager_free(zbx_pp_manager_t *manager)
 {
 	int	i;
 
-	pp_task_queue_lock(&manager->queue);
 	for (i = 0; i < manager->workers_num; i++)
 		pp_worker_stop(&manager->workers[i]);
 
 	pp_task_queue_notify_all(&manager->queue);
-	pp_task_queue_unlock(&manager->queue);
 
 	for (i = 0; i < manager->workers_num; i++)
 		pp_worker_destroy(&manager->workers[i]);
@@ -267,10 +275,8 @@ static void	zbx_pp_manager_queue_test(zbx_pp_manager_t *manager, zbx_pp_item_pre
 {
 	zbx_pp_task_t	*task = pp_task_test_create(preproc, value, ts, client);
 
-	pp_task_queue_lock(&manager->queue);
 	pp_task_queue_push_test(&manager->queue, task);
 	pp_task_queue_notify(&manager->queue);
-	pp_task_queue_unlock(&manager->queue);
 }
 
 /******************************************************************************
@@ -281,15 +287,14 @@ static void	zbx_pp_manager_queue_test(zbx_pp_manager_t *manager, zbx_pp_item_pre
 static void	zbx_pp_manager_queue_value_preproc(zbx_pp_manager_t *manager, zbx_vector_pp_task_ptr_t *tasks)
 {
 	zbx_prof_start(__func__, ZBX_PROF_MUTEX);
-	pp_task_queue_lock(&manager->queue);
-	zbx_prof_end_wait();
 
 	for (int i = 0; i < tasks->values_num; i++)
 		pp_task_queue_push(&manager->queue, tasks->values[i]);
 
-	pp_task_queue_notify(&manager->queue);
+	zbx_prof_end_wait();
+
+	pp_task_queue_notify_num(&manager->queue, tasks->values_num);
 
-	pp_task_queue_unlock(&manager->queue);
 	zbx_prof_end();
 }
 
@@ -375,8 +380,6 @@ static zbx_pp_item_t	*pp_manager_get_cacheable_dependent_item(zbx_pp_manager_t *
  *             cache          - [IN] preprocessing cache                      *
  *                                   (optional, can be NULL)                  *
  *                                                                            *
- * Comments: This function called within task queue lock.                     *
- *                                                                            *
  ******************************************************************************/
 static void	pp_manager_queue_dependents(zbx_pp_manager_t *manager, zbx_pp_item_preproc_t *preproc,
 		zbx_dc_um_shared_handle_t *um_handle, zbx_uint64_t exclude_itemid, const zbx_variant_t *value,
@@ -420,8 +423,7 @@ static void	pp_manager_queue_dependents(zbx_pp_manager_t *manager, zbx_pp_item_p
 		queued_num++;
 	}
 
-	if (0 < queued_num)
-		pp_task_queue_notify(&manager->queue);
+	pp_task_queue_notify_num(&manager->queue, queued_num);
 
 	pp_cache_release(cache);
 }
@@ -434,8 +436,6 @@ static void	pp_manager_queue_dependents(zbx_pp_manager_t *manager, zbx_pp_item_p
  * Parameters: manager - [IN] manager                                         *
  *             task    - [IN] finished value task                             *
  *                                                                            *
- * Comments: This function called within task queue lock.                     *
- *                                                                            *
  ******************************************************************************/
 static void	pp_manager_queue_value_task_result(zbx_pp_manager_t *manager, zbx_pp_task_t *task)
 {
@@ -474,8 +474,6 @@ static void	pp_manager_queue_value_task_result(zbx_pp_manager_t *manager, zbx_pp
  * Parameters: manager - [IN] manager                                         *
  *             task    - [IN] finished dependent task                         *
  *                                                                            *
- * Comments: This function called within task queue lock.                     *
- *                                                                            *
  ******************************************************************************/
 static zbx_pp_task_t	*pp_manager_queue_dependent_task_result(zbx_pp_manager_t *manager, zbx_pp_task_t *task)
 {
@@ -499,15 +497,12 @@ static zbx_pp_task_t	*pp_manager_queue_dependent_task_result(zbx_pp_manager_t *m
  * Parameters: manager  - [IN] manager                                        *
  *             task_seq - [IN] finished sequence task                         *
  *                                                                            *
- * Comments: This function called within task queue lock.                     *
- *                                                                            *
  ******************************************************************************/
 static zbx_pp_task_t	*pp_manager_requeue_next_sequence_task(zbx_pp_manager_t *manager, zbx_pp_task_t *task_seq)
 {
-	zbx_pp_task_sequence_t	*d_seq = (zbx_pp_task_sequence_t *)PP_TASK_DATA(task_seq);
-	zbx_pp_task_t		*task = NULL, *tmp_task;
+	zbx_pp_task_t	*task;
 
-	if (SUCCEED == zbx_list_pop(&d_seq->tasks, (void **)&task))
+	if (NULL != (task = pp_task_queue_pop_sequence_task(&manager->queue, task_seq)))
 	{
 		switch (task->type)
 		{
@@ -524,16 +519,12 @@ static zbx_pp_task_t	*pp_manager_requeue_next_sequence_task(zbx_pp_manager_t *ma
 		}
 	}
 
-	if (SUCCEED == zbx_list_peek(&d_seq->tasks, (void **)&tmp_task))
-	{
-		pp_task_queue_push_immediate(&manager->queue, task_seq);
+	/* workers might have added new tasks to the sequence while processing results, */
+	/* so the sequence is checked again and requeued within task queue shard lock    */
+	if (SUCCEED == pp_task_queue_requeue_sequence(&manager->queue, task_seq))
 		pp_task_queue_notify(&manager->queue);
-	}
 	else
-	{
-		pp_task_queue_remove_sequence(&manager->queue, task_seq->itemid);
 		pp_task_free(task_seq);
-	}
 
 	return task;
 }
@@ -554,48 +545,46 @@ static void	zbx_pp_manager_process_finished(zbx_pp_manager_t *manager, zbx_vecto
 {
 #define PP_FINISHED_TASK_BATCH_SIZE	100
 
-	zbx_pp_task_t	*task;
-	static time_t	timekeeper_clock = 0;
-	time_t		now;
+	zbx_pp_task_t			*task;
+	static time_t			timekeeper_clock = 0;
+	time_t				now;
+	zbx_vector_pp_task_ptr_t	finished;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	zbx_vector_pp_task_ptr_create(&finished);
 	zbx_vector_pp_task_ptr_reserve(tasks, PP_FINISHED_TASK_BATCH_SIZE);
 	zbx_prof_start(__func__, ZBX_PROF_MUTEX);
-	pp_task_queue_lock(&manager->queue);
+	(void)pp_task_queue_pop_finished(&manager->queue, &finished, PP_FINISHED_TASK_BATCH_SIZE);
 	zbx_prof_end_wait();
-	while (PP_FINISHED_TASK_BATCH_SIZE > tasks->values_num)
+
+	for (int i = 0; i < finished.values_num; i++)
 	{
-		if (NULL != (task = pp_task_queue_pop_finished(&manager->queue)))
+		task = finished.values[i];
+
+		switch (task->type)
 		{
-			switch (task->type)
-			{
-				case ZBX_PP_TASK_VALUE:
-					pp_manager_queue_value_task_result(manager, task);
-					break;
-				case ZBX_PP_TASK_DEPENDENT:
-					task = pp_manager_queue_dependent_task_result(manager, task);
-					break;
-				case ZBX_PP_TASK_SEQUENCE:
-					task = pp_manager_requeue_next_sequence_task(manager, task);
-					break;
-				default:
-					break;
-			}
+			case ZBX_PP_TASK_VALUE:
+				pp_manager_queue_value_task_result(manager, task);
+				break;
+			case ZBX_PP_TASK_DEPENDENT:
+				task = pp_manager_queue_dependent_task_result(manager, task);
+				break;
+			case ZBX_PP_TASK_SEQUENCE:
+				task = pp_manager_requeue_next_sequence_task(manager, task);
+				break;
+			default:
+				break;
 		}
 
-		if (NULL == task)
-			break;
-
-		zbx_vector_pp_task_ptr_append(tasks, task);
+		if (NULL != task)
+			zbx_vector_pp_task_ptr_append(tasks, task);
 	}
 
-	*pending_num = manager->queue.pending_num;
-	*finished_num = manager->queue.finished_num;
-	*processing_num = manager->queue.processing_num;
+	pp_task_queue_get_stats(&manager->queue, pending_num, processing_num, finished_num, NULL);
 
-	pp_task_queue_unlock(&manager->queue);
 	zbx_prof_end();
+	zbx_vector_pp_task_ptr_destroy(&finished);
 	now = time(NULL);
 	if (now != timekeeper_clock)
 	{
@@ -664,10 +653,10 @@ zbx_hashset_t  *zbx_pp_manager_items(zbx_pp_manager_t *manager)
 static void	zbx_pp_manager_get_diag_stats(zbx_pp_manager_t *manager, zbx_uint64_t *preproc_num,
 		zbx_uint64_t *pending_num, zbx_uint64_t *finished_num, zbx_uint64_t *sequences_num)
 {
+	zbx_uint64_t	processing_num;
+
 	*preproc_num = (zbx_uint64_t)manager->items.num_data;
-	*pending_num = manager->queue.pending_num;
-	*finished_num = manager->queue.finished_num;
-	*sequences_num = (zbx_uint64_t)manager->queue.sequences.num_data;
+	pp_task_queue_get_stats(&manager->queue, pending_num, &processing_num, finished_num, sequences_num);
 }
 
 /******************************************************************************
@@ -691,6 +680,30 @@ static void	zbx_pp_manager_get_worker_usage(zbx_pp_manager_t *manager, zbx_vecto
 	(void)zbx_timekeeper_get_usage(manager->timekeeper, worker_usage);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get compiled regexp cache statistics summed over all workers      *
+ *                                                                            *
+ ******************************************************************************/
+static void	pp_manager_get_regexp_cache_stats(zbx_pp_manager_t *manager, zbx_regexp_cache_stats_t *stats)
+{
+	memset(stats, 0, sizeof(zbx_regexp_cache_stats_t));
+
+	pp_task_queue_lock_finished(&manager->queue);
+
+	for (int i = 0; i < manager->workers_num; i++)
+	{
+		const zbx_regexp_cache_stats_t	*worker_stats = &manager->workers[i].regexp_stats;
+
+		stats->hits += worker_stats->hits;
+		stats->misses += worker_stats->misses;
+		stats->evictions += worker_stats->evictions;
+		stats->items_num += worker_stats->items_num;
+	}
+
+	pp_task_queue_unlock_finished(&manager->queue);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: synchronize preprocessing manager with configuration cache data   *
@@ -940,7 +953,9 @@ static void	preprocessor_add_test_request(zbx_pp_manager_t *manager, zbx_ipc_cli
 
 static void	preprocessor_reply_queue_size(zbx_pp_manager_t *manager, zbx_ipc_client_t *client)
 {
-	zbx_uint64_t	pending_num = manager->queue.pending_num;
+	zbx_uint64_t	pending_num, processing_num, finished_num;
+
+	pp_task_queue_get_stats(&manager->queue, &pending_num, &processing_num, &finished_num, NULL);
 
 	zbx_ipc_client_send(client, ZBX_IPC_PREPROCESSOR_QUEUE, (unsigned char *)&pending_num, sizeof(pending_num));
 }
@@ -1113,6 +1128,40 @@ static void	preprocessor_reply_usage_stats(zbx_pp_manager_t *manager, int worker
 	zbx_vector_dbl_destroy(&usage);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: respond to compiled regexp cache statistics request               *
+ *                                                                            *
+ * Parameters: manager - [IN] preprocessing manager                           *
+ *             client  - [IN] request source                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_reply_regexp_stats(zbx_pp_manager_t *manager, zbx_ipc_client_t *client)
+{
+	zbx_regexp_cache_stats_t	stats;
+
+	pp_manager_get_regexp_cache_stats(manager, &stats);
+
+	zbx_ipc_client_send(client, ZBX_IPC_PREPROCESSOR_REGEXP_STATS, (unsigned char *)&stats, sizeof(stats));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: respond to task queue contention statistics request               *
+ *                                                                            *
+ * Parameters: manager - [IN] preprocessing manager                           *
+ *             client  - [IN] request source                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_reply_queue_stats(zbx_pp_manager_t *manager, zbx_ipc_client_t *client)
+{
+	zbx_pp_queue_stats_t	stats;
+
+	pp_task_queue_get_contention_stats(&manager->queue, &stats);
+
+	zbx_ipc_client_send(client, ZBX_IPC_PREPROCESSOR_QUEUE_STATS, (unsigned char *)&stats, sizeof(stats));
+}
+
 static void	preprocessor_finished_task_cb(void *data)
 {
 	zbx_ipc_service_alert((zbx_ipc_service_t *)data);
@@ -1290,6 +1339,12 @@ ZBX_THREAD_ENTRY(zbx_pp_manager_thread, args)
 				case ZBX_IPC_PREPROCESSOR_USAGE_STATS:
 					preprocessor_reply_usage_stats(manager, pp_args->workers_num, client);
 					break;
+				case ZBX_IPC_PREPROCESSOR_REGEXP_STATS:
+					preprocessor_reply_regexp_stats(manager, client);
+					break;
+				case ZBX_IPC_PREPROCESSOR_QUEUE_STATS:
+					preprocessor_reply_queue_stats(manager, client);
+					break;
 				case ZBX_RTC_LOG_LEVEL_INCREASE:
 					preprocessor_change_loglevel(manager, 1, (const char *)message->data);
 					break;
@@ -1131,6 +1131,49 @@ int	zbx_preprocessor_get_usage_stats(zbx_vector_dbl_t *usage, int *count, char *
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get compiled regexp cache statistics summed over all              *
+ *          preprocessing workers                                             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_preprocessor_get_regexp_cache_stats(zbx_regexp_cache_stats_t *stats, char **error)
+{
+	unsigned char	*result;
+
+	if (SUCCEED != zbx_ipc_async_exchange(ZBX_IPC_SERVICE_PREPROCESSING, ZBX_IPC_PREPROCESSOR_REGEXP_STATS,
+			SEC_PER_MIN, NULL, 0, &result, error))
+	{
+		return FAIL;
+	}
+
+	memcpy(stats, result, sizeof(zbx_regexp_cache_stats_t));
+	zbx_free(result);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get preprocessing task queue contention statistics                *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_preprocessor_get_queue_stats(zbx_pp_queue_stats_t *stats, char **error)
+{
+	unsigned char	*result;
+
+	if (SUCCEED != zbx_ipc_async_exchange(ZBX_IPC_SERVICE_PREPROCESSING, ZBX_IPC_PREPROCESSOR_QUEUE_STATS,
+			SEC_PER_MIN, NULL, 0, &result, error))
+	{
+		return FAIL;
+	}
+
+	memcpy(stats, result, sizeof(zbx_pp_queue_stats_t));
+	zbx_free(result);
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: get preprocessing worker usage statistics                         *
@@ -33,6 +33,8 @@
 #define ZBX_IPC_PREPROCESSOR_TOP_SEQUENCES		10007
 #define ZBX_IPC_PREPROCESSOR_TOP_SEQUENCES_RESULT	10008
 #define ZBX_IPC_PREPROCESSOR_USAGE_STATS		10009
+#define ZBX_IPC_PREPROCESSOR_REGEXP_STATS		10010
+#define ZBX_IPC_PREPROCESSOR_QUEUE_STATS		10011
 
 /* item value data used in preprocessing manager */
 typedef struct
@@ -20,6 +20,7 @@
 #define PP_TASK_QUEUE_INIT_NONE		0x00
 #define PP_TASK_QUEUE_INIT_LOCK		0x01
 #define PP_TASK_QUEUE_INIT_EVENT	0x02
+#define PP_TASK_QUEUE_INIT_FINISHED	0x04
 
 ZBX_PTR_VECTOR_IMPL(pp_sequence_stats_ptr, zbx_pp_sequence_stats_t *)
 
@@ -31,30 +32,102 @@ typedef struct
 }
 zbx_pp_item_task_sequence_t;
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: lock mutex and count lock contention                              *
+ *                                                                            *
+ * Parameters: lock          - [IN] mutex to lock                             *
+ *             locks_num     - [OUT] the lock counter                         *
+ *             contended_num - [OUT] the contended lock counter               *
+ *                                                                            *
+ * Comments: The counters are updated after acquiring the lock, so they are   *
+ *           protected by the same mutex.                                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	pp_mutex_lock(pthread_mutex_t *lock, zbx_uint64_t *locks_num, zbx_uint64_t *contended_num)
+{
+	if (0 != pthread_mutex_trylock(lock))
+	{
+		pthread_mutex_lock(lock);
+		(*contended_num)++;
+	}
+
+	(*locks_num)++;
+}
+
+static zbx_pp_queue_shard_t	*pp_task_queue_get_shard(zbx_pp_queue_t *queue, zbx_uint64_t itemid)
+{
+	return &queue->shards[itemid % (zbx_uint64_t)queue->shards_num];
+}
+
+static void	pp_task_queue_shard_lock(zbx_pp_queue_shard_t *shard)
+{
+	pp_mutex_lock(&shard->lock, &shard->locks_num, &shard->locks_contended_num);
+}
+
+static void	pp_task_queue_shard_unlock(zbx_pp_queue_shard_t *shard)
+{
+	pthread_mutex_unlock(&shard->lock);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: initialize task queue                                             *
  *                                                                            *
- * Parameters: queue - [IN] task queue                                        *
- *             error - [OUT]                                                  *
+ * Parameters: queue      - [IN] task queue                                   *
+ *             shards_num - [IN] number of task queue shards                  *
+ *             error      - [OUT]                                             *
  *                                                                            *
  * Return value: SUCCEED - the task queue was initialized successfully        *
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-int	pp_task_queue_init(zbx_pp_queue_t *queue, char **error)
+int	pp_task_queue_init(zbx_pp_queue_t *queue, int shards_num, char **error)
 {
 	int	err, ret = FAIL;
 
 	queue->workers_num = 0;
-	queue->pending_num = 0;
+	queue->idle_num = 0;
 	queue->finished_num = 0;
-	queue->processing_num = 0;
-	zbx_list_create(&queue->pending);
-	zbx_list_create(&queue->immediate);
+	queue->pushed_num = 0;
+	queue->finished_locks_num = 0;
+	queue->finished_locks_contended_num = 0;
+	queue->notify_seq = 0;
+	queue->waits_num = 0;
 	zbx_list_create(&queue->finished);
 
-	zbx_hashset_create(&queue->sequences, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	queue->shards_num = MAX(shards_num, 1);
+	queue->shards = (zbx_pp_queue_shard_t *)zbx_calloc(NULL, (size_t)queue->shards_num,
+			sizeof(zbx_pp_queue_shard_t));
+
+	for (int i = 0; i < queue->shards_num; i++)
+	{
+		zbx_pp_queue_shard_t	*shard = &queue->shards[i];
+
+		zbx_list_create(&shard->pending);
+		zbx_list_create(&shard->immediate);
+		zbx_hashset_create(&shard->sequences, 100, ZBX_DEFAULT_UINT64_HASH_FUNC,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+		if (0 != (err = pthread_mutex_init(&shard->lock, NULL)))
+		{
+			*error = zbx_dsprintf(NULL, "cannot initialize task queue shard mutex: %s", zbx_strerror(err));
+
+			/* destroy only the initialized shards */
+			zbx_list_destroy(&shard->pending);
+			zbx_list_destroy(&shard->immediate);
+			zbx_hashset_destroy(&shard->sequences);
+			queue->shards_num = i;
+			goto out;
+		}
+	}
+
+	if (0 != (err = pthread_mutex_init(&queue->finished_lock, NULL)))
+	{
+		*error = zbx_dsprintf(NULL, "cannot initialize task queue mutex: %s", zbx_strerror(err));
+		goto out;
+	}
+	queue->init_flags |= PP_TASK_QUEUE_INIT_FINISHED;
 
 	if (0 != (err = pthread_mutex_init(&queue->lock, NULL)))
 	{
@@ -104,23 +177,36 @@ void	pp_task_queue_destroy(zbx_pp_queue_t *queue)
 	if (0 != (queue->init_flags & PP_TASK_QUEUE_INIT_EVENT))
 		pthread_cond_destroy(&queue->event);
 
-	pp_task_queue_clear_tasks(&queue->pending);
-	zbx_list_destroy(&queue->pending);
+	if (0 != (queue->init_flags & PP_TASK_QUEUE_INIT_FINISHED))
+		pthread_mutex_destroy(&queue->finished_lock);
+
+	for (int i = 0; i < queue->shards_num; i++)
+	{
+		zbx_pp_queue_shard_t	*shard = &queue->shards[i];
+
+		pthread_mutex_destroy(&shard->lock);
+
+		pp_task_queue_clear_tasks(&shard->pending);
+		zbx_list_destroy(&shard->pending);
+
+		pp_task_queue_clear_tasks(&shard->immediate);
+		zbx_list_destroy(&shard->immediate);
 
-	pp_task_queue_clear_tasks(&queue->immediate);
-	zbx_list_destroy(&queue->immediate);
+		zbx_hashset_destroy(&shard->sequences);
+	}
+
+	zbx_free(queue->shards);
+	queue->shards_num = 0;
 
 	pp_task_queue_clear_tasks(&queue->finished);
 	zbx_list_destroy(&queue->finished);
 
-	zbx_hashset_destroy(&queue->sequences);
-
 	queue->init_flags = PP_TASK_QUEUE_INIT_NONE;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: lock task queue                                                   *
+ * Purpose: lock task queue worker registry                                   *
  *                                                                            *
  ******************************************************************************/
 void	pp_task_queue_lock(zbx_pp_queue_t *queue)
@@ -130,7 +216,7 @@ void	pp_task_queue_lock(zbx_pp_queue_t *queue)
 
 /******************************************************************************
  *                                                                            *
- * Purpose: unlock task queue                                                 *
+ * Purpose: unlock task queue worker registry                                 *
  *                                                                            *
  ******************************************************************************/
 void	pp_task_queue_unlock(zbx_pp_queue_t *queue)
@@ -142,10 +228,20 @@ void	pp_task_queue_unlock(zbx_pp_queue_t *queue)
  *                                                                            *
  * Purpose: register a new worker                                             *
  *                                                                            *
+ * Return value: The current notification sequence to be used when waiting    *
+ *               for new tasks.                                               *
+ *                                                                            *
  ******************************************************************************/
-void	pp_task_queue_register_worker(zbx_pp_queue_t *queue)
+zbx_uint64_t	pp_task_queue_register_worker(zbx_pp_queue_t *queue)
 {
+	zbx_uint64_t	notify_seq;
+
+	pp_task_queue_lock(queue);
 	queue->workers_num++;
+	notify_seq = queue->notify_seq;
+	pp_task_queue_unlock(queue);
+
+	return notify_seq;
 }
 
 /******************************************************************************
@@ -155,30 +251,32 @@ void	pp_task_queue_register_worker(zbx_pp_queue_t *queue)
  ******************************************************************************/
 void	pp_task_queue_deregister_worker(zbx_pp_queue_t *queue)
 {
+	pp_task_queue_lock(queue);
 	queue->workers_num--;
+	pp_task_queue_unlock(queue);
 }
 
 /******************************************************************************
  *                                                                            *
  * Purpose: add task to an existing sequence or create/append to a new one    *
  *                                                                            *
- * Parameters: queue - [IN] task queue                                        *
+ * Parameters: shard - [IN] task queue shard                                  *
  *             task  - [IN] task to add                                       *
  *                                                                            *
  * Return value: The created sequence task or NULL if task was added to an    *
  *               existing sequence.                                           *
  *                                                                            *
  ******************************************************************************/
-static zbx_pp_task_t	*pp_task_queue_add_sequence(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
+static zbx_pp_task_t	*pp_task_queue_add_sequence(zbx_pp_queue_shard_t *shard, zbx_pp_task_t *task)
 {
 	zbx_pp_item_task_sequence_t	*sequence;
 	zbx_pp_task_t			*new_task;
 
-	if (NULL == (sequence = (zbx_pp_item_task_sequence_t *)zbx_hashset_search(&queue->sequences, &task->itemid)))
+	if (NULL == (sequence = (zbx_pp_item_task_sequence_t *)zbx_hashset_search(&shard->sequences, &task->itemid)))
 	{
 		zbx_pp_item_task_sequence_t	sequence_local = {.itemid = task->itemid};
 
-		sequence = (zbx_pp_item_task_sequence_t *)zbx_hashset_insert(&queue->sequences, &sequence_local,
+		sequence = (zbx_pp_item_task_sequence_t *)zbx_hashset_insert(&shard->sequences, &sequence_local,
 				sizeof(sequence_local));
 
 		sequence->task = pp_task_sequence_create(task->itemid);
@@ -198,43 +296,101 @@ static zbx_pp_task_t	*pp_task_queue_add_sequence(zbx_pp_queue_t *queue, zbx_pp_t
  *                                                                            *
  * Purpose: queue task to be processed before normal tasks                    *
  *                                                                            *
- * Parameters: queue - [IN] task queue                                        *
+ * Parameters: shard - [IN] locked task queue shard                           *
  *             task  - [IN] task to push                                      *
  *                                                                            *
  ******************************************************************************/
-void	pp_task_queue_push_immediate(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
+static void	pp_task_queue_shard_push_immediate(zbx_pp_queue_shard_t *shard, zbx_pp_task_t *task)
 {
 	switch (task->type)
 	{
 		case ZBX_PP_TASK_VALUE_SEQ:
 		case ZBX_PP_TASK_DEPENDENT:
-			queue->pending_num++;
-			if (NULL == (task = pp_task_queue_add_sequence(queue, task)))
+			shard->pending_num++;
+			if (NULL == (task = pp_task_queue_add_sequence(shard, task)))
 				return;
 			break;
 		case ZBX_PP_TASK_SEQUENCE:
 			/* sequence task is just a container for other tasks - it does not affect statistics, */
-			/* so there is no need to increment queue->pending_num                                */
+			/* so there is no need to increment shard->pending_num                                */
 			break;
 		default:
-			queue->pending_num++;
+			shard->pending_num++;
 			break;
 	}
 
-	(void)zbx_list_append(&queue->immediate, task, NULL);
+	(void)zbx_list_append(&shard->immediate, task, NULL);
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: remove task sequence                                              *
+ * Purpose: queue task to be processed before normal tasks                    *
  *                                                                            *
- * Parameters: queue  - [IN] task queue                                       *
- *             itemid - [IN] task sequence itemid                             *
+ * Parameters: queue - [IN] task queue                                        *
+ *             task  - [IN] task to push                                      *
  *                                                                            *
  ******************************************************************************/
-void	pp_task_queue_remove_sequence(zbx_pp_queue_t *queue, zbx_uint64_t itemid)
+void	pp_task_queue_push_immediate(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
 {
-	zbx_hashset_remove(&queue->sequences, &itemid);
+	zbx_pp_queue_shard_t	*shard = pp_task_queue_get_shard(queue, task->itemid);
+
+	pp_task_queue_shard_lock(shard);
+	pp_task_queue_shard_push_immediate(shard, task);
+	pp_task_queue_shard_unlock(shard);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: pop the first task from sequence                                  *
+ *                                                                            *
+ * Parameters: queue    - [IN] task queue                                     *
+ *             task_seq - [IN] finished sequence task                         *
+ *                                                                            *
+ * Return value: The popped task or NULL if the sequence is empty.            *
+ *                                                                            *
+ ******************************************************************************/
+zbx_pp_task_t	*pp_task_queue_pop_sequence_task(zbx_pp_queue_t *queue, zbx_pp_task_t *task_seq)
+{
+	zbx_pp_task_sequence_t	*d_seq = (zbx_pp_task_sequence_t *)PP_TASK_DATA(task_seq);
+	zbx_pp_queue_shard_t	*shard = pp_task_queue_get_shard(queue, task_seq->itemid);
+	zbx_pp_task_t		*task = NULL;
+
+	pp_task_queue_shard_lock(shard);
+	(void)zbx_list_pop(&d_seq->tasks, (void **)&task);
+	pp_task_queue_shard_unlock(shard);
+
+	return task;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: requeue sequence task if it has more tasks or remove it           *
+ *                                                                            *
+ * Parameters: queue    - [IN] task queue                                     *
+ *             task_seq - [IN] finished sequence task                         *
+ *                                                                            *
+ * Return value: SUCCEED - the sequence task was requeued                     *
+ *               FAIL    - the sequence was empty and was removed, the        *
+ *                         sequence task must be freed by caller              *
+ *                                                                            *
+ ******************************************************************************/
+int	pp_task_queue_requeue_sequence(zbx_pp_queue_t *queue, zbx_pp_task_t *task_seq)
+{
+	zbx_pp_task_sequence_t	*d_seq = (zbx_pp_task_sequence_t *)PP_TASK_DATA(task_seq);
+	zbx_pp_queue_shard_t	*shard = pp_task_queue_get_shard(queue, task_seq->itemid);
+	zbx_pp_task_t		*task;
+	int			ret;
+
+	pp_task_queue_shard_lock(shard);
+
+	if (SUCCEED == (ret = zbx_list_peek(&d_seq->tasks, (void **)&task)))
+		pp_task_queue_shard_push_immediate(shard, task_seq);
+	else
+		zbx_hashset_remove(&shard->sequences, &task_seq->itemid);
+
+	pp_task_queue_shard_unlock(shard);
+
+	return ret;
 }
 
 /******************************************************************************
@@ -247,8 +403,12 @@ void	pp_task_queue_remove_sequence(zbx_pp_queue_t *queue, zbx_uint64_t itemid)
  ******************************************************************************/
 void	pp_task_queue_push_test(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
 {
-	queue->pending_num++;
-	(void)zbx_list_append(&queue->immediate, task, NULL);
+	zbx_pp_queue_shard_t	*shard = pp_task_queue_get_shard(queue, task->itemid);
+
+	pp_task_queue_shard_lock(shard);
+	shard->pending_num++;
+	(void)zbx_list_append(&shard->immediate, task, NULL);
+	pp_task_queue_shard_unlock(shard);
 }
 
 /******************************************************************************
@@ -265,67 +425,60 @@ void	pp_task_queue_push_test(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
 void	pp_task_queue_push(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
 {
 	zbx_pp_task_value_t	*d = (zbx_pp_task_value_t *)PP_TASK_DATA(task);
-	queue->pending_num++;
+	zbx_pp_queue_shard_t	*shard = pp_task_queue_get_shard(queue, task->itemid);
+	zbx_pp_task_t		*seq_task;
 
-	if (ITEM_TYPE_INTERNAL != d->preproc->type)
-	{
-		(void)zbx_list_append(&queue->pending, task, NULL);
-		return;
-	}
+	pp_task_queue_shard_lock(shard);
 
-	if (ZBX_PP_TASK_VALUE == task->type)
-	{
-		(void)zbx_list_append(&queue->immediate, task, NULL);
-		return;
-	}
+	shard->pending_num++;
 
-	zbx_pp_task_t	*seq_task;
+	if (ITEM_TYPE_INTERNAL != d->preproc->type)
+		(void)zbx_list_append(&shard->pending, task, NULL);
+	else if (ZBX_PP_TASK_VALUE == task->type)
+		(void)zbx_list_append(&shard->immediate, task, NULL);
+	else if (NULL != (seq_task = pp_task_queue_add_sequence(shard, task)))
+		(void)zbx_list_append(&shard->immediate, seq_task, NULL);
 
-	if (NULL != (seq_task = pp_task_queue_add_sequence(queue, task)))
-		(void)zbx_list_append(&queue->immediate, seq_task, NULL);
+	pp_task_queue_shard_unlock(shard);
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: pop task from task queue                                          *
+ * Purpose: pop task from task queue shard                                    *
  *                                                                            *
- * Parameters: queue - [IN] task queue                                        *
+ * Parameters: shard - [IN] locked task queue shard                           *
  *                                                                            *
  * Return value: The popped task or NULL if there are no tasks to be          *
  *               processed.                                                   *
  *                                                                            *
- * Comments: This function is used by workers to pop tasks for processing.    *
- *           Sequence tasks will be moved to existing tasks sequences or      *
- *           returned if there are no registered sequences for this item.     *
- *                                                                            *
  ******************************************************************************/
-zbx_pp_task_t	*pp_task_queue_pop_new(zbx_pp_queue_t *queue)
+static zbx_pp_task_t	*pp_task_queue_shard_pop_new(zbx_pp_queue_shard_t *shard)
 {
 	zbx_pp_task_t	*task = NULL;
 
-	if (SUCCEED == zbx_list_pop(&queue->immediate, (void **)&task))
+	if (SUCCEED == zbx_list_pop(&shard->immediate, (void **)&task))
 	{
 		/* while sequence tasks do not affect statistics, the first task in sequence */
 		/* does, so the statistics can be updated for all tasks                      */
-		queue->pending_num--;
-		queue->processing_num++;
+		shard->pending_num--;
+		shard->popped_num++;
 
 		return (zbx_pp_task_t *)task;
 	}
 
-	while (SUCCEED == zbx_list_pop(&queue->pending, (void **)&task))
+	while (SUCCEED == zbx_list_pop(&shard->pending, (void **)&task))
 	{
 		if (ZBX_PP_TASK_VALUE_SEQ == task->type)
 		{
 			/* task is being moved from pending to immediate queue */
 			/* while still pending, so statistics are not affected */
-			task = pp_task_queue_add_sequence(queue, task);
+			task = pp_task_queue_add_sequence(shard, task);
 		}
 
 		if (NULL != task)
 		{
-			queue->pending_num--;
-			queue->processing_num++;
+			shard->pending_num--;
+			shard->popped_num++;
 
 			return task;
 		}
@@ -334,6 +487,96 @@ zbx_pp_task_t	*pp_task_queue_pop_new(zbx_pp_queue_t *queue)
 	return NULL;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: pop task from task queue                                          *
+ *                                                                            *
+ * Parameters: queue       - [IN] task queue                                  *
+ *             shard_index - [IN] the worker's own shard                      *
+ *                                                                            *
+ * Return value: The popped task or NULL if there are no tasks to be          *
+ *               processed.                                                   *
+ *                                                                            *
+ * Comments: This function is used by workers to pop tasks for processing.    *
+ *           Workers take tasks from their own shard first and then steal     *
+ *           tasks from other shards. Shards locked by other threads are      *
+ *           skipped on the first pass.                                       *
+ *                                                                            *
+ ******************************************************************************/
+zbx_pp_task_t	*pp_task_queue_pop_new(zbx_pp_queue_t *queue, int shard_index)
+{
+	zbx_pp_queue_shard_t	*shard;
+	zbx_pp_task_t		*task;
+	int			i, busy_num = 0;
+
+	shard = &queue->shards[shard_index % queue->shards_num];
+
+	pp_task_queue_shard_lock(shard);
+	task = pp_task_queue_shard_pop_new(shard);
+	pp_task_queue_shard_unlock(shard);
+
+	if (NULL != task)
+		return task;
+
+	for (i = 1; i < queue->shards_num; i++)
+	{
+		shard = &queue->shards[(shard_index + i) % queue->shards_num];
+
+		if (0 != pthread_mutex_trylock(&shard->lock))
+		{
+			busy_num++;
+			continue;
+		}
+
+		shard->locks_num++;
+
+		if (NULL != (task = pp_task_queue_shard_pop_new(shard)))
+			shard->steals_num++;
+
+		pp_task_queue_shard_unlock(shard);
+
+		if (NULL != task)
+			return task;
+	}
+
+	for (i = 1; 0 < busy_num && i < queue->shards_num; i++)
+	{
+		shard = &queue->shards[(shard_index + i) % queue->shards_num];
+
+		pp_task_queue_shard_lock(shard);
+
+		if (NULL != (task = pp_task_queue_shard_pop_new(shard)))
+			shard->steals_num++;
+
+		pp_task_queue_shard_unlock(shard);
+
+		if (NULL != task)
+			return task;
+	}
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: lock finished task list                                           *
+ *                                                                            *
+ ******************************************************************************/
+void	pp_task_queue_lock_finished(zbx_pp_queue_t *queue)
+{
+	pp_mutex_lock(&queue->finished_lock, &queue->finished_locks_num, &queue->finished_locks_contended_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: unlock finished task list                                         *
+ *                                                                            *
+ ******************************************************************************/
+void	pp_task_queue_unlock_finished(zbx_pp_queue_t *queue)
+{
+	pthread_mutex_unlock(&queue->finished_lock);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: push finished task into queue                                     *
@@ -341,60 +584,103 @@ zbx_pp_task_t	*pp_task_queue_pop_new(zbx_pp_queue_t *queue)
  * Parameters: queue - [IN] task queue                                        *
  *             task  - [IN] task                                              *
  *                                                                            *
+ * Comments: This function must be called with finished task list locked.     *
+ *                                                                            *
  ******************************************************************************/
 void	pp_task_queue_push_finished(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
 {
 	queue->finished_num++;
-	queue->processing_num--;
+	queue->pushed_num++;
 	(void)zbx_list_append(&queue->finished, task, NULL);
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: pop finished task from queue                                      *
+ * Purpose: pop finished tasks from queue                                     *
  *                                                                            *
- * Parameters: queue - [IN] task queue                                        *
+ * Parameters: queue     - [IN] task queue                                    *
+ *             tasks     - [OUT] the popped tasks                             *
+ *             tasks_max - [IN] the maximum number of tasks to pop            *
  *                                                                            *
- * Return value: The popped task or NULL if there are no finished tasks.      *
+ * Return value: The number of popped tasks.                                  *
  *                                                                            *
  ******************************************************************************/
-zbx_pp_task_t	*pp_task_queue_pop_finished(zbx_pp_queue_t *queue)
+int	pp_task_queue_pop_finished(zbx_pp_queue_t *queue, zbx_vector_pp_task_ptr_t *tasks, int tasks_max)
 {
 	zbx_pp_task_t	*task;
+	int		tasks_num = 0;
+
+	pp_task_queue_lock_finished(queue);
 
-	if (SUCCEED == zbx_list_pop(&queue->finished, (void **)&task))
+	while (tasks_num < tasks_max && SUCCEED == zbx_list_pop(&queue->finished, (void **)&task))
 	{
+		zbx_vector_pp_task_ptr_append(tasks, task);
 		queue->finished_num--;
-		return task;
+		tasks_num++;
 	}
 
-	return NULL;
+	pp_task_queue_unlock_finished(queue);
+
+	return tasks_num;
 }
 
 /******************************************************************************
  *                                                                            *
  * Purpose: wait for queue notifications                                      *
  *                                                                            *
- * Parameters: queue - [IN] task queue                                        *
- *             error - [IN]                                                   *
+ * Parameters: queue      - [IN] task queue                                   *
+ *             notify_seq - [IN/OUT] the last seen notification sequence      *
+ *             stop       - [IN] the worker stop flag, protected by queue     *
+ *                               lock                                         *
+ *             error      - [OUT]                                             *
  *                                                                            *
  * Return value: SUCCEED - the wait succeeded                                 *
- *               FAIL    - an error has occurred                              *
+ *               FAIL    - the worker was stopped or an error has occurred,   *
+ *                         in the latter case error is set                    *
  *                                                                            *
- * Comments: This function is used by workers to wait for new tasks.          *
+ * Comments: This function is used by workers to wait for new tasks. The      *
+ *           worker does not sleep if there were notifications since the      *
+ *           last seen notification sequence, so tasks pushed while worker    *
+ *           was checking shards are not missed.                              *
  *                                                                            *
  ******************************************************************************/
-int	pp_task_queue_wait(zbx_pp_queue_t *queue, char **error)
+int	pp_task_queue_wait(zbx_pp_queue_t *queue, zbx_uint64_t *notify_seq, const int *stop, char **error)
 {
-	int	err;
+	int	err, ret = SUCCEED;
+
+	pp_task_queue_lock(queue);
 
-	if (0 != (err = pthread_cond_wait(&queue->event, &queue->lock)))
+	if (0 != *stop)
 	{
-		*error = zbx_dsprintf(NULL, "cannot wait for conditional variable: %s", zbx_strerror(err));
-		return FAIL;
+		ret = FAIL;
+		goto out;
+	}
+
+	if (*notify_seq == queue->notify_seq)
+	{
+		queue->waits_num++;
+		queue->idle_num++;
+
+		err = pthread_cond_wait(&queue->event, &queue->lock);
+
+		queue->idle_num--;
+
+		if (0 != err)
+		{
+			*error = zbx_dsprintf(NULL, "cannot wait for conditional variable: %s", zbx_strerror(err));
+			ret = FAIL;
+			goto out;
+		}
+
+		if (0 != *stop)
+			ret = FAIL;
 	}
 
-	return SUCCEED;
+	*notify_seq = queue->notify_seq;
+out:
+	pp_task_queue_unlock(queue);
+
+	return ret;
 }
 
 /******************************************************************************
@@ -408,13 +694,47 @@ int	pp_task_queue_wait(zbx_pp_queue_t *queue, char **error)
  *                                                                            *
  ******************************************************************************/
 void	pp_task_queue_notify(zbx_pp_queue_t *queue)
+{
+	pp_task_queue_notify_num(queue, 1);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: notify workers about queued tasks                                 *
+ *                                                                            *
+ * Parameters: queue     - [IN] task queue                                    *
+ *             tasks_num - [IN] the number of queued tasks                    *
+ *                                                                            *
+ * Comments: One idle worker is woken up per queued task. Busy workers see    *
+ *           the changed notification sequence and check shards again         *
+ *           before going idle, so waking up more workers than there are      *
+ *           tasks would only make them compete for the shard locks.          *
+ *                                                                            *
+ ******************************************************************************/
+void	pp_task_queue_notify_num(zbx_pp_queue_t *queue, int tasks_num)
 {
 	int	err;
 
-	if (0 != (err = pthread_cond_signal(&queue->event)))
+	if (0 >= tasks_num)
+		return;
+
+	pp_task_queue_lock(queue);
+
+	queue->notify_seq++;
+
+	if (tasks_num > queue->idle_num)
+		tasks_num = queue->idle_num;
+
+	for (int i = 0; i < tasks_num; i++)
 	{
-		zabbix_log(LOG_LEVEL_WARNING, "cannot signal conditional variable: %s", zbx_strerror(err));
+		if (0 != (err = pthread_cond_signal(&queue->event)))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot signal conditional variable: %s", zbx_strerror(err));
+			break;
+		}
 	}
+
+	pp_task_queue_unlock(queue);
 }
 
 /******************************************************************************
@@ -423,18 +743,104 @@ void	pp_task_queue_notify(zbx_pp_queue_t *queue)
  *                                                                            *
  * Parameters: queue - [IN] task queue                                        *
  *                                                                            *
- * Comments: This function is used by manager to notify workers when either   *
- *           multiple tasks have been pushed or when stopping workers.        *
+ * Comments: This function is used by manager to wake up all workers when     *
+ *           stopping them.                                                   *
  *                                                                            *
  ******************************************************************************/
 void	pp_task_queue_notify_all(zbx_pp_queue_t *queue)
 {
 	int	err;
 
+	pp_task_queue_lock(queue);
+
+	queue->notify_seq++;
+
 	if (0 != (err = pthread_cond_broadcast(&queue->event)))
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "cannot broadcast conditional variable: %s", zbx_strerror(err));
 	}
+
+	pp_task_queue_unlock(queue);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get task queue statistics                                         *
+ *                                                                            *
+ * Parameters: queue          - [IN] task queue                               *
+ *             pending_num    - [OUT] tasks waiting to be processed           *
+ *             processing_num - [OUT] tasks being processed                   *
+ *             finished_num   - [OUT] finished tasks                          *
+ *             sequences_num  - [OUT] registered task sequences (optional)    *
+ *                                                                            *
+ ******************************************************************************/
+void	pp_task_queue_get_stats(zbx_pp_queue_t *queue, zbx_uint64_t *pending_num, zbx_uint64_t *processing_num,
+		zbx_uint64_t *finished_num, zbx_uint64_t *sequences_num)
+{
+	zbx_uint64_t	pushed_num, popped_num = 0;
+
+	/* read finished counters first - every finished task is counted as popped before */
+	/* it is pushed to finished list, so processing task count cannot underflow        */
+	pp_task_queue_lock_finished(queue);
+	*finished_num = queue->finished_num;
+	pushed_num = queue->pushed_num;
+	pp_task_queue_unlock_finished(queue);
+
+	*pending_num = 0;
+
+	if (NULL != sequences_num)
+		*sequences_num = 0;
+
+	for (int i = 0; i < queue->shards_num; i++)
+	{
+		zbx_pp_queue_shard_t	*shard = &queue->shards[i];
+
+		pp_task_queue_shard_lock(shard);
+
+		*pending_num += shard->pending_num;
+		popped_num += shard->popped_num;
+
+		if (NULL != sequences_num)
+			*sequences_num += (zbx_uint64_t)shard->sequences.num_data;
+
+		pp_task_queue_shard_unlock(shard);
+	}
+
+	*processing_num = popped_num - pushed_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get task queue lock contention statistics                         *
+ *                                                                            *
+ ******************************************************************************/
+void	pp_task_queue_get_contention_stats(zbx_pp_queue_t *queue, zbx_pp_queue_stats_t *stats)
+{
+	memset(stats, 0, sizeof(zbx_pp_queue_stats_t));
+
+	stats->shards_num = (zbx_uint64_t)queue->shards_num;
+
+	for (int i = 0; i < queue->shards_num; i++)
+	{
+		zbx_pp_queue_shard_t	*shard = &queue->shards[i];
+
+		pthread_mutex_lock(&shard->lock);
+
+		stats->locks_num += shard->locks_num;
+		stats->locks_contended_num += shard->locks_contended_num;
+		stats->steals_num += shard->steals_num;
+
+		pthread_mutex_unlock(&shard->lock);
+	}
+
+	pthread_mutex_lock(&queue->finished_lock);
+	stats->finished_locks_num = queue->finished_locks_num;
+	stats->finished_locks_contended_num = queue->finished_locks_contended_num;
+	pthread_mutex_unlock(&queue->finished_lock);
+
+	pp_task_queue_lock(queue);
+	stats->waits_num = queue->waits_num;
+	pp_task_queue_unlock(queue);
 }
 
 /******************************************************************************
@@ -453,31 +859,35 @@ void	pp_task_queue_get_sequence_stats(zbx_pp_queue_t *queue, zbx_vector_pp_seque
 	zbx_pp_sequence_stats_t		*stat;
 	zbx_list_iterator_t		li;
 
-	pp_task_queue_lock(queue);
-
-	zbx_hashset_iter_reset(&queue->sequences, &iter);
-	while (NULL != (sequence = (zbx_pp_item_task_sequence_t *)zbx_hashset_iter_next(&iter)))
+	for (int i = 0; i < queue->shards_num; i++)
 	{
-		stat = (zbx_pp_sequence_stats_t *)zbx_malloc(NULL, sizeof(zbx_pp_sequence_stats_t));
-		stat->tasks_num = 0;
-		stat->itemid = sequence->itemid;
+		zbx_pp_queue_shard_t	*shard = &queue->shards[i];
 
-		zbx_pp_task_sequence_t	*d_seq = (zbx_pp_task_sequence_t *)PP_TASK_DATA(sequence->task);
+		pp_task_queue_shard_lock(shard);
 
-		if (NULL != d_seq->tasks.head)
+		zbx_hashset_iter_reset(&shard->sequences, &iter);
+		while (NULL != (sequence = (zbx_pp_item_task_sequence_t *)zbx_hashset_iter_next(&iter)))
 		{
-			zbx_list_iterator_init(&d_seq->tasks, &li);
+			stat = (zbx_pp_sequence_stats_t *)zbx_malloc(NULL, sizeof(zbx_pp_sequence_stats_t));
+			stat->tasks_num = 0;
+			stat->itemid = sequence->itemid;
+
+			zbx_pp_task_sequence_t	*d_seq = (zbx_pp_task_sequence_t *)PP_TASK_DATA(sequence->task);
 
-			do
+			if (NULL != d_seq->tasks.head)
 			{
-				stat->tasks_num++;
+				zbx_list_iterator_init(&d_seq->tasks, &li);
+
+				do
+				{
+					stat->tasks_num++;
+				}
+				while (SUCCEED == zbx_list_iterator_next(&li));
 			}
-			while (SUCCEED == zbx_list_iterator_next(&li));
+
+			zbx_vector_pp_sequence_stats_ptr_append(stats, stat);
 		}
 
-		zbx_vector_pp_sequence_stats_ptr_append(stats, stat);
+		pp_task_queue_shard_unlock(shard);
 	}
-
-	pp_task_queue_unlock(queue);
-
 }
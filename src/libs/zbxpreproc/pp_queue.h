@@ -18,46 +18,81 @@
 #include "zbxpreproc.h"
 #include "zbxalgo.h"
 
+/* task queue shard - tasks are distributed between shards by itemid, so all tasks */
+/* of the same item are kept in the same shard and task sequencing is local to it  */
 typedef struct
 {
-	zbx_uint32_t	init_flags;
-	int		workers_num;
-	zbx_uint64_t	pending_num;
-	zbx_uint64_t	finished_num;
-	zbx_uint64_t	processing_num;
-
 	zbx_hashset_t	sequences;
 
 	zbx_list_t	pending;
 	zbx_list_t	immediate;
-	zbx_list_t	finished;
+
+	zbx_uint64_t	pending_num;
+	zbx_uint64_t	popped_num;
+
+	/* contention statistics */
+	zbx_uint64_t	locks_num;
+	zbx_uint64_t	locks_contended_num;
+	zbx_uint64_t	steals_num;
 
 	pthread_mutex_t	lock;
-	pthread_cond_t	event;
+}
+zbx_pp_queue_shard_t;
+
+typedef struct
+{
+	zbx_uint32_t		init_flags;
+
+	zbx_pp_queue_shard_t	*shards;
+	int			shards_num;
+
+	/* finished tasks, protected by finished_lock */
+	zbx_list_t		finished;
+	zbx_uint64_t		finished_num;
+	zbx_uint64_t		pushed_num;
+	zbx_uint64_t		finished_locks_num;
+	zbx_uint64_t		finished_locks_contended_num;
+	pthread_mutex_t		finished_lock;
+
+	/* worker registration and idle worker notification, protected by lock */
+	int			workers_num;
+	int			idle_num;	/* workers waiting for notification */
+	zbx_uint64_t		notify_seq;
+	zbx_uint64_t		waits_num;
+	pthread_mutex_t		lock;
+	pthread_cond_t		event;
 }
 zbx_pp_queue_t;
 
-int	pp_task_queue_init(zbx_pp_queue_t *queue, char **error);
+int	pp_task_queue_init(zbx_pp_queue_t *queue, int shards_num, char **error);
 void	pp_task_queue_destroy(zbx_pp_queue_t *queue);
 
 void	pp_task_queue_lock(zbx_pp_queue_t *queue);
 void	pp_task_queue_unlock(zbx_pp_queue_t *queue);
-void	pp_task_queue_register_worker(zbx_pp_queue_t *queue);
+zbx_uint64_t	pp_task_queue_register_worker(zbx_pp_queue_t *queue);
 void	pp_task_queue_deregister_worker(zbx_pp_queue_t *queue);
-void	pp_task_queue_remove_sequence(zbx_pp_queue_t *queue, zbx_uint64_t itemid);
 
-int	pp_task_queue_wait(zbx_pp_queue_t *queue, char **error);
+int	pp_task_queue_wait(zbx_pp_queue_t *queue, zbx_uint64_t *notify_seq, const int *stop, char **error);
 void	pp_task_queue_notify(zbx_pp_queue_t *queue);
+void	pp_task_queue_notify_num(zbx_pp_queue_t *queue, int tasks_num);
 void	pp_task_queue_notify_all(zbx_pp_queue_t *queue);
 
 void	pp_task_queue_push_test(zbx_pp_queue_t *queue, zbx_pp_task_t *task);
 void	pp_task_queue_push(zbx_pp_queue_t *queue, zbx_pp_task_t *task);
-
-zbx_pp_task_t	*pp_task_queue_pop_new(zbx_pp_queue_t *queue);
 void	pp_task_queue_push_immediate(zbx_pp_queue_t *queue, zbx_pp_task_t *task);
+zbx_pp_task_t	*pp_task_queue_pop_new(zbx_pp_queue_t *queue, int shard_index);
+
+zbx_pp_task_t	*pp_task_queue_pop_sequence_task(zbx_pp_queue_t *queue, zbx_pp_task_t *task_seq);
+int	pp_task_queue_requeue_sequence(zbx_pp_queue_t *queue, zbx_pp_task_t *task_seq);
+
+void	pp_task_queue_lock_finished(zbx_pp_queue_t *queue);
+void	pp_task_queue_unlock_finished(zbx_pp_queue_t *queue);
 void	pp_task_queue_push_finished(zbx_pp_queue_t *queue, zbx_pp_task_t *task);
-zbx_pp_task_t	*pp_task_queue_pop_finished(zbx_pp_queue_t *queue);
+int	pp_task_queue_pop_finished(zbx_pp_queue_t *queue, zbx_vector_pp_task_ptr_t *tasks, int tasks_max);
 
+void	pp_task_queue_get_stats(zbx_pp_queue_t *queue, zbx_uint64_t *pending_num, zbx_uint64_t *processing_num,
+		zbx_uint64_t *finished_num, zbx_uint64_t *sequences_num);
+void	pp_task_queue_get_contention_stats(zbx_pp_queue_t *queue, zbx_pp_queue_stats_t *stats);
 void	pp_task_queue_get_sequence_stats(zbx_pp_queue_t *queue, zbx_vector_pp_sequence_stats_ptr_t *stats);
 
 #endif
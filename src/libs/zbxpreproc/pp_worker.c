@@ -104,7 +104,8 @@ static void	*pp_worker_entry(void *args)
 	zbx_pp_task_t		*in;
 	char			*error = NULL, component[MAX_ID_LEN + 1];
 	sigset_t		mask;
-	int			err;
+	int			err, stop;
+	zbx_uint64_t		notify_seq;
 
 	zbx_snprintf(component, sizeof(component), "%d", worker->id);
 	zbx_set_log_component(component, &worker->logger);
@@ -125,18 +126,13 @@ static void	*pp_worker_entry(void *args)
 	if (0 != (err = pthread_sigmask(SIG_BLOCK, &mask, NULL)))
 		zabbix_log(LOG_LEVEL_WARNING, "cannot block signals: %s", zbx_strerror(err));
 
-	worker->stop = 0;
-
 	pp_context_init(&worker->execute_ctx);
-	pp_task_queue_lock(queue);
-	pp_task_queue_register_worker(queue);
+	notify_seq = pp_task_queue_register_worker(queue);
 
-	while (0 == worker->stop)
+	for (;;)
 	{
-		if (NULL != (in = pp_task_queue_pop_new(queue)))
+		if (NULL != (in = pp_task_queue_pop_new(queue, worker->id - 1)))
 		{
-			pp_task_queue_unlock(queue);
-
 			zbx_timekeeper_update(worker->timekeeper, worker->id - 1, ZBX_PROCESS_STATE_BUSY);
 
 			zabbix_log(LOG_LEVEL_TRACE, "%s() process task type:%u itemid:" ZBX_FS_UI64, __func__,
@@ -161,28 +157,38 @@ static void	*pp_worker_entry(void *args)
 
 			zbx_timekeeper_update(worker->timekeeper, worker->id - 1, ZBX_PROCESS_STATE_IDLE);
 
-			pp_task_queue_lock(queue);
+			pp_task_queue_lock_finished(queue);
+			zbx_regexp_cache_get_stats(&worker->regexp_stats);
 			pp_task_queue_push_finished(queue, in);
 
 			if (NULL != worker->finished_cb)
 				worker->finished_cb(worker->finished_data);
 
+			stop = worker->stop;
+
+			pp_task_queue_unlock_finished(queue);
+
+			if (0 != stop)
+				break;
+
 			continue;
 		}
 
-		if (SUCCEED != pp_task_queue_wait(queue, &error))
+		if (SUCCEED != pp_task_queue_wait(queue, &notify_seq, &worker->stop, &error))
 		{
-			zabbix_log(LOG_LEVEL_WARNING, "[%d] %s", worker->id, error);
-			zbx_free(error);
-			worker->stop = 1;
-		}
+			if (NULL != error)
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "[%d] %s", worker->id, error);
+				zbx_free(error);
+			}
 
-		if (1 < queue->pending_num)
-			pp_task_queue_notify(queue);
+			break;
+		}
 	}
 
 	pp_task_queue_deregister_worker(queue);
-	pp_task_queue_unlock(queue);
+
+	zbx_regexp_cache_clear();
 
 	zabbix_log(LOG_LEVEL_INFORMATION, "thread stopped [%s #%d]",
 			get_process_type_string(ZBX_PROCESS_TYPE_PREPROCESSOR), worker->id);
@@ -213,6 +219,7 @@ int	pp_worker_init(zbx_pp_worker_t *worker, int id, zbx_pp_queue_t *queue, zbx_t
 	pthread_attr_t	attr;
 
 	worker->id = id;
+	worker->stop = 0;
 	worker->queue = queue;
 	worker->timekeeper = timekeeper;
 	worker->config_source_ip = config_source_ip;
@@ -237,11 +244,20 @@ out:
  *                                                                            *
  * Purpose: stop the worker thread                                            *
  *                                                                            *
+ * Comments: The stop flag is set with both task queue and finished task list *
+ *           locked, so worker can read it while holding either of them.      *
+ *                                                                            *
  ******************************************************************************/
 void	pp_worker_stop(zbx_pp_worker_t *worker)
 {
-	if (0 != (worker->init_flags & PP_WORKER_INIT_THREAD))
-		worker->stop = 1;
+	if (0 == (worker->init_flags & PP_WORKER_INIT_THREAD))
+		return;
+
+	pp_task_queue_lock(worker->queue);
+	pp_task_queue_lock_finished(worker->queue);
+	worker->stop = 1;
+	pp_task_queue_unlock_finished(worker->queue);
+	pp_task_queue_unlock(worker->queue);
 }
 
 /******************************************************************************
@@ -19,6 +19,7 @@
 #include "pp_execute.h"
 #include "zbxtimekeeper.h"
 #include "zbxpreproc.h"
+#include "zbxregexp.h"
 
 
 typedef struct
@@ -26,7 +27,7 @@ typedef struct
 	int				id;
 
 	zbx_uint32_t			init_flags;
-	int				stop;
+	int				stop;		/* protected by queue lock and finished lock */
 
 	zbx_pp_queue_t			*queue;
 	pthread_t			thread;
@@ -42,6 +43,8 @@ typedef struct
 	zbx_log_component_t		logger;
 
 	const char			*config_source_ip;
+
+	zbx_regexp_cache_stats_t	regexp_stats;	/* protected by queue finished lock */
 }
 zbx_pp_worker_t;
 
@@ -16,30 +16,50 @@
 #include "zbxalgo.h"
 #include "zbxtime.h"
 
-#define PROF_LEVEL_MAX	10
+#define PROF_LEVEL_MAX		10
+
+/* latency histogram with 4 linear sub-buckets per power of two microseconds */
+#define PROF_HIST_SUB_BITS	2
+#define PROF_HIST_SUB_NUM	(1 << PROF_HIST_SUB_BITS)
+#define PROF_HIST_BUCKETS	128
 
 typedef struct
 {
-	const char		*func_name;
-	double			start;
+	zbx_uint64_t	count;
+	zbx_uint64_t	max;
+	zbx_uint64_t	buckets[PROF_HIST_BUCKETS];
+}
+zbx_prof_hist_t;
+
+typedef struct
+{
+	const char		*func_name;	/* static __func__ of the call site, used as profile identifier */
 	double			sec;
 	double			sec_wait;
 	unsigned int		locked;
 	zbx_prof_scope_t	scope;
+	zbx_prof_hist_t		hist_wait;
+	zbx_prof_hist_t		hist_busy;
 }
 zbx_func_profile_t;
 
-ZBX_PTR_VECTOR_DECL(func_profiles, zbx_func_profile_t*)
-ZBX_PTR_VECTOR_IMPL(func_profiles, zbx_func_profile_t*)
+typedef struct
+{
+	zbx_func_profile_t	*func_profile;
+	double			start;
+	double			wait;
+}
+zbx_func_frame_t;
 
 static volatile int					zbx_prof_scope_requested;
+static volatile int					zbx_prof_dump_requested;
 
-static ZBX_THREAD_LOCAL zbx_vector_func_profiles_t	zbx_func_profiles;
+static ZBX_THREAD_LOCAL zbx_hashset_t			zbx_func_profiles;
 static ZBX_THREAD_LOCAL zbx_prof_scope_t		zbx_prof_scope;
 static ZBX_THREAD_LOCAL int				zbx_prof_initialized;
+static ZBX_THREAD_LOCAL int				zbx_prof_dumped;
 
-static ZBX_THREAD_LOCAL zbx_func_profile_t		*zbx_func_profile[PROF_LEVEL_MAX];
-#undef PROF_LEVEL_MAX
+static ZBX_THREAD_LOCAL zbx_func_frame_t		zbx_func_frame[PROF_LEVEL_MAX];
 static ZBX_THREAD_LOCAL int				zbx_func_profile_level;
 
 static void	zbx_prof_init(void)
@@ -47,57 +67,124 @@ static void	zbx_prof_init(void)
 	if (0 == zbx_prof_initialized)
 	{
 		zbx_prof_initialized = 1;
-		zbx_vector_func_profiles_create(&zbx_func_profiles);
+		zbx_hashset_create(&zbx_func_profiles, 100, ZBX_DEFAULT_PTR_HASH_FUNC, ZBX_DEFAULT_PTR_COMPARE_FUNC);
 	}
 }
 
-static int	compare_func_profile(const void *d1, const void *d2)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get histogram bucket of the specified duration                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	prof_hist_get_bucket(zbx_uint64_t usec)
+{
+	int		exp = 0, index;
+	zbx_uint64_t	value;
+
+	if (PROF_HIST_SUB_NUM > usec)
+		return (int)usec;
+
+	for (value = usec; PROF_HIST_SUB_NUM * 2 <= value; value >>= 1)
+		exp++;
+
+	index = (exp + 1) * PROF_HIST_SUB_NUM + (int)(value - PROF_HIST_SUB_NUM);
+
+	return PROF_HIST_BUCKETS > index ? index : PROF_HIST_BUCKETS - 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get upper bound of the histogram bucket in microseconds           *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	prof_hist_get_bound(int index)
+{
+	index++;
+
+	if (PROF_HIST_SUB_NUM > index)
+		return (zbx_uint64_t)index;
+
+	return (zbx_uint64_t)(PROF_HIST_SUB_NUM + index % PROF_HIST_SUB_NUM) <<
+			(index / PROF_HIST_SUB_NUM - 1);
+}
+
+static void	prof_hist_add(zbx_prof_hist_t *hist, double sec)
 {
-	const zbx_func_profile_t	*func_profile1 = *((const zbx_func_profile_t * const *)d1);
-	const zbx_func_profile_t	*func_profile2 = *((const zbx_func_profile_t * const *)d2);
+	zbx_uint64_t	usec;
 
-	ZBX_RETURN_IF_NOT_EQUAL(func_profile1->func_name, func_profile2->func_name);
+	usec = 0 < sec ? (zbx_uint64_t)(sec * 1000000) : 0;
 
-	return 0;
+	hist->count++;
+	hist->buckets[prof_hist_get_bucket(usec)]++;
+
+	if (hist->max < usec)
+		hist->max = usec;
 }
 
-static void	func_profile_free(zbx_func_profile_t *func_profile)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: estimate percentile from histogram                                *
+ *                                                                            *
+ * Parameters: hist    - [IN]                                                 *
+ *             percent - [IN] the percentile (0-100)                          *
+ *                                                                            *
+ * Return value: upper bound of the bucket containing the percentile, limited *
+ *               by the maximum observed value, in microseconds               *
+ *                                                                            *
+ * Comments: The last bucket also holds all longer durations, so the maximum  *
+ *           observed value is its only known upper bound.                    *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	prof_hist_get_percentile(const zbx_prof_hist_t *hist, int percent)
 {
-	zbx_free(func_profile);
+	zbx_uint64_t	rank, total = 0, bound;
+	int		i;
+
+	if (0 == hist->count)
+		return 0;
+
+	rank = (hist->count * (zbx_uint64_t)percent + 99) / 100;
+
+	for (i = 0; i < PROF_HIST_BUCKETS; i++)
+	{
+		if (rank <= (total += hist->buckets[i]))
+			break;
+	}
+
+	if (PROF_HIST_BUCKETS - 1 <= i)
+		return hist->max;
+
+	bound = prof_hist_get_bound(i);
+
+	return bound < hist->max ? bound : hist->max;
 }
 
 void	zbx_prof_start(const char *func_name, zbx_prof_scope_t scope)
 {
 	if (0 != zbx_prof_scope)
 	{
-		int			i;
-#if defined(__hpux)
-		/* fix for compiling with HP-UX bundled cc compiler */
-		zbx_func_profile_t	*func_profile, func_profile_local = {func_name, 0};
-#else
-		zbx_func_profile_t	*func_profile, func_profile_local = {.func_name = func_name};
-#endif
-		if (FAIL == (i = zbx_vector_func_profiles_bsearch(&zbx_func_profiles, &func_profile_local,
-				compare_func_profile)))
+		zbx_func_profile_t	*func_profile, func_profile_local;
+		zbx_func_frame_t	*frame;
+
+		func_profile_local.func_name = func_name;
+
+		if (NULL == (func_profile = (zbx_func_profile_t *)zbx_hashset_search(&zbx_func_profiles,
+				&func_profile_local)))
 		{
-			func_profile = zbx_malloc(NULL, sizeof(zbx_func_profile_t));
-			func_profile->func_name = func_name;
-			func_profile->sec = 0;
-			func_profile->locked = 0;
-			func_profile->sec_wait = 0;
-			func_profile->scope = scope;
-
-			zbx_vector_func_profiles_append(&zbx_func_profiles, func_profile);
-			zbx_vector_func_profiles_sort(&zbx_func_profiles, compare_func_profile);
+			memset(&func_profile_local, 0, sizeof(func_profile_local));
+			func_profile_local.func_name = func_name;
+			func_profile_local.scope = scope;
+
+			func_profile = (zbx_func_profile_t *)zbx_hashset_insert(&zbx_func_profiles, &func_profile_local,
+					sizeof(func_profile_local));
 		}
-		else
-			func_profile = zbx_func_profiles.values[i];
 
 		func_profile->locked++;
-		func_profile->start = zbx_time();
 
-		zbx_func_profile[zbx_func_profile_level] = func_profile;
-		zbx_func_profile_level++;
+		frame = &zbx_func_frame[zbx_func_profile_level++];
+		frame->func_profile = func_profile;
+		frame->wait = 0;
+		frame->start = zbx_time();
 	}
 }
 
@@ -105,11 +192,13 @@ void	zbx_prof_end_wait(void)
 {
 	if (0 != zbx_prof_scope)
 	{
-		zbx_func_profile_t	*func_profile;
+		zbx_func_frame_t	*frame;
 
-		func_profile = zbx_func_profile[zbx_func_profile_level - 1];
+		frame = &zbx_func_frame[zbx_func_profile_level - 1];
+		frame->wait = zbx_time() - frame->start;
 
-		func_profile->sec_wait += zbx_time() - func_profile->start;
+		frame->func_profile->sec_wait += frame->wait;
+		prof_hist_add(&frame->func_profile->hist_wait, frame->wait);
 	}
 }
 
@@ -117,11 +206,14 @@ void	zbx_prof_end(void)
 {
 	if (0 != zbx_prof_scope)
 	{
-		zbx_func_profile_t	*func_profile;
+		zbx_func_frame_t	*frame;
+		double			sec;
 
-		func_profile = zbx_func_profile[zbx_func_profile_level - 1];
-		func_profile->sec += zbx_time() - func_profile->start;
-		zbx_func_profile_level--;
+		frame = &zbx_func_frame[--zbx_func_profile_level];
+		sec = zbx_time() - frame->start;
+
+		frame->func_profile->sec += sec;
+		prof_hist_add(&frame->func_profile->hist_busy, sec - frame->wait);
 	}
 }
 
@@ -142,7 +234,7 @@ static void	zbx_print_prof(const char *info)
 {
 	if (0 != zbx_prof_scope)
 	{
-		int			i;
+		zbx_hashset_iter_t	iter;
 		zbx_func_profile_t	*func_profile;
 		static ZBX_THREAD_LOCAL char	*str = NULL;
 		static ZBX_THREAD_LOCAL size_t	str_alloc;
@@ -151,10 +243,10 @@ static void	zbx_print_prof(const char *info)
 					total_mutex_busy_lock = 0;
 		unsigned int		total_locked_mutex = 0, total_locked_rwlock = 0;
 
-		for (i = 0; i < zbx_func_profiles.values_num; i++)
-		{
-			func_profile = zbx_func_profiles.values[i];
+		zbx_hashset_iter_reset(&zbx_func_profiles, &iter);
 
+		while (NULL != (func_profile = (zbx_func_profile_t *)zbx_hashset_iter_next(&iter)))
+		{
 			if (0 == (zbx_prof_scope & func_profile->scope))
 				continue;
 
@@ -215,6 +307,71 @@ static void	zbx_print_prof(const char *info)
 	}
 }
 
+static void	prof_hist_dump_json(char **str, size_t *str_alloc, size_t *str_offset, const char *name,
+		const zbx_prof_hist_t *hist)
+{
+	zbx_snprintf_alloc(str, str_alloc, str_offset, ",\"%s\":{\"count\":" ZBX_FS_UI64 ",\"p50\":" ZBX_FS_DBL
+			",\"p99\":" ZBX_FS_DBL ",\"max\":" ZBX_FS_DBL "}", name, hist->count,
+			(double)prof_hist_get_percentile(hist, 50) / 1000000,
+			(double)prof_hist_get_percentile(hist, 99) / 1000000, (double)hist->max / 1000000);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: log profiling latency histograms of the current thread in JSON    *
+ *          format                                                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_dump_prof(const char *info)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_func_profile_t	*func_profile;
+	char			*str = NULL;
+	size_t			str_alloc = 0, str_offset = 0;
+	int			first = 1;
+
+	zbx_snprintf_alloc(&str, &str_alloc, &str_offset, "{\"process\":\"%s\",\"functions\":[", info);
+
+	if (0 != zbx_prof_initialized)
+	{
+		zbx_hashset_iter_reset(&zbx_func_profiles, &iter);
+
+		while (NULL != (func_profile = (zbx_func_profile_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (0 == (zbx_prof_scope & func_profile->scope))
+				continue;
+
+			zbx_snprintf_alloc(&str, &str_alloc, &str_offset, "%s{\"name\":\"%s\",\"scope\":\"%s\","
+					"\"calls\":%u,\"busy\":" ZBX_FS_DBL ",\"wait\":" ZBX_FS_DBL,
+					0 == first ? "," : "", func_profile->func_name,
+					get_scope_string(func_profile->scope), func_profile->locked,
+					func_profile->sec - func_profile->sec_wait, func_profile->sec_wait);
+
+			if (ZBX_PROF_PROCESSING != func_profile->scope)
+			{
+				prof_hist_dump_json(&str, &str_alloc, &str_offset, "wait_latency",
+						&func_profile->hist_wait);
+				prof_hist_dump_json(&str, &str_alloc, &str_offset, "hold_latency",
+						&func_profile->hist_busy);
+			}
+			else
+			{
+				prof_hist_dump_json(&str, &str_alloc, &str_offset, "busy_latency",
+						&func_profile->hist_busy);
+			}
+
+			zbx_snprintf_alloc(&str, &str_alloc, &str_offset, "}");
+			first = 0;
+		}
+	}
+
+	zbx_snprintf_alloc(&str, &str_alloc, &str_offset, "]}");
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "=== Profiling histograms for %s === %s", info, str);
+
+	zbx_free(str);
+}
+
 void	zbx_prof_enable(zbx_prof_scope_t scope)
 {
 	if (0 == scope)
@@ -228,10 +385,22 @@ void	zbx_prof_disable(void)
 	zbx_prof_scope_requested = 0;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: request profiling histograms to be logged on the next update      *
+ *                                                                            *
+ * Comments: called from signal handler, so only sets the request counter     *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_prof_dump(void)
+{
+	zbx_prof_dump_requested++;
+}
+
 static void	zbx_reset_prof(void)
 {
 	if (0 != zbx_prof_initialized)
-		zbx_vector_func_profiles_clear_ext(&zbx_func_profiles, func_profile_free);
+		zbx_hashset_clear(&zbx_func_profiles);
 }
 
 void	zbx_prof_update(const char *info, double time_now)
@@ -247,6 +416,17 @@ void	zbx_prof_update(const char *info, double time_now)
 	else
 		zbx_prof_scope = 0;
 
+	if (zbx_prof_dumped != zbx_prof_dump_requested)
+	{
+		zbx_prof_dumped = zbx_prof_dump_requested;
+
+		if (0 != zbx_prof_scope)
+			zbx_dump_prof(info);
+		else
+			zabbix_log(LOG_LEVEL_INFORMATION, "cannot dump profiling histograms for %s: profiling is "
+					"disabled", info);
+	}
+
 	if (PROF_UPDATE_INTERVAL < time_now - last_update)
 	{
 		last_update = time_now;
@@ -258,3 +438,8 @@ void	zbx_prof_update(const char *info, double time_now)
 	}
 #undef PROF_UPDATE_INTERVAL
 }
+
+#undef PROF_LEVEL_MAX
+#undef PROF_HIST_SUB_BITS
+#undef PROF_HIST_SUB_NUM
+#undef PROF_HIST_BUCKETS
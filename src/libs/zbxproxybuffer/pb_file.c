@@ -0,0 +1,1284 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "pb_file.h"
+#include "proxybuffer.h"
+#include "zbxalgo.h"
+#include "zbxcacheconfig.h"
+#include "zbxcommon.h"
+#include "zbxnum.h"
+#include "zbxserialize.h"
+#include "zbxstr.h"
+
+#include <sys/mman.h>
+
+/******************************************************************************
+ *                                                                            *
+ *                     History segment file layout                            *
+ *                  -----------------------------------                       *
+ *                                                                            *
+ * History records are appended to segment files named by the id of the      *
+ * first record in segment - history-<first id>.seg. Segment starts with      *
+ * header:                                                                    *
+ *                                                                            *
+ *   | signature (8 bytes) | version (4 bytes) | reserved (4 bytes) |         *
+ *                                                                            *
+ * followed by records:                                                       *
+ *                                                                            *
+ *   | payload length (4 bytes) | payload crc32 (4 bytes) | payload |         *
+ *                                                                            *
+ * When the active segment grows over PB_FILE_SEGMENT_SIZE a new segment is   *
+ * started. Segments are read through memory mapping. The position after the *
+ * last record acknowledged by server is kept in the index file, segments     *
+ * before it are unlinked.                                                    *
+ *                                                                            *
+ * On startup the active (last) segment is scanned and truncated after the    *
+ * last record with valid checksum, discarding partially written data.        *
+ *                                                                            *
+ * Segment and index files are written by holding the proxy buffer file lock. *
+ * The proxy buffer lock is taken only to publish the new segment size and    *
+ * read cursor after the data has been written, so file I/O never blocks the  *
+ * processes accessing proxy buffer.                                          *
+ *                                                                            *
+ ******************************************************************************/
+
+#define PB_FILE_SIGNATURE		"ZBXPBSEG"
+#define PB_FILE_INDEX_SIGNATURE		"ZBXPBIDX"
+#define PB_FILE_SIGNATURE_LEN		8
+#define PB_FILE_VERSION			1
+
+#define PB_FILE_HEADER_SIZE		16
+#define PB_FILE_RECORD_HEADER_SIZE	(2 * sizeof(zbx_uint32_t))
+#define PB_FILE_INDEX_SIZE		(PB_FILE_SIGNATURE_LEN + 3 * sizeof(zbx_uint64_t) + sizeof(zbx_uint32_t))
+
+#define PB_FILE_SEGMENT_SIZE		(16 * ZBX_MEBIBYTE)
+
+#define PB_FILE_SEGMENT_PREFIX		"history-"
+#define PB_FILE_SEGMENT_SUFFIX		".seg"
+#define PB_FILE_INDEX_NAME		"history.idx"
+
+typedef struct
+{
+	zbx_uint64_t	id;
+	zbx_uint64_t	segment;
+	zbx_uint64_t	offset;		/* position after the record */
+}
+pb_file_pos_t;
+
+ZBX_VECTOR_DECL(pb_file_pos, pb_file_pos_t)
+ZBX_VECTOR_IMPL(pb_file_pos, pb_file_pos_t)
+
+typedef struct
+{
+	zbx_uint64_t			segment;	/* the segment being read, 0 if there are no segments */
+	zbx_uint64_t			offset;		/* the read position in segment */
+	zbx_uint64_t			lastid;		/* id of the last read record */
+
+	/* the active segment and its size when reading was started */
+	zbx_uint64_t			end_segment;
+	zbx_uint64_t			end_offset;
+
+	unsigned char			*map;
+	size_t				map_size;
+	zbx_uint64_t			map_segment;
+	int				map_complete;	/* the segment was not written when mapped */
+
+	/* positions of the records returned since reading was started */
+	zbx_vector_pb_file_pos_t	positions;
+}
+pb_file_reader_t;
+
+static char		*pb_file_dir = NULL;
+
+/* the active segment opened for writing by this process */
+static int		writer_fd = -1;
+static zbx_uint64_t	writer_segment = 0;
+
+static pb_file_reader_t	reader;
+
+static zbx_uint32_t	pb_file_crc32(const unsigned char *data, size_t len)
+{
+	static zbx_uint32_t	table[256];
+	static int		table_init = 0;
+	zbx_uint32_t		crc = 0xffffffff;
+
+	if (0 == table_init)
+	{
+		for (zbx_uint32_t i = 0; i < 256; i++)
+		{
+			zbx_uint32_t	c = i;
+
+			for (int k = 0; k < 8; k++)
+				c = (0 != (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1);
+
+			table[i] = c;
+		}
+
+		table_init = 1;
+	}
+
+	for (size_t i = 0; i < len; i++)
+		crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+
+	return crc ^ 0xffffffff;
+}
+
+static char	*pb_file_segment_path(zbx_uint64_t segment)
+{
+	return zbx_dsprintf(NULL, "%s/" PB_FILE_SEGMENT_PREFIX "%020llu" PB_FILE_SEGMENT_SUFFIX, pb_file_dir,
+			(unsigned long long)segment);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get sorted list of segment files                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	pb_file_list_segments(zbx_vector_uint64_t *segments)
+{
+	DIR		*dir;
+	struct dirent	*entry;
+
+	if (NULL == (dir = opendir(pb_file_dir)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot open proxy buffer directory \"%s\": %s", pb_file_dir,
+				zbx_strerror(errno));
+		return;
+	}
+
+	while (NULL != (entry = readdir(dir)))
+	{
+		size_t		len;
+		zbx_uint64_t	segment;
+		const char	*ptr;
+
+		if (0 != strncmp(entry->d_name, PB_FILE_SEGMENT_PREFIX, ZBX_CONST_STRLEN(PB_FILE_SEGMENT_PREFIX)))
+			continue;
+
+		ptr = entry->d_name + ZBX_CONST_STRLEN(PB_FILE_SEGMENT_PREFIX);
+		len = strlen(ptr);
+
+		if (len <= ZBX_CONST_STRLEN(PB_FILE_SEGMENT_SUFFIX) ||
+				0 != strcmp(ptr + len - ZBX_CONST_STRLEN(PB_FILE_SEGMENT_SUFFIX), PB_FILE_SEGMENT_SUFFIX))
+		{
+			continue;
+		}
+
+		if (SUCCEED != zbx_is_uint64_n(ptr, len - ZBX_CONST_STRLEN(PB_FILE_SEGMENT_SUFFIX), &segment) ||
+				0 == segment)
+		{
+			continue;
+		}
+
+		zbx_vector_uint64_append(segments, segment);
+	}
+
+	closedir(dir);
+
+	zbx_vector_uint64_sort(segments, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get the first segment after the specified segment                 *
+ *                                                                            *
+ * Return value: The segment or 0 if there are no more segments.              *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	pb_file_next_segment(zbx_uint64_t segment)
+{
+	zbx_vector_uint64_t	segments;
+	zbx_uint64_t		next = 0;
+
+	zbx_vector_uint64_create(&segments);
+	pb_file_list_segments(&segments);
+
+	for (int i = 0; i < segments.values_num; i++)
+	{
+		if (segments.values[i] > segment)
+		{
+			next = segments.values[i];
+			break;
+		}
+	}
+
+	zbx_vector_uint64_destroy(&segments);
+
+	return next;
+}
+
+static int	pb_file_write_all(int fd, const char *buf, size_t len, zbx_uint64_t offset)
+{
+	while (0 < len)
+	{
+		ssize_t	n;
+
+		if (-1 == (n = pwrite(fd, buf, len, (off_t)offset)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			return FAIL;
+		}
+
+		buf += n;
+		len -= (size_t)n;
+		offset += (zbx_uint64_t)n;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: flush segment directory entries to disk                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	pb_file_sync_dir(void)
+{
+	int	fd;
+
+	if (-1 == (fd = open(pb_file_dir, O_RDONLY)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot open proxy buffer directory \"%s\": %s", pb_file_dir,
+				zbx_strerror(errno));
+		return;
+	}
+
+	if (0 != fsync(fd))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot flush proxy buffer directory \"%s\": %s", pb_file_dir,
+				zbx_strerror(errno));
+	}
+
+	close(fd);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: write read cursor into the index file                             *
+ *                                                                            *
+ * Comments: This function must be called with proxy buffer file locked and   *
+ *           proxy buffer unlocked.                                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	pb_file_write_index(const zbx_pb_t *pb)
+{
+	unsigned char	buf[PB_FILE_INDEX_SIZE], *ptr = buf;
+	char		*path, *path_tmp;
+	int		fd;
+	zbx_uint32_t	crc;
+	zbx_uint64_t	lastid, segment, offset;
+
+	pb_lock();
+	lastid = pb->history_lastid_sent;
+	segment = pb->file_read_segment;
+	offset = pb->file_read_offset;
+	pb_unlock();
+
+	memcpy(ptr, PB_FILE_INDEX_SIGNATURE, PB_FILE_SIGNATURE_LEN);
+	ptr += PB_FILE_SIGNATURE_LEN;
+	ptr += zbx_serialize_uint64(ptr, lastid);
+	ptr += zbx_serialize_uint64(ptr, segment);
+	ptr += zbx_serialize_uint64(ptr, offset);
+	crc = pb_file_crc32(buf, (size_t)(ptr - buf));
+	(void)zbx_serialize_value(ptr, crc);
+
+	path = zbx_dsprintf(NULL, "%s/" PB_FILE_INDEX_NAME, pb_file_dir);
+	path_tmp = zbx_dsprintf(NULL, "%s.tmp", path);
+
+	if (-1 == (fd = open(path_tmp, O_WRONLY | O_CREAT | O_TRUNC, 0600)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot create proxy buffer index file \"%s\": %s", path_tmp,
+				zbx_strerror(errno));
+		goto out;
+	}
+
+	if (SUCCEED != pb_file_write_all(fd, (const char *)buf, sizeof(buf), 0) || 0 != fsync(fd))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot write proxy buffer index file \"%s\": %s", path_tmp,
+				zbx_strerror(errno));
+		close(fd);
+		goto out;
+	}
+
+	close(fd);
+
+	if (0 != rename(path_tmp, path))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot rename proxy buffer index file \"%s\": %s", path_tmp,
+				zbx_strerror(errno));
+		goto out;
+	}
+
+	pb_file_sync_dir();
+out:
+	zbx_free(path_tmp);
+	zbx_free(path);
+}
+
+static int	pb_file_read_index(zbx_uint64_t *lastid, zbx_uint64_t *segment, zbx_uint64_t *offset)
+{
+	unsigned char	buf[PB_FILE_INDEX_SIZE];
+	const unsigned char	*ptr = buf;
+	char		*path;
+	int		fd, ret = FAIL;
+	zbx_uint32_t	crc;
+
+	path = zbx_dsprintf(NULL, "%s/" PB_FILE_INDEX_NAME, pb_file_dir);
+
+	if (-1 == (fd = open(path, O_RDONLY)))
+	{
+		if (ENOENT != errno)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot open proxy buffer index file \"%s\": %s", path,
+					zbx_strerror(errno));
+		}
+
+		goto out;
+	}
+
+	if ((ssize_t)sizeof(buf) != read(fd, buf, sizeof(buf)) ||
+			0 != memcmp(buf, PB_FILE_INDEX_SIGNATURE, PB_FILE_SIGNATURE_LEN))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "invalid proxy buffer index file \"%s\"", path);
+		close(fd);
+		goto out;
+	}
+
+	close(fd);
+
+	ptr += PB_FILE_SIGNATURE_LEN;
+	ptr += zbx_deserialize_uint64(ptr, lastid);
+	ptr += zbx_deserialize_uint64(ptr, segment);
+	ptr += zbx_deserialize_uint64(ptr, offset);
+	(void)zbx_deserialize_value(ptr, &crc);
+
+	if (crc != pb_file_crc32(buf, (size_t)(ptr - buf)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "invalid proxy buffer index file \"%s\" checksum", path);
+		goto out;
+	}
+
+	ret = SUCCEED;
+out:
+	zbx_free(path);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: create new segment file                                           *
+ *                                                                            *
+ * Return value: opened segment file descriptor or -1 on error                *
+ *                                                                            *
+ ******************************************************************************/
+static int	pb_file_create_segment(zbx_uint64_t segment)
+{
+	char		header[PB_FILE_HEADER_SIZE], *path;
+	int		fd;
+	zbx_uint32_t	version = PB_FILE_VERSION;
+
+	memset(header, 0, sizeof(header));
+	memcpy(header, PB_FILE_SIGNATURE, PB_FILE_SIGNATURE_LEN);
+	memcpy(header + PB_FILE_SIGNATURE_LEN, &version, sizeof(version));
+
+	path = pb_file_segment_path(segment);
+
+	if (-1 == (fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot create proxy buffer segment file \"%s\": %s", path,
+				zbx_strerror(errno));
+		goto out;
+	}
+
+	if (SUCCEED != pb_file_write_all(fd, header, sizeof(header), 0))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot write proxy buffer segment file \"%s\": %s", path,
+				zbx_strerror(errno));
+		close(fd);
+		(void)unlink(path);
+		fd = -1;
+	}
+out:
+	zbx_free(path);
+
+	return fd;
+}
+
+static void	pb_file_close_writer(void)
+{
+	if (-1 != writer_fd)
+	{
+		close(writer_fd);
+		writer_fd = -1;
+		writer_segment = 0;
+	}
+}
+
+static int	pb_file_open_writer(const zbx_pb_t *pb)
+{
+	char	*path;
+
+	if (-1 != writer_fd && writer_segment == pb->file_segment)
+		return SUCCEED;
+
+	pb_file_close_writer();
+
+	path = pb_file_segment_path(pb->file_segment);
+
+	if (-1 == (writer_fd = open(path, O_WRONLY)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot open proxy buffer segment file \"%s\": %s", path,
+				zbx_strerror(errno));
+		zbx_free(path);
+
+		return FAIL;
+	}
+
+	zbx_free(path);
+	writer_segment = pb->file_segment;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: remove acknowledged and expired segments                          *
+ *                                                                            *
+ * Comments: Segments are expired when they were not modified for the         *
+ *           offline buffer period. The active segment is never removed.      *
+ *                                                                            *
+ *           This function must be called with proxy buffer file locked and   *
+ *           proxy buffer unlocked.                                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	pb_file_remove_segments(zbx_pb_t *pb)
+{
+	zbx_vector_uint64_t	segments;
+	zbx_uint64_t		read_segment;
+	time_t			now;
+	int			cursor_changed = 0;
+
+	zbx_vector_uint64_create(&segments);
+	pb_file_list_segments(&segments);
+
+	pb_lock();
+	read_segment = pb->file_read_segment;
+	pb_unlock();
+
+	now = time(NULL);
+
+	/* the active segment is changed only with proxy buffer file locked */
+	for (int i = 0; i < segments.values_num && segments.values[i] != pb->file_segment; i++)
+	{
+		zbx_uint64_t	segment = segments.values[i];
+		char		*path;
+		zbx_stat_t	st;
+
+		path = pb_file_segment_path(segment);
+
+		if (segment >= read_segment)
+		{
+			if (0 != zbx_stat(path, &st) || now - st.st_mtime <= pb->offline_buffer)
+			{
+				zbx_free(path);
+				break;
+			}
+
+			zabbix_log(LOG_LEVEL_WARNING, "discarding proxy buffer segment file \"%s\": data is older than"
+					" ProxyOfflineBuffer", path);
+
+			pb_lock();
+
+			if (segment == pb->file_read_segment)
+			{
+				/* move read cursor to the beginning of next segment */
+				pb->file_read_segment = (i + 1 < segments.values_num ? segments.values[i + 1] : 0);
+				pb->file_read_offset = PB_FILE_HEADER_SIZE;
+
+				if (0 != pb->file_read_segment)
+					pb->history_lastid_sent = pb->file_read_segment - 1;
+				cursor_changed = 1;
+			}
+
+			pb_unlock();
+		}
+
+		if (0 != unlink(path))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot remove proxy buffer segment file \"%s\": %s", path,
+					zbx_strerror(errno));
+		}
+
+		zbx_free(path);
+	}
+
+	if (0 != cursor_changed)
+		pb_file_write_index(pb);
+
+	zbx_vector_uint64_destroy(&segments);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: start new active segment                                          *
+ *                                                                            *
+ * Comments: This function must be called with proxy buffer file locked and   *
+ *           proxy buffer unlocked.                                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	pb_file_rotate(zbx_pb_t *pb, zbx_uint64_t segment)
+{
+	int	fd;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() segment:" ZBX_FS_UI64, __func__, segment);
+
+	if (0 != pb->file_segment)
+		pb_file_sync(pb);
+
+	if (-1 == (fd = pb_file_create_segment(segment)))
+		return FAIL;
+
+	/* make sure the new segment is not lost with the records written into it */
+	pb_file_sync_dir();
+
+	pb_file_close_writer();
+	writer_fd = fd;
+	writer_segment = segment;
+
+	pb_lock();
+
+	pb->file_segment = segment;
+	pb->file_segment_size = PB_FILE_HEADER_SIZE;
+	pb->file_sealed = 0;
+
+	if (0 == pb->file_read_segment)
+	{
+		pb->file_read_segment = segment;
+		pb->file_read_offset = PB_FILE_HEADER_SIZE;
+	}
+
+	pb_unlock();
+
+	pb_file_remove_segments(pb);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+
+	return SUCCEED;
+}
+
+static void	pb_file_serialize_row(char **buf, size_t *buf_alloc, size_t *buf_offset, const zbx_pb_history_t *row)
+{
+	zbx_uint32_t	len = 0, value_len, source_len, crc;
+	const char	*value = ZBX_NULL2EMPTY_STR(row->value), *source = ZBX_NULL2EMPTY_STR(row->source);
+	int		write_clock = (int)row->write_clock;
+	unsigned char	*ptr, *payload;
+
+	zbx_serialize_prepare_value(len, row->id);
+	zbx_serialize_prepare_value(len, row->itemid);
+	zbx_serialize_prepare_value(len, row->lastlogsize);
+	zbx_serialize_prepare_value(len, row->ts.sec);
+	zbx_serialize_prepare_value(len, row->ts.ns);
+	zbx_serialize_prepare_value(len, row->timestamp);
+	zbx_serialize_prepare_value(len, row->severity);
+	zbx_serialize_prepare_value(len, row->logeventid);
+	zbx_serialize_prepare_value(len, row->state);
+	zbx_serialize_prepare_value(len, row->mtime);
+	zbx_serialize_prepare_value(len, row->flags);
+	zbx_serialize_prepare_value(len, write_clock);
+	zbx_serialize_prepare_str_len(len, value, value_len);
+	zbx_serialize_prepare_str_len(len, source, source_len);
+
+	if (*buf_alloc - *buf_offset < PB_FILE_RECORD_HEADER_SIZE + len)
+	{
+		while (*buf_alloc - *buf_offset < PB_FILE_RECORD_HEADER_SIZE + len)
+			*buf_alloc = (0 == *buf_alloc ? ZBX_KIBIBYTE * 64 : *buf_alloc * 2);
+
+		*buf = (char *)zbx_realloc(*buf, *buf_alloc);
+	}
+
+	ptr = payload = (unsigned char *)*buf + *buf_offset + PB_FILE_RECORD_HEADER_SIZE;
+
+	ptr += zbx_serialize_uint64(ptr, row->id);
+	ptr += zbx_serialize_uint64(ptr, row->itemid);
+	ptr += zbx_serialize_uint64(ptr, row->lastlogsize);
+	ptr += zbx_serialize_int(ptr, row->ts.sec);
+	ptr += zbx_serialize_int(ptr, row->ts.ns);
+	ptr += zbx_serialize_int(ptr, row->timestamp);
+	ptr += zbx_serialize_int(ptr, row->severity);
+	ptr += zbx_serialize_int(ptr, row->logeventid);
+	ptr += zbx_serialize_int(ptr, row->state);
+	ptr += zbx_serialize_int(ptr, row->mtime);
+	ptr += zbx_serialize_int(ptr, row->flags);
+	ptr += zbx_serialize_int(ptr, write_clock);
+	ptr += zbx_serialize_str(ptr, value, value_len);
+	(void)zbx_serialize_str(ptr, source, source_len);
+
+	crc = pb_file_crc32(payload, len);
+
+	ptr = (unsigned char *)*buf + *buf_offset;
+	ptr += zbx_serialize_value(ptr, len);
+	(void)zbx_serialize_value(ptr, crc);
+
+	*buf_offset += PB_FILE_RECORD_HEADER_SIZE + len;
+}
+
+static zbx_pb_history_t	*pb_file_deserialize_row(const unsigned char *ptr)
+{
+	zbx_pb_history_t	*row;
+	zbx_uint32_t		len;
+	int			write_clock;
+
+	row = (zbx_pb_history_t *)zbx_malloc(NULL, sizeof(zbx_pb_history_t));
+
+	ptr += zbx_deserialize_uint64(ptr, &row->id);
+	ptr += zbx_deserialize_uint64(ptr, &row->itemid);
+	ptr += zbx_deserialize_uint64(ptr, &row->lastlogsize);
+	ptr += zbx_deserialize_int(ptr, &row->ts.sec);
+	ptr += zbx_deserialize_int(ptr, &row->ts.ns);
+	ptr += zbx_deserialize_int(ptr, &row->timestamp);
+	ptr += zbx_deserialize_int(ptr, &row->severity);
+	ptr += zbx_deserialize_int(ptr, &row->logeventid);
+	ptr += zbx_deserialize_int(ptr, &row->state);
+	ptr += zbx_deserialize_int(ptr, &row->mtime);
+	ptr += zbx_deserialize_int(ptr, &row->flags);
+	ptr += zbx_deserialize_int(ptr, &write_clock);
+	ptr += zbx_deserialize_str(ptr, &row->value, len);
+	(void)zbx_deserialize_str(ptr, &row->source, len);
+
+	row->write_clock = write_clock;
+
+	/* value and source are not kept for records without value, see pb_history_free() */
+	if (0 != (row->flags & ZBX_PROXY_HISTORY_FLAG_NOVALUE))
+	{
+		zbx_free(row->value);
+		zbx_free(row->source);
+	}
+
+	return row;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check record at the specified segment position                    *
+ *                                                                            *
+ * Parameters: data   - [IN] segment data                                     *
+ *             offset - [IN] record position                                  *
+ *             size   - [IN] segment data size                                *
+ *             len    - [OUT] record payload length                           *
+ *                                                                            *
+ * Return value: SUCCEED - the record is complete and has valid checksum      *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	pb_file_check_record(const unsigned char *data, zbx_uint64_t offset, zbx_uint64_t size,
+		zbx_uint32_t *len)
+{
+	zbx_uint32_t	crc;
+
+	if (offset + PB_FILE_RECORD_HEADER_SIZE > size)
+		return FAIL;
+
+	memcpy(len, data + offset, sizeof(zbx_uint32_t));
+	memcpy(&crc, data + offset + sizeof(zbx_uint32_t), sizeof(zbx_uint32_t));
+
+	if (offset + PB_FILE_RECORD_HEADER_SIZE + *len > size)
+		return FAIL;
+
+	if (crc != pb_file_crc32(data + offset + PB_FILE_RECORD_HEADER_SIZE, *len))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+static void	pb_file_unmap(void)
+{
+	if (NULL != reader.map)
+	{
+		(void)munmap(reader.map, reader.map_size);
+		reader.map = NULL;
+		reader.map_size = 0;
+		reader.map_segment = 0;
+		reader.map_complete = 0;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: map segment file into memory                                      *
+ *                                                                            *
+ * Parameters: segment  - [IN]                                                *
+ *             size_min - [IN] the minimum size of mapped data, 0 to map the  *
+ *                             whole segment which is not written anymore     *
+ *                                                                            *
+ ******************************************************************************/
+static int	pb_file_map_segment(zbx_uint64_t segment, zbx_uint64_t size_min)
+{
+	char		*path;
+	int		fd, ret = FAIL;
+	zbx_stat_t	st;
+	void		*map;
+
+	if (NULL != reader.map && reader.map_segment == segment)
+	{
+		if (0 == size_min ? 0 != reader.map_complete : reader.map_size >= size_min)
+			return SUCCEED;
+	}
+
+	pb_file_unmap();
+
+	path = pb_file_segment_path(segment);
+
+	if (-1 == (fd = open(path, O_RDONLY)))
+	{
+		if (ENOENT != errno)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot open proxy buffer segment file \"%s\": %s", path,
+					zbx_strerror(errno));
+		}
+
+		goto out;
+	}
+
+	if (0 != zbx_fstat(fd, &st) || PB_FILE_HEADER_SIZE > st.st_size)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "invalid proxy buffer segment file \"%s\"", path);
+		close(fd);
+		goto out;
+	}
+
+	map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (MAP_FAILED == map)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot map proxy buffer segment file \"%s\": %s", path,
+				zbx_strerror(errno));
+		goto out;
+	}
+
+	if (0 != memcmp(map, PB_FILE_SIGNATURE, PB_FILE_SIGNATURE_LEN))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "invalid proxy buffer segment file \"%s\" signature", path);
+		(void)munmap(map, (size_t)st.st_size);
+		goto out;
+	}
+
+	reader.map = (unsigned char *)map;
+	reader.map_size = (size_t)st.st_size;
+	reader.map_segment = segment;
+	reader.map_complete = (0 == size_min ? 1 : 0);
+
+	ret = SUCCEED;
+out:
+	zbx_free(path);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: stop writing into the active segment after corrupted data was     *
+ *          found in it                                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	pb_file_seal_segment(zbx_uint64_t segment)
+{
+	zbx_pb_t	*pb = get_pb_data();
+
+	pb_file_lock(pb);
+	pb_lock();
+
+	/* force segment rotation on the next write */
+	if (pb->file_segment == segment)
+		pb->file_sealed = 1;
+
+	pb_unlock();
+	pb_file_unlock(pb);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: recover the active segment after restart                          *
+ *                                                                            *
+ * Comments: Partially written or corrupted records at the end of segment are *
+ *           truncated.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	pb_file_recover_segment(zbx_pb_t *pb, zbx_uint64_t segment)
+{
+	zbx_uint64_t	offset = PB_FILE_HEADER_SIZE, lastid = segment - 1;
+	zbx_uint32_t	len;
+	int		fd;
+	char		*path;
+
+	pb->file_segment = segment;
+
+	if (SUCCEED != pb_file_map_segment(segment, 0))
+	{
+		pb->file_segment_size = PB_FILE_HEADER_SIZE;
+		pb->file_lastid = lastid;
+
+		/* retry creating the segment on the next write */
+		if (-1 != (fd = pb_file_create_segment(segment)))
+		{
+			close(fd);
+			pb->file_sealed = 0;
+		}
+		else
+			pb->file_sealed = 1;
+
+		return;
+	}
+
+	while (SUCCEED == pb_file_check_record(reader.map, offset, reader.map_size, &len))
+	{
+		memcpy(&lastid, reader.map + offset + PB_FILE_RECORD_HEADER_SIZE, sizeof(lastid));
+		offset += PB_FILE_RECORD_HEADER_SIZE + len;
+	}
+
+	if (offset < reader.map_size)
+	{
+		path = pb_file_segment_path(segment);
+
+		zabbix_log(LOG_LEVEL_WARNING, "truncating " ZBX_FS_UI64 " bytes of incomplete data in proxy buffer"
+				" segment file \"%s\"", (zbx_uint64_t)reader.map_size - offset, path);
+
+		if (0 != truncate(path, (off_t)offset))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot truncate proxy buffer segment file \"%s\": %s", path,
+					zbx_strerror(errno));
+		}
+
+		zbx_free(path);
+	}
+
+	pb_file_unmap();
+
+	pb->file_segment_size = offset;
+	pb->file_sealed = 0;
+	pb->file_lastid = lastid;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initialize history segment files                                  *
+ *                                                                            *
+ * Parameters: dir   - [IN] the segment file directory                        *
+ *             error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the directory is usable                            *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	pb_file_init(const char *dir, char **error)
+{
+	zbx_stat_t	st;
+
+	if (NULL == dir || '\0' == *dir)
+	{
+		*error = zbx_strdup(NULL, "proxy buffer file directory is not set");
+		return FAIL;
+	}
+
+	if (0 != zbx_stat(dir, &st))
+	{
+		if (ENOENT != errno || 0 != mkdir(dir, 0700))
+		{
+			*error = zbx_dsprintf(NULL, "cannot access proxy buffer directory \"%s\": %s", dir,
+					zbx_strerror(errno));
+			return FAIL;
+		}
+	}
+	else if (!S_ISDIR(st.st_mode))
+	{
+		*error = zbx_dsprintf(NULL, "proxy buffer path \"%s\" is not a directory", dir);
+		return FAIL;
+	}
+
+	if (0 != access(dir, W_OK | X_OK))
+	{
+		*error = zbx_dsprintf(NULL, "cannot write to proxy buffer directory \"%s\": %s", dir,
+				zbx_strerror(errno));
+		return FAIL;
+	}
+
+	pb_file_dir = zbx_strdup(NULL, dir);
+
+	memset(&reader, 0, sizeof(reader));
+	zbx_vector_pb_file_pos_create(&reader.positions);
+
+	return SUCCEED;
+}
+
+void	pb_file_destroy(void)
+{
+	pb_file_close_writer();
+	pb_file_unmap();
+	zbx_vector_pb_file_pos_destroy(&reader.positions);
+	zbx_free(pb_file_dir);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: restore segment file state after restart                          *
+ *                                                                            *
+ ******************************************************************************/
+void	pb_file_recover(zbx_pb_t *pb)
+{
+	zbx_vector_uint64_t	segments;
+	zbx_uint64_t		lastid = 0, segment = 0, offset = 0;
+	int			index_found, segment_found = FAIL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	zbx_vector_uint64_create(&segments);
+	pb_file_list_segments(&segments);
+
+	index_found = pb_file_read_index(&lastid, &segment, &offset);
+
+	pb->file_segment = 0;
+	pb->file_segment_size = 0;
+	pb->file_lastid = lastid;
+
+	if (0 != segments.values_num)
+		pb_file_recover_segment(pb, segments.values[segments.values_num - 1]);
+
+	if (SUCCEED == index_found)
+	{
+		segment_found = zbx_vector_uint64_bsearch(&segments, segment, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+		if (FAIL != segment_found && segment == pb->file_segment && offset > pb->file_segment_size)
+			offset = pb->file_segment_size;
+	}
+
+	if (FAIL != segment_found)
+	{
+		pb->file_read_segment = segment;
+		pb->file_read_offset = offset;
+		pb->history_lastid_sent = lastid;
+	}
+	else
+	{
+		/* start reading from the first segment not older than the indexed one */
+		pb->file_read_segment = 0;
+		pb->file_read_offset = PB_FILE_HEADER_SIZE;
+
+		for (int i = 0; i < segments.values_num; i++)
+		{
+			if (segments.values[i] > segment)
+			{
+				pb->file_read_segment = segments.values[i];
+				break;
+			}
+		}
+
+		if (SUCCEED == index_found)
+			pb->history_lastid_sent = lastid;
+		else if (0 != pb->file_read_segment)
+			pb->history_lastid_sent = pb->file_read_segment - 1;
+		else
+			pb->history_lastid_sent = 0;
+	}
+
+	pb->history_lastid_db = pb->file_lastid;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() segments:%d lastid:" ZBX_FS_UI64 " sent:" ZBX_FS_UI64, __func__,
+			segments.values_num, pb->file_lastid, pb->history_lastid_sent);
+
+	zbx_vector_uint64_destroy(&segments);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: lock proxy buffer files for writing                               *
+ *                                                                            *
+ * Comments: The proxy buffer file lock must be taken before proxy buffer     *
+ *           lock.                                                            *
+ *                                                                            *
+ ******************************************************************************/
+void	pb_file_lock(zbx_pb_t *pb)
+{
+	zbx_mutex_lock(pb->file_mutex);
+}
+
+void	pb_file_unlock(zbx_pb_t *pb)
+{
+	zbx_mutex_unlock(pb->file_mutex);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: flush the active segment to disk                                  *
+ *                                                                            *
+ * Comments: This function must be called with proxy buffer file locked.      *
+ *                                                                            *
+ ******************************************************************************/
+void	pb_file_sync(zbx_pb_t *pb)
+{
+	if (0 == pb->file_segment)
+		return;
+
+	if (-1 != writer_fd && writer_segment == pb->file_segment)
+	{
+		(void)fdatasync(writer_fd);
+	}
+	else
+	{
+		char	*path;
+		int	fd;
+
+		path = pb_file_segment_path(pb->file_segment);
+
+		if (-1 != (fd = open(path, O_WRONLY)))
+		{
+			(void)fdatasync(fd);
+			close(fd);
+		}
+
+		zbx_free(path);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: append history rows to the active segment                         *
+ *                                                                            *
+ * Parameters: pb     - [IN] the proxy buffer                                 *
+ *             rows   - [IN/OUT] the rows to write, row ids are assigned      *
+ *             lastid - [OUT] id of the last written row                      *
+ *                                                                            *
+ * Return value: SUCCEED - the rows were written                              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: This function must be called with proxy buffer file locked and   *
+ *           proxy buffer unlocked. The active segment state is changed only  *
+ *           with both locks taken, so it can be read with either of them.    *
+ *                                                                            *
+ ******************************************************************************/
+int	pb_file_write_rows(zbx_pb_t *pb, zbx_list_t *rows, zbx_uint64_t *lastid)
+{
+	char			*buf = NULL;
+	size_t			buf_alloc = 0, buf_offset = 0;
+	zbx_uint64_t		id = pb->file_lastid;
+	zbx_list_iterator_t	li;
+	zbx_pb_history_t	*row;
+	int			ret = FAIL;
+
+	zbx_list_iterator_init(rows, &li);
+
+	while (SUCCEED == zbx_list_iterator_next(&li))
+	{
+		(void)zbx_list_iterator_peek(&li, (void **)&row);
+		row->id = ++id;
+		pb_file_serialize_row(&buf, &buf_alloc, &buf_offset, row);
+	}
+
+	if (0 == buf_offset)
+		return SUCCEED;
+
+	if (0 == pb->file_segment || 0 != pb->file_sealed || (PB_FILE_HEADER_SIZE < pb->file_segment_size &&
+			PB_FILE_SEGMENT_SIZE < pb->file_segment_size + buf_offset))
+	{
+		if (SUCCEED != pb_file_rotate(pb, pb->file_lastid + 1))
+			goto out;
+	}
+
+	if (SUCCEED != pb_file_open_writer(pb))
+		goto out;
+
+	if (SUCCEED != pb_file_write_all(writer_fd, buf, buf_offset, pb->file_segment_size))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot write proxy buffer segment file: %s", zbx_strerror(errno));
+
+		/* discard partially written data and continue with new segment */
+		(void)ftruncate(writer_fd, (off_t)pb->file_segment_size);
+
+		pb_lock();
+		pb->file_sealed = 1;
+		pb_unlock();
+
+		goto out;
+	}
+
+	pb_lock();
+	pb->file_segment_size += buf_offset;
+	pb->file_lastid = id;
+	pb_unlock();
+
+	*lastid = id;
+
+	ret = SUCCEED;
+out:
+	zbx_free(buf);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: start reading unsent history rows                                 *
+ *                                                                            *
+ * Comments: This function must be called with proxy buffer locked.           *
+ *                                                                            *
+ ******************************************************************************/
+void	pb_file_read_begin(zbx_pb_t *pb)
+{
+	reader.segment = pb->file_read_segment;
+	reader.offset = pb->file_read_offset;
+	reader.lastid = pb->history_lastid_sent;
+	reader.end_segment = pb->file_segment;
+	reader.end_offset = pb->file_segment_size;
+
+	zbx_vector_pb_file_pos_clear(&reader.positions);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: read next batch of unsent history rows                            *
+ *                                                                            *
+ * Parameters: rows     - [OUT] the read rows                                 *
+ *             rows_max - [IN] the maximum number of rows to read             *
+ *                                                                            *
+ * Return value: The number of rows read.                                     *
+ *                                                                            *
+ ******************************************************************************/
+int	pb_file_read_rows(zbx_vector_pb_history_ptr_t *rows, int rows_max)
+{
+	int	rows_num = 0;
+
+	while (0 != reader.segment && reader.segment <= reader.end_segment && rows_num < rows_max)
+	{
+		zbx_uint64_t	size;
+		zbx_uint32_t	len;
+
+		size = (reader.segment == reader.end_segment ? reader.end_offset : 0);
+
+		if (SUCCEED == pb_file_map_segment(reader.segment, size))
+		{
+			if (reader.segment != reader.end_segment)
+				size = reader.map_size;
+
+			while (rows_num < rows_max && reader.offset < size)
+			{
+				zbx_pb_history_t	*row;
+				pb_file_pos_t		pos;
+
+				if (SUCCEED != pb_file_check_record(reader.map, reader.offset, size, &len))
+				{
+					zabbix_log(LOG_LEVEL_WARNING, "corrupted data in proxy buffer segment "
+							ZBX_FS_UI64 " at offset " ZBX_FS_UI64 ", skipping the rest of"
+							" segment", reader.segment, reader.offset);
+
+					if (reader.segment == reader.end_segment)
+						pb_file_seal_segment(reader.segment);
+
+					reader.offset = size;
+					break;
+				}
+
+				row = pb_file_deserialize_row(reader.map + reader.offset + PB_FILE_RECORD_HEADER_SIZE);
+				reader.offset += PB_FILE_RECORD_HEADER_SIZE + len;
+
+				if (row->id <= reader.lastid)
+				{
+					zbx_free(row->value);
+					zbx_free(row->source);
+					zbx_free(row);
+					continue;
+				}
+
+				reader.lastid = row->id;
+
+				pos.id = row->id;
+				pos.segment = reader.segment;
+				pos.offset = reader.offset;
+				zbx_vector_pb_file_pos_append(&reader.positions, pos);
+
+				zbx_vector_pb_history_ptr_append(rows, row);
+				rows_num++;
+			}
+
+			if (reader.offset < size || reader.segment == reader.end_segment)
+				break;
+		}
+		else if (reader.segment == reader.end_segment)
+			break;
+
+		reader.segment = pb_file_next_segment(reader.segment);
+		reader.offset = PB_FILE_HEADER_SIZE;
+	}
+
+	return rows_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finish reading unsent history rows                                *
+ *                                                                            *
+ ******************************************************************************/
+void	pb_file_read_end(void)
+{
+	/* keep the active segment mapped, it will be read again on next upload */
+	if (NULL != reader.map && reader.map_segment != reader.end_segment)
+		pb_file_unmap();
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: set the last history row acknowledged by server                   *
+ *                                                                            *
+ * Comments: This function must be called with proxy buffer locked. The       *
+ *           index file is updated later by pb_file_update_index().           *
+ *                                                                            *
+ ******************************************************************************/
+void	pb_file_set_lastid(zbx_pb_t *pb, zbx_uint64_t lastid)
+{
+	int	i;
+
+	for (i = reader.positions.values_num - 1; 0 <= i; i--)
+	{
+		if (reader.positions.values[i].id == lastid)
+			break;
+	}
+
+	if (0 <= i)
+	{
+		pb->file_read_segment = reader.positions.values[i].segment;
+		pb->file_read_offset = reader.positions.values[i].offset;
+	}
+	else
+	{
+		/* the rows before lastid will be skipped when reading from the old position */
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() position of record " ZBX_FS_UI64 " is not known", __func__, lastid);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: write read cursor into the index file and remove the segments     *
+ *          acknowledged by server                                            *
+ *                                                                            *
+ ******************************************************************************/
+void	pb_file_update_index(zbx_pb_t *pb)
+{
+	pb_file_lock(pb);
+
+	pb_file_write_index(pb);
+	pb_file_remove_segments(pb);
+
+	pb_file_unlock(pb);
+}
@@ -0,0 +1,38 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#ifndef ZABBIX_PB_FILE_H
+#define ZABBIX_PB_FILE_H
+
+#include "proxybuffer.h"
+#include "zbxalgo.h"
+#include "zbxtypes.h"
+
+int	pb_file_init(const char *dir, char **error);
+void	pb_file_destroy(void);
+void	pb_file_recover(zbx_pb_t *pb);
+void	pb_file_lock(zbx_pb_t *pb);
+void	pb_file_unlock(zbx_pb_t *pb);
+void	pb_file_sync(zbx_pb_t *pb);
+
+int	pb_file_write_rows(zbx_pb_t *pb, zbx_list_t *rows, zbx_uint64_t *lastid);
+
+void	pb_file_read_begin(zbx_pb_t *pb);
+int	pb_file_read_rows(zbx_vector_pb_history_ptr_t *rows, int rows_max);
+void	pb_file_read_end(void);
+
+void	pb_file_set_lastid(zbx_pb_t *pb, zbx_uint64_t lastid);
+void	pb_file_update_index(zbx_pb_t *pb);
+
+#endif
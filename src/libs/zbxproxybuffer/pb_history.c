@@ -13,6 +13,7 @@
 **/
 
 #include "pb_history.h"
+#include "pb_file.h"
 #include "proxybuffer.h"
 #include "zbx_host_constants.h"
 #include "zbx_item_constants.h"
@@ -119,11 +120,15 @@ static void	pb_history_add_value(zbx_pb_history_data_t *data, zbx_uint64_t itemi
  *             rows               - [OUT] read proxy history rows              *
  *             more               - [OUT] set to ZBX_PROXY_DATA_MORE if there *
  *                                        might be more data to read          *
+ *             handleids          - [IN] the opened handles to wait for when  *
+ *                                       records are missing, NULL if there   *
+ *                                       cannot be uncommitted records        *
  *                                                                            *
  * Return value: The number of records read.                                  *
  *                                                                            *
  ******************************************************************************/
-static int	pb_history_get_rows_db(zbx_uint64_t lastid, zbx_vector_pb_history_ptr_t *rows, int *more)
+static int	pb_history_get_rows_db(zbx_uint64_t lastid, zbx_vector_pb_history_ptr_t *rows, int *more,
+		const zbx_vector_uint64_t *handleids)
 {
 	zbx_db_result_t		result;
 	zbx_db_row_t		row;
@@ -161,7 +166,7 @@ try_again:
 				zbx_db_free_result(result);
 
 				gapid = id;
-				pb_wait_handles(&get_pb_data()->history_handleids);
+				pb_wait_handles(handleids);
 
 				goto try_again;
 			}
@@ -353,7 +358,7 @@ static int	pb_history_get_db(struct zbx_json *j, zbx_uint64_t *lastid, int *more
 	/*   2) we have retrieved more than the total maximum number of records */
 	/*   3) we have gathered more than half of the maximum packet size      */
 	while (ZBX_DATA_JSON_BATCH_LIMIT > j->buffer_offset && ZBX_MAX_HRECORDS_TOTAL > records_num &&
-			0 != pb_history_get_rows_db(id, &rows, more))
+			0 != pb_history_get_rows_db(id, &rows, more, &get_pb_data()->history_handleids))
 	{
 		records_num = pb_history_export(j, records_num, &rows, lastid);
 
@@ -379,6 +384,55 @@ static int	pb_history_get_db(struct zbx_json *j, zbx_uint64_t *lastid, int *more
 	return records_num;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get history records from segment files                            *
+ *                                                                            *
+ ******************************************************************************/
+static int	pb_history_get_file(struct zbx_json *j, zbx_uint64_t *lastid, int *more)
+{
+	int				records_num = 0;
+	zbx_vector_pb_history_ptr_t	rows;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	zbx_vector_pb_history_ptr_create(&rows);
+
+	*more = ZBX_PROXY_DATA_MORE;
+
+	pb_lock();
+	pb_file_read_begin(get_pb_data());
+	pb_unlock();
+
+	while (ZBX_DATA_JSON_BATCH_LIMIT > j->buffer_offset && ZBX_MAX_HRECORDS_TOTAL > records_num)
+	{
+		if (ZBX_MAX_HRECORDS != pb_file_read_rows(&rows, ZBX_MAX_HRECORDS))
+			*more = ZBX_PROXY_DATA_DONE;
+
+		if (0 == rows.values_num)
+			break;
+
+		records_num = pb_history_export(j, records_num, &rows, lastid);
+
+		zbx_vector_pb_history_ptr_clear_ext(&rows, pb_history_free);
+
+		if (ZBX_PROXY_DATA_DONE == *more)
+			break;
+	}
+
+	pb_file_read_end();
+
+	if (0 != records_num)
+		zbx_json_close(j);
+
+	zbx_vector_pb_history_ptr_destroy(&rows);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() lastid:" ZBX_FS_UI64 " records_num:%d size:~" ZBX_FS_SIZE_T " more:%d",
+			__func__, *lastid, records_num, j->buffer_offset, *more);
+
+	return records_num;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: get history records from memory cache                             *
@@ -575,6 +629,8 @@ static void	pb_history_add_rows_db(zbx_list_t *rows, zbx_list_item_t *next, zbx_
 		zbx_db_insert_prepare(&db_insert, "proxy_history", "id", "itemid", "clock", "timestamp", "source",
 				"severity", "value", "logeventid", "ns", "state", "lastlogsize", "mtime", "flags",
 				"write_clock", (char *)NULL);
+		zbx_db_insert_enable_copy(&db_insert);
+
 		do
 		{
 			(void)zbx_list_iterator_peek(&li, (void **)&row);
@@ -687,6 +743,194 @@ void	pb_history_set_lastid(zbx_uint64_t lastid)
 	pb_set_lastid("proxy_history", "history_lastid", lastid);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: move unsent history records from database to segment files       *
+ *                                                                            *
+ * Comments: The migrated records get new ids following the last id in        *
+ *           segment files. Records are removed from database only after they *
+ *           have been written to segment files, the rest are migrated again  *
+ *           later.                                                           *
+ *                                                                            *
+ *           This function must be called with proxy buffer file locked and   *
+ *           proxy buffer unlocked.                                           *
+ *                                                                            *
+ ******************************************************************************/
+void	pb_history_file_migrate(zbx_pb_t *pb)
+{
+	zbx_uint64_t			dbid, dbid_migrated, lastid;
+	zbx_vector_pb_history_ptr_t	rows;
+	int				more = ZBX_PROXY_DATA_MORE, records_num = 0, ret = SUCCEED;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	zbx_vector_pb_history_ptr_create(&rows);
+
+	dbid = dbid_migrated = pb_get_lastid("proxy_history", "history_lastid");
+
+	/* in file mode records are inserted into database with proxy buffer file locked */
+	while (ZBX_PROXY_DATA_MORE == more && 0 != pb_history_get_rows_db(dbid, &rows, &more, NULL))
+	{
+		zbx_list_t	list;
+
+		zbx_list_create(&list);
+
+		for (int i = 0; i < rows.values_num; i++)
+		{
+			zbx_pb_history_t	*row = rows.values[i];
+
+			/* database rows are read only with the fields relevant for the record type */
+			if (ZBX_PROXY_HISTORY_FLAG_NOVALUE == (row->flags & ZBX_PROXY_HISTORY_MASK_NOVALUE))
+				row->state = 0;
+
+			if (0 != (row->flags & ZBX_PROXY_HISTORY_FLAG_NOVALUE))
+			{
+				row->timestamp = 0;
+				row->severity = 0;
+				row->logeventid = 0;
+				row->value = NULL;
+				row->source = NULL;
+			}
+
+			if (0 == (row->flags & ZBX_PROXY_HISTORY_FLAG_META))
+			{
+				row->lastlogsize = 0;
+				row->mtime = 0;
+			}
+
+			row->write_clock = row->ts.sec;
+			dbid = row->id;
+
+			zbx_list_append(&list, row, NULL);
+		}
+
+		if (SUCCEED == (ret = pb_file_write_rows(pb, &list, &lastid)))
+		{
+			dbid_migrated = dbid;
+			records_num += rows.values_num;
+		}
+		else
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot migrate history records to proxy buffer files, keeping"
+					" them in database");
+		}
+
+		zbx_list_destroy(&list);
+		zbx_vector_pb_history_ptr_clear_ext(&rows, pb_history_free);
+
+		if (SUCCEED != ret)
+			break;
+	}
+
+	zbx_vector_pb_history_ptr_destroy(&rows);
+
+	if (0 != records_num)
+	{
+		pb_file_sync(pb);
+
+		do
+		{
+			zbx_db_begin();
+			zbx_db_execute("delete from proxy_history where id<=" ZBX_FS_UI64, dbid_migrated);
+			pb_history_set_lastid(dbid_migrated);
+		}
+		while (ZBX_DB_DOWN == zbx_db_commit());
+
+		zabbix_log(LOG_LEVEL_WARNING, "migrated %d unsent history records from database to proxy buffer"
+				" files", records_num);
+	}
+
+	pb_lock();
+
+	if (pb->history_lastid_db < pb->file_lastid)
+		pb->history_lastid_db = pb->file_lastid;
+
+	pb->file_db_pending = (SUCCEED == ret ? 0 : 1);
+
+	pb_unlock();
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() records:%d", __func__, records_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: migrate history records stored in database after segment file     *
+ *          write failure                                                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	pb_history_file_migrate_pending(zbx_pb_t *pb)
+{
+	int	pending;
+
+	pb_lock();
+	pending = pb->file_db_pending;
+	pb_unlock();
+
+	if (0 == pending)
+		return;
+
+	pb_file_lock(pb);
+
+	if (0 != pb->file_db_pending)
+		pb_history_file_migrate(pb);
+
+	pb_file_unlock(pb);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: append history rows to segment files                              *
+ *                                                                            *
+ * Parameters: pb       - [IN] proxy buffer                                   *
+ *             rows     - [IN] rows to add                                    *
+ *             rows_num - [IN] number of rows                                 *
+ *                                                                            *
+ * Comments: When rows cannot be written to segment files they are stored in  *
+ *           database. While there are records waiting in database the new    *
+ *           rows are stored in database too, keeping the order of records.   *
+ *           They are migrated to segment files by data sender, see           *
+ *           zbx_pb_history_get_rows().                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	pb_history_add_rows_file(zbx_pb_t *pb, zbx_list_t *rows, int rows_num)
+{
+	zbx_uint64_t	lastid = 0;
+
+	pb_file_lock(pb);
+
+	if (0 == pb->file_db_pending)
+	{
+		if (SUCCEED == pb_file_write_rows(pb, rows, &lastid))
+		{
+			pb_lock();
+
+			if (pb->history_lastid_db < lastid)
+				pb->history_lastid_db = lastid;
+
+			pb_unlock();
+			goto out;
+		}
+
+		zabbix_log(LOG_LEVEL_WARNING, "cannot write history to proxy buffer files, storing records in database"
+				" until they can be migrated");
+
+		pb_lock();
+		pb->file_db_pending = 1;
+		pb_unlock();
+	}
+
+	pb_history_set_row_ids(rows, rows_num);
+
+	do
+	{
+		zbx_db_begin();
+		pb_history_add_rows_db(rows, NULL, &lastid);
+	}
+	while (ZBX_DB_DOWN == zbx_db_commit());
+out:
+	pb_file_unlock(pb);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: check if history rows are cached in memory buffer                 *
@@ -721,7 +965,12 @@ zbx_pb_history_data_t	*zbx_pb_history_open(void)
 
 	data->handleid = pb_register_handle(pb_data, &(pb_data->history_handleids));
 
-	if (PB_DATABASE == (data->state = get_pb_dst(pb_data->state)))
+	if (ZBX_PB_MODE_FILE == pb_data->mode)
+	{
+		/* rows are collected in handle and appended to segment files when closing it */
+		data->state = PB_MEMORY;
+	}
+	else if (PB_DATABASE == (data->state = get_pb_dst(pb_data->state)))
 		pb_data->db_handles_num++;
 
 	pb_unlock();
@@ -737,6 +986,7 @@ zbx_pb_history_data_t	*zbx_pb_history_open(void)
 		zbx_db_insert_prepare(&data->db_insert, "proxy_history", "id", "itemid", "clock", "timestamp", "source",
 				"severity", "value", "logeventid", "ns", "state", "lastlogsize", "mtime", "flags",
 				"write_clock", (char *)NULL);
+		zbx_db_insert_enable_copy(&data->db_insert);
 	}
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -760,6 +1010,16 @@ void	zbx_pb_history_close(zbx_pb_history_data_t *data)
 	{
 		zbx_list_item_t	*next = NULL;
 
+		if (ZBX_PB_MODE_FILE == pb_data->mode)
+		{
+			/* segment files are written without locking proxy buffer */
+			if (0 != data->rows_num)
+				pb_history_add_rows_file(pb_data, &data->rows, data->rows_num);
+
+			pb_lock();
+			goto out;
+		}
+
 		pb_lock();
 
 		if (0 == data->rows_num)
@@ -863,6 +1123,13 @@ int	zbx_pb_history_get_rows(struct zbx_json *j, zbx_uint64_t *lastid, int *more)
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() lastid:" ZBX_FS_UI64, __func__, *lastid);
 
+	if (ZBX_PB_MODE_FILE == get_pb_data()->mode)
+	{
+		pb_history_file_migrate_pending(get_pb_data());
+		ret = pb_history_get_file(j, lastid, more);
+		goto out;
+	}
+
 	pb_lock();
 
 	if (PB_MEMORY == (state = get_pb_src(get_pb_data()->state)))
@@ -872,6 +1139,7 @@ int	zbx_pb_history_get_rows(struct zbx_json *j, zbx_uint64_t *lastid, int *more)
 
 	if (PB_MEMORY != state)
 		ret = pb_history_get_db(j, lastid, more);
+out:
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() rows:%d", __func__, ret);
 
@@ -894,12 +1162,19 @@ void	zbx_pb_set_history_lastid(const zbx_uint64_t lastid)
 
 	pb_data->history_lastid_sent = lastid;
 
-	if (PB_MEMORY == (state = get_pb_src(pb_data->state)))
+	if (ZBX_PB_MODE_FILE == pb_data->mode)
+	{
+		pb_file_set_lastid(pb_data, lastid);
+		state = PB_MEMORY;
+	}
+	else if (PB_MEMORY == (state = get_pb_src(pb_data->state)))
 		pb_history_clear(pb_data, lastid);
 
 	pb_unlock();
 
-	if (PB_DATABASE == state)
+	if (ZBX_PB_MODE_FILE == pb_data->mode)
+		pb_file_update_index(pb_data);
+	else if (PB_DATABASE == state)
 		pb_history_set_lastid(lastid);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -15,6 +15,7 @@
 #include "proxybuffer.h"
 #include "pb_autoreg.h"
 #include "pb_discovery.h"
+#include "pb_file.h"
 #include "pb_history.h"
 #include "zbxalgo.h"
 #include "zbxcommon.h"
@@ -314,7 +315,20 @@ static void	pb_init_state(zbx_pb_t *pb)
 	discovery_ret = pb_check_unsent_rows("proxy_dhistory", "dhistory_lastid", &lastid, &maxid);
 	autoreg_ret = pb_check_unsent_rows("proxy_autoreg_host", "autoreg_host_lastid", &lastid, &maxid);
 
-	if (ZBX_PB_MODE_DISK == pb->mode)
+	if (ZBX_PB_MODE_FILE == pb->mode)
+	{
+		pb_file_lock(pb);
+		pb_file_recover(pb);
+
+		if (SUCCEED == history_ret)
+			pb_history_file_migrate(pb);
+
+		pb_file_unlock(pb);
+
+		/* only history is stored in files, discovery and auto registration data use database */
+		pb_set_state(pb, PB_DATABASE, "proxy buffer initialized in file mode");
+	}
+	else if (ZBX_PB_MODE_DISK == pb->mode)
 		pb_set_state(pb, PB_DATABASE, "proxy buffer initialized in disk mode");
 	else if (SUCCEED == history_ret || SUCCEED == discovery_ret || SUCCEED == autoreg_ret)
 		pb_set_state(pb, PB_DATABASE, "unsent database records found");
@@ -489,6 +503,13 @@ static void	pb_flush_lastids(zbx_pb_t *pb)
 
 static void	pb_flush(zbx_pb_t *pb)
 {
+	if (ZBX_PB_MODE_FILE == pb->mode)
+	{
+		pb_file_lock(pb);
+		pb_file_sync(pb);
+		pb_file_unlock(pb);
+		return;
+	}
 
 	if (ZBX_PB_MODE_MEMORY != pb->mode && (SUCCEED == pb_history_has_mem_rows(pb) ||
 			SUCCEED == pb_discovery_has_mem_rows(pb) || SUCCEED == pb_autoreg_has_mem_rows(pb)))
@@ -671,19 +692,21 @@ void	pb_wait_handles(const zbx_vector_uint64_t *handleids)
  *             size  - [IN] cache size in bytes                               *
  *             age   - [IN] maximum allowed data age                          *
  *             offline_buffer [IN] offline buffer in seconds                  *
+ *             file_dir - [IN] history segment file directory (file mode)     *
  *             error - [OUT] error message                                    *
  *                                                                            *
  * Return value: SUCCEED - proxy buffer was created successfully              *
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-int	zbx_pb_create(int mode, zbx_uint64_t size, int age, int offline_buffer, char **error)
+int	zbx_pb_create(int mode, zbx_uint64_t size, int age, int offline_buffer, const char *file_dir,
+		char **error)
 {
 	int	ret = FAIL, allow_oom;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() mode:%d", __func__, mode);
 
-	if (ZBX_PB_MODE_DISK == mode)
+	if (ZBX_PB_MODE_DISK == mode || ZBX_PB_MODE_FILE == mode)
 	{
 		/* allocate proxy buffer only to store statistics and track opened history handles */
 		size = ZBX_KIBIBYTE * 16;
@@ -718,6 +741,15 @@ int	zbx_pb_create(int mode, zbx_uint64_t size, int age, int offline_buffer, char
 	pb_data->max_age = age;
 	pb_data->offline_buffer = offline_buffer;
 
+	if (ZBX_PB_MODE_FILE == mode)
+	{
+		if (SUCCEED != zbx_mutex_create(&pb_data->file_mutex, ZBX_MUTEX_PROXY_BUFFER_FILE, error))
+			goto out;
+
+		if (SUCCEED != pb_file_init(file_dir, error))
+			goto out;
+	}
+
 	ret = SUCCEED;
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s(): %s", __func__, ZBX_NULL2EMPTY_STR(*error));
@@ -746,6 +778,12 @@ void	zbx_pb_init(void)
  ******************************************************************************/
 void	zbx_pb_destroy(void)
 {
+	if (ZBX_PB_MODE_FILE == pb_data->mode)
+	{
+		pb_file_destroy();
+		zbx_mutex_destroy(&pb_data->file_mutex);
+	}
+
 	zbx_mutex_destroy(&pb_data->mutex);
 	zbx_shmem_destroy(pb_mem);
 }
@@ -763,6 +801,8 @@ int	zbx_pb_parse_mode(const char *str, int *mode)
 		*mode = ZBX_PB_MODE_MEMORY;
 	else if (0 == strcmp(str, "hybrid"))
 		*mode = ZBX_PB_MODE_HYBRID;
+	else if (0 == strcmp(str, "file"))
+		*mode = ZBX_PB_MODE_FILE;
 	else
 		return FAIL;
 
@@ -816,7 +856,7 @@ void	zbx_pb_flush(void)
  ******************************************************************************/
 int	zbx_pb_get_mem_info(zbx_pb_mem_info_t *info, char **error)
 {
-	if (ZBX_PB_MODE_DISK == pb_data->mode)
+	if (ZBX_PB_MODE_DISK == pb_data->mode || ZBX_PB_MODE_FILE == pb_data->mode)
 	{
 		*error = zbx_strdup(NULL, "Proxy memory buffer is disabled.");
 		return FAIL;
@@ -839,7 +879,7 @@ int	zbx_pb_get_mem_info(zbx_pb_mem_info_t *info, char **error)
  ******************************************************************************/
 void	zbx_pb_get_state_info(zbx_pb_state_info_t *info)
 {
-	if (ZBX_PB_MODE_DISK == pb_data->mode)
+	if (ZBX_PB_MODE_DISK == pb_data->mode || ZBX_PB_MODE_FILE == pb_data->mode)
 	{
 		info->changes_num = 0;
 		info->state = 0;
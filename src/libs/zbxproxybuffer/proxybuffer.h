@@ -122,6 +122,17 @@ typedef struct
 
 	zbx_uint64_t		history_lastid_mem;
 
+	/* history segment file state, see pb_file.c */
+	zbx_mutex_t		file_mutex;
+	zbx_uint64_t		file_lastid;		/* id of the last record written to segment files */
+	zbx_uint64_t		file_segment;		/* the active segment, 0 if there are no segments */
+	zbx_uint64_t		file_segment_size;
+	int			file_sealed;		/* the active segment must not be written anymore */
+	int			file_db_pending;	/* history records were stored in database after */
+							/* failing to write them to segment files        */
+	zbx_uint64_t		file_read_segment;	/* position after the last record uploaded to server */
+	zbx_uint64_t		file_read_offset;
+
 	/* opened data handle tracking */
 	zbx_uint64_t		handleid;
 	zbx_vector_uint64_t	history_handleids;
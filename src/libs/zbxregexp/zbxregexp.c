@@ -25,6 +25,11 @@
 #define ZBX_REGEXP_NO_AUTO_CAPTURE PCRE_NO_AUTO_CAPTURE
 #endif
 #define ZBX_REGEXP_CASELESS PCRE_CASELESS
+#ifdef PCRE_STUDY_JIT_COMPILE
+#	define ZBX_REGEXP_STUDY_FLAGS	PCRE_STUDY_JIT_COMPILE
+#else
+#	define ZBX_REGEXP_STUDY_FLAGS	0
+#endif
 #endif
 
 #if !defined(HAVE_PCRE_H) && !defined(HAVE_PCRE2_H)
@@ -100,13 +105,17 @@ static char	*decode_pcre2_compile_error(int error_code, PCRE2_SIZE error_offset,
  *                      ZBX_REGEXP_MULTILINE.                                 *
  *     regexp    - [OUT] compiled regexp. Can be NULL if only regexp          *
  *                       compilation is checked, Cleanup in caller.           *
+ *     jit       - [IN] 1 - JIT compile the regexp (if supported). Only       *
+ *                           regexps reused for many matches are worth it,    *
+ *                           JIT compilation costs more than a single match.  *
+ *                      0 - interpret the regexp                              *
  *     err_msg   - [OUT] dynamically allocated error message. Can be NULL to  *
  *                       discard the error message.                           *
  *                                                                            *
  * Return value: SUCCEED or FAIL                                              *
  *                                                                            *
  ******************************************************************************/
-static int	regexp_compile(const char *pattern, int flags, zbx_regexp_t **regexp, char **err_msg)
+static int	regexp_compile(const char *pattern, int flags, zbx_regexp_t **regexp, int jit, char **err_msg)
 {
 #ifdef HAVE_PCRE_H
 	const char	*err_msg_static = NULL;
@@ -160,7 +169,8 @@ static int	regexp_compile(const char *pattern, int flags, zbx_regexp_t **regexp,
 	{
 		struct pcre_extra	*extra;
 
-		if (NULL == (extra = pcre_study(pcre_regexp, 0, &err_msg_static)) && NULL != err_msg_static)
+		if (NULL == (extra = pcre_study(pcre_regexp, 0 != jit ? ZBX_REGEXP_STUDY_FLAGS : 0,
+				&err_msg_static)) && NULL != err_msg_static)
 		{
 			if (NULL != err_msg)
 			{
@@ -192,6 +202,9 @@ static int	regexp_compile(const char *pattern, int flags, zbx_regexp_t **regexp,
 	if (NULL != regexp)
 	{
 		pcre2_match_context	*match_ctx;
+#ifdef PCRE2_JIT_COMPLETE
+		int			jit_err;
+#endif
 
 		if (NULL == (match_ctx = pcre2_match_context_create(NULL)))
 		{
@@ -200,6 +213,11 @@ static int	regexp_compile(const char *pattern, int flags, zbx_regexp_t **regexp,
 			return FAIL;
 		}
 
+#ifdef PCRE2_JIT_COMPLETE
+		/* JIT compilation failure is not an error - the interpreter is used for such patterns */
+		if (0 != jit && 0 != (jit_err = pcre2_jit_compile(pcre2_regexp, PCRE2_JIT_COMPLETE)))
+			zabbix_log(LOG_LEVEL_TRACE, "%s() cannot JIT compile regexp, error %d", __func__, jit_err);
+#endif
 		*regexp = (zbx_regexp_t *)zbx_malloc(NULL, sizeof(zbx_regexp_t));
 		(*regexp)->pcre2_regexp = pcre2_regexp;
 		(*regexp)->match_ctx = match_ctx;
@@ -230,9 +248,9 @@ static int	regexp_compile(const char *pattern, int flags, zbx_regexp_t **regexp,
 int	zbx_regexp_compile(const char *pattern, zbx_regexp_t **regexp, char **err_msg)
 {
 #ifdef ZBX_REGEXP_NO_AUTO_CAPTURE
-	return regexp_compile(pattern, ZBX_REGEXP_MULTILINE | ZBX_REGEXP_NO_AUTO_CAPTURE, regexp, err_msg);
+	return regexp_compile(pattern, ZBX_REGEXP_MULTILINE | ZBX_REGEXP_NO_AUTO_CAPTURE, regexp, 0, err_msg);
 #else
-	return regexp_compile(pattern, ZBX_REGEXP_MULTILINE, regexp, err_msg);
+	return regexp_compile(pattern, ZBX_REGEXP_MULTILINE, regexp, 0, err_msg);
 #endif
 }
 
@@ -254,46 +272,189 @@ int	zbx_regexp_compile(const char *pattern, zbx_regexp_t **regexp, char **err_ms
  ******************************************************************************/
 int	zbx_regexp_compile_ext(const char *pattern, zbx_regexp_t **regexp, int flags, char **err_msg)
 {
-	return regexp_compile(pattern, flags, regexp, err_msg);
+	return regexp_compile(pattern, flags, regexp, 0, err_msg);
+}
+
+#define ZBX_REGEXP_CACHE_SIZE	32	/* max number of compiled regexps cached per thread */
+
+typedef struct
+{
+	char		*pattern;
+	int		flags;
+	zbx_hash_t	hash;
+	zbx_uint64_t	lastaccess;
+	zbx_regexp_t	*regexp;
 }
+zbx_regexp_cache_entry_t;
+
+typedef struct
+{
+	zbx_regexp_cache_entry_t	entries[ZBX_REGEXP_CACHE_SIZE];
+	int				entries_num;
+	zbx_uint64_t			clock;
+	zbx_regexp_cache_stats_t	stats;
+}
+zbx_regexp_cache_t;
+
+static ZBX_THREAD_LOCAL zbx_regexp_cache_t	regexp_cache;
 
 /****************************************************************************************************
  *                                                                                                  *
- * Purpose: wrapper for zbx_regexp_compile. Caches and reuses the last used regexp.                 *
+ * Purpose: wrapper for zbx_regexp_compile. Caches and reuses recently used regexps.                *
+ *                                                                                                  *
+ * Comments: The compiled regexps are kept in a per-thread cache of ZBX_REGEXP_CACHE_SIZE entries   *
+ *           keyed by pattern and flags. When the cache is full the least recently used entry is    *
+ *           evicted. The returned regexp is owned by the cache and stays valid until the next call *
+ *           of this function by the same thread.                                                   *
  *                                                                                                  *
  ****************************************************************************************************/
 static int	regexp_prepare(const char *pattern, int flags, zbx_regexp_t **regexp, char **err_msg)
 {
-	static ZBX_THREAD_LOCAL zbx_regexp_t	*curr_regexp = NULL;
-	static ZBX_THREAD_LOCAL char		*curr_pattern = NULL;
-	static ZBX_THREAD_LOCAL int		curr_flags = 0;
-	int					ret = SUCCEED;
+	zbx_regexp_cache_entry_t	*entry, *lru = NULL;
+	zbx_hash_t			hash;
+	zbx_regexp_t			*compiled = NULL;
+
+	hash = ZBX_DEFAULT_STRING_HASH_FUNC(pattern);
+	hash = ZBX_DEFAULT_HASH_ALGO(&flags, sizeof(flags), hash);
 
-	if (NULL == curr_regexp || 0 != strcmp(curr_pattern, pattern) || curr_flags != flags)
+	regexp_cache.clock++;
+
+	for (int i = 0; i < regexp_cache.entries_num; i++)
 	{
-		if (NULL != curr_regexp)
+		entry = &regexp_cache.entries[i];
+
+		if (entry->hash == hash && entry->flags == flags && 0 == strcmp(entry->pattern, pattern))
 		{
-			zbx_regexp_free(curr_regexp);
-			zbx_free(curr_pattern);
+			entry->lastaccess = regexp_cache.clock;
+			regexp_cache.stats.hits++;
+			*regexp = entry->regexp;
+
+			return SUCCEED;
 		}
 
-		curr_regexp = NULL;
-		curr_pattern = NULL;
-		curr_flags = 0;
+		if (NULL == lru || entry->lastaccess < lru->lastaccess)
+			lru = entry;
+	}
 
-		if (SUCCEED == regexp_compile(pattern, flags, &curr_regexp, err_msg))
-		{
-			curr_pattern = zbx_strdup(curr_pattern, pattern);
-			curr_flags = flags;
-		}
-		else
-			ret = FAIL;
+	regexp_cache.stats.misses++;
+
+	if (SUCCEED != regexp_compile(pattern, flags, &compiled, 1, err_msg))
+	{
+		*regexp = NULL;
+		return FAIL;
 	}
 
-	*regexp = curr_regexp;
-	return ret;
+	if (ZBX_REGEXP_CACHE_SIZE > regexp_cache.entries_num)
+	{
+		entry = &regexp_cache.entries[regexp_cache.entries_num++];
+	}
+	else
+	{
+		entry = lru;
+		zbx_regexp_free(entry->regexp);
+		zbx_free(entry->pattern);
+		regexp_cache.stats.evictions++;
+	}
+
+	entry->pattern = zbx_strdup(NULL, pattern);
+	entry->flags = flags;
+	entry->hash = hash;
+	entry->lastaccess = regexp_cache.clock;
+	entry->regexp = compiled;
+
+	*regexp = compiled;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets compiled regular expression from the per-thread cache,       *
+ *          compiling it on cache miss                                        *
+ *                                                                            *
+ * Parameters:                                                                *
+ *     pattern   - [IN] regular expression as a text string                   *
+ *     regexp    - [OUT] compiled regular expression, owned by the cache      *
+ *     err_msg   - [OUT] error message if any                                 *
+ *                                                                            *
+ * Return value: SUCCEED or FAIL                                              *
+ *                                                                            *
+ * Comments: Compiled with the same flags as zbx_regexp_compile(). The        *
+ *           returned regexp must not be freed, it stays valid until the next *
+ *           cached compilation by the same thread.                           *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_regexp_compile_cached(const char *pattern, const zbx_regexp_t **regexp, char **err_msg)
+{
+#ifdef ZBX_REGEXP_NO_AUTO_CAPTURE
+	return zbx_regexp_compile_cached_ext(pattern, regexp, ZBX_REGEXP_MULTILINE | ZBX_REGEXP_NO_AUTO_CAPTURE,
+			err_msg);
+#else
+	return zbx_regexp_compile_cached_ext(pattern, regexp, ZBX_REGEXP_MULTILINE, err_msg);
+#endif
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets compiled regular expression with the specified compilation   *
+ *          parameters from the per-thread cache                              *
+ *                                                                            *
+ * Parameters:                                                                *
+ *     pattern   - [IN] regular expression as a text string                   *
+ *     regexp    - [OUT] compiled regular expression, owned by the cache      *
+ *     flags     - [IN] regexp compilation parameters, see                    *
+ *                      zbx_regexp_compile_ext()                              *
+ *     err_msg   - [OUT] error message if any                                 *
+ *                                                                            *
+ * Return value: SUCCEED or FAIL                                              *
+ *                                                                            *
+ * Comments: The returned regexp must not be freed, it stays valid until the  *
+ *           next cached compilation by the same thread.                      *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_regexp_compile_cached_ext(const char *pattern, const zbx_regexp_t **regexp, int flags, char **err_msg)
+{
+	zbx_regexp_t	*compiled;
+
+	if (SUCCEED != regexp_prepare(pattern, flags, &compiled, err_msg))
+		return FAIL;
+
+	*regexp = compiled;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets compiled regexp cache statistics of the calling thread       *
+ *                                                                            *
+ * Parameters: stats - [OUT] cache statistics                                 *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_regexp_cache_get_stats(zbx_regexp_cache_stats_t *stats)
+{
+	*stats = regexp_cache.stats;
+	stats->items_num = (zbx_uint64_t)regexp_cache.entries_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees compiled regexps cached by the calling thread               *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_regexp_cache_clear(void)
+{
+	for (int i = 0; i < regexp_cache.entries_num; i++)
+	{
+		zbx_regexp_free(regexp_cache.entries[i].regexp);
+		zbx_free(regexp_cache.entries[i].pattern);
+	}
+
+	regexp_cache.entries_num = 0;
+}
+
+#undef ZBX_REGEXP_CACHE_SIZE
+
 /* calculate recursion limit, PCRE man page suggests to reckon on about 500 bytes per recursion */
 /* but to be on the safe side - reckon on 800 bytes and do not set limit higher than 100000 */
 #define REGEXP_RECURSION_STEP	800
@@ -441,14 +602,27 @@ static int	regexp_exec(const char *string, const zbx_regexp_t *regexp, int flags
 #undef MATCHES_BUFF_SIZE
 #endif
 #ifdef HAVE_PCRE2_H
-	int			result, r, i;
-	pcre2_match_data	*match_data = NULL;
-	PCRE2_SIZE		*ovector = NULL;
+	int					result, r, i;
+	static ZBX_THREAD_LOCAL pcre2_match_data	*match_data_buff = NULL;
+	pcre2_match_data			*match_data = NULL;
+	PCRE2_SIZE				*ovector = NULL;
 
 	pcre2_set_match_limit(regexp->match_ctx, 1000000);
 
 	pcre2_set_recursion_limit(regexp->match_ctx, (uint32_t)compute_recursion_limit());
-	match_data = pcre2_match_data_create((uint32_t)count, NULL);
+
+	/* match data for the supported number of capture groups is allocated once per thread and reused */
+	if (ZBX_REGEXP_GROUPS_MAX < count)
+	{
+		match_data = pcre2_match_data_create((uint32_t)count, NULL);
+	}
+	else
+	{
+		if (NULL == match_data_buff)
+			match_data_buff = pcre2_match_data_create(ZBX_REGEXP_GROUPS_MAX, NULL);
+
+		match_data = match_data_buff;
+	}
 
 	if (NULL == match_data)
 	{
@@ -461,8 +635,17 @@ static int	regexp_exec(const char *string, const zbx_regexp_t *regexp, int flags
 		flags |= PCRE2_NO_UTF_CHECK;
 #endif
 
-		if (0 <= (r = pcre2_match(regexp->pcre2_regexp, (PCRE2_SPTR)string, PCRE2_ZERO_TERMINATED, 0, flags,
-			match_data, regexp->match_ctx)))
+		r = pcre2_match(regexp->pcre2_regexp, (PCRE2_SPTR)string, PCRE2_ZERO_TERMINATED, 0, flags, match_data,
+				regexp->match_ctx);
+#if defined(PCRE2_ERROR_JIT_STACKLIMIT) && defined(PCRE2_NO_JIT)
+		/* JIT uses a small fixed size stack, retry with interpreter which is bound by recursion limit */
+		if (PCRE2_ERROR_JIT_STACKLIMIT == r)
+		{
+			r = pcre2_match(regexp->pcre2_regexp, (PCRE2_SPTR)string, PCRE2_ZERO_TERMINATED, 0,
+					flags | PCRE2_NO_JIT, match_data, regexp->match_ctx);
+		}
+#endif
+		if (0 <= r)
 		{
 			if (NULL != matches)
 			{
@@ -492,7 +675,8 @@ static int	regexp_exec(const char *string, const zbx_regexp_t *regexp, int flags
 			result = FAIL;
 		}
 
-		pcre2_match_data_free(match_data);
+		if (match_data != match_data_buff)
+			pcre2_match_data_free(match_data);
 	}
 
 	return result;
@@ -1739,6 +1923,248 @@ void	zbx_regexp_escape(char **string)
 	*string = buffer;
 }
 
+/**********************************************************************************
+ *                                                                                *
+ * Purpose: finds end of character class in regular expression                    *
+ *                                                                                *
+ * Parameters: p - [IN] pointer to '[' starting the character class               *
+ *                                                                                *
+ * Return value: pointer to ']' ending the character class or NULL if class is    *
+ *               not terminated                                                   *
+ *                                                                                *
+ **********************************************************************************/
+static const char	*regexp_skip_class(const char *p)
+{
+	p++;
+
+	if ('^' == *p)
+		p++;
+
+	if (']' == *p)		/* ']' as the first character is a literal */
+		p++;
+
+	for (; '\0' != *p; p++)
+	{
+		if ('\\' == *p)
+		{
+			if ('\0' == *(++p))
+				return NULL;
+
+			continue;
+		}
+
+		/* POSIX class [:name:] or collating element, ends at the first ']' if not valid */
+		if ('[' == *p && (':' == p[1] || '.' == p[1] || '=' == p[1]))
+		{
+			const char	*q;
+
+			for (q = p + 2; '\0' != *q && ']' != *q; q++)
+			{
+				if (p[1] == *q && ']' == q[1])
+				{
+					p = q + 1;
+					break;
+				}
+			}
+
+			continue;
+		}
+
+		if (']' == *p)
+			return p;
+	}
+
+	return NULL;
+}
+
+/**********************************************************************************
+ *                                                                                *
+ * Purpose: finds end of escape sequence with letter or digit in regular          *
+ *          expression                                                            *
+ *                                                                                *
+ * Parameters: p - [IN] pointer to letter or digit following '\'                   *
+ *                                                                                *
+ * Return value: pointer to the last character of escape sequence or NULL if      *
+ *               sequence is not terminated                                       *
+ *                                                                                *
+ **********************************************************************************/
+static const char	*regexp_skip_escape(const char *p)
+{
+	const char	*end;
+	char		c = *p;
+
+	if (0 != isdigit((unsigned char)c))	/* back reference or octal character code */
+	{
+		while (0 != isdigit((unsigned char)p[1]))
+			p++;
+
+		return p;
+	}
+
+	switch (p[1])
+	{
+		case '{':
+			end = strchr(p + 2, '}');
+			break;
+		case '<':
+			end = ('g' == c || 'k' == c ? strchr(p + 2, '>') : p);
+			break;
+		case '\'':
+			end = ('g' == c || 'k' == c ? strchr(p + 2, '\'') : p);
+			break;
+		default:
+			end = p;
+	}
+
+	if (NULL == end)
+		return NULL;
+
+	if (end != p)
+		return end;
+
+	switch (c)
+	{
+		case 'c':	/* control character */
+		case 'p':	/* character property */
+		case 'P':
+			return '\0' != p[1] ? p + 1 : NULL;
+		case 'x':	/* hexadecimal character code */
+			for (int i = 0; i < 2 && 0 != isxdigit((unsigned char)p[1]); i++)
+				p++;
+			return p;
+		case 'g':	/* back reference by number */
+			if ('-' == p[1] || '+' == p[1])
+				p++;
+			while (0 != isdigit((unsigned char)p[1]))
+				p++;
+			return p;
+		default:
+			return p;
+	}
+}
+
+/**********************************************************************************
+ *                                                                                *
+ * Purpose: finds the longest literal string that is present in every string      *
+ *          matching case sensitive regular expression                            *
+ *                                                                                *
+ * Parameters: pattern - [IN] the regular expression                              *
+ *                                                                                *
+ * Return value: allocated literal string or NULL if there is no such string or   *
+ *               it cannot be determined                                          *
+ *                                                                                *
+ * Comments: The analysis is conservative. Only unquantified ASCII characters     *
+ *           outside of groups are collected. Patterns with top level             *
+ *           alternatives, option settings or quoted sequences are not analyzed.  *
+ *           Can be used to reject non-matching strings before running the        *
+ *           regular expression, the pattern itself must be valid.                *
+ *                                                                                *
+ **********************************************************************************/
+char	*zbx_regexp_get_literal(const char *pattern)
+{
+	const char	*p, *q;
+	char		*literal = NULL, *run = NULL;
+	size_t		run_alloc = 0, run_offset = 0, literal_len = 0;
+	int		depth = 0, is_literal;
+
+	for (p = pattern; '\0' != *p; p++)
+	{
+		is_literal = 0;
+
+		switch (*p)
+		{
+			case '\\':
+				if ('\0' == *(++p) || 'Q' == *p)
+					goto fail;
+
+				/* escaped punctuation is literal, other escapes are character types, anchors, */
+				/* references etc. */
+				if (0 != isalnum((unsigned char)*p))
+				{
+					if (NULL == (p = regexp_skip_escape(p)))
+						goto fail;
+				}
+				else if (0 == (0x80 & (unsigned char)*p))
+					is_literal = 1;
+				break;
+			case '[':
+				if (NULL == (p = regexp_skip_class(p)))
+					goto fail;
+				break;
+			case '(':
+				/* option settings like (?i) change meaning of the following characters */
+				if ('?' == p[1] && NULL == strchr(":=!<>|#", p[2]))
+					goto fail;
+
+				depth++;
+				break;
+			case ')':
+				if (0 > --depth)
+					goto fail;
+				break;
+			case '|':
+				if (0 == depth)
+					goto fail;
+				break;
+			case '{':
+				/* skip {n}, {n,} and {n,m} quantifiers, otherwise '{' is a literal */
+				for (q = p + 1; 0 != isdigit((unsigned char)*q) || ',' == *q || ' ' == *q; q++)
+					;
+
+				if ('}' == *q)
+					p = q;
+				ZBX_FALLTHROUGH;
+			case '*':
+			case '?':
+			case '+':
+				/* quantified character might be absent or be not contiguous with the rest */
+				if (0 != run_offset)
+					run_offset--;
+				break;
+			case '.':
+			case '^':
+			case '$':
+				break;
+			default:
+				if (0 == (0x80 & (unsigned char)*p))
+					is_literal = 1;
+		}
+
+		if (0 != is_literal && 0 == depth)
+		{
+			zbx_chrcpy_alloc(&run, &run_alloc, &run_offset, *p);
+			continue;
+		}
+
+		if (run_offset > literal_len)
+		{
+			literal_len = run_offset;
+			literal = (char *)zbx_realloc(literal, literal_len + 1);
+			memcpy(literal, run, literal_len);
+			literal[literal_len] = '\0';
+		}
+
+		run_offset = 0;
+	}
+
+	/* characters at the end of pattern are not quantified */
+	if (run_offset > literal_len)
+	{
+		literal = (char *)zbx_realloc(literal, run_offset + 1);
+		memcpy(literal, run, run_offset);
+		literal[run_offset] = '\0';
+	}
+
+	zbx_free(run);
+
+	return literal;
+fail:
+	zbx_free(run);
+	zbx_free(literal);
+
+	return NULL;
+}
+
 /**********************************************************************************
  *                                                                                *
  * Purpose: remove repeated wildcard characters from the expression               *
@@ -178,6 +178,13 @@ int	zbx_rtc_parse_options(const char *opt, zbx_uint32_t *code, struct zbx_json *
 		return rtc_parse_profiler_parameter(opt, ZBX_CONST_STRLEN(ZBX_PROF_DISABLE), j, error);
 	}
 
+	if (0 == strncmp(opt, ZBX_PROF_DUMP, ZBX_CONST_STRLEN(ZBX_PROF_DUMP)))
+	{
+		*code = ZBX_RTC_PROF_DUMP;
+
+		return rtc_parse_target_parameter(opt, ZBX_CONST_STRLEN(ZBX_PROF_DUMP), NULL, j, error);
+	}
+
 	if (0 == strcmp(opt, ZBX_CONFIG_CACHE_RELOAD))
 	{
 		*code = ZBX_RTC_CONFIG_CACHE_RELOAD;
@@ -456,6 +463,7 @@ int	zbx_rtc_async_exchange(char **data, zbx_uint32_t code, int config_timeout, c
 		case ZBX_RTC_LOG_LEVEL_INCREASE:
 		case ZBX_RTC_PROF_ENABLE:
 		case ZBX_RTC_PROF_DISABLE:
+		case ZBX_RTC_PROF_DUMP:
 			*error = zbx_dsprintf(NULL, "operation is not supported on the given operating system");
 			return FAIL;
 	}
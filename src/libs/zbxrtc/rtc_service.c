@@ -460,6 +460,7 @@ static void	rtc_process_request(zbx_rtc_t *rtc, zbx_uint32_t code, const unsigne
 			return;
 		case ZBX_RTC_PROF_ENABLE:
 		case ZBX_RTC_PROF_DISABLE:
+		case ZBX_RTC_PROF_DUMP:
 			rtc_process_profiler_option(code, (const char *)data, result);
 			return;
 #endif
@@ -103,13 +103,20 @@ static void	*__mem_malloc(zbx_shmem_info_t *info, zbx_uint64_t size);
 static void	*__mem_realloc(zbx_shmem_info_t *info, void *old, zbx_uint64_t size);
 static void	__mem_free(zbx_shmem_info_t *info, void *ptr);
 
+static void	*mem_malloc(zbx_shmem_info_t *info, zbx_uint64_t size);
+static void	*mem_realloc(zbx_shmem_info_t *info, void *old, zbx_uint64_t size);
+static void	mem_free(zbx_shmem_info_t *info, void *ptr);
+
 #define SHMEM_SIZE_FIELD	sizeof(zbx_uint64_t)
 
 #define SHMEM_FLG_USED		((__UINT64_C(1))<<63)
+#define SHMEM_FLG_SLAB		((__UINT64_C(1))<<62)
 
 #define FREE_CHUNK(ptr)		(((*(zbx_uint64_t *)(ptr)) & SHMEM_FLG_USED) == 0)
 #define CHUNK_SIZE(ptr)		((*(zbx_uint64_t *)(ptr)) & ~SHMEM_FLG_USED)
 
+#define SLAB_OBJECT(ptr)	(((*(zbx_uint64_t *)(ptr)) & SHMEM_FLG_SLAB) != 0)
+
 #define SHMEM_MIN_SIZE		__UINT64_C(128)
 #define SHMEM_MAX_SIZE		__UINT64_C(0x1000000000)	/* 64 GB */
 
@@ -519,6 +526,346 @@ static void	__mem_free(zbx_shmem_info_t *info, void *ptr)
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ *                          Small object slabs                                *
+ *                       ------------------------                             *
+ *                                                                            *
+ * Objects up to ZBX_SHMEM_SLAB_MAX_OBJECT bytes can be allocated from slabs  *
+ * instead of the heap. A slab is a SHMEM_SLAB_SIZE heap chunk split into     *
+ * objects of the same size class:                                            *
+ *                                                                            *
+ *   |--------|-- slab header --|--------|--- object ---|--------|-- ...      *
+ *     heap        shmem_slab_t   object                  object              *
+ *     chunk                      header                  header              *
+ *     size                                                                   *
+ *                                                                            *
+ * The object header has the same size as chunk size field so the user data  *
+ * is 8-aligned. It has SHMEM_FLG_SLAB bit set and keeps the offset from the  *
+ * slab header, which allows to find the slab when freeing object.           *
+ *                                                                            *
+ * Free objects of a slab are kept in a singly-linked list, stored in the     *
+ * object user data. Slabs having free objects are linked into their size     *
+ * class list. Slabs without used objects are returned to the heap, except    *
+ * one slab per size class which is kept to avoid slab allocation churn.      *
+ *                                                                            *
+ * Memory of free slab objects is accounted as free memory.                   *
+ *                                                                            *
+ ******************************************************************************/
+
+#define SHMEM_SLAB_SIZE		(32 * ZBX_KIBIBYTE)
+
+/* minimum memory size for slabs to be used, smaller memory would be wasted by partially used slabs */
+#define SHMEM_SLAB_MIN_SHMEM	((zbx_uint64_t)ZBX_SHMEM_SLAB_CLASS_COUNT * SHMEM_SLAB_SIZE * 4)
+
+typedef struct shmem_slab
+{
+	struct shmem_slab	*prev;
+	struct shmem_slab	*next;
+	void			*free_objects;
+	zbx_uint32_t		used_num;
+	zbx_uint32_t		class_index;
+}
+shmem_slab_t;
+
+typedef struct
+{
+	shmem_slab_t	*partial;
+	zbx_uint32_t	object_size;
+	zbx_uint32_t	objects_per_slab;
+	zbx_uint32_t	slabs_num;
+	zbx_uint32_t	empty_num;
+	zbx_uint32_t	used_num;
+}
+shmem_slab_class_t;
+
+#define SHMEM_SLAB_HEADER_SIZE	((sizeof(shmem_slab_t) + 7) & ~(size_t)7)
+
+static int	slab_class_by_size(zbx_uint64_t size)
+{
+	return (int)((mem_proper_alloc_size(size) - SHMEM_MIN_ALLOC) >> 3);
+}
+
+static void	slab_link(shmem_slab_class_t *slab_class, shmem_slab_t *slab)
+{
+	slab->prev = NULL;
+	slab->next = slab_class->partial;
+
+	if (NULL != slab_class->partial)
+		slab_class->partial->prev = slab;
+
+	slab_class->partial = slab;
+}
+
+static void	slab_unlink(shmem_slab_class_t *slab_class, shmem_slab_t *slab)
+{
+	if (NULL != slab->prev)
+		slab->prev->next = slab->next;
+	else
+		slab_class->partial = slab->next;
+
+	if (NULL != slab->next)
+		slab->next->prev = slab->prev;
+}
+
+static void	slab_classes_init(shmem_slab_class_t *slab_classes)
+{
+	for (int i = 0; i < ZBX_SHMEM_SLAB_CLASS_COUNT; i++)
+	{
+		slab_classes[i].partial = NULL;
+		slab_classes[i].object_size = SHMEM_MIN_ALLOC + 8 * i;
+		slab_classes[i].objects_per_slab = (zbx_uint32_t)((SHMEM_SLAB_SIZE - SHMEM_SLAB_HEADER_SIZE) /
+				(SHMEM_SIZE_FIELD + slab_classes[i].object_size));
+		slab_classes[i].slabs_num = 0;
+		slab_classes[i].empty_num = 0;
+		slab_classes[i].used_num = 0;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: allocates new slab from heap and splits it into free objects      *
+ *                                                                            *
+ ******************************************************************************/
+static shmem_slab_t	*slab_create(zbx_shmem_info_t *info, int class_index)
+{
+	shmem_slab_class_t	*slab_class = (shmem_slab_class_t *)info->slabs + class_index;
+	shmem_slab_t		*slab;
+	void			*chunk;
+	char			*object;
+	zbx_uint64_t		free_size;
+
+	if (NULL == (chunk = __mem_malloc(info, SHMEM_SLAB_SIZE)))
+		return NULL;
+
+	slab = (shmem_slab_t *)((char *)chunk + SHMEM_SIZE_FIELD);
+	slab->class_index = (zbx_uint32_t)class_index;
+	slab->used_num = 0;
+	slab->free_objects = NULL;
+
+	object = (char *)slab + SHMEM_SLAB_HEADER_SIZE;
+
+	for (zbx_uint32_t i = 0; i < slab_class->objects_per_slab; i++)
+	{
+		*(zbx_uint64_t *)object = SHMEM_FLG_SLAB | (zbx_uint64_t)(object - (char *)slab);
+		*(void **)(object + SHMEM_SIZE_FIELD) = slab->free_objects;
+		slab->free_objects = object;
+		object += SHMEM_SIZE_FIELD + slab_class->object_size;
+	}
+
+	free_size = (zbx_uint64_t)slab_class->objects_per_slab * slab_class->object_size;
+	info->used_size -= free_size;
+	info->free_size += free_size;
+
+	slab_class->slabs_num++;
+	slab_class->empty_num++;
+	slab_link(slab_class, slab);
+
+	return slab;
+}
+
+static void	slab_destroy(zbx_shmem_info_t *info, shmem_slab_t *slab)
+{
+	shmem_slab_class_t	*slab_class = (shmem_slab_class_t *)info->slabs + slab->class_index;
+	zbx_uint64_t		free_size;
+
+	slab_unlink(slab_class, slab);
+	slab_class->slabs_num--;
+	slab_class->empty_num--;
+
+	free_size = (zbx_uint64_t)slab_class->objects_per_slab * slab_class->object_size;
+	info->used_size += free_size;
+	info->free_size -= free_size;
+
+	__mem_free(info, slab);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: allocates object from size class slab                             *
+ *                                                                            *
+ * Return value: the object header (same as chunk for heap allocations) or    *
+ *               NULL if there was not enough memory for a new slab           *
+ *                                                                            *
+ ******************************************************************************/
+static void	*slab_malloc(zbx_shmem_info_t *info, zbx_uint64_t size)
+{
+	int			class_index = slab_class_by_size(size);
+	shmem_slab_class_t	*slab_class = (shmem_slab_class_t *)info->slabs + class_index;
+	shmem_slab_t		*slab;
+	char			*object;
+
+	if (NULL == (slab = slab_class->partial) && NULL == (slab = slab_create(info, class_index)))
+		return NULL;
+
+	object = (char *)slab->free_objects;
+	slab->free_objects = *(void **)(object + SHMEM_SIZE_FIELD);
+	*(zbx_uint64_t *)object |= SHMEM_FLG_USED;
+
+	if (0 == slab->used_num++)
+		slab_class->empty_num--;
+
+	if (NULL == slab->free_objects)
+		slab_unlink(slab_class, slab);
+
+	slab_class->used_num++;
+	info->used_size += slab_class->object_size;
+	info->free_size -= slab_class->object_size;
+
+	return object;
+}
+
+static void	slab_free(zbx_shmem_info_t *info, void *object)
+{
+	zbx_uint64_t		offset = *(zbx_uint64_t *)object & ~(SHMEM_FLG_USED | SHMEM_FLG_SLAB);
+	shmem_slab_t		*slab = (shmem_slab_t *)((char *)object - offset);
+	shmem_slab_class_t	*slab_class = (shmem_slab_class_t *)info->slabs + slab->class_index;
+
+	*(zbx_uint64_t *)object &= ~SHMEM_FLG_USED;
+
+	if (NULL == slab->free_objects)
+		slab_link(slab_class, slab);
+
+	*(void **)((char *)object + SHMEM_SIZE_FIELD) = slab->free_objects;
+	slab->free_objects = object;
+
+	slab_class->used_num--;
+	info->used_size -= slab_class->object_size;
+	info->free_size += slab_class->object_size;
+
+	if (0 == --slab->used_num)
+	{
+		/* keep one empty slab per class to avoid allocating and releasing slab on every object */
+		if (0 != slab_class->empty_num++)
+			slab_destroy(info, slab);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns all empty slabs to heap                                   *
+ *                                                                            *
+ * Return value: the number of released slabs                                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	slab_release_empty(zbx_shmem_info_t *info)
+{
+	int	released = 0;
+
+	for (int i = 0; i < ZBX_SHMEM_SLAB_CLASS_COUNT; i++)
+	{
+		shmem_slab_class_t	*slab_class = (shmem_slab_class_t *)info->slabs + i;
+		shmem_slab_t		*slab, *next;
+
+		for (slab = slab_class->partial; 0 != slab_class->empty_num && NULL != slab; slab = next)
+		{
+			next = slab->next;
+
+			if (0 == slab->used_num)
+			{
+				slab_destroy(info, slab);
+				released++;
+			}
+		}
+	}
+
+	return released;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: allocates memory from slab or heap depending on the size          *
+ *                                                                            *
+ * Return value: the chunk (or slab object) header                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	*mem_malloc(zbx_shmem_info_t *info, zbx_uint64_t size)
+{
+	void	*chunk;
+
+	if (NULL == info->slabs)
+		return __mem_malloc(info, size);
+
+	if (ZBX_SHMEM_SLAB_MAX_OBJECT >= size && NULL != (chunk = slab_malloc(info, size)))
+		return chunk;
+
+	if (NULL == (chunk = __mem_malloc(info, size)) && 0 != slab_release_empty(info))
+		chunk = __mem_malloc(info, size);
+
+	return chunk;
+}
+
+static void	*mem_realloc(zbx_shmem_info_t *info, void *old, zbx_uint64_t size)
+{
+	void			*object = (char *)old - SHMEM_SIZE_FIELD, *chunk;
+	shmem_slab_class_t	*slab_class;
+	zbx_uint64_t		offset;
+
+	if (!SLAB_OBJECT(object))
+	{
+		if (NULL == (chunk = __mem_realloc(info, old, size)) && NULL != info->slabs &&
+				0 != slab_release_empty(info))
+		{
+			chunk = __mem_realloc(info, old, size);
+		}
+
+		return chunk;
+	}
+
+	offset = *(zbx_uint64_t *)object & ~(SHMEM_FLG_USED | SHMEM_FLG_SLAB);
+	slab_class = (shmem_slab_class_t *)info->slabs + ((shmem_slab_t *)((char *)object - offset))->class_index;
+
+	if (ZBX_SHMEM_SLAB_MAX_OBJECT >= size && slab_class == (shmem_slab_class_t *)info->slabs +
+			slab_class_by_size(size))
+	{
+		return object;
+	}
+
+	if (NULL == (chunk = mem_malloc(info, size)))
+		return NULL;
+
+	memcpy((char *)chunk + SHMEM_SIZE_FIELD, old, MIN(size, slab_class->object_size));
+	slab_free(info, object);
+
+	return chunk;
+}
+
+static void	mem_free(zbx_shmem_info_t *info, void *ptr)
+{
+	void	*object = (char *)ptr - SHMEM_SIZE_FIELD;
+
+	if (SLAB_OBJECT(object))
+		slab_free(info, object);
+	else
+		__mem_free(info, ptr);
+}
+
+static void	slab_get_stats(const zbx_shmem_info_t *info, zbx_shmem_stats_t *stats)
+{
+	stats->slabs_num = 0;
+	stats->slab_size = 0;
+	stats->slab_free_size = 0;
+
+	if (0 == (stats->slabs_enabled = (NULL != info->slabs)))
+		return;
+
+	for (int i = 0; i < ZBX_SHMEM_SLAB_CLASS_COUNT; i++)
+	{
+		const shmem_slab_class_t	*slab_class = (const shmem_slab_class_t *)info->slabs + i;
+		zbx_shmem_slab_stats_t		*class_stats = &stats->slab_classes[i];
+
+		class_stats->object_size = slab_class->object_size;
+		class_stats->slabs_num = slab_class->slabs_num;
+		class_stats->used_objects = slab_class->used_num;
+		class_stats->free_objects = slab_class->slabs_num * slab_class->objects_per_slab -
+				slab_class->used_num;
+
+		stats->slabs_num += slab_class->slabs_num;
+		stats->slab_size += (zbx_uint64_t)slab_class->slabs_num * SHMEM_SLAB_SIZE;
+		stats->slab_free_size += (zbx_uint64_t)class_stats->free_objects * slab_class->object_size;
+	}
+}
+
 /* public memory interface */
 
 int	zbx_shmem_create(zbx_shmem_info_t **info, zbx_uint64_t size, const char *descr, const char *param,
@@ -592,6 +939,7 @@ int	zbx_shmem_create(zbx_shmem_info_t **info, zbx_uint64_t size, const char *des
 	base = (void *)((char *)base + strlen(param) + 1);
 
 	(*info)->allow_oom = allow_oom;
+	(*info)->slabs = NULL;
 
 	/* prepare shared memory for further allocation by creating one big chunk */
 	(*info)->lo_bound = ALIGN8(base);
@@ -661,6 +1009,42 @@ void	zbx_shmem_destroy(zbx_shmem_info_t *info)
 	(void)shmdt(info->base);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: enables allocation of small objects from size class slabs         *
+ *                                                                            *
+ * Parameters: info - [IN] shared memory                                      *
+ *                                                                            *
+ * Comments: Slabs reduce heap fragmentation caused by large number of small  *
+ *           objects of the same size being allocated and freed. Objects      *
+ *           allocated before slabs were enabled stay in the heap.            *
+ *           Slabs are not used for small memory sizes.                       *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_shmem_enable_slabs(zbx_shmem_info_t *info)
+{
+	void	*chunk;
+
+	if (NULL != info->slabs)
+		return;
+
+	if (SHMEM_SLAB_MIN_SHMEM > info->total_size)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "slab allocation is not used for %s: memory size is less than "
+				ZBX_FS_UI64 " bytes", info->mem_descr, SHMEM_SLAB_MIN_SHMEM);
+		return;
+	}
+
+	if (NULL == (chunk = __mem_malloc(info, sizeof(shmem_slab_class_t) * ZBX_SHMEM_SLAB_CLASS_COUNT)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot enable slab allocation for %s: out of memory", info->mem_descr);
+		return;
+	}
+
+	info->slabs = (char *)chunk + SHMEM_SIZE_FIELD;
+	slab_classes_init((shmem_slab_class_t *)info->slabs);
+}
+
 void	*__zbx_shmem_malloc(const char *file, int line, zbx_shmem_info_t *info, const void *old, size_t size)
 {
 	void	*chunk;
@@ -679,7 +1063,7 @@ void	*__zbx_shmem_malloc(const char *file, int line, zbx_shmem_info_t *info, con
 		exit(EXIT_FAILURE);
 	}
 
-	chunk = __mem_malloc(info, size);
+	chunk = mem_malloc(info, size);
 
 	if (NULL == chunk)
 	{
@@ -711,9 +1095,9 @@ void	*__zbx_shmem_realloc(const char *file, int line, zbx_shmem_info_t *info, vo
 	}
 
 	if (NULL == old)
-		chunk = __mem_malloc(info, size);
+		chunk = mem_malloc(info, size);
 	else
-		chunk = __mem_realloc(info, old, size);
+		chunk = mem_realloc(info, old, size);
 
 	if (NULL == chunk)
 	{
@@ -741,7 +1125,7 @@ void	__zbx_shmem_free(const char *file, int line, zbx_shmem_info_t *info, void *
 		exit(EXIT_FAILURE);
 	}
 
-	__mem_free(info, ptr);
+	mem_free(info, ptr);
 }
 
 void	zbx_shmem_clear(zbx_shmem_info_t *info)
@@ -759,6 +1143,12 @@ void	zbx_shmem_clear(zbx_shmem_info_t *info)
 	info->used_size = 0;
 	info->free_size = info->total_size;
 
+	if (NULL != info->slabs)
+	{
+		info->slabs = NULL;
+		zbx_shmem_enable_slabs(info);
+	}
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
@@ -766,7 +1156,7 @@ void	zbx_shmem_get_stats(const zbx_shmem_info_t *info, zbx_shmem_stats_t *stats)
 {
 	void		*chunk;
 	int		i;
-	zbx_uint64_t	counter;
+	zbx_uint64_t	counter, heap_free_size;
 
 	stats->free_chunks = 0;
 	stats->max_chunk_size = __UINT64_C(0);
@@ -796,6 +1186,21 @@ void	zbx_shmem_get_stats(const zbx_shmem_info_t *info, zbx_shmem_stats_t *stats)
 	stats->used_chunks = stats->overhead / (2 * SHMEM_SIZE_FIELD) + 1 - stats->free_chunks;
 	stats->free_size = info->free_size;
 	stats->used_size = info->used_size;
+
+	slab_get_stats(info, stats);
+
+	/* free slab objects are accounted as free memory, but can be used only by objects of the same size */
+	heap_free_size = stats->free_size - stats->slab_free_size;
+
+	if (0 != heap_free_size)
+		stats->heap_fragmentation = 100.0 * (double)(heap_free_size - stats->max_chunk_size) / heap_free_size;
+	else
+		stats->heap_fragmentation = 0;
+
+	if (0 != stats->slab_size)
+		stats->slab_fragmentation = 100.0 * (double)stats->slab_free_size / stats->slab_size;
+	else
+		stats->slab_fragmentation = 0;
 }
 
 void	zbx_shmem_dump_stats(int level, zbx_shmem_info_t *info)
@@ -828,6 +1233,26 @@ void	zbx_shmem_dump_stats(int level, zbx_shmem_info_t *info)
 			(unsigned long long)stats.used_size, (unsigned long long)stats.used_chunks);
 	zabbix_log(level, "of those, %10llu bytes are used by allocation overhead",
 			(unsigned long long)stats.overhead);
+	zabbix_log(level, "heap fragmentation: %.2f%%", stats.heap_fragmentation);
+
+	if (0 != stats.slabs_enabled)
+	{
+		for (i = 0; i < ZBX_SHMEM_SLAB_CLASS_COUNT; i++)
+		{
+			const zbx_shmem_slab_stats_t	*class_stats = &stats.slab_classes[i];
+
+			if (0 == class_stats->slabs_num)
+				continue;
+
+			zabbix_log(level, "slabs of %3llu byte objects: %6u used objects: %8u free objects: %8u",
+					(unsigned long long)class_stats->object_size, class_stats->slabs_num,
+					class_stats->used_objects, class_stats->free_objects);
+		}
+
+		zabbix_log(level, "%llu bytes are in %u slabs, of those %llu bytes are in free objects (%.2f%%)",
+				(unsigned long long)stats.slab_size, stats.slabs_num,
+				(unsigned long long)stats.slab_free_size, stats.slab_fragmentation);
+	}
 
 	zabbix_log(level, "================================");
 }
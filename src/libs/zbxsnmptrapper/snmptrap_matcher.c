@@ -0,0 +1,287 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "snmptrap_matcher.h"
+
+#include "zbxexpression.h"
+#include "zbxsysinfo.h"
+#include "zbxstr.h"
+#include "zbx_item_constants.h"
+
+/* compiled snmp trap items of an interface */
+struct zbx_snmptrap_matcher
+{
+	zbx_uint64_t	interfaceid;
+	zbx_uint64_t	revision;
+	time_t		lastaccess;
+	zbx_hashset_t	items;
+};
+
+static zbx_hashset_t	matchers;
+
+static void	snmptrap_item_clear(void *data)
+{
+	zbx_snmptrap_item_t	*trap_item = (zbx_snmptrap_item_t *)data;
+
+	if (NULL != trap_item->regexp)
+		zbx_regexp_free(trap_item->regexp);
+
+	zbx_regexp_clean_expressions(&trap_item->regexps);
+	zbx_vector_expression_destroy(&trap_item->regexps);
+
+	zbx_free(trap_item->regex);
+	zbx_free(trap_item->error);
+}
+
+static void	snmptrap_matcher_clear(void *data)
+{
+	zbx_snmptrap_matcher_t	*matcher = (zbx_snmptrap_matcher_t *)data;
+
+	zbx_hashset_destroy(&matcher->items);
+}
+
+void	snmptrap_matchers_init(void)
+{
+	zbx_hashset_create_ext(&matchers, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC,
+			snmptrap_matcher_clear, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+			ZBX_DEFAULT_MEM_FREE_FUNC);
+}
+
+void	snmptrap_matchers_destroy(void)
+{
+	zbx_hashset_destroy(&matchers);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes matchers of interfaces that have not received traps for   *
+ *          the specified time                                                *
+ *                                                                            *
+ * Parameters: now - [IN] the current time                                    *
+ *             ttl - [IN] the time to keep unused matchers                    *
+ *                                                                            *
+ * Comments: Matchers of removed interfaces are never accessed again.         *
+ *                                                                            *
+ ******************************************************************************/
+void	snmptrap_matchers_clean(time_t now, int ttl)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_snmptrap_matcher_t	*matcher;
+	int			removed_num = 0;
+
+	zbx_hashset_iter_reset(&matchers, &iter);
+	while (NULL != (matcher = (zbx_snmptrap_matcher_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (matcher->lastaccess + ttl > now)
+			continue;
+
+		zbx_hashset_iter_remove(&iter);
+		removed_num++;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() removed:%d matchers:%d", __func__, removed_num, matchers.num_data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets compiled matcher of the specified interface                  *
+ *                                                                            *
+ * Parameters: interfaceid - [IN]                                             *
+ *             revision    - [IN] revision of the interface host items and    *
+ *                                user macros                                 *
+ *             now         - [IN] the current time                            *
+ *                                                                            *
+ * Return value: The matcher, created if it did not exist.                    *
+ *                                                                            *
+ * Comments: Compiled items are dropped when the revision has changed and are *
+ *           compiled again on demand.                                        *
+ *                                                                            *
+ ******************************************************************************/
+zbx_snmptrap_matcher_t	*snmptrap_matcher_get(zbx_uint64_t interfaceid, zbx_uint64_t revision, time_t now)
+{
+	zbx_snmptrap_matcher_t	*matcher, matcher_local;
+
+	if (NULL == (matcher = (zbx_snmptrap_matcher_t *)zbx_hashset_search(&matchers, &interfaceid)))
+	{
+		matcher_local.interfaceid = interfaceid;
+		matcher_local.revision = revision;
+		matcher = (zbx_snmptrap_matcher_t *)zbx_hashset_insert(&matchers, &matcher_local,
+				sizeof(matcher_local));
+
+		zbx_hashset_create_ext(&matcher->items, 10, ZBX_DEFAULT_UINT64_HASH_FUNC,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC, snmptrap_item_clear, ZBX_DEFAULT_MEM_MALLOC_FUNC,
+				ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+	}
+	else if (matcher->revision != revision)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() interfaceid:" ZBX_FS_UI64 " revision:" ZBX_FS_UI64 "->"
+				ZBX_FS_UI64, __func__, interfaceid, matcher->revision, revision);
+
+		zbx_hashset_clear(&matcher->items);
+		matcher->revision = revision;
+	}
+
+	matcher->lastaccess = now;
+
+	return matcher;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: parses snmp trap item key, loads global regular expressions and   *
+ *          precompiles regular expression                                    *
+ *                                                                            *
+ * Parameters: trap_item - [IN/OUT] the compiled item                         *
+ *             key       - [IN] the item key with expanded macros             *
+ *                                                                            *
+ ******************************************************************************/
+static void	snmptrap_item_parse(zbx_snmptrap_item_t *trap_item, const char *key)
+{
+	char		*errmsg = NULL;
+	const char	*regex;
+	AGENT_REQUEST	request;
+
+	trap_item->type = SNMPTRAP_ITEM_SKIP;
+
+	if (0 == strcmp(key, "snmptrap.fallback"))
+	{
+		trap_item->type = SNMPTRAP_ITEM_FALLBACK;
+		return;
+	}
+
+	zbx_init_agent_request(&request);
+
+	if (SUCCEED != zbx_parse_item_key(key, &request))
+		goto out;
+
+	if (0 != strcmp(get_rkey(&request), "snmptrap"))
+		goto out;
+
+	if (1 < get_rparams_num(&request))
+		goto out;
+
+	if (NULL != (regex = get_rparam(&request, 0)) && '\0' != *regex)
+	{
+		trap_item->regex = zbx_strdup(NULL, regex);
+
+		if ('@' == *regex)
+		{
+			zbx_dc_get_expressions_by_name(&trap_item->regexps, regex + 1);
+
+			if (0 == trap_item->regexps.values_num)
+			{
+				trap_item->error = zbx_dsprintf(NULL,
+						"Global regular expression \"%s\" does not exist.", regex + 1);
+				trap_item->type = SNMPTRAP_ITEM_ERROR;
+				goto out;
+			}
+		}
+		else if (SUCCEED != zbx_regexp_compile(regex, &trap_item->regexp, &errmsg))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "cannot compile regular expression \"%s\": %s", regex, errmsg);
+			zbx_free(errmsg);
+
+			trap_item->error = zbx_dsprintf(NULL, "Invalid regular expression \"%s\".", regex);
+			trap_item->type = SNMPTRAP_ITEM_ERROR;
+			goto out;
+		}
+	}
+
+	trap_item->type = SNMPTRAP_ITEM_MATCH;
+out:
+	zbx_free_agent_request(&request);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: expands macros in snmp trap item key and compiles the item        *
+ *                                                                            *
+ * Parameters: trap_item - [IN/OUT] the compiled item                         *
+ *             item      - [IN] the item                                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	snmptrap_item_compile(zbx_snmptrap_item_t *trap_item, zbx_dc_item_t *item)
+{
+	char			*key, error[ZBX_ITEM_ERROR_LEN_MAX];
+	zbx_dc_um_handle_t	*um_handle;
+
+	um_handle = zbx_dc_open_user_macros();
+
+	key = zbx_strdup(NULL, item->key_orig);
+	if (SUCCEED != zbx_substitute_key_macros(&key, NULL, item, NULL, NULL, ZBX_MACRO_TYPE_ITEM_KEY, error,
+			sizeof(error)))
+	{
+		trap_item->error = zbx_strdup(NULL, error);
+		trap_item->type = SNMPTRAP_ITEM_ERROR;
+	}
+	else
+		snmptrap_item_parse(trap_item, key);
+
+	zbx_free(key);
+
+	zbx_dc_close_user_macros(um_handle);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets compiled snmp trap item                                      *
+ *                                                                            *
+ * Parameters: matcher - [IN] the interface matcher                           *
+ *             item    - [IN] the item                                        *
+ *                                                                            *
+ * Return value: The compiled item, compiled on first use.                    *
+ *                                                                            *
+ ******************************************************************************/
+const zbx_snmptrap_item_t	*snmptrap_matcher_get_item(zbx_snmptrap_matcher_t *matcher, zbx_dc_item_t *item)
+{
+	zbx_snmptrap_item_t	*trap_item, trap_item_local = {.itemid = item->itemid};
+
+	if (NULL != (trap_item = (zbx_snmptrap_item_t *)zbx_hashset_search(&matcher->items, &item->itemid)))
+		return trap_item;
+
+	trap_item = (zbx_snmptrap_item_t *)zbx_hashset_insert(&matcher->items, &trap_item_local,
+			sizeof(trap_item_local));
+	zbx_vector_expression_create(&trap_item->regexps);
+
+	snmptrap_item_compile(trap_item, item);
+
+	return trap_item;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: matches trap against compiled snmptrap[] item                     *
+ *                                                                            *
+ * Parameters: trap_item - [IN] the compiled item                             *
+ *             trap      - [IN] the trap                                      *
+ *                                                                            *
+ * Return value: ZBX_REGEXP_MATCH    - the trap matches                       *
+ *               ZBX_REGEXP_NO_MATCH - the trap does not match                *
+ *               FAIL                - invalid global regular expression      *
+ *                                                                            *
+ ******************************************************************************/
+int	snmptrap_item_match(const zbx_snmptrap_item_t *trap_item, const char *trap)
+{
+	if (NULL == trap_item->regex)
+		return ZBX_REGEXP_MATCH;
+
+	if (NULL != trap_item->regexp)
+	{
+		return 0 == zbx_regexp_match_precompiled(trap, trap_item->regexp) ? ZBX_REGEXP_MATCH :
+				ZBX_REGEXP_NO_MATCH;
+	}
+
+	/* global regular expressions are compiled on demand and kept in the per thread regexp cache */
+	return zbx_regexp_match_ex(&trap_item->regexps, trap, trap_item->regex, ZBX_CASE_SENSITIVE);
+}
@@ -0,0 +1,48 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#ifndef ZABBIX_SNMPTRAP_MATCHER_H
+#define ZABBIX_SNMPTRAP_MATCHER_H
+
+#include "zbxcacheconfig.h"
+#include "zbxregexp.h"
+
+#define SNMPTRAP_ITEM_SKIP	0	/* not a supported snmptrap item key, ignored */
+#define SNMPTRAP_ITEM_MATCH	1	/* snmptrap[<regex>] item */
+#define SNMPTRAP_ITEM_FALLBACK	2	/* snmptrap.fallback item */
+#define SNMPTRAP_ITEM_ERROR	3	/* item key or regular expression cannot be used */
+
+typedef struct
+{
+	zbx_uint64_t		itemid;
+	unsigned char		type;
+	char			*regex;		/* regular expression or global regular expression name */
+						/* prefixed with '@', NULL if any trap matches          */
+	zbx_regexp_t		*regexp;	/* precompiled regular expression */
+	zbx_vector_expression_t	regexps;	/* global regular expressions */
+	char			*error;
+}
+zbx_snmptrap_item_t;
+
+typedef struct zbx_snmptrap_matcher zbx_snmptrap_matcher_t;
+
+void	snmptrap_matchers_init(void);
+void	snmptrap_matchers_destroy(void);
+void	snmptrap_matchers_clean(time_t now, int ttl);
+
+zbx_snmptrap_matcher_t	*snmptrap_matcher_get(zbx_uint64_t interfaceid, zbx_uint64_t revision, time_t now);
+const zbx_snmptrap_item_t	*snmptrap_matcher_get_item(zbx_snmptrap_matcher_t *matcher, zbx_dc_item_t *item);
+int	snmptrap_item_match(const zbx_snmptrap_item_t *trap_item, const char *trap);
+
+#endif
@@ -33,6 +33,7 @@
 #include "zbxpreproc.h"
 #include "zbxcrypto.h"
 #include "zbxhash.h"
+#include "snmptrap_matcher.h"
 
 static int	trap_fd = -1;
 static off_t	trap_lastsize;
@@ -41,11 +42,77 @@ static char	*buffer = NULL;
 static int	offset = 0;
 static int	force = 0;
 
+/* traps are distributed between snmp trappers by source address, each trapper reads the whole */
+/* file and keeps track of its own file position and processed trap identifiers in database   */
+static int	worker_index = 0;
+static int	workers_num = 1;
+
+#define SNMP_VAR_NAME_LEN	64
+
+static const char	*snmp_var_names[] = {"snmp_lastsize", "snmp_timestamp", "snmp_id", "snmp_node"};
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets name of global variable of the current snmp trapper          *
+ *                                                                            *
+ * Parameters: name - [IN] the variable name                                  *
+ *                                                                            *
+ * Return value: The variable name with process number suffix, variables of   *
+ *               the first trapper have no suffix.                            *
+ *                                                                            *
+ * Comments: The returned value is valid until the next call.                 *
+ *                                                                            *
+ ******************************************************************************/
+static const char	*snmp_var_name(const char *name)
+{
+	static char	buffer[SNMP_VAR_NAME_LEN];
+
+	if (0 == worker_index)
+		return name;
+
+	zbx_snprintf(buffer, sizeof(buffer), "%s_%d", name, worker_index + 1);
+
+	return buffer;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: parses global variable name of other than the first snmp trapper  *
+ *                                                                            *
+ * Parameters: name        - [IN] the variable name                           *
+ *             process_num - [OUT] the snmp trapper process number            *
+ *                                                                            *
+ * Return value: Index of the variable in snmp_var_names or FAIL if the name  *
+ *               is not a suffixed snmp trapper variable.                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	snmp_var_parse(const char *name, int *process_num)
+{
+	const char	*ptr;
+
+	if (NULL == (ptr = strrchr(name, '_')) || SUCCEED != zbx_is_uint31(ptr + 1, process_num) ||
+			2 > *process_num)
+	{
+		return FAIL;
+	}
+
+	for (int i = 0; i < (int)ARRSIZE(snmp_var_names); i++)
+	{
+		if (strlen(snmp_var_names[i]) == (size_t)(ptr - name) && 0 == strncmp(name, snmp_var_names[i],
+				(size_t)(ptr - name)))
+		{
+			return i;
+		}
+	}
+
+	return FAIL;
+}
+
 static void	db_update_lastsize(void)
 {
 	zbx_db_begin();
-	zbx_db_execute("update globalvars set value=" ZBX_FS_I64 " where name='snmp_lastsize'",
-			(zbx_int64_t)trap_lastsize);
+	zbx_db_execute("update globalvars set value=" ZBX_FS_I64 " where name='%s'", (zbx_int64_t)trap_lastsize,
+			snmp_var_name("snmp_lastsize"));
 	zbx_db_commit();
 }
 
@@ -59,90 +126,64 @@ static void	db_update_lastsize(void)
  ******************************************************************************/
 static int	process_trap_for_interface(zbx_uint64_t interfaceid, char *trap, zbx_timespec_t *ts)
 {
-	zbx_dc_item_t		*items = NULL;
-	const char		*regex;
-	char			error[ZBX_ITEM_ERROR_LEN_MAX];
-	int			ret = FAIL, fb = -1, value_type, regexp_ret;
-	AGENT_REQUEST		request;
-	zbx_vector_expression_t	regexps;
-	zbx_dc_um_handle_t	*um_handle;
-
-	zbx_vector_expression_create(&regexps);
+	zbx_dc_item_t			*items = NULL;
+	const zbx_snmptrap_item_t	*trap_item;
+	zbx_snmptrap_matcher_t		*matcher;
+	zbx_uint64_t			revision;
+	int				ret = FAIL, fb = -1, value_type, regexp_ret;
+	size_t				num;
+
+	if (0 == (num = zbx_dc_config_get_snmp_items_by_interfaceid(interfaceid, &items, &revision)))
+	{
+		zbx_free(items);
+		return FAIL;
+	}
 
-	um_handle = zbx_dc_open_user_macros();
+	matcher = snmptrap_matcher_get(interfaceid, revision, (time_t)ts->sec);
 
-	size_t			num = zbx_dc_config_get_snmp_items_by_interfaceid(interfaceid, &items);
-	zbx_uint64_t		*itemids = (zbx_uint64_t *)zbx_malloc(NULL, sizeof(zbx_uint64_t) * num);
-	int			*lastclocks = (int *)zbx_malloc(NULL, sizeof(int) * num),
-				*errcodes = (int *)zbx_malloc(NULL, sizeof(int) * num);
-	AGENT_RESULT		*results = (AGENT_RESULT *)zbx_malloc(NULL, sizeof(AGENT_RESULT) * num);
+	zbx_uint64_t	*itemids = (zbx_uint64_t *)zbx_malloc(NULL, sizeof(zbx_uint64_t) * num);
+	int		*lastclocks = (int *)zbx_malloc(NULL, sizeof(int) * num),
+			*errcodes = (int *)zbx_malloc(NULL, sizeof(int) * num);
+	AGENT_RESULT	*results = (AGENT_RESULT *)zbx_malloc(NULL, sizeof(AGENT_RESULT) * num);
 
 	for (size_t i = 0; i < num; i++)
 	{
 		zbx_init_agent_result(&results[i]);
 		errcodes[i] = FAIL;
 
-		items[i].key = zbx_strdup(items[i].key, items[i].key_orig);
-		if (SUCCEED != zbx_substitute_key_macros(&items[i].key, NULL, &items[i], NULL, NULL,
-				ZBX_MACRO_TYPE_ITEM_KEY, error, sizeof(error)))
+		trap_item = snmptrap_matcher_get_item(matcher, &items[i]);
+
+		switch (trap_item->type)
 		{
-			SET_MSG_RESULT(&results[i], zbx_strdup(NULL, error));
-			errcodes[i] = NOTSUPPORTED;
-			continue;
+			case SNMPTRAP_ITEM_MATCH:
+				break;
+			case SNMPTRAP_ITEM_FALLBACK:
+				fb = i;
+				continue;
+			case SNMPTRAP_ITEM_ERROR:
+				SET_MSG_RESULT(&results[i], zbx_strdup(NULL, trap_item->error));
+				errcodes[i] = NOTSUPPORTED;
+				continue;
+			default:
+				continue;
 		}
 
-		if (0 == strcmp(items[i].key, "snmptrap.fallback"))
+		if (ZBX_REGEXP_NO_MATCH == (regexp_ret = snmptrap_item_match(trap_item, trap)))
 		{
-			fb = i;
 			continue;
 		}
-
-		zbx_init_agent_request(&request);
-
-		if (SUCCEED != zbx_parse_item_key(items[i].key, &request))
-			goto next;
-
-		if (0 != strcmp(get_rkey(&request), "snmptrap"))
-			goto next;
-
-		if (1 < get_rparams_num(&request))
-			goto next;
-
-		if (NULL != (regex = get_rparam(&request, 0)))
+		else if (FAIL == regexp_ret)
 		{
-			if ('@' == *regex)
-			{
-				zbx_dc_get_expressions_by_name(&regexps, regex + 1);
-
-				if (0 == regexps.values_num)
-				{
-					SET_MSG_RESULT(&results[i], zbx_dsprintf(NULL,
-							"Global regular expression \"%s\" does not exist.", regex + 1));
-					errcodes[i] = NOTSUPPORTED;
-					goto next;
-				}
-			}
-
-			if (ZBX_REGEXP_NO_MATCH == (regexp_ret = zbx_regexp_match_ex(&regexps, trap, regex,
-					ZBX_CASE_SENSITIVE)))
-			{
-				goto next;
-			}
-			else if (FAIL == regexp_ret)
-			{
-				SET_MSG_RESULT(&results[i], zbx_dsprintf(NULL,
-						"Invalid regular expression \"%s\".", regex));
-				errcodes[i] = NOTSUPPORTED;
-				goto next;
-			}
+			SET_MSG_RESULT(&results[i], zbx_dsprintf(NULL, "Invalid regular expression \"%s\".",
+					trap_item->regex));
+			errcodes[i] = NOTSUPPORTED;
+			continue;
 		}
 
 		value_type = (ITEM_VALUE_TYPE_LOG == items[i].value_type ? ITEM_VALUE_TYPE_LOG : ITEM_VALUE_TYPE_TEXT);
 		zbx_set_agent_result_type(&results[i], value_type, trap);
 		errcodes[i] = SUCCEED;
 		ret = SUCCEED;
-next:
-		zbx_free_agent_request(&request);
 	}
 
 	if (FAIL == ret && -1 != fb)
@@ -181,7 +222,6 @@ next:
 				break;
 		}
 
-		zbx_free(items[i].key);
 		zbx_free_agent_result(&results[i]);
 	}
 
@@ -196,11 +236,6 @@ next:
 	zbx_dc_config_clean_items(items, NULL, num);
 	zbx_free(items);
 
-	zbx_dc_close_user_macros(um_handle);
-
-	zbx_regexp_clean_expressions(&regexps);
-	zbx_vector_expression_destroy(&regexps);
-
 	zbx_preprocessor_flush();
 
 	return ret;
@@ -222,6 +257,9 @@ static void	process_trap(const char *addr, char *begin, char *end)
 	int		ret = FAIL;
 	char		*trap = NULL;
 
+	if (1 < workers_num && (int)(zbx_default_string_hash_func(addr) % (zbx_hash_t)workers_num) != worker_index)
+		return;
+
 	zbx_timespec(&ts);
 
 	trap = zbx_dsprintf(trap, "%s%s", begin, end);
@@ -315,9 +353,10 @@ static void	db_update_snmp_id(const char *date, const char *trap)
 
 	sql_offset = 0;
 	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
-			"update globalvars set value=%d where name='snmp_timestamp';\n", (int)timestamp);
+			"update globalvars set value=%d where name='%s';\n", (int)timestamp,
+			snmp_var_name("snmp_timestamp"));
 	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
-			"update globalvars set value='%s' where name='snmp_id';\n", hash_hex);
+			"update globalvars set value='%s' where name='%s';\n", hash_hex, snmp_var_name("snmp_id"));
 	zbx_db_execute("%s", sql);
 	zbx_free(sql);
 
@@ -626,6 +665,145 @@ static void	read_all_traps(const char *config_snmptrap_file, int snmp_timestamp,
 		parse_traps(1, snmp_timestamp, snmp_id_bin, skip, config_node_name);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes global variables of snmp trappers that are not started    *
+ *          and initializes variables of new snmp trappers with the values of *
+ *          the first trapper                                                 *
+ *                                                                            *
+ * Parameters: snmp_node      - [IN] the first trapper node name, can be NULL *
+ *             snmp_timestamp - [IN] the first trapper last trap timestamp    *
+ *             snmp_id        - [IN] the first trapper last trap identifier,  *
+ *                                   NULL if not used                         *
+ *                                                                            *
+ * Comments: Called by the first trapper within transaction before it starts  *
+ *           processing traps, so that new trappers resume from the same      *
+ *           position. Other trappers wait until their variables exist.       *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_init_workers_vars(const char *snmp_node, int snmp_timestamp, const char *snmp_id)
+{
+	zbx_db_result_t		result;
+	zbx_db_row_t		row;
+	zbx_vector_str_t	names;
+	unsigned char		*initialized;
+	char			*sql = NULL, name[SNMP_VAR_NAME_LEN];
+	size_t			sql_alloc = 0, sql_offset = 0;
+	int			process_num, var, i, inserts_num = 0;
+	zbx_db_insert_t		db_insert;
+
+	zbx_vector_str_create(&names);
+	initialized = (unsigned char *)zbx_calloc(NULL, (size_t)workers_num + 1, sizeof(unsigned char));
+
+	result = zbx_db_select("select name from globalvars where name like 'snmp%%'");
+
+	while (NULL != (row = zbx_db_fetch(result)))
+	{
+		if (FAIL == (var = snmp_var_parse(row[0], &process_num)))
+			continue;
+
+		zbx_vector_str_append(&names, zbx_strdup(NULL, row[0]));
+
+		if (process_num <= workers_num && 0 == var)
+			initialized[process_num] = 1;
+	}
+	zbx_db_free_result(result);
+
+	/* variables of trappers that are not started or have no position are removed */
+	for (i = 0; i < names.values_num; i++)
+	{
+		(void)snmp_var_parse(names.values[i], &process_num);
+
+		if (process_num <= workers_num && 0 != initialized[process_num])
+		{
+			zbx_free(names.values[i]);
+			zbx_vector_str_remove_noorder(&names, i--);
+		}
+	}
+
+	if (0 != names.values_num)
+	{
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "delete from globalvars where");
+		zbx_db_add_str_condition_alloc(&sql, &sql_alloc, &sql_offset, "name",
+				(const char * const *)names.values, names.values_num);
+		zbx_db_execute("%s", sql);
+		zbx_free(sql);
+	}
+
+	zbx_db_insert_prepare(&db_insert, "globalvars", "name", "value", (char *)NULL);
+
+	for (process_num = 2; process_num <= workers_num; process_num++)
+	{
+		char	value[MAX_ID_LEN + 1];
+
+		if (0 != initialized[process_num])
+			continue;
+
+		zbx_snprintf(name, sizeof(name), "%s_%d", snmp_var_names[0], process_num);
+		zbx_snprintf(value, sizeof(value), ZBX_FS_I64, (zbx_int64_t)trap_lastsize);
+		zbx_db_insert_add_values(&db_insert, name, value);
+
+		if (NULL != snmp_id)
+		{
+			zbx_snprintf(name, sizeof(name), "%s_%d", snmp_var_names[1], process_num);
+			zbx_snprintf(value, sizeof(value), "%d", snmp_timestamp);
+			zbx_db_insert_add_values(&db_insert, name, value);
+
+			zbx_snprintf(name, sizeof(name), "%s_%d", snmp_var_names[2], process_num);
+			zbx_db_insert_add_values(&db_insert, name, snmp_id);
+		}
+
+		if (NULL != snmp_node)
+		{
+			zbx_snprintf(name, sizeof(name), "%s_%d", snmp_var_names[3], process_num);
+			zbx_db_insert_add_values(&db_insert, name, snmp_node);
+		}
+
+		inserts_num++;
+	}
+
+	if (0 != inserts_num)
+		zbx_db_insert_execute(&db_insert);
+
+	zbx_db_insert_clean(&db_insert);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() removed:%d initialized:%d", __func__, names.values_num, inserts_num);
+
+	zbx_free(initialized);
+	zbx_vector_str_clear_ext(&names, zbx_str_free);
+	zbx_vector_str_destroy(&names);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: waits until the first trapper initializes global variables of the *
+ *          current snmp trapper                                              *
+ *                                                                            *
+ * Return value: SUCCEED - the variables were initialized                     *
+ *               FAIL    - the process is being stopped                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	db_wait_worker_vars(void)
+{
+	zbx_db_result_t	result;
+	int		found;
+
+	while (ZBX_IS_RUNNING())
+	{
+		result = zbx_db_select("select value from globalvars where name='%s'",
+				snmp_var_name("snmp_lastsize"));
+		found = (NULL != zbx_db_fetch(result));
+		zbx_db_free_result(result);
+
+		if (0 != found)
+			return SUCCEED;
+
+		zbx_sleep(1);
+	}
+
+	return FAIL;
+}
+
 static void	DBget_lastsize(const char *config_node_name, const char *config_snmptrap_file)
 {
 	zbx_db_result_t	result;
@@ -633,48 +811,62 @@ static void	DBget_lastsize(const char *config_node_name, const char *config_snmp
 	int		snmp_timestamp = 0;
 	char		*snmp_id = NULL, *snmp_node = NULL;
 
-	zbx_db_begin();
+	if (0 != worker_index && SUCCEED != db_wait_worker_vars())
+		return;
 
-	result = zbx_db_select("select value from globalvars where name='snmp_lastsize'");
-	if (NULL == (row = zbx_db_fetch(result)))
-	{
-		zbx_db_execute("insert into globalvars (name,value) values ('snmp_lastsize','0')");
-		trap_lastsize = 0;
-	}
-	else
-		ZBX_STR2UINT64(trap_lastsize, row[0]);
-	zbx_db_free_result(result);
+	zbx_db_begin();
 
 	if (NULL == config_node_name)
 	{
-		zbx_db_execute("delete from globalvars where name in ('snmp_node','snmp_timestamp','snmp_id')");
+		for (int i = 1; i < (int)ARRSIZE(snmp_var_names); i++)
+			zbx_db_execute("delete from globalvars where name='%s'", snmp_var_name(snmp_var_names[i]));
 	}
 	else
 	{
-		result = zbx_db_select("select value from globalvars where name='snmp_node'");
+		result = zbx_db_select("select value from globalvars where name='%s'", snmp_var_name("snmp_node"));
 		if (NULL != (row = zbx_db_fetch(result)))
 			snmp_node = zbx_strdup(NULL, row[0]);
 		zbx_db_free_result(result);
 
-		result = zbx_db_select("select value from globalvars where name='snmp_timestamp'");
+		result = zbx_db_select("select value from globalvars where name='%s'",
+				snmp_var_name("snmp_timestamp"));
 		if (NULL == (row = zbx_db_fetch(result)))
 		{
-			zbx_db_execute("insert into globalvars (name,value) values ('snmp_timestamp','0')");
+			zbx_db_execute("insert into globalvars (name,value) values ('%s','0')",
+					snmp_var_name("snmp_timestamp"));
 		}
 		else
 			snmp_timestamp = atoi(row[0]);
 		zbx_db_free_result(result);
 
-		result = zbx_db_select("select value from globalvars where name='snmp_id'");
+		result = zbx_db_select("select value from globalvars where name='%s'", snmp_var_name("snmp_id"));
 		if (NULL == (row = zbx_db_fetch(result)))
 		{
-			zbx_db_execute("insert into globalvars (name,value) values ('snmp_id','')");
+			zbx_db_execute("insert into globalvars (name,value) values ('%s','')",
+					snmp_var_name("snmp_id"));
 		}
 		else
 			snmp_id = zbx_strdup(NULL, row[0]);
 		zbx_db_free_result(result);
 	}
 
+	result = zbx_db_select("select value from globalvars where name='%s'", snmp_var_name("snmp_lastsize"));
+	if (NULL == (row = zbx_db_fetch(result)))
+	{
+		zbx_db_execute("insert into globalvars (name,value) values ('%s','0')",
+				snmp_var_name("snmp_lastsize"));
+		trap_lastsize = 0;
+	}
+	else
+		ZBX_STR2UINT64(trap_lastsize, row[0]);
+	zbx_db_free_result(result);
+
+	if (0 == worker_index)
+	{
+		db_init_workers_vars(snmp_node, snmp_timestamp,
+				NULL != config_node_name ? ZBX_NULL2EMPTY_STR(snmp_id) : NULL);
+	}
+
 	zbx_db_commit();
 
 	if (NULL != config_node_name)
@@ -738,7 +930,7 @@ static void	DBget_lastsize(const char *config_node_name, const char *config_snmp
 				zbx_db_insert_t	db_insert;
 
 				zbx_db_insert_prepare(&db_insert, "globalvars", "name", "value", (char *)NULL);
-				zbx_db_insert_add_values(&db_insert, "snmp_node", config_node_name);
+				zbx_db_insert_add_values(&db_insert, snmp_var_name("snmp_node"), config_node_name);
 				zbx_db_insert_execute(&db_insert);
 				zbx_db_insert_clean(&db_insert);
 			}
@@ -747,8 +939,8 @@ static void	DBget_lastsize(const char *config_node_name, const char *config_snmp
 				char	*config_node_name_esc;
 
 				config_node_name_esc = zbx_db_dyn_escape_string(config_node_name);
-				zbx_db_execute("update globalvars set value='%s' where name='snmp_node'",
-						config_node_name_esc);
+				zbx_db_execute("update globalvars set value='%s' where name='%s'",
+						config_node_name_esc, snmp_var_name("snmp_node"));
 				zbx_free(config_node_name_esc);
 			}
 
@@ -836,6 +1028,7 @@ static int	get_latest_data(const char *config_snmptrap_file, const char *config_
 ZBX_THREAD_ENTRY(zbx_snmptrapper_thread, args)
 {
 	double			sec;
+	time_t			matchers_cleantime = 0;
 	const zbx_thread_info_t	*info = &((zbx_thread_args_t *)args)->info;
 	int			server_num = ((zbx_thread_args_t *)args)->info.server_num,
 				process_num = ((zbx_thread_args_t *)args)->info.process_num;
@@ -847,6 +1040,9 @@ ZBX_THREAD_ENTRY(zbx_snmptrapper_thread, args)
 	if (NULL != snmptrapper_args_in->config_ha_node_name && '\0' == *snmptrapper_args_in->config_ha_node_name)
 		snmptrapper_args_in->config_ha_node_name = NULL;
 
+	worker_index = process_num - 1;
+	workers_num = MAX(snmptrapper_args_in->workers_num, 1);
+
 	zabbix_log(LOG_LEVEL_INFORMATION, "%s #%d started [%s #%d]", get_program_type_string(info->program_type),
 			server_num, get_process_type_string(process_type), process_num);
 
@@ -857,9 +1053,18 @@ ZBX_THREAD_ENTRY(zbx_snmptrapper_thread, args)
 
 	zbx_db_connect(ZBX_DB_CONNECT_NORMAL);
 
+	if (0 != worker_index)
+	{
+		zbx_setproctitle("%s #%d [waiting for %s #1 to initialize trap file position]",
+				get_process_type_string(process_type), process_num,
+				get_process_type_string(process_type));
+	}
+
 	buffer = (char *)zbx_malloc(buffer, MAX_BUFFER_LEN);
 	*buffer = '\0';
 
+	snmptrap_matchers_init();
+
 	DBget_lastsize(snmptrapper_args_in->config_ha_node_name, snmptrapper_args_in->config_snmptrap_file);
 
 	while (ZBX_IS_RUNNING())
@@ -867,6 +1072,13 @@ ZBX_THREAD_ENTRY(zbx_snmptrapper_thread, args)
 		sec = zbx_time();
 		zbx_update_env(get_process_type_string(process_type), sec);
 
+		/* matchers of removed interfaces and interfaces without recent traps are dropped */
+		if (matchers_cleantime + SEC_PER_HOUR <= (time_t)sec)
+		{
+			snmptrap_matchers_clean((time_t)sec, SEC_PER_HOUR);
+			matchers_cleantime = (time_t)sec;
+		}
+
 		zbx_setproctitle("%s [processing data]", get_process_type_string(process_type));
 
 		while (ZBX_IS_RUNNING() && FAIL == zbx_vps_monitor_capped())
@@ -891,6 +1103,8 @@ ZBX_THREAD_ENTRY(zbx_snmptrapper_thread, args)
 
 	zbx_free(buffer);
 
+	snmptrap_matchers_destroy();
+
 	if (-1 != trap_fd)
 		close(trap_fd);
 
@@ -30,6 +30,7 @@
 #include "zbxstr.h"
 #include "zbxlog.h"
 #include "zbxself.h"
+#include "zbxprof.h"
 #include "zbxnix.h"
 #include "zbxcommshigh.h"
 #include "zbxpoller.h"
@@ -1135,6 +1136,53 @@ static int	comms_parse_response(char *xml, char *host, size_t host_len, char *ke
 	return ret;
 }
 
+/* Request processing latency is collected by profiler separately for each request type. Profiles are */
+/* identified by the address of their name, so the names must be static.                             */
+#define TRAPPER_REQUEST_PROF(request)	{request, "trapper request \"" request "\""}
+
+static const struct
+{
+	const char	*request;
+	const char	*prof_name;
+}
+trapper_request_profs[] = {
+	TRAPPER_REQUEST_PROF(ZBX_PROTO_VALUE_AGENT_DATA),
+	TRAPPER_REQUEST_PROF(ZBX_PROTO_VALUE_SENDER_DATA),
+	TRAPPER_REQUEST_PROF(ZBX_PROTO_VALUE_PROXY_HEARTBEAT),
+	TRAPPER_REQUEST_PROF(ZBX_PROTO_VALUE_GET_ACTIVE_CHECKS),
+	TRAPPER_REQUEST_PROF(ZBX_PROTO_VALUE_COMMAND),
+	TRAPPER_REQUEST_PROF(ZBX_PROTO_VALUE_GET_QUEUE),
+	TRAPPER_REQUEST_PROF(ZBX_PROTO_VALUE_GET_STATUS),
+	TRAPPER_REQUEST_PROF(ZBX_PROTO_VALUE_ZABBIX_STATS),
+	TRAPPER_REQUEST_PROF(ZBX_PROTO_VALUE_EXPRESSIONS_EVALUATE),
+	TRAPPER_REQUEST_PROF(ZBX_PROTO_VALUE_ZABBIX_ITEM_TEST),
+	TRAPPER_REQUEST_PROF(ZBX_PROTO_VALUE_ACTIVE_CHECK_HEARTBEAT),
+	TRAPPER_REQUEST_PROF(ZBX_PROTO_VALUE_PROXY_CONFIG),
+	TRAPPER_REQUEST_PROF(ZBX_PROTO_VALUE_PROXY_DATA),
+	TRAPPER_REQUEST_PROF(ZBX_PROTO_VALUE_PROXY_TASKS),
+	TRAPPER_REQUEST_PROF(ZBX_PROTO_VALUE_ZABBIX_ALERT_SEND),
+	TRAPPER_REQUEST_PROF(ZBX_PROTO_VALUE_REPORT_TEST),
+	TRAPPER_REQUEST_PROF(ZBX_PROTO_VALUE_HISTORY_PUSH),
+	TRAPPER_REQUEST_PROF("ZBX_GET_ACTIVE_CHECKS"),
+	TRAPPER_REQUEST_PROF("sender data (XML or plain text)"),
+	TRAPPER_REQUEST_PROF("unknown")
+};
+
+#undef TRAPPER_REQUEST_PROF
+
+static const char	*trapper_request_prof_name(const char *request)
+{
+	size_t	i;
+
+	for (i = 0; i < ARRSIZE(trapper_request_profs) - 1; i++)
+	{
+		if (0 == strcmp(trapper_request_profs[i].request, request))
+			break;
+	}
+
+	return trapper_request_profs[i].prof_name;
+}
+
 static int	process_trap(zbx_socket_t *sock, char *s, ssize_t bytes_received, zbx_timespec_t *ts,
 		const zbx_config_comms_args_t *config_comms, const zbx_config_vault_t *config_vault,
 		int config_startup_time, const zbx_events_funcs_t *events_cbs, int proxydata_frequency,
@@ -1175,6 +1223,8 @@ static int	process_trap(zbx_socket_t *sock, char *s, ssize_t bytes_received, zbx
 			return FAIL;
 		}
 
+		zbx_prof_start(trapper_request_prof_name(value), ZBX_PROF_PROCESSING);
+
 		if (0 == strcmp(value, ZBX_PROTO_VALUE_AGENT_DATA))
 		{
 			recv_agenthistory(sock, &jp, ts, config_comms->config_timeout);
@@ -1243,11 +1293,15 @@ static int	process_trap(zbx_socket_t *sock, char *s, ssize_t bytes_received, zbx
 			zabbix_log(LOG_LEVEL_WARNING, "unknown request received from \"%s\": [%s]", sock->peer,
 				value);
 		}
+
+		zbx_prof_end();
 	}
 	else if (0 == strncmp(s, "ZBX_GET_ACTIVE_CHECKS", 21))	/* request for list of active checks */
 	{
+		zbx_prof_start(trapper_request_prof_name("ZBX_GET_ACTIVE_CHECKS"), ZBX_PROF_PROCESSING);
 		ret = send_list_of_active_checks(sock, s, events_cbs, config_comms->config_timeout,
 				autoreg_update_host_cb);
+		zbx_prof_end();
 	}
 	else
 	{
@@ -1318,36 +1372,136 @@ static int	process_trap(zbx_socket_t *sock, char *s, ssize_t bytes_received, zbx
 		if (0 == strcmp(av.value, ZBX_NOTSUPPORTED))
 			av.state = ITEM_STATE_NOTSUPPORTED;
 
+		zbx_prof_start(trapper_request_prof_name("sender data (XML or plain text)"), ZBX_PROF_PROCESSING);
+
 		zbx_dc_config_history_recv_get_items_by_keys(&item, &hk, &errcode, 1);
 		zbx_process_history_data(&item, &av, &errcode, 1, NULL);
 
 		if (SUCCEED != zbx_tcp_send_ext(sock, "OK", ZBX_CONST_STRLEN("OK"), 0, 0, config_comms->config_timeout))
 			zabbix_log(LOG_LEVEL_WARNING, "Error sending result back");
+
+		zbx_prof_end();
 	}
 
 	return ret;
 }
 
-static void	process_trapper_child(zbx_socket_t *sock, zbx_timespec_t *ts,
-		const zbx_config_comms_args_t *config_comms, const zbx_config_vault_t *config_vault,
-		int config_startup_time, const zbx_events_funcs_t *events_cbs, int proxydata_frequency,
-		zbx_get_config_forks_f get_config_forks, const char *config_stats_allowed_ip, const char *progname,
-		const char *config_java_gateway, int config_java_gateway_port, const char *config_externalscripts,
-		int config_enable_global_scripts, zbx_get_value_internal_ext_f zbx_get_value_internal_ext_cb,
-		const char *config_ssh_key_location, const char *config_webdriver_url,
-		zbx_trapper_process_request_func_t trapper_process_request_cb,
-		zbx_autoreg_update_host_func_t autoreg_update_host_cb)
+/* Maximum number of connections a trapper receives data from concurrently. It is not configurable because   */
+/* memory of the connections is limited by ZBX_TRAPPER_BUFFERS_SIZE_MAX and requests are processed one by    */
+/* one, so the limit only bounds the sockets polled and scanned in each loop iteration. Connections over the */
+/* limit wait in the listen backlog for other trappers, so StartTrappers still scales the total number of    */
+/* concurrent connections (32 per trapper) without letting a single trapper hoard ready requests.            */
+#define ZBX_TRAPPER_CONNECTIONS_MAX	32
+
+/* Trapper stops reading new requests and accepting connections while dynamic receive buffers of its */
+/* connections exceed this size, so memory is bounded by it plus a single largest request.          */
+#define ZBX_TRAPPER_BUFFERS_SIZE_MAX	(64 * ZBX_MEBIBYTE)
+
+#define ZBX_TRAPPER_CONN_HANDSHAKE	0
+#define ZBX_TRAPPER_CONN_RECV		1
+#define ZBX_TRAPPER_CONN_READY		2
+
+typedef struct
+{
+	zbx_socket_t		s;
+	zbx_tcp_recv_context_t	context;
+	zbx_timespec_t		ts;
+	double			deadline;
+	short			events;
+	unsigned char		state;
+}
+zbx_trapper_conn_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: continues TLS handshake or request receiving on connection        *
+ *                                                                            *
+ * Parameters: conn        - [IN] the connection                              *
+ *             args        - [IN] trapper arguments                           *
+ *                                                                            *
+ * Return value: SUCCEED - the connection must be polled again or the         *
+ *                         request is ready for processing                    *
+ *               FAIL    - the connection must be closed                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	trapper_conn_io(zbx_trapper_conn_t *conn, const zbx_thread_trapper_args *args)
+{
+	if (ZBX_TRAPPER_CONN_HANDSHAKE == conn->state)
+	{
+		/* Trapper has to accept all types of connections it can accept with the specified          */
+		/* configuration. Only after receiving data it is known who has sent them and one can decide */
+		/* to accept or discard the data.                                                            */
+		if (SUCCEED != zbx_tcp_accept_handshake(&conn->s, ZBX_TCP_SEC_TLS_CERT | ZBX_TCP_SEC_TLS_PSK |
+				ZBX_TCP_SEC_UNENCRYPTED, &conn->events))
+		{
+			if (0 != conn->events)
+				return SUCCEED;
+
+			zabbix_log(LOG_LEVEL_WARNING, "failed to accept an incoming connection: %s",
+					zbx_socket_strerror());
+			return FAIL;
+		}
+
+		zbx_tcp_recv_context_init(&conn->s, &conn->context, ZBX_TCP_LARGE);
+		conn->deadline = zbx_time() + args->config_comms->config_trapper_timeout;
+		conn->state = ZBX_TRAPPER_CONN_RECV;
+	}
+
+	if (FAIL == zbx_tcp_recv_context(&conn->s, &conn->context, ZBX_TCP_LARGE, &conn->events))
+	{
+		if (0 != conn->events)
+			return SUCCEED;
+
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot receive data from %s: %s", conn->s.peer, zbx_socket_strerror());
+
+		return FAIL;
+	}
+
+	conn->state = ZBX_TRAPPER_CONN_READY;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: processes received request                                        *
+ *                                                                            *
+ * Parameters: conn  - [IN] the connection                                    *
+ *             args  - [IN] trapper arguments                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	trapper_conn_process(zbx_trapper_conn_t *conn, const zbx_thread_trapper_args *args)
+{
+	process_trap(&conn->s, conn->s.buffer, (ssize_t)(conn->s.read_bytes + conn->context.offset), &conn->ts,
+			args->config_comms, args->config_vault, args->config_startup_time, args->events_cbs,
+			args->proxydata_frequency, args->get_process_forks_cb_arg, args->config_stats_allowed_ip,
+			args->progname, args->config_java_gateway, args->config_java_gateway_port,
+			args->config_externalscripts, args->config_enable_global_scripts,
+			args->zbx_get_value_internal_ext_cb, args->config_ssh_key_location, args->config_webdriver_url,
+			args->trapper_process_request_func_cb, args->autoreg_update_host_cb);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns size of dynamic receive buffer of connection              *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	trapper_conn_buffer_size(const zbx_trapper_conn_t *conn)
 {
-	ssize_t	bytes_received;
+	if (ZBX_BUF_TYPE_DYN != conn->s.buf_type)
+		return 0;
 
-	if (FAIL == (bytes_received = zbx_tcp_recv_ext(sock, config_comms->config_trapper_timeout, ZBX_TCP_LARGE)))
-		return;
+	/* compressed messages are decompressed into buffer of uncompressed size */
+	return (size_t)MAX(conn->context.expected_len, conn->context.reserved) + 1;
+}
 
-	process_trap(sock, sock->buffer, bytes_received, ts, config_comms, config_vault, config_startup_time,
-			events_cbs, proxydata_frequency, get_config_forks, config_stats_allowed_ip, progname,
-			config_java_gateway, config_java_gateway_port, config_externalscripts,
-			config_enable_global_scripts, zbx_get_value_internal_ext_cb, config_ssh_key_location,
-			config_webdriver_url, trapper_process_request_cb, autoreg_update_host_cb);
+static void	trapper_conn_free(zbx_trapper_conn_t *conn)
+{
+	if (ZBX_TRAPPER_CONN_HANDSHAKE != conn->state)
+		zbx_tcp_recv_context_clear(&conn->context);
+
+	zbx_tcp_unaccept(&conn->s);
+	zbx_free(conn);
 }
 
 ZBX_THREAD_ENTRY(zbx_trapper_thread, args)
@@ -1355,12 +1509,16 @@ ZBX_THREAD_ENTRY(zbx_trapper_thread, args)
 #define POLL_TIMEOUT	1
 	zbx_thread_trapper_args	*trapper_args_in = (zbx_thread_trapper_args *)
 					(((zbx_thread_args_t *)args)->args);
-	double			sec = 0.0;
+	double			sec = 0.0, time_now;
 	zbx_socket_t		s;
 	const zbx_thread_info_t	*info = &((zbx_thread_args_t *)args)->info;
-	int			ret, server_num = ((zbx_thread_args_t *)args)->info.server_num,
+	int			i, conns_num = 0, pds_num, listen_num, ready,
+				server_num = ((zbx_thread_args_t *)args)->info.server_num,
 				process_num = ((zbx_thread_args_t *)args)->info.process_num;
 	unsigned char		process_type = ((zbx_thread_args_t *)args)->info.process_type;
+	size_t			buffers_size;
+	zbx_trapper_conn_t	*conns[ZBX_TRAPPER_CONNECTIONS_MAX];
+	zbx_pollfd_t		*pds;
 #ifdef HAVE_NETSNMP
 	zbx_uint32_t		rtc_msgs[] = {ZBX_RTC_SNMP_CACHE_RELOAD};
 	zbx_ipc_async_socket_t	rtc;
@@ -1388,6 +1546,9 @@ ZBX_THREAD_ENTRY(zbx_trapper_thread, args)
 			trapper_args_in->config_comms->config_timeout, &rtc);
 #endif
 
+	pds = (zbx_pollfd_t *)zbx_malloc(NULL, sizeof(zbx_pollfd_t) * (size_t)(s.num_socks +
+			ZBX_TRAPPER_CONNECTIONS_MAX));
+
 	while (ZBX_IS_RUNNING())
 	{
 #ifdef HAVE_NETSNMP
@@ -1395,78 +1556,181 @@ ZBX_THREAD_ENTRY(zbx_trapper_thread, args)
 		unsigned char	*rtc_data;
 		int		snmp_reload = 0;
 #endif
+		zbx_trapper_conn_t	*conn;
+
+		zbx_prof_update(get_process_type_string(process_type), zbx_time());
 
 		zbx_setproctitle("%s #%d [processed data in " ZBX_FS_DBL " sec, waiting for connection%s]",
 				get_process_type_string(process_type), process_num, sec, zbx_vps_monitor_status());
 
 		zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_IDLE);
 
-		/* Trapper has to accept all types of connections it can accept with the specified configuration. */
-		/* Only after receiving data it is known who has sent them and one can decide to accept or discard */
-		/* the data. */
-		ret = zbx_tcp_accept(&s, ZBX_TCP_SEC_TLS_CERT | ZBX_TCP_SEC_TLS_PSK | ZBX_TCP_SEC_UNENCRYPTED,
-				POLL_TIMEOUT);
-		zbx_update_env(get_process_type_string(process_type), zbx_time());
+		/* Wait for new connections and for data on connections that have not sent the whole request */
+		/* yet, so that slow clients do not block the trapper for the duration of data transfer.      */
+		for (i = 0, ready = -1, buffers_size = 0; i < conns_num; i++)
+		{
+			buffers_size += trapper_conn_buffer_size(conns[i]);
 
-		if (TIMEOUT_ERROR == ret)
-			continue;
+			if (ZBX_TRAPPER_CONN_READY == conns[i]->state && (-1 == ready ||
+					0 > zbx_timespec_compare(&conns[i]->ts, &conns[ready]->ts)))
+			{
+				ready = i;
+			}
+		}
 
-		if (SUCCEED == ret)
+		pds_num = 0;
+
+		/* while received requests are waiting for processing new connections are left to idle trappers */
+		if (ZBX_TRAPPER_CONNECTIONS_MAX > conns_num && ZBX_TRAPPER_BUFFERS_SIZE_MAX > buffers_size &&
+				-1 == ready)
 		{
-			zbx_timespec_t	ts;
+			for (i = 0; i < s.num_socks; i++)
+			{
+				pds[pds_num].fd = s.sockets[i];
+				pds[pds_num].events = POLLIN;
+				pds[pds_num++].revents = 0;
+			}
+		}
 
-			/* get connection timestamp */
-			zbx_timespec(&ts);
+		listen_num = pds_num;
 
-			zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_BUSY);
+		for (i = 0; i < conns_num; i++)
+		{
+			conn = conns[i];
 
-			zbx_setproctitle("%s #%d [processing data]", get_process_type_string(process_type),
-					process_num);
+			/* connections that would allocate receive buffers wait until memory is released */
+			if (ZBX_TRAPPER_CONN_READY == conn->state || (ZBX_TRAPPER_CONN_RECV == conn->state &&
+					ZBX_BUF_TYPE_DYN != conn->s.buf_type &&
+					ZBX_TRAPPER_BUFFERS_SIZE_MAX <= buffers_size))
+			{
+				pds[pds_num].fd = -1;
+				pds[pds_num].events = 0;
+			}
+			else
+			{
+				pds[pds_num].fd = conn->s.socket;
+				pds[pds_num].events = conn->events;
+			}
 
-#ifdef HAVE_NETSNMP
-			while (SUCCEED == zbx_rtc_wait(&rtc, info, &rtc_cmd, &rtc_data, 0) && 0 != rtc_cmd)
+			pds[pds_num++].revents = 0;
+		}
+
+		if (ZBX_PROTO_ERROR == zbx_socket_poll(pds, (unsigned long)pds_num, -1 == ready ? POLL_TIMEOUT * 1000 :
+				0) && SUCCEED != zbx_socket_had_nonblocking_error())
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "failed to wait for incoming connections: %s",
+					zbx_strerror_from_system(zbx_socket_last_error()));
+			zbx_sleep(POLL_TIMEOUT);
+		}
+
+		time_now = zbx_time();
+		zbx_update_env(get_process_type_string(process_type), time_now);
+
+		for (i = 0; i < listen_num; i++)
+		{
+			if (0 != (pds[i].revents & POLLIN))
+				break;
+		}
+
+		if (i != listen_num)
+		{
+			int	ret;
+
+			if (SUCCEED == (ret = zbx_tcp_accept_socket(&s, 0)))
 			{
-				if (ZBX_RTC_SNMP_CACHE_RELOAD == rtc_cmd && 0 == snmp_reload)
-				{
-					zbx_clear_cache_snmp(process_type, process_num);
-					snmp_reload = 1;
-				}
-				else if (ZBX_RTC_SHUTDOWN == rtc_cmd)
-				{
-					zbx_tcp_unaccept(&s);
-					goto out;
-				}
+				conn = (zbx_trapper_conn_t *)zbx_malloc(NULL, sizeof(zbx_trapper_conn_t));
+				zbx_tcp_accept_detach(&s, &conn->s);
+
+				/* get connection timestamp */
+				zbx_timespec(&conn->ts);
+
+				/* TLS handshake is bounded by Timeout, receiving request by TrapperTimeout */
+				conn->deadline = time_now + trapper_args_in->config_comms->config_timeout;
+				conn->state = ZBX_TRAPPER_CONN_HANDSHAKE;
+				conn->events = POLLIN;
+
+				/* the first data is usually already available when the connection is accepted */
+				pds[pds_num].fd = conn->s.socket;
+				pds[pds_num].events = POLLIN;
+				pds[pds_num++].revents = POLLIN;
+				conns[conns_num++] = conn;
+			}
+			else if (TIMEOUT_ERROR != ret)
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "failed to accept an incoming connection: %s",
+						zbx_socket_strerror());
+			}
+		}
+
+		for (i = conns_num - 1; 0 <= i; i--)
+		{
+			conn = conns[i];
+
+			if (ZBX_TRAPPER_CONN_READY == conn->state)
+				continue;
 
+			if (0 == pds[listen_num + i].revents)
+			{
+				if (time_now < conn->deadline)
+					continue;
+
+				zabbix_log(LOG_LEVEL_DEBUG, "cannot receive data from %s: read timeout", conn->s.peer);
 			}
-#endif
-			sec = zbx_time();
-			process_trapper_child(&s, &ts, trapper_args_in->config_comms, trapper_args_in->config_vault,
-					trapper_args_in->config_startup_time, trapper_args_in->events_cbs,
-					trapper_args_in->proxydata_frequency,
-					trapper_args_in->get_process_forks_cb_arg,
-					trapper_args_in->config_stats_allowed_ip, trapper_args_in->progname,
-					trapper_args_in->config_java_gateway,
-					trapper_args_in->config_java_gateway_port,
-					trapper_args_in->config_externalscripts,
-					trapper_args_in->config_enable_global_scripts,
-					trapper_args_in->zbx_get_value_internal_ext_cb,
-					trapper_args_in->config_ssh_key_location,
-					trapper_args_in->config_webdriver_url,
-					trapper_args_in->trapper_process_request_func_cb,
-					trapper_args_in->autoreg_update_host_cb);
-			sec = zbx_time() - sec;
-
-			zbx_tcp_unaccept(&s);
+			else if (SUCCEED == trapper_conn_io(conn, trapper_args_in))
+				continue;
+
+			if (ready == conns_num - 1)
+				ready = i;
+
+			trapper_conn_free(conn);
+			conns[i] = conns[--conns_num];
+			pds[listen_num + i] = pds[listen_num + conns_num];
 		}
-		else
+
+		/* Process one request at a time, so that connections with requests being received are polled */
+		/* between processing of received requests.                                                    */
+		if (-1 == ready)
+			continue;
+
+		conn = conns[ready];
+
+		zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_BUSY);
+
+		zbx_setproctitle("%s #%d [processing data]", get_process_type_string(process_type), process_num);
+#ifdef HAVE_NETSNMP
+		while (SUCCEED == zbx_rtc_wait(&rtc, info, &rtc_cmd, &rtc_data, 0) && 0 != rtc_cmd)
 		{
-			zabbix_log(LOG_LEVEL_WARNING, "failed to accept an incoming connection: %s",
-					zbx_socket_strerror());
+			if (ZBX_RTC_SNMP_CACHE_RELOAD == rtc_cmd && 0 == snmp_reload)
+			{
+				zbx_clear_cache_snmp(process_type, process_num);
+				snmp_reload = 1;
+			}
+			else if (ZBX_RTC_SHUTDOWN == rtc_cmd)
+				goto out;
+		}
+#endif
+		sec = zbx_time();
+		trapper_conn_process(conn, trapper_args_in);
+		sec = zbx_time() - sec;
+
+		trapper_conn_free(conn);
+		conns[ready] = conns[--conns_num];
+
+		/* time spent processing the request does not count against the other connections */
+		for (i = 0; i < conns_num; i++)
+		{
+			if (ZBX_TRAPPER_CONN_READY != conns[i]->state)
+				conns[i]->deadline += sec;
 		}
 	}
 #ifdef HAVE_NETSNMP
 out:
 #endif
+	for (i = 0; i < conns_num; i++)
+		trapper_conn_free(conns[i]);
+
+	zbx_free(pds);
+
 	zbx_setproctitle("%s #%d [terminated]", get_process_type_string(process_type), process_num);
 
 	while (1)
@@ -3009,6 +3009,7 @@ int	zbx_vmware_get_statistics(zbx_vmware_stats_t *stats)
 
 	stats->memory_total = vmware_shmem_get_vmware_mem()->total_size;
 	stats->memory_used = vmware_shmem_get_vmware_mem()->total_size - vmware_shmem_get_vmware_mem()->free_size;
+	stats->perf = vmware->perf_stats;
 
 	zbx_vmware_unlock();
 
@@ -25,8 +25,11 @@
 #include "zbxnum.h"
 #include "zbxstr.h"
 #include "zbxxml.h"
+#include "zbxtime.h"
+#include "zbxcurl.h"
 #ifdef HAVE_LIBXML2
 #	include <libxml/xpath.h>
+#	include <libxml/parser.h>
 #endif
 
 ZBX_VECTOR_IMPL(uint16, uint16_t)
@@ -663,148 +666,423 @@ void	vmware_service_update_perf_entities(zbx_vmware_service_t *service)
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() entities:%d", __func__, service->entities.num_data);
 }
 
+/* QueryPerf response element currently read as text */
+#define ZBX_PERF_TEXT_NONE		0
+#define ZBX_PERF_TEXT_ENTITY		1
+#define ZBX_PERF_TEXT_VALUE		2
+#define ZBX_PERF_TEXT_COUNTERID		3
+#define ZBX_PERF_TEXT_INSTANCE		4
+#define ZBX_PERF_TEXT_FAULTSTRING	5
+
+/* QueryPerf response body type */
+#define ZBX_PERF_BODY_UNKNOWN	0
+#define ZBX_PERF_BODY_RESPONSE	1
+#define ZBX_PERF_BODY_FAULT	2
+
+/* QueryPerf response SAX parser state */
+typedef struct
+{
+	xmlParserCtxt				*ctxt;
+
+	/* parsed performance entity data */
+	zbx_vector_vmware_perf_data_ptr_t	perfdata;
+
+	/* the current element depth, Envelope element has depth 1 */
+	int					depth;
+
+	unsigned char				body;
+
+	/* the performance entity being parsed and number of its accessible values */
+	zbx_vmware_perf_data_t			*data;
+	int					data_values;
+
+	/* the metric series (PerfMetricIntSeries) being parsed */
+	unsigned char				series;
+	unsigned char				series_id;
+	char					*counterid;
+	char					*instance;
+	char					*value;
+	char					*value_accessible;
+
+	/* text of the element being read */
+	unsigned char				text_type;
+	char					*text;
+	size_t					text_alloc;
+	size_t					text_offset;
+
+	/* SOAP fault and the first parsing error */
+	unsigned char				fault_detail;
+	char					*fault;
+	char					*error;
+}
+zbx_vmware_perf_parser_t;
+
+static void	vmware_perf_parser_series_clear(zbx_vmware_perf_parser_t *parser)
+{
+	zbx_free(parser->counterid);
+	zbx_free(parser->instance);
+	zbx_free(parser->value);
+	zbx_free(parser->value_accessible);
+}
+
 /******************************************************************************
  *                                                                            *
- * Purpose: updates vmware performance statistics data                        *
+ * Purpose: adds parsed metric series value to the current performance entity *
  *                                                                            *
- * Parameters: perfdata  - [OUT] performance counter values                   *
- *             xdoc      - [IN] xml document containing performance           *
- *                              counter values for all entities               *
- *             node      - [IN] xml node containing performance counter       *
- *                              values for specified entity                   *
+ * Parameters: parser - [IN/OUT] QueryPerf response parser                    *
  *                                                                            *
- * Return value: SUCCEED - performance entity data was parsed                 *
- *               FAIL    - performance entity data did not contain valid      *
- *                         values                                             *
+ * Comments: The last accessible (not -1) sample of the series is used, if    *
+ *           there are no such samples the last sample is used.               *
  *                                                                            *
  ******************************************************************************/
-static int	vmware_service_process_perf_entity_data(zbx_vmware_perf_data_t *perfdata, xmlDoc *xdoc, xmlNode *node)
+static void	vmware_perf_parser_series_add(zbx_vmware_perf_parser_t *parser)
 {
-	xmlXPathContext				*xpathCtx;
-	xmlXPathObject				*xpathObj;
-	xmlNodeSetPtr				nodeset;
-	char					*instance, *counter, *value;
-	int					values = 0, ret = FAIL;
-	zbx_vector_vmware_perf_value_ptr_t	*pervalues = &perfdata->values;
-	zbx_vmware_perf_value_t			*perfvalue;
+	zbx_vmware_perf_data_t	*data = parser->data;
+	zbx_vmware_perf_value_t	*perfvalue;
+	char			*value;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	value = (NULL != parser->value_accessible ? parser->value_accessible : parser->value);
 
-	xpathCtx = xmlXPathNewContext(xdoc);
-	xpathCtx->node = node;
+	if (NULL == value || NULL == parser->counterid)
+		return;
 
-	if (NULL == (xpathObj = xmlXPathEvalExpression((const xmlChar *)"*[local-name()='value']", xpathCtx)))
-		goto out;
+	perfvalue = (zbx_vmware_perf_value_t *)zbx_malloc(NULL, sizeof(zbx_vmware_perf_value_t));
 
-	if (0 != xmlXPathNodeSetIsEmpty(xpathObj->nodesetval))
-		goto out;
+	ZBX_STR2UINT64(perfvalue->counterid, parser->counterid);
+	perfvalue->instance = (NULL != parser->instance ? parser->instance : zbx_strdup(NULL, ""));
+	parser->instance = NULL;
 
-	nodeset = xpathObj->nodesetval;
-	zbx_vector_vmware_perf_value_ptr_reserve(pervalues, (size_t)(nodeset->nodeNr + pervalues->values_alloc));
+	if (0 == strcmp(value, "-1") || SUCCEED != zbx_is_uint64(value, &perfvalue->value))
+	{
+		perfvalue->value = ZBX_MAX_UINT64;
+		zabbix_log(LOG_LEVEL_DEBUG, "PerfCounter inaccessible. type:%s object id:%s "
+				"counter id:" ZBX_FS_UI64 " instance:%s value:%s", ZBX_NULL2EMPTY_STR(data->type),
+				ZBX_NULL2EMPTY_STR(data->id), perfvalue->counterid, perfvalue->instance, value);
+	}
+	else
+		parser->data_values++;
 
-	for (int i = 0; i < nodeset->nodeNr; i++)
+	zbx_vector_vmware_perf_value_ptr_append(&data->values, perfvalue);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: SAX callback for element start                                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_perf_parser_start_element(void *ctx, const xmlChar *localname, const xmlChar *prefix,
+		const xmlChar *URI, int nb_namespaces, const xmlChar **namespaces, int nb_attributes,
+		int nb_defaulted, const xmlChar **attributes)
+{
+	zbx_vmware_perf_parser_t	*parser = (zbx_vmware_perf_parser_t *)ctx;
+	const char			*name = (const char *)localname;
+
+	ZBX_UNUSED(prefix);
+	ZBX_UNUSED(URI);
+	ZBX_UNUSED(nb_namespaces);
+	ZBX_UNUSED(namespaces);
+	ZBX_UNUSED(nb_defaulted);
+
+	parser->depth++;
+	parser->text_type = ZBX_PERF_TEXT_NONE;
+
+	/* Envelope/Body/<QueryPerfResponse|Fault>/returnval/<entity|value>/<id|value>/<counterId|instance> */
+	switch (parser->depth)
 	{
-		if (NULL == (value = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i],
-				"*[local-name()='value'][text() != '-1'][last()]")))
-		{
-			value = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i], "*[local-name()='value'][last()]");
-		}
+		case 3:
+			if (0 == strcmp(name, "QueryPerfResponse"))
+				parser->body = ZBX_PERF_BODY_RESPONSE;
+			else if (0 == strcmp(name, "Fault"))
+				parser->body = ZBX_PERF_BODY_FAULT;
+			break;
+		case 4:
+			if (ZBX_PERF_BODY_FAULT == parser->body)
+			{
+				if (0 == strcmp(name, "faultstring"))
+					parser->text_type = ZBX_PERF_TEXT_FAULTSTRING;
+				else if (0 == strcmp(name, "detail"))
+					parser->fault_detail = 1;
+				break;
+			}
 
-		instance = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i], "*[local-name()='id']"
-				"/*[local-name()='instance']");
-		counter = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i], "*[local-name()='id']"
-				"/*[local-name()='counterId']");
+			if (ZBX_PERF_BODY_RESPONSE != parser->body)
+				break;
 
-		if (NULL != value && NULL != counter)
-		{
-			perfvalue = (zbx_vmware_perf_value_t *)zbx_malloc(NULL, sizeof(zbx_vmware_perf_value_t));
+			parser->data = (zbx_vmware_perf_data_t *)zbx_malloc(NULL, sizeof(zbx_vmware_perf_data_t));
+			parser->data->id = NULL;
+			parser->data->type = NULL;
+			parser->data->error = NULL;
+			zbx_vector_vmware_perf_value_ptr_create(&parser->data->values);
+			parser->data_values = 0;
+			break;
+		case 5:
+			if (1 == parser->fault_detail)
+			{
+				/* use the fault type name if fault has no description */
+				if (NULL == parser->fault)
+					parser->fault = zbx_strdup(NULL, name);
+				break;
+			}
 
-			ZBX_STR2UINT64(perfvalue->counterid, counter);
-			perfvalue->instance = (NULL != instance ? instance : zbx_strdup(NULL, ""));
+			if (NULL == parser->data)
+				break;
 
-			if (0 == strcmp(value, "-1") || SUCCEED != zbx_is_uint64(value, &perfvalue->value))
+			if (0 == strcmp(name, "entity"))
 			{
-				perfvalue->value = ZBX_MAX_UINT64;
-				zabbix_log(LOG_LEVEL_DEBUG, "PerfCounter inaccessible. type:%s object id:%s "
-						"counter id:" ZBX_FS_UI64 " instance:%s value:%s", perfdata->type,
-						perfdata->id, perfvalue->counterid, perfvalue->instance, value);
+				parser->text_type = ZBX_PERF_TEXT_ENTITY;
+
+				for (int i = 0; i < nb_attributes; i++)
+				{
+					const xmlChar	**attr = attributes + i * 5;
+
+					if (0 == strcmp((const char *)attr[0], "type"))
+					{
+						parser->data->type = zbx_dsprintf(parser->data->type, "%.*s",
+								(int)(attr[4] - attr[3]), (const char *)attr[3]);
+					}
+				}
 			}
-			else if (FAIL == ret)
-				ret = SUCCEED;
+			else if (0 == strcmp(name, "value"))
+				parser->series = 1;
+			break;
+		case 6:
+			if (1 != parser->series)
+				break;
+
+			if (0 == strcmp(name, "value"))
+				parser->text_type = ZBX_PERF_TEXT_VALUE;
+			else if (0 == strcmp(name, "id"))
+				parser->series_id = 1;
+			break;
+		case 7:
+			if (1 != parser->series_id)
+				break;
+
+			if (0 == strcmp(name, "counterId"))
+				parser->text_type = ZBX_PERF_TEXT_COUNTERID;
+			else if (0 == strcmp(name, "instance"))
+				parser->text_type = ZBX_PERF_TEXT_INSTANCE;
+			break;
+	}
 
-			zbx_vector_vmware_perf_value_ptr_append(pervalues, perfvalue);
+	parser->text_offset = 0;
+}
 
-			instance = NULL;
-			values++;
-		}
+/******************************************************************************
+ *                                                                            *
+ * Purpose: SAX callback for element end                                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_perf_parser_end_element(void *ctx, const xmlChar *localname, const xmlChar *prefix,
+		const xmlChar *URI)
+{
+	zbx_vmware_perf_parser_t	*parser = (zbx_vmware_perf_parser_t *)ctx;
+	char				*text = NULL;
 
-		zbx_free(counter);
-		zbx_free(instance);
-		zbx_free(value);
+	ZBX_UNUSED(localname);
+	ZBX_UNUSED(prefix);
+	ZBX_UNUSED(URI);
+
+	/* empty elements are treated as missing, the same as when reading values with xpath */
+	if (ZBX_PERF_TEXT_NONE != parser->text_type && 0 != parser->text_offset)
+		text = zbx_strdup(NULL, parser->text);
+
+	switch (parser->text_type)
+	{
+		case ZBX_PERF_TEXT_ENTITY:
+			zbx_free(parser->data->id);
+			parser->data->id = text;
+			break;
+		case ZBX_PERF_TEXT_VALUE:
+			if (NULL != text && 0 != strcmp(text, "-1"))
+				parser->value_accessible = zbx_strdup(parser->value_accessible, text);
+
+			zbx_free(parser->value);
+			parser->value = text;
+			break;
+		case ZBX_PERF_TEXT_COUNTERID:
+			zbx_free(parser->counterid);
+			parser->counterid = text;
+			break;
+		case ZBX_PERF_TEXT_INSTANCE:
+			zbx_free(parser->instance);
+			parser->instance = text;
+			break;
+		case ZBX_PERF_TEXT_FAULTSTRING:
+			if (NULL != text)
+			{
+				zbx_free(parser->fault);
+				parser->fault = text;
+			}
+			break;
+		default:
+			zbx_free(text);
 	}
 
-out:
-	xmlXPathFreeObject(xpathObj);
-	xmlXPathFreeContext(xpathCtx);
+	parser->text_type = ZBX_PERF_TEXT_NONE;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() values:%d", __func__, values);
+	switch (parser->depth)
+	{
+		case 4:
+			parser->fault_detail = 0;
 
-	return ret;
+			if (NULL == parser->data)
+				break;
+
+			if (NULL != parser->data->type && NULL != parser->data->id && 0 != parser->data_values)
+				zbx_vector_vmware_perf_data_ptr_append(&parser->perfdata, parser->data);
+			else
+				vmware_free_perfdata(parser->data);
+
+			parser->data = NULL;
+			break;
+		case 5:
+			if (1 == parser->series)
+			{
+				vmware_perf_parser_series_add(parser);
+				vmware_perf_parser_series_clear(parser);
+				parser->series = 0;
+			}
+			break;
+		case 6:
+			parser->series_id = 0;
+			break;
+	}
+
+	parser->depth--;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: updates vmware performance statistics data                        *
+ * Purpose: SAX callback for element text                                     *
  *                                                                            *
- * Parameters: perfdata - [OUT] performance entity data                       *
- *             xdoc     - [IN] performance data xml document                  *
+ ******************************************************************************/
+static void	vmware_perf_parser_characters(void *ctx, const xmlChar *ch, int len)
+{
+	zbx_vmware_perf_parser_t	*parser = (zbx_vmware_perf_parser_t *)ctx;
+
+	if (ZBX_PERF_TEXT_NONE != parser->text_type)
+	{
+		zbx_strncpy_alloc(&parser->text, &parser->text_alloc, &parser->text_offset, (const char *)ch,
+				(size_t)len);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: SAX callback for parsing errors                                   *
  *                                                                            *
  ******************************************************************************/
-static void	vmware_service_parse_perf_data(zbx_vector_vmware_perf_data_ptr_t *perfdata, xmlDoc *xdoc)
+#if 21200 > LIBXML_VERSION /* version 2.12.0 */
+static void	vmware_perf_parser_error(void *ctx, xmlErrorPtr err)
+#else
+static void	vmware_perf_parser_error(void *ctx, const xmlError *err)
+#endif
 {
-	xmlXPathContext	*xpathCtx;
-	xmlXPathObject	*xpathObj;
-	xmlNodeSetPtr	nodeset;
+	zbx_vmware_perf_parser_t	*parser = (zbx_vmware_perf_parser_t *)ctx;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	if (NULL == parser->error && XML_ERR_WARNING < err->level)
+	{
+		parser->error = zbx_dsprintf(NULL, "cannot parse performance data: %s", err->message);
+		zbx_rtrim(parser->error, "\n");
+	}
+}
 
-	xpathCtx = xmlXPathNewContext(xdoc);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initializes QueryPerf response streaming parser                   *
+ *                                                                            *
+ * Parameters: parser - [OUT]                                                 *
+ *                                                                            *
+ * Return value: SUCCEED - the parser was initialized                         *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: QueryPerf responses for large environments are huge and contain  *
+ *           only few element types, so instead of building document tree and *
+ *           evaluating xpaths for each value the response is parsed with SAX *
+ *           interface while it is being received.                            *
+ *                                                                            *
+ ******************************************************************************/
+static int	vmware_perf_parser_init(zbx_vmware_perf_parser_t *parser)
+{
+	xmlSAXHandler	sax;
 
-	if (NULL == (xpathObj = xmlXPathEvalExpression((const xmlChar *)"/*/*/*/*", xpathCtx)))
-		goto clean;
+	memset(parser, 0, sizeof(zbx_vmware_perf_parser_t));
+	zbx_vector_vmware_perf_data_ptr_create(&parser->perfdata);
 
-	if (0 != xmlXPathNodeSetIsEmpty(xpathObj->nodesetval))
-		goto clean;
+	memset(&sax, 0, sizeof(sax));
+	sax.initialized = XML_SAX2_MAGIC;
+	sax.startElementNs = vmware_perf_parser_start_element;
+	sax.endElementNs = vmware_perf_parser_end_element;
+	sax.characters = vmware_perf_parser_characters;
+	sax.serror = vmware_perf_parser_error;
 
-	nodeset = xpathObj->nodesetval;
-	zbx_vector_vmware_perf_data_ptr_reserve(perfdata, (size_t)(nodeset->nodeNr + perfdata->values_alloc));
+	if (NULL == (parser->ctxt = xmlCreatePushParserCtxt(&sax, parser, NULL, 0, NULL)))
+		return FAIL;
 
-	for (int i = 0; i < nodeset->nodeNr; i++)
-	{
-		zbx_vmware_perf_data_t	*data;
-		int			ret = FAIL;
+	xmlCtxtUseOptions(parser->ctxt, XML_PARSE_NONET);
 
-		data = (zbx_vmware_perf_data_t *)zbx_malloc(NULL, sizeof(zbx_vmware_perf_data_t));
+	return SUCCEED;
+}
 
-		data->id = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i], "*[local-name()='entity']");
-		data->type = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i], "*[local-name()='entity']/@type");
-		data->error = NULL;
-		zbx_vector_vmware_perf_value_ptr_create(&data->values);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finishes QueryPerf response parsing                               *
+ *                                                                            *
+ * Parameters: parser - [IN/OUT]                                              *
+ *             error  - [OUT] error message in case of failure                *
+ *                                                                            *
+ * Return value: SUCCEED - the response was parsed and has no SOAP fault      *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	vmware_perf_parser_finish(zbx_vmware_perf_parser_t *parser, char **error)
+{
+	xmlParseChunk(parser->ctxt, NULL, 0, 1);
 
-		if (NULL != data->type && NULL != data->id)
-			ret = vmware_service_process_perf_entity_data(data, xdoc, nodeset->nodeTab[i]);
+	if (NULL != parser->error || 0 == parser->ctxt->wellFormed)
+	{
+		*error = zbx_strdup(*error, NULL != parser->error ? parser->error : "cannot parse performance data");
+		return FAIL;
+	}
 
-		if (SUCCEED == ret)
-			zbx_vector_vmware_perf_data_ptr_append(perfdata, data);
-		else
-			vmware_free_perfdata(data);
+	if (ZBX_PERF_BODY_FAULT == parser->body)
+	{
+		*error = zbx_strdup(*error, NULL != parser->fault ? parser->fault : "unknown SOAP fault");
+		return FAIL;
 	}
-clean:
-	xmlXPathFreeObject(xpathObj);
-	xmlXPathFreeContext(xpathCtx);
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+
+	return SUCCEED;
+}
+
+static void	vmware_perf_parser_clean(zbx_vmware_perf_parser_t *parser)
+{
+	if (NULL != parser->ctxt)
+		xmlFreeParserCtxt(parser->ctxt);
+
+	if (NULL != parser->data)
+		vmware_free_perfdata(parser->data);
+
+	vmware_perf_parser_series_clear(parser);
+
+	zbx_vector_vmware_perf_data_ptr_clear_ext(&parser->perfdata, vmware_free_perfdata);
+	zbx_vector_vmware_perf_data_ptr_destroy(&parser->perfdata);
+
+	zbx_free(parser->text);
+	zbx_free(parser->fault);
+	zbx_free(parser->error);
 }
 
+#undef ZBX_PERF_TEXT_NONE
+#undef ZBX_PERF_TEXT_ENTITY
+#undef ZBX_PERF_TEXT_VALUE
+#undef ZBX_PERF_TEXT_COUNTERID
+#undef ZBX_PERF_TEXT_INSTANCE
+#undef ZBX_PERF_TEXT_FAULTSTRING
+#undef ZBX_PERF_BODY_UNKNOWN
+#undef ZBX_PERF_BODY_RESPONSE
+#undef ZBX_PERF_BODY_FAULT
+
 /******************************************************************************
  *                                                                            *
  * Purpose: adds error for specified perf entity                              *
@@ -890,8 +1168,360 @@ static void	vmware_service_copy_perf_data(const zbx_vmware_service_t *service,
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/* the maximum number of concurrent performance data requests per service */
+#define ZBX_VMWARE_PERF_REQUESTS_MAX	4
+
+/* performance data (QueryPerf) request */
+typedef struct
+{
+	char				*request;
+
+	/* range of entities in entities vector whose counters are completed by this request */
+	int				entity_first;
+	int				entity_last;
+
+	/* connection handle from the handle pool while the request is being sent */
+	CURL				*handle;
+	zbx_vmware_perf_parser_t	parser;
+
+	/* received response bytes and time spent parsing them */
+	zbx_uint64_t			bytes;
+	double				time_parse;
+
+	/* the request result - NULL on success, error message otherwise */
+	char				*error;
+}
+zbx_vmware_perf_request_t;
+
+ZBX_PTR_VECTOR_DECL(vmware_perf_request_ptr, zbx_vmware_perf_request_t *)
+ZBX_PTR_VECTOR_IMPL(vmware_perf_request_ptr, zbx_vmware_perf_request_t *)
+
+static void	vmware_perf_request_free(zbx_vmware_perf_request_t *request)
+{
+	vmware_perf_parser_clean(&request->parser);
+	zbx_free(request->error);
+	zbx_free(request->request);
+	zbx_free(request);
+}
+
+/* pool of connection handles reused by performance data requests */
+typedef struct
+{
+	CURL	*handles[ZBX_VMWARE_PERF_REQUESTS_MAX];
+	int	handles_num;
+
+	/* the handles not used by active requests */
+	CURL	*idle[ZBX_VMWARE_PERF_REQUESTS_MAX];
+	int	idle_num;
+}
+zbx_vmware_perf_handle_pool_t;
+
+static size_t	vmware_perf_request_write_cb(void *ptr, size_t size, size_t nmemb, void *userdata)
+{
+	size_t				r_size = size * nmemb;
+	zbx_vmware_perf_request_t	*request = (zbx_vmware_perf_request_t *)userdata;
+	double				time_start;
+
+	zabbix_log(LOG_LEVEL_TRACE, "%s() SOAP response: %.*s", __func__, (int)r_size, (const char *)ptr);
+
+	time_start = zbx_time();
+	xmlParseChunk(request->parser.ctxt, (const char *)ptr, (int)r_size, 0);
+	request->time_parse += zbx_time() - time_start;
+	request->bytes += r_size;
+
+	/* abort the transfer if the response cannot be parsed */
+	if (NULL != request->parser.error || 0 == request->parser.ctxt->wellFormed)
+		return 0;
+
+	return r_size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets connection handle for performance data request               *
+ *                                                                            *
+ * Parameters: pool       - [IN/OUT] connection handle pool                   *
+ *             easyhandle - [IN] authenticated cURL connection handle         *
+ *             cookies    - [IN] session cookies of the connection handle     *
+ *             error      - [OUT] the error message                           *
+ *                                                                            *
+ * Return value: idle connection handle or NULL on error                      *
+ *                                                                            *
+ * Comments: Handles are copies of the connection handle sharing the service  *
+ *           session. They are created when all existing handles are busy and *
+ *           are reused by the following requests, keeping connections and    *
+ *           TLS sessions alive between requests.                             *
+ *                                                                            *
+ ******************************************************************************/
+static CURL	*vmware_perf_handle_get(zbx_vmware_perf_handle_pool_t *pool, CURL *easyhandle,
+		const struct curl_slist *cookies, char **error)
+{
+	CURL		*handle;
+	CURLoption	opt;
+	CURLcode	err;
+
+	if (0 != pool->idle_num)
+		return pool->idle[--pool->idle_num];
+
+	if (ZBX_VMWARE_PERF_REQUESTS_MAX == pool->handles_num)
+	{
+		*error = zbx_strdup(*error, "no idle cURL handle");
+		return NULL;
+	}
+
+	if (NULL == (handle = curl_easy_duphandle(easyhandle)))
+	{
+		*error = zbx_strdup(*error, "cannot duplicate cURL handle");
+		return NULL;
+	}
+
+	if (CURLE_OK != (err = curl_easy_setopt(handle, opt = CURLOPT_WRITEFUNCTION, vmware_perf_request_write_cb)))
+		goto out;
+
+	for (; NULL != cookies; cookies = cookies->next)
+	{
+		if (CURLE_OK != (err = curl_easy_setopt(handle, opt = CURLOPT_COOKIELIST, cookies->data)))
+			goto out;
+	}
+
+	pool->handles[pool->handles_num++] = handle;
+
+	return handle;
+out:
+	*error = zbx_dsprintf(*error, "Cannot set cURL option %d: %s.", (int)opt, curl_easy_strerror(err));
+	curl_easy_cleanup(handle);
+
+	return NULL;
+}
+
+static void	vmware_perf_handle_release(zbx_vmware_perf_handle_pool_t *pool, CURL *handle)
+{
+	pool->idle[pool->idle_num++] = handle;
+}
+
+static void	vmware_perf_handle_pool_clean(zbx_vmware_perf_handle_pool_t *pool)
+{
+	for (int i = 0; i < pool->handles_num; i++)
+		curl_easy_cleanup(pool->handles[i]);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepares performance data request for sending                     *
+ *                                                                            *
+ * Parameters: pool       - [IN/OUT] connection handle pool                   *
+ *             easyhandle - [IN] authenticated cURL connection handle         *
+ *             cookies    - [IN] session cookies of the connection handle     *
+ *             request    - [IN/OUT] the request to prepare                   *
+ *                                                                            *
+ * Return value: SUCCEED - the request is ready to be sent                    *
+ *               FAIL    - otherwise, the request error is set                *
+ *                                                                            *
+ ******************************************************************************/
+static int	vmware_perf_request_prepare(zbx_vmware_perf_handle_pool_t *pool, CURL *easyhandle,
+		const struct curl_slist *cookies, zbx_vmware_perf_request_t *request)
+{
+	CURLoption	opt;
+	CURLcode	err;
+
+	zabbix_log(LOG_LEVEL_TRACE, "%s() SOAP request: %s", __func__, request->request);
+
+	if (SUCCEED != vmware_perf_parser_init(&request->parser))
+	{
+		request->error = zbx_strdup(request->error, "cannot create performance data parser");
+		return FAIL;
+	}
+
+	if (NULL == (request->handle = vmware_perf_handle_get(pool, easyhandle, cookies, &request->error)))
+		return FAIL;
+
+	if (CURLE_OK != (err = curl_easy_setopt(request->handle, opt = CURLOPT_WRITEDATA, request)) ||
+			CURLE_OK != (err = curl_easy_setopt(request->handle, opt = CURLOPT_PRIVATE, request)) ||
+			CURLE_OK != (err = curl_easy_setopt(request->handle, opt = CURLOPT_POSTFIELDS,
+					request->request)))
+	{
+		request->error = zbx_dsprintf(request->error, "Cannot set cURL option %d: %s.", (int)opt,
+				curl_easy_strerror(err));
+		vmware_perf_handle_release(pool, request->handle);
+		request->handle = NULL;
+
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finishes sent performance data request                            *
+ *                                                                            *
+ * Parameters: pool    - [IN/OUT] connection handle pool                      *
+ *             request - [IN/OUT]                                             *
+ *             err     - [IN] the transfer result                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_perf_request_finish(zbx_vmware_perf_handle_pool_t *pool, zbx_vmware_perf_request_t *request,
+		CURLcode err)
+{
+	if (CURLE_OK != err)
+	{
+		if (NULL != request->parser.error)
+			request->error = zbx_strdup(request->error, request->parser.error);
+		else
+			request->error = zbx_strdup(request->error, curl_easy_strerror(err));
+	}
+	else
+		vmware_perf_parser_finish(&request->parser, &request->error);
+
+	vmware_perf_handle_release(pool, request->handle);
+	request->handle = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sends performance data requests                                   *
+ *                                                                            *
+ * Parameters: easyhandle - [IN] authenticated cURL connection handle         *
+ *             requests   - [IN/OUT] the requests to send                     *
+ *             stats      - [IN/OUT] performance data collection statistics   *
+ *                                                                            *
+ * Comments: Requests are sent concurrently with cURL multi interface when    *
+ *           it is supported, the responses are parsed while being received.  *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_perf_requests_send(CURL *easyhandle, zbx_vector_vmware_perf_request_ptr_t *requests,
+		zbx_vmware_perf_stats_t *stats)
+{
+	struct curl_slist		*cookies = NULL;
+	CURLM				*multi = NULL;
+	CURLMcode			code = CURLM_OK;
+	int				next = 0, active = 0;
+	double				time_start;
+	zbx_vmware_perf_handle_pool_t	pool = {0};
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() requests:%d", __func__, requests->values_num);
+
+	time_start = zbx_time();
+
+	if (CURLE_OK != curl_easy_getinfo(easyhandle, CURLINFO_COOKIELIST, &cookies))
+		cookies = NULL;
+
+	if (1 < requests->values_num && SUCCEED == zbx_curl_has_multi_wait(NULL))
+		multi = curl_multi_init();
+
+	if (NULL == multi)
+	{
+		for (; next < requests->values_num; next++)
+		{
+			zbx_vmware_perf_request_t	*request = requests->values[next];
+
+			if (SUCCEED == vmware_perf_request_prepare(&pool, easyhandle, cookies, request))
+				vmware_perf_request_finish(&pool, request, curl_easy_perform(request->handle));
+		}
+
+		goto out;
+	}
+
+	while (next < requests->values_num || 0 < active)
+	{
+		CURLMsg	*msg;
+		int	running, fds, msgnum;
+
+		for (; next < requests->values_num && ZBX_VMWARE_PERF_REQUESTS_MAX > active; next++)
+		{
+			zbx_vmware_perf_request_t	*request = requests->values[next];
+
+			if (SUCCEED != vmware_perf_request_prepare(&pool, easyhandle, cookies, request))
+				continue;
+
+			if (CURLM_OK != (code = curl_multi_add_handle(multi, request->handle)))
+			{
+				request->error = zbx_dsprintf(request->error, "cannot add cURL handle: %s",
+						curl_multi_strerror(code));
+				vmware_perf_handle_release(&pool, request->handle);
+				request->handle = NULL;
+				continue;
+			}
+
+			active++;
+		}
+
+		if (CURLM_OK != (code = curl_multi_perform(multi, &running)))
+			break;
+
+		while (NULL != (msg = curl_multi_info_read(multi, &msgnum)))
+		{
+			zbx_vmware_perf_request_t	*request;
+
+			if (CURLMSG_DONE != msg->msg)
+				continue;
+
+			if (CURLE_OK != curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&request))
+				continue;
+
+			curl_multi_remove_handle(multi, msg->easy_handle);
+			vmware_perf_request_finish(&pool, request, msg->data.result);
+			active--;
+		}
+
+		if (0 != active && CURLM_OK != (code = zbx_curl_multi_wait(multi, SEC_PER_MIN * 1000, &fds)))
+			break;
+	}
+
+	if (CURLM_OK != code)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot perform performance data requests: %s",
+				curl_multi_strerror(code));
+	}
+
+	/* fail the requests left unfinished because of multi interface error */
+	for (int i = 0; i < requests->values_num; i++)
+	{
+		zbx_vmware_perf_request_t	*request = requests->values[i];
+
+		if (NULL != request->handle)
+		{
+			curl_multi_remove_handle(multi, request->handle);
+			request->handle = NULL;
+		}
+		else if (i < next)
+			continue;
+
+		request->error = zbx_strdup(request->error, "cannot perform performance data request");
+	}
+
+	curl_multi_cleanup(multi);
+out:
+	vmware_perf_handle_pool_clean(&pool);
+	curl_slist_free_all(cookies);
+
+	for (int i = 0; i < requests->values_num; i++)
+	{
+		zbx_vmware_perf_request_t	*request = requests->values[i];
+
+		stats->bytes += request->bytes;
+		stats->time_parse += request->time_parse;
+		stats->time_transfer -= request->time_parse;
+	}
+
+	stats->requests += (zbx_uint64_t)requests->values_num;
+	stats->time_transfer += zbx_time() - time_start;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
 #define ZBX_XML_DATETIME		26
 
+static void	vmware_perf_stats_add(zbx_vmware_perf_stats_t *dst, const zbx_vmware_perf_stats_t *src,
+		double time_total)
+{
+	dst->requests += src->requests;
+	dst->bytes += src->bytes;
+	dst->time_total += time_total;
+	dst->time_transfer += src->time_transfer;
+	dst->time_parse += src->time_parse;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: retrieves performance counter values from vmware service          *
@@ -902,23 +1532,29 @@ static void	vmware_service_copy_perf_data(const zbx_vmware_service_t *service,
  *                                 counters for                               *
  *             counters_max - [IN] maximum number of counters per query       *
  *             perfdata     - [OUT] performance counter values                *
+ *             stats        - [IN/OUT] performance data collection statistics *
  *                                                                            *
  ******************************************************************************/
 static void	vmware_service_retrieve_perf_counters(zbx_vmware_service_t *service, CURL *easyhandle,
 		zbx_vector_vmware_perf_entity_ptr_t *entities, int counters_max,
-		zbx_vector_vmware_perf_data_ptr_t *perfdata)
+		zbx_vector_vmware_perf_data_ptr_t *perfdata, zbx_vmware_perf_stats_t *stats)
 {
-	char				*tmp = NULL, *error = NULL;
-	size_t				tmp_alloc = 0, tmp_offset;
-	int				i, j, start_counter = 0;
-	zbx_vmware_perf_entity_t	*entity;
-	xmlDoc				*doc = NULL;
+	char					*tmp = NULL;
+	size_t					tmp_alloc = 0, tmp_offset;
+	int					i, j, start_counter = 0, end;
+	zbx_vmware_perf_entity_t		*entity;
+	zbx_vector_vmware_perf_request_ptr_t	requests;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() counters_max:%d", __func__, counters_max);
 
-	while (0 != entities->values_num)
+	zbx_vector_vmware_perf_request_ptr_create(&requests);
+
+	zbx_vmware_lock();
+
+	for (end = entities->values_num; 0 != end; end = i + 1)
 	{
-		int	counters_num = 0;
+		int				counters_num = 0;
+		zbx_vmware_perf_request_t	*request;
 
 		tmp_offset = 0;
 		zbx_strcpy_alloc(&tmp, &tmp_alloc, &tmp_offset, ZBX_POST_VSPHERE_HEADER);
@@ -926,9 +1562,7 @@ static void	vmware_service_retrieve_perf_counters(zbx_vmware_service_t *service,
 				"<ns0:_this type=\"PerformanceManager\">%s</ns0:_this>",
 				get_vmware_service_objects()[service->type].performance_manager);
 
-		zbx_vmware_lock();
-
-		for (i = entities->values_num - 1; 0 <= i && counters_num < counters_max;)
+		for (i = end - 1; 0 <= i && counters_num < counters_max;)
 		{
 			char	*id_esc;
 
@@ -998,36 +1632,47 @@ static void	vmware_service_retrieve_perf_counters(zbx_vmware_service_t *service,
 			zbx_snprintf_alloc(&tmp, &tmp_alloc, &tmp_offset, "</ns0:querySpec>");
 		}
 
-		zbx_vmware_unlock();
-		zbx_xml_free_doc(doc);
-		doc = NULL;
-
 		zbx_strcpy_alloc(&tmp, &tmp_alloc, &tmp_offset, "</ns0:QueryPerf>");
 		zbx_strcpy_alloc(&tmp, &tmp_alloc, &tmp_offset, ZBX_POST_VSPHERE_FOOTER);
 
-		zabbix_log(LOG_LEVEL_TRACE, "%s() SOAP request: %s", __func__, tmp);
+		request = (zbx_vmware_perf_request_t *)zbx_malloc(NULL, sizeof(zbx_vmware_perf_request_t));
+		memset(request, 0, sizeof(zbx_vmware_perf_request_t));
+		request->request = zbx_strdup(NULL, tmp);
+		request->entity_first = i + 1;
+		request->entity_last = end - 1;
+		zbx_vector_vmware_perf_request_ptr_append(&requests, request);
+	}
+
+	zbx_vmware_unlock();
 
-		if (SUCCEED != zbx_soap_post(__func__, easyhandle, tmp, &doc, NULL, &error))
+	vmware_perf_requests_send(easyhandle, &requests, stats);
+
+	for (i = 0; i < requests.values_num; i++)
+	{
+		zbx_vmware_perf_request_t	*request = requests.values[i];
+
+		if (NULL != request->error)
 		{
-			for (j = i + 1; j < entities->values_num; j++)
+			for (j = request->entity_first; j <= request->entity_last; j++)
 			{
 				entity = (zbx_vmware_perf_entity_t *)entities->values[j];
-				vmware_perf_data_add_error(perfdata, entity->type, entity->id, error);
+				vmware_perf_data_add_error(perfdata, entity->type, entity->id, request->error);
 			}
 
-			zbx_free(error);
-			break;
+			continue;
 		}
 
-		/* parse performance data into local memory */
-		vmware_service_parse_perf_data(perfdata, doc);
-
-		while (entities->values_num > i + 1)
-			zbx_vector_vmware_perf_entity_ptr_remove_noorder(entities, entities->values_num - 1);
+		/* move parsed performance data into local memory */
+		zbx_vector_vmware_perf_data_ptr_append_array(perfdata, request->parser.perfdata.values,
+				request->parser.perfdata.values_num);
+		zbx_vector_vmware_perf_data_ptr_clear(&request->parser.perfdata);
 	}
 
+	zbx_vector_vmware_perf_entity_ptr_clear(entities);
+
+	zbx_vector_vmware_perf_request_ptr_clear_ext(&requests, vmware_perf_request_free);
+	zbx_vector_vmware_perf_request_ptr_destroy(&requests);
 	zbx_free(tmp);
-	zbx_xml_free_doc(doc);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
@@ -1263,10 +1908,14 @@ int	zbx_vmware_service_update_perf(zbx_vmware_service_t *service, const char *co
 	zbx_hashset_iter_t			iter;
 	zbx_vector_vmware_perf_data_ptr_t	perfdata;
 	zbx_vector_perf_available_ptr_t		perf_available;
+	zbx_vmware_perf_stats_t			stats = {0};
+	double					time_start;
 	static ZBX_HTTPPAGE			page;	/* 173K */
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() '%s'@'%s'", __func__, service->username, service->url);
 
+	time_start = zbx_time();
+
 	zbx_vector_vmware_perf_entity_ptr_create(&entities);
 	zbx_vector_vmware_perf_entity_ptr_create(&hist_entities);
 	zbx_vector_vmware_perf_data_ptr_create(&perfdata);
@@ -1415,9 +2064,10 @@ int	zbx_vmware_service_update_perf(zbx_vmware_service_t *service, const char *co
 
 	zbx_vmware_unlock();
 
-	vmware_service_retrieve_perf_counters(service, easyhandle, &entities, ZBX_MAXQUERYMETRICS_UNLIMITED, &perfdata);
+	vmware_service_retrieve_perf_counters(service, easyhandle, &entities, ZBX_MAXQUERYMETRICS_UNLIMITED, &perfdata,
+			&stats);
 	vmware_service_retrieve_perf_counters(service, easyhandle, &hist_entities, service->data->max_query_metrics,
-			&perfdata);
+			&perfdata, &stats);
 
 	if (SUCCEED != vmware_service_logout(service, easyhandle, &error))
 	{
@@ -1448,6 +2098,8 @@ out:
 		vmware_service_copy_perf_data(service, &perfdata);
 	}
 
+	vmware_perf_stats_add(&zbx_vmware_get_vmware()->perf_stats, &stats, zbx_time() - time_start);
+
 	zbx_vmware_unlock();
 
 	zbx_vector_perf_available_ptr_clear_ext(&perf_available, vmware_perf_available_free);
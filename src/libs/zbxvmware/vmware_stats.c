@@ -32,6 +32,15 @@ void	zbx_vmware_stats_ext_get(struct zbx_json *json, const void *arg)
 				vmware_stats.memory_total * 100);
 		zbx_json_adduint64(json, "used", vmware_stats.memory_used);
 		zbx_json_addfloat(json, "pused", (double)vmware_stats.memory_used / vmware_stats.memory_total * 100);
+
+		zbx_json_addobject(json, "perf");
+		zbx_json_adduint64(json, "requests", vmware_stats.perf.requests);
+		zbx_json_adduint64(json, "bytes", vmware_stats.perf.bytes);
+		zbx_json_addfloat(json, "time_total", vmware_stats.perf.time_total);
+		zbx_json_addfloat(json, "time_transfer", vmware_stats.perf.time_transfer);
+		zbx_json_addfloat(json, "time_parse", vmware_stats.perf.time_parse);
+		zbx_json_close(json);
+
 		zbx_json_close(json);
 	}
 }
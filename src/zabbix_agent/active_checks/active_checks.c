@@ -282,6 +282,7 @@ static void	add_check(const char *key, zbx_uint64_t itemid, const char *delay, z
 			metric->logfiles_num = 0;
 			metric->start_time = 0.0;
 			metric->processed_bytes = 0;
+			metric->watch_revision = 0;
 #if !defined(_WINDOWS) && !defined(__MINGW32__)
 			if (NULL != metric->persistent_file_name)
 			{
@@ -341,6 +342,7 @@ static void	add_check(const char *key, zbx_uint64_t itemid, const char *delay, z
 	metric->error_count = 0;
 	metric->logfiles_num = 0;
 	metric->logfiles = NULL;
+	metric->watch_revision = 0;
 	metric->flags = ZBX_METRIC_FLAG_NEW;
 
 	if ('l' == metric->key[0] && 'o' == metric->key[1] && 'g' == metric->key[2])
@@ -1893,6 +1895,17 @@ ZBX_THREAD_ENTRY(active_checks_thread, args)
 #endif
 	init_active_metrics(activechks_args_in->config_buffer_size);
 
+	if (1 == activechks_args_in->config_log_file_watch)
+	{
+		char	*error = NULL;
+
+		if (SUCCEED != zbx_logfiles_watch_init(&error))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot start tracking changes of log files: %s", error);
+			zbx_free(error);
+		}
+	}
+
 #ifndef _WINDOWS
 	zbx_set_sigusr_handler(zbx_active_checks_sigusr_handler);
 #endif
@@ -2014,6 +2027,7 @@ ZBX_THREAD_ENTRY(active_checks_thread, args)
 		}
 	}
 
+	zbx_logfiles_watch_destroy();
 	zbx_free(session_token);
 
 #ifdef _WINDOWS
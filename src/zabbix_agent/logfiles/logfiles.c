@@ -32,6 +32,10 @@
 #	include "zbxlog.h"
 #endif /* _WINDOWS */
 
+#if defined(HAVE_SYS_INOTIFY_H) && defined(HAVE_SYS_VFS_H)
+#	include <sys/inotify.h>
+#endif
+
 #define MAX_LEN_MD5	512	/* maximum size of the first and the last blocks of the file to calculate MD5 sum for */
 
 #define ZBX_SAME_FILE_ERROR	-1
@@ -1969,6 +1973,47 @@ static void	log_regexp_runtime_error(const char *key, const char *err_msg, zbx_u
 		zabbix_log(LOG_LEVEL_WARNING, "itemid " ZBX_FS_UI64 ": regexp runtime error: %s", itemid, err_msg);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: matches log record against regular expression                     *
+ *                                                                            *
+ * Parameters: regexps         - [IN] vector of global regular expressions    *
+ *             value           - [IN] log record                              *
+ *             pattern         - [IN] pattern to match                        *
+ *             literal         - [IN] string required by pattern or NULL      *
+ *             pattern_checked - [IN/OUT] 1 - pattern was compiled            *
+ *                                        successfully before                 *
+ *             output_template - [IN] output formatting template              *
+ *             output          - [OUT] formatted output value                 *
+ *             err_msg         - [OUT] error message                          *
+ *                                                                            *
+ * Return value: ZBX_REGEXP_MATCH, ZBX_REGEXP_NO_MATCH,                       *
+ *               ZBX_REGEXP_COMPILE_FAIL or ZBX_REGEXP_RUNTIME_FAIL           *
+ *                                                                            *
+ * Comments: Records without the literal string required by pattern are       *
+ *           rejected without running regular expression. The pattern is      *
+ *           always used for the first record to report invalid patterns.     *
+ *                                                                            *
+ *           Thread-safe                                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	match_log_record(const zbx_vector_expression_t *regexps, const char *value, const char *pattern,
+		const char *literal, int *pattern_checked, const char *output_template, char **output, char **err_msg)
+{
+	int	ret;
+
+	if (NULL != literal && 0 != *pattern_checked && NULL == strstr(value, literal))
+		return ZBX_REGEXP_NO_MATCH;
+
+	if (ZBX_REGEXP_COMPILE_FAIL != (ret = zbx_regexp_sub_ex2(regexps, value, pattern, ZBX_CASE_SENSITIVE,
+			output_template, output, err_msg)))
+	{
+		*pattern_checked = 1;
+	}
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Comments: Thread-safe                                                      *
@@ -1985,9 +2030,9 @@ static int	zbx_read2(int fd, unsigned char flags, struct st_logfile *logfile, zb
 {
 	static ZBX_THREAD_LOCAL char	*buf = NULL;
 
-	int				ret, nbytes;
+	int				ret, nbytes, pattern_checked = 0;
 	const char			*cr, *lf, *p_end;
-	char				*p_start, *p, *p_nl, *p_next, *item_value = NULL;
+	char				*p_start, *p, *p_nl, *p_next, *item_value = NULL, *literal = NULL;
 	size_t				szbyte;
 	zbx_offset_t			offset;
 	const int			is_count_item = (0 != (ZBX_METRIC_FLAG_LOG_COUNT & flags)) ? 1 : 0;
@@ -2009,6 +2054,10 @@ static int	zbx_read2(int fd, unsigned char flags, struct st_logfile *logfile, zb
 
 	zbx_find_cr_lf_szbyte(encoding, &cr, &lf, &szbyte);
 
+	/* most log records usually do not match, look for a string required by the pattern before matching */
+	if (NULL != pattern && '@' != *pattern)
+		literal = zbx_regexp_get_literal(pattern);
+
 	for (;;)
 	{
 		if (0 >= *p_count || 0 >= *s_count)
@@ -2096,8 +2145,8 @@ static int	zbx_read2(int fd, unsigned char flags, struct st_logfile *logfile, zb
 					processed_size = (size_t)offset + (size_t)nbytes;
 					send_err = FAIL;
 
-					regexp_ret = zbx_regexp_sub_ex2(regexps, value, pattern, ZBX_CASE_SENSITIVE,
-							(0 == is_count_item) ? output_template : NULL,
+					regexp_ret = match_log_record(regexps, value, pattern, literal,
+							&pattern_checked, (0 == is_count_item) ? output_template : NULL,
 							(0 == is_count_item) ? &item_value : NULL, err_msg);
 #if !defined(_WINDOWS) && !defined(__MINGW32__)
 					if (NULL != persistent_file_name && (ZBX_REGEXP_MATCH == regexp_ret ||
@@ -2234,8 +2283,8 @@ static int	zbx_read2(int fd, unsigned char flags, struct st_logfile *logfile, zb
 					processed_size = (size_t)offset + (size_t)(p_next - buf);
 					send_err = FAIL;
 
-					regexp_ret = zbx_regexp_sub_ex2(regexps, value, pattern, ZBX_CASE_SENSITIVE,
-							(0 == is_count_item) ? output_template : NULL,
+					regexp_ret = match_log_record(regexps, value, pattern, literal,
+							&pattern_checked, (0 == is_count_item) ? output_template : NULL,
 							(0 == is_count_item) ? &item_value : NULL, err_msg);
 #if !defined(_WINDOWS) && !defined(__MINGW32__)
 					if (NULL != persistent_file_name && (ZBX_REGEXP_MATCH == regexp_ret ||
@@ -2357,6 +2406,8 @@ static int	zbx_read2(int fd, unsigned char flags, struct st_logfile *logfile, zb
 		}
 	}
 out:
+	zbx_free(literal);
+
 	return ret;
 
 #undef BUF_SIZE
@@ -3636,6 +3687,444 @@ out:
 	return ret;
 }
 
+#if defined(HAVE_SYS_INOTIFY_H) && defined(HAVE_SYS_VFS_H)
+#define ZBX_LOGFILES_WATCH_EVENTS	(IN_MODIFY | IN_ATTRIB | IN_CREATE | IN_DELETE | IN_MOVED_FROM | \
+		IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+#define ZBX_LOGFILES_WATCH_REFRESH	SEC_PER_MIN	/* max time a watched directory is considered unchanged */
+#define ZBX_LOGFILES_WATCH_TTL		SEC_PER_HOUR	/* remove watches not used by any item this long */
+
+/* directory name, can be shared by several items, several names can refer to the same watch */
+typedef struct
+{
+	char	*path;
+	int	wd;		/* watch descriptor or -1 if directory cannot be watched */
+	time_t	expires;
+}
+zbx_logfiles_watch_path_t;
+
+/* inotify watch of directory, revision is changed on every event in the directory */
+typedef struct
+{
+	int		wd;
+	int		paths_num;
+	zbx_uint64_t	revision;
+	time_t		nextrefresh;
+}
+zbx_logfiles_watch_t;
+
+typedef struct
+{
+	int		fd;
+	zbx_uint64_t	revision;
+	time_t		nextclean;
+	zbx_hashset_t	paths;
+	zbx_hashset_t	watches;
+}
+zbx_logfiles_watch_tracker_t;
+
+/* Log file change tracker is used by active checks of C agent only. Active checks are processed */
+/* by a single thread in each process therefore the tracker is not protected by locks.          */
+static zbx_logfiles_watch_tracker_t	*tracker = NULL;
+
+/* file systems where all changes are made through local kernel and reported by inotify */
+static const unsigned long	local_fs_types[] = {
+	0xEF53,		/* ext2, ext3, ext4 */
+	0x58465342,	/* xfs */
+	0x9123683E,	/* btrfs */
+	0x01021994,	/* tmpfs */
+	0x794C7630,	/* overlayfs */
+	0x2FC12FC1,	/* zfs */
+	0xF2F52010,	/* f2fs */
+	0x52654973,	/* reiserfs */
+	0x3153464A,	/* jfs */
+	0
+};
+
+static zbx_hash_t	logfiles_watch_hash_func(const void *data)
+{
+	const zbx_logfiles_watch_t	*watch = (const zbx_logfiles_watch_t *)data;
+
+	return ZBX_DEFAULT_HASH_ALGO(&watch->wd, sizeof(watch->wd), ZBX_DEFAULT_HASH_SEED);
+}
+
+static int	logfiles_watch_compare_func(const void *d1, const void *d2)
+{
+	const zbx_logfiles_watch_t	*watch1 = (const zbx_logfiles_watch_t *)d1;
+	const zbx_logfiles_watch_t	*watch2 = (const zbx_logfiles_watch_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(watch1->wd, watch2->wd);
+
+	return 0;
+}
+
+static void	logfiles_watch_path_clean(zbx_logfiles_watch_path_t *path)
+{
+	zbx_free(path->path);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes directory watch and all names referring to it             *
+ *                                                                            *
+ * Parameters: wd        - [IN] watch descriptor                              *
+ *             rm_watch  - [IN] 1 - remove watch from inotify instance,       *
+ *                              0 - watch was already removed by kernel       *
+ *                                                                            *
+ ******************************************************************************/
+static void	logfiles_watch_remove(int wd, int rm_watch)
+{
+	zbx_hashset_iter_t		iter;
+	zbx_logfiles_watch_path_t	*path;
+	zbx_logfiles_watch_t		*watch, watch_local;
+
+	watch_local.wd = wd;
+
+	if (NULL == (watch = (zbx_logfiles_watch_t *)zbx_hashset_search(&tracker->watches, &watch_local)))
+		return;
+
+	zbx_hashset_iter_reset(&tracker->paths, &iter);
+	while (NULL != (path = (zbx_logfiles_watch_path_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (path->wd == wd)
+			zbx_hashset_iter_remove(&iter);
+	}
+
+	if (1 == rm_watch)
+		inotify_rm_watch(tracker->fd, wd);
+
+	zbx_hashset_remove_direct(&tracker->watches, watch);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads pending inotify events and updates revisions of watches     *
+ *          where changes took place                                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	logfiles_watch_read_events(void)
+{
+	zbx_uint64_t			buf[4096 / sizeof(zbx_uint64_t)];
+	ssize_t				n;
+	const struct inotify_event	*event;
+	zbx_logfiles_watch_t		*watch, watch_local;
+	zbx_hashset_iter_t		iter;
+
+	while (0 < (n = read(tracker->fd, buf, sizeof(buf))))
+	{
+		for (const char *ptr = (const char *)buf; ptr < (const char *)buf + n;
+				ptr += sizeof(struct inotify_event) + event->len)
+		{
+			event = (const struct inotify_event *)(const void *)ptr;
+
+			if (0 != (event->mask & IN_Q_OVERFLOW))
+			{
+				/* events were lost, assume that all watched directories have changed */
+				zbx_hashset_iter_reset(&tracker->watches, &iter);
+				while (NULL != (watch = (zbx_logfiles_watch_t *)zbx_hashset_iter_next(&iter)))
+					watch->revision = ++tracker->revision;
+
+				continue;
+			}
+
+			watch_local.wd = event->wd;
+
+			if (NULL == (watch = (zbx_logfiles_watch_t *)zbx_hashset_search(&tracker->watches,
+					&watch_local)))
+			{
+				continue;
+			}
+
+			if (0 != (event->mask & IN_IGNORED))
+				logfiles_watch_remove(event->wd, 0);
+			else if (0 != (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)))
+				logfiles_watch_remove(event->wd, 1);
+			else
+				watch->revision = ++tracker->revision;
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if directory resides on file system where inotify reports  *
+ *          all changes                                                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	logfiles_watch_is_local_fs(const char *directory)
+{
+	struct statfs	buf;
+
+	if (0 != statfs(directory, &buf))
+		return FAIL;
+
+	for (int i = 0; 0 != local_fs_types[i]; i++)
+	{
+		if ((unsigned long)buf.f_type == local_fs_types[i])
+			return SUCCEED;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "directory \"%s\" resides on file system 0x%lx which is not tracked for changes",
+			directory, (unsigned long)buf.f_type);
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns revision of log file directory, starts watching the       *
+ *          directory if necessary                                            *
+ *                                                                            *
+ * Parameters: directory - [IN] directory where log files reside              *
+ *             revision  - [OUT] revision, changes when anything in directory *
+ *                               changes                                      *
+ *                                                                            *
+ * Return value: SUCCEED - the directory is watched                           *
+ *               FAIL    - changes in the directory cannot be tracked         *
+ *                                                                            *
+ ******************************************************************************/
+static int	logfiles_watch_get_revision(const char *directory, zbx_uint64_t *revision)
+{
+	zbx_logfiles_watch_path_t	*path, path_local;
+	zbx_logfiles_watch_t		*watch, watch_local;
+	time_t				now;
+
+	logfiles_watch_read_events();
+
+	now = time(NULL);
+
+	if (now >= tracker->nextclean)
+	{
+		zbx_hashset_iter_t	iter;
+
+		zbx_hashset_iter_reset(&tracker->paths, &iter);
+		while (NULL != (path = (zbx_logfiles_watch_path_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (now < path->expires)
+				continue;
+
+			watch_local.wd = path->wd;
+
+			if (NULL != (watch = (zbx_logfiles_watch_t *)zbx_hashset_search(&tracker->watches,
+					&watch_local)) && 0 == --watch->paths_num)
+			{
+				inotify_rm_watch(tracker->fd, watch->wd);
+				zbx_hashset_remove_direct(&tracker->watches, watch);
+			}
+
+			zbx_hashset_iter_remove(&iter);
+		}
+
+		tracker->nextclean = now + ZBX_LOGFILES_WATCH_TTL;
+	}
+
+	path_local.path = (char *)directory;
+
+	if (NULL != (path = (zbx_logfiles_watch_path_t *)zbx_hashset_search(&tracker->paths, &path_local)) &&
+			-1 == path->wd && now >= path->expires)
+	{
+		zbx_hashset_remove_direct(&tracker->paths, path);
+		path = NULL;
+	}
+
+	if (NULL == path)
+	{
+		path_local.path = zbx_strdup(NULL, directory);
+		path_local.wd = -1;
+		path_local.expires = now + ZBX_LOGFILES_WATCH_REFRESH;
+
+		if (SUCCEED == logfiles_watch_is_local_fs(directory))
+		{
+			if (-1 == (path_local.wd = inotify_add_watch(tracker->fd, directory,
+					ZBX_LOGFILES_WATCH_EVENTS)))
+			{
+				zabbix_log(LOG_LEVEL_DEBUG, "cannot watch directory \"%s\": %s", directory,
+						zbx_strerror(errno));
+			}
+		}
+
+		path = (zbx_logfiles_watch_path_t *)zbx_hashset_insert(&tracker->paths, &path_local,
+				sizeof(path_local));
+
+		if (-1 != path->wd)
+		{
+			/* several names of the same directory share the same watch */
+			watch_local.wd = path->wd;
+
+			if (NULL == (watch = (zbx_logfiles_watch_t *)zbx_hashset_search(&tracker->watches,
+					&watch_local)))
+			{
+				watch_local.paths_num = 0;
+				watch_local.revision = ++tracker->revision;
+				watch_local.nextrefresh = now + ZBX_LOGFILES_WATCH_REFRESH;
+
+				watch = (zbx_logfiles_watch_t *)zbx_hashset_insert(&tracker->watches, &watch_local,
+						sizeof(watch_local));
+			}
+
+			watch->paths_num++;
+		}
+	}
+
+	if (-1 == path->wd)
+		return FAIL;
+
+	path->expires = now + ZBX_LOGFILES_WATCH_TTL;
+
+	watch_local.wd = path->wd;
+
+	if (NULL == (watch = (zbx_logfiles_watch_t *)zbx_hashset_search(&tracker->watches, &watch_local)))
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		return FAIL;
+	}
+
+	/* events can be missed in rare cases (e.g. writes through memory mapping or hard links in other */
+	/* directories), limit for how long the directory can be considered unchanged */
+	if (now >= watch->nextrefresh)
+	{
+		watch->revision = ++tracker->revision;
+		watch->nextrefresh = now + ZBX_LOGFILES_WATCH_REFRESH;
+	}
+
+	*revision = watch->revision;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets revision of directory where log files of item reside         *
+ *                                                                            *
+ * Parameters: flags     - [IN] bit flags with item type: log, logrt, ...     *
+ *             filename  - [IN] log file name or regular expression           *
+ *             revision  - [OUT] directory revision                           *
+ *                                                                            *
+ * Return value: SUCCEED - the directory is watched                           *
+ *               FAIL    - changes in the directory cannot be tracked         *
+ *                                                                            *
+ ******************************************************************************/
+static int	logfiles_watch_get_item_revision(unsigned char flags, const char *filename, zbx_uint64_t *revision)
+{
+	char	*directory = NULL, *filename_regexp = NULL, *err_msg = NULL;
+	int	ret = FAIL;
+
+	if (NULL == tracker)
+		return FAIL;
+
+	if (0 != (ZBX_METRIC_FLAG_LOG_LOG & flags))
+	{
+		const char	*separator;
+
+		if (NULL == (separator = strrchr(filename, ZBX_PATH_SEPARATOR)))
+			return FAIL;
+
+		directory = zbx_malloc(NULL, (size_t)(separator - filename) + 2);
+		memcpy(directory, filename, (size_t)(separator - filename) + 1);
+		directory[separator - filename + 1] = '\0';
+	}
+	else if (SUCCEED != split_filename(filename, &directory, &filename_regexp, &err_msg))
+	{
+		zbx_free(err_msg);
+		return FAIL;
+	}
+
+	ret = logfiles_watch_get_revision(directory, revision);
+
+	zbx_free(filename_regexp);
+	zbx_free(directory);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if log file list describes completely analyzed files that  *
+ *          will not change without inotify events in their directory         *
+ *                                                                            *
+ ******************************************************************************/
+static int	logfiles_watch_is_settled(const struct st_logfile *logfiles, int logfiles_num)
+{
+	if (0 == logfiles_num)
+		return FAIL;
+
+	for (int i = 0; i < logfiles_num; i++)
+	{
+		zbx_stat_t	buf;
+
+		if (logfiles[i].processed_size != logfiles[i].size || 0 != logfiles[i].retry)
+			return FAIL;
+
+		/* changes of symbolic link targets are reported in directory of target */
+		if (0 != lstat(logfiles[i].filename, &buf) || 0 != S_ISLNK(buf.st_mode))
+			return FAIL;
+	}
+
+	return SUCCEED;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: starts tracking changes of log file directories to skip analysis  *
+ *          of log files when nothing has changed                             *
+ *                                                                            *
+ * Parameters: error - [OUT] error message                                    *
+ *                                                                            *
+ * Return value: SUCCEED - tracking was started                               *
+ *               FAIL    - tracking is not supported or cannot be started     *
+ *                                                                            *
+ * Comments: Not thread-safe, must be called by process doing active checks.  *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_logfiles_watch_init(char **error)
+{
+#if defined(HAVE_SYS_INOTIFY_H) && defined(HAVE_SYS_VFS_H)
+	int	fd;
+
+	if (NULL != tracker)
+		return SUCCEED;
+
+	if (-1 == (fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)))
+	{
+		*error = zbx_dsprintf(*error, "cannot initialize inotify: %s", zbx_strerror(errno));
+		return FAIL;
+	}
+
+	tracker = (zbx_logfiles_watch_tracker_t *)zbx_malloc(NULL, sizeof(zbx_logfiles_watch_tracker_t));
+	tracker->fd = fd;
+	tracker->revision = 0;
+	tracker->nextclean = time(NULL) + ZBX_LOGFILES_WATCH_TTL;
+
+	zbx_hashset_create_ext(&tracker->paths, 0, ZBX_DEFAULT_STRING_PTR_HASH_FUNC, ZBX_DEFAULT_STR_COMPARE_FUNC,
+			(zbx_clean_func_t)logfiles_watch_path_clean, ZBX_DEFAULT_MEM_MALLOC_FUNC,
+			ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+	zbx_hashset_create(&tracker->watches, 0, logfiles_watch_hash_func, logfiles_watch_compare_func);
+
+	return SUCCEED;
+#else
+	*error = zbx_strdup(*error, "log file change tracking is not supported on this platform");
+	return FAIL;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: stops tracking changes of log file directories                    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_logfiles_watch_destroy(void)
+{
+#if defined(HAVE_SYS_INOTIFY_H) && defined(HAVE_SYS_VFS_H)
+	if (NULL == tracker)
+		return;
+
+	close(tracker->fd);
+	zbx_hashset_destroy(&tracker->paths);
+	zbx_hashset_destroy(&tracker->watches);
+	zbx_free(tracker);
+#endif
+}
+
 static int	check_number_of_parameters(unsigned char flags, const AGENT_REQUEST *request, char **error)
 {
 	int	parameter_num, max_parameter_num;
@@ -3843,11 +4332,16 @@ int	process_log_check(zbx_vector_addr_ptr_t *addrs, zbx_vector_ptr_t *agent2_res
 	const char			*filename, *regexp, *encoding, *skip, *output_template;
 	char				*encoding_uc = NULL;
 	int				max_lines_per_sec, ret = FAIL, s_count, p_count, s_count_orig, is_count_item,
-					mtime_orig, big_rec_orig, logfiles_num_new = 0, jumped = 0, delay;
+					mtime_orig, big_rec_orig, logfiles_num_new = 0, jumped = 0, delay,
+					unchanged = 0;
 	zbx_log_rotation_options_t	rotation_type;
 	zbx_uint64_t			lastlogsize_orig;
 	float				max_delay;
 	struct st_logfile		*logfiles_new = NULL;
+#if defined(HAVE_SYS_INOTIFY_H) && defined(HAVE_SYS_VFS_H)
+	zbx_uint64_t			watch_revision = 0;
+	int				settled = 0;
+#endif
 
 	if (0 != (ZBX_METRIC_FLAG_LOG_COUNT & metric->flags))
 		is_count_item = 1;
@@ -4067,13 +4561,45 @@ int	process_log_check(zbx_vector_addr_ptr_t *addrs, zbx_vector_ptr_t *agent2_res
 		}
 	}
 #endif
-	ret = process_logrt(metric->flags, filename, &metric->lastlogsize, &metric->mtime, lastlogsize_sent, mtime_sent,
-			&metric->skip_old_data, &metric->big_rec, &metric->use_ino, error, &metric->logfiles,
-			metric->logfiles_num, &logfiles_new, &logfiles_num_new, encoding, regexps, regexp,
-			output_template, &p_count, &s_count, process_value_cb, addrs, agent2_result, config_hostname,
-			metric->key, &jumped, max_delay, &metric->start_time, &metric->processed_bytes,
-			rotation_type, metric->persistent_file_name, prep_vec, config_tls, config_timeout,
-			config_source_ip, metric->itemid, config_buffer_send, config_buffer_size);
+#if defined(HAVE_SYS_INOTIFY_H) && defined(HAVE_SYS_VFS_H)
+	/* Revision must be obtained before analyzing log files so that changes made during analysis are */
+	/* noticed in the next check. If nothing has changed in the directory since all log files were   */
+	/* analyzed to the end then there is nothing to do - the file list and MD5 sums are still valid. */
+	if (SUCCEED == logfiles_watch_get_item_revision(metric->flags, filename, &watch_revision) &&
+			watch_revision == metric->watch_revision && 0 == metric->skip_old_data &&
+			0 == metric->big_rec && 0 != metric->logfiles_num)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "%s(): item \"%s\": log file directory has not changed", __func__,
+				metric->key);
+		unchanged = 1;
+	}
+#endif
+	if (0 != unchanged)
+	{
+		/* keep the current log file list, there are no new records */
+		metric->processed_bytes = 0;
+		ret = SUCCEED;
+	}
+	else
+	{
+		ret = process_logrt(metric->flags, filename, &metric->lastlogsize, &metric->mtime, lastlogsize_sent,
+				mtime_sent, &metric->skip_old_data, &metric->big_rec, &metric->use_ino, error,
+				&metric->logfiles, metric->logfiles_num, &logfiles_new, &logfiles_num_new, encoding,
+				regexps, regexp, output_template, &p_count, &s_count, process_value_cb, addrs,
+				agent2_result, config_hostname, metric->key, &jumped, max_delay, &metric->start_time,
+				&metric->processed_bytes, rotation_type, metric->persistent_file_name, prep_vec,
+				config_tls, config_timeout, config_source_ip, metric->itemid, config_buffer_send,
+				config_buffer_size);
+	}
+#if defined(HAVE_SYS_INOTIFY_H) && defined(HAVE_SYS_VFS_H)
+	/* the directory can be considered unchanged in the next check only if all log files were analyzed */
+	if (0 != watch_revision && SUCCEED == ret && (0 != unchanged || (0 == jumped && 0 < p_count &&
+			0 < s_count && 0 == metric->big_rec &&
+			SUCCEED == logfiles_watch_is_settled(logfiles_new, logfiles_num_new))))
+	{
+		settled = 1;
+	}
+#endif
 
 	if (0 == is_count_item && NULL != logfiles_new)
 	{
@@ -4113,9 +4639,12 @@ int	process_log_check(zbx_vector_addr_ptr_t *addrs, zbx_vector_ptr_t *agent2_res
 				*mtime_sent = metric->mtime;
 
 				/* switch to the new log file list */
-				destroy_logfile_list(&metric->logfiles, NULL, &metric->logfiles_num);
-				metric->logfiles = logfiles_new;
-				metric->logfiles_num = logfiles_num_new;
+				if (0 == unchanged)
+				{
+					destroy_logfile_list(&metric->logfiles, NULL, &metric->logfiles_num);
+					metric->logfiles = logfiles_new;
+					metric->logfiles_num = logfiles_num_new;
+				}
 			}
 			else
 			{
@@ -4128,6 +4657,10 @@ int	process_log_check(zbx_vector_addr_ptr_t *addrs, zbx_vector_ptr_t *agent2_res
 
 				/* the old log file list 'metric->logfiles' stays in its place, drop the new list */
 				destroy_logfile_list(&logfiles_new, NULL, &logfiles_num_new);
+#if defined(HAVE_SYS_INOTIFY_H) && defined(HAVE_SYS_VFS_H)
+				if (0 == unchanged)
+					settled = 0;
+#endif
 			}
 		}
 	}
@@ -4157,6 +4690,9 @@ int	process_log_check(zbx_vector_addr_ptr_t *addrs, zbx_vector_ptr_t *agent2_res
 			ret = SUCCEED;
 		}
 	}
+#if defined(HAVE_SYS_INOTIFY_H) && defined(HAVE_SYS_VFS_H)
+	metric->watch_revision = (0 != settled ? watch_revision : 0);
+#endif
 out:
 	zbx_free(encoding_uc);
 	zbx_free_agent_request(&request);
@@ -108,5 +108,8 @@ int	process_log_check(zbx_vector_addr_ptr_t *addrs, zbx_vector_ptr_t *agent2_res
 		const char *config_hostname, int config_buffer_send, int config_buffer_size,
 		int config_max_lines_per_second);
 
+int	zbx_logfiles_watch_init(char **error);
+void	zbx_logfiles_watch_destroy(void);
+
 struct st_logfile	*find_last_processed_file_in_logfiles_list(struct st_logfile *logfiles, int logfiles_num);
 #endif
@@ -50,6 +50,7 @@ static int	zbx_config_buffer_size = 100;
 static int	zbx_config_buffer_send = 5;
 static int	zbx_config_max_lines_per_second	= 20;
 static int	zbx_config_eventlog_max_lines_per_second = 20;
+static int	zbx_config_log_file_watch = 0;
 static char	*config_load_module_path = NULL;
 static char	**config_aliases = NULL;
 static char	**config_load_module = NULL;
@@ -846,6 +847,7 @@ static int	add_serveractive_host_cb(const zbx_vector_addr_ptr_t *addrs, zbx_vect
 		config_active_args[forks].config_eventlog_max_lines_per_second =
 				zbx_config_eventlog_max_lines_per_second;
 		config_active_args[forks].config_max_lines_per_second = zbx_config_max_lines_per_second;
+		config_active_args[forks].config_log_file_watch = zbx_config_log_file_watch;
 		config_active_args[forks].config_refresh_active_checks = zbx_config_refresh_active_checks;
 		config_active_args[forks].config_user_parameters = zbx_config_user_parameters;
 	}
@@ -981,6 +983,8 @@ static void	zbx_load_config(int requirement, ZBX_TASK_EX *task)
 				MAX_ACTIVE_CHECKS_REFRESH_FREQUENCY},
 		{"MaxLinesPerSecond",		&zbx_config_max_lines_per_second,	ZBX_CFG_TYPE_INT,
 				ZBX_CONF_PARM_OPT,	1,			1000},
+		{"LogFileWatch",		&zbx_config_log_file_watch,		ZBX_CFG_TYPE_INT,
+				ZBX_CONF_PARM_OPT,	0,			1},
 		{"EnableRemoteCommands",	&parser_load_enable_remove_commands,	ZBX_CFG_TYPE_CUSTOM,
 				ZBX_CONF_PARM_OPT,	0,			1},
 		{"LogRemoteCommands",		&zbx_config_log_remote_commands,	ZBX_CFG_TYPE_INT,
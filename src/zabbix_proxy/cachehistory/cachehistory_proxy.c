@@ -374,13 +374,9 @@ void	zbx_sync_proxy_history(int *values_num, int *triggers_num, const zbx_events
 	{
 		*more = ZBX_SYNC_DONE;
 
-		zbx_dbcache_lock();
-
 		zbx_hc_pop_items(&history_items);		/* select and take items out of history cache */
 		history_num = history_items.values_num;
 
-		zbx_dbcache_unlock();
-
 		if (0 == history_num)
 			break;
 
@@ -399,10 +395,10 @@ void	zbx_sync_proxy_history(int *values_num, int *triggers_num, const zbx_events
 			while (ZBX_DB_DOWN == (txn_rc = zbx_db_commit()));
 		}
 
-		zbx_dbcache_lock();
-
 		zbx_hc_push_items(&history_items);	/* return items to history cache */
 
+		zbx_dbcache_lock();
+
 		if (ZBX_DB_FAIL != txn_rc)
 		{
 			if (0 != item_diff.values_num)
@@ -116,6 +116,8 @@ static const char	*help_message[] = {
 	"                                   target is not specified",
 	"      " ZBX_PROF_DISABLE "=target        Disable profiling, affects all processes if",
 	"                                   target is not specified",
+	"      " ZBX_PROF_DUMP "=target           Log profiling latency histograms in JSON format,",
+	"                                   affects all processes if target is not specified",
 	"",
 	"      Log level control targets:",
 	"        process-type             All processes of specified type",
@@ -272,6 +274,7 @@ static int	config_vmware_perf_frequency	= 60;
 static int	config_vmware_timeout		= 10;
 
 static zbx_uint64_t	config_conf_cache_size		= 8 * ZBX_MEBIBYTE;
+static char		*config_cache_snapshot_file	= NULL;
 static zbx_uint64_t	config_history_cache_size	= 16 * ZBX_MEBIBYTE;
 static zbx_uint64_t	config_history_index_cache_size	= 4 * ZBX_MEBIBYTE;
 static zbx_uint64_t	config_trends_cache_size	= 0;
@@ -280,6 +283,7 @@ static zbx_uint64_t	config_vmware_cache_size	= 8 * ZBX_MEBIBYTE;
 static int	config_unreachable_period		= 45;
 static int	config_unreachable_delay		= 15;
 static int	config_max_concurrent_checks_per_poller	= 1000;
+static int	config_cache_slabs			= 0;
 
 static int	config_log_level		= LOG_LEVEL_WARNING;
 
@@ -333,6 +337,7 @@ static char		*config_proxy_buffer_mode_str = NULL;
 static int		config_proxy_buffer_mode	= 0;
 static zbx_uint64_t	config_proxy_memory_buffer_size	= 0;
 static int		config_proxy_memory_buffer_age	= 0;
+static char		*config_proxy_file_buffer_dir	= NULL;
 
 /* proxy has no any events processing */
 static const zbx_events_funcs_t	events_cbs = {
@@ -757,7 +762,7 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 		err = 1;
 	}
 
-	if (ZBX_PB_MODE_DISK != config_proxy_buffer_mode)
+	if (ZBX_PB_MODE_MEMORY == config_proxy_buffer_mode || ZBX_PB_MODE_HYBRID == config_proxy_buffer_mode)
 	{
 		if (0 != config_proxy_local_buffer)
 		{
@@ -808,6 +813,29 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 		}
 	}
 
+	if (ZBX_PB_MODE_FILE == config_proxy_buffer_mode)
+	{
+		if (0 != config_proxy_local_buffer)
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "ProxyBufferMode configuration parameter cannot be set to"
+					" \"file\" when ProxyLocalBuffer parameter is set");
+			err = 1;
+		}
+
+		if (NULL == config_proxy_file_buffer_dir)
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "ProxyFileBufferDir configuration parameter must be set when"
+					" ProxyBufferMode parameter is set to \"file\"");
+			err = 1;
+		}
+	}
+	else if (NULL != config_proxy_file_buffer_dir)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "ProxyFileBufferDir configuration parameter can be set only"
+				" when ProxyBufferMode is set to \"file\"");
+		err = 1;
+	}
+
 	if (ZBX_PB_MODE_HYBRID != config_proxy_buffer_mode)
 	{
 		if (0 != config_proxy_memory_buffer_age)
@@ -890,9 +918,13 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 				ZBX_CONF_PARM_OPT,	0,			0},
 		{"StartSNMPTrapper",		&config_forks[ZBX_PROCESS_TYPE_SNMPTRAPPER],
 											ZBX_CFG_TYPE_INT,
-				ZBX_CONF_PARM_OPT,	0,			1},
+				ZBX_CONF_PARM_OPT,	0,			100},
 		{"CacheSize",			&config_conf_cache_size,		ZBX_CFG_TYPE_UINT64,
 				ZBX_CONF_PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(64) * ZBX_GIBIBYTE},
+		{"CacheSnapshotFile",		&config_cache_snapshot_file,		ZBX_CFG_TYPE_STRING,
+				ZBX_CONF_PARM_OPT,	0,			0},
+		{"CacheSlabAllocation",		&config_cache_slabs,			ZBX_CFG_TYPE_INT,
+				ZBX_CONF_PARM_OPT,	0,			1},
 		{"HistoryCacheSize",		&config_history_cache_size,		ZBX_CFG_TYPE_UINT64,
 				ZBX_CONF_PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"HistoryIndexCacheSize",	&config_history_index_cache_size,	ZBX_CFG_TYPE_UINT64,
@@ -994,6 +1026,9 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 		{"DBTLSCipher13",		&(zbx_config_dbhigh->config_db_tls_cipher_13),
 											ZBX_CFG_TYPE_STRING,
 				ZBX_CONF_PARM_OPT,	0,			0},
+		{"DBBulkCopy",			&(zbx_config_dbhigh->config_db_bulk_copy),
+											ZBX_CFG_TYPE_INT,
+				ZBX_CONF_PARM_OPT,	0,			1},
 		{"SSHKeyLocation",		&config_ssh_key_location,		ZBX_CFG_TYPE_STRING,
 				ZBX_CONF_PARM_OPT,	0,			0},
 		{"LogSlowQueries",		&config_log_slow_queries,		ZBX_CFG_TYPE_INT,
@@ -1076,6 +1111,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 				ZBX_CONF_PARM_OPT,	0,			SEC_PER_DAY * 10},
 		{"ProxyBufferMode",		&config_proxy_buffer_mode_str,		ZBX_CFG_TYPE_STRING,
 				ZBX_CONF_PARM_OPT,	0,			0},
+		{"ProxyFileBufferDir",		&config_proxy_file_buffer_dir,		ZBX_CFG_TYPE_STRING,
+				ZBX_CONF_PARM_OPT,	0,			0},
 		{"StartHTTPAgentPollers",	&config_forks[ZBX_PROCESS_TYPE_HTTPAGENT_POLLER],
 											ZBX_CFG_TYPE_INT,
 				ZBX_CONF_PARM_OPT,	0,			1000},
@@ -1526,7 +1563,9 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 	zbx_thread_vmware_args			vmware_args = {zbx_config_source_ip, config_vmware_frequency,
 								config_vmware_perf_frequency, config_vmware_timeout};
 	zbx_thread_snmptrapper_args		snmptrapper_args = {.config_snmptrap_file = zbx_config_snmptrap_file,
-								.config_ha_node_name = NULL};
+								.config_ha_node_name = NULL,
+								.workers_num =
+								config_forks[ZBX_PROCESS_TYPE_SNMPTRAPPER]};
 
 	zbx_rtc_process_request_ex_func_t	rtc_process_request_func = NULL;
 
@@ -1646,7 +1685,8 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 	zbx_unblock_signals(&orig_mask);
 
 	if (SUCCEED != zbx_init_database_cache(get_zbx_program_type, zbx_sync_proxy_history, config_history_cache_size,
-			config_history_index_cache_size, &config_trends_cache_size, &error))
+			config_history_index_cache_size, &config_trends_cache_size,
+			config_forks[ZBX_PROCESS_TYPE_HISTSYNCER], config_cache_slabs, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize database cache: %s", error);
 		zbx_free(error);
@@ -1661,7 +1701,7 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 	}
 
 	if (SUCCEED != zbx_init_configuration_cache(get_zbx_program_type, get_config_forks, config_conf_cache_size,
-			config_hostname, &error))
+			config_hostname, config_cache_snapshot_file, config_cache_slabs, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize configuration cache: %s", error);
 		zbx_free(error);
@@ -1706,7 +1746,8 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 	}
 
 	if (FAIL == zbx_pb_create(config_proxy_buffer_mode, config_proxy_memory_buffer_size,
-			config_proxy_memory_buffer_age, config_proxy_offline_buffer * SEC_PER_HOUR, &error))
+			config_proxy_memory_buffer_age, config_proxy_offline_buffer * SEC_PER_HOUR,
+			config_proxy_file_buffer_dir, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize proxy buffer: %s", error);
 		zbx_free(error);
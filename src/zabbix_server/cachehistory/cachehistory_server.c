@@ -1188,6 +1188,27 @@ static void	DCmodule_sync_history(int history_float_num, int history_integer_num
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: accounts time spent in history synchronization stage              *
+ *                                                                            *
+ * Parameters: stage_time - [IN/OUT] the time spent in each stage             *
+ *             stage      - [IN] the finished stage                           *
+ *             ts_start   - [IN] the stage start time                         *
+ *                                                                            *
+ * Return value: the current time, which is start time of the next stage      *
+ *                                                                            *
+ ******************************************************************************/
+static double	sync_stage_finish(double *stage_time, int stage, double ts_start)
+{
+	double	ts_now;
+
+	ts_now = zbx_time();
+	stage_time[stage] += ts_now - ts_start;
+
+	return ts_now;
+}
+
 /***************************************************************************************
  *                                                                                     *
  * Purpose: Flushes history cache to database, processes triggers of flushed           *
@@ -1211,6 +1232,8 @@ static void	DCmodule_sync_history(int history_float_num, int history_integer_num
  *            a) history cache is empty or less than 10% of batch values were          *
  *               processed (the other items were locked by triggers)                   *
  *            b) less than 500 (full batch) timer triggers were processed              *
+ *           The time spent is accounted to synchronization stages so that stage       *
+ *           totals add up to the whole time spent in the sync loop.                   *
  *                                                                                     *
  ***************************************************************************************/
 void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_events_funcs_t *events_cbs,
@@ -1247,6 +1270,7 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 	unsigned char				*data = NULL;
 	size_t					data_alloc = 0, data_offset;
 	zbx_vector_connector_filter_t		connector_filters_history, connector_filters_events;
+	double					stage_time[ZBX_HC_SYNC_STAGE_COUNT] = {0}, ts_stage;
 
 	if (NULL == history_float && NULL != history_float_cbs)
 	{
@@ -1311,6 +1335,8 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 
 	item_retrieve_mode = 0 == zbx_has_export_dir() ? ZBX_ITEM_GET_SYNC : ZBX_ITEM_GET_SYNC_EXPORT;
 
+	ts_stage = zbx_time();
+
 	do
 	{
 		int			trends_num = 0, timers_num = 0, ret = SUCCEED;
@@ -1318,18 +1344,14 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 
 		*more = ZBX_SYNC_DONE;
 
-		zbx_dbcache_lock();
 		zbx_hc_pop_items(&history_items);		/* select and take items out of history cache */
-		zbx_dbcache_unlock();
 
 		if (0 != history_items.values_num)
 		{
 			if (0 == (history_num = zbx_dc_config_lock_triggers_by_history_items(&history_items,
 					&triggerids)))
 			{
-				zbx_dbcache_lock();
 				zbx_hc_push_items(&history_items);
-				zbx_dbcache_unlock();
 				zbx_vector_hc_item_ptr_clear(&history_items);
 			}
 		}
@@ -1377,7 +1399,11 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 					events_cbs->add_event_cb, &item_diff,
 					&inventory_values, compression_age, &proxy_subscriptions);
 
-			if (FAIL != (ret = DBmass_add_history(history, history_num, config_history_storage_pipelines)))
+			ts_stage = sync_stage_finish(stage_time, ZBX_HC_SYNC_STAGE_PREPARE, ts_stage);
+			ret = DBmass_add_history(history, history_num, config_history_storage_pipelines);
+			ts_stage = sync_stage_finish(stage_time, ZBX_HC_SYNC_STAGE_HISTORY, ts_stage);
+
+			if (FAIL != ret)
 			{
 				zbx_dc_config_items_apply_changes(&item_diff);
 				zbx_dc_mass_update_trends(history, history_num, &trends, &trends_num, compression_age);
@@ -1401,6 +1427,8 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 				}
 				while (ZBX_DB_DOWN == txn_error);
 
+				ts_stage = sync_stage_finish(stage_time, ZBX_HC_SYNC_STAGE_TRENDS, ts_stage);
+
 				do
 				{
 					if (0 == item_diff.values_num && 0 == inventory_values.values_num)
@@ -1423,6 +1451,8 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 					}
 				}
 				while (ZBX_DB_DOWN == txn_error);
+
+				ts_stage = sync_stage_finish(stage_time, ZBX_HC_SYNC_STAGE_ITEMS, ts_stage);
 			}
 
 			zbx_dc_close_user_macros(um_handle);
@@ -1433,6 +1463,8 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 			zbx_vector_inventory_value_ptr_clear_ext(&inventory_values, DCinventory_value_free);
 			zbx_vector_item_diff_ptr_clear_ext(&item_diff, zbx_item_diff_free);
 		}
+		else
+			ts_stage = sync_stage_finish(stage_time, ZBX_HC_SYNC_STAGE_PREPARE, ts_stage);
 
 		if (FAIL != ret)
 		{
@@ -1518,6 +1550,8 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 			zbx_vector_trigger_timer_ptr_clear(&trigger_timers);
 		}
 
+		ts_stage = sync_stage_finish(stage_time, ZBX_HC_SYNC_STAGE_TRIGGERS, ts_stage);
+
 		if (0 != proxy_subscriptions.values_num)
 		{
 			zbx_vector_uint64_pair_sort(&proxy_subscriptions, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
@@ -1527,8 +1561,9 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 
 		if (0 != history_num)
 		{
-			zbx_dbcache_lock();
 			zbx_hc_push_items(&history_items);	/* return items to history cache */
+
+			zbx_dbcache_lock();
 			zbx_dbcache_set_history_num(zbx_dbcache_get_history_num() - history_num);
 
 			if (0 != zbx_hc_queue_get_size())
@@ -1648,11 +1683,15 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 
 		zbx_vector_uint64_clear(&itemids);
 
+		ts_stage = sync_stage_finish(stage_time, ZBX_HC_SYNC_STAGE_EXPORT, ts_stage);
+
 		/* Exit from sync loop if we have spent too much time here.       */
 		/* This is done to allow syncer process to update its statistics. */
 	}
 	while (ZBX_SYNC_MORE == *more && ZBX_HC_SYNC_TIME_MAX >= time(NULL) - sync_start);
 
+	zbx_hc_add_sync_stage_time(stage_time);
+
 	zbx_free(items);
 	zbx_free(errcodes);
 	zbx_free(data);
@@ -1695,10 +1734,9 @@ int	zbx_hc_check_proxy(zbx_uint64_t proxyid)
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() proxyid:"ZBX_FS_UI64, __func__, proxyid);
 
-	zbx_dbcache_lock();
+	hc_pused = zbx_dbcache_get_hc_pused();
 
-	hc_pused = 100 * (double)(zbx_dbcache_get_hc_mem()->total_size - zbx_dbcache_get_hc_mem()->free_size) /
-			zbx_dbcache_get_hc_mem()->total_size;
+	zbx_dbcache_lock();
 
 	if (20 >= hc_pused)
 	{
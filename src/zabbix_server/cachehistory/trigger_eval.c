@@ -15,6 +15,7 @@
 #include "cachehistory_server.h"
 
 #include "zbxcacheconfig.h"
+#include "zbxcachehistory.h"
 #include "zbx_trigger_constants.h"
 #include "zbx_item_constants.h"
 #include "zbx_host_constants.h"
@@ -154,6 +155,59 @@ static void	func_clean(void *ptr)
 	zbx_variant_clear(&func->value);
 }
 
+/* function call with user macros expanded in parameters, used to share results between */
+/* functions that differ only by parameter macros                                      */
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	const char	*function;
+	char		*params;
+	zbx_timespec_t	timespec;
+	zbx_func_t	*func;
+}
+zbx_func_call_t;
+
+static zbx_hash_t	func_call_hash_func(const void *data)
+{
+	const zbx_func_call_t	*call = (const zbx_func_call_t *)data;
+	zbx_hash_t		hash;
+
+	hash = ZBX_DEFAULT_UINT64_HASH_FUNC(&call->itemid);
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(call->function, strlen(call->function), hash);
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(call->params, strlen(call->params), hash);
+	hash = ZBX_DEFAULT_HASH_ALGO(&call->timespec.sec, sizeof(call->timespec.sec), hash);
+	hash = ZBX_DEFAULT_HASH_ALGO(&call->timespec.ns, sizeof(call->timespec.ns), hash);
+
+	return hash;
+}
+
+static int	func_call_compare_func(const void *d1, const void *d2)
+{
+	const zbx_func_call_t	*call1 = (const zbx_func_call_t *)d1;
+	const zbx_func_call_t	*call2 = (const zbx_func_call_t *)d2;
+	int			ret;
+
+	ZBX_RETURN_IF_NOT_EQUAL(call1->itemid, call2->itemid);
+
+	if (0 != (ret = strcmp(call1->function, call2->function)))
+		return ret;
+
+	if (0 != (ret = strcmp(call1->params, call2->params)))
+		return ret;
+
+	ZBX_RETURN_IF_NOT_EQUAL(call1->timespec.sec, call2->timespec.sec);
+	ZBX_RETURN_IF_NOT_EQUAL(call1->timespec.ns, call2->timespec.ns);
+
+	return 0;
+}
+
+static void	func_call_clean(void *ptr)
+{
+	zbx_func_call_t	*call = (zbx_func_call_t *)ptr;
+
+	zbx_free(call->params);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: prepare hashset of functions to evaluate.                         *
@@ -230,19 +284,42 @@ static void	populate_function_items(const zbx_vector_uint64_t *functionids, zbx_
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() ifuncs_num:%d", __func__, ifuncs->num_data);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: evaluate functions of the trigger batch.                          *
+ *                                                                            *
+ * Parameters: funcs            - [IN/OUT] functions to evaluate, indexed by  *
+ *                                         itemid, name, parameter, timestamp *
+ *             history_itemids  - [IN] items retrieved when saving history    *
+ *             history_items    - [IN]                                        *
+ *             history_errcodes - [IN]                                        *
+ *             items            - [OUT] other items referenced by functions   *
+ *             items_err        - [OUT]                                       *
+ *             items_num        - [OUT]                                       *
+ *             evaluated_num    - [OUT] number of evaluated functions         *
+ *                                                                            *
+ * Comments: Functions with the same item, name and timestamp whose           *
+ *           parameters become equal after user macro expansion are           *
+ *           evaluated once and the result is copied to the others.           *
+ *                                                                            *
+ ******************************************************************************/
 static void	evaluate_item_functions(zbx_hashset_t *funcs, const zbx_vector_uint64_t *history_itemids,
 		const zbx_history_sync_item_t *history_items, const int *history_errcodes,
-		zbx_history_sync_item_t **items, int **items_err, int *items_num)
+		zbx_history_sync_item_t **items, int **items_err, int *items_num, int *evaluated_num)
 {
 	char			*error = NULL;
 	int			i;
 	zbx_func_t		*func;
 	zbx_vector_uint64_t	itemids;
 	zbx_hashset_iter_t	iter;
+	zbx_hashset_t		calls;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() funcs_num:%d", __func__, funcs->num_data);
 
 	zbx_vector_uint64_create(&itemids);
+	zbx_hashset_create_ext(&calls, (size_t)funcs->num_data, func_call_hash_func, func_call_compare_func,
+			func_call_clean, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+			ZBX_DEFAULT_MEM_FREE_FUNC);
 
 	zbx_hashset_iter_reset(funcs, &iter);
 	while (NULL != (func = (zbx_func_t *)zbx_hashset_iter_next(&iter)))
@@ -272,6 +349,7 @@ static void	evaluate_item_functions(zbx_hashset_t *funcs, const zbx_vector_uint6
 		const zbx_history_sync_item_t	*item;
 		char				*params;
 		zbx_dc_evaluate_item_t		evaluate_item;
+		zbx_func_call_t			*call, call_local;
 
 		/* avoid double copying from configuration cache if already retrieved when saving history */
 		if (FAIL != (i = zbx_vector_uint64_bsearch(history_itemids, func->itemid,
@@ -350,6 +428,22 @@ static void	evaluate_item_functions(zbx_hashset_t *funcs, const zbx_vector_uint6
 
 		params = zbx_dc_expand_user_macros_in_func_params(func->parameter, item->host.hostid);
 
+		call_local.itemid = func->itemid;
+		call_local.function = func->function;
+		call_local.params = params;
+		call_local.timespec = func->timespec;
+
+		if (NULL != (call = (zbx_func_call_t *)zbx_hashset_search(&calls, &call_local)))
+		{
+			zbx_variant_copy(&func->value, &call->func->value);
+			zbx_free(params);
+			continue;
+		}
+
+		call_local.func = func;
+		zbx_hashset_insert(&calls, &call_local, sizeof(call_local));
+		(*evaluated_num)++;
+
 		evaluate_item.itemid = item->itemid;
 		evaluate_item.value_type = item->value_type;
 		evaluate_item.proxyid = item->host.proxyid;
@@ -366,11 +460,10 @@ static void	evaluate_item_functions(zbx_hashset_t *funcs, const zbx_vector_uint6
 							item->key_orig, params, error));
 			zbx_free(error);
 		}
-
-		zbx_free(params);
 	}
 
 	zbx_vc_flush_stats();
+	zbx_hashset_destroy(&calls);
 	zbx_vector_uint64_destroy(&itemids);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -488,6 +581,8 @@ static void	substitute_functions(zbx_vector_dc_trigger_t *triggers, const zbx_ve
 {
 	zbx_vector_uint64_t	functionids;
 	zbx_hashset_t		ifuncs, funcs;
+	int			funcs_num = 0, evaluated_num = 0;
+	zbx_uint64_t		stats[ZBX_HC_TRIGGER_FUNCS_COUNT];
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -507,17 +602,25 @@ static void	substitute_functions(zbx_vector_dc_trigger_t *triggers, const zbx_ve
 
 	if (0 != ifuncs.num_data)
 	{
+		funcs_num = funcs.num_data;
 		evaluate_item_functions(&funcs, history_itemids, history_items, history_errcodes, items, items_err,
-				items_num);
+				items_num, &evaluated_num);
 		substitute_functions_results(&ifuncs, triggers);
 	}
 
 	zbx_hashset_destroy(&ifuncs);
 	zbx_hashset_destroy(&funcs);
+
+	stats[ZBX_HC_TRIGGER_FUNCS_REFERENCES] = (zbx_uint64_t)functionids.values_num;
+	stats[ZBX_HC_TRIGGER_FUNCS_UNIQUE] = (zbx_uint64_t)funcs_num;
+	stats[ZBX_HC_TRIGGER_FUNCS_EVALUATED] = (zbx_uint64_t)evaluated_num;
+	zbx_hc_add_trigger_funcs_stats(stats);
 empty:
-	zbx_vector_uint64_destroy(&functionids);
+	/* functionids_num - function references, funcs_num - unique by parameter, evaluated_num - unique calls */
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() functionids_num:%d funcs_num:%d evaluated_num:%d", __func__,
+			functionids.values_num, funcs_num, evaluated_num);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	zbx_vector_uint64_destroy(&functionids);
 }
 
 static int	evaluate_expression(zbx_eval_context_t *ctx, const zbx_timespec_t *ts, double *result,
@@ -27,9 +27,13 @@
 
 #define ZBX_DIAG_LLD_RULES		0x00000001
 #define ZBX_DIAG_LLD_VALUES		0x00000002
+#define ZBX_DIAG_LLD_ROWS_PROCESSED	0x00000004
+#define ZBX_DIAG_LLD_ROWS_SKIPPED	0x00000008
 
 #define ZBX_DIAG_LLD_SIMPLE		(ZBX_DIAG_LLD_RULES | \
-					ZBX_DIAG_LLD_VALUES)
+					ZBX_DIAG_LLD_VALUES | \
+					ZBX_DIAG_LLD_ROWS_PROCESSED | \
+					ZBX_DIAG_LLD_ROWS_SKIPPED)
 
 #define ZBX_DIAG_ALERTING_ALERTS	0x00000001
 
@@ -260,6 +264,8 @@ static int	diag_add_lld_info(const struct zbx_json_parse *jp, struct zbx_json *j
 							{"", ZBX_DIAG_LLD_SIMPLE},
 							{"rules", ZBX_DIAG_LLD_RULES},
 							{"values", ZBX_DIAG_LLD_VALUES},
+							{"rows_processed", ZBX_DIAG_LLD_ROWS_PROCESSED},
+							{"rows_skipped", ZBX_DIAG_LLD_ROWS_SKIPPED},
 							{NULL, 0}
 						};
 
@@ -271,10 +277,11 @@ static int	diag_add_lld_info(const struct zbx_json_parse *jp, struct zbx_json *j
 
 		if (0 != (fields & ZBX_DIAG_LLD_SIMPLE))
 		{
-			zbx_uint64_t	values_num, items_num;
+			zbx_uint64_t	values_num, items_num, rows_processed_num, rows_skipped_num;
 
 			time1 = zbx_time();
-			if (FAIL == (ret = zbx_lld_get_diag_stats(&items_num, &values_num, error)))
+			if (FAIL == (ret = zbx_lld_get_diag_stats(&items_num, &values_num, &rows_processed_num,
+					&rows_skipped_num, error)))
 				goto out;
 			time2 = zbx_time();
 			time_total += time2 - time1;
@@ -283,6 +290,10 @@ static int	diag_add_lld_info(const struct zbx_json_parse *jp, struct zbx_json *j
 				zbx_json_addint64(json, "rules", items_num);
 			if (0 != (fields & ZBX_DIAG_LLD_VALUES))
 				zbx_json_addint64(json, "values", values_num);
+			if (0 != (fields & ZBX_DIAG_LLD_ROWS_PROCESSED))
+				zbx_json_addint64(json, "rows_processed", rows_processed_num);
+			if (0 != (fields & ZBX_DIAG_LLD_ROWS_SKIPPED))
+				zbx_json_addint64(json, "rows_skipped", rows_skipped_num);
 		}
 
 		if (0 != tops.values_num)
@@ -0,0 +1,687 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "history_partition.h"
+
+#include "zbxcommon.h"
+
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+
+#include "zbxdbhigh.h"
+#include "zbxdb.h"
+#include "zbxstr.h"
+#include "zbxnum.h"
+#include "zbxtime.h"
+#include "zbxalgo.h"
+#include "zbxcacheconfig.h"
+
+/* partitions are created in advance to cover at least this period */
+#define HK_PARTITION_CREATE_AHEAD	SEC_PER_WEEK
+
+/* the minimum period of automatically created partitions */
+#define HK_PARTITION_PERIOD_MIN		SEC_PER_HOUR
+
+/* native range partition of history/trends table */
+typedef struct
+{
+	char	*name;
+
+	/* the partition covers clock range [from, to), INT_MIN/INT_MAX are used for MINVALUE/MAXVALUE bounds */
+	int	from;
+	int	to;
+}
+zbx_hk_partition_t;
+
+ZBX_VECTOR_DECL(hk_partition, zbx_hk_partition_t)
+ZBX_VECTOR_IMPL(hk_partition, zbx_hk_partition_t)
+
+/* partition period, either fixed length or calendar months/days */
+typedef struct
+{
+	int	seconds;	/* fixed period length, 0 for calendar periods */
+	int	months;
+	int	days;		/* local time days, UTC days have fixed length */
+	int	utc;		/* calendar months are aligned to UTC, otherwise to local time */
+}
+zbx_hk_partition_period_t;
+
+static void	hk_partitions_clear(zbx_vector_hk_partition_t *partitions)
+{
+	for (int i = 0; i < partitions->values_num; i++)
+		zbx_free(partitions->values[i].name);
+
+	zbx_vector_hk_partition_clear(partitions);
+}
+
+#if defined(HAVE_POSTGRESQL)
+static int	hk_partition_compare_to(const void *d1, const void *d2)
+{
+	const zbx_hk_partition_t	*p1 = (const zbx_hk_partition_t *)d1;
+	const zbx_hk_partition_t	*p2 = (const zbx_hk_partition_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(p1->to, p2->to);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: parses partition bound from partition bound specification         *
+ *                                                                            *
+ * Parameters: spec    - [IN] partition bound specification in format         *
+ *                            FOR VALUES FROM (<from>) TO (<to>)              *
+ *             keyword - [IN] bound keyword with opening bracket              *
+ *             value   - [OUT] parsed bound value                             *
+ *                                                                            *
+ * Return value: SUCCEED - bound was parsed successfully                      *
+ *               FAIL    - otherwise (for example DEFAULT partition)          *
+ *                                                                            *
+ ******************************************************************************/
+static int	hk_partition_parse_bound(const char *spec, const char *keyword, int *value)
+{
+	const char	*ptr;
+	char		*end;
+	long		num;
+
+	if (NULL == (ptr = strstr(spec, keyword)))
+		return FAIL;
+
+	ptr += strlen(keyword);
+
+	if (0 == strncmp(ptr, "MINVALUE)", ZBX_CONST_STRLEN("MINVALUE)")))
+	{
+		*value = INT_MIN;
+		return SUCCEED;
+	}
+
+	if (0 == strncmp(ptr, "MAXVALUE)", ZBX_CONST_STRLEN("MAXVALUE)")))
+	{
+		*value = INT_MAX;
+		return SUCCEED;
+	}
+
+	errno = 0;
+	num = strtol(ptr, &end, 10);
+
+	if (0 != errno || end == ptr || ')' != *end || INT_MIN >= num || INT_MAX <= num)
+		return FAIL;
+
+	*value = (int)num;
+
+	return SUCCEED;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets native range partitions of history/trends table              *
+ *                                                                            *
+ * Parameters: table      - [IN] history/trends table name                    *
+ *             partitions - [OUT] table partitions sorted by upper bound      *
+ *                                                                            *
+ * Return value: SUCCEED - the table is range partitioned by clock column     *
+ *               FAIL    - the table is not partitioned or uses unsupported   *
+ *                         partitioning scheme                                *
+ *                                                                            *
+ * Comments: Partitions without range bounds (PostgreSQL DEFAULT partition)   *
+ *           are not returned.                                                *
+ *                                                                            *
+ ******************************************************************************/
+static int	hk_partitions_get(const char *table, zbx_vector_hk_partition_t *partitions)
+{
+	zbx_db_result_t		result;
+	zbx_db_row_t		row;
+	int			ret = FAIL;
+	zbx_hk_partition_t	partition;
+
+#if defined(HAVE_POSTGRESQL)
+	result = zbx_db_select(
+			"select pg_get_partkeydef(c.oid)"
+			" from pg_class c,pg_namespace n"
+			" where c.relnamespace=n.oid"
+				" and n.nspname=current_schema()"
+				" and c.relkind='p'"
+				" and c.relname='%s'",
+			table);
+
+	if (NULL != (row = zbx_db_fetch(result)) && 0 == strcmp(row[0], "RANGE (clock)"))
+		ret = SUCCEED;
+
+	zbx_db_free_result(result);
+
+	if (SUCCEED != ret)
+		return FAIL;
+
+	result = zbx_db_select(
+			"select c.relname,pg_get_expr(c.relpartbound,c.oid)"
+			" from pg_inherits i,pg_class c,pg_class p,pg_namespace n"
+			" where i.inhrelid=c.oid"
+				" and i.inhparent=p.oid"
+				" and p.relnamespace=n.oid"
+				" and n.nspname=current_schema()"
+				" and p.relname='%s'",
+			table);
+
+	while (NULL != (row = zbx_db_fetch(result)))
+	{
+		if (SUCCEED != hk_partition_parse_bound(row[1], "FROM (", &partition.from) ||
+				SUCCEED != hk_partition_parse_bound(row[1], " TO (", &partition.to))
+		{
+			continue;
+		}
+
+		partition.name = zbx_strdup(NULL, row[0]);
+		zbx_vector_hk_partition_append(partitions, partition);
+	}
+
+	zbx_db_free_result(result);
+
+	zbx_vector_hk_partition_sort(partitions, hk_partition_compare_to);
+#elif defined(HAVE_MYSQL)
+	result = zbx_db_select(
+			"select partition_name,partition_method,partition_expression,partition_description,"
+				"subpartition_name"
+			" from information_schema.partitions"
+			" where table_schema=database()"
+				" and table_name='%s'"
+			" order by partition_ordinal_position",
+			table);
+
+	partition.from = INT_MIN;
+
+	while (NULL != (row = zbx_db_fetch(result)))
+	{
+		/* non-partitioned tables have single row with NULL partition name */
+		if (SUCCEED == zbx_db_is_null(row[0]) || SUCCEED != zbx_db_is_null(row[4]) ||
+				0 != strncmp(row[1], "RANGE", ZBX_CONST_STRLEN("RANGE")) ||
+				(0 != strcmp(row[2], "`clock`") && 0 != strcmp(row[2], "clock")))
+		{
+			ret = FAIL;
+			break;
+		}
+
+		if (0 == strcmp(row[3], "MAXVALUE"))
+			partition.to = INT_MAX;
+		else if (SUCCEED != zbx_is_int(row[3], &partition.to))
+		{
+			ret = FAIL;
+			break;
+		}
+
+		partition.name = zbx_strdup(NULL, row[0]);
+		zbx_vector_hk_partition_append(partitions, partition);
+
+		partition.from = partition.to;
+		ret = SUCCEED;
+	}
+
+	zbx_db_free_result(result);
+
+	if (SUCCEED != ret)
+		hk_partitions_clear(partitions);
+#endif
+	return ret;
+}
+
+static int	hk_partition_is_month_start(const struct tm *tm)
+{
+	return 1 == tm->tm_mday && 0 == tm->tm_hour && 0 == tm->tm_min && 0 == tm->tm_sec ? SUCCEED : FAIL;
+}
+
+static int	hk_partition_is_day_start(const struct tm *tm)
+{
+	return 0 == tm->tm_hour && 0 == tm->tm_min && 0 == tm->tm_sec ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: derives partition period from existing partition bounds           *
+ *                                                                            *
+ * Parameters: from           - [IN] partition lower bound                    *
+ *             to             - [IN] partition upper bound                    *
+ *             period_default - [IN] period used when it cannot be derived    *
+ *             period         - [OUT]                                         *
+ *                                                                            *
+ * Comments: Partitions starting at month start are continued with calendar   *
+ *           months, so that monthly partitions stay aligned regardless of    *
+ *           month length. Partitions starting at local midnight, but not at  *
+ *           UTC midnight, are continued with local time days, which are      *
+ *           affected by daylight saving time changes.                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	hk_partition_period_get(int from, int to, int period_default, zbx_hk_partition_period_t *period)
+{
+	time_t		clock_from = (time_t)from, clock_to = (time_t)to;
+	struct tm	tm_from, tm_to;
+
+	memset(period, 0, sizeof(zbx_hk_partition_period_t));
+
+	if (INT_MIN == from || INT_MAX == to || HK_PARTITION_PERIOD_MIN > to - from)
+	{
+		period->seconds = period_default;
+		return;
+	}
+
+	gmtime_r(&clock_from, &tm_from);
+	gmtime_r(&clock_to, &tm_to);
+
+	if (SUCCEED == hk_partition_is_month_start(&tm_from) && SUCCEED == hk_partition_is_month_start(&tm_to))
+	{
+		period->months = (tm_to.tm_year - tm_from.tm_year) * 12 + tm_to.tm_mon - tm_from.tm_mon;
+		period->utc = 1;
+		return;
+	}
+
+	if (SUCCEED == hk_partition_is_day_start(&tm_from) && SUCCEED == hk_partition_is_day_start(&tm_to))
+	{
+		period->seconds = to - from;
+		return;
+	}
+
+	localtime_r(&clock_from, &tm_from);
+	localtime_r(&clock_to, &tm_to);
+
+	if (SUCCEED == hk_partition_is_month_start(&tm_from) && SUCCEED == hk_partition_is_month_start(&tm_to))
+	{
+		period->months = (tm_to.tm_year - tm_from.tm_year) * 12 + tm_to.tm_mon - tm_from.tm_mon;
+		return;
+	}
+
+	if (SUCCEED == hk_partition_is_day_start(&tm_from) && SUCCEED == hk_partition_is_day_start(&tm_to))
+	{
+		period->days = (to - from + SEC_PER_DAY / 2) / SEC_PER_DAY;
+		return;
+	}
+
+	period->seconds = to - from;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates partition upper bound                                  *
+ *                                                                            *
+ * Parameters: from   - [IN] partition lower bound                            *
+ *             period - [IN]                                                  *
+ *                                                                            *
+ * Return value: partition upper bound, INT_MAX on overflow                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	hk_partition_period_add(int from, const zbx_hk_partition_period_t *period)
+{
+	time_t		clock = (time_t)from;
+	struct tm	tm;
+	int		to;
+
+	if (0 != period->seconds)
+		return INT_MAX - period->seconds > from ? from + period->seconds : INT_MAX;
+
+	if (0 != period->utc)
+	{
+		int	mon;
+
+		gmtime_r(&clock, &tm);
+		mon = tm.tm_mon + period->months;
+
+		if (SUCCEED != zbx_utc_time(tm.tm_year + 1900 + mon / 12, mon % 12 + 1, 1, 0, 0, 0, &to))
+			return INT_MAX;
+
+		return to;
+	}
+
+	localtime_r(&clock, &tm);
+	tm.tm_mon += period->months;
+	tm.tm_mday += period->days;
+	tm.tm_isdst = -1;
+
+	if (-1 == (clock = mktime(&tm)) || INT_MAX <= clock)
+		return INT_MAX;
+
+	return (int)clock;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates ranges of partitions to be created                     *
+ *                                                                            *
+ * Parameters: partitions     - [IN] existing partitions sorted by upper      *
+ *                                   bound                                    *
+ *             period_default - [IN] the partition period used when it cannot *
+ *                                   be derived from existing partitions      *
+ *             now            - [IN] current timestamp                        *
+ *             ranges         - [OUT] partition ranges without names          *
+ *                                                                            *
+ * Comments: New partitions continue from the last bounded partition with the *
+ *           same period, so that inserted values always have a partition.    *
+ *           The first partition also covers the gap left when partitions     *
+ *           were not created for a while.                                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	hk_partition_ranges_get(const zbx_vector_hk_partition_t *partitions, int period_default, int now,
+		zbx_vector_hk_partition_t *ranges)
+{
+	zbx_hk_partition_period_t	period;
+	zbx_hk_partition_t		range = {0};
+	int				horizon, next, from = INT_MIN, from_prev = INT_MIN;
+
+	for (int i = 0; i < partitions->values_num; i++)
+	{
+		const zbx_hk_partition_t	*partition = &partitions->values[i];
+
+		if (INT_MAX != partition->to && partition->to > from)
+		{
+			from = partition->to;
+			from_prev = partition->from;
+		}
+	}
+
+	if (INT_MIN == from)
+	{
+		from = now - now % period_default;
+		period.seconds = period_default;
+		period.months = period.days = period.utc = 0;
+	}
+	else
+		hk_partition_period_get(from_prev, from, period_default, &period);
+
+	if (INT_MAX == (next = hk_partition_period_add(from, &period)))
+		return;
+
+	horizon = now + MAX(HK_PARTITION_CREATE_AHEAD, 2 * (next - from));
+
+	while (from < horizon)
+	{
+		range.from = from;
+
+		if (0 != period.seconds)
+		{
+			range.to = from + (MAX(from, now) - from) / period.seconds * period.seconds;
+			range.to = hk_partition_period_add(range.to, &period);
+		}
+		else
+		{
+			for (range.to = hk_partition_period_add(from, &period); range.to <= now && INT_MAX != range.to;)
+				range.to = hk_partition_period_add(range.to, &period);
+		}
+
+		if (INT_MAX == range.to || range.to <= from)
+			break;
+
+		zbx_vector_hk_partition_append(ranges, range);
+		from = range.to;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates the number of expired partitions to be dropped         *
+ *                                                                            *
+ * Parameters: partitions      - [IN] partitions sorted by upper bound        *
+ *             history_seconds - [IN] history to keep                         *
+ *             now             - [IN] current timestamp                       *
+ *                                                                            *
+ * Return value: the number of the first partitions to be dropped             *
+ *                                                                            *
+ * Comments: The last partition is never dropped, because MySQL does not      *
+ *           allow dropping all partitions of a table.                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	hk_partitions_expired_num(const zbx_vector_hk_partition_t *partitions, int history_seconds, int now)
+{
+	int	keep_from = now - history_seconds, num;
+
+	for (num = 0; num < partitions->values_num - 1; num++)
+	{
+		if (partitions->values[num].to > keep_from)
+			break;
+	}
+
+	return num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: formats partition name for the specified partition start          *
+ *                                                                            *
+ * Parameters: table - [IN] history/trends table name                         *
+ *             from  - [IN] partition lower bound                             *
+ *                                                                            *
+ * Return value: partition name, must be freed by caller                      *
+ *                                                                            *
+ ******************************************************************************/
+static char	*hk_partition_name(const char *table, int from)
+{
+	time_t		clock = (time_t)from;
+	struct tm	tm;
+
+	gmtime_r(&clock, &tm);
+
+#if defined(HAVE_POSTGRESQL)
+	/* PostgreSQL partitions are regular tables sharing the schema namespace */
+	return zbx_dsprintf(NULL, "%s_p%04d%02d%02d%02d", table, tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+			tm.tm_hour);
+#else
+	ZBX_UNUSED(table);
+
+	return zbx_dsprintf(NULL, "p%04d%02d%02d%02d", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour);
+#endif
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if history/trends table is natively range partitioned by   *
+ *          clock column                                                      *
+ *                                                                            *
+ * Parameters: table - [IN] history/trends table name                         *
+ *                                                                            *
+ * Return value: SUCCEED - the table is partitioned                           *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	hk_history_partition_check(const char *table)
+{
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+	zbx_vector_hk_partition_t	partitions;
+	int				ret;
+
+	zbx_vector_hk_partition_create(&partitions);
+
+	ret = hk_partitions_get(table, &partitions);
+
+	hk_partitions_clear(&partitions);
+	zbx_vector_hk_partition_destroy(&partitions);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() table:%s partitioned:%s", __func__, table, zbx_result_string(ret));
+
+	return ret;
+#else
+	ZBX_UNUSED(table);
+
+	return FAIL;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates future partitions of history/trends table                 *
+ *                                                                            *
+ * Parameters: table  - [IN] history/trends table name                        *
+ *             period - [IN] the default partition period, used when it       *
+ *                           cannot be derived from existing partitions       *
+ *             now    - [IN] current timestamp                                *
+ *                                                                            *
+ * Comments: See hk_partition_ranges_get() for partition bounds.              *
+ *           On MySQL the MAXVALUE partition is split, on PostgreSQL the      *
+ *           creation fails if DEFAULT partition has rows in the new range.   *
+ *                                                                            *
+ ******************************************************************************/
+void	hk_history_partition_create(const char *table, int period, int now)
+{
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+	zbx_vector_hk_partition_t	partitions, ranges;
+	int				created = 0;
+	const char			*maxvalue = NULL;
+#if defined(HAVE_MYSQL)
+	char				*sql = NULL;
+	size_t				sql_alloc = 0, sql_offset = 0;
+#endif
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() table:%s now:%d", __func__, table, now);
+
+	zbx_vector_hk_partition_create(&partitions);
+	zbx_vector_hk_partition_create(&ranges);
+
+	if (SUCCEED != hk_partitions_get(table, &partitions))
+		goto out;
+
+	if (0 != partitions.values_num && INT_MAX == partitions.values[partitions.values_num - 1].to)
+		maxvalue = partitions.values[partitions.values_num - 1].name;
+
+	hk_partition_ranges_get(&partitions, period, now, &ranges);
+
+	for (int i = 0; i < ranges.values_num; i++)
+	{
+		char	*name;
+
+		name = hk_partition_name(table, ranges.values[i].from);
+#if defined(HAVE_POSTGRESQL)
+		if (ZBX_DB_OK > zbx_db_execute("create table %s partition of %s for values from (%d) to (%d)",
+				name, table, ranges.values[i].from, ranges.values[i].to))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot create partition \"%s\" of table \"%s\"", name, table);
+			zbx_free(name);
+			break;
+		}
+#else
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "%spartition %s values less than (%d)",
+				0 == created ? "" : ",", name, ranges.values[i].to);
+#endif
+		zbx_free(name);
+		created++;
+	}
+
+#if defined(HAVE_MYSQL)
+	if (0 != created)
+	{
+		int	rc;
+
+		if (NULL != maxvalue)
+		{
+			rc = zbx_db_execute("alter table %s reorganize partition %s into (%s,partition %s"
+					" values less than maxvalue)", table, maxvalue, sql, maxvalue);
+		}
+		else
+			rc = zbx_db_execute("alter table %s add partition (%s)", table, sql);
+
+		if (ZBX_DB_OK > rc)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot create partitions of table \"%s\"", table);
+			created = 0;
+		}
+
+		zbx_free(sql);
+	}
+#else
+	ZBX_UNUSED(maxvalue);
+#endif
+out:
+	zbx_vector_hk_partition_destroy(&ranges);
+	hk_partitions_clear(&partitions);
+	zbx_vector_hk_partition_destroy(&partitions);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() created:%d", __func__, created);
+#else
+	ZBX_UNUSED(table);
+	ZBX_UNUSED(period);
+	ZBX_UNUSED(now);
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: drops expired partitions of history/trends table                  *
+ *                                                                            *
+ * Parameters: table           - [IN] history/trends table name               *
+ *             history_seconds - [IN] history to keep                         *
+ *             now             - [IN] current timestamp                       *
+ *                                                                            *
+ * Comments: Only partitions with all data older than the history period are  *
+ *           dropped, the remaining expired records are removed together with *
+ *           their partition later.                                           *
+ *                                                                            *
+ ******************************************************************************/
+void	hk_history_partition_drop(const char *table, int history_seconds, int now)
+{
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+	zbx_vector_hk_partition_t	partitions;
+	int				expired_num, dropped = 0;
+#if defined(HAVE_MYSQL)
+	char				*sql = NULL;
+	size_t				sql_alloc = 0, sql_offset = 0;
+#endif
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() table:%s now:%d", __func__, table, now);
+
+	zbx_vector_hk_partition_create(&partitions);
+
+	if (0 != history_seconds && (ZBX_HK_HISTORY_MIN > history_seconds || ZBX_HK_PERIOD_MAX < history_seconds))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "invalid history storage period for table '%s'", table);
+		goto out;
+	}
+
+	if (SUCCEED != hk_partitions_get(table, &partitions))
+		goto out;
+
+	expired_num = hk_partitions_expired_num(&partitions, history_seconds, now);
+
+	for (int i = 0; i < expired_num; i++)
+	{
+		zbx_hk_partition_t	*partition = &partitions.values[i];
+#if defined(HAVE_POSTGRESQL)
+		if (ZBX_DB_OK > zbx_db_execute("drop table %s", partition->name))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot drop partition \"%s\" of table \"%s\"", partition->name,
+					table);
+			break;
+		}
+#else
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "%s%s", 0 == dropped ? "" : ",", partition->name);
+#endif
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() table:%s partition:%s to:%d", __func__, table, partition->name,
+				partition->to);
+		dropped++;
+	}
+
+#if defined(HAVE_MYSQL)
+	if (0 != dropped)
+	{
+		if (ZBX_DB_OK > zbx_db_execute("alter table %s drop partition %s", table, sql))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot drop partitions of table \"%s\"", table);
+			dropped = 0;
+		}
+
+		zbx_free(sql);
+	}
+#endif
+out:
+	hk_partitions_clear(&partitions);
+	zbx_vector_hk_partition_destroy(&partitions);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() dropped:%d", __func__, dropped);
+#else
+	ZBX_UNUSED(table);
+	ZBX_UNUSED(history_seconds);
+	ZBX_UNUSED(now);
+#endif
+}
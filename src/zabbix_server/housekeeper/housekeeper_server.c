@@ -15,6 +15,7 @@
 #include "housekeeper_server.h"
 
 #include "history_compress.h"
+#include "history_partition.h"
 
 #include "zbxtimekeeper.h"
 #include "zbxlog.h"
@@ -136,6 +137,9 @@ typedef struct
 	/* type for checking which values are sent to the history storage */
 	unsigned char				type;
 
+	/* 1 if the table is natively range partitioned by clock, 0 otherwise */
+	unsigned char				partitioned;
+
 	/* the oldest item record timestamp cache for target table */
 	zbx_hashset_t				item_cache;
 
@@ -488,6 +492,31 @@ static void	hk_history_update(zbx_hk_history_rule_t *rules, int now)
 	zbx_free(tmp);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if expired history of the rule is removed by dropping      *
+ *          native table partitions                                           *
+ *                                                                            *
+ * Parameters: rule - [IN] history housekeeping rule                          *
+ *                                                                            *
+ * Return value: SUCCEED - partitions are dropped instead of deleting records *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Partitions can be dropped only when global history (trends)      *
+ *           period is in effect, otherwise records are deleted per item.     *
+ *                                                                            *
+ ******************************************************************************/
+static int	hk_history_partition_mode(const zbx_hk_history_rule_t *rule)
+{
+	if (1 == rule->partitioned && ZBX_HK_MODE_REGULAR == *rule->poption_mode &&
+			ZBX_HK_OPTION_ENABLED == *rule->poption_global)
+	{
+		return SUCCEED;
+	}
+
+	return FAIL;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: prepares history housekeeping delete queues for all defined       *
@@ -509,7 +538,7 @@ static void	hk_history_delete_queue_prepare_all(zbx_hk_history_rule_t *rules, in
 	/* prepare history item cache (hashset containing itemid:min_clock values) */
 	for (zbx_hk_history_rule_t *rule = rules; NULL != rule->table; rule++)
 	{
-		if (ZBX_HK_MODE_REGULAR == *rule->poption_mode)
+		if (ZBX_HK_MODE_REGULAR == *rule->poption_mode && SUCCEED != hk_history_partition_mode(rule))
 		{
 			if (0 == rule->item_cache.num_slots)
 				hk_history_prepare(rule);
@@ -634,10 +663,13 @@ static void 	hk_update_dbversion_status(void)
  *                                                                            *
  * Purpose: performs housekeeping for history and trends tables               *
  *                                                                            *
- * Parameters: now - [IN] current timestamp                                   *
+ * Parameters: now        - [IN] current timestamp                            *
+ *             partitions - [IN] 1 - manage native partitions of history and  *
+ *                                   trends tables                            *
+ *                               0 - otherwise                                *
  *                                                                            *
  ******************************************************************************/
-static int	housekeeping_history_and_trends(int now)
+static int	housekeeping_history_and_trends(int now, int partitions)
 {
 	int			deleted = 0;
 	zbx_hk_history_rule_t	*rule;
@@ -647,6 +679,18 @@ static int	housekeeping_history_and_trends(int now)
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() now:%d", __func__, now);
 
+	/* native partitioning is not used together with TimescaleDB hypertables */
+	for (rule = hk_history_rules; NULL != rule->table; rule++)
+	{
+		if (0 != partitions && ZBX_HK_MODE_PARTITION != *rule->poption_mode &&
+				SUCCEED == hk_history_partition_check(rule->table))
+		{
+			rule->partitioned = 1;
+		}
+		else
+			rule->partitioned = 0;
+	}
+
 	/* prepare delete queues for all history housekeeping rules */
 	hk_history_delete_queue_prepare_all(hk_history_rules, now);
 
@@ -659,6 +703,13 @@ static int	housekeeping_history_and_trends(int now)
 	/* we need to clear records from */
 	for (rule = hk_history_rules; NULL != rule->table; rule++)
 	{
+		/* partitions must exist for incoming values regardless of housekeeping settings */
+		if (1 == rule->partitioned)
+		{
+			hk_history_partition_create(rule->table,
+					0 == strcmp(rule->history, "trends") ? SEC_PER_WEEK : SEC_PER_DAY, now);
+		}
+
 		if (ZBX_HK_MODE_DISABLED == *rule->poption_mode)
 			goto skip;
 
@@ -672,6 +723,13 @@ static int	housekeeping_history_and_trends(int now)
 			goto skip;
 		}
 
+		/* drop natively partitioned table partitions with expired history when global period is set */
+		if (SUCCEED == hk_history_partition_mode(rule))
+		{
+			hk_history_partition_drop(rule->table, *rule->poption, now);
+			goto skip;
+		}
+
 #if defined(HAVE_POSTGRESQL)
 		if (0 < tsdb_version)
 		{
@@ -1484,7 +1542,8 @@ ZBX_THREAD_ENTRY(housekeeper_thread, args)
 		zbx_setproctitle("%s [removing old history and trends]",
 				get_process_type_string(process_type));
 		sec = zbx_time();
-		int	d_history_and_trends = housekeeping_history_and_trends(now);
+		int	d_history_and_trends = housekeeping_history_and_trends(now,
+				housekeeper_args_in->config_housekeeping_partitions);
 
 		zbx_setproctitle("%s [removing old problems]", get_process_type_string(process_type));
 		int	d_problems = housekeeping_problems(now, housekeeper_args_in->config_max_housekeeper_delete);
@@ -23,6 +23,7 @@ typedef struct
 	int				config_timeout;
 	int				config_housekeeping_frequency;
 	int				config_max_housekeeper_delete;
+	int				config_housekeeping_partitions;
 }
 zbx_thread_housekeeper_args;
 
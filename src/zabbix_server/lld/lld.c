@@ -1091,18 +1091,534 @@ static void	lld_row_free(zbx_lld_row_t *lld_row)
 	zbx_free(lld_row);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: appends string to digest, distinguishing NULL from empty string   *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_md5_append_str(md5_state_t *state, const char *str)
+{
+	static const md5_byte_t	null_marker = 0xff;
+
+	if (NULL == str)
+		zbx_md5_append(state, &null_marker, 1);
+	else
+		zbx_md5_append(state, (const md5_byte_t *)str, (int)strlen(str) + 1);
+}
+
+static void	lld_md5_append_uint64(md5_state_t *state, zbx_uint64_t value)
+{
+	zbx_md5_append(state, (const md5_byte_t *)&value, (int)sizeof(value));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates digest of LLD macro values of discovered row and the   *
+ *          overrides matching the row                                        *
+ *                                                                            *
+ * Parameters: lld_row         - [IN] discovered row                          *
+ *             lld_macro_paths - [IN] LLD macro paths                         *
+ *             digest          - [OUT] row digest                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_row_fingerprint(const zbx_lld_row_t *lld_row,
+		const zbx_vector_lld_macro_path_ptr_t *lld_macro_paths, md5_byte_t *digest)
+{
+	md5_state_t		state;
+	const char		*p = NULL;
+	char			name[MAX_STRING_LEN], *value = NULL;
+	size_t			value_alloc = 0;
+	struct zbx_json_parse	jp_value;
+
+	zbx_md5_init(&state);
+
+	while (NULL != (p = zbx_json_pair_next(&lld_row->jp_row, p, name, sizeof(name))))
+	{
+		if ('{' != name[0] || '#' != name[1])
+			continue;
+
+		lld_md5_append_str(&state, name);
+
+		if (NULL != zbx_json_decodevalue_dyn(p, &value, &value_alloc, NULL))
+			lld_md5_append_str(&state, value);
+		else if (SUCCEED == zbx_json_brackets_open(p, &jp_value))
+		{
+			zbx_md5_append(&state, (const md5_byte_t *)jp_value.start,
+					(int)(jp_value.end - jp_value.start + 1));
+		}
+	}
+
+	zbx_free(value);
+
+	for (int i = 0; i < lld_macro_paths->values_num; i++)
+	{
+		const zbx_lld_macro_path_t	*lld_macro_path = lld_macro_paths->values[i];
+
+		lld_md5_append_str(&state, lld_macro_path->lld_macro);
+
+		if (SUCCEED == zbx_lld_macro_value_by_name(&lld_row->jp_row, lld_macro_paths,
+				lld_macro_path->lld_macro, &value))
+		{
+			lld_md5_append_str(&state, value);
+		}
+
+		zbx_free(value);
+	}
+
+	for (int i = 0; i < lld_row->overrides.values_num; i++)
+		lld_md5_append_uint64(&state, lld_row->overrides.values[i]->overrideid);
+
+	zbx_md5_finish(&state, digest);
+}
+
+static int	lld_row_digest_compare(const void *d1, const void *d2)
+{
+	return memcmp(d1, d2, ZBX_MD5_DIGEST_SIZE);
+}
+
+static void	lld_filter_fingerprint(md5_state_t *state, const zbx_lld_filter_t *filter)
+{
+	lld_md5_append_uint64(state, (zbx_uint64_t)filter->evaltype);
+	lld_md5_append_str(state, filter->expression);
+
+	for (int i = 0; i < filter->conditions.values_num; i++)
+	{
+		const lld_condition_t	*condition = filter->conditions.values[i];
+
+		lld_md5_append_uint64(state, condition->id);
+		lld_md5_append_str(state, condition->macro);
+		lld_md5_append_str(state, condition->regexp);
+		lld_md5_append_uint64(state, condition->op);
+
+		/* global regular expressions referenced by the condition */
+		for (int j = 0; j < condition->regexps.values_num; j++)
+		{
+			const zbx_expression_t	*regexp = condition->regexps.values[j];
+
+			lld_md5_append_str(state, regexp->name);
+			lld_md5_append_str(state, regexp->expression);
+			lld_md5_append_uint64(state, (zbx_uint64_t)regexp->expression_type);
+			lld_md5_append_uint64(state, (zbx_uint64_t)regexp->exp_delimiter);
+			lld_md5_append_uint64(state, regexp->case_sensitive);
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: appends definitions of LLD rule overrides to digest               *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_overrides_fingerprint(md5_state_t *state, const zbx_vector_lld_override_ptr_t *overrides)
+{
+	for (int i = 0; i < overrides->values_num; i++)
+	{
+		const zbx_lld_override_t	*override = overrides->values[i];
+
+		lld_md5_append_uint64(state, override->overrideid);
+		lld_md5_append_uint64(state, (zbx_uint64_t)override->step);
+		lld_md5_append_uint64(state, override->stop);
+		lld_filter_fingerprint(state, &override->filter);
+
+		for (int j = 0; j < override->override_operations.values_num; j++)
+		{
+			const zbx_lld_override_operation_t	*op = override->override_operations.values[j];
+
+			lld_md5_append_uint64(state, op->override_operationid);
+			lld_md5_append_uint64(state, op->operationtype);
+			lld_md5_append_uint64(state, op->operator);
+			lld_md5_append_str(state, op->value);
+			lld_md5_append_str(state, op->delay);
+			lld_md5_append_str(state, op->history);
+			lld_md5_append_str(state, op->trends);
+			lld_md5_append_uint64(state, op->status);
+			lld_md5_append_uint64(state, op->severity);
+			lld_md5_append_uint64(state, (zbx_uint64_t)op->inventory_mode);
+			lld_md5_append_uint64(state, op->discover);
+
+			for (int k = 0; k < op->tags.values_num; k++)
+			{
+				lld_md5_append_str(state, op->tags.values[k]->tag);
+				lld_md5_append_str(state, op->tags.values[k]->value);
+			}
+
+			for (int k = 0; k < op->templateids.values_num; k++)
+				lld_md5_append_uint64(state, op->templateids.values[k]);
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: appends all columns of the selected rows to digest                *
+ *                                                                            *
+ * Parameters: state       - [IN/OUT] digest state                            *
+ *             columns_num - [IN] number of selected columns                  *
+ *             fmt         - [IN] SQL query format                            *
+ *                                                                            *
+ * Return value: number of selected rows                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_query_fingerprint(md5_state_t *state, int columns_num, const char *fmt, ...)
+{
+	va_list		args;
+	zbx_db_result_t	result;
+	zbx_db_row_t	row;
+	int		rows_num = 0;
+
+	va_start(args, fmt);
+	result = zbx_db_vselect(fmt, args);
+	va_end(args);
+
+	while (NULL != (row = zbx_db_fetch(result)))
+	{
+		for (int i = 0; i < columns_num; i++)
+			lld_md5_append_str(state, SUCCEED == zbx_db_is_null(row[i]) ? NULL : row[i]);
+
+		rows_num++;
+	}
+
+	zbx_db_free_result(result);
+
+	/* separate rows of different queries */
+	lld_md5_append_uint64(state, (zbx_uint64_t)rows_num);
+
+	return rows_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates digest of item, trigger and host prototype definitions *
+ *          of LLD rule that are tracked by configuration cache changelog     *
+ *                                                                            *
+ * Parameters: lld_ruleid  - [IN] LLD rule                                    *
+ *             fingerprint - [OUT]                                            *
+ *                                                                            *
+ * Comments: Prototypes are not fully cached in configuration cache, so the   *
+ *           definitions are read from database. Child tables are read only   *
+ *           when the rule has prototypes of the corresponding type.          *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_prototypes_fingerprint(zbx_uint64_t lld_ruleid, md5_byte_t *fingerprint)
+{
+#define LLD_TRIGGER_PROTOTYPES_SQL	"select f.triggerid from functions f,item_discovery id"		\
+					" where f.itemid=id.itemid and id.parent_itemid=" ZBX_FS_UI64
+#define LLD_HOST_PROTOTYPES_SQL		"select hostid from host_discovery where parent_itemid=" ZBX_FS_UI64
+
+	md5_state_t	state;
+
+	zbx_md5_init(&state);
+
+	if (0 != lld_query_fingerprint(&state, 45,
+			"select i.itemid,i.name,i.key_,i.type,i.value_type,i.delay,"
+				"i.history,i.trends,i.status,i.trapper_hosts,i.units,i.formula,"
+				"i.logtimefmt,i.valuemapid,i.params,i.ipmi_sensor,i.snmp_oid,i.authtype,"
+				"i.username,i.password,i.publickey,i.privatekey,i.description,i.interfaceid,"
+				"i.jmx_endpoint,i.master_itemid,i.timeout,i.url,i.query_fields,"
+				"i.posts,i.status_codes,i.follow_redirects,i.post_type,i.http_proxy,i.headers,"
+				"i.retrieve_mode,i.request_method,i.output_format,i.ssl_cert_file,i.ssl_key_file,"
+				"i.ssl_key_password,i.verify_peer,i.verify_host,i.allow_traps,i.discover"
+			" from items i,item_discovery id"
+			" where i.itemid=id.itemid"
+				" and id.parent_itemid=" ZBX_FS_UI64
+			" order by i.itemid",
+			lld_ruleid))
+	{
+		lld_query_fingerprint(&state, 7,
+				"select ip.item_preprocid,ip.itemid,ip.step,ip.type,ip.params,ip.error_handler,"
+					"ip.error_handler_params"
+				" from item_preproc ip,item_discovery id"
+				" where ip.itemid=id.itemid"
+					" and id.parent_itemid=" ZBX_FS_UI64
+				" order by ip.item_preprocid",
+				lld_ruleid);
+
+		lld_query_fingerprint(&state, 4,
+				"select it.itemtagid,it.itemid,it.tag,it.value"
+				" from item_tag it,item_discovery id"
+				" where it.itemid=id.itemid"
+					" and id.parent_itemid=" ZBX_FS_UI64
+				" order by it.itemtagid",
+				lld_ruleid);
+	}
+
+	if (0 != lld_query_fingerprint(&state, 17,
+			"select t.triggerid,t.description,t.expression,t.status,t.type,t.priority,t.comments,"
+				"t.url,t.url_name,t.recovery_expression,t.recovery_mode,t.correlation_mode,"
+				"t.correlation_tag,t.manual_close,t.opdata,t.discover,t.event_name"
+			" from triggers t"
+			" where t.triggerid in (" LLD_TRIGGER_PROTOTYPES_SQL ")"
+			" order by t.triggerid",
+			lld_ruleid))
+	{
+		lld_query_fingerprint(&state, 5,
+				"select functionid,triggerid,itemid,name,parameter"
+				" from functions"
+				" where triggerid in (" LLD_TRIGGER_PROTOTYPES_SQL ")"
+				" order by functionid",
+				lld_ruleid);
+
+		lld_query_fingerprint(&state, 3,
+				"select triggerdepid,triggerid_down,triggerid_up"
+				" from trigger_depends"
+				" where triggerid_down in (" LLD_TRIGGER_PROTOTYPES_SQL ")"
+				" order by triggerdepid",
+				lld_ruleid);
+
+		lld_query_fingerprint(&state, 4,
+				"select triggertagid,triggerid,tag,value"
+				" from trigger_tag"
+				" where triggerid in (" LLD_TRIGGER_PROTOTYPES_SQL ")"
+				" order by triggertagid",
+				lld_ruleid);
+	}
+
+	if (0 != lld_query_fingerprint(&state, 6,
+			"select hostid,host,name,status,discover,custom_interfaces"
+			" from hosts"
+			" where hostid in (" LLD_HOST_PROTOTYPES_SQL ")"
+			" order by hostid",
+			lld_ruleid))
+	{
+		lld_query_fingerprint(&state, 2,
+				"select hostid,inventory_mode"
+				" from host_inventory"
+				" where hostid in (" LLD_HOST_PROTOTYPES_SQL ")"
+				" order by hostid",
+				lld_ruleid);
+
+		lld_query_fingerprint(&state, 7,
+				"select hostmacroid,hostid,macro,value,description,type,automatic"
+				" from hostmacro"
+				" where hostid in (" LLD_HOST_PROTOTYPES_SQL ")"
+				" order by hostmacroid",
+				lld_ruleid);
+
+		lld_query_fingerprint(&state, 5,
+				"select hosttagid,hostid,tag,value,automatic"
+				" from host_tag"
+				" where hostid in (" LLD_HOST_PROTOTYPES_SQL ")"
+				" order by hosttagid",
+				lld_ruleid);
+
+		lld_query_fingerprint(&state, 4,
+				"select hosttemplateid,hostid,templateid,link_type"
+				" from hosts_templates"
+				" where hostid in (" LLD_HOST_PROTOTYPES_SQL ")"
+				" order by hosttemplateid",
+				lld_ruleid);
+
+		lld_query_fingerprint(&state, 19,
+				"select hi.interfaceid,hi.hostid,hi.main,hi.type,hi.useip,hi.ip,hi.dns,hi.port,"
+					"s.version,s.bulk,s.community,s.securityname,s.securitylevel,"
+					"s.authpassphrase,s.privpassphrase,s.authprotocol,s.privprotocol,"
+					"s.contextname,s.max_repetitions"
+				" from interface hi"
+				" left join interface_snmp s"
+					" on hi.interfaceid=s.interfaceid"
+				" where hi.hostid in (" LLD_HOST_PROTOTYPES_SQL ")"
+				" order by hi.interfaceid",
+				lld_ruleid);
+	}
+
+	zbx_md5_finish(&state, fingerprint);
+
+#undef LLD_HOST_PROTOTYPES_SQL
+#undef LLD_TRIGGER_PROTOTYPES_SQL
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: appends definitions of LLD rule prototype objects that are not    *
+ *          tracked by configuration cache changelog to digest                *
+ *                                                                            *
+ * Comments: Graph prototypes, item prototype parameters and host prototype   *
+ *           group prototypes are read from database with every value.        *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_prototypes_untracked_fingerprint(md5_state_t *state, zbx_uint64_t lld_ruleid)
+{
+#define LLD_GRAPH_PROTOTYPES_SQL	"select gi.graphid from graphs_items gi,item_discovery id"	\
+					" where gi.itemid=id.itemid and id.parent_itemid=" ZBX_FS_UI64
+
+	if (0 != lld_query_fingerprint(state, 18,
+			"select g.graphid,g.name,g.width,g.height,g.yaxismin,g.yaxismax,g.show_work_period,"
+				"g.show_triggers,g.graphtype,g.show_legend,g.show_3d,g.percent_left,g.percent_right,"
+				"g.ymin_type,g.ymin_itemid,g.ymax_type,g.ymax_itemid,g.discover"
+			" from graphs g"
+			" where g.graphid in (" LLD_GRAPH_PROTOTYPES_SQL ")"
+			" order by g.graphid",
+			lld_ruleid))
+	{
+		lld_query_fingerprint(state, 9,
+				"select gitemid,graphid,itemid,drawtype,sortorder,color,yaxisside,calc_fnc,type"
+				" from graphs_items"
+				" where graphid in (" LLD_GRAPH_PROTOTYPES_SQL ")"
+				" order by gitemid",
+				lld_ruleid);
+	}
+
+	lld_query_fingerprint(state, 4,
+			"select ip.item_parameterid,ip.itemid,ip.name,ip.value"
+			" from item_parameter ip,item_discovery id"
+			" where ip.itemid=id.itemid"
+				" and id.parent_itemid=" ZBX_FS_UI64
+			" order by ip.item_parameterid",
+			lld_ruleid);
+
+	lld_query_fingerprint(state, 4,
+			"select gp.group_prototypeid,gp.hostid,gp.name,gp.groupid"
+			" from group_prototype gp,host_discovery hd"
+			" where gp.hostid=hd.hostid"
+				" and hd.parent_itemid=" ZBX_FS_UI64
+			" order by gp.group_prototypeid",
+			lld_ruleid);
+
+#undef LLD_GRAPH_PROTOTYPES_SQL
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates fingerprint of discovered rows and the LLD rule        *
+ *          configuration applied to them                                     *
+ *                                                                            *
+ * Parameters: lld_ruleid             - [IN] LLD rule                         *
+ *             lld_rows               - [IN] discovered rows                  *
+ *             lld_macro_paths        - [IN] LLD macro paths                  *
+ *             overrides              - [IN] LLD rule overrides               *
+ *             lifetime               - [IN] lost resources lifetime          *
+ *             enabled_lifetime       - [IN] lost resources enabled lifetime  *
+ *             prototypes_fingerprint - [IN] digest of changelog tracked      *
+ *                                           prototypes                       *
+ *             fingerprint            - [OUT]                                 *
+ *                                                                            *
+ * Comments: The rows are digested independently of their order.              *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_rows_fingerprint(zbx_uint64_t lld_ruleid, const zbx_vector_lld_row_ptr_t *lld_rows,
+		const zbx_vector_lld_macro_path_ptr_t *lld_macro_paths, const zbx_vector_lld_override_ptr_t *overrides,
+		const zbx_lld_lifetime_t *lifetime, const zbx_lld_lifetime_t *enabled_lifetime,
+		const md5_byte_t *prototypes_fingerprint, md5_byte_t *fingerprint)
+{
+	md5_state_t	state;
+	md5_byte_t	*digests;
+
+	digests = (md5_byte_t *)zbx_malloc(NULL, (size_t)MAX(lld_rows->values_num, 1) * ZBX_MD5_DIGEST_SIZE);
+
+	for (int i = 0; i < lld_rows->values_num; i++)
+		lld_row_fingerprint(lld_rows->values[i], lld_macro_paths, digests + i * ZBX_MD5_DIGEST_SIZE);
+
+	qsort(digests, (size_t)lld_rows->values_num, ZBX_MD5_DIGEST_SIZE, lld_row_digest_compare);
+
+	zbx_md5_init(&state);
+	zbx_md5_append(&state, digests, lld_rows->values_num * ZBX_MD5_DIGEST_SIZE);
+	lld_md5_append_uint64(&state, lifetime->type);
+	lld_md5_append_uint64(&state, (zbx_uint64_t)lifetime->duration);
+	lld_md5_append_uint64(&state, enabled_lifetime->type);
+	lld_md5_append_uint64(&state, (zbx_uint64_t)enabled_lifetime->duration);
+	lld_overrides_fingerprint(&state, overrides);
+	zbx_md5_append(&state, prototypes_fingerprint, ZBX_MD5_DIGEST_SIZE);
+	lld_prototypes_untracked_fingerprint(&state, lld_ruleid);
+	zbx_md5_finish(&state, fingerprint);
+
+	zbx_free(digests);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if discovered rows changed since the last processing       *
+ *                                                                            *
+ * Parameters: lld_ruleid       - [IN] LLD rule                               *
+ *             hostid           - [IN] LLD rule host                          *
+ *             lld_rows         - [IN] discovered rows                        *
+ *             lld_macro_paths  - [IN] LLD macro paths                        *
+ *             overrides        - [IN] LLD rule overrides                     *
+ *             lifetime         - [IN] lost resources lifetime                *
+ *             enabled_lifetime - [IN] lost resources enabled lifetime        *
+ *             now              - [IN] current time                           *
+ *             rows_state       - [IN/OUT] state of the last processed rows   *
+ *                                                                            *
+ * Return value: SUCCEED - rows did not change and can be skipped             *
+ *               FAIL    - rows must be processed, the new rows state is set  *
+ *                                                                            *
+ * Comments: The rows are compared by fingerprint that also covers the rule   *
+ *           lost resource lifetimes, overrides and item, trigger, graph and  *
+ *           host prototypes. Any configuration change of the rule host,      *
+ *           including its user macros, forces the rows processing. The rows  *
+ *           are also processed at least once per ZBX_LLD_ROWS_REFRESH_PERIOD *
+ *           (or lost resource lifetime if it is shorter) to update the       *
+ *           discovery time and remove lost resources.                        *
+ *           The digest of prototypes tracked by changelog is read from       *
+ *           database only when the configuration cache LLD prototypes        *
+ *           revision changes or the rows must be refreshed, otherwise the    *
+ *           digest of the last check is reused.                              *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_rows_check_unchanged(zbx_uint64_t lld_ruleid, zbx_uint64_t hostid,
+		const zbx_vector_lld_row_ptr_t *lld_rows, const zbx_vector_lld_macro_path_ptr_t *lld_macro_paths,
+		const zbx_vector_lld_override_ptr_t *overrides, const zbx_lld_lifetime_t *lifetime,
+		const zbx_lld_lifetime_t *enabled_lifetime, int now, zbx_lld_rows_state_t *rows_state)
+{
+	md5_byte_t	fingerprint[ZBX_MD5_DIGEST_SIZE], prototypes_fingerprint[ZBX_MD5_DIGEST_SIZE];
+	zbx_uint64_t	revision, prototypes_revision;
+	int		refresh_period = ZBX_LLD_ROWS_REFRESH_PERIOD;
+
+	if (SUCCEED != zbx_dc_get_host_revision(hostid, &revision))
+		return FAIL;
+
+	if (ZBX_LLD_LIFETIME_TYPE_AFTER == lifetime->type)
+		refresh_period = MIN(refresh_period, lifetime->duration);
+
+	if (ZBX_LLD_LIFETIME_TYPE_AFTER == enabled_lifetime->type)
+		refresh_period = MIN(refresh_period, enabled_lifetime->duration);
+
+	/* the revision is read before database, so prototype changes not yet synced to cache */
+	/* are either included in the digest or will force its recalculation after the sync  */
+	prototypes_revision = zbx_dc_get_lld_prototypes_revision();
+
+	if (0 == rows_state->lastcheck || prototypes_revision != rows_state->prototypes_revision ||
+			now - rows_state->lastcheck >= refresh_period)
+	{
+		lld_prototypes_fingerprint(lld_ruleid, prototypes_fingerprint);
+	}
+	else
+		memcpy(prototypes_fingerprint, rows_state->prototypes_fingerprint, ZBX_MD5_DIGEST_SIZE);
+
+	lld_rows_fingerprint(lld_ruleid, lld_rows, lld_macro_paths, overrides, lifetime, enabled_lifetime,
+			prototypes_fingerprint, fingerprint);
+
+	rows_state->rows_num = lld_rows->values_num;
+	rows_state->prototypes_revision = prototypes_revision;
+
+	if (0 != rows_state->lastcheck && revision == rows_state->revision &&
+			now - rows_state->lastcheck < refresh_period &&
+			0 == memcmp(fingerprint, rows_state->fingerprint, ZBX_MD5_DIGEST_SIZE))
+	{
+		return SUCCEED;
+	}
+
+	rows_state->revision = revision;
+	rows_state->lastcheck = now;
+	memcpy(rows_state->fingerprint, fingerprint, ZBX_MD5_DIGEST_SIZE);
+	memcpy(rows_state->prototypes_fingerprint, prototypes_fingerprint, ZBX_MD5_DIGEST_SIZE);
+
+	return FAIL;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: adds or updates items, triggers and graphs for discovery item     *
  *                                                                            *
  * Parameters: lld_ruleid - [IN] discovery rule id from database              *
  *             value      - [IN] received value from agent                    *
+ *             rows_state - [IN/OUT] state of the last processed rows         *
  *             error      - [OUT] Error or informational message. Will be set *
  *                               to empty string on successful discovery      *
  *                               without additional information.              *
  *                                                                            *
  ******************************************************************************/
-int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char **error)
+int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, zbx_lld_rows_state_t *rows_state,
+		char **error)
 {
 #define LIFETIME_DURATION_GET(lt, lt_str)									\
 	do													\
@@ -1144,6 +1660,8 @@ int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64, __func__, lld_ruleid);
 
+	rows_state->status = ZBX_LLD_ROWS_FAILED;
+
 	um_handle = zbx_dc_open_user_macros();
 
 	zbx_vector_lld_row_ptr_create(&lld_rows);
@@ -1213,6 +1731,14 @@ int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char
 
 	now = time(NULL);
 
+	if (SUCCEED == lld_rows_check_unchanged(lld_ruleid, hostid, &lld_rows, &lld_macro_paths, &overrides,
+			&lifetime, &enabled_lifetime, (int)now, rows_state))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "skipped processing of %d unchanged rows", lld_rows.values_num);
+		rows_state->status = ZBX_LLD_ROWS_SKIPPED;
+		goto skip;
+	}
+
 	zbx_config_get(&cfg, ZBX_CONFIG_FLAGS_AUDITLOG_ENABLED | ZBX_CONFIG_FLAGS_AUDITLOG_MODE);
 	zbx_audit_init(cfg.auditlog_enabled, cfg.auditlog_mode, ZBX_AUDIT_LLD_CONTEXT);
 
@@ -1243,6 +1769,10 @@ int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char
 
 	lld_update_hosts(lld_ruleid, &lld_rows, &lld_macro_paths, error, &lifetime, &enabled_lifetime, now);
 
+	/* rows with processing errors must be processed again to report the errors */
+	if ('\0' == **error)
+		rows_state->status = ZBX_LLD_ROWS_PROCESSED;
+skip:
 	/* add informative warning to the error message about lack of data for macros used in filter */
 	if (NULL != info)
 		*error = zbx_strdcat(*error, info);
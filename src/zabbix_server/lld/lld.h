@@ -21,6 +21,8 @@
 #include "zbxcacheconfig.h"
 #include "zbxregexp.h"
 
+#include "lld_manager.h"
+
 typedef struct
 {
 	zbx_uint64_t	itemid;
@@ -389,7 +391,8 @@ typedef void	(*object_audit_entry_update_status_f)(int audit_context_mode, zbx_u
 		int status_old, int status_new);
 typedef int	(get_object_status_val)(int status);
 
-int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char **error);
+int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, zbx_lld_rows_state_t *rows_state,
+		char **error);
 
 /* discovered resource tracking (*_discovery tables) */
 typedef struct
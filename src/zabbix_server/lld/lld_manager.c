@@ -38,6 +38,11 @@
  * values in the list the rule is removed from the index (rule_index hashset),
  * otherwise the rule is enqueued back in LLD queue.
  *
+ * The manager also keeps the state of the last processed rows of each LLD rule
+ * (rows_states hashset). It is sent to the worker together with the value and
+ * allows worker to skip processing of rows that did not change. The updated
+ * state is returned with the 'done' response.
+ *
  */
 
 typedef struct
@@ -73,6 +78,13 @@ typedef struct
 	/* the number of queued LLD rules */
 	zbx_uint64_t			queued_num;
 
+	/* the last processed rows states of LLD rules */
+	zbx_hashset_t			rows_states;
+
+	/* the number of processed and skipped unchanged discovered rows */
+	zbx_uint64_t			rows_processed_num;
+	zbx_uint64_t			rows_skipped_num;
+
 }
 zbx_lld_manager_t;
 
@@ -156,7 +168,11 @@ static void	lld_manager_init(zbx_lld_manager_t *manager, zbx_get_config_forks_f
 		zbx_vector_lld_worker_ptr_append(&manager->workers, worker);
 	}
 
+	zbx_hashset_create(&manager->rows_states, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
 	manager->queued_num = 0;
+	manager->rows_processed_num = 0;
+	manager->rows_skipped_num = 0;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
@@ -326,14 +342,22 @@ static void	lld_process_next_request(zbx_lld_manager_t *manager, zbx_lld_worker_
 	unsigned char		*buf;
 	zbx_uint32_t		buf_len;
 	zbx_lld_data_t		*data;
+	zbx_lld_rows_state_t	*rows_state, rows_state_local;
 
 	elem = zbx_binary_heap_find_min(&manager->rule_queue);
 	worker->rule = elem->data;
 	zbx_binary_heap_remove_min(&manager->rule_queue);
 
 	data = worker->rule->head;
-	buf_len = zbx_lld_serialize_item_value(&buf, data->itemid, 0, data->value, &data->ts, data->meta,
-			data->lastlogsize, data->mtime, data->error);
+
+	if (NULL == (rows_state = (zbx_lld_rows_state_t *)zbx_hashset_search(&manager->rows_states, &data->itemid)))
+	{
+		memset(&rows_state_local, 0, sizeof(rows_state_local));
+		rows_state_local.itemid = data->itemid;
+		rows_state = &rows_state_local;
+	}
+
+	buf_len = zbx_lld_serialize_task(&buf, data, rows_state);
 	zbx_ipc_client_send(worker->client, ZBX_IPC_LLD_TASK, buf, buf_len);
 	zbx_free(buf);
 }
@@ -356,24 +380,98 @@ static void	lld_process_queue(zbx_lld_manager_t *manager)
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: updates LLD rule rows state returned by worker                    *
+ *                                                                            *
+ * Parameters: manager    - [IN/OUT]                                          *
+ *             rows_state - [IN] the rows state                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_update_rows_state(zbx_lld_manager_t *manager, const zbx_lld_rows_state_t *rows_state)
+{
+	zbx_lld_rows_state_t	*state;
+
+	switch (rows_state->status)
+	{
+		case ZBX_LLD_ROWS_PROCESSED:
+			manager->rows_processed_num += (zbx_uint64_t)rows_state->rows_num;
+
+			if (NULL == (state = (zbx_lld_rows_state_t *)zbx_hashset_search(&manager->rows_states,
+					&rows_state->itemid)))
+			{
+				zbx_hashset_insert(&manager->rows_states, rows_state, sizeof(zbx_lld_rows_state_t));
+			}
+			else
+				*state = *rows_state;
+			break;
+		case ZBX_LLD_ROWS_SKIPPED:
+			manager->rows_skipped_num += (zbx_uint64_t)rows_state->rows_num;
+
+			/* skipped rows were checked against unchanged prototypes of the newer revision */
+			if (NULL != (state = (zbx_lld_rows_state_t *)zbx_hashset_search(&manager->rows_states,
+					&rows_state->itemid)))
+			{
+				state->prototypes_revision = rows_state->prototypes_revision;
+			}
+			break;
+		case ZBX_LLD_ROWS_FAILED:
+			zbx_hashset_remove(&manager->rows_states, &rows_state->itemid);
+			break;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes rows states of LLD rules that were not processed for a    *
+ *          long time                                                         *
+ *                                                                            *
+ * Parameters: manager - [IN/OUT]                                             *
+ *             now     - [IN] current time                                    *
+ *                                                                            *
+ * Comments: The rows state is refreshed at least once per                    *
+ *           ZBX_LLD_ROWS_REFRESH_PERIOD, so older states belong to removed   *
+ *           or disabled rules.                                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_flush_rows_states(zbx_lld_manager_t *manager, int now)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_lld_rows_state_t	*rows_state;
+
+	zbx_hashset_iter_reset(&manager->rows_states, &iter);
+
+	while (NULL != (rows_state = (zbx_lld_rows_state_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (rows_state->lastcheck + 2 * ZBX_LLD_ROWS_REFRESH_PERIOD < now)
+			zbx_hashset_iter_remove(&iter);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: processes LLD worker 'done' response                              *
  *                                                                            *
  * Parameters: manager - [IN]                                                 *
  *             client  - [IN] worker's IPC client connection                  *
+ *             message - [IN] received message                                *
  *                                                                            *
  ******************************************************************************/
-static void	lld_process_result(zbx_lld_manager_t *manager, zbx_ipc_client_t *client)
+static void	lld_process_result(zbx_lld_manager_t *manager, zbx_ipc_client_t *client,
+		const zbx_ipc_message_t *message)
 {
 	zbx_lld_worker_t	*worker;
 	zbx_lld_rule_t		*rule;
 	zbx_lld_data_t		*data;
+	zbx_lld_rows_state_t	rows_state;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	worker = lld_get_worker_by_client(manager, client);
 
+	zbx_lld_deserialize_rows_state(message->data, &rows_state);
+	lld_update_rows_state(manager, &rows_state);
+
 	zabbix_log(LOG_LEVEL_DEBUG, "discovery rule:" ZBX_FS_UI64 " has been processed", worker->rule->head->itemid);
 
 	rule = worker->rule;
@@ -416,7 +514,8 @@ static void	lld_process_diag_stats(zbx_lld_manager_t *manager, zbx_ipc_client_t
 	unsigned char	*data;
 	zbx_uint32_t	data_len;
 
-	data_len = zbx_lld_serialize_diag_stats(&data, manager->rule_index.num_data, manager->queued_num);
+	data_len = zbx_lld_serialize_diag_stats(&data, manager->rule_index.num_data, manager->queued_num,
+			manager->rows_processed_num, manager->rows_skipped_num);
 	zbx_ipc_client_send(client, ZBX_IPC_LLD_DIAG_STATS_RESULT, data, data_len);
 	zbx_free(data);
 }
@@ -513,7 +612,7 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 	char			*error = NULL;
 	zbx_ipc_client_t	*client;
 	zbx_ipc_message_t	*message;
-	double			time_stat, time_now, sec, time_idle = 0;
+	double			time_stat, time_now, sec, time_idle = 0, time_flush;
 	zbx_lld_manager_t	manager;
 	zbx_uint64_t		processed_num = 0;
 	zbx_timespec_t		timeout = {1, 0};
@@ -540,6 +639,7 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 
 	/* initialize statistics */
 	time_stat = zbx_time();
+	time_flush = time_stat;
 
 	zbx_setproctitle("%s #%d started", get_process_type_string(process_type), process_num);
 
@@ -561,6 +661,12 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 			processed_num = 0;
 		}
 
+		if (ZBX_LLD_ROWS_REFRESH_PERIOD < time_now - time_flush)
+		{
+			lld_flush_rows_states(&manager, (int)time_now);
+			time_flush = time_now;
+		}
+
 		zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_IDLE);
 		ret = zbx_ipc_service_recv(&lld_service, &timeout, &client, &message);
 		zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_BUSY);
@@ -583,7 +689,7 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 					lld_process_queue(&manager);
 					break;
 				case ZBX_IPC_LLD_DONE:
-					lld_process_result(&manager, client);
+					lld_process_result(&manager, client, message);
 					processed_num++;
 					manager.queued_num--;
 					break;
@@ -18,6 +18,7 @@
 #include "zbxthreads.h"
 #include "zbxtime.h"
 #include "zbxalgo.h"
+#include "zbxhash.h"
 
 typedef struct zbx_lld_value
 {
@@ -63,6 +64,43 @@ typedef struct
 }
 zbx_lld_rule_info_t;
 
+/* the maximum time unchanged rows are not processed */
+#define ZBX_LLD_ROWS_REFRESH_PERIOD	SEC_PER_HOUR
+
+#define ZBX_LLD_ROWS_NONE	0	/* rows were not processed, the state is not changed */
+#define ZBX_LLD_ROWS_PROCESSED	1	/* rows were processed and the state was updated */
+#define ZBX_LLD_ROWS_SKIPPED	2	/* rows were not changed since the last processing */
+#define ZBX_LLD_ROWS_FAILED	3	/* rows processing failed, the state must be reset */
+
+/* state of the rows discovered by LLD rule, used to skip processing of unchanged rows */
+typedef struct
+{
+	/* the LLD rule item id */
+	zbx_uint64_t	itemid;
+
+	/* the LLD rule host configuration revision when the rows were processed */
+	zbx_uint64_t	revision;
+
+	/* the time rows were last processed, 0 if never */
+	int		lastcheck;
+
+	/* the number of discovered rows */
+	int		rows_num;
+
+	/* the result of the last value processing (ZBX_LLD_ROWS_*) */
+	unsigned char	status;
+
+	/* order independent digest of the discovered rows */
+	md5_byte_t	fingerprint[ZBX_MD5_DIGEST_SIZE];
+
+	/* the configuration cache LLD prototypes revision when prototypes_fingerprint was calculated */
+	zbx_uint64_t	prototypes_revision;
+
+	/* digest of the prototype definitions tracked by configuration cache changelog */
+	md5_byte_t	prototypes_fingerprint[ZBX_MD5_DIGEST_SIZE];
+}
+zbx_lld_rows_state_t;
+
 ZBX_PTR_VECTOR_DECL(lld_rule_info_ptr, zbx_lld_rule_info_t*)
 
 typedef struct
@@ -18,9 +18,9 @@
 #include "zbxipcservice.h"
 #include "zbxsysinfo.h"
 
-zbx_uint32_t	zbx_lld_serialize_item_value(unsigned char **data, zbx_uint64_t itemid, zbx_uint64_t hostid,
+static zbx_uint32_t	lld_serialize_item_value(unsigned char **data, zbx_uint64_t itemid, zbx_uint64_t hostid,
 		const char *value, const zbx_timespec_t *ts, unsigned char meta, zbx_uint64_t lastlogsize, int mtime,
-		const char *error)
+		const char *error, const zbx_lld_rows_state_t *rows_state)
 {
 	unsigned char	*ptr;
 	zbx_uint32_t	data_len = 0, value_len, error_len;
@@ -38,6 +38,9 @@ zbx_uint32_t	zbx_lld_serialize_item_value(unsigned char **data, zbx_uint64_t ite
 		zbx_serialize_prepare_value(data_len, mtime);
 	}
 
+	if (NULL != rows_state)
+		zbx_serialize_prepare_value(data_len, *rows_state);
+
 	*data = (unsigned char *)zbx_malloc(NULL, data_len);
 
 	ptr = *data;
@@ -50,15 +53,18 @@ zbx_uint32_t	zbx_lld_serialize_item_value(unsigned char **data, zbx_uint64_t ite
 	if (0 != meta)
 	{
 		ptr += zbx_serialize_value(ptr, lastlogsize);
-		(void)zbx_serialize_value(ptr, mtime);
+		ptr += zbx_serialize_value(ptr, mtime);
 	}
 
+	if (NULL != rows_state)
+		(void)zbx_serialize_value(ptr, *rows_state);
+
 	return data_len;
 }
 
-void	zbx_lld_deserialize_item_value(const unsigned char *data, zbx_uint64_t *itemid, zbx_uint64_t *hostid,
+static void	lld_deserialize_item_value(const unsigned char *data, zbx_uint64_t *itemid, zbx_uint64_t *hostid,
 		char **value, zbx_timespec_t *ts, unsigned char *meta, zbx_uint64_t *lastlogsize, int *mtime,
-		char **error)
+		char **error, zbx_lld_rows_state_t *rows_state)
 {
 	zbx_uint32_t	value_len, error_len;
 
@@ -71,32 +77,88 @@ void	zbx_lld_deserialize_item_value(const unsigned char *data, zbx_uint64_t *ite
 	if (0 != *meta)
 	{
 		data += zbx_deserialize_value(data, lastlogsize);
-		(void)zbx_deserialize_value(data, mtime);
+		data += zbx_deserialize_value(data, mtime);
 	}
+
+	if (NULL != rows_state)
+		(void)zbx_deserialize_value(data, rows_state);
+}
+
+zbx_uint32_t	zbx_lld_serialize_item_value(unsigned char **data, zbx_uint64_t itemid, zbx_uint64_t hostid,
+		const char *value, const zbx_timespec_t *ts, unsigned char meta, zbx_uint64_t lastlogsize, int mtime,
+		const char *error)
+{
+	return lld_serialize_item_value(data, itemid, hostid, value, ts, meta, lastlogsize, mtime, error, NULL);
+}
+
+void	zbx_lld_deserialize_item_value(const unsigned char *data, zbx_uint64_t *itemid, zbx_uint64_t *hostid,
+		char **value, zbx_timespec_t *ts, unsigned char *meta, zbx_uint64_t *lastlogsize, int *mtime,
+		char **error)
+{
+	lld_deserialize_item_value(data, itemid, hostid, value, ts, meta, lastlogsize, mtime, error, NULL);
+}
+
+zbx_uint32_t	zbx_lld_serialize_task(unsigned char **data, const zbx_lld_data_t *lld_data,
+		const zbx_lld_rows_state_t *rows_state)
+{
+	return lld_serialize_item_value(data, lld_data->itemid, 0, lld_data->value, &lld_data->ts, lld_data->meta,
+			lld_data->lastlogsize, lld_data->mtime, lld_data->error, rows_state);
+}
+
+void	zbx_lld_deserialize_task(const unsigned char *data, zbx_uint64_t *itemid, char **value, zbx_timespec_t *ts,
+		unsigned char *meta, zbx_uint64_t *lastlogsize, int *mtime, char **error,
+		zbx_lld_rows_state_t *rows_state)
+{
+	zbx_uint64_t	hostid;
+
+	lld_deserialize_item_value(data, itemid, &hostid, value, ts, meta, lastlogsize, mtime, error, rows_state);
+}
+
+zbx_uint32_t	zbx_lld_serialize_rows_state(unsigned char **data, const zbx_lld_rows_state_t *rows_state)
+{
+	zbx_uint32_t	data_len = 0;
+
+	zbx_serialize_prepare_value(data_len, *rows_state);
+	*data = (unsigned char *)zbx_malloc(NULL, data_len);
+	(void)zbx_serialize_value(*data, *rows_state);
+
+	return data_len;
+}
+
+void	zbx_lld_deserialize_rows_state(const unsigned char *data, zbx_lld_rows_state_t *rows_state)
+{
+	(void)zbx_deserialize_value(data, rows_state);
 }
 
-zbx_uint32_t	zbx_lld_serialize_diag_stats(unsigned char **data, zbx_uint64_t items_num, zbx_uint64_t values_num)
+zbx_uint32_t	zbx_lld_serialize_diag_stats(unsigned char **data, zbx_uint64_t items_num, zbx_uint64_t values_num,
+		zbx_uint64_t rows_processed_num, zbx_uint64_t rows_skipped_num)
 {
 	unsigned char	*ptr;
 	zbx_uint32_t	data_len = 0;
 
 	zbx_serialize_prepare_value(data_len, items_num);
 	zbx_serialize_prepare_value(data_len, values_num);
+	zbx_serialize_prepare_value(data_len, rows_processed_num);
+	zbx_serialize_prepare_value(data_len, rows_skipped_num);
 
 	*data = (unsigned char *)zbx_malloc(NULL, data_len);
 
 	ptr = *data;
 	ptr += zbx_serialize_value(ptr, items_num);
-	(void)zbx_serialize_value(ptr, values_num);
+	ptr += zbx_serialize_value(ptr, values_num);
+	ptr += zbx_serialize_value(ptr, rows_processed_num);
+	(void)zbx_serialize_value(ptr, rows_skipped_num);
 
 	return data_len;
 }
 
 static void	zbx_lld_deserialize_diag_stats(const unsigned char *data, zbx_uint64_t *items_num,
-		zbx_uint64_t *values_num)
+		zbx_uint64_t *values_num, zbx_uint64_t *rows_processed_num, zbx_uint64_t *rows_skipped_num)
 {
 	data += zbx_deserialize_value(data, items_num);
-	(void)zbx_deserialize_value(data, values_num);
+	data += zbx_deserialize_value(data, values_num);
+	data += zbx_deserialize_value(data, rows_processed_num);
+	(void)zbx_deserialize_value(data, rows_skipped_num);
 }
 
 static zbx_uint32_t	zbx_lld_serialize_top_items_request(unsigned char **data, int limit)
@@ -288,7 +350,8 @@ out:
  * Purpose: gets LLD manager diagnostic statistics                            *
  *                                                                            *
  ******************************************************************************/
-int	zbx_lld_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num, char **error)
+int	zbx_lld_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num, zbx_uint64_t *rows_processed_num,
+		zbx_uint64_t *rows_skipped_num, char **error)
 {
 	unsigned char	*result;
 
@@ -298,7 +361,7 @@ int	zbx_lld_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num, ch
 		return FAIL;
 	}
 
-	zbx_lld_deserialize_diag_stats(result, items_num, values_num);
+	zbx_lld_deserialize_diag_stats(result, items_num, values_num, rows_processed_num, rows_skipped_num);
 	zbx_free(result);
 
 	return SUCCEED;
@@ -54,7 +54,19 @@ void	zbx_lld_deserialize_item_value(const unsigned char *data, zbx_uint64_t *ite
 		char **value, zbx_timespec_t *ts, unsigned char *meta, zbx_uint64_t *lastlogsize, int *mtime,
 		char **error);
 
-zbx_uint32_t	zbx_lld_serialize_diag_stats(unsigned char **data, zbx_uint64_t items_num, zbx_uint64_t values_num);
+zbx_uint32_t	zbx_lld_serialize_task(unsigned char **data, const zbx_lld_data_t *lld_data,
+		const zbx_lld_rows_state_t *rows_state);
+
+void	zbx_lld_deserialize_task(const unsigned char *data, zbx_uint64_t *itemid, char **value, zbx_timespec_t *ts,
+		unsigned char *meta, zbx_uint64_t *lastlogsize, int *mtime, char **error,
+		zbx_lld_rows_state_t *rows_state);
+
+zbx_uint32_t	zbx_lld_serialize_rows_state(unsigned char **data, const zbx_lld_rows_state_t *rows_state);
+
+void	zbx_lld_deserialize_rows_state(const unsigned char *data, zbx_lld_rows_state_t *rows_state);
+
+zbx_uint32_t	zbx_lld_serialize_diag_stats(unsigned char **data, zbx_uint64_t items_num, zbx_uint64_t values_num,
+		zbx_uint64_t rows_processed_num, zbx_uint64_t rows_skipped_num);
 
 void	zbx_lld_deserialize_top_items_request(const unsigned char *data, int *limit);
 
@@ -69,7 +81,8 @@ void	zbx_lld_process_agent_result(zbx_uint64_t itemid, zbx_uint64_t hostid, AGEN
 
 int	zbx_lld_get_queue_size(zbx_uint64_t *size, char **error);
 
-int	zbx_lld_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num, char **error);
+int	zbx_lld_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num, zbx_uint64_t *rows_processed_num,
+		zbx_uint64_t *rows_skipped_num, char **error);
 
 int	zbx_lld_get_top_items(int limit, zbx_vector_uint64_pair_t *items, char **error);
 
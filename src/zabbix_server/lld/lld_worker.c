@@ -50,12 +50,13 @@ static void	lld_register_worker(zbx_ipc_socket_t *socket)
  * Purpose: Processes LLD task and updates rule state/error in configuration  *
  *          cache and database.                                               *
  *                                                                            *
- * Parameters: message - [IN] message with LLD request                        *
+ * Parameters: message    - [IN] message with LLD request                     *
+ *             rows_state - [OUT] the discovered rows state                   *
  *                                                                            *
  ******************************************************************************/
-static void	lld_process_task(const zbx_ipc_message_t *message)
+static void	lld_process_task(const zbx_ipc_message_t *message, zbx_lld_rows_state_t *rows_state)
 {
-	zbx_uint64_t		itemid, hostid, lastlogsize;
+	zbx_uint64_t		itemid, lastlogsize;
 	char			*value, *error;
 	zbx_timespec_t		ts;
 	zbx_item_diff_t		diff;
@@ -65,13 +66,18 @@ static void	lld_process_task(const zbx_ipc_message_t *message)
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_lld_deserialize_item_value(message->data, &itemid, &hostid, &value, &ts, &meta, &lastlogsize, &mtime,
-			&error);
+	zbx_lld_deserialize_task(message->data, &itemid, &value, &ts, &meta, &lastlogsize, &mtime, &error,
+			rows_state);
+
+	rows_state->status = ZBX_LLD_ROWS_NONE;
 
 	zbx_dc_config_get_items_by_itemids(&item, &itemid, &errcode, 1);
 
 	if (SUCCEED != errcode)
+	{
+		rows_state->status = ZBX_LLD_ROWS_FAILED;
 		goto out;
+	}
 
 	zabbix_log(LOG_LEVEL_DEBUG, "processing discovery rule:" ZBX_FS_UI64, itemid);
 
@@ -79,10 +85,15 @@ static void	lld_process_task(const zbx_ipc_message_t *message)
 
 	if (NULL != error || NULL != value)
 	{
-		if (NULL == error && SUCCEED == lld_process_discovery_rule(itemid, value, &error))
+		if (NULL == error && SUCCEED == lld_process_discovery_rule(itemid, value, rows_state, &error))
+		{
 			state = ITEM_STATE_NORMAL;
+		}
 		else
+		{
 			state = ITEM_STATE_NOTSUPPORTED;
+			rows_state->status = ZBX_LLD_ROWS_FAILED;
+		}
 
 		if (state != item.state)
 		{
@@ -170,6 +181,9 @@ ZBX_THREAD_ENTRY(lld_worker_thread, args)
 	char			*error = NULL;
 	zbx_ipc_socket_t	lld_socket;
 	zbx_ipc_message_t	message;
+	zbx_lld_rows_state_t	rows_state;
+	unsigned char		*data;
+	zbx_uint32_t		data_len;
 	double			time_stat, time_idle = 0, time_now, time_read;
 	zbx_uint64_t		processed_num = 0;
 	zbx_thread_info_t	*info = &((zbx_thread_args_t *)args)->info;
@@ -233,8 +247,10 @@ ZBX_THREAD_ENTRY(lld_worker_thread, args)
 		switch (message.code)
 		{
 			case ZBX_IPC_LLD_TASK:
-				lld_process_task(&message);
-				zbx_ipc_socket_write(&lld_socket, ZBX_IPC_LLD_DONE, NULL, 0);
+				lld_process_task(&message, &rows_state);
+				data_len = zbx_lld_serialize_rows_state(&data, &rows_state);
+				zbx_ipc_socket_write(&lld_socket, ZBX_IPC_LLD_DONE, data, data_len);
+				zbx_free(data);
 				processed_num++;
 				break;
 		}
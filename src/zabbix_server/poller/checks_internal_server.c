@@ -18,6 +18,7 @@
 #include "../lld/lld_protocol.h"
 
 #include "zbxcachevalue.h"
+#include "zbxcachehistory.h"
 #include "zbxcacheconfig.h"
 #include "zbxconnector.h"
 #include "zbxproxybuffer.h"
@@ -235,6 +236,64 @@ int	zbx_get_value_internal_ext_server(const zbx_dc_item_t *item, const char *par
 			goto out;
 		}
 	}
+	else if (0 == strcmp(param1, "history_sync"))		/* zabbix[history_sync,<stage>] */
+	{
+		int	stage;
+
+		if (2 != nparams)
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters."));
+			goto out;
+		}
+
+		param2 = get_rparam(request, 1);
+
+		if (0 == strcmp(param2, "prepare"))
+			stage = ZBX_HC_SYNC_STAGE_PREPARE;
+		else if (0 == strcmp(param2, "history"))
+			stage = ZBX_HC_SYNC_STAGE_HISTORY;
+		else if (0 == strcmp(param2, "trends"))
+			stage = ZBX_HC_SYNC_STAGE_TRENDS;
+		else if (0 == strcmp(param2, "items"))
+			stage = ZBX_HC_SYNC_STAGE_ITEMS;
+		else if (0 == strcmp(param2, "triggers"))
+			stage = ZBX_HC_SYNC_STAGE_TRIGGERS;
+		else if (0 == strcmp(param2, "export"))
+			stage = ZBX_HC_SYNC_STAGE_EXPORT;
+		else
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
+			goto out;
+		}
+
+		SET_DBL_RESULT(result, zbx_hc_get_sync_stage_time(stage));
+	}
+	else if (0 == strcmp(param1, "trigger_functions"))	/* zabbix[trigger_functions,<counter>] */
+	{
+		int	counter;
+
+		if (2 != nparams)
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters."));
+			goto out;
+		}
+
+		param2 = get_rparam(request, 1);
+
+		if (0 == strcmp(param2, "references"))
+			counter = ZBX_HC_TRIGGER_FUNCS_REFERENCES;
+		else if (0 == strcmp(param2, "unique"))
+			counter = ZBX_HC_TRIGGER_FUNCS_UNIQUE;
+		else if (0 == strcmp(param2, "evaluated"))
+			counter = ZBX_HC_TRIGGER_FUNCS_EVALUATED;
+		else
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
+			goto out;
+		}
+
+		SET_UI64_RESULT(result, zbx_hc_get_trigger_funcs_stats(counter));
+	}
 	else if (0 == strcmp(param1, "lld_queue"))
 	{
 		zbx_uint64_t	value;
@@ -145,6 +145,8 @@ static const char	*help_message[] = {
 	"                                        target is not specified",
 	"      " ZBX_PROF_DISABLE "=target             Disable profiling, affects all processes if",
 	"                                        target is not specified",
+	"      " ZBX_PROF_DUMP "=target                Log profiling latency histograms in JSON format,",
+	"                                        affects all processes if target is not specified",
 	"      " ZBX_SERVICE_CACHE_RELOAD "             Reload service manager cache",
 	"      " ZBX_HA_STATUS "                        Display HA cluster status",
 	"      " ZBX_HA_REMOVE_NODE "=target            Remove the HA node specified by its name or ID",
@@ -308,6 +310,7 @@ static char	*config_server		= NULL;		/* not used in zabbix_server, required for
 
 static int	config_housekeeping_frequency	= 1;
 static int	config_max_housekeeper_delete	= 5000;		/* applies for every separate field value */
+static int	config_housekeeping_partitions	= 0;
 static int	config_confsyncer_frequency	= 10;
 
 static int	config_problemhousekeeping_frequency = 60;
@@ -317,6 +320,7 @@ static int	config_vmware_perf_frequency	= 60;
 static int	config_vmware_timeout		= 10;
 
 static zbx_uint64_t	config_conf_cache_size		= 32 * ZBX_MEBIBYTE;
+static char		*config_cache_snapshot_file	= NULL;
 static zbx_uint64_t	config_history_cache_size	= 16 * ZBX_MEBIBYTE;
 static zbx_uint64_t	config_history_index_cache_size	= 4 * ZBX_MEBIBYTE;
 static zbx_uint64_t	config_trends_cache_size	= 4 * ZBX_MEBIBYTE;
@@ -327,6 +331,8 @@ static zbx_uint64_t	config_vmware_cache_size	= 8 * ZBX_MEBIBYTE;
 static int	config_unreachable_period		= 45;
 static int	config_unreachable_delay		= 15;
 static int	config_max_concurrent_checks_per_poller	= 1000;
+static int	config_value_cache_compression		= 0;
+static int	config_cache_slabs			= 0;
 static int	config_log_level		= LOG_LEVEL_WARNING;
 static char	*config_externalscripts		= NULL;
 static int	config_allow_unsupported_db_versions = 0;
@@ -908,9 +914,13 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 				ZBX_CONF_PARM_OPT,	0,			0},
 		{"StartSNMPTrapper",		&config_forks[ZBX_PROCESS_TYPE_SNMPTRAPPER],
 											ZBX_CFG_TYPE_INT,
-				ZBX_CONF_PARM_OPT,	0,			1},
+				ZBX_CONF_PARM_OPT,	0,			100},
 		{"CacheSize",			&config_conf_cache_size,		ZBX_CFG_TYPE_UINT64,
 				ZBX_CONF_PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(64) * ZBX_GIBIBYTE},
+		{"CacheSnapshotFile",		&config_cache_snapshot_file,		ZBX_CFG_TYPE_STRING,
+				ZBX_CONF_PARM_OPT,	0,			0},
+		{"CacheSlabAllocation",		&config_cache_slabs,			ZBX_CFG_TYPE_INT,
+				ZBX_CONF_PARM_OPT,	0,			1},
 		{"HistoryCacheSize",		&config_history_cache_size,		ZBX_CFG_TYPE_UINT64,
 				ZBX_CONF_PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"HistoryIndexCacheSize",	&config_history_index_cache_size,	ZBX_CFG_TYPE_UINT64,
@@ -921,12 +931,16 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 				ZBX_CONF_PARM_OPT,	0,			__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"ValueCacheSize",		&config_value_cache_size,		ZBX_CFG_TYPE_UINT64,
 				ZBX_CONF_PARM_OPT,	0,			__UINT64_C(64) * ZBX_GIBIBYTE},
+		{"ValueCacheCompression",	&config_value_cache_compression,	ZBX_CFG_TYPE_INT,
+				ZBX_CONF_PARM_OPT,	0,			1},
 		{"CacheUpdateFrequency",	&config_confsyncer_frequency,		ZBX_CFG_TYPE_INT,
 				ZBX_CONF_PARM_OPT,	1,			SEC_PER_HOUR},
 		{"HousekeepingFrequency",	&config_housekeeping_frequency,		ZBX_CFG_TYPE_INT,
 				ZBX_CONF_PARM_OPT,	0,			24},
 		{"MaxHousekeeperDelete",	&config_max_housekeeper_delete,		ZBX_CFG_TYPE_INT,
 				ZBX_CONF_PARM_OPT,	0,			1000000},
+		{"HousekeepingPartitions",	&config_housekeeping_partitions,	ZBX_CFG_TYPE_INT,
+				ZBX_CONF_PARM_OPT,	0,			1},
 		{"TmpDir",			&zbx_config_tmpdir,			ZBX_CFG_TYPE_STRING,
 				ZBX_CONF_PARM_OPT,	0,			0},
 		{"FpingLocation",		&zbx_config_fping_location,		ZBX_CFG_TYPE_STRING,
@@ -1012,6 +1026,9 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 		{"DBTLSCipher13",		&(zbx_config_dbhigh->config_db_tls_cipher_13),
 											ZBX_CFG_TYPE_STRING,
 				ZBX_CONF_PARM_OPT,	0,			0},
+		{"DBBulkCopy",			&(zbx_config_dbhigh->config_db_bulk_copy),
+											ZBX_CFG_TYPE_INT,
+				ZBX_CONF_PARM_OPT,	0,			1},
 		{"SSHKeyLocation",		&config_ssh_key_location,		ZBX_CFG_TYPE_STRING,
 				ZBX_CONF_PARM_OPT,	0,			0},
 		{"LogSlowQueries",		&config_log_slow_queries,		ZBX_CFG_TYPE_INT,
@@ -1573,7 +1590,8 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 							zbx_config_tls->key_file, zbx_config_source_ip,
 							zbx_config_webservice_url};
 	zbx_thread_housekeeper_args	housekeeper_args = {&db_version_info, zbx_config_timeout,
-							config_housekeeping_frequency, config_max_housekeeper_delete};
+							config_housekeeping_frequency, config_max_housekeeper_delete,
+							config_housekeeping_partitions};
 	zbx_thread_server_trigger_housekeeper_args	trigger_housekeeper_args = {zbx_config_timeout,
 							config_problemhousekeeping_frequency};
 	zbx_thread_taskmanager_args	taskmanager_args = {zbx_config_timeout, config_startup_time};
@@ -1609,13 +1627,16 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 								config_vmware_perf_frequency, config_vmware_timeout};
 	zbx_thread_timer_args		timer_args = {get_config_forks};
 	zbx_thread_snmptrapper_args	snmptrapper_args = {.config_snmptrap_file = zbx_config_snmptrap_file,
-								.config_ha_node_name = CONFIG_HA_NODE_NAME};
+								.config_ha_node_name = CONFIG_HA_NODE_NAME,
+								.workers_num =
+								config_forks[ZBX_PROCESS_TYPE_SNMPTRAPPER]};
 	zbx_thread_service_manager_args	service_manager_args = {.config_timeout = zbx_config_timeout,
 								.config_service_manager_sync_frequency =
 								config_service_manager_sync_frequency};
 
 	if (SUCCEED != zbx_init_database_cache(get_zbx_program_type, zbx_sync_server_history, config_history_cache_size,
-			config_history_index_cache_size, &config_trends_cache_size, &error))
+			config_history_index_cache_size, &config_trends_cache_size,
+			config_forks[ZBX_PROCESS_TYPE_HISTSYNCER], config_cache_slabs, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize database cache: %s", error);
 		zbx_free(error);
@@ -1623,7 +1644,7 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 	}
 
 	if (SUCCEED != zbx_init_configuration_cache(get_zbx_program_type, get_config_forks, config_conf_cache_size,
-			NULL, &error))
+			NULL, config_cache_snapshot_file, config_cache_slabs, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize configuration cache: %s", error);
 		zbx_free(error);
@@ -1646,7 +1667,8 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 		return FAIL;
 	}
 
-	if (SUCCEED != zbx_vc_init(config_value_cache_size, &error))
+	if (SUCCEED != zbx_vc_init(config_value_cache_size, config_value_cache_compression, config_cache_slabs,
+			&error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize history value cache: %s", error);
 		zbx_free(error);
@@ -2288,7 +2310,8 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 	}
 
 	if (SUCCEED != zbx_init_database_cache(get_zbx_program_type, zbx_sync_server_history, config_history_cache_size,
-			config_history_index_cache_size, &config_trends_cache_size, &error))
+			config_history_index_cache_size, &config_trends_cache_size,
+			config_forks[ZBX_PROCESS_TYPE_HISTSYNCER], config_cache_slabs, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize database cache: %s", error);
 		zbx_free(error);
@@ -56,9 +56,11 @@ AC_DEFUN([CONF_TESTS],
 			tests/libs/zbxcomms/Makefile
 			tests/libs/zbxcommshigh/Makefile
 			tests/libs/zbxcfg/Makefile
+			tests/libs/zbxcachehistory/Makefile
 			tests/libs/zbxcachevalue/Makefile
 			tests/libs/zbxcacheconfig/Makefile
 			tests/libs/zbxdbhigh/Makefile
+			tests/libs/zbxdbwrap/Makefile
 			tests/libs/zbxeval/Makefile
 			tests/libs/zbxexpr/Makefile
 			tests/libs/zbxfile/Makefile
@@ -71,10 +73,13 @@ AC_DEFUN([CONF_TESTS],
 			tests/libs/zbxparam/Makefile
 			tests/libs/zbxpreproc/Makefile
 			tests/libs/zbxprometheus/Makefile
+			tests/libs/zbxprof/Makefile
+			tests/libs/zbxproxybuffer/Makefile
 			tests/libs/zbxregexp/Makefile
 			tests/libs/zbxexpression/Makefile
 			tests/libs/zbxsysinfo/Makefile
 			tests/libs/zbxsysinfo/common/Makefile
+			tests/libs/zbxshmem/Makefile
 			tests/libs/zbxstr/Makefile
 			tests/libs/zbxtagfilter/Makefile
 			tests/libs/zbxtrends/Makefile
@@ -82,12 +87,18 @@ AC_DEFUN([CONF_TESTS],
 			tests/libs/zbxtime/Makefile
 			tests/libs/zbxvariant/Makefile
 			tests/libs/zbxxml/Makefile
+			tests/libs/zbxvmware/Makefile
+			tests/libs/zbxsnmptrapper/Makefile
 			tests/libs/zbxodbc/Makefile
 			tests/zabbix_server/Makefile
 			tests/zabbix_server/pinger/Makefile
 			tests/zabbix_server/service/Makefile
 			tests/zabbix_server/trapper/Makefile
 			tests/zabbix_server/lld/Makefile
+			tests/zabbix_server/housekeeper/Makefile
+			tests/zabbix_server/cachehistory/Makefile
+			tests/zabbix_agent/Makefile
+			tests/zabbix_agent/logfiles/Makefile
 			tests/mocks/Makefile
 			tests/mocks/configcache/Makefile
 			tests/mocks/valuecache/Makefile
@@ -0,0 +1,253 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxalgo.h"
+
+/* Operations are applied to a heap with key index (direct option) and to a heap storing element */
+/* positions in element data (index option). The key index heap serves as the reference.         */
+
+typedef struct
+{
+	zbx_uint64_t	key;
+	int		value;
+	int		queue_index;
+	int		queued;
+}
+mock_elem_t;
+
+static int	mock_elem_compare(const void *d1, const void *d2)
+{
+	const mock_elem_t	*e1 = (const mock_elem_t *)((const zbx_binary_heap_elem_t *)d1)->data;
+	const mock_elem_t	*e2 = (const mock_elem_t *)((const zbx_binary_heap_elem_t *)d2)->data;
+
+	ZBX_RETURN_IF_NOT_EQUAL(e1->value, e2->value);
+	ZBX_RETURN_IF_NOT_EQUAL(e1->key, e2->key);
+
+	return 0;
+}
+
+static void	mock_heaps_check(zbx_binary_heap_t *direct, zbx_binary_heap_t *index)
+{
+	int	i;
+
+	zbx_mock_assert_int_eq("number of elements", direct->elems_num, index->elems_num);
+
+	for (i = 0; i < index->elems_num; i++)
+	{
+		const mock_elem_t	*elem = (const mock_elem_t *)index->elems[i].data;
+
+		zbx_mock_assert_int_eq("stored element position", i, elem->queue_index);
+		zbx_mock_assert_uint64_eq("element key", elem->key, index->elems[i].key);
+
+		if (0 != i && 0 < mock_elem_compare(&index->elems[(i - 1) / 2], &index->elems[i]))
+			fail_msg("heap order is broken at position %d", i);
+	}
+
+	if (0 != direct->elems_num)
+	{
+		zbx_mock_assert_uint64_eq("minimum element", zbx_binary_heap_find_min(direct)->key,
+				zbx_binary_heap_find_min(index)->key);
+	}
+}
+
+static mock_elem_t	*mock_elem_get(zbx_vector_ptr_t *elems, zbx_uint64_t key)
+{
+	mock_elem_t	*elem;
+	int		i;
+
+	for (i = 0; i < elems->values_num; i++)
+	{
+		if (((mock_elem_t *)elems->values[i])->key == key)
+			return (mock_elem_t *)elems->values[i];
+	}
+
+	elem = (mock_elem_t *)zbx_malloc(NULL, sizeof(mock_elem_t));
+	memset(elem, 0, sizeof(mock_elem_t));
+	elem->key = key;
+	elem->queue_index = -1;
+	zbx_vector_ptr_append(elems, elem);
+
+	return elem;
+}
+
+static void	mock_heaps_insert(zbx_binary_heap_t *direct, zbx_binary_heap_t *index, mock_elem_t *elem, int value)
+{
+	zbx_binary_heap_elem_t	heap_elem = {elem->key, elem};
+
+	elem->value = value;
+	elem->queued = 1;
+	zbx_binary_heap_insert(direct, &heap_elem);
+	zbx_binary_heap_insert(index, &heap_elem);
+}
+
+static void	mock_heaps_update(zbx_binary_heap_t *direct, zbx_binary_heap_t *index, mock_elem_t *elem, int value)
+{
+	zbx_binary_heap_elem_t	heap_elem = {elem->key, elem};
+
+	elem->value = value;
+	zbx_binary_heap_update_direct(direct, &heap_elem);
+	zbx_binary_heap_update_direct(index, &heap_elem);
+}
+
+static void	mock_heaps_remove(zbx_binary_heap_t *direct, zbx_binary_heap_t *index, mock_elem_t *elem)
+{
+	zbx_binary_heap_elem_t	heap_elem = {elem->key, elem};
+
+	elem->queued = 0;
+	zbx_binary_heap_remove_direct(direct, elem->key);
+	zbx_binary_heap_remove_index(index, &heap_elem);
+}
+
+static zbx_uint64_t	mock_heaps_pop(zbx_binary_heap_t *direct, zbx_binary_heap_t *index)
+{
+	zbx_binary_heap_elem_t	*elem;
+	zbx_uint64_t		key;
+
+	if (SUCCEED == zbx_binary_heap_empty(index))
+		fail_msg("cannot pop element from empty heap");
+
+	elem = zbx_binary_heap_find_min(index);
+	key = elem->key;
+	((mock_elem_t *)elem->data)->queued = 0;
+
+	zbx_mock_assert_uint64_eq("popped element", zbx_binary_heap_find_min(direct)->key, key);
+
+	zbx_binary_heap_remove_min(direct);
+	zbx_binary_heap_remove_min(index);
+
+	return key;
+}
+
+static void	mock_run_steps(zbx_binary_heap_t *direct, zbx_binary_heap_t *index, zbx_vector_ptr_t *elems)
+{
+	zbx_mock_handle_t	hsteps, hstep;
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hsteps, &hstep))
+	{
+		const char	*op = zbx_mock_get_object_member_string(hstep, "op");
+		mock_elem_t	*elem = mock_elem_get(elems, zbx_mock_get_object_member_uint64(hstep, "key"));
+
+		if (0 == strcmp(op, "insert"))
+		{
+			mock_heaps_insert(direct, index, elem, zbx_mock_get_object_member_int(hstep, "value"));
+		}
+		else if (0 == strcmp(op, "update"))
+		{
+			mock_heaps_update(direct, index, elem, zbx_mock_get_object_member_int(hstep, "value"));
+		}
+		else if (0 == strcmp(op, "remove"))
+		{
+			mock_heaps_remove(direct, index, elem);
+		}
+		else if (0 == strcmp(op, "pop"))
+		{
+			zbx_mock_assert_uint64_eq("popped element", elem->key, mock_heaps_pop(direct, index));
+		}
+		else
+			fail_msg("unknown operation \"%s\"", op);
+
+		mock_heaps_check(direct, index);
+	}
+}
+
+static int	mock_random(zbx_uint64_t *seed, int range)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 7;
+	*seed ^= *seed << 17;
+
+	return (int)(*seed % (zbx_uint64_t)range);
+}
+
+static void	mock_run_random(zbx_binary_heap_t *direct, zbx_binary_heap_t *index, zbx_vector_ptr_t *elems)
+{
+	zbx_uint64_t	seed = 88172645463325252, key;
+	int		i, elems_num, ops_num, values_num;
+
+	elems_num = (int)zbx_mock_get_parameter_uint64("in.random.elements");
+	ops_num = (int)zbx_mock_get_parameter_uint64("in.random.operations");
+	values_num = (int)zbx_mock_get_parameter_uint64("in.random.values");
+
+	for (key = 1; key <= (zbx_uint64_t)elems_num; key++)
+		(void)mock_elem_get(elems, key);
+
+	for (i = 0; i < ops_num; i++)
+	{
+		mock_elem_t	*elem = (mock_elem_t *)elems->values[mock_random(&seed, elems_num)];
+
+		if (0 == elem->queued)
+		{
+			mock_heaps_insert(direct, index, elem, mock_random(&seed, values_num));
+			continue;
+		}
+
+		switch (mock_random(&seed, 4))
+		{
+			case 0:
+			case 1:
+				mock_heaps_update(direct, index, elem, mock_random(&seed, values_num));
+				break;
+			case 2:
+				mock_heaps_remove(direct, index, elem);
+				break;
+			default:
+				(void)mock_heaps_pop(direct, index);
+		}
+
+		/* checking after every operation would make the test quadratic */
+		if (0 == i % 97)
+			mock_heaps_check(direct, index);
+	}
+
+	while (SUCCEED != zbx_binary_heap_empty(index))
+		(void)mock_heaps_pop(direct, index);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_binary_heap_t	direct, index;
+	zbx_vector_ptr_t	elems;
+	zbx_mock_handle_t	handle;
+
+	ZBX_UNUSED(state);
+
+	zbx_vector_ptr_create(&elems);
+
+	zbx_binary_heap_create(&direct, mock_elem_compare, ZBX_BINARY_HEAP_OPTION_DIRECT);
+	zbx_binary_heap_create_index_ext(&index, mock_elem_compare, offsetof(mock_elem_t, queue_index),
+			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter("in.steps", &handle))
+		mock_run_steps(&direct, &index, &elems);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter("in.random", &handle))
+		mock_run_random(&direct, &index, &elems);
+
+	mock_heaps_check(&direct, &index);
+	zbx_mock_assert_int_eq("remaining elements", (int)zbx_mock_get_parameter_uint64("out.remaining"),
+			index.elems_num);
+
+	zbx_binary_heap_destroy(&index);
+	zbx_binary_heap_destroy(&direct);
+
+	zbx_vector_ptr_clear_ext(&elems, zbx_ptr_free);
+	zbx_vector_ptr_destroy(&elems);
+}
@@ -0,0 +1,427 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+#include "zbxmockdb.h"
+
+#include "../../../src/libs/zbxcacheconfig/dbsync.c"
+
+/* Steps read changelog records from mocked database and check the changesets of the objects synced with */
+/* changelog. The configuration cache is not updated by the changesets, it holds the test case objects.   */
+
+#define MOCK_ROWS_MAX	64
+
+typedef struct
+{
+	const char	*name;
+	int		(*compare_func)(zbx_dbsync_t *sync);
+}
+mock_sync_object_t;
+
+static const mock_sync_object_t	mock_objects[] = {
+	{"host_macros", zbx_dbsync_compare_host_macros},
+	{"host_templates", zbx_dbsync_compare_host_templates},
+	{"host_inventory", zbx_dbsync_compare_host_inventory},
+	{"interfaces", zbx_dbsync_compare_interfaces},
+	{"item_discovery", zbx_dbsync_compare_item_discovery},
+	{"trigger_dependency", zbx_dbsync_compare_trigger_dependency}
+};
+
+/* the current step, its user macros are used to expand interface addresses */
+static zbx_mock_handle_t	mock_hstep;
+
+char	*__wrap_dc_expand_user_and_func_macros_dyn(const char *text, const zbx_uint64_t *hostids, int hostids_num,
+		int env);
+
+/* replaces user macros with values from test case step */
+char	*__wrap_dc_expand_user_and_func_macros_dyn(const char *text, const zbx_uint64_t *hostids, int hostids_num,
+		int env)
+{
+	zbx_mock_handle_t	hmacros, hmacro;
+	char			*out;
+
+	ZBX_UNUSED(hostids);
+	ZBX_UNUSED(hostids_num);
+	ZBX_UNUSED(env);
+
+	out = zbx_strdup(NULL, text);
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(mock_hstep, "macros", &hmacros))
+		return out;
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hmacros, &hmacro))
+	{
+		const char	*macro, *value;
+		char		*ptr;
+
+		macro = zbx_mock_get_object_member_string(hmacro, "macro");
+		value = zbx_mock_get_object_member_string(hmacro, "value");
+
+		while (NULL != (ptr = strstr(out, macro)))
+		{
+			size_t	l = (size_t)(ptr - out), r = l + strlen(macro) - 1;
+
+			zbx_replace_string(&out, l, &r, value);
+		}
+	}
+
+	return out;
+}
+
+static zbx_hash_t	mock_um_host_hash(const void *d)
+{
+	const zbx_um_host_t	*host = *(const zbx_um_host_t * const *)d;
+
+	return ZBX_DEFAULT_UINT64_HASH_FUNC(&host->hostid);
+}
+
+static int	mock_um_host_compare(const void *d1, const void *d2)
+{
+	const zbx_um_host_t	*h1 = *(const zbx_um_host_t * const *)d1;
+	const zbx_um_host_t	*h2 = *(const zbx_um_host_t * const *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(h1->hostid, h2->hostid);
+
+	return 0;
+}
+
+static unsigned char	mock_get_uchar(zbx_mock_handle_t hobject, const char *name)
+{
+	return (unsigned char)zbx_mock_get_object_member_uint64(hobject, name);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: fills configuration cache with host macros, inventories and       *
+ *          interfaces used to resolve deletes cascaded from hosts            *
+ *                                                                            *
+ ******************************************************************************/
+static void	mock_cache_init(zbx_dc_config_t *cache, zbx_um_cache_t *um_cache)
+{
+	zbx_mock_handle_t	hcache, hobjects, hobject, hids, hid;
+
+	zbx_hashset_create(&um_cache->hosts, 10, mock_um_host_hash, mock_um_host_compare);
+	zbx_hashset_create(&cache->host_inventories, 10, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_hashset_create(&cache->interfaces, 10, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_hashset_create(&cache->interfaces_snmp, 10, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	cache->um_cache = um_cache;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_parameter("in.cache", &hcache))
+		return;
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hcache, "hosts", &hobjects))
+	{
+		while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hobjects, &hobject))
+		{
+			zbx_um_host_t	*host;
+
+			host = (zbx_um_host_t *)zbx_calloc(NULL, 1, sizeof(zbx_um_host_t));
+			host->hostid = zbx_mock_get_object_member_uint64(hobject, "hostid");
+			zbx_vector_um_macro_create(&host->macros);
+
+			hids = zbx_mock_get_object_member_handle(hobject, "macroids");
+
+			while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hids, &hid))
+			{
+				zbx_um_macro_t	*macro;
+
+				macro = (zbx_um_macro_t *)zbx_calloc(NULL, 1, sizeof(zbx_um_macro_t));
+				macro->hostid = host->hostid;
+
+				if (ZBX_MOCK_SUCCESS != zbx_mock_uint64(hid, &macro->macroid))
+					fail_msg("invalid host macro identifier");
+
+				zbx_vector_um_macro_append(&host->macros, macro);
+			}
+
+			zbx_hashset_insert(&um_cache->hosts, &host, sizeof(host));
+		}
+	}
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hcache, "inventories", &hids))
+	{
+		while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hids, &hid))
+		{
+			ZBX_DC_HOST_INVENTORY	inventory = {0};
+
+			if (ZBX_MOCK_SUCCESS != zbx_mock_uint64(hid, &inventory.hostid))
+				fail_msg("invalid host inventory identifier");
+
+			zbx_hashset_insert(&cache->host_inventories, &inventory, sizeof(inventory));
+		}
+	}
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hcache, "interfaces", &hobjects))
+	{
+		while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hobjects, &hobject))
+		{
+			ZBX_DC_INTERFACE	interface = {0};
+
+			interface.interfaceid = zbx_mock_get_object_member_uint64(hobject, "interfaceid");
+			interface.hostid = zbx_mock_get_object_member_uint64(hobject, "hostid");
+			interface.type = mock_get_uchar(hobject, "type");
+			interface.main = mock_get_uchar(hobject, "main");
+			interface.useip = mock_get_uchar(hobject, "useip");
+			interface.ip = zbx_mock_get_object_member_string(hobject, "ip");
+			interface.dns = zbx_mock_get_object_member_string(hobject, "dns");
+			interface.port = zbx_mock_get_object_member_string(hobject, "port");
+
+			zbx_hashset_insert(&cache->interfaces, &interface, sizeof(interface));
+		}
+	}
+}
+
+static void	mock_cache_destroy(zbx_dc_config_t *cache, zbx_um_cache_t *um_cache)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_um_host_t		**phost;
+
+	zbx_hashset_iter_reset(&um_cache->hosts, &iter);
+	while (NULL != (phost = (zbx_um_host_t **)zbx_hashset_iter_next(&iter)))
+	{
+		zbx_vector_um_macro_clear_ext(&(*phost)->macros, (zbx_um_macro_free_func_t)zbx_ptr_free);
+		zbx_vector_um_macro_destroy(&(*phost)->macros);
+		zbx_free(*phost);
+	}
+
+	zbx_hashset_destroy(&um_cache->hosts);
+	zbx_hashset_destroy(&cache->host_inventories);
+	zbx_hashset_destroy(&cache->interfaces);
+	zbx_hashset_destroy(&cache->interfaces_snmp);
+}
+
+static unsigned char	mock_str_to_tag(const char *str)
+{
+	if (0 == strcmp(str, "add"))
+		return ZBX_DBSYNC_ROW_ADD;
+
+	if (0 == strcmp(str, "update"))
+		return ZBX_DBSYNC_ROW_UPDATE;
+
+	if (0 == strcmp(str, "remove"))
+		return ZBX_DBSYNC_ROW_REMOVE;
+
+	fail_msg("unknown row tag \"%s\"", str);
+
+	return ZBX_DBSYNC_ROW_NONE;
+}
+
+static char	*mock_row_str(zbx_uint64_t rowid, char **row, unsigned char tag, int columns_num)
+{
+	char	*str = NULL;
+	size_t	str_alloc = 0, str_offset = 0;
+
+	zbx_snprintf_alloc(&str, &str_alloc, &str_offset, "tag:%d rowid:" ZBX_FS_UI64 " values:[", (int)tag, rowid);
+
+	for (int i = 0; NULL != row && i < columns_num; i++)
+	{
+		if (0 != i)
+			zbx_chrcpy_alloc(&str, &str_alloc, &str_offset, ',');
+
+		zbx_strcpy_alloc(&str, &str_alloc, &str_offset, ZBX_NULL2STR(row[i]));
+	}
+
+	zbx_chrcpy_alloc(&str, &str_alloc, &str_offset, ']');
+
+	return str;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if changeset row matches expected row                      *
+ *                                                                            *
+ * Comments: The columns not listed in expected row values must be NULL,      *
+ *           expected row without values matches only row without data.       *
+ *                                                                            *
+ ******************************************************************************/
+static int	mock_row_match(zbx_mock_handle_t hrow, zbx_uint64_t rowid, char **row, unsigned char tag,
+		int columns_num)
+{
+	zbx_mock_handle_t	hrowid, hvalues, hvalue;
+	zbx_uint64_t		expected_rowid = 0;
+	int			i = 0;
+
+	if (tag != mock_str_to_tag(zbx_mock_get_object_member_string(hrow, "tag")))
+		return FAIL;
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hrow, "rowid", &hrowid) &&
+			ZBX_MOCK_SUCCESS != zbx_mock_uint64(hrowid, &expected_rowid))
+	{
+		fail_msg("invalid expected row identifier");
+	}
+
+	if (rowid != expected_rowid)
+		return FAIL;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(hrow, "values", &hvalues))
+		return NULL == row ? SUCCEED : FAIL;
+
+	if (NULL == row)
+		return FAIL;
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hvalues, &hvalue))
+	{
+		const char	*value;
+
+		if (ZBX_MOCK_SUCCESS != zbx_mock_string(hvalue, &value))
+			fail_msg("invalid expected row value");
+
+		if (i == columns_num || NULL == row[i] || 0 != strcmp(value, row[i]))
+			return FAIL;
+
+		i++;
+	}
+
+	for (; i < columns_num; i++)
+	{
+		if (NULL != row[i])
+			return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks that changeset contains the expected rows in any order     *
+ *                                                                            *
+ ******************************************************************************/
+static void	mock_check_changes(zbx_dbsync_t *sync, zbx_mock_handle_t hstep, const char *name)
+{
+	zbx_mock_handle_t	hchanges, hrows, hrow, hexpected[MOCK_ROWS_MAX];
+	int			expected_num = 0, matched[MOCK_ROWS_MAX] = {0}, rows_num = 0;
+	zbx_uint64_t		rowid;
+	char			**row;
+	unsigned char		tag;
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "changes", &hchanges) &&
+			ZBX_MOCK_SUCCESS == zbx_mock_object_member(hchanges, name, &hrows))
+	{
+		while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hrows, &hrow))
+		{
+			if (MOCK_ROWS_MAX == expected_num)
+				fail_msg("too many expected %s rows", name);
+
+			hexpected[expected_num++] = hrow;
+		}
+	}
+
+	while (SUCCEED == zbx_dbsync_next(sync, &rowid, &row, &tag))
+	{
+		int	i;
+
+		for (i = 0; i < expected_num; i++)
+		{
+			if (0 == matched[i] && SUCCEED == mock_row_match(hexpected[i], rowid, row, tag,
+					sync->columns_num))
+			{
+				matched[i] = 1;
+				break;
+			}
+		}
+
+		if (i == expected_num)
+		{
+			char	*str = mock_row_str(rowid, row, tag, sync->columns_num);
+
+			fail_msg("unexpected %s row %s", name, str);
+			zbx_free(str);
+		}
+
+		rows_num++;
+	}
+
+	zbx_mock_assert_int_eq(name, expected_num, rows_num);
+}
+
+static void	mock_step(zbx_dc_config_t *cache, zbx_mock_handle_t hstep)
+{
+	zbx_mock_handle_t	hmember;
+	zbx_dbsync_t		syncs[ARRSIZE(mock_objects)];
+	unsigned char		mode = ZBX_DBSYNC_UPDATE;
+	size_t			i;
+	const char		*str;
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "mode", &hmember))
+	{
+		if (ZBX_MOCK_SUCCESS != zbx_mock_string(hmember, &str))
+			fail_msg("invalid sync mode");
+
+		if (0 == strcmp(str, "init"))
+			mode = ZBX_DBSYNC_INIT;
+		else if (0 != strcmp(str, "update"))
+			fail_msg("unknown sync mode \"%s\"", str);
+	}
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "um_revision", &hmember) &&
+			ZBX_MOCK_SUCCESS != zbx_mock_uint64(hmember, &cache->um_cache->revision))
+	{
+		fail_msg("invalid user macro cache revision");
+	}
+
+	mock_hstep = hstep;
+
+	zbx_dbsync_env_prepare(mode);
+
+	for (i = 0; i < ARRSIZE(mock_objects); i++)
+	{
+		zbx_dbsync_init_changelog(&syncs[i], mode);
+		zbx_mock_assert_result_eq(mock_objects[i].name, SUCCEED, mock_objects[i].compare_func(&syncs[i]));
+		mock_check_changes(&syncs[i], hstep, mock_objects[i].name);
+	}
+
+	if (ZBX_DBSYNC_UPDATE == mode)
+		zbx_dbsync_env_flush_changelog();
+
+	for (i = 0; i < ARRSIZE(mock_objects); i++)
+		zbx_dbsync_clear(&syncs[i]);
+
+	zbx_dbsync_env_clear();
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t	hsteps, hstep;
+	zbx_dc_config_t		*cache;
+	zbx_um_cache_t		um_cache = {0};
+
+	ZBX_UNUSED(state);
+
+	zbx_mockdb_init();
+
+	cache = (zbx_dc_config_t *)zbx_calloc(NULL, 1, sizeof(zbx_dc_config_t));
+	mock_cache_init(cache, &um_cache);
+
+	zbx_dbsync_env_init(cache, NULL, ZBX_PROGRAM_TYPE_SERVER);
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hsteps, &hstep))
+		mock_step(cache, hstep);
+
+	zbx_hashset_destroy(&dbsync_env.changelog);
+	zbx_hashset_destroy(&dbsync_env.host_templates.links);
+	zbx_hashset_destroy(&dbsync_env.item_discovery.links);
+	zbx_hashset_destroy(&dbsync_env.trigger_deps.links);
+
+	mock_cache_destroy(cache, &um_cache);
+	zbx_free(cache);
+
+	zbx_mockdb_destroy();
+}
@@ -0,0 +1,345 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "../../../src/libs/zbxcacheconfig/dbsync_snapshot.c"
+
+/* Steps write snapshot file in temporary directory created on real file system, damage it and check */
+/* the rows and changelog records loaded from it.                                                     */
+
+#define MOCK_OBJECTS_NUM	3
+#define MOCK_CHANGELOG_MAX_AGE	SEC_PER_HOUR
+
+/* the snapshot size after full sync or compaction when compaction was started */
+static zbx_uint64_t	mock_base_size;
+
+/* the file is damaged at position from its start or at offset from its end */
+static void	mock_file_damage(zbx_mock_handle_t hstep, const char *op)
+{
+	zbx_mock_handle_t	hposition;
+	zbx_stat_t		st;
+	int			fd;
+	zbx_uint64_t		position;
+
+	if (-1 == (fd = open(writer.path, O_RDWR)) || 0 != zbx_fstat(fd, &st))
+		fail_msg("cannot open snapshot file: %s", zbx_strerror(errno));
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "position", &hposition))
+		position = zbx_mock_get_object_member_uint64(hstep, "position");
+	else
+		position = (zbx_uint64_t)st.st_size - zbx_mock_get_object_member_uint64(hstep, "offset");
+
+	if ((zbx_uint64_t)st.st_size <= position)
+		fail_msg("position " ZBX_FS_UI64 " is outside of snapshot file", position);
+
+	if (0 == strcmp(op, "truncate"))
+	{
+		if (0 != ftruncate(fd, (off_t)position))
+			fail_msg("cannot truncate snapshot file: %s", zbx_strerror(errno));
+	}
+	else
+	{
+		unsigned char	byte;
+
+		if (1 != pread(fd, &byte, 1, (off_t)position))
+			fail_msg("cannot read snapshot file: %s", zbx_strerror(errno));
+
+		byte ^= 0xff;
+
+		if (1 != pwrite(fd, &byte, 1, (off_t)position))
+			fail_msg("cannot write snapshot file: %s", zbx_strerror(errno));
+	}
+
+	close(fd);
+}
+
+static void	mock_step_row(zbx_mock_handle_t hstep)
+{
+	zbx_mock_handle_t	hvalues, hvalue;
+	zbx_vector_str_t	values;
+	const char		*value;
+
+	zbx_vector_str_create(&values);
+
+	hvalues = zbx_mock_get_object_member_handle(hstep, "values");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hvalues, &hvalue))
+	{
+		if (ZBX_MOCK_SUCCESS != zbx_mock_string(hvalue, &value))
+			fail_msg("invalid row value");
+
+		zbx_vector_str_append(&values, (char *)value);
+	}
+
+	dbsync_snapshot_write_row((unsigned char)zbx_mock_get_object_member_int(hstep, "object"),
+			zbx_mock_get_object_member_uint64(hstep, "rowid"), values.values, values.values_num);
+
+	zbx_vector_str_destroy(&values);
+}
+
+static void	mock_check_rows(zbx_mock_handle_t hstep, const zbx_dbsync_snapshot_t *snapshot)
+{
+	zbx_mock_handle_t	hrows, hrow;
+	int			index[MOCK_OBJECTS_NUM] = {0};
+
+	hrows = zbx_mock_get_object_member_handle(hstep, "rows");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hrows, &hrow))
+	{
+		zbx_mock_handle_t	hvalues, hvalue;
+		unsigned char		object;
+		zbx_uint64_t		rowid;
+		char			*row[16];
+		int			columns_num = 0, i;
+		const char		*value;
+
+		object = (unsigned char)zbx_mock_get_object_member_int(hrow, "object");
+		i = index[object - 1]++;
+
+		if (dbsync_snapshot_get_rows_num(snapshot, object) <= i)
+		{
+			fail_msg("missing row " ZBX_FS_UI64 " of object %d",
+					zbx_mock_get_object_member_uint64(hrow, "rowid"), object);
+		}
+
+		hvalues = zbx_mock_get_object_member_handle(hrow, "values");
+
+		while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hvalues, &hvalue))
+			columns_num++;
+
+		zbx_mock_assert_result_eq("row decoding", SUCCEED,
+				dbsync_snapshot_get_row(snapshot, object, i, &rowid, row, columns_num));
+		zbx_mock_assert_uint64_eq("rowid", zbx_mock_get_object_member_uint64(hrow, "rowid"), rowid);
+
+		hvalues = zbx_mock_get_object_member_handle(hrow, "values");
+
+		for (i = 0; ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hvalues, &hvalue); i++)
+		{
+			if (ZBX_MOCK_SUCCESS != zbx_mock_string(hvalue, &value))
+				fail_msg("invalid row value");
+
+			zbx_mock_assert_str_eq("row value", value, row[i]);
+		}
+	}
+
+	for (unsigned char object = 1; object <= MOCK_OBJECTS_NUM; object++)
+		zbx_mock_assert_int_eq("rows", index[object - 1], dbsync_snapshot_get_rows_num(snapshot, object));
+}
+
+static void	mock_check_changelog(zbx_mock_handle_t hstep, const zbx_dbsync_snapshot_t *snapshot)
+{
+	zbx_mock_handle_t		hchangelog, hrecord;
+	const zbx_vector_uint64_pair_t	*changelog;
+	int				i;
+
+	changelog = dbsync_snapshot_get_changelog(snapshot);
+	hchangelog = zbx_mock_get_object_member_handle(hstep, "changelog");
+
+	for (i = 0; ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hchangelog, &hrecord); i++)
+	{
+		if (changelog->values_num <= i)
+		{
+			fail_msg("missing changelog record " ZBX_FS_UI64,
+					zbx_mock_get_object_member_uint64(hrecord, "id"));
+		}
+
+		zbx_mock_assert_uint64_eq("changelogid", zbx_mock_get_object_member_uint64(hrecord, "id"),
+				changelog->values[i].first);
+		zbx_mock_assert_uint64_eq("changelog clock", zbx_mock_get_object_member_uint64(hrecord, "clock"),
+				changelog->values[i].second);
+	}
+
+	zbx_mock_assert_int_eq("changelog records", i, changelog->values_num);
+}
+
+static void	mock_step_load(zbx_mock_handle_t hstep)
+{
+	zbx_dbsync_snapshot_t	*snapshot;
+	int			ret;
+
+	ret = dbsync_snapshot_load(zbx_mock_get_object_member_int(hstep, "now"),
+			zbx_mock_get_object_member_int(hstep, "max_age"), &snapshot);
+
+	zbx_mock_assert_result_eq("load result",
+			zbx_mock_str_to_return_code(zbx_mock_get_object_member_string(hstep, "result")), ret);
+
+	if (SUCCEED != ret)
+		return;
+
+	mock_check_rows(hstep, snapshot);
+	mock_check_changelog(hstep, snapshot);
+
+	dbsync_snapshot_free(snapshot);
+}
+
+/* compaction process is left unreaped, so the next commit finishes compaction */
+static void	mock_step_compact(zbx_mock_handle_t hstep)
+{
+	siginfo_t	info;
+
+	mock_base_size = writer.base_size;
+	dbsync_snapshot_compact_start(zbx_mock_get_object_member_int(hstep, "clock"));
+
+	if (0 == writer.compact_pid)
+		fail_msg("compaction process was not started");
+
+	if (0 != waitid(P_PID, (id_t)writer.compact_pid, &info, WEXITED | WNOWAIT))
+		fail_msg("cannot wait for compaction process: %s", zbx_strerror(errno));
+}
+
+static void	mock_step_compacted(zbx_mock_handle_t hstep)
+{
+	const char	*expected;
+
+	dbsync_snapshot_compact_finish(0);
+
+	expected = zbx_mock_get_object_member_string(hstep, "expect");
+
+	if (0 == strcmp(expected, "yes"))
+	{
+		if (writer.base_size == mock_base_size)
+			fail_msg("snapshot was not compacted");
+	}
+	else if (0 == strcmp(expected, "no"))
+		zbx_mock_assert_uint64_eq("snapshot base size", mock_base_size, writer.base_size);
+	else
+		fail_msg("unknown expectation \"%s\"", expected);
+}
+
+static void	mock_run_steps(const char *path)
+{
+	zbx_mock_handle_t	hsteps, hstep;
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hsteps, &hstep))
+	{
+		const char	*op = zbx_mock_get_object_member_string(hstep, "op");
+
+		if (0 == strcmp(op, "init"))
+		{
+			dbsync_snapshot_init(path, ZBX_PROGRAM_TYPE_SERVER, MOCK_OBJECTS_NUM, MOCK_CHANGELOG_MAX_AGE);
+		}
+		else if (0 == strcmp(op, "begin"))
+		{
+			const char	*mode = zbx_mock_get_object_member_string(hstep, "mode");
+
+			zbx_mock_assert_result_eq("begin result", SUCCEED,
+					dbsync_snapshot_begin(0 == strcmp(mode, "init") ? ZBX_DBSYNC_INIT :
+					ZBX_DBSYNC_UPDATE));
+		}
+		else if (0 == strcmp(op, "row"))
+		{
+			mock_step_row(hstep);
+		}
+		else if (0 == strcmp(op, "delete"))
+		{
+			dbsync_snapshot_write_delete((unsigned char)zbx_mock_get_object_member_int(hstep, "object"),
+					zbx_mock_get_object_member_uint64(hstep, "rowid"));
+		}
+		else if (0 == strcmp(op, "changelog"))
+		{
+			dbsync_snapshot_write_changelog(zbx_mock_get_object_member_uint64(hstep, "id"),
+					zbx_mock_get_object_member_int(hstep, "clock"));
+		}
+		else if (0 == strcmp(op, "flush"))
+		{
+			zbx_mock_assert_result_eq("flush result", SUCCEED, dbsync_snapshot_flush());
+		}
+		else if (0 == strcmp(op, "commit"))
+		{
+			dbsync_snapshot_commit(zbx_mock_get_object_member_int(hstep, "clock"));
+		}
+		else if (0 == strcmp(op, "rollback"))
+		{
+			dbsync_snapshot_rollback();
+		}
+		else if (0 == strcmp(op, "truncate") || 0 == strcmp(op, "corrupt"))
+		{
+			mock_file_damage(hstep, op);
+		}
+		else if (0 == strcmp(op, "compact"))
+		{
+			mock_step_compact(hstep);
+		}
+		else if (0 == strcmp(op, "compacted"))
+		{
+			mock_step_compacted(hstep);
+		}
+		else if (0 == strcmp(op, "block compaction"))
+		{
+			char	*path_compact = dbsync_snapshot_compact_path();
+
+			if (0 != mkdir(path_compact, 0700))
+				fail_msg("cannot create directory \"%s\": %s", path_compact, zbx_strerror(errno));
+
+			zbx_free(path_compact);
+		}
+		else if (0 == strcmp(op, "load"))
+		{
+			mock_step_load(hstep);
+		}
+		else
+			fail_msg("unknown operation \"%s\"", op);
+	}
+}
+
+static void	mock_remove(const char *path, const char *suffix)
+{
+	char	*filename;
+
+	filename = zbx_dsprintf(NULL, "%s%s", path, suffix);
+
+	if (0 != unlink(filename) && EISDIR == errno)
+		(void)rmdir(filename);
+
+	zbx_free(filename);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	char	directory[] = "/tmp/zbx_dbsync_snapshot_XXXXXX", *path;
+
+	ZBX_UNUSED(state);
+
+	if (NULL == mkdtemp(directory))
+		fail_msg("cannot create temporary directory: %s", zbx_strerror(errno));
+
+	/* files in the temporary directory are accessed with the real system calls */
+	zbx_set_mock_real_path(directory);
+
+	path = zbx_dsprintf(NULL, "%s/snapshot", directory);
+
+	mock_run_steps(path);
+
+	dbsync_snapshot_compact_abort();
+	dbsync_snapshot_close();
+	zbx_free(writer.path);
+	zbx_free(writer.buf);
+	zbx_vector_uint64_pair_destroy(&writer.changelog);
+
+	mock_remove(path, "");
+	mock_remove(path, ".tmp");
+	mock_remove(path, ".compact");
+	zbx_free(path);
+
+	if (0 != rmdir(directory))
+		fail_msg("cannot remove temporary directory: %s", zbx_strerror(errno));
+
+	zbx_set_mock_real_path(NULL);
+}
@@ -0,0 +1,394 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxcommon.h"
+#include "zbxcacheconfig.h"
+#include "zbxcacheconfig/dbconfig.h"
+
+/* Items and host groups are either listed in test case or generated as described by in.generate: */
+/* item N is named "item N", has tags "tag 0" .. "tag K" and belongs to host N % hosts, host N    */
+/* belongs to host group "group N % groups".                                                      */
+
+static char	*mock_str(zbx_vector_str_t *strings, const char *str)
+{
+	char	*copy;
+
+	copy = zbx_strdup(NULL, str);
+	zbx_vector_str_append(strings, copy);
+
+	return copy;
+}
+
+static ZBX_DC_ITEM	*mock_item_add(zbx_dc_config_t *config, zbx_uint64_t itemid, const char *name)
+{
+	ZBX_DC_ITEM	item_local, *item;
+
+	memset(&item_local, 0, sizeof(item_local));
+	item_local.itemid = itemid;
+
+	item = (ZBX_DC_ITEM *)zbx_hashset_insert(&config->items, &item_local, sizeof(item_local));
+	item->name = name;
+	zbx_vector_ptr_create(&item->tags);
+
+	return item;
+}
+
+static void	mock_item_add_tag(ZBX_DC_ITEM *item, const char *tag, const char *value)
+{
+	zbx_dc_item_tag_t	*item_tag;
+
+	item_tag = (zbx_dc_item_tag_t *)zbx_malloc(NULL, sizeof(zbx_dc_item_tag_t));
+	item_tag->itemtagid = 0;
+	item_tag->itemid = item->itemid;
+	item_tag->tag = tag;
+	item_tag->value = value;
+	zbx_vector_ptr_append(&item->tags, item_tag);
+}
+
+static zbx_dc_hostgroup_t	*mock_group_add(zbx_dc_config_t *config, zbx_uint64_t groupid, const char *name)
+{
+	zbx_dc_hostgroup_t	group_local, *group;
+
+	memset(&group_local, 0, sizeof(group_local));
+	group_local.groupid = groupid;
+
+	group = (zbx_dc_hostgroup_t *)zbx_hashset_insert(&config->hostgroups, &group_local, sizeof(group_local));
+	group->name = name;
+	zbx_hashset_create(&group->hostids, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	return group;
+}
+
+static void	mock_config_read(zbx_dc_config_t *config, zbx_vector_str_t *strings)
+{
+	zbx_mock_handle_t	hitems, hitem, htags, htag, hgroups, hgroup, hhostids, hhostid;
+
+	hitems = zbx_mock_get_parameter_handle("in.items");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hitems, &hitem))
+	{
+		ZBX_DC_ITEM	*item;
+
+		item = mock_item_add(config, zbx_mock_get_object_member_uint64(hitem, "itemid"),
+				mock_str(strings, zbx_mock_get_object_member_string(hitem, "name")));
+
+		if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(hitem, "tags", &htags))
+			continue;
+
+		while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(htags, &htag))
+		{
+			mock_item_add_tag(item, mock_str(strings, zbx_mock_get_object_member_string(htag, "tag")),
+					mock_str(strings, zbx_mock_get_object_member_string(htag, "value")));
+		}
+	}
+
+	hgroups = zbx_mock_get_parameter_handle("in.groups");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hgroups, &hgroup))
+	{
+		zbx_dc_hostgroup_t	*group;
+
+		group = mock_group_add(config, zbx_mock_get_object_member_uint64(hgroup, "groupid"),
+				mock_str(strings, zbx_mock_get_object_member_string(hgroup, "name")));
+
+		hhostids = zbx_mock_get_object_member_handle(hgroup, "hostids");
+
+		while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hhostids, &hhostid))
+		{
+			zbx_uint64_t	hostid;
+
+			if (ZBX_MOCK_SUCCESS != zbx_mock_uint64(hhostid, &hostid))
+				fail_msg("invalid hostid");
+
+			zbx_hashset_insert(&group->hostids, &hostid, sizeof(hostid));
+		}
+	}
+}
+
+static void	mock_config_generate(zbx_dc_config_t *config, zbx_vector_str_t *strings, int items_num,
+		int hosts_num, int groups_num, int tags_num)
+{
+	zbx_dc_hostgroup_t	**groups;
+	char			buf[64];
+	int			i, j;
+
+	groups = (zbx_dc_hostgroup_t **)zbx_malloc(NULL, sizeof(zbx_dc_hostgroup_t *) * (size_t)groups_num);
+
+	for (i = 0; i < groups_num; i++)
+	{
+		zbx_snprintf(buf, sizeof(buf), "group %d", i);
+		groups[i] = mock_group_add(config, (zbx_uint64_t)i + 1, mock_str(strings, buf));
+	}
+
+	for (i = 0; i < hosts_num; i++)
+	{
+		zbx_uint64_t	hostid = (zbx_uint64_t)i;
+
+		zbx_hashset_insert(&groups[i % groups_num]->hostids, &hostid, sizeof(hostid));
+	}
+
+	for (i = 0; i < items_num; i++)
+	{
+		ZBX_DC_ITEM	*item;
+		const char	*value;
+
+		zbx_snprintf(buf, sizeof(buf), "item %d", i);
+		item = mock_item_add(config, (zbx_uint64_t)i, mock_str(strings, buf));
+
+		zbx_snprintf(buf, sizeof(buf), "value %d", i);
+		value = mock_str(strings, buf);
+
+		/* add tags in reverse order to check sorting */
+		for (j = tags_num - 1; 0 <= j; j--)
+		{
+			zbx_snprintf(buf, sizeof(buf), "tag %d", j);
+			mock_item_add_tag(item, mock_str(strings, buf), value);
+		}
+	}
+
+	zbx_free(groups);
+}
+
+static void	mock_request_add(zbx_vector_history_export_item_ptr_t *items,
+		zbx_vector_history_export_host_ptr_t *hosts, zbx_uint64_t itemid, zbx_uint64_t hostid)
+{
+	zbx_history_export_item_t	*item;
+	zbx_history_export_host_t	*host;
+
+	item = (zbx_history_export_item_t *)zbx_malloc(NULL, sizeof(zbx_history_export_item_t));
+	item->itemid = itemid;
+	item->name = NULL;
+	zbx_vector_tags_ptr_create(&item->item_tags);
+	zbx_vector_history_export_item_ptr_append(items, item);
+
+	host = (zbx_history_export_host_t *)zbx_malloc(NULL, sizeof(zbx_history_export_host_t));
+	host->hostid = hostid;
+	zbx_vector_str_create(&host->groups);
+	zbx_vector_history_export_host_ptr_append(hosts, host);
+}
+
+static void	mock_request_read(zbx_vector_history_export_item_ptr_t *items,
+		zbx_vector_history_export_host_ptr_t *hosts)
+{
+	zbx_mock_handle_t	hrequests, hrequest;
+
+	hrequests = zbx_mock_get_parameter_handle("in.request");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hrequests, &hrequest))
+	{
+		mock_request_add(items, hosts, zbx_mock_get_object_member_uint64(hrequest, "itemid"),
+				zbx_mock_get_object_member_uint64(hrequest, "hostid"));
+	}
+}
+
+static void	mock_result_check(const zbx_vector_history_export_item_ptr_t *items,
+		const zbx_vector_history_export_host_ptr_t *hosts)
+{
+	zbx_mock_handle_t	hresults, hresult, hname, htags, htag, hgroups, hgroup;
+	int			i = 0, j;
+
+	hresults = zbx_mock_get_parameter_handle("out.result");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hresults, &hresult))
+	{
+		const zbx_history_export_item_t	*item;
+		const zbx_history_export_host_t	*host;
+		const char			*name, *group;
+
+		if (i >= items->values_num)
+			fail_msg("expected more than %d results", items->values_num);
+
+		item = items->values[i];
+		host = hosts->values[i++];
+
+		/* items missing from configuration cache get no name */
+		if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(hresult, "name", &hname))
+		{
+			if (NULL != item->name)
+				fail_msg("unexpected name \"%s\" of item " ZBX_FS_UI64, item->name, item->itemid);
+		}
+		else
+		{
+			if (NULL == item->name)
+				fail_msg("no name for item " ZBX_FS_UI64, item->itemid);
+
+			if (ZBX_MOCK_SUCCESS != zbx_mock_string(hname, &name))
+				fail_msg("invalid item name");
+
+			zbx_mock_assert_str_eq("item name", name, item->name);
+		}
+
+		htags = zbx_mock_get_object_member_handle(hresult, "tags");
+
+		for (j = 0; ZBX_MOCK_SUCCESS == zbx_mock_vector_element(htags, &htag); j++)
+		{
+			if (j >= item->item_tags.values_num)
+				fail_msg("expected more than %d tags", item->item_tags.values_num);
+
+			zbx_mock_assert_str_eq("tag name", zbx_mock_get_object_member_string(htag, "tag"),
+					item->item_tags.values[j]->tag);
+			zbx_mock_assert_str_eq("tag value", zbx_mock_get_object_member_string(htag, "value"),
+					item->item_tags.values[j]->value);
+		}
+
+		zbx_mock_assert_int_eq("number of tags", j, item->item_tags.values_num);
+
+		hgroups = zbx_mock_get_object_member_handle(hresult, "groups");
+
+		for (j = 0; ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hgroups, &hgroup); j++)
+		{
+			if (j >= host->groups.values_num)
+				fail_msg("expected more than %d host groups", host->groups.values_num);
+
+			if (ZBX_MOCK_SUCCESS != zbx_mock_string(hgroup, &group))
+				fail_msg("invalid host group name");
+
+			zbx_mock_assert_str_eq("host group", group, host->groups.values[j]);
+		}
+
+		zbx_mock_assert_int_eq("number of host groups", j, host->groups.values_num);
+	}
+
+	zbx_mock_assert_int_eq("number of results", i, items->values_num);
+}
+
+static void	mock_result_check_generated(const zbx_vector_history_export_item_ptr_t *items,
+		const zbx_vector_history_export_host_ptr_t *hosts, int groups_num, int tags_num)
+{
+	char	buf[64];
+	int	i, j;
+
+	for (i = 0; i < items->values_num; i++)
+	{
+		const zbx_history_export_item_t	*item = items->values[i];
+		const zbx_history_export_host_t	*host = hosts->values[i];
+
+		zbx_snprintf(buf, sizeof(buf), "item " ZBX_FS_UI64, item->itemid);
+		zbx_mock_assert_ptr_ne("item name", NULL, item->name);
+		zbx_mock_assert_str_eq("item name", buf, item->name);
+		zbx_mock_assert_int_eq("number of tags", tags_num, item->item_tags.values_num);
+
+		for (j = 0; j < tags_num; j++)
+		{
+			zbx_snprintf(buf, sizeof(buf), "tag %d", j);
+			zbx_mock_assert_str_eq("tag name", buf, item->item_tags.values[j]->tag);
+		}
+
+		zbx_mock_assert_int_eq("number of host groups", 1, host->groups.values_num);
+		zbx_snprintf(buf, sizeof(buf), "group %d", (int)(host->hostid % (zbx_uint64_t)groups_num));
+		zbx_mock_assert_str_eq("host group", buf, host->groups.values[0]);
+	}
+}
+
+static void	mock_config_free(zbx_dc_config_t *config)
+{
+	zbx_hashset_iter_t	iter;
+	ZBX_DC_ITEM		*item;
+	zbx_dc_hostgroup_t	*group;
+
+	zbx_hashset_iter_reset(&config->items, &iter);
+
+	while (NULL != (item = (ZBX_DC_ITEM *)zbx_hashset_iter_next(&iter)))
+	{
+		zbx_vector_ptr_clear_ext(&item->tags, zbx_ptr_free);
+		zbx_vector_ptr_destroy(&item->tags);
+	}
+
+	zbx_hashset_iter_reset(&config->hostgroups, &iter);
+
+	while (NULL != (group = (zbx_dc_hostgroup_t *)zbx_hashset_iter_next(&iter)))
+		zbx_hashset_destroy(&group->hostids);
+
+	zbx_hashset_destroy(&config->hostgroups);
+	zbx_hashset_destroy(&config->items);
+	zbx_free(config);
+}
+
+static void	mock_export_item_free(zbx_history_export_item_t *item)
+{
+	zbx_vector_tags_ptr_clear_ext(&item->item_tags, zbx_free_tag);
+	zbx_vector_tags_ptr_destroy(&item->item_tags);
+	zbx_free(item->name);
+	zbx_free(item);
+}
+
+static void	mock_export_host_free(zbx_history_export_host_t *host)
+{
+	zbx_vector_str_clear_ext(&host->groups, zbx_str_free);
+	zbx_vector_str_destroy(&host->groups);
+	zbx_free(host);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_dc_config_t				*config;
+	zbx_vector_str_t			strings;
+	zbx_vector_history_export_item_ptr_t	items;
+	zbx_vector_history_export_host_ptr_t	hosts;
+	zbx_mock_handle_t			handle;
+	int					items_num, hosts_num, groups_num, tags_num, i;
+
+	ZBX_UNUSED(state);
+
+	zbx_vector_str_create(&strings);
+	zbx_vector_history_export_item_ptr_create(&items);
+	zbx_vector_history_export_host_ptr_create(&hosts);
+
+	config = (zbx_dc_config_t *)zbx_malloc(NULL, sizeof(zbx_dc_config_t));
+	memset(config, 0, sizeof(zbx_dc_config_t));
+	zbx_hashset_create(&config->items, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_hashset_create(&config->hostgroups, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	set_dc_config(config);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter("in.generate", &handle))
+	{
+		items_num = zbx_mock_get_object_member_int(handle, "items");
+		hosts_num = zbx_mock_get_object_member_int(handle, "hosts");
+		groups_num = zbx_mock_get_object_member_int(handle, "groups");
+		tags_num = zbx_mock_get_object_member_int(handle, "tags");
+
+		mock_config_generate(config, &strings, items_num, hosts_num, groups_num, tags_num);
+
+		for (i = 0; i < items_num; i++)
+			mock_request_add(&items, &hosts, (zbx_uint64_t)i, (zbx_uint64_t)(i % hosts_num));
+
+		zbx_dc_config_history_sync_get_export_data(&items, &hosts);
+
+		mock_result_check_generated(&items, &hosts, groups_num, tags_num);
+	}
+	else
+	{
+		mock_config_read(config, &strings);
+		mock_request_read(&items, &hosts);
+
+		zbx_dc_config_history_sync_get_export_data(&items, &hosts);
+
+		mock_result_check(&items, &hosts);
+	}
+
+	zbx_vector_history_export_item_ptr_clear_ext(&items, mock_export_item_free);
+	zbx_vector_history_export_item_ptr_destroy(&items);
+	zbx_vector_history_export_host_ptr_clear_ext(&hosts, mock_export_host_free);
+	zbx_vector_history_export_host_ptr_destroy(&hosts);
+
+	mock_config_free(config);
+
+	zbx_vector_str_clear_ext(&strings, zbx_str_free);
+	zbx_vector_str_destroy(&strings);
+}
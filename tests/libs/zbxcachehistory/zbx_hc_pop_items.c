@@ -0,0 +1,159 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "../../../src/libs/zbxcachehistory/cachehistory.c"
+
+void	__wrap_zbx_vps_monitor_add_collected(zbx_uint64_t values_num);
+
+void	__wrap_zbx_vps_monitor_add_collected(zbx_uint64_t values_num)
+{
+	ZBX_UNUSED(values_num);
+}
+
+static unsigned char	mock_get_program_type(void)
+{
+	return ZBX_PROGRAM_TYPE_PROXY;
+}
+
+static void	mock_sync_history(int *values_num, int *triggers_num, const zbx_events_funcs_t *events_cbs,
+		zbx_ipc_async_socket_t *rtc, int config_history_storage_pipelines, int *more)
+{
+	ZBX_UNUSED(values_num);
+	ZBX_UNUSED(triggers_num);
+	ZBX_UNUSED(events_cbs);
+	ZBX_UNUSED(rtc);
+	ZBX_UNUSED(config_history_storage_pipelines);
+
+	*more = ZBX_SYNC_DONE;
+}
+
+static void	mock_add_values(void)
+{
+	zbx_mock_handle_t	hvalues, hvalue;
+	zbx_pp_value_opt_t	value_opt = {.flags = ZBX_PP_VALUE_OPT_NONE};
+
+	hvalues = zbx_mock_get_parameter_handle("in.values");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hvalues, &hvalue))
+	{
+		zbx_variant_t	value;
+		zbx_timespec_t	ts;
+
+		ts.sec = (int)zbx_mock_get_object_member_uint64(hvalue, "clock");
+		ts.ns = 0;
+
+		zbx_variant_set_ui64(&value, (zbx_uint64_t)ts.sec);
+		zbx_dc_add_history_variant(zbx_mock_get_object_member_uint64(hvalue, "itemid"),
+				ITEM_VALUE_TYPE_UINT64, 0, &value, ts, &value_opt);
+		zbx_variant_clear(&value);
+	}
+
+	zbx_dc_flush_history();
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check that every cached item is stored in the shard selected by   *
+ *          its identifier                                                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	mock_check_routing(void)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_hc_item_t		*item;
+	int			items_num = 0;
+
+	for (int i = 0; i < hc_shards_num; i++)
+	{
+		zbx_hashset_iter_reset(&cache->shards[i].history_items, &iter);
+
+		while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
+		{
+			zbx_mock_assert_int_eq("item shard", hc_shard_index(item->itemid), i);
+			items_num++;
+		}
+
+		zbx_mock_assert_int_eq("queued shard items", cache->shards[i].history_items.num_data,
+				cache->shards[i].history_queue.elems_num);
+	}
+
+	zbx_mock_assert_int_eq("cached items", (int)zbx_mock_get_parameter_uint64("out.items"), items_num);
+}
+
+static void	mock_check_popped(const zbx_vector_hc_item_ptr_t *history_items)
+{
+	zbx_mock_handle_t	hitemids, hitemid;
+	int			i = 0;
+
+	hitemids = zbx_mock_get_parameter_handle("out.popped");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hitemids, &hitemid))
+	{
+		zbx_uint64_t	itemid;
+
+		if (ZBX_MOCK_SUCCESS != zbx_mock_uint64(hitemid, &itemid))
+			fail_msg("invalid popped itemid");
+
+		if (i >= history_items->values_num)
+			fail_msg("popped fewer items than expected");
+
+		zbx_mock_assert_uint64_eq("popped item", itemid, history_items->values[i++]->itemid);
+	}
+
+	zbx_mock_assert_int_eq("popped items", i, history_items->values_num);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_vector_hc_item_ptr_t	history_items;
+	zbx_uint64_t			trends_cache_size = 0;
+	char				*error = NULL;
+
+	ZBX_UNUSED(state);
+
+	if (SUCCEED != zbx_locks_create(&error))
+		fail_msg("cannot create locks: %s", error);
+
+	if (SUCCEED != zbx_init_database_cache(mock_get_program_type, mock_sync_history,
+			zbx_mock_get_parameter_uint64("in.history_cache_size"),
+			zbx_mock_get_parameter_uint64("in.history_index_cache_size"), &trends_cache_size,
+			(int)zbx_mock_get_parameter_uint64("in.syncers"), 0, &error))
+	{
+		fail_msg("cannot initialize history cache: %s", error);
+	}
+
+	zbx_mock_assert_int_eq("history cache shards", (int)zbx_mock_get_parameter_uint64("out.shards"),
+			hc_shards_num);
+
+	mock_add_values();
+	mock_check_routing();
+
+	zbx_vector_hc_item_ptr_create(&history_items);
+
+	zbx_hc_set_sync_shard((int)zbx_mock_get_parameter_uint64("in.process_num"));
+	zbx_hc_pop_items(&history_items);
+
+	mock_check_popped(&history_items);
+
+	zbx_hc_push_items(&history_items);
+	zbx_vector_hc_item_ptr_destroy(&history_items);
+
+	zbx_free_database_cache(ZBX_SYNC_NONE, NULL, 0);
+	zbx_locks_destroy();
+}
@@ -37,8 +37,10 @@ int	zbx_vc_get_cached_values(zbx_uint64_t itemid, unsigned char value_type, zbx_
 
 	for (chunk = item->tail; NULL != chunk; chunk = chunk->next)
 	{
+		zbx_history_record_t	*slots = vch_chunk_slots(chunk);
+
 		for (i = chunk->first_value; i <= chunk->last_value; i++)
-			vc_history_record_vector_append(values, value_type, &chunk->slots[i]);
+			vc_history_record_vector_append(values, value_type, &slots[i]);
 	}
 
 	return SUCCEED;
@@ -60,7 +62,7 @@ int	zbx_vc_precache_values(zbx_uint64_t itemid, int value_type, int seconds, int
 	/* perform request to cache values */
 	zbx_history_record_vector_create(&values);
 	RDLOCK_CACHE;
-	ret = vch_item_get_values(item, &values, seconds, count, ts);
+	ret = vch_item_get_values(item, &values, NULL, seconds, count, ts);
 	UNLOCK_CACHE;
 	zbx_vc_flush_stats();
 	zbx_history_record_vector_destroy(&values, value_type);
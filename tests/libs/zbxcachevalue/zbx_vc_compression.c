@@ -0,0 +1,337 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "../../../src/libs/zbxcachevalue/valuecache.c"
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+/* deterministic pseudo random generator, so test data does not depend on platform */
+static zbx_uint64_t	vc_test_rand(zbx_uint64_t *seed)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 7;
+	*seed ^= *seed << 17;
+
+	return *seed;
+}
+
+static void	vc_test_parse_value(const char *str, unsigned char value_type, zbx_history_value_t *value)
+{
+	char	*end;
+
+	if (ITEM_VALUE_TYPE_FLOAT == value_type)
+		value->dbl = strtod(str, &end);
+	else
+		value->ui64 = strtoull(str, &end, 10);
+
+	if ('\0' != *end || end == str)
+		fail_msg("invalid value \"%s\"", str);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: generates history values described by the test case               *
+ *                                                                            *
+ * Comments: Values are generated with the specified count, start clock and   *
+ *           interval. Nanoseconds are either zero, a fixed number or random. *
+ *           Values are either a counter, random or taken in order from a     *
+ *           list.                                                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_test_generate_values(zbx_mock_handle_t hvalues, unsigned char value_type,
+		zbx_vector_history_record_t *values)
+{
+	zbx_mock_handle_t	hlist, hvalue;
+	zbx_uint64_t		seed = 88172645463325252ULL;
+	const char		*ns_mode, *value_mode;
+	int			count, clock, interval, list_num = 0;
+	zbx_vector_str_t	list;
+
+	count = zbx_mock_get_object_member_int(hvalues, "count");
+	clock = zbx_mock_get_object_member_int(hvalues, "clock");
+	interval = zbx_mock_get_object_member_int(hvalues, "interval");
+	ns_mode = zbx_mock_get_object_member_string(hvalues, "ns");
+	value_mode = zbx_mock_get_object_member_string(hvalues, "value");
+
+	zbx_vector_str_create(&list);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hvalues, "list", &hlist))
+	{
+		const char	*str;
+
+		while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hlist, &hvalue))
+		{
+			if (ZBX_MOCK_SUCCESS != zbx_mock_string(hvalue, &str))
+				fail_msg("invalid list value");
+
+			zbx_vector_str_append(&list, (char *)str);
+		}
+
+		list_num = list.values_num;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		zbx_history_record_t	record;
+
+		record.timestamp.sec = clock + i * interval;
+
+		if (0 == strcmp(ns_mode, "random"))
+			record.timestamp.ns = (int)(vc_test_rand(&seed) % 1000000000);
+		else
+			record.timestamp.ns = atoi(ns_mode);
+
+		if (0 == strcmp(value_mode, "counter"))
+		{
+			if (ITEM_VALUE_TYPE_FLOAT == value_type)
+				record.value.dbl = 1000.5 + i * 0.25;
+			else
+				record.value.ui64 = 1000000 + (zbx_uint64_t)i * 60;
+		}
+		else if (0 == strcmp(value_mode, "random"))
+		{
+			zbx_uint64_t	rnd = vc_test_rand(&seed);
+
+			if (ITEM_VALUE_TYPE_FLOAT == value_type)
+				record.value.dbl = (double)(rnd >> 11) / (double)(__UINT64_C(1) << 53) * 100;
+			else
+				record.value.ui64 = rnd;
+		}
+		else if (0 == strcmp(value_mode, "list"))
+		{
+			if (0 == list_num)
+				fail_msg("empty value list");
+
+			vc_test_parse_value(list.values[i % list_num], value_type, &record.value);
+		}
+		else
+			fail_msg("unknown value mode \"%s\"", value_mode);
+
+		zbx_vector_history_record_append_ptr(values, &record);
+	}
+
+	zbx_vector_str_destroy(&list);
+}
+
+static void	vc_test_read_inserts(zbx_mock_handle_t hinserts, unsigned char value_type,
+		zbx_vector_history_record_t *values)
+{
+	zbx_mock_handle_t	hinsert;
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hinserts, &hinsert))
+	{
+		zbx_history_record_t	record;
+
+		record.timestamp.sec = zbx_mock_get_object_member_int(hinsert, "clock");
+		record.timestamp.ns = zbx_mock_get_object_member_int(hinsert, "ns");
+		vc_test_parse_value(zbx_mock_get_object_member_string(hinsert, "value"), value_type, &record.value);
+
+		zbx_vector_history_record_append_ptr(values, &record);
+	}
+}
+
+/* values are compared bitwise, so NaN, infinity and negative zero are checked as well */
+static void	vc_test_compare_record(const char *prefix, int index, const zbx_history_record_t *expected,
+		const zbx_history_record_t *returned)
+{
+	char	msg[MAX_STRING_LEN];
+
+	zbx_snprintf(msg, sizeof(msg), "%s value #%d timestamp", prefix, index);
+	zbx_mock_assert_timespec_eq(msg, &expected->timestamp, &returned->timestamp);
+
+	zbx_snprintf(msg, sizeof(msg), "%s value #%d", prefix, index);
+	zbx_mock_assert_uint64_eq(msg, expected->value.ui64, returned->value.ui64);
+}
+
+static void	vc_test_codec(unsigned char value_type, const zbx_vector_history_record_t *values)
+{
+	zbx_vc_bitstream_t	bs = {0};
+	zbx_history_record_t	*decoded;
+	zbx_mock_handle_t	hsize;
+	zbx_uint64_t		size_max;
+
+	vc_chunk_encode(&bs, value_type, values->values, values->values_num);
+
+	decoded = (zbx_history_record_t *)zbx_malloc(NULL, sizeof(zbx_history_record_t) * (size_t)values->values_num);
+	vc_chunk_decode(bs.data, value_type, decoded, values->values_num);
+
+	for (int i = 0; i < values->values_num; i++)
+		vc_test_compare_record("decoded", i, &values->values[i], &decoded[i]);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter("out['max size']", &hsize))
+	{
+		if (ZBX_MOCK_SUCCESS != zbx_mock_uint64(hsize, &size_max))
+			fail_msg("invalid max size");
+
+		printf("encoded %d values into " ZBX_FS_SIZE_T " bytes\n", values->values_num,
+				(zbx_fs_size_t)((bs.bits_num + 7) / 8));
+
+		if (size_max < (bs.bits_num + 7) / 8)
+		{
+			fail_msg("encoded size " ZBX_FS_SIZE_T " exceeds " ZBX_FS_UI64 " bytes",
+					(zbx_fs_size_t)((bs.bits_num + 7) / 8), size_max);
+		}
+	}
+
+	zbx_free(decoded);
+	zbx_free(bs.data);
+}
+
+static void	vc_test_check_item(zbx_vc_item_t *item, const zbx_vector_history_record_t *expected)
+{
+	zbx_vc_chunk_t		*chunk;
+	zbx_history_record_t	*slots[VC_DECODED_CHUNKS_NUM];
+	zbx_vc_chunk_t		*chunks[VC_DECODED_CHUNKS_NUM];
+	int			index = 0, compact_num = 0, chunks_num = 0, starts[VC_DECODED_CHUNKS_NUM];
+
+	/* read values from oldest to newest */
+	for (chunk = item->tail; NULL != chunk; chunk = chunk->next)
+	{
+		zbx_history_record_t	*records = vch_chunk_slots(chunk);
+
+		if (vch_chunk_is_compact(chunk))
+			compact_num++;
+
+		for (int i = chunk->first_value; i <= chunk->last_value; i++, index++)
+		{
+			if (index >= expected->values_num)
+				fail_msg("too many values in cache");
+
+			vc_test_compare_record("cached", index, &expected->values[index], &records[i]);
+		}
+	}
+
+	zbx_mock_assert_int_eq("cached values", expected->values_num, index);
+	zbx_mock_assert_int_eq("values total", expected->values_num, item->values_total);
+
+	/* read values from newest to oldest */
+	for (chunk = item->head; NULL != chunk; chunk = chunk->prev)
+	{
+		zbx_history_record_t	*records = vch_chunk_slots(chunk);
+
+		for (int i = chunk->last_value; i >= chunk->first_value; i--)
+		{
+			index--;
+			vc_test_compare_record("reverse cached", index, &expected->values[index], &records[i]);
+		}
+	}
+
+	/* the recently decoded compact chunks must stay valid while other recent chunks are accessed */
+	for (chunk = item->tail; NULL != chunk && chunks_num < VC_DECODED_CHUNKS_NUM; chunk = chunk->next)
+	{
+		if (vch_chunk_is_compact(chunk))
+		{
+			chunks[chunks_num] = chunk;
+			starts[chunks_num] = index - chunk->first_value;
+			slots[chunks_num++] = vch_chunk_slots(chunk);
+		}
+
+		index += chunk->last_value - chunk->first_value + 1;
+	}
+
+	for (int i = 0; i < chunks_num; i++)
+	{
+		for (int j = chunks[i]->first_value; j <= chunks[i]->last_value; j++)
+		{
+			vc_test_compare_record("recently decoded", starts[i] + j, &expected->values[starts[i] + j],
+					&slots[i][j]);
+		}
+	}
+
+	/* accessing recently decoded chunks must not decode them again */
+	for (int i = chunks_num - 1; i >= 0; i--)
+		zbx_mock_assert_ptr_eq("decoded chunk slots", slots[i], vch_chunk_slots(chunks[i]));
+
+	zbx_mock_assert_int_eq("compact chunks", (int)zbx_mock_get_parameter_uint64("out['compact chunks']"),
+			compact_num);
+}
+
+static void	vc_test_cache(unsigned char value_type, zbx_vector_history_record_t *values)
+{
+	zbx_vc_item_t		*item, item_local = {.itemid = 1, .value_type = value_type};
+	zbx_mock_handle_t	hinserts;
+	char			*error = NULL;
+	const char		*add;
+
+	if (SUCCEED != zbx_locks_create(&error))
+		fail_msg("cannot create locks: %s", error);
+
+	if (SUCCEED != zbx_vc_init(ZBX_MEBIBYTE * 64, 1, 0, &error))
+		fail_msg("cannot initialize value cache: %s", error);
+
+	item = (zbx_vc_item_t *)zbx_hashset_insert(&vc_cache->items, &item_local, sizeof(item_local));
+	add = zbx_mock_get_parameter_string("in.add");
+
+	if (0 == strcmp(add, "head"))
+	{
+		for (int i = 0; i < values->values_num; i++)
+		{
+			if (SUCCEED != vch_item_add_value_at_head(item, &values->values[i]))
+				fail_msg("cannot add value #%d at head", i);
+		}
+	}
+	else if (0 == strcmp(add, "tail"))
+	{
+		if (SUCCEED != vch_item_add_values_at_tail(item, values->values, values->values_num))
+			fail_msg("cannot add values at tail");
+	}
+	else
+		fail_msg("unknown add mode \"%s\"", add);
+
+	/* out of order values expand the compact chunks they must be inserted in */
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter("in.inserts", &hinserts))
+	{
+		int	inserts_start = values->values_num;
+
+		vc_test_read_inserts(hinserts, value_type, values);
+
+		for (int i = inserts_start; i < values->values_num; i++)
+		{
+			if (SUCCEED != vch_item_add_value_at_head(item, &values->values[i]))
+				fail_msg("cannot insert value #%d", i);
+		}
+
+		zbx_vector_history_record_sort(values, (zbx_compare_func_t)zbx_history_record_compare_asc_func);
+	}
+
+	vc_test_check_item(item, values);
+
+	zbx_vc_reset();
+	zbx_vc_destroy();
+	zbx_locks_destroy();
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_vector_history_record_t	values;
+	unsigned char			value_type;
+	zbx_mock_handle_t		hcache;
+
+	ZBX_UNUSED(state);
+
+	value_type = zbx_mock_str_to_value_type(zbx_mock_get_parameter_string("in['value type']"));
+
+	zbx_history_record_vector_create(&values);
+	vc_test_generate_values(zbx_mock_get_parameter_handle("in.values"), value_type, &values);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter("in.add", &hcache))
+		vc_test_cache(value_type, &values);
+	else
+		vc_test_codec(value_type, &values);
+
+	zbx_history_record_vector_destroy(&values, value_type);
+}
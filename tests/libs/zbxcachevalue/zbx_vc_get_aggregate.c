@@ -0,0 +1,118 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxcommon.h"
+#include "zbxcachevalue.h"
+#include "valuecache_test.h"
+#include "mocks/valuecache/valuecache_mock.h"
+
+#include "zbx_vc_common.h"
+
+static void	vc_test_check_aggregate(unsigned char value_type, const zbx_vector_history_record_t *expected,
+		const zbx_vc_aggregate_t *aggregate)
+{
+	int	i;
+
+	zbx_mock_assert_int_eq("aggregate.values_num", expected->values_num, aggregate->values_num);
+
+	if (0 == expected->values_num)
+		return;
+
+	if (ITEM_VALUE_TYPE_FLOAT == value_type)
+	{
+		double	min, max, sum = 0, avg = 0;
+
+		min = max = expected->values[0].value.dbl;
+
+		for (i = 0; i < expected->values_num; i++)
+		{
+			double	value = expected->values[i].value.dbl;
+
+			if (value < min)
+				min = value;
+
+			if (value > max)
+				max = value;
+
+			sum += value;
+			avg += value / (i + 1) - avg / (i + 1);
+		}
+
+		zbx_mock_assert_double_eq("aggregate.min", min, aggregate->min.dbl);
+		zbx_mock_assert_double_eq("aggregate.max", max, aggregate->max.dbl);
+		zbx_mock_assert_double_eq("aggregate.sum", sum, aggregate->sum.dbl);
+		zbx_mock_assert_double_eq("aggregate.avg", avg, aggregate->avg);
+	}
+	else if (ITEM_VALUE_TYPE_UINT64 == value_type)
+	{
+		zbx_uint64_t	min, max, sum = 0;
+
+		min = max = expected->values[0].value.ui64;
+
+		for (i = 0; i < expected->values_num; i++)
+		{
+			zbx_uint64_t	value = expected->values[i].value.ui64;
+
+			if (value < min)
+				min = value;
+
+			if (value > max)
+				max = value;
+
+			sum += value;
+		}
+
+		zbx_mock_assert_uint64_eq("aggregate.min", min, aggregate->min.ui64);
+		zbx_mock_assert_uint64_eq("aggregate.max", max, aggregate->max.ui64);
+		zbx_mock_assert_uint64_eq("aggregate.sum", sum, aggregate->sum.ui64);
+		zbx_mock_assert_double_eq("aggregate.avg", (double)sum / expected->values_num, aggregate->avg);
+	}
+}
+
+static void	zbx_vc_test_get_aggregate_setup(zbx_mock_handle_t *handle, zbx_uint64_t *itemid,
+		unsigned char *value_type, zbx_timespec_t *ts, int *err, zbx_vector_history_record_t *expected,
+		zbx_vector_history_record_t *returned, int *seconds, int *count)
+{
+	zbx_vc_aggregate_t	aggregate;
+
+	ZBX_UNUSED(returned);
+
+	/* perform request */
+
+	*handle = zbx_mock_get_parameter_handle("in.test");
+	zbx_vcmock_set_time(*handle, "time");
+	zbx_vcmock_set_mode(*handle, "cache mode");
+
+	zbx_vcmock_get_request_params(*handle, itemid, value_type, seconds, count, ts);
+	*err = zbx_vc_get_aggregate(*itemid, *value_type, *seconds, *count, ts, &aggregate);
+	zbx_vc_flush_stats();
+	zbx_mock_assert_result_eq("zbx_vc_get_aggregate() return value", SUCCEED, *err);
+
+	/* validate results against the values that would be returned by zbx_vc_get_values() */
+
+	zbx_vcmock_read_values(zbx_mock_get_parameter_handle("out.values"), *value_type, expected);
+	vc_test_check_aggregate(*value_type, expected, &aggregate);
+
+	zbx_history_record_vector_clean(expected, *value_type);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_vc_common_test_func(state, NULL, NULL, zbx_vc_test_get_aggregate_setup, 1);
+}
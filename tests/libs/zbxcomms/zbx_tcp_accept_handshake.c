@@ -0,0 +1,277 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxcommon.h"
+#include "zbxcomms.h"
+
+#define MOCK_TCP_HEADER_DATA	"ZBXD"
+#define MOCK_TCP_HEADER_LEN	ZBX_CONST_STRLEN(MOCK_TCP_HEADER_DATA)
+
+#define MOCK_CONN_HANDSHAKE	0
+#define MOCK_CONN_RECV		1
+#define MOCK_CONN_DONE		2
+
+typedef struct
+{
+	zbx_socket_t		s;
+	zbx_tcp_recv_context_t	context;
+	int			fds[2];
+	char			*message;
+	size_t			message_size;
+	size_t			offset;
+	size_t			chunk;
+	int			delay;
+	int			state;
+	int			round;
+	int			ret;
+	const char		*payload;
+}
+mock_conn_t;
+
+static unsigned int	mock_get_tls_accept(void)
+{
+	zbx_mock_handle_t	hflags, hflag;
+	unsigned int		tls_accept = 0;
+
+	hflags = zbx_mock_get_parameter_handle("in.tls_accept");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hflags, &hflag))
+	{
+		const char	*flag;
+
+		if (ZBX_MOCK_SUCCESS != zbx_mock_string(hflag, &flag))
+			fail_msg("invalid tls_accept flag");
+
+		if (0 == strcmp(flag, "unencrypted"))
+			tls_accept |= ZBX_TCP_SEC_UNENCRYPTED;
+		else if (0 == strcmp(flag, "psk"))
+			tls_accept |= ZBX_TCP_SEC_TLS_PSK;
+		else if (0 == strcmp(flag, "cert"))
+			tls_accept |= ZBX_TCP_SEC_TLS_CERT;
+		else
+			fail_msg("unknown tls_accept flag \"%s\"", flag);
+	}
+
+	return tls_accept;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates connection with a message in Zabbix protocol or a raw     *
+ *          first byte followed by the payload                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	mock_conn_init(mock_conn_t *conn, zbx_mock_handle_t hconn)
+{
+	zbx_mock_handle_t	hfirst;
+	const char		*first;
+	zbx_uint32_t		len32_le;
+	size_t			payload_len;
+
+	memset(conn, 0, sizeof(mock_conn_t));
+
+	if (0 != socketpair(AF_UNIX, SOCK_STREAM, 0, conn->fds))
+		fail_msg("cannot create socket pair: %s", zbx_strerror(errno));
+
+	if (-1 == fcntl(conn->fds[0], F_SETFL, fcntl(conn->fds[0], F_GETFL) | O_NONBLOCK))
+		fail_msg("cannot set non-blocking mode: %s", zbx_strerror(errno));
+
+	conn->payload = zbx_mock_get_object_member_string(hconn, "data");
+	conn->chunk = zbx_mock_get_object_member_uint64(hconn, "chunk");
+	conn->delay = (int)zbx_mock_get_object_member_uint64(hconn, "delay");
+	payload_len = strlen(conn->payload);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hconn, "first", &hfirst) &&
+			ZBX_MOCK_SUCCESS == zbx_mock_string(hfirst, &first))
+	{
+		conn->message_size = 1 + payload_len;
+		conn->message = (char *)zbx_malloc(NULL, conn->message_size);
+		conn->message[0] = (char)strtol(first, NULL, 16);
+		memcpy(conn->message + 1, conn->payload, payload_len);
+	}
+	else
+	{
+		conn->message_size = MOCK_TCP_HEADER_LEN + 1 + 2 * sizeof(zbx_uint32_t) + payload_len;
+		conn->message = (char *)zbx_malloc(NULL, conn->message_size);
+		memcpy(conn->message, MOCK_TCP_HEADER_DATA, MOCK_TCP_HEADER_LEN);
+		conn->message[MOCK_TCP_HEADER_LEN] = ZBX_TCP_PROTOCOL;
+		len32_le = zbx_htole_uint32((zbx_uint32_t)payload_len);
+		memcpy(conn->message + MOCK_TCP_HEADER_LEN + 1, &len32_le, sizeof(len32_le));
+		len32_le = 0;
+		memcpy(conn->message + MOCK_TCP_HEADER_LEN + 1 + sizeof(len32_le), &len32_le, sizeof(len32_le));
+		memcpy(conn->message + MOCK_TCP_HEADER_LEN + 1 + 2 * sizeof(zbx_uint32_t), conn->payload,
+				payload_len);
+	}
+
+	conn->s.socket = conn->fds[0];
+	conn->s.buf_type = ZBX_BUF_TYPE_STAT;
+	conn->s.buffer = conn->s.buf_stat;
+	zbx_strlcpy(conn->s.peer, "test", sizeof(conn->s.peer));
+
+	conn->state = MOCK_CONN_HANDSHAKE;
+	conn->ret = FAIL;
+}
+
+static void	mock_conn_write(mock_conn_t *conn, int round)
+{
+	size_t	len;
+
+	if (round <= conn->delay || conn->offset == conn->message_size)
+		return;
+
+	len = MIN(conn->chunk, conn->message_size - conn->offset);
+
+	if ((ssize_t)len != write(conn->fds[1], conn->message + conn->offset, len))
+		fail_msg("cannot write data: %s", zbx_strerror(errno));
+
+	conn->offset += len;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: continues handshake and receiving on connection like trapper does *
+ *          when connection is reported ready by poll                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	mock_conn_io(mock_conn_t *conn, unsigned int tls_accept, int round)
+{
+	short	events;
+
+	if (MOCK_CONN_HANDSHAKE == conn->state)
+	{
+		if (SUCCEED != zbx_tcp_accept_handshake(&conn->s, tls_accept, &events))
+		{
+			if (0 == events)
+			{
+				conn->state = MOCK_CONN_DONE;
+				conn->round = round;
+			}
+			else
+				zbx_mock_assert_int_eq("handshake events", POLLIN, events);
+
+			return;
+		}
+
+		zbx_mock_assert_int_eq("connection type", ZBX_TCP_SEC_UNENCRYPTED, conn->s.connection_type);
+
+		zbx_tcp_recv_context_init(&conn->s, &conn->context, ZBX_TCP_LARGE);
+		conn->state = MOCK_CONN_RECV;
+	}
+
+	if (FAIL == zbx_tcp_recv_context(&conn->s, &conn->context, ZBX_TCP_LARGE, &events))
+	{
+		if (0 == events)
+			fail_msg("cannot receive data: %s", zbx_socket_strerror());
+
+		return;
+	}
+
+	conn->state = MOCK_CONN_DONE;
+	conn->round = round;
+	conn->ret = SUCCEED;
+}
+
+static void	mock_conn_check(mock_conn_t *conn, zbx_mock_handle_t hconn)
+{
+	zbx_mock_assert_result_eq("handshake result", zbx_mock_str_to_return_code(
+			zbx_mock_get_object_member_string(hconn, "return")), conn->ret);
+
+	zbx_mock_assert_int_eq("completion round", (int)zbx_mock_get_object_member_uint64(hconn, "round"),
+			conn->round);
+
+	if (SUCCEED == conn->ret)
+	{
+		zbx_mock_assert_uint64_eq("received size", strlen(conn->payload), conn->s.read_bytes);
+
+		if (0 != memcmp(conn->payload, conn->s.buffer, strlen(conn->payload)))
+			fail_msg("received data does not match sent data");
+	}
+}
+
+static void	mock_conn_clear(mock_conn_t *conn)
+{
+	if (MOCK_CONN_RECV == conn->state || SUCCEED == conn->ret)
+		zbx_tcp_recv_context_clear(&conn->context);
+
+	if (ZBX_BUF_TYPE_DYN == conn->s.buf_type)
+		zbx_free(conn->s.buffer);
+
+	close(conn->fds[0]);
+	close(conn->fds[1]);
+	zbx_free(conn->message);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t	hconns, hconn;
+	mock_conn_t		conns[8];
+	int			conns_num = 0, done, round;
+	unsigned int		tls_accept;
+
+	ZBX_UNUSED(state);
+
+	/* sockets are read with the real read() */
+	zbx_set_mock_real_path("/");
+
+	tls_accept = mock_get_tls_accept();
+
+	hconns = zbx_mock_get_parameter_handle("in.connections");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hconns, &hconn))
+	{
+		if (ARRSIZE(conns) == conns_num)
+			fail_msg("too many connections");
+
+		mock_conn_init(&conns[conns_num++], hconn);
+	}
+
+	/* every round the clients send the next chunk and the pending connections are served once */
+	for (round = 1, done = 0; done < conns_num; round++)
+	{
+		if (100000 < round)
+			fail_msg("connections did not complete");
+
+		for (int i = 0; i < conns_num; i++)
+			mock_conn_write(&conns[i], round);
+
+		for (int i = 0; i < conns_num; i++)
+		{
+			if (MOCK_CONN_DONE == conns[i].state)
+				continue;
+
+			mock_conn_io(&conns[i], tls_accept, round);
+
+			if (MOCK_CONN_DONE == conns[i].state)
+				done++;
+		}
+	}
+
+	hconns = zbx_mock_get_parameter_handle("out.connections");
+
+	for (int i = 0; i < conns_num; i++)
+	{
+		if (ZBX_MOCK_SUCCESS != zbx_mock_vector_element(hconns, &hconn))
+			fail_msg("missing expected result of connection #%d", i + 1);
+
+		mock_conn_check(&conns[i], hconn);
+		mock_conn_clear(&conns[i]);
+	}
+
+	zbx_set_mock_real_path(NULL);
+}
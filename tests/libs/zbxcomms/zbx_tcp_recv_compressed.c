@@ -0,0 +1,212 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxcommon.h"
+#include "zbxcomms.h"
+#include "zbxcompress.h"
+
+#define MOCK_TCP_HEADER_DATA	"ZBXD"
+#define MOCK_TCP_HEADER_LEN	ZBX_CONST_STRLEN(MOCK_TCP_HEADER_DATA)
+
+/* generates hex digits, compressible enough to exercise inflate with partial input */
+static char	*mock_generate_data(size_t size)
+{
+	static const char	digits[] = "0123456789abcdef";
+	zbx_uint64_t		x = 88172645463325252;
+	char			*data;
+	size_t			i;
+
+	data = (char *)zbx_malloc(NULL, size + 1);
+
+	for (i = 0; i < size; i++)
+	{
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		data[i] = digits[x % 8];
+	}
+
+	data[size] = '\0';
+
+	return data;
+}
+
+static void	mock_uncompress_stream(const char *data, size_t size, const char *compressed, size_t compressed_size,
+		size_t chunk)
+{
+	zbx_uncompress_stream_t	*stream;
+	char			*out;
+	size_t			out_alloc, out_size, offset;
+	int			ret = SUCCEED;
+
+	out_alloc = zbx_mock_get_parameter_uint64("in.capacity");
+	out = (char *)zbx_malloc(NULL, out_alloc + 1);
+
+	if (NULL == (stream = zbx_uncompress_stream_open(out, out_alloc)))
+		fail_msg("cannot open decompression stream: %s", zbx_compress_strerror());
+
+	for (offset = 0; offset < compressed_size && SUCCEED == ret; offset += chunk)
+	{
+		ret = zbx_uncompress_stream_write(stream, compressed + offset,
+				MIN(chunk, compressed_size - offset));
+	}
+
+	if (SUCCEED == ret)
+		ret = zbx_uncompress_stream_close(stream, &out_size);
+	else
+		(void)zbx_uncompress_stream_close(stream, &out_size);
+
+	zbx_mock_assert_result_eq("decompression result", zbx_mock_str_to_return_code(
+			zbx_mock_get_parameter_string("out.return")), ret);
+
+	if (SUCCEED == ret)
+	{
+		zbx_mock_assert_uint64_eq("decompressed size", size, out_size);
+
+		if (0 != memcmp(data, out, size))
+			fail_msg("decompressed data does not match original data");
+	}
+
+	zbx_free(out);
+}
+
+static void	mock_recv_compressed(const char *data, size_t size, const char *compressed, size_t message_size,
+		size_t compressed_size, size_t chunk)
+{
+	zbx_socket_t		s;
+	zbx_tcp_recv_context_t	context;
+	char			header[MOCK_TCP_HEADER_LEN + 1 + 2 * sizeof(zbx_uint32_t)];
+	zbx_uint32_t		len32_le;
+	int			fds[2], streamed = 0;
+	ssize_t			ret = FAIL;
+	size_t			offset = 0;
+	short			events = 0;
+
+	if (0 != socketpair(AF_UNIX, SOCK_STREAM, 0, fds))
+		fail_msg("cannot create socket pair: %s", zbx_strerror(errno));
+
+	if (-1 == fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK))
+		fail_msg("cannot set non-blocking mode: %s", zbx_strerror(errno));
+
+	memcpy(header, MOCK_TCP_HEADER_DATA, MOCK_TCP_HEADER_LEN);
+	header[MOCK_TCP_HEADER_LEN] = ZBX_TCP_PROTOCOL | ZBX_TCP_COMPRESS;
+	len32_le = zbx_htole_uint32((zbx_uint32_t)message_size);
+	memcpy(header + MOCK_TCP_HEADER_LEN + 1, &len32_le, sizeof(len32_le));
+	len32_le = zbx_htole_uint32((zbx_uint32_t)size);
+	memcpy(header + MOCK_TCP_HEADER_LEN + 1 + sizeof(len32_le), &len32_le, sizeof(len32_le));
+
+	if ((ssize_t)sizeof(header) != write(fds[1], header, sizeof(header)))
+		fail_msg("cannot write header: %s", zbx_strerror(errno));
+
+	memset(&s, 0, sizeof(s));
+	s.socket = fds[0];
+	s.buf_type = ZBX_BUF_TYPE_STAT;
+	s.buffer = s.buf_stat;
+	zbx_strlcpy(s.peer, "test", sizeof(s.peer));
+
+	zbx_tcp_recv_context_init(&s, &context, ZBX_TCP_LARGE);
+
+	/* feed data in chunks, receiving whatever is available after each chunk like trapper does */
+	for (;;)
+	{
+		if (offset < compressed_size)
+		{
+			size_t	len = MIN(chunk, compressed_size - offset);
+
+			if ((ssize_t)len != write(fds[1], compressed + offset, len))
+				fail_msg("cannot write data: %s", zbx_strerror(errno));
+
+			offset += len;
+
+			if (offset == compressed_size)
+				close(fds[1]);
+		}
+
+		if (FAIL != (ret = zbx_tcp_recv_context(&s, &context, ZBX_TCP_LARGE, &events)) || 0 == events)
+			break;
+
+		if (NULL != context.stream)
+			streamed = 1;
+
+		if (offset == compressed_size && 0 != events)
+			fail_msg("receiving did not finish after all data was sent");
+	}
+
+	zbx_mock_assert_result_eq("receive result", zbx_mock_str_to_return_code(
+			zbx_mock_get_parameter_string("out.return")), FAIL == ret ? FAIL : SUCCEED);
+
+	zbx_mock_assert_int_eq("data decompressed while receiving", 1, streamed);
+
+	if (NULL != context.stream)
+		fail_msg("decompression stream was not released");
+
+	if (FAIL != ret)
+	{
+		zbx_mock_assert_uint64_eq("received size", size, s.read_bytes);
+
+		if (0 != memcmp(data, s.buffer, size) || '\0' != s.buffer[size])
+			fail_msg("received data does not match sent data");
+	}
+
+	zbx_tcp_recv_context_clear(&context);
+
+	if (ZBX_BUF_TYPE_DYN == s.buf_type)
+		zbx_free(s.buffer);
+
+	close(fds[0]);
+
+	if (offset < compressed_size)
+		close(fds[1]);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	char		*data, *compressed;
+	size_t		size, message_size, compressed_size, chunk;
+	const char	*mode;
+
+	ZBX_UNUSED(state);
+
+	/* sockets are read with the real read() */
+	zbx_set_mock_real_path("/");
+
+	size = zbx_mock_get_parameter_uint64("in.size");
+	chunk = zbx_mock_get_parameter_uint64("in.chunk");
+	data = mock_generate_data(size);
+
+	if (SUCCEED != zbx_compress(data, size, &compressed, &message_size))
+		fail_msg("cannot compress data: %s", zbx_compress_strerror());
+
+	/* drop the end of compressed data */
+	compressed_size = message_size - zbx_mock_get_parameter_uint64("in.truncate");
+
+	mode = zbx_mock_get_parameter_string("in.mode");
+
+	if (0 == strcmp(mode, "stream"))
+		mock_uncompress_stream(data, size, compressed, compressed_size, chunk);
+	else if (0 == strcmp(mode, "socket"))
+		mock_recv_compressed(data, size, compressed, message_size, compressed_size, chunk);
+	else
+		fail_msg("unknown mode \"%s\"", mode);
+
+	zbx_free(compressed);
+	zbx_free(data);
+
+	zbx_set_mock_real_path(NULL);
+}
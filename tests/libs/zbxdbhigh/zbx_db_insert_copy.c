@@ -0,0 +1,375 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+#include "zbxmockdb.h"
+
+#include "../../../src/libs/zbxdbhigh/db.c"
+
+#ifdef HAVE_POSTGRESQL
+/* Rows are inserted with zbx_db_insert_execute() while the libpq COPY functions are replaced by mocks that */
+/* collect the data sent to server. The collected rows are compared with known good binary COPY encoding. */
+/* Benchmark cases compare time spent on COPY encoding and on INSERT statement generation for the same    */
+/* rows. Only client side work is measured, server side parsing needs a running database.                */
+
+int	__wrap_zbx_db_copy_start_basic(const char *table, const char *fields, char **error);
+int	__wrap_zbx_db_copy_put_basic(const char *data, size_t len);
+int	__wrap_zbx_db_copy_end_basic(char **error);
+int	__wrap_zbx_db_txn_level(void);
+int	__wrap_zbx_db_txn_error(void);
+
+static int	copy_result = ZBX_DB_OK;
+static int	copy_keep_data = 1;
+static char	*copy_data = NULL;
+static size_t	copy_data_alloc = 0, copy_data_offset = 0, copy_bytes = 0;
+static int	copy_started = 0;
+
+int	__wrap_zbx_db_copy_start_basic(const char *table, const char *fields, char **error)
+{
+	ZBX_UNUSED(table);
+	ZBX_UNUSED(fields);
+
+	copy_started++;
+
+	if (ZBX_DB_OK != copy_result)
+		*error = zbx_strdup(NULL, "mocked COPY failure");
+
+	return copy_result;
+}
+
+int	__wrap_zbx_db_copy_put_basic(const char *data, size_t len)
+{
+	copy_bytes += len;
+
+	if (0 == copy_keep_data)
+		return ZBX_DB_OK;
+
+	/* binary data contains zero bytes, so string copying functions cannot be used */
+	if (copy_data_offset + len > copy_data_alloc)
+	{
+		copy_data_alloc = copy_data_offset + len;
+		copy_data = (char *)zbx_realloc(copy_data, copy_data_alloc);
+	}
+
+	memcpy(copy_data + copy_data_offset, data, len);
+	copy_data_offset += len;
+
+	return ZBX_DB_OK;
+}
+
+int	__wrap_zbx_db_copy_end_basic(char **error)
+{
+	ZBX_UNUSED(error);
+
+	return ZBX_DB_OK;
+}
+
+int	__wrap_zbx_db_txn_level(void)
+{
+	return 1;
+}
+
+int	__wrap_zbx_db_txn_error(void)
+{
+	return ZBX_DB_OK;
+}
+
+static void	mock_hex_to_bin(const char *hex, char **bin, size_t *bin_offset)
+{
+	*bin = (char *)zbx_malloc(NULL, strlen(hex) / 2 + 1);
+	*bin_offset = 0;
+
+	while ('\0' != *hex)
+	{
+		unsigned int	byte;
+
+		if (NULL != strchr(ZBX_WHITESPACE, *hex))
+		{
+			hex++;
+			continue;
+		}
+
+		if (1 != sscanf(hex, "%2x", &byte) || '\0' == hex[1])
+			fail_msg("invalid hex data \"%s\"", hex);
+
+		(*bin)[(*bin_offset)++] = (char)byte;
+		hex += 2;
+	}
+}
+
+static void	mock_value_parse(const zbx_db_field_t *field, const char *str, zbx_db_value_t *value)
+{
+	switch (field->type)
+	{
+		case ZBX_TYPE_CHAR:
+		case ZBX_TYPE_TEXT:
+		case ZBX_TYPE_LONGTEXT:
+			value->str = (char *)str;
+			break;
+		case ZBX_TYPE_INT:
+			value->i32 = atoi(str);
+			break;
+		case ZBX_TYPE_FLOAT:
+			value->dbl = atof(str);
+			break;
+		case ZBX_TYPE_UINT:
+		case ZBX_TYPE_ID:
+		case ZBX_TYPE_SERIAL:
+			if (SUCCEED != zbx_is_uint64(str, &value->ui64))
+				fail_msg("invalid unsigned value \"%s\" of field \"%s\"", str, field->name);
+			break;
+		default:
+			fail_msg("unsupported type of field \"%s\"", field->name);
+	}
+}
+
+static void	mock_insert_prepare(zbx_db_insert_t *db_insert)
+{
+	zbx_mock_handle_t	hfields, hfield;
+	const zbx_db_table_t	*table;
+	const zbx_db_field_t	*fields[ZBX_MAX_FIELDS];
+	int			fields_num = 0;
+
+	if (NULL == (table = zbx_db_get_table(zbx_mock_get_parameter_string("in.table"))))
+		fail_msg("unknown table \"%s\"", zbx_mock_get_parameter_string("in.table"));
+
+	hfields = zbx_mock_get_parameter_handle("in.fields");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hfields, &hfield))
+	{
+		const char	*name;
+
+		if (ZBX_MOCK_SUCCESS != zbx_mock_string(hfield, &name))
+			fail_msg("invalid field name");
+
+		if (NULL == (fields[fields_num++] = zbx_db_get_field(table, name)))
+			fail_msg("unknown field \"%s\"", name);
+	}
+
+	zbx_db_insert_prepare_dyn(db_insert, table, fields, fields_num);
+	zbx_db_insert_enable_copy(db_insert);
+}
+
+static void	mock_insert_add_row(zbx_db_insert_t *db_insert, const char * const *strs)
+{
+	zbx_db_value_t	values[ZBX_MAX_FIELDS], *pvalues[ZBX_MAX_FIELDS];
+
+	for (int i = 0; i < db_insert->fields.values_num; i++)
+	{
+		mock_value_parse(db_insert->fields.values[i], strs[i], &values[i]);
+		pvalues[i] = &values[i];
+	}
+
+	zbx_db_insert_add_values_dyn(db_insert, pvalues, db_insert->fields.values_num);
+}
+
+static void	mock_insert_add_rows(zbx_db_insert_t *db_insert)
+{
+	zbx_mock_handle_t	hrows, hrow, hvalue;
+
+	hrows = zbx_mock_get_parameter_handle("in.rows");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hrows, &hrow))
+	{
+		const char	*strs[ZBX_MAX_FIELDS];
+		int		values_num = 0;
+
+		while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hrow, &hvalue))
+		{
+			if (values_num == db_insert->fields.values_num)
+				fail_msg("too many values in row");
+
+			if (ZBX_MOCK_SUCCESS != zbx_mock_string(hvalue, &strs[values_num++]))
+				fail_msg("invalid row value");
+		}
+
+		if (values_num != db_insert->fields.values_num)
+			fail_msg("expected %d values in row but got %d", db_insert->fields.values_num, values_num);
+
+		mock_insert_add_row(db_insert, strs);
+	}
+}
+
+static void	mock_check_copy_data(void)
+{
+	char	*expected = NULL;
+	size_t	expected_len;
+
+	if (sizeof(copy_header) + 2 > copy_data_offset)
+		fail_msg("COPY data is too short: " ZBX_FS_SIZE_T " bytes", (zbx_fs_size_t)copy_data_offset);
+
+	if (0 != memcmp(copy_data, copy_header, sizeof(copy_header)))
+		fail_msg("invalid COPY header");
+
+	if (0 != memcmp(copy_data + copy_data_offset - 2, "\377\377", 2))
+		fail_msg("invalid COPY trailer");
+
+	mock_hex_to_bin(zbx_mock_get_parameter_string("out.rows"), &expected, &expected_len);
+
+	zbx_mock_assert_uint64_eq("COPY rows size", expected_len, copy_data_offset - sizeof(copy_header) - 2);
+
+	for (size_t i = 0; i < expected_len; i++)
+	{
+		if (expected[i] != copy_data[sizeof(copy_header) + i])
+		{
+			fail_msg("COPY rows differ at byte " ZBX_FS_SIZE_T ": expected %02x, got %02x",
+					(zbx_fs_size_t)i, (unsigned char)expected[i],
+					(unsigned char)copy_data[sizeof(copy_header) + i]);
+		}
+	}
+
+	zbx_free(expected);
+}
+
+static void	mock_check_insert_rows(const zbx_db_insert_t *db_insert)
+{
+	zbx_mock_handle_t	hvalues, hvalue;
+	int			i = 0, column;
+
+	column = (int)zbx_mock_get_parameter_uint64("out.column");
+	hvalues = zbx_mock_get_parameter_handle("out.values");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hvalues, &hvalue))
+	{
+		const char	*value;
+
+		if (ZBX_MOCK_SUCCESS != zbx_mock_string(hvalue, &value))
+			fail_msg("invalid expected value");
+
+		if (i >= db_insert->rows.values_num)
+			fail_msg("fewer rows than expected");
+
+		zbx_mock_assert_str_eq("inserted value", value, db_insert->rows.values[i++][column].str);
+	}
+
+	zbx_mock_assert_int_eq("inserted rows", i, db_insert->rows.values_num);
+}
+
+static double	mock_benchmark_run(int copy, int rows_num, zbx_uint64_t *copy_size)
+{
+	zbx_config_dbhigh_t	config = {.config_db_bulk_copy = copy};
+	zbx_db_insert_t		db_insert;
+	double			sec;
+
+	zbx_cfg_dbhigh = &config;
+
+	mock_insert_prepare(&db_insert);
+
+	for (int i = 0; i < rows_num; i++)
+	{
+		char		itemid[MAX_ID_LEN + 1], clock[MAX_ID_LEN + 1], value[ZBX_MAX_DOUBLE_LEN + 1],
+				ns[MAX_ID_LEN + 1];
+		const char	*strs[] = {itemid, clock, value, ns};
+
+		zbx_snprintf(itemid, sizeof(itemid), "%d", 10000 + i % 1000);
+		zbx_snprintf(clock, sizeof(clock), "%d", 1700000000 + i / 1000);
+		zbx_snprintf(value, sizeof(value), "%d.%03d", i, i % 1000);
+		zbx_snprintf(ns, sizeof(ns), "%d", (i * 7919) % 1000000000);
+
+		mock_insert_add_row(&db_insert, strs);
+	}
+
+	copy_bytes = 0;
+
+	sec = zbx_time();
+	zbx_mock_assert_result_eq("insert result", SUCCEED, zbx_db_insert_execute(&db_insert));
+	sec = zbx_time() - sec;
+
+	*copy_size = copy_bytes;
+
+	zbx_db_insert_clean(&db_insert);
+
+	zbx_cfg_dbhigh = NULL;
+
+	return sec;
+}
+
+static void	mock_benchmark(void)
+{
+#define COPY_HISTORY_ROW_SIZE	(2 + 4 + 8 + 4 + 4 + 4 + 8 + 4 + 4)
+	int		rows_num;
+	double		copy_sec, insert_sec;
+	zbx_uint64_t	copy_size, insert_copy_size;
+
+	rows_num = (int)zbx_mock_get_parameter_uint64("in.benchmark");
+	copy_keep_data = 0;
+
+	copy_sec = mock_benchmark_run(1, rows_num, &copy_size);
+	insert_sec = mock_benchmark_run(0, rows_num, &insert_copy_size);
+
+	zbx_mock_assert_uint64_eq("COPY data size", sizeof(copy_header) + (zbx_uint64_t)rows_num *
+			COPY_HISTORY_ROW_SIZE + 2, copy_size);
+	zbx_mock_assert_uint64_eq("COPY data size with COPY disabled", 0, insert_copy_size);
+
+	printf("%d rows: COPY encoding " ZBX_FS_DBL " sec, INSERT statement generation " ZBX_FS_DBL " sec\n",
+			rows_num, copy_sec, insert_sec);
+#undef COPY_HISTORY_ROW_SIZE
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_config_dbhigh_t	config = {.config_db_bulk_copy = 1};
+	zbx_db_insert_t		db_insert;
+	const char		*copy;
+
+	ZBX_UNUSED(state);
+
+	zbx_mockdb_init();
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.benchmark"))
+	{
+		mock_benchmark();
+		goto out;
+	}
+
+	copy = zbx_mock_get_parameter_string("in.copy");
+
+	if (0 == strcmp(copy, "ok"))
+		copy_result = ZBX_DB_OK;
+	else if (0 == strcmp(copy, "fail"))
+		copy_result = ZBX_DB_FAIL;
+	else
+		fail_msg("invalid in.copy value \"%s\"", copy);
+
+	zbx_cfg_dbhigh = &config;
+
+	mock_insert_prepare(&db_insert);
+	mock_insert_add_rows(&db_insert);
+
+	zbx_mock_assert_result_eq("insert result", SUCCEED, zbx_db_insert_execute(&db_insert));
+	zbx_mock_assert_int_eq("COPY started", 1, copy_started);
+
+	if (ZBX_DB_OK == copy_result)
+		mock_check_copy_data();
+	else
+		mock_check_insert_rows(&db_insert);
+
+	zbx_db_insert_clean(&db_insert);
+
+	zbx_cfg_dbhigh = NULL;
+	zbx_free(copy_data);
+out:
+	zbx_mockdb_destroy();
+}
+#else
+void	zbx_mock_test_entry(void **state)
+{
+	ZBX_UNUSED(state);
+
+	skip();
+}
+#endif
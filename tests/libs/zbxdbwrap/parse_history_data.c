@@ -0,0 +1,206 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "../../../src/libs/zbxdbwrap/history_data.h"
+
+#define MOCK_LONG_VALUE	"{LONG}"
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: replaces long value placeholders with the configured number of    *
+ *          characters                                                        *
+ *                                                                            *
+ ******************************************************************************/
+static char	*mock_expand_long_value(const char *str)
+{
+	const char	*ptr;
+	char		*out = NULL;
+	size_t		out_alloc = 0, out_offset = 0;
+	zbx_uint64_t	size;
+
+	if (NULL == strstr(str, MOCK_LONG_VALUE))
+		return zbx_strdup(NULL, str);
+
+	size = zbx_mock_get_parameter_uint64("in.long_value_size");
+
+	while (NULL != (ptr = strstr(str, MOCK_LONG_VALUE)))
+	{
+		zbx_strncpy_alloc(&out, &out_alloc, &out_offset, str, (size_t)(ptr - str));
+
+		for (zbx_uint64_t i = 0; i < size; i++)
+			zbx_chrcpy_alloc(&out, &out_alloc, &out_offset, 'a' + (char)(i % 26));
+
+		str = ptr + ZBX_CONST_STRLEN(MOCK_LONG_VALUE);
+	}
+
+	zbx_strcpy_alloc(&out, &out_alloc, &out_offset, str);
+
+	return out;
+}
+
+static zbx_uint64_t	mock_get_member_uint64(zbx_mock_handle_t handle, const char *name)
+{
+	zbx_mock_handle_t	hmember;
+	zbx_uint64_t		value;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(handle, name, &hmember))
+		return 0;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_uint64(hmember, &value))
+		fail_msg("invalid \"%s\" value", name);
+
+	return value;
+}
+
+static void	mock_check_string(zbx_mock_handle_t handle, const char *name, const char *returned)
+{
+	zbx_mock_handle_t	hmember;
+	const char		*expected;
+	char			*value;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(handle, name, &hmember))
+	{
+		if (NULL != returned)
+			fail_msg("unexpected \"%s\" value \"%s\"", name, returned);
+		return;
+	}
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_string(hmember, &expected))
+		fail_msg("invalid \"%s\" value", name);
+
+	if (NULL == returned)
+		fail_msg("missing \"%s\" value", name);
+
+	value = mock_expand_long_value(expected);
+	zbx_mock_assert_str_eq(name, value, returned);
+	zbx_free(value);
+}
+
+static void	mock_check_value(zbx_mock_handle_t hvalue, const zbx_agent_value_t *av, int now)
+{
+	zbx_mock_handle_t	hclock;
+	const char		*clock;
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hvalue, "clock", &hclock) &&
+			ZBX_MOCK_SUCCESS == zbx_mock_string(hclock, &clock) && 0 == strcmp(clock, "now"))
+	{
+		if (av->ts.sec < now)
+			fail_msg("expected current timestamp but got %d", av->ts.sec);
+	}
+	else
+	{
+		zbx_mock_assert_int_eq("clock", (int)mock_get_member_uint64(hvalue, "clock"), av->ts.sec);
+		zbx_mock_assert_int_eq("ns", (int)mock_get_member_uint64(hvalue, "ns"), av->ts.ns);
+	}
+
+	mock_check_string(hvalue, "value", av->value);
+	mock_check_string(hvalue, "source", av->source);
+
+	zbx_mock_assert_int_eq("state", (int)mock_get_member_uint64(hvalue, "state"), av->state);
+	zbx_mock_assert_int_eq("meta", (int)mock_get_member_uint64(hvalue, "meta"), av->meta);
+	zbx_mock_assert_uint64_eq("lastlogsize", mock_get_member_uint64(hvalue, "lastlogsize"), av->lastlogsize);
+	zbx_mock_assert_int_eq("mtime", (int)mock_get_member_uint64(hvalue, "mtime"), av->mtime);
+	zbx_mock_assert_int_eq("timestamp", (int)mock_get_member_uint64(hvalue, "timestamp"), av->timestamp);
+	zbx_mock_assert_int_eq("severity", (int)mock_get_member_uint64(hvalue, "severity"), av->severity);
+	zbx_mock_assert_int_eq("logeventid", (int)mock_get_member_uint64(hvalue, "logeventid"), av->logeventid);
+	zbx_mock_assert_uint64_eq("id", mock_get_member_uint64(hvalue, "id"), av->id);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	struct zbx_json_parse	jp, jp_data;
+	zbx_agent_value_t	*values;
+	zbx_host_key_t		*hostkeys;
+	zbx_uint64_t		*itemids;
+	zbx_timespec_t		unique_shift = {0, 0};
+	zbx_mock_handle_t	hvalues, hvalue;
+	const char		*pnext = NULL, *protocol;
+	char			*data, *error = NULL;
+	int			values_num, parsed_num, ret, i = 0, now;
+
+	ZBX_UNUSED(state);
+
+	now = (int)time(NULL);
+
+	data = mock_expand_long_value(zbx_mock_get_parameter_string("in.data"));
+
+	if (SUCCEED != zbx_json_open(data, &jp))
+		fail_msg("invalid input data: %s", zbx_json_strerror());
+
+	if (SUCCEED != zbx_json_brackets_by_name(&jp, ZBX_PROTO_TAG_DATA, &jp_data))
+		fail_msg("missing history data array: %s", zbx_json_strerror());
+
+	values = (zbx_agent_value_t *)zbx_calloc(NULL, ZBX_HISTORY_VALUES_MAX, sizeof(zbx_agent_value_t));
+	hostkeys = (zbx_host_key_t *)zbx_calloc(NULL, ZBX_HISTORY_VALUES_MAX, sizeof(zbx_host_key_t));
+	itemids = (zbx_uint64_t *)zbx_malloc(NULL, ZBX_HISTORY_VALUES_MAX * sizeof(zbx_uint64_t));
+
+	protocol = zbx_mock_get_parameter_string("in.protocol");
+
+	if (0 == strcmp(protocol, "itemid"))
+	{
+		ret = parse_history_data_by_itemids(&jp_data, &pnext, values, itemids, &values_num, &parsed_num,
+				&unique_shift, &error);
+	}
+	else if (0 == strcmp(protocol, "hostkey"))
+		ret = parse_history_data(&jp_data, &pnext, values, hostkeys, &values_num, &parsed_num, &unique_shift);
+	else
+		fail_msg("unknown protocol \"%s\"", protocol);
+
+	zbx_mock_assert_result_eq("return value", SUCCEED, ret);
+	zbx_mock_assert_int_eq("parsed rows", (int)zbx_mock_get_parameter_uint64("out.parsed"), parsed_num);
+
+	hvalues = zbx_mock_get_parameter_handle("out.values");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hvalues, &hvalue))
+	{
+		if (i >= values_num)
+			fail_msg("parsed fewer values than expected");
+
+		if (0 == strcmp(protocol, "itemid"))
+		{
+			zbx_mock_assert_uint64_eq("itemid", zbx_mock_get_object_member_uint64(hvalue, "itemid"),
+					itemids[i]);
+		}
+		else
+		{
+			zbx_mock_assert_str_eq("host", zbx_mock_get_object_member_string(hvalue, "host"),
+					hostkeys[i].host);
+			zbx_mock_assert_str_eq("key", zbx_mock_get_object_member_string(hvalue, "key"),
+					hostkeys[i].key);
+		}
+
+		mock_check_value(hvalue, &values[i++], now);
+	}
+
+	zbx_mock_assert_int_eq("parsed values", i, values_num);
+
+	for (i = 0; i < ZBX_HISTORY_VALUES_MAX; i++)
+	{
+		zbx_free(values[i].value);
+		zbx_free(values[i].source);
+		zbx_free(hostkeys[i].host);
+		zbx_free(hostkeys[i].key);
+	}
+
+	zbx_free(itemids);
+	zbx_free(hostkeys);
+	zbx_free(values);
+	zbx_free(error);
+	zbx_free(data);
+}
@@ -0,0 +1,204 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxfile.h"
+
+#include "zbxcommon.h"
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+/* Lines of random length are generated with known positions of newlines and NULL characters, then */
+/* the buffer is split with zbx_find_buf_newline() starting at given offset from aligned address.  */
+
+typedef struct
+{
+	size_t	end;	/* offset of line end (before newline) */
+	size_t	next;	/* offset of next line */
+}
+mock_line_t;
+
+ZBX_VECTOR_DECL(mock_line, mock_line_t)
+ZBX_VECTOR_IMPL(mock_line, mock_line_t)
+
+static int	mock_random(zbx_uint64_t *seed, int range)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 7;
+	*seed ^= *seed << 17;
+
+	return (int)(*seed % (zbx_uint64_t)range);
+}
+
+/* unlike zbx_strncpy_alloc() copies NULL bytes of multi-byte encodings */
+static void	mock_append(char **data, size_t *data_alloc, size_t *data_offset, const char *src, size_t n)
+{
+	if (*data_offset + n > *data_alloc)
+	{
+		*data_alloc = MAX(*data_alloc * 2, *data_offset + n);
+		*data = (char *)zbx_realloc(*data, *data_alloc);
+	}
+
+	memcpy(*data + *data_offset, src, n);
+	*data_offset += n;
+}
+
+static void	mock_append_char(char **data, size_t *data_alloc, size_t *data_offset, const char *lf,
+		size_t szbyte, char c)
+{
+	char	buf[4];
+	size_t	i;
+
+	/* character is placed where line feed has its non-zero byte */
+	for (i = 0; i < szbyte; i++)
+		buf[i] = ('\0' == lf[i] ? '\0' : c);
+
+	mock_append(data, data_alloc, data_offset, buf, szbyte);
+}
+
+static void	mock_generate(zbx_uint64_t seed, const char *cr, const char *lf, size_t szbyte, char **data,
+		size_t *size, char **expected, zbx_vector_mock_line_t *lines)
+{
+	size_t		data_alloc = 0, data_offset = 0, expected_alloc = 0, expected_offset = 0;
+	int		i, lines_num, max_line, nul, prev_cr = 0;
+	const char	*newline;
+
+	lines_num = (int)zbx_mock_get_parameter_uint64("in.lines");
+	max_line = (int)zbx_mock_get_parameter_uint64("in.max_line");
+	nul = (int)zbx_mock_get_parameter_uint64("in.nul");
+	newline = zbx_mock_get_parameter_string("in.newline");
+
+	/* the last line is not terminated and must not be returned */
+	for (i = 0; i <= lines_num; i++)
+	{
+		int		j, len;
+		const char	*type = newline;
+		mock_line_t	line;
+
+		len = mock_random(&seed, max_line + 1);
+
+		for (j = 0; j < len; j++)
+		{
+			char	c = (char)('a' + mock_random(&seed, 26));
+
+			/* UTF-32 NULL characters are not replaced */
+			if (0 != nul && 4 != szbyte && 0 == mock_random(&seed, nul))
+			{
+				mock_append_char(data, &data_alloc, &data_offset, lf, szbyte, '\0');
+				mock_append_char(expected, &expected_alloc, &expected_offset, lf, szbyte, '?');
+				continue;
+			}
+
+			mock_append_char(data, &data_alloc, &data_offset, lf, szbyte, c);
+			mock_append_char(expected, &expected_alloc, &expected_offset, lf, szbyte, c);
+		}
+
+		if (i == lines_num)
+			break;
+
+		line.end = data_offset;
+
+		if (0 == strcmp(newline, "mixed"))
+		{
+			const char	*types[] = {"lf", "cr", "crlf"};
+
+			type = types[mock_random(&seed, 3)];
+
+			/* empty line after CR would be joined with LF into CR+LF */
+			if (1 == prev_cr && 0 == len)
+				type = "cr";
+		}
+
+		prev_cr = 0;
+
+		if (0 == strcmp(type, "lf"))
+		{
+			mock_append(data, &data_alloc, &data_offset, lf, szbyte);
+		}
+		else if (0 == strcmp(type, "cr"))
+		{
+			mock_append(data, &data_alloc, &data_offset, cr, szbyte);
+			prev_cr = 1;
+		}
+		else if (0 == strcmp(type, "crlf"))
+		{
+			mock_append(data, &data_alloc, &data_offset, cr, szbyte);
+			mock_append(data, &data_alloc, &data_offset, lf, szbyte);
+		}
+		else
+			fail_msg("unknown newline \"%s\"", type);
+
+		mock_append(expected, &expected_alloc, &expected_offset, *data + line.end,
+				data_offset - line.end);
+
+		line.next = data_offset;
+		zbx_vector_mock_line_append(lines, line);
+	}
+
+	/* empty buffer is still allocated to have valid pointers */
+	if (NULL == *data)
+	{
+		*data = zbx_strdup(NULL, "");
+		*expected = zbx_strdup(NULL, "");
+	}
+
+	*size = data_offset;
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	const char		*cr, *lf;
+	char			*data = NULL, *expected = NULL, *buf, *p, *p_next, *p_end, *end;
+	size_t			szbyte, size, offset;
+	zbx_vector_mock_line_t	lines;
+	int			i;
+
+	ZBX_UNUSED(state);
+
+	zbx_find_cr_lf_szbyte(zbx_mock_get_parameter_string("in.encoding"), &cr, &lf, &szbyte);
+
+	zbx_vector_mock_line_create(&lines);
+	mock_generate(zbx_mock_get_parameter_uint64("in.seed"), cr, lf, szbyte, &data, &size, &expected, &lines);
+
+	/* unaligned buffer start exercises unaligned block loads */
+	offset = zbx_mock_get_parameter_uint64("in.offset");
+	buf = (char *)zbx_malloc(NULL, size + offset + 1);
+	memcpy(buf + offset, data, size);
+	p = buf + offset;
+	p_end = p + size;
+
+	for (i = 0; i < lines.values_num; i++)
+	{
+		if (NULL == (end = zbx_find_buf_newline(p, &p_next, p_end, cr, lf, szbyte)))
+			fail_msg("newline of line %d was not found", i + 1);
+
+		zbx_mock_assert_uint64_eq("line end", lines.values[i].end, (zbx_uint64_t)(end - (buf + offset)));
+		zbx_mock_assert_uint64_eq("next line", lines.values[i].next, (zbx_uint64_t)(p_next - (buf + offset)));
+
+		p = p_next;
+	}
+
+	if (NULL != zbx_find_buf_newline(p, &p_next, p_end, cr, lf, szbyte))
+		fail_msg("newline was found in unterminated last line");
+
+	if (0 != memcmp(buf + offset, expected, size))
+		fail_msg("NULL characters were not replaced as expected");
+
+	zbx_free(buf);
+	zbx_free(expected);
+	zbx_free(data);
+	zbx_vector_mock_line_destroy(&lines);
+}
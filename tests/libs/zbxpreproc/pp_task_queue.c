@@ -0,0 +1,621 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxcommon.h"
+#include "zbxjson.h"
+#include "zbxdiag.h"
+#include "zbxtime.h"
+#include "zbxpreproc.h"
+#include "zbxpreprocbase.h"
+#include "libs/zbxpreproc/pp_queue.h"
+#include "libs/zbxpreproc/pp_task.h"
+
+/* The test runs the task queue with worker threads using the same protocol as preprocessing workers and */
+/* the main thread acting as preprocessing manager - pushing new tasks, processing finished tasks and     */
+/* requeuing sequences. Every processed task is recorded to check per item ordering and that no item is   */
+/* processed by two workers at the same time.                                                            */
+
+#define MOCK_WAIT_TIMEOUT	5
+
+static const struct timespec	mock_poll_delay = {0, 1000000};
+
+zbx_dc_um_shared_handle_t	*__wrap_zbx_dc_um_shared_handle_copy(zbx_dc_um_shared_handle_t *handle);
+void	__wrap_zbx_dc_um_shared_handle_release(zbx_dc_um_shared_handle_t *handle);
+int	__wrap_zbx_preprocessor_get_queue_stats(zbx_pp_queue_stats_t *stats, char **error);
+
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	unsigned char	type;
+	int		index;
+}
+mock_task_record_t;
+
+ZBX_VECTOR_DECL(mock_task_record, mock_task_record_t)
+ZBX_VECTOR_IMPL(mock_task_record, mock_task_record_t)
+
+typedef struct
+{
+	zbx_pp_queue_t	*queue;
+	int		id;
+	int		stop;
+	pthread_t	thread;
+}
+mock_worker_t;
+
+static zbx_pp_queue_t			queue;
+static pthread_mutex_t			records_lock = PTHREAD_MUTEX_INITIALIZER;
+static zbx_vector_mock_task_record_t	records;
+static zbx_vector_uint64_t		items_busy;
+static int				records_errors;
+
+zbx_dc_um_shared_handle_t	*__wrap_zbx_dc_um_shared_handle_copy(zbx_dc_um_shared_handle_t *handle)
+{
+	return handle;
+}
+
+void	__wrap_zbx_dc_um_shared_handle_release(zbx_dc_um_shared_handle_t *handle)
+{
+	ZBX_UNUSED(handle);
+}
+
+int	__wrap_zbx_preprocessor_get_queue_stats(zbx_pp_queue_stats_t *stats, char **error)
+{
+	ZBX_UNUSED(error);
+
+	pp_task_queue_get_contention_stats(&queue, stats);
+
+	return SUCCEED;
+}
+
+static int	mock_task_index(const zbx_pp_task_t *task)
+{
+	const zbx_pp_task_dependent_t	*d_dep;
+
+	switch (task->type)
+	{
+		case ZBX_PP_TASK_VALUE_SEQ:
+			return ((const zbx_pp_task_value_t *)PP_TASK_DATA(task))->ts.sec;
+		case ZBX_PP_TASK_DEPENDENT:
+			d_dep = (const zbx_pp_task_dependent_t *)PP_TASK_DATA(task);
+			return ((const zbx_pp_task_value_t *)PP_TASK_DATA(d_dep->primary))->ts.sec;
+		default:
+			fail_msg("unexpected task type %u", task->type);
+			return -1;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: process the first task of sequence like a preprocessing worker    *
+ *                                                                            *
+ ******************************************************************************/
+static void	mock_task_process(zbx_pp_task_t *task_seq)
+{
+	zbx_pp_task_sequence_t	*d_seq = (zbx_pp_task_sequence_t *)PP_TASK_DATA(task_seq);
+	zbx_pp_task_t		*task;
+	mock_task_record_t	record;
+	int			i;
+
+	pthread_mutex_lock(&records_lock);
+
+	if (ZBX_PP_TASK_SEQUENCE != task_seq->type || SUCCEED != zbx_list_peek(&d_seq->tasks, (void **)&task))
+	{
+		records_errors++;
+		pthread_mutex_unlock(&records_lock);
+		return;
+	}
+
+	if (FAIL != zbx_vector_uint64_search(&items_busy, task_seq->itemid, ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+		records_errors++;
+
+	zbx_vector_uint64_append(&items_busy, task_seq->itemid);
+
+	record.itemid = task->itemid;
+	record.type = task->type;
+	record.index = mock_task_index(task);
+	zbx_vector_mock_task_record_append(&records, record);
+
+	pthread_mutex_unlock(&records_lock);
+
+	/* give other workers a chance to pick tasks of the same item if sequencing is broken */
+	sched_yield();
+
+	pthread_mutex_lock(&records_lock);
+
+	if (FAIL != (i = zbx_vector_uint64_search(&items_busy, task_seq->itemid, ZBX_DEFAULT_UINT64_COMPARE_FUNC)))
+		zbx_vector_uint64_remove_noorder(&items_busy, i);
+
+	pthread_mutex_unlock(&records_lock);
+}
+
+static void	*mock_worker_entry(void *args)
+{
+	mock_worker_t	*worker = (mock_worker_t *)args;
+	zbx_pp_task_t	*task;
+	zbx_uint64_t	notify_seq;
+	char		*error = NULL;
+
+	notify_seq = pp_task_queue_register_worker(worker->queue);
+
+	for (;;)
+	{
+		if (NULL != (task = pp_task_queue_pop_new(worker->queue, worker->id)))
+		{
+			mock_task_process(task);
+
+			pp_task_queue_lock_finished(worker->queue);
+			pp_task_queue_push_finished(worker->queue, task);
+			pp_task_queue_unlock_finished(worker->queue);
+
+			continue;
+		}
+
+		if (SUCCEED != pp_task_queue_wait(worker->queue, &notify_seq, &worker->stop, &error))
+			break;
+	}
+
+	zbx_free(error);
+	pp_task_queue_deregister_worker(worker->queue);
+
+	return NULL;
+}
+
+static void	mock_worker_stop(mock_worker_t *worker)
+{
+	pp_task_queue_lock(worker->queue);
+	worker->stop = 1;
+	pp_task_queue_unlock(worker->queue);
+}
+
+static zbx_pp_task_t	*mock_task_create(zbx_pp_item_preproc_t *preproc, zbx_uint64_t itemid, const char *type,
+		int index)
+{
+	zbx_timespec_t	ts = {.sec = index, .ns = 0};
+	zbx_pp_task_t	*task;
+
+	/* the user macro handle is not used by the queue, the copy/release functions are mocked */
+	if (0 == strcmp(type, "value_seq"))
+		return pp_task_value_seq_create(itemid, preproc, (zbx_dc_um_shared_handle_t *)preproc, NULL, ts, NULL,
+				NULL);
+
+	if (0 == strcmp(type, "dependent"))
+	{
+		task = pp_task_dependent_create(itemid, preproc);
+		((zbx_pp_task_dependent_t *)PP_TASK_DATA(task))->primary = pp_task_value_create(itemid, preproc,
+				(zbx_dc_um_shared_handle_t *)preproc, NULL, ts, NULL, NULL);
+
+		return task;
+	}
+
+	fail_msg("unknown task type \"%s\"", type);
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: push tasks like preprocessing manager - new values are queued as  *
+ *          pending tasks and dependent tasks are queued as immediate         *
+ *                                                                            *
+ ******************************************************************************/
+static void	mock_task_push(zbx_pp_task_t *task)
+{
+	if (ZBX_PP_TASK_VALUE_SEQ == task->type)
+		pp_task_queue_push(&queue, task);
+	else
+		pp_task_queue_push_immediate(&queue, task);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finish the first task of sequence and requeue the sequence like   *
+ *          preprocessing manager                                             *
+ *                                                                            *
+ * Return value: SUCCEED - a value task was finished                          *
+ *               FAIL    - the sequence was empty                             *
+ *                                                                            *
+ ******************************************************************************/
+static int	mock_task_finish(zbx_pp_task_t *task_seq)
+{
+	zbx_pp_task_t	*task;
+	int		ret = FAIL;
+
+	if (NULL != (task = pp_task_queue_pop_sequence_task(&queue, task_seq)))
+	{
+		pp_task_free(task);
+		ret = SUCCEED;
+	}
+
+	if (SUCCEED == pp_task_queue_requeue_sequence(&queue, task_seq))
+		pp_task_queue_notify(&queue);
+	else
+		pp_task_free(task_seq);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: process finished tasks like preprocessing manager                 *
+ *                                                                            *
+ * Return value: The number of finished value tasks.                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	mock_process_finished(void)
+{
+	zbx_vector_pp_task_ptr_t	tasks;
+	int				finished_num = 0;
+
+	zbx_vector_pp_task_ptr_create(&tasks);
+
+	(void)pp_task_queue_pop_finished(&queue, &tasks, 100);
+
+	for (int i = 0; i < tasks.values_num; i++)
+	{
+		if (SUCCEED == mock_task_finish(tasks.values[i]))
+			finished_num++;
+	}
+
+	zbx_vector_pp_task_ptr_destroy(&tasks);
+
+	return finished_num;
+}
+
+static void	mock_check_order(int tasks_num)
+{
+	zbx_hashset_t		last;
+	mock_task_record_t	*record, *prev;
+
+	zbx_mock_assert_int_eq("concurrently processed tasks of the same item", 0, records_errors);
+	zbx_mock_assert_int_eq("processed tasks", tasks_num, records.values_num);
+
+	/* tasks of the same type are queued in the same list, so their order must be kept */
+	zbx_hashset_create(&last, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	for (int i = 0; i < records.values_num; i++)
+	{
+		mock_task_record_t	key;
+
+		record = &records.values[i];
+
+		key = *record;
+		key.itemid = record->itemid * 2 + (ZBX_PP_TASK_DEPENDENT == record->type);
+
+		if (NULL != (prev = (mock_task_record_t *)zbx_hashset_search(&last, &key)))
+		{
+			if (prev->index >= record->index)
+			{
+				fail_msg("item " ZBX_FS_UI64 " task %d was processed after task %d", record->itemid,
+						record->index, prev->index);
+			}
+
+			prev->index = record->index;
+		}
+		else
+			zbx_hashset_insert(&last, &key, sizeof(key));
+	}
+
+	zbx_hashset_destroy(&last);
+}
+
+static void	mock_test_order(void)
+{
+	zbx_mock_handle_t	htasks, htask;
+	zbx_pp_item_preproc_t	*preproc;
+	mock_worker_t		*workers;
+	int			workers_num, batch, repeat, tasks_num = 0, finished_num = 0, pushed_num = 0;
+	double			progress_time;
+	zbx_vector_ptr_t	tasks;
+
+	workers_num = (int)zbx_mock_get_parameter_uint64("in.workers");
+	batch = (int)zbx_mock_get_parameter_uint64("in.batch");
+	repeat = (int)zbx_mock_get_parameter_uint64("in.repeat");
+
+	preproc = zbx_pp_item_preproc_create(0, ITEM_TYPE_ZABBIX, ITEM_VALUE_TYPE_UINT64, 0);
+	zbx_vector_ptr_create(&tasks);
+
+	for (int i = 0; i < repeat; i++)
+	{
+		htasks = zbx_mock_get_parameter_handle("in.tasks");
+
+		while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(htasks, &htask))
+		{
+			zbx_uint64_t	itemid;
+
+			itemid = zbx_mock_get_object_member_uint64(htask, "itemid");
+			zbx_vector_ptr_append(&tasks, mock_task_create(preproc, itemid,
+					zbx_mock_get_object_member_string(htask, "type"), tasks_num++));
+		}
+	}
+
+	workers = (mock_worker_t *)zbx_calloc(NULL, (size_t)workers_num, sizeof(mock_worker_t));
+
+	for (int i = 0; i < workers_num; i++)
+	{
+		workers[i].queue = &queue;
+		workers[i].id = i;
+
+		if (0 != pthread_create(&workers[i].thread, NULL, mock_worker_entry, &workers[i]))
+			fail_msg("cannot create worker thread");
+	}
+
+	progress_time = zbx_time();
+
+	while (finished_num < tasks_num)
+	{
+		int	num;
+
+		for (num = 0; num < batch && pushed_num < tasks_num; num++)
+			mock_task_push((zbx_pp_task_t *)tasks.values[pushed_num++]);
+
+		pp_task_queue_notify_num(&queue, num);
+
+		if (0 != (num = mock_process_finished()))
+		{
+			finished_num += num;
+			progress_time = zbx_time();
+			continue;
+		}
+
+		/* workers must be woken up for every pushed task, so stalling means lost notification */
+		if (MOCK_WAIT_TIMEOUT < zbx_time() - progress_time)
+			break;
+
+		nanosleep(&mock_poll_delay, NULL);
+	}
+
+	for (int i = 0; i < workers_num; i++)
+		mock_worker_stop(&workers[i]);
+
+	pp_task_queue_notify_all(&queue);
+
+	for (int i = 0; i < workers_num; i++)
+		pthread_join(workers[i].thread, NULL);
+
+	zbx_free(workers);
+
+	zbx_mock_assert_int_eq("finished tasks", tasks_num, finished_num);
+	mock_check_order(tasks_num);
+
+	zbx_vector_ptr_destroy(&tasks);
+	zbx_pp_item_preproc_release(preproc);
+}
+
+typedef struct
+{
+	zbx_uint64_t	notify_seq;
+	int		stop;
+	int		done;
+}
+mock_waiter_t;
+
+static void	*mock_waiter_entry(void *args)
+{
+	mock_waiter_t	*waiter = (mock_waiter_t *)args;
+	char		*error = NULL;
+
+	(void)pp_task_queue_wait(&queue, &waiter->notify_seq, &waiter->stop, &error);
+	zbx_free(error);
+
+	pp_task_queue_lock(&queue);
+	waiter->done = 1;
+	pp_task_queue_unlock(&queue);
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: wait until waiter thread returns from pp_task_queue_wait()        *
+ *                                                                            *
+ * Return value: SUCCEED - the waiter thread was woken up                     *
+ *               FAIL    - the waiter thread was still waiting after timeout, *
+ *                         it is stopped before returning                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	mock_waiter_join(mock_waiter_t *waiter, pthread_t thread)
+{
+	double	start = zbx_time();
+	int	done;
+
+	do
+	{
+		pp_task_queue_lock(&queue);
+		done = waiter->done;
+		pp_task_queue_unlock(&queue);
+
+		if (0 != done)
+			break;
+
+		nanosleep(&mock_poll_delay, NULL);
+	}
+	while (MOCK_WAIT_TIMEOUT > zbx_time() - start);
+
+	if (0 == done)
+	{
+		pp_task_queue_lock(&queue);
+		waiter->stop = 1;
+		pp_task_queue_unlock(&queue);
+
+		pp_task_queue_notify_all(&queue);
+	}
+
+	pthread_join(thread, NULL);
+
+	return 0 != done ? SUCCEED : FAIL;
+}
+
+static void	mock_test_wakeup(void)
+{
+	zbx_pp_item_preproc_t	*preproc;
+	zbx_pp_task_t		*task;
+	mock_waiter_t		waiter = {0};
+	pthread_t		thread;
+	int			idle_num = 0;
+
+	preproc = zbx_pp_item_preproc_create(0, ITEM_TYPE_ZABBIX, ITEM_VALUE_TYPE_UINT64, 0);
+
+	/* task pushed after worker found the queue empty, but before it started waiting */
+	waiter.notify_seq = pp_task_queue_register_worker(&queue);
+
+	if (NULL != pp_task_queue_pop_new(&queue, 0))
+		fail_msg("popped task from empty queue");
+
+	pp_task_queue_push(&queue, mock_task_create(preproc, 1, "value_seq", 0));
+	pp_task_queue_notify_num(&queue, 1);
+
+	if (0 != pthread_create(&thread, NULL, mock_waiter_entry, &waiter))
+		fail_msg("cannot create waiter thread");
+
+	if (SUCCEED != mock_waiter_join(&waiter, thread))
+		fail_msg("worker was not woken up by task pushed before it started waiting");
+
+	if (NULL == (task = pp_task_queue_pop_new(&queue, 0)))
+		fail_msg("cannot pop pushed task");
+
+	(void)mock_task_finish(task);
+
+	/* task pushed while worker is waiting */
+	waiter.done = 0;
+
+	if (0 != pthread_create(&thread, NULL, mock_waiter_entry, &waiter))
+		fail_msg("cannot create waiter thread");
+
+	for (double start = zbx_time(); 0 == idle_num && MOCK_WAIT_TIMEOUT > zbx_time() - start;)
+	{
+		pp_task_queue_lock(&queue);
+		idle_num = queue.idle_num;
+		pp_task_queue_unlock(&queue);
+
+		nanosleep(&mock_poll_delay, NULL);
+	}
+
+	pp_task_queue_push(&queue, mock_task_create(preproc, 2, "value_seq", 0));
+	pp_task_queue_notify_num(&queue, 1);
+
+	if (SUCCEED != mock_waiter_join(&waiter, thread))
+		fail_msg("idle worker was not woken up by pushed task");
+
+	if (NULL == (task = pp_task_queue_pop_new(&queue, 0)))
+		fail_msg("cannot pop pushed task");
+
+	(void)mock_task_finish(task);
+
+	pp_task_queue_deregister_worker(&queue);
+	zbx_pp_item_preproc_release(preproc);
+}
+
+static zbx_uint64_t	mock_json_get_uint64(const struct zbx_json_parse *jp, const char *name)
+{
+	char		buf[MAX_ID_LEN + 1];
+	zbx_uint64_t	value;
+
+	if (SUCCEED != zbx_json_value_by_name(jp, name, buf, sizeof(buf), NULL))
+		fail_msg("cannot find diagnostic field \"%s\"", name);
+
+	if (SUCCEED != zbx_is_uint64(buf, &value))
+		fail_msg("invalid diagnostic field \"%s\" value \"%s\"", name, buf);
+
+	return value;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: check that queue contention counters are reported in diagnostic   *
+ *          information                                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	mock_check_diag(void)
+{
+	struct zbx_json		json;
+	struct zbx_json_parse	jp, jp_preproc, jp_queue;
+	zbx_pp_queue_stats_t	stats;
+	char			*error = NULL;
+
+	zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
+
+	if (SUCCEED != zbx_json_open("{\"stats\":[\"queue\"]}", &jp))
+		fail_msg("cannot open diagnostic request");
+
+	if (SUCCEED != zbx_diag_add_preproc_info(&jp, &json, &error))
+		fail_msg("cannot get diagnostic information: %s", error);
+
+	zbx_json_close(&json);
+
+	if (SUCCEED != zbx_json_open(json.buffer, &jp) ||
+			SUCCEED != zbx_json_brackets_by_name(&jp, ZBX_DIAG_PREPROCESSING, &jp_preproc) ||
+			SUCCEED != zbx_json_brackets_by_name(&jp_preproc, "queue", &jp_queue))
+	{
+		fail_msg("cannot find queue statistics in \"%s\"", json.buffer);
+	}
+
+	pp_task_queue_get_contention_stats(&queue, &stats);
+
+	zbx_mock_assert_uint64_eq("shards", zbx_mock_get_parameter_uint64("in.shards"),
+			mock_json_get_uint64(&jp_queue, "shards"));
+	zbx_mock_assert_uint64_eq("locks", stats.locks_num, mock_json_get_uint64(&jp_queue, "locks"));
+	zbx_mock_assert_uint64_eq("contended locks", stats.locks_contended_num,
+			mock_json_get_uint64(&jp_queue, "contended locks"));
+	zbx_mock_assert_uint64_eq("steals", stats.steals_num, mock_json_get_uint64(&jp_queue, "steals"));
+	zbx_mock_assert_uint64_eq("finished locks", stats.finished_locks_num,
+			mock_json_get_uint64(&jp_queue, "finished locks"));
+	zbx_mock_assert_uint64_eq("finished contended locks", stats.finished_locks_contended_num,
+			mock_json_get_uint64(&jp_queue, "finished contended locks"));
+	zbx_mock_assert_uint64_eq("idle waits", stats.waits_num, mock_json_get_uint64(&jp_queue, "idle waits"));
+
+	if (0 == stats.locks_num)
+		fail_msg("shard locks were not counted");
+
+	if (stats.waits_num < zbx_mock_get_parameter_uint64("out.waits_min"))
+		fail_msg("expected at least " ZBX_FS_UI64 " idle waits, got " ZBX_FS_UI64,
+				zbx_mock_get_parameter_uint64("out.waits_min"), stats.waits_num);
+
+	zbx_json_free(&json);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	const char	*test;
+	char		*error = NULL;
+
+	ZBX_UNUSED(state);
+
+	zbx_vector_mock_task_record_create(&records);
+	zbx_vector_uint64_create(&items_busy);
+
+	if (SUCCEED != pp_task_queue_init(&queue, (int)zbx_mock_get_parameter_uint64("in.shards"), &error))
+		fail_msg("cannot initialize task queue: %s", error);
+
+	test = zbx_mock_get_parameter_string("in.test");
+
+	if (0 == strcmp(test, "order"))
+		mock_test_order();
+	else if (0 == strcmp(test, "wakeup"))
+		mock_test_wakeup();
+	else
+		fail_msg("unknown test \"%s\"", test);
+
+	mock_check_diag();
+
+	pp_task_queue_destroy(&queue);
+
+	zbx_vector_uint64_destroy(&items_busy);
+	zbx_vector_mock_task_record_destroy(&records);
+}
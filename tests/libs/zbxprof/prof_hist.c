@@ -0,0 +1,94 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "../../../src/libs/zbxprof/prof.c"
+
+static void	mock_test_bucket(void)
+{
+	zbx_prof_hist_t	hist;
+	zbx_uint64_t	usec;
+	int		bucket;
+
+	usec = zbx_mock_get_parameter_uint64("in.usec");
+	bucket = prof_hist_get_bucket(usec);
+
+	zbx_mock_assert_int_eq("bucket", (int)zbx_mock_get_parameter_uint64("out.bucket"), bucket);
+
+	/* the last bucket holds all longer durations */
+	if ((int)ARRSIZE(hist.buckets) - 1 != bucket && usec >= prof_hist_get_bound(bucket))
+		fail_msg("duration " ZBX_FS_UI64 " is not below bucket %d bound", usec, bucket);
+
+	if (0 != bucket && usec < prof_hist_get_bound(bucket - 1))
+		fail_msg("duration " ZBX_FS_UI64 " is below previous bucket %d bound", usec, bucket - 1);
+}
+
+static void	mock_test_bound(void)
+{
+	int	bucket;
+
+	bucket = (int)zbx_mock_get_parameter_uint64("in.bucket");
+
+	zbx_mock_assert_uint64_eq("bound", zbx_mock_get_parameter_uint64("out.bound"), prof_hist_get_bound(bucket));
+}
+
+static void	mock_test_percentile(void)
+{
+	zbx_prof_hist_t		hist;
+	zbx_mock_handle_t	hvalues, hvalue;
+
+	memset(&hist, 0, sizeof(hist));
+
+	hvalues = zbx_mock_get_parameter_handle("in.values");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hvalues, &hvalue))
+	{
+		zbx_uint64_t	usec, count;
+
+		usec = zbx_mock_get_object_member_uint64(hvalue, "usec");
+		count = zbx_mock_get_object_member_uint64(hvalue, "count");
+
+		/* durations are added in microseconds to avoid rounding of seconds in prof_hist_add() */
+		hist.count += count;
+		hist.buckets[prof_hist_get_bucket(usec)] += count;
+
+		if (hist.max < usec)
+			hist.max = usec;
+	}
+
+	zbx_mock_assert_uint64_eq("percentile", zbx_mock_get_parameter_uint64("out.usec"),
+			prof_hist_get_percentile(&hist, (int)zbx_mock_get_parameter_uint64("in.percent")));
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	const char	*function;
+
+	ZBX_UNUSED(state);
+
+	function = zbx_mock_get_parameter_string("in.function");
+
+	if (0 == strcmp(function, "bucket"))
+		mock_test_bucket();
+	else if (0 == strcmp(function, "bound"))
+		mock_test_bound();
+	else if (0 == strcmp(function, "percentile"))
+		mock_test_percentile();
+	else
+		fail_msg("unknown function \"%s\"", function);
+}
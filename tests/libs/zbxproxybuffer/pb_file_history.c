@@ -0,0 +1,318 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+#include "zbxmockdb.h"
+
+#include "zbxproxybuffer.h"
+#include "zbxcacheconfig.h"
+#include "zbxcachehistory.h"
+#include "zbxmutexs.h"
+#include "zbxjson.h"
+#include "zbxstr.h"
+#include "zbx_item_constants.h"
+#include "zbx_host_constants.h"
+#include "../../../src/libs/zbxproxybuffer/proxybuffer.h"
+
+#define PB_TEST_OFFLINE_BUFFER	SEC_PER_HOUR
+
+static char	*pb_dir;
+
+/* configuration cache is not used by this test, all items are monitored */
+void	zbx_dc_config_get_items_by_itemids(zbx_dc_item_t *items, const zbx_uint64_t *itemids, int *errcodes,
+		size_t num)
+{
+	for (size_t i = 0; i < num; i++)
+	{
+		memset(&items[i], 0, sizeof(zbx_dc_item_t));
+		items[i].itemid = itemids[i];
+		items[i].status = ITEM_STATUS_ACTIVE;
+		items[i].host.status = HOST_STATUS_MONITORED;
+		errcodes[i] = SUCCEED;
+	}
+}
+
+void	zbx_dc_config_clean_items(zbx_dc_item_t *items, int *errcodes, size_t num)
+{
+	ZBX_UNUSED(items);
+	ZBX_UNUSED(errcodes);
+	ZBX_UNUSED(num);
+}
+
+zbx_uint64_t	zbx_dc_get_nextid(const char *table_name, int num)
+{
+	static zbx_uint64_t	nextid = 1;
+	zbx_uint64_t		id = nextid;
+
+	ZBX_UNUSED(table_name);
+
+	nextid += (zbx_uint64_t)num;
+
+	return id;
+}
+
+static void	pb_test_start(void)
+{
+	char	*error = NULL;
+
+	if (SUCCEED != zbx_pb_create(ZBX_PB_MODE_FILE, 0, 0, PB_TEST_OFFLINE_BUFFER, pb_dir, &error))
+		fail_msg("cannot create proxy buffer: %s", error);
+
+	zbx_pb_init();
+}
+
+static char	*pb_test_path(const char *name)
+{
+	return zbx_dsprintf(NULL, "%s/%s", pb_dir, name);
+}
+
+static void	pb_test_write(zbx_mock_handle_t hstep)
+{
+	zbx_mock_handle_t	hvalues, hvalue;
+	zbx_pb_history_data_t	*data;
+
+	hvalues = zbx_mock_get_object_member_handle(hstep, "values");
+	data = zbx_pb_history_open();
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hvalues, &hvalue))
+	{
+		zbx_timespec_t	ts;
+
+		ts.sec = zbx_mock_get_object_member_int(hvalue, "clock");
+		ts.ns = 0;
+
+		zbx_pb_history_write_value(data, zbx_mock_get_object_member_uint64(hvalue, "itemid"),
+				ITEM_STATE_NORMAL, zbx_mock_get_object_member_string(hvalue, "value"), &ts, 0,
+				(time_t)ts.sec);
+	}
+
+	zbx_pb_history_close(data);
+}
+
+static void	pb_test_read(zbx_mock_handle_t hstep)
+{
+	zbx_mock_handle_t	hvalues, hvalue;
+	struct zbx_json		j;
+	struct zbx_json_parse	jp, jp_data, jp_row;
+	zbx_uint64_t		lastid = 0;
+	int			more, records_num;
+	const char		*p = NULL;
+	char			value[MAX_STRING_LEN];
+
+	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
+	records_num = zbx_pb_history_get_rows(&j, &lastid, &more);
+	zbx_json_close(&j);
+
+	hvalues = zbx_mock_get_object_member_handle(hstep, "values");
+
+	if (0 != records_num)
+	{
+		if (SUCCEED != zbx_json_open(j.buffer, &jp) ||
+				SUCCEED != zbx_json_brackets_by_name(&jp, ZBX_PROTO_TAG_HISTORY_DATA, &jp_data))
+		{
+			fail_msg("cannot parse history data: %s", j.buffer);
+		}
+	}
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hvalues, &hvalue))
+	{
+		const char	*expected;
+
+		if (ZBX_MOCK_SUCCESS != zbx_mock_string(hvalue, &expected))
+			fail_msg("invalid expected value");
+
+		if (0 == records_num || NULL == (p = zbx_json_next(&jp_data, p)))
+			fail_msg("missing history record with value \"%s\"", expected);
+
+		if (SUCCEED != zbx_json_brackets_open(p, &jp_row) ||
+				SUCCEED != zbx_json_value_by_name(&jp_row, ZBX_PROTO_TAG_VALUE, value, sizeof(value),
+				NULL))
+		{
+			fail_msg("cannot parse history record");
+		}
+
+		zbx_mock_assert_str_eq("history value", expected, value);
+	}
+
+	if (0 != records_num && NULL != zbx_json_next(&jp_data, p))
+		fail_msg("unexpected history records: %s", j.buffer);
+
+	if (0 == strcmp(zbx_mock_get_object_member_string(hstep, "ack"), "yes") && 0 != records_num)
+		zbx_pb_set_history_lastid(lastid);
+
+	zbx_json_free(&j);
+}
+
+static void	pb_test_append(zbx_mock_handle_t hstep)
+{
+	zbx_vector_str_t	names;
+	DIR			*dir;
+	struct dirent		*entry;
+	char			*path;
+	const char		*data;
+	int			fd;
+
+	zbx_vector_str_create(&names);
+
+	if (NULL == (dir = opendir(pb_dir)))
+		fail_msg("cannot open directory \"%s\": %s", pb_dir, zbx_strerror(errno));
+
+	while (NULL != (entry = readdir(dir)))
+	{
+		if (0 == strncmp(entry->d_name, "history-", ZBX_CONST_STRLEN("history-")))
+			zbx_vector_str_append(&names, zbx_strdup(NULL, entry->d_name));
+	}
+
+	closedir(dir);
+
+	if (0 == names.values_num)
+		fail_msg("no segment files found");
+
+	zbx_vector_str_sort(&names, ZBX_DEFAULT_STR_COMPARE_FUNC);
+
+	/* simulate partially written record at the end of the active segment */
+	path = pb_test_path(names.values[names.values_num - 1]);
+	data = zbx_mock_get_object_member_string(hstep, "data");
+
+	if (-1 == (fd = open(path, O_WRONLY | O_APPEND)))
+		fail_msg("cannot open \"%s\": %s", path, zbx_strerror(errno));
+
+	if ((ssize_t)strlen(data) != write(fd, data, strlen(data)))
+		fail_msg("cannot write \"%s\": %s", path, zbx_strerror(errno));
+
+	close(fd);
+	zbx_free(path);
+
+	zbx_vector_str_clear_ext(&names, zbx_str_free);
+	zbx_vector_str_destroy(&names);
+}
+
+static void	pb_test_remove_dir(const char *path)
+{
+	DIR		*dir;
+	struct dirent	*entry;
+
+	if (NULL == (dir = opendir(path)))
+		return;
+
+	while (NULL != (entry = readdir(dir)))
+	{
+		char	*name;
+
+		if (0 == strcmp(entry->d_name, ".") || 0 == strcmp(entry->d_name, ".."))
+			continue;
+
+		name = zbx_dsprintf(NULL, "%s/%s", path, entry->d_name);
+
+		if (0 != unlink(name))
+			pb_test_remove_dir(name);
+
+		zbx_free(name);
+	}
+
+	closedir(dir);
+	(void)rmdir(path);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t	hsteps, hstep, hdirs, hdir;
+	char			*error = NULL, tmpl[] = "/tmp/zbx_pb_file_XXXXXX";
+	const char		*name;
+
+	ZBX_UNUSED(state);
+
+	if (NULL == (pb_dir = mkdtemp(tmpl)))
+		fail_msg("cannot create temporary directory: %s", zbx_strerror(errno));
+
+	zbx_set_mock_real_path(pb_dir);
+	zbx_mockdb_init();
+
+	if (SUCCEED != zbx_locks_create(&error))
+		fail_msg("cannot create locks: %s", error);
+
+	/* directories named as segment files make segment creation fail */
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter("in.dirs", &hdirs))
+	{
+		while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hdirs, &hdir))
+		{
+			char	*path;
+
+			if (ZBX_MOCK_SUCCESS != zbx_mock_string(hdir, &name))
+				fail_msg("invalid directory name");
+
+			path = pb_test_path(name);
+
+			if (0 != mkdir(path, 0700))
+				fail_msg("cannot create directory \"%s\": %s", path, zbx_strerror(errno));
+
+			zbx_free(path);
+		}
+	}
+
+	pb_test_start();
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hsteps, &hstep))
+	{
+		const char	*op = zbx_mock_get_object_member_string(hstep, "op");
+
+		if (0 == strcmp(op, "write"))
+		{
+			pb_test_write(hstep);
+		}
+		else if (0 == strcmp(op, "read"))
+		{
+			pb_test_read(hstep);
+		}
+		else if (0 == strcmp(op, "restart"))
+		{
+			zbx_pb_destroy();
+			pb_test_start();
+		}
+		else if (0 == strcmp(op, "append"))
+		{
+			pb_test_append(hstep);
+		}
+		else if (0 == strcmp(op, "rmdir"))
+		{
+			char	*path;
+
+			path = pb_test_path(zbx_mock_get_object_member_string(hstep, "name"));
+
+			if (0 != rmdir(path))
+				fail_msg("cannot remove directory \"%s\": %s", path, zbx_strerror(errno));
+
+			zbx_free(path);
+		}
+		else if (0 == strcmp(op, "pending"))
+		{
+			zbx_mock_assert_int_eq("database records pending migration",
+					zbx_mock_get_object_member_int(hstep, "value"), get_pb_data()->file_db_pending);
+		}
+		else
+			fail_msg("unknown step \"%s\"", op);
+	}
+
+	zbx_pb_destroy();
+	zbx_locks_destroy();
+	zbx_mockdb_destroy();
+
+	pb_test_remove_dir(pb_dir);
+	zbx_set_mock_real_path(NULL);
+}
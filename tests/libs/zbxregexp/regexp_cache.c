@@ -0,0 +1,107 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxregexp.h"
+
+static void	regexp_cache_match(const char *pattern, const char *string, int expected, const char *api)
+{
+	int			result;
+	zbx_regexp_t		*regexp = NULL;
+	const zbx_regexp_t	*cached;
+	char			*error = NULL;
+
+	/* cached regexp */
+	if (0 == strcmp(api, "match"))
+	{
+		result = NULL != zbx_regexp_match(string, pattern, NULL) ? ZBX_REGEXP_MATCH : ZBX_REGEXP_NO_MATCH;
+	}
+	else if (0 == strcmp(api, "compile"))
+	{
+		if (SUCCEED != zbx_regexp_compile_cached(pattern, &cached, &error))
+			fail_msg("cannot compile cached regexp \"%s\": %s", pattern, error);
+
+		result = 0 == zbx_regexp_match_precompiled(string, cached) ? ZBX_REGEXP_MATCH : ZBX_REGEXP_NO_MATCH;
+	}
+	else
+		fail_msg("unknown api \"%s\"", api);
+
+	zbx_mock_assert_int_eq(pattern, expected, result);
+
+	/* uncached regexp must give the same result and must not affect cache */
+	if (SUCCEED != zbx_regexp_compile(pattern, &regexp, &error))
+		fail_msg("cannot compile regexp \"%s\": %s", pattern, error);
+
+	result = 0 == zbx_regexp_match_precompiled(string, regexp) ? ZBX_REGEXP_MATCH : ZBX_REGEXP_NO_MATCH;
+	zbx_mock_assert_int_eq(pattern, expected, result);
+
+	zbx_regexp_free(regexp);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t		hmatches, hmatch;
+	zbx_regexp_cache_stats_t	stats;
+
+	ZBX_UNUSED(state);
+
+	zbx_regexp_cache_clear();
+
+	/* distinct patterns to fill the cache */
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.generate"))
+	{
+		zbx_uint64_t	num = zbx_mock_get_parameter_uint64("in.generate");
+
+		for (zbx_uint64_t i = 0; i < num; i++)
+		{
+			char	pattern[32], string[32];
+
+			zbx_snprintf(pattern, sizeof(pattern), "^p" ZBX_FS_UI64 "$", i);
+			zbx_snprintf(string, sizeof(string), "p" ZBX_FS_UI64, i);
+
+			regexp_cache_match(pattern, string, ZBX_REGEXP_MATCH, "match");
+		}
+	}
+
+	hmatches = zbx_mock_get_parameter_handle("in.matches");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hmatches, &hmatch))
+	{
+		const char		*match = zbx_mock_get_object_member_string(hmatch, "match"), *api = "match";
+		zbx_mock_handle_t	hapi;
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hmatch, "api", &hapi) &&
+				ZBX_MOCK_SUCCESS != zbx_mock_string(hapi, &api))
+		{
+			fail_msg("invalid api");
+		}
+
+		regexp_cache_match(zbx_mock_get_object_member_string(hmatch, "pattern"),
+				zbx_mock_get_object_member_string(hmatch, "string"),
+				0 == strcmp(match, "yes") ? ZBX_REGEXP_MATCH : ZBX_REGEXP_NO_MATCH, api);
+	}
+
+	zbx_regexp_cache_get_stats(&stats);
+
+	zbx_mock_assert_uint64_eq("hits", zbx_mock_get_parameter_uint64("out.hits"), stats.hits);
+	zbx_mock_assert_uint64_eq("misses", zbx_mock_get_parameter_uint64("out.misses"), stats.misses);
+	zbx_mock_assert_uint64_eq("evictions", zbx_mock_get_parameter_uint64("out.evictions"), stats.evictions);
+	zbx_mock_assert_uint64_eq("items", zbx_mock_get_parameter_uint64("out.items"), stats.items_num);
+
+	zbx_regexp_cache_clear();
+}
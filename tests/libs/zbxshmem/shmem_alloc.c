@@ -0,0 +1,230 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxshmem.h"
+
+typedef struct
+{
+	unsigned char	*ptr;
+	size_t		size;
+	unsigned char	fill;
+}
+shmem_slot_t;
+
+static zbx_uint64_t	rnd_state;
+
+static zbx_uint64_t	rnd_next(void)
+{
+	/* xorshift64, deterministic sequence for the same seed */
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 7;
+	rnd_state ^= rnd_state << 17;
+
+	return rnd_state;
+}
+
+static void	slot_fill(shmem_slot_t *slot)
+{
+	slot->fill = (unsigned char)rnd_next();
+	memset(slot->ptr, slot->fill, slot->size);
+}
+
+static void	slot_check(const shmem_slot_t *slot, size_t size)
+{
+	for (size_t i = 0; i < size; i++)
+	{
+		if (slot->ptr[i] != slot->fill)
+			fail_msg("object of " ZBX_FS_SIZE_T " bytes corrupted at offset " ZBX_FS_SIZE_T,
+					(zbx_fs_size_t)slot->size, (zbx_fs_size_t)i);
+	}
+}
+
+static void	shmem_check_slabs(zbx_shmem_info_t *shmem, const shmem_slot_t *slots, int slots_num)
+{
+	zbx_shmem_stats_t	stats;
+	unsigned int		small_num = 0, used_objects = 0;
+
+	zbx_shmem_get_stats(shmem, &stats);
+
+	if (0 == stats.slabs_enabled)
+		return;
+
+	for (int i = 0; i < slots_num; i++)
+	{
+		if (NULL != slots[i].ptr && ZBX_SHMEM_SLAB_MAX_OBJECT >= slots[i].size)
+			small_num++;
+	}
+
+	for (int i = 0; i < ZBX_SHMEM_SLAB_CLASS_COUNT; i++)
+		used_objects += stats.slab_classes[i].used_objects;
+
+	/* small objects reallocated from heap stay in heap, so slabs can hold fewer objects */
+	if (used_objects > small_num)
+		fail_msg("slabs hold %u objects while only %u small objects are allocated", used_objects, small_num);
+}
+
+/* random allocations, reallocations and frees, checking that objects are not corrupted */
+static void	shmem_test_random(zbx_shmem_info_t *shmem)
+{
+	int			slots_num, ops_num;
+	size_t			max_size;
+	shmem_slot_t		*slots;
+	zbx_shmem_stats_t	stats;
+	zbx_uint64_t		used_size;
+
+	slots_num = (int)zbx_mock_get_parameter_uint64("in.slots");
+	ops_num = (int)zbx_mock_get_parameter_uint64("in.ops");
+	max_size = (size_t)zbx_mock_get_parameter_uint64("in.max_size");
+
+	slots = (shmem_slot_t *)zbx_calloc(NULL, (size_t)slots_num, sizeof(shmem_slot_t));
+
+	zbx_shmem_get_stats(shmem, &stats);
+	used_size = stats.used_size;
+
+	for (int i = 0; i < ops_num; i++)
+	{
+		shmem_slot_t	*slot = &slots[rnd_next() % (zbx_uint64_t)slots_num];
+		size_t		size = 1 + rnd_next() % max_size;
+
+		if (NULL == slot->ptr)
+		{
+			if (NULL == (slot->ptr = (unsigned char *)zbx_shmem_malloc(shmem, NULL, size)))
+				fail_msg("cannot allocate " ZBX_FS_SIZE_T " bytes", (zbx_fs_size_t)size);
+
+			slot->size = size;
+			slot_fill(slot);
+		}
+		else if (0 == rnd_next() % 2)
+		{
+			slot_check(slot, slot->size);
+			zbx_shmem_free(shmem, slot->ptr);
+		}
+		else
+		{
+			slot_check(slot, slot->size);
+
+			if (NULL == (slot->ptr = (unsigned char *)zbx_shmem_realloc(shmem, slot->ptr, size)))
+				fail_msg("cannot reallocate " ZBX_FS_SIZE_T " bytes", (zbx_fs_size_t)size);
+
+			slot_check(slot, MIN(size, slot->size));
+			slot->size = size;
+			slot_fill(slot);
+		}
+
+		if (0 == i % 1000)
+			shmem_check_slabs(shmem, slots, slots_num);
+	}
+
+	for (int i = 0; i < slots_num; i++)
+	{
+		if (NULL == slots[i].ptr)
+			continue;
+
+		slot_check(&slots[i], slots[i].size);
+		zbx_shmem_free(shmem, slots[i].ptr);
+	}
+
+	zbx_shmem_get_stats(shmem, &stats);
+
+	if (0 != stats.slabs_enabled)
+	{
+		/* at most one empty slab per size class is kept */
+		for (int i = 0; i < ZBX_SHMEM_SLAB_CLASS_COUNT; i++)
+		{
+			zbx_mock_assert_uint64_eq("used slab objects", 0, stats.slab_classes[i].used_objects);
+
+			if (1 < stats.slab_classes[i].slabs_num)
+				fail_msg("%u empty slabs kept in size class %d", stats.slab_classes[i].slabs_num, i);
+		}
+
+		/* the kept slabs are used heap memory, their free objects are accounted as free memory */
+		zbx_mock_assert_uint64_eq("used size", used_size + stats.slab_size - stats.slab_free_size,
+				stats.used_size);
+	}
+	else
+	{
+		zbx_mock_assert_uint64_eq("used size", used_size, stats.used_size);
+		zbx_mock_assert_int_eq("free chunks", 1, (int)stats.free_chunks);
+	}
+
+	zbx_free(slots);
+}
+
+/* exhausts memory with small objects and checks that freed slabs are reused for large allocations */
+static void	shmem_test_oom(zbx_shmem_info_t *shmem)
+{
+	zbx_vector_ptr_t	objects;
+	size_t			small_size, large_size;
+	void			*ptr;
+
+	small_size = (size_t)zbx_mock_get_parameter_uint64("in.small_size");
+	large_size = (size_t)zbx_mock_get_parameter_uint64("in.large_size");
+
+	zbx_vector_ptr_create(&objects);
+
+	while (NULL != (ptr = zbx_shmem_malloc(shmem, NULL, small_size)))
+		zbx_vector_ptr_append(&objects, ptr);
+
+	if (0 == objects.values_num)
+		fail_msg("cannot allocate any object");
+
+	for (int i = 0; i < objects.values_num; i++)
+		zbx_shmem_free(shmem, objects.values[i]);
+
+	zbx_vector_ptr_clear(&objects);
+
+	/* all memory must be available again for large objects */
+	while (NULL != (ptr = zbx_shmem_malloc(shmem, NULL, large_size)))
+		zbx_vector_ptr_append(&objects, ptr);
+
+	zbx_mock_assert_int_eq("large objects", (int)zbx_mock_get_parameter_uint64("out.large_objects"),
+			objects.values_num);
+
+	for (int i = 0; i < objects.values_num; i++)
+		zbx_shmem_free(shmem, objects.values[i]);
+
+	zbx_vector_ptr_destroy(&objects);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_shmem_info_t	*shmem;
+	char			*error = NULL;
+	const char		*scenario;
+
+	ZBX_UNUSED(state);
+
+	if (SUCCEED != zbx_shmem_create(&shmem, zbx_mock_get_parameter_uint64("in.size"), "test", "test", 1, &error))
+		fail_msg("cannot create shared memory: %s", error);
+
+	if (0 == strcmp(zbx_mock_get_parameter_string("in.slabs"), "yes"))
+		zbx_shmem_enable_slabs(shmem);
+
+	rnd_state = zbx_mock_get_parameter_uint64("in.seed");
+	scenario = zbx_mock_get_parameter_string("in.scenario");
+
+	if (0 == strcmp(scenario, "random"))
+		shmem_test_random(shmem);
+	else if (0 == strcmp(scenario, "oom"))
+		shmem_test_oom(shmem);
+	else
+		fail_msg("unknown scenario \"%s\"", scenario);
+
+	zbx_shmem_destroy(shmem);
+}
@@ -0,0 +1,79 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "../../../src/libs/zbxsnmptrapper/snmptrap_matcher.c"
+
+/* Item key with expanded macros is compiled and the compiled item is matched against the traps in in.traps. */
+
+static unsigned char	mock_str_to_item_type(const char *str)
+{
+	if (0 == strcmp(str, "skip"))
+		return SNMPTRAP_ITEM_SKIP;
+
+	if (0 == strcmp(str, "match"))
+		return SNMPTRAP_ITEM_MATCH;
+
+	if (0 == strcmp(str, "fallback"))
+		return SNMPTRAP_ITEM_FALLBACK;
+
+	if (0 == strcmp(str, "error"))
+		return SNMPTRAP_ITEM_ERROR;
+
+	fail_msg("unknown item type \"%s\"", str);
+
+	return SNMPTRAP_ITEM_SKIP;
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_snmptrap_item_t	trap_item = {0};
+	zbx_mock_handle_t	htraps, htrap;
+
+	ZBX_UNUSED(state);
+
+	zbx_vector_expression_create(&trap_item.regexps);
+
+	snmptrap_item_parse(&trap_item, zbx_mock_get_parameter_string("in.key"));
+
+	zbx_mock_assert_int_eq("item type", mock_str_to_item_type(zbx_mock_get_parameter_string("out.type")),
+			trap_item.type);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("out.error"))
+		zbx_mock_assert_str_eq("error", zbx_mock_get_parameter_string("out.error"), trap_item.error);
+	else
+		zbx_mock_assert_ptr_eq("error", NULL, trap_item.error);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.traps"))
+	{
+		htraps = zbx_mock_get_parameter_handle("in.traps");
+
+		while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(htraps, &htrap))
+		{
+			const char	*trap = zbx_mock_get_object_member_string(htrap, "trap");
+			int		expected;
+
+			expected = (0 == strcmp(zbx_mock_get_object_member_string(htrap, "match"), "yes") ?
+					ZBX_REGEXP_MATCH : ZBX_REGEXP_NO_MATCH);
+
+			zbx_mock_assert_int_eq(trap, expected, snmptrap_item_match(&trap_item, trap));
+		}
+	}
+
+	snmptrap_item_clear(&trap_item);
+}
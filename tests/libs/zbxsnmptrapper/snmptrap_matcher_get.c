@@ -0,0 +1,85 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "../../../src/libs/zbxsnmptrapper/snmptrap_matcher.c"
+
+/* Steps get interface matchers at the specified revisions, add compiled items to the last returned matcher */
+/* and remove unused matchers. Compiled items are expected to be kept only while the revision is the same.  */
+
+static void	mock_step_add(zbx_mock_handle_t hstep, zbx_snmptrap_matcher_t *matcher)
+{
+	zbx_snmptrap_item_t	*trap_item, trap_item_local = {0};
+
+	if (NULL == matcher)
+		fail_msg("item is added before matcher was returned");
+
+	trap_item_local.itemid = zbx_mock_get_object_member_uint64(hstep, "itemid");
+
+	trap_item = (zbx_snmptrap_item_t *)zbx_hashset_insert(&matcher->items, &trap_item_local,
+			sizeof(trap_item_local));
+	zbx_vector_expression_create(&trap_item->regexps);
+
+	snmptrap_item_parse(trap_item, zbx_mock_get_object_member_string(hstep, "key"));
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t	hsteps, hstep;
+	zbx_snmptrap_matcher_t	*matcher = NULL;
+
+	ZBX_UNUSED(state);
+
+	snmptrap_matchers_init();
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hsteps, &hstep))
+	{
+		const char	*op = zbx_mock_get_object_member_string(hstep, "op");
+
+		if (0 == strcmp(op, "get"))
+		{
+			matcher = snmptrap_matcher_get(zbx_mock_get_object_member_uint64(hstep, "interfaceid"),
+					zbx_mock_get_object_member_uint64(hstep, "revision"),
+					(time_t)zbx_mock_get_object_member_int(hstep, "now"));
+
+			zbx_mock_assert_int_eq("compiled items", zbx_mock_get_object_member_int(hstep, "items"),
+					matcher->items.num_data);
+		}
+		else if (0 == strcmp(op, "add"))
+		{
+			mock_step_add(hstep, matcher);
+		}
+		else if (0 == strcmp(op, "clean"))
+		{
+			snmptrap_matchers_clean((time_t)zbx_mock_get_object_member_int(hstep, "now"),
+					zbx_mock_get_object_member_int(hstep, "ttl"));
+
+			zbx_mock_assert_int_eq("matchers", zbx_mock_get_object_member_int(hstep, "matchers"),
+					matchers.num_data);
+
+			/* the returned matcher might have been removed */
+			matcher = NULL;
+		}
+		else
+			fail_msg("unknown operation \"%s\"", op);
+	}
+
+	snmptrap_matchers_destroy();
+}
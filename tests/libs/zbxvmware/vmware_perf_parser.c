@@ -0,0 +1,250 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "../../../src/libs/zbxvmware/vmware_perfcntr.c"
+
+#if defined(HAVE_LIBXML2) && defined(HAVE_LIBCURL)
+/* QueryPerf response fixture is parsed with the streaming parser fed by chunks of different sizes and the */
+/* result is compared with the response parsed from document tree with xpath, as it was done before.     */
+
+static int	mock_dom_parse_entity(zbx_vmware_perf_data_t *perfdata, xmlDoc *xdoc, xmlNode *node)
+{
+	xmlXPathContext	*xpathCtx;
+	xmlXPathObject	*xpathObj;
+	xmlNodeSetPtr	nodeset;
+	int		ret = FAIL;
+
+	xpathCtx = xmlXPathNewContext(xdoc);
+	xpathCtx->node = node;
+
+	if (NULL == (xpathObj = xmlXPathEvalExpression((const xmlChar *)"*[local-name()='value']", xpathCtx)))
+		goto out;
+
+	if (0 != xmlXPathNodeSetIsEmpty(xpathObj->nodesetval))
+		goto out;
+
+	nodeset = xpathObj->nodesetval;
+
+	for (int i = 0; i < nodeset->nodeNr; i++)
+	{
+		zbx_vmware_perf_value_t	*perfvalue;
+		char			*instance, *counter, *value;
+
+		if (NULL == (value = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i],
+				"*[local-name()='value'][text() != '-1'][last()]")))
+		{
+			value = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i], "*[local-name()='value'][last()]");
+		}
+
+		instance = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i], "*[local-name()='id']"
+				"/*[local-name()='instance']");
+		counter = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i], "*[local-name()='id']"
+				"/*[local-name()='counterId']");
+
+		if (NULL != value && NULL != counter)
+		{
+			perfvalue = (zbx_vmware_perf_value_t *)zbx_malloc(NULL, sizeof(zbx_vmware_perf_value_t));
+
+			ZBX_STR2UINT64(perfvalue->counterid, counter);
+			perfvalue->instance = (NULL != instance ? instance : zbx_strdup(NULL, ""));
+
+			if (0 == strcmp(value, "-1") || SUCCEED != zbx_is_uint64(value, &perfvalue->value))
+				perfvalue->value = ZBX_MAX_UINT64;
+			else
+				ret = SUCCEED;
+
+			zbx_vector_vmware_perf_value_ptr_append(&perfdata->values, perfvalue);
+			instance = NULL;
+		}
+
+		zbx_free(counter);
+		zbx_free(instance);
+		zbx_free(value);
+	}
+out:
+	xmlXPathFreeObject(xpathObj);
+	xmlXPathFreeContext(xpathCtx);
+
+	return ret;
+}
+
+static void	mock_dom_parse(const char *xml, zbx_vector_vmware_perf_data_ptr_t *perfdata)
+{
+	xmlDoc		*xdoc;
+	xmlXPathContext	*xpathCtx;
+	xmlXPathObject	*xpathObj;
+	xmlNodeSetPtr	nodeset;
+
+	if (NULL == (xdoc = xmlReadMemory(xml, (int)strlen(xml), "noname.xml", NULL, 0)))
+		fail_msg("cannot parse fixture");
+
+	xpathCtx = xmlXPathNewContext(xdoc);
+
+	if (NULL == (xpathObj = xmlXPathEvalExpression((const xmlChar *)"/*/*/*/*", xpathCtx)))
+		goto out;
+
+	if (0 != xmlXPathNodeSetIsEmpty(xpathObj->nodesetval))
+		goto out;
+
+	nodeset = xpathObj->nodesetval;
+
+	for (int i = 0; i < nodeset->nodeNr; i++)
+	{
+		zbx_vmware_perf_data_t	*data;
+		int			ret = FAIL;
+
+		data = (zbx_vmware_perf_data_t *)zbx_malloc(NULL, sizeof(zbx_vmware_perf_data_t));
+
+		data->id = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i], "*[local-name()='entity']");
+		data->type = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i], "*[local-name()='entity']/@type");
+		data->error = NULL;
+		zbx_vector_vmware_perf_value_ptr_create(&data->values);
+
+		if (NULL != data->type && NULL != data->id)
+			ret = mock_dom_parse_entity(data, xdoc, nodeset->nodeTab[i]);
+
+		if (SUCCEED == ret)
+			zbx_vector_vmware_perf_data_ptr_append(perfdata, data);
+		else
+			vmware_free_perfdata(data);
+	}
+out:
+	xmlXPathFreeObject(xpathObj);
+	xmlXPathFreeContext(xpathCtx);
+	xmlFreeDoc(xdoc);
+}
+
+static int	mock_sax_parse(const char *xml, size_t chunk, zbx_vector_vmware_perf_data_ptr_t *perfdata,
+		char **error)
+{
+	zbx_vmware_perf_parser_t	parser;
+	size_t				len, offset;
+	int				ret;
+
+	if (SUCCEED != vmware_perf_parser_init(&parser))
+		fail_msg("cannot create parser");
+
+	len = strlen(xml);
+
+	for (offset = 0; offset < len; offset += chunk)
+	{
+		xmlParseChunk(parser.ctxt, xml + offset, (int)MIN(chunk, len - offset), 0);
+
+		if (NULL != parser.error || 0 == parser.ctxt->wellFormed)
+			break;
+	}
+
+	if (SUCCEED == (ret = vmware_perf_parser_finish(&parser, error)))
+	{
+		zbx_vector_vmware_perf_data_ptr_append_array(perfdata, parser.perfdata.values,
+				parser.perfdata.values_num);
+		zbx_vector_vmware_perf_data_ptr_clear(&parser.perfdata);
+	}
+
+	vmware_perf_parser_clean(&parser);
+
+	return ret;
+}
+
+static void	mock_perfdata_compare(const zbx_vector_vmware_perf_data_ptr_t *expected,
+		const zbx_vector_vmware_perf_data_ptr_t *returned)
+{
+	zbx_mock_assert_int_eq("number of entities", expected->values_num, returned->values_num);
+
+	for (int i = 0; i < expected->values_num; i++)
+	{
+		const zbx_vmware_perf_data_t	*e = expected->values[i], *r = returned->values[i];
+
+		zbx_mock_assert_str_eq("entity type", e->type, r->type);
+		zbx_mock_assert_str_eq("entity id", e->id, r->id);
+		zbx_mock_assert_int_eq("number of values", e->values.values_num, r->values.values_num);
+
+		for (int j = 0; j < e->values.values_num; j++)
+		{
+			zbx_mock_assert_uint64_eq("counter id", e->values.values[j]->counterid,
+					r->values.values[j]->counterid);
+			zbx_mock_assert_str_eq("instance", e->values.values[j]->instance,
+					r->values.values[j]->instance);
+			zbx_mock_assert_uint64_eq("value", e->values.values[j]->value, r->values.values[j]->value);
+		}
+	}
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	const char				*xml;
+	zbx_vector_vmware_perf_data_ptr_t	expected;
+	zbx_mock_handle_t			hchunks, hchunk;
+	int					expected_ret;
+
+	ZBX_UNUSED(state);
+
+	xml = zbx_mock_get_parameter_string("in.xml");
+	expected_ret = zbx_mock_str_to_return_code(zbx_mock_get_parameter_string("out.result"));
+
+	zbx_vector_vmware_perf_data_ptr_create(&expected);
+
+	if (SUCCEED == expected_ret)
+	{
+		mock_dom_parse(xml, &expected);
+		zbx_mock_assert_int_eq("number of entities parsed from document tree",
+				(int)zbx_mock_get_parameter_uint64("out.entities"), expected.values_num);
+	}
+
+	hchunks = zbx_mock_get_parameter_handle("in.chunks");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hchunks, &hchunk))
+	{
+		zbx_vector_vmware_perf_data_ptr_t	returned;
+		zbx_uint64_t				chunk;
+		char					*error = NULL;
+		const char				*expected_error;
+		int					ret;
+
+		if (ZBX_MOCK_SUCCESS != zbx_mock_uint64(hchunk, &chunk) || 0 == chunk)
+			fail_msg("invalid chunk size");
+
+		zbx_vector_vmware_perf_data_ptr_create(&returned);
+
+		ret = mock_sax_parse(xml, (size_t)chunk, &returned, &error);
+		zbx_mock_assert_result_eq("parse result", expected_ret, ret);
+
+		if (SUCCEED == ret)
+			mock_perfdata_compare(&expected, &returned);
+		else if (NULL != (expected_error = zbx_mock_get_optional_parameter_string("out.error")))
+			zbx_mock_assert_str_eq("error", expected_error, error);
+		else if (NULL == error)
+			fail_msg("expected error message");
+
+		zbx_free(error);
+		zbx_vector_vmware_perf_data_ptr_clear_ext(&returned, vmware_free_perfdata);
+		zbx_vector_vmware_perf_data_ptr_destroy(&returned);
+	}
+
+	zbx_vector_vmware_perf_data_ptr_clear_ext(&expected, vmware_free_perfdata);
+	zbx_vector_vmware_perf_data_ptr_destroy(&expected);
+}
+#else
+void	zbx_mock_test_entry(void **state)
+{
+	ZBX_UNUSED(state);
+
+	skip();
+}
+#endif
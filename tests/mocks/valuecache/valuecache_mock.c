@@ -47,6 +47,7 @@ void	*__wrap___zbx_shmem_malloc(const char *file, int line, zbx_shmem_info_t *in
 void	*__wrap___zbx_shmem_realloc(const char *file, int line, zbx_shmem_info_t *info, void *old, size_t size);
 void	__wrap___zbx_shmem_free(const char *file, int line, zbx_shmem_info_t *info, void *ptr);
 void	__wrap_zbx_shmem_dump_stats(int level, zbx_shmem_info_t *info);
+void	__wrap_zbx_shmem_enable_slabs(zbx_shmem_info_t *info);
 int	__wrap_zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start, int count, int end,
 		zbx_vector_history_record_t *values);
 int	__wrap_zbx_history_add_values(const zbx_vector_ptr_t *history);
@@ -580,6 +581,11 @@ void	__wrap_zbx_shmem_dump_stats(int level, zbx_shmem_info_t *info)
 	ZBX_UNUSED(info);
 }
 
+void	__wrap_zbx_shmem_enable_slabs(zbx_shmem_info_t *info)
+{
+	ZBX_UNUSED(info);
+}
+
 int	__wrap_zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start, int count, int end,
 		zbx_vector_history_record_t *values)
 {
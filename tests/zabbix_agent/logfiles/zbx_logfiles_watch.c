@@ -0,0 +1,189 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "../../../src/zabbix_agent/logfiles/logfiles.c"
+
+#if defined(HAVE_SYS_INOTIFY_H) && defined(HAVE_SYS_VFS_H)
+/* Steps are applied to a temporary directory created on real file system. Revision expectations are */
+/* relative to the revision returned by the previous successful revision step.                       */
+
+static char	*mock_path(const char *directory, const char *name)
+{
+	return zbx_dsprintf(NULL, "%s/%s", directory, name);
+}
+
+static void	mock_step_revision(zbx_mock_handle_t hstep, const char *directory, zbx_uint64_t *last_revision)
+{
+	const char	*type, *expected;
+	char		*filename;
+	unsigned char	flags;
+	zbx_uint64_t	revision = 0;
+	int		ret;
+
+	type = zbx_mock_get_object_member_string(hstep, "type");
+
+	if (0 == strcmp(type, "log"))
+		flags = ZBX_METRIC_FLAG_LOG_LOG;
+	else if (0 == strcmp(type, "logrt"))
+		flags = ZBX_METRIC_FLAG_LOG_LOGRT;
+	else
+		fail_msg("unknown item type \"%s\"", type);
+
+	filename = mock_path(directory, zbx_mock_get_object_member_string(hstep, "file"));
+	ret = logfiles_watch_get_item_revision(flags, filename, &revision);
+	zbx_free(filename);
+
+	expected = zbx_mock_get_object_member_string(hstep, "expect");
+
+	if (0 == strcmp(expected, "fail"))
+	{
+		zbx_mock_assert_result_eq("revision result", FAIL, ret);
+		return;
+	}
+
+	zbx_mock_assert_result_eq("revision result", SUCCEED, ret);
+
+	if (0 == strcmp(expected, "same"))
+		zbx_mock_assert_uint64_eq("revision", *last_revision, revision);
+	else if (0 == strcmp(expected, "changed"))
+	{
+		if (revision <= *last_revision)
+			fail_msg("expected revision newer than " ZBX_FS_UI64 " but got " ZBX_FS_UI64, *last_revision,
+					revision);
+	}
+	else if (0 != strcmp(expected, "watched"))
+		fail_msg("unknown expectation \"%s\"", expected);
+
+	*last_revision = revision;
+}
+
+static void	mock_step_destroy(void)
+{
+	int	fd = -1;
+
+	if (NULL != tracker)
+		fd = tracker->fd;
+
+	zbx_logfiles_watch_destroy();
+
+	if (NULL != tracker)
+		fail_msg("tracker was not released");
+
+	if (-1 != fd && -1 != fcntl(fd, F_GETFD))
+		fail_msg("inotify descriptor was not closed");
+}
+
+static void	mock_run_steps(const char *directory, zbx_vector_str_t *files)
+{
+	zbx_mock_handle_t	hsteps, hstep;
+	zbx_uint64_t		last_revision = 0;
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hsteps, &hstep))
+	{
+		const char	*op = zbx_mock_get_object_member_string(hstep, "op");
+
+		if (0 == strcmp(op, "init"))
+		{
+			char	*error = NULL;
+
+			if (SUCCEED != zbx_logfiles_watch_init(&error))
+				fail_msg("cannot initialize tracker: %s", error);
+		}
+		else if (0 == strcmp(op, "destroy"))
+		{
+			mock_step_destroy();
+		}
+		else if (0 == strcmp(op, "revision"))
+		{
+			mock_step_revision(hstep, directory, &last_revision);
+		}
+		else if (0 == strcmp(op, "create"))
+		{
+			char	*path;
+			int	fd;
+
+			path = mock_path(directory, zbx_mock_get_object_member_string(hstep, "file"));
+
+			if (-1 == (fd = open(path, O_CREAT | O_WRONLY, 0600)))
+				fail_msg("cannot create file \"%s\": %s", path, zbx_strerror(errno));
+
+			close(fd);
+			zbx_vector_str_append(files, path);
+		}
+		else if (0 == strcmp(op, "remove"))
+		{
+			char	*path;
+
+			path = mock_path(directory, zbx_mock_get_object_member_string(hstep, "file"));
+
+			if (0 != unlink(path))
+				fail_msg("cannot remove file \"%s\": %s", path, zbx_strerror(errno));
+
+			zbx_free(path);
+		}
+		else
+			fail_msg("unknown operation \"%s\"", op);
+	}
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	char			directory[] = "/tmp/zbx_logfiles_watch_XXXXXX";
+	zbx_vector_str_t	files;
+
+	ZBX_UNUSED(state);
+
+	if (NULL == mkdtemp(directory))
+		fail_msg("cannot create temporary directory: %s", zbx_strerror(errno));
+
+	/* files in the temporary directory are accessed with the real system calls */
+	zbx_set_mock_real_path(directory);
+
+	if (SUCCEED != logfiles_watch_is_local_fs(directory))
+	{
+		rmdir(directory);
+		skip();
+	}
+
+	zbx_vector_str_create(&files);
+
+	mock_run_steps(directory, &files);
+	mock_step_destroy();
+
+	for (int i = 0; i < files.values_num; i++)
+		(void)unlink(files.values[i]);
+
+	zbx_vector_str_clear_ext(&files, zbx_str_free);
+	zbx_vector_str_destroy(&files);
+
+	if (0 != rmdir(directory))
+		fail_msg("cannot remove temporary directory: %s", zbx_strerror(errno));
+
+	zbx_set_mock_real_path(NULL);
+}
+#else
+void	zbx_mock_test_entry(void **state)
+{
+	ZBX_UNUSED(state);
+
+	skip();
+}
+#endif
@@ -0,0 +1,218 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "../../../src/zabbix_server/cachehistory/trigger_eval.c"
+
+static int	mock_evaluations_num = 0;
+
+char	*__wrap_zbx_dc_expand_user_macros_in_func_params(const char *params, zbx_uint64_t hostid);
+int	__wrap_zbx_evaluate_function(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item, const char *function,
+		const char *parameter, const zbx_timespec_t *ts, char **error);
+void	__wrap_zbx_vc_flush_stats(void);
+
+/* replaces user macros with values from test case */
+char	*__wrap_zbx_dc_expand_user_macros_in_func_params(const char *params, zbx_uint64_t hostid)
+{
+	zbx_mock_handle_t	hmacros, hmacro;
+	char			*out;
+
+	ZBX_UNUSED(hostid);
+
+	out = zbx_strdup(NULL, params);
+	hmacros = zbx_mock_get_parameter_handle("in.macros");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hmacros, &hmacro))
+	{
+		const char	*macro, *value;
+		char		*ptr;
+
+		macro = zbx_mock_get_object_member_string(hmacro, "macro");
+		value = zbx_mock_get_object_member_string(hmacro, "value");
+
+		while (NULL != (ptr = strstr(out, macro)))
+		{
+			size_t	l = (size_t)(ptr - out), r = l + strlen(macro) - 1;
+
+			zbx_replace_string(&out, l, &r, value);
+		}
+	}
+
+	return out;
+}
+
+/* returns result configured for the function call with expanded parameters */
+int	__wrap_zbx_evaluate_function(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item, const char *function,
+		const char *parameter, const zbx_timespec_t *ts, char **error)
+{
+	zbx_mock_handle_t	hresults, hresult, herror;
+	const char		*str;
+
+	ZBX_UNUSED(ts);
+
+	mock_evaluations_num++;
+	hresults = zbx_mock_get_parameter_handle("in.results");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hresults, &hresult))
+	{
+		if (item->itemid != zbx_mock_get_object_member_uint64(hresult, "itemid") ||
+				0 != strcmp(function, zbx_mock_get_object_member_string(hresult, "function")) ||
+				0 != strcmp(parameter, zbx_mock_get_object_member_string(hresult, "parameter")))
+		{
+			continue;
+		}
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hresult, "error", &herror) &&
+				ZBX_MOCK_SUCCESS == zbx_mock_string(herror, &str))
+		{
+			*error = zbx_strdup(NULL, str);
+			return FAIL;
+		}
+
+		zbx_variant_set_str(value, zbx_strdup(NULL, zbx_mock_get_object_member_string(hresult, "value")));
+
+		return SUCCEED;
+	}
+
+	fail_msg("unexpected function call %s(%s)", function, parameter);
+
+	return FAIL;
+}
+
+void	__wrap_zbx_vc_flush_stats(void)
+{
+}
+
+static void	mock_read_functions(zbx_hashset_t *funcs, zbx_vector_uint64_t *itemids)
+{
+	zbx_mock_handle_t	hfuncs, hfunc;
+
+	hfuncs = zbx_mock_get_parameter_handle("in.functions");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hfuncs, &hfunc))
+	{
+		zbx_func_t	func_local = {0};
+
+		func_local.itemid = zbx_mock_get_object_member_uint64(hfunc, "itemid");
+		func_local.function = zbx_strdup(NULL, zbx_mock_get_object_member_string(hfunc, "function"));
+		func_local.parameter = zbx_strdup(NULL, zbx_mock_get_object_member_string(hfunc, "parameter"));
+		func_local.type = ZBX_FUNCTION_TYPE_HISTORY;
+		func_local.timespec.sec = 1000;
+		zbx_variant_set_none(&func_local.value);
+
+		if (NULL != zbx_hashset_search(funcs, &func_local))
+			fail_msg("duplicate function %s(%s)", func_local.function, func_local.parameter);
+
+		zbx_hashset_insert(funcs, &func_local, sizeof(func_local));
+		zbx_vector_uint64_append(itemids, func_local.itemid);
+	}
+
+	zbx_vector_uint64_sort(itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_uniq(itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+}
+
+static void	mock_check_functions(zbx_hashset_t *funcs)
+{
+	zbx_mock_handle_t	hfuncs, hfunc, herror;
+	int			funcs_num = 0;
+
+	hfuncs = zbx_mock_get_parameter_handle("out.functions");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hfuncs, &hfunc))
+	{
+		zbx_func_t	func_local, *func;
+		const char	*error;
+
+		func_local.itemid = zbx_mock_get_object_member_uint64(hfunc, "itemid");
+		func_local.function = (char *)zbx_mock_get_object_member_string(hfunc, "function");
+		func_local.parameter = (char *)zbx_mock_get_object_member_string(hfunc, "parameter");
+		func_local.timespec.sec = 1000;
+		func_local.timespec.ns = 0;
+
+		if (NULL == (func = (zbx_func_t *)zbx_hashset_search(funcs, &func_local)))
+			fail_msg("function %s(%s) not found", func_local.function, func_local.parameter);
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hfunc, "error", &herror) &&
+				ZBX_MOCK_SUCCESS == zbx_mock_string(herror, &error))
+		{
+			zbx_mock_assert_int_eq("value type", ZBX_VARIANT_ERR, func->value.type);
+			zbx_mock_assert_str_eq("error", error, func->value.data.err);
+		}
+		else
+		{
+			zbx_mock_assert_int_eq("value type", ZBX_VARIANT_STR, func->value.type);
+			zbx_mock_assert_str_eq("value", zbx_mock_get_object_member_string(hfunc, "value"),
+					func->value.data.str);
+		}
+
+		funcs_num++;
+	}
+
+	zbx_mock_assert_int_eq("functions", funcs_num, funcs->num_data);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_hashset_t		funcs;
+	zbx_vector_uint64_t	itemids;
+	zbx_history_sync_item_t	*history_items, *items = NULL;
+	int			*errcodes, *items_err = NULL, items_num = 0, evaluated_num = 0;
+
+	ZBX_UNUSED(state);
+
+	zbx_hashset_create_ext(&funcs, 0, func_hash_func, func_compare_func, func_clean,
+			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+	zbx_vector_uint64_create(&itemids);
+
+	mock_read_functions(&funcs, &itemids);
+
+	/* all items are retrieved with history, so no items are requested from configuration cache */
+	history_items = (zbx_history_sync_item_t *)zbx_calloc(NULL, (size_t)itemids.values_num,
+			sizeof(zbx_history_sync_item_t));
+	errcodes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)itemids.values_num);
+
+	for (int i = 0; i < itemids.values_num; i++)
+	{
+		history_items[i].itemid = itemids.values[i];
+		history_items[i].value_type = ITEM_VALUE_TYPE_FLOAT;
+		history_items[i].status = ITEM_STATUS_ACTIVE;
+		history_items[i].state = ITEM_STATE_NORMAL;
+		history_items[i].history = 1;
+		history_items[i].host.hostid = 1;
+		history_items[i].host.status = HOST_STATUS_MONITORED;
+		zbx_strlcpy(history_items[i].host.host, "host", sizeof(history_items[i].host.host));
+		zbx_snprintf(history_items[i].key_orig, sizeof(history_items[i].key_orig), "key" ZBX_FS_UI64,
+				itemids.values[i]);
+		errcodes[i] = SUCCEED;
+	}
+
+	evaluate_item_functions(&funcs, &itemids, history_items, errcodes, &items, &items_err, &items_num,
+			&evaluated_num);
+
+	zbx_mock_assert_int_eq("evaluated functions", (int)zbx_mock_get_parameter_uint64("out.evaluated"),
+			evaluated_num);
+	zbx_mock_assert_int_eq("value cache evaluations", evaluated_num, mock_evaluations_num);
+	zbx_mock_assert_int_eq("items retrieved from configuration cache", 0, items_num);
+
+	mock_check_functions(&funcs);
+
+	zbx_free(errcodes);
+	zbx_free(history_items);
+	zbx_vector_uint64_destroy(&itemids);
+	zbx_hashset_destroy(&funcs);
+}
@@ -0,0 +1,296 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "../../../src/zabbix_server/cachehistory/cachehistory_server.c"
+
+/* every zbx_time() call advances the clock by one second, so stage times count the stage boundaries */
+static double		mock_clock = 1000;
+static double		mock_clock_first = 0;
+static double		mock_stage_time[ZBX_HC_SYNC_STAGE_COUNT];
+static zbx_hc_item_t	*mock_items = NULL;
+static int		mock_items_num = 0, mock_items_popped = 0, mock_items_pushed = 0;
+static int		mock_add_history_ret = SUCCEED;
+
+double	__wrap_zbx_time(void);
+void	__wrap_zbx_hc_pop_items(zbx_vector_hc_item_ptr_t *history_items);
+void	__wrap_zbx_hc_push_items(zbx_vector_hc_item_ptr_t *history_items);
+int	__wrap_zbx_dc_config_lock_triggers_by_history_items(zbx_vector_hc_item_ptr_t *history_items,
+		zbx_vector_uint64_t *triggerids);
+void	__wrap_zbx_hc_get_item_values(zbx_dc_history_t *history, zbx_vector_hc_item_ptr_t *history_items);
+void	__wrap_zbx_hc_free_item_values(zbx_dc_history_t *history, int history_num);
+void	__wrap_zbx_dc_config_history_sync_get_items_by_itemids(zbx_history_sync_item_t *items,
+		const zbx_uint64_t *itemids, int *errcodes, size_t num, unsigned int mode);
+void	__wrap_zbx_dc_config_clean_history_sync_items(zbx_history_sync_item_t *items, int *errcodes, size_t num);
+void	__wrap_zbx_dc_config_history_sync_get_connector_filters(
+		zbx_vector_connector_filter_t *connector_filters_history,
+		zbx_vector_connector_filter_t *connector_filters_events);
+zbx_dc_um_handle_t	*__wrap_zbx_dc_open_user_macros(void);
+void	__wrap_zbx_dc_close_user_macros(zbx_dc_um_handle_t *um_handle);
+int	__wrap_zbx_vc_add_values(zbx_vector_dc_history_ptr_t *history, int *ret_flush,
+		int config_history_storage_pipelines);
+void	__wrap_zbx_vps_monitor_add_written(zbx_uint64_t values_num);
+void	__wrap_zbx_dc_config_items_apply_changes(const zbx_vector_item_diff_ptr_t *item_diff);
+void	__wrap_zbx_dc_mass_update_trends(const zbx_dc_history_t *history, int history_num, ZBX_DC_TREND **trends,
+		int *trends_num, int compression_age);
+void	__wrap_zbx_db_mass_update_items(const zbx_vector_item_diff_ptr_t *item_diff,
+		const zbx_vector_inventory_value_ptr_t *inventory_values);
+void	__wrap_zbx_dc_get_trigger_timers(zbx_vector_trigger_timer_ptr_t *timers, int now, int soft_limit,
+		int hard_limit);
+void	__wrap_zbx_dc_config_history_sync_get_triggers_by_itemids(zbx_hashset_t *trigger_info,
+		zbx_vector_dc_trigger_t *trigger_order, const zbx_uint64_t *itemids, const zbx_timespec_t *timespecs,
+		int itemids_num);
+void	__wrap_zbx_dc_config_triggers_apply_changes(zbx_vector_trigger_diff_ptr_t *trigger_diff);
+void	__wrap_zbx_dbcache_lock(void);
+void	__wrap_zbx_dbcache_unlock(void);
+int	__wrap_zbx_dbcache_get_history_num(void);
+void	__wrap_zbx_dbcache_set_history_num(int num);
+int	__wrap_zbx_hc_queue_get_size(void);
+int	__wrap_zbx_hc_get_history_compression_age(void);
+void	__wrap_zbx_hc_add_sync_stage_time(const double *stage_time);
+
+double	__wrap_zbx_time(void)
+{
+	mock_clock += 1;
+
+	if (0 == mock_clock_first)
+		mock_clock_first = mock_clock;
+
+	return mock_clock;
+}
+
+void	__wrap_zbx_hc_pop_items(zbx_vector_hc_item_ptr_t *history_items)
+{
+	for (; mock_items_popped < mock_items_num; mock_items_popped++)
+		zbx_vector_hc_item_ptr_append(history_items, &mock_items[mock_items_popped]);
+}
+
+void	__wrap_zbx_hc_push_items(zbx_vector_hc_item_ptr_t *history_items)
+{
+	mock_items_pushed += history_items->values_num;
+}
+
+int	__wrap_zbx_dc_config_lock_triggers_by_history_items(zbx_vector_hc_item_ptr_t *history_items,
+		zbx_vector_uint64_t *triggerids)
+{
+	ZBX_UNUSED(triggerids);
+
+	return history_items->values_num;
+}
+
+void	__wrap_zbx_hc_get_item_values(zbx_dc_history_t *history, zbx_vector_hc_item_ptr_t *history_items)
+{
+	for (int i = 0; i < history_items->values_num; i++)
+	{
+		zbx_dc_history_t	*h = &history[i];
+
+		memset(h, 0, sizeof(zbx_dc_history_t));
+		h->itemid = history_items->values[i]->itemid;
+		h->value_type = ITEM_VALUE_TYPE_TEXT;
+		h->value.str = zbx_strdup(NULL, "value");
+		h->ts.sec = (int)time(NULL);
+		h->state = ITEM_STATE_NORMAL;
+	}
+}
+
+void	__wrap_zbx_hc_free_item_values(zbx_dc_history_t *history, int history_num)
+{
+	for (int i = 0; i < history_num; i++)
+		zbx_free(history[i].value.str);
+}
+
+void	__wrap_zbx_dc_config_history_sync_get_items_by_itemids(zbx_history_sync_item_t *items,
+		const zbx_uint64_t *itemids, int *errcodes, size_t num, unsigned int mode)
+{
+	ZBX_UNUSED(mode);
+
+	for (size_t i = 0; i < num; i++)
+	{
+		memset(&items[i], 0, sizeof(zbx_history_sync_item_t));
+		items[i].itemid = itemids[i];
+		items[i].value_type = ITEM_VALUE_TYPE_TEXT;
+		items[i].status = ITEM_STATUS_ACTIVE;
+		items[i].host.status = HOST_STATUS_MONITORED;
+		items[i].history = 1;
+		items[i].history_sec = SEC_PER_DAY;
+		errcodes[i] = SUCCEED;
+	}
+}
+
+void	__wrap_zbx_dc_config_clean_history_sync_items(zbx_history_sync_item_t *items, int *errcodes, size_t num)
+{
+	ZBX_UNUSED(items);
+	ZBX_UNUSED(errcodes);
+	ZBX_UNUSED(num);
+}
+
+void	__wrap_zbx_dc_config_history_sync_get_connector_filters(
+		zbx_vector_connector_filter_t *connector_filters_history,
+		zbx_vector_connector_filter_t *connector_filters_events)
+{
+	ZBX_UNUSED(connector_filters_history);
+	ZBX_UNUSED(connector_filters_events);
+}
+
+zbx_dc_um_handle_t	*__wrap_zbx_dc_open_user_macros(void)
+{
+	return NULL;
+}
+
+void	__wrap_zbx_dc_close_user_macros(zbx_dc_um_handle_t *um_handle)
+{
+	ZBX_UNUSED(um_handle);
+}
+
+int	__wrap_zbx_vc_add_values(zbx_vector_dc_history_ptr_t *history, int *ret_flush,
+		int config_history_storage_pipelines)
+{
+	ZBX_UNUSED(history);
+	ZBX_UNUSED(config_history_storage_pipelines);
+
+	*ret_flush = (SUCCEED == mock_add_history_ret ? FLUSH_SUCCEED : FLUSH_FAIL);
+
+	return mock_add_history_ret;
+}
+
+void	__wrap_zbx_vps_monitor_add_written(zbx_uint64_t values_num)
+{
+	ZBX_UNUSED(values_num);
+}
+
+void	__wrap_zbx_dc_config_items_apply_changes(const zbx_vector_item_diff_ptr_t *item_diff)
+{
+	ZBX_UNUSED(item_diff);
+}
+
+void	__wrap_zbx_dc_mass_update_trends(const zbx_dc_history_t *history, int history_num, ZBX_DC_TREND **trends,
+		int *trends_num, int compression_age)
+{
+	ZBX_UNUSED(history);
+	ZBX_UNUSED(history_num);
+	ZBX_UNUSED(trends);
+	ZBX_UNUSED(compression_age);
+
+	*trends_num = 0;
+}
+
+void	__wrap_zbx_db_mass_update_items(const zbx_vector_item_diff_ptr_t *item_diff,
+		const zbx_vector_inventory_value_ptr_t *inventory_values)
+{
+	ZBX_UNUSED(item_diff);
+	ZBX_UNUSED(inventory_values);
+}
+
+void	__wrap_zbx_dc_get_trigger_timers(zbx_vector_trigger_timer_ptr_t *timers, int now, int soft_limit,
+		int hard_limit)
+{
+	ZBX_UNUSED(timers);
+	ZBX_UNUSED(now);
+	ZBX_UNUSED(soft_limit);
+	ZBX_UNUSED(hard_limit);
+}
+
+void	__wrap_zbx_dc_config_history_sync_get_triggers_by_itemids(zbx_hashset_t *trigger_info,
+		zbx_vector_dc_trigger_t *trigger_order, const zbx_uint64_t *itemids, const zbx_timespec_t *timespecs,
+		int itemids_num)
+{
+	ZBX_UNUSED(trigger_info);
+	ZBX_UNUSED(trigger_order);
+	ZBX_UNUSED(itemids);
+	ZBX_UNUSED(timespecs);
+	ZBX_UNUSED(itemids_num);
+}
+
+void	__wrap_zbx_dc_config_triggers_apply_changes(zbx_vector_trigger_diff_ptr_t *trigger_diff)
+{
+	ZBX_UNUSED(trigger_diff);
+}
+
+void	__wrap_zbx_dbcache_lock(void)
+{
+}
+
+void	__wrap_zbx_dbcache_unlock(void)
+{
+}
+
+int	__wrap_zbx_dbcache_get_history_num(void)
+{
+	return mock_items_num;
+}
+
+void	__wrap_zbx_dbcache_set_history_num(int num)
+{
+	ZBX_UNUSED(num);
+}
+
+int	__wrap_zbx_hc_queue_get_size(void)
+{
+	return 0;
+}
+
+int	__wrap_zbx_hc_get_history_compression_age(void)
+{
+	return 0;
+}
+
+void	__wrap_zbx_hc_add_sync_stage_time(const double *stage_time)
+{
+	for (int i = 0; i < ZBX_HC_SYNC_STAGE_COUNT; i++)
+		mock_stage_time[i] += stage_time[i];
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	const char		*stages[ZBX_HC_SYNC_STAGE_COUNT] = {"prepare", "history", "trends", "items",
+						"triggers", "export"};
+	zbx_events_funcs_t	events_cbs = {0};
+	zbx_mock_handle_t	hstages;
+	int			values_num = 0, triggers_num = 0, more;
+	double			total = 0;
+
+	ZBX_UNUSED(state);
+
+	mock_items_num = (int)zbx_mock_get_parameter_uint64("in.values");
+	mock_items = (zbx_hc_item_t *)zbx_calloc(NULL, (size_t)MAX(mock_items_num, 1), sizeof(zbx_hc_item_t));
+
+	for (int i = 0; i < mock_items_num; i++)
+		mock_items[i].itemid = (zbx_uint64_t)i + 1;
+
+	if (0 == strcmp(zbx_mock_get_parameter_string("in.add_history"), "FAIL"))
+		mock_add_history_ret = FAIL;
+
+	zbx_sync_server_history(&values_num, &triggers_num, &events_cbs, NULL, 0, &more);
+
+	hstages = zbx_mock_get_parameter_handle("out.stages");
+
+	for (int i = 0; i < ZBX_HC_SYNC_STAGE_COUNT; i++)
+	{
+		zbx_mock_assert_double_eq(stages[i], (double)zbx_mock_get_object_member_uint64(hstages, stages[i]),
+				mock_stage_time[i]);
+		total += mock_stage_time[i];
+	}
+
+	/* the stage times must account all the time spent in the sync loop */
+	zbx_mock_assert_double_eq("stage total", mock_clock - mock_clock_first, total);
+
+	zbx_mock_assert_int_eq("synced values", (int)zbx_mock_get_parameter_uint64("out.values"), values_num);
+	zbx_mock_assert_int_eq("returned items", mock_items_num, mock_items_pushed);
+
+	zbx_free(mock_items);
+}
@@ -0,0 +1,155 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "../../../src/zabbix_server/housekeeper/history_partition.c"
+
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+/* Partition bounds are written as timestamps with time zone, MINVALUE or MAXVALUE. Local time calendar */
+/* periods are tested with the time zone set by in.timezone in POSIX TZ format.                          */
+
+static int	mock_bound(const char *value)
+{
+	zbx_timespec_t		ts;
+	zbx_mock_error_t	err;
+
+	if (0 == strcmp(value, "MINVALUE"))
+		return INT_MIN;
+
+	if (0 == strcmp(value, "MAXVALUE"))
+		return INT_MAX;
+
+	if (ZBX_MOCK_SUCCESS != (err = zbx_strtime_to_timespec(value, &ts)))
+		fail_msg("invalid partition bound \"%s\": %s", value, zbx_mock_error_string(err));
+
+	return ts.sec;
+}
+
+static void	mock_partitions_read(const char *path, zbx_vector_hk_partition_t *partitions)
+{
+	zbx_mock_handle_t	hpartitions, hpartition;
+
+	hpartitions = zbx_mock_get_parameter_handle(path);
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hpartitions, &hpartition))
+	{
+		zbx_hk_partition_t	partition;
+
+		partition.name = NULL;
+		partition.from = mock_bound(zbx_mock_get_object_member_string(hpartition, "from"));
+		partition.to = mock_bound(zbx_mock_get_object_member_string(hpartition, "to"));
+
+		zbx_vector_hk_partition_append(partitions, partition);
+	}
+}
+
+static void	mock_test_parse_bound(void)
+{
+#if defined(HAVE_POSTGRESQL)
+	int	ret, value = 0;
+
+	ret = hk_partition_parse_bound(zbx_mock_get_parameter_string("in.spec"),
+			zbx_mock_get_parameter_string("in.keyword"), &value);
+
+	zbx_mock_assert_result_eq("parse result", zbx_mock_str_to_return_code(
+			zbx_mock_get_parameter_string("out.result")), ret);
+
+	if (SUCCEED == ret)
+		zbx_mock_assert_int_eq("bound", mock_bound(zbx_mock_get_parameter_string("out.value")), value);
+#else
+	skip();
+#endif
+}
+
+static void	mock_test_ranges(void)
+{
+	zbx_vector_hk_partition_t	partitions, ranges, expected;
+
+	zbx_vector_hk_partition_create(&partitions);
+	zbx_vector_hk_partition_create(&ranges);
+	zbx_vector_hk_partition_create(&expected);
+
+	mock_partitions_read("in.partitions", &partitions);
+	mock_partitions_read("out.ranges", &expected);
+
+	hk_partition_ranges_get(&partitions, (int)zbx_mock_get_parameter_uint64("in.period"),
+			mock_bound(zbx_mock_get_parameter_string("in.now")), &ranges);
+
+	for (int i = 0; i < ranges.values_num && i < expected.values_num; i++)
+	{
+		zbx_mock_assert_int_eq("range lower bound", expected.values[i].from, ranges.values[i].from);
+		zbx_mock_assert_int_eq("range upper bound", expected.values[i].to, ranges.values[i].to);
+	}
+
+	zbx_mock_assert_int_eq("number of ranges", expected.values_num, ranges.values_num);
+
+	zbx_vector_hk_partition_destroy(&expected);
+	zbx_vector_hk_partition_destroy(&ranges);
+	zbx_vector_hk_partition_destroy(&partitions);
+}
+
+static void	mock_test_expired(void)
+{
+	zbx_vector_hk_partition_t	partitions;
+	int				num;
+
+	zbx_vector_hk_partition_create(&partitions);
+
+	mock_partitions_read("in.partitions", &partitions);
+
+	num = hk_partitions_expired_num(&partitions, (int)zbx_mock_get_parameter_uint64("in.history"),
+			mock_bound(zbx_mock_get_parameter_string("in.now")));
+
+	zbx_mock_assert_int_eq("number of expired partitions", (int)zbx_mock_get_parameter_uint64("out.expired"),
+			num);
+
+	zbx_vector_hk_partition_destroy(&partitions);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	const char	*function, *timezone;
+
+	ZBX_UNUSED(state);
+
+	if (NULL != (timezone = zbx_mock_get_optional_parameter_string("in.timezone")))
+		setenv("TZ", timezone, 1);
+	else
+		setenv("TZ", "UTC", 1);
+
+	tzset();
+
+	function = zbx_mock_get_parameter_string("in.function");
+
+	if (0 == strcmp(function, "parse_bound"))
+		mock_test_parse_bound();
+	else if (0 == strcmp(function, "ranges"))
+		mock_test_ranges();
+	else if (0 == strcmp(function, "expired"))
+		mock_test_expired();
+	else
+		fail_msg("unknown function \"%s\"", function);
+}
+#else
+void	zbx_mock_test_entry(void **state)
+{
+	ZBX_UNUSED(state);
+
+	skip();
+}
+#endif
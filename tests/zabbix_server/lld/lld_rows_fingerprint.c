@@ -0,0 +1,215 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+#include "zbxmockdata.h"
+#include "zbxmockdb.h"
+#include "zbxcommon.h"
+
+#include "../../../src/zabbix_server/lld/lld.c"
+
+/* Rows of two LLD rule runs described by in.first and in.second are checked with the same rows state.    */
+/* Prototypes are read from mocked database - data of the second run is in the data sources with "(2)"     */
+/* suffix. The LLD prototypes revision of the runs defaults to 1 and 2, so the prototypes are read twice   */
+/* unless the second run sets the same prototypes_revision as the first one.                              */
+
+static zbx_uint64_t	mock_prototypes_revision;
+
+int	__wrap_zbx_dc_get_host_revision(zbx_uint64_t hostid, zbx_uint64_t *revision);
+zbx_uint64_t	__wrap_zbx_dc_get_lld_prototypes_revision(void);
+
+int	__wrap_zbx_dc_get_host_revision(zbx_uint64_t hostid, zbx_uint64_t *revision)
+{
+	ZBX_UNUSED(hostid);
+
+	*revision = 1;
+
+	return SUCCEED;
+}
+
+zbx_uint64_t	__wrap_zbx_dc_get_lld_prototypes_revision(void)
+{
+	return mock_prototypes_revision;
+}
+
+static void	mock_rows_read(zbx_mock_handle_t hrun, zbx_vector_lld_row_ptr_t *lld_rows,
+		const zbx_vector_lld_override_ptr_t *overrides)
+{
+	zbx_mock_handle_t	hrows, hrow, hoverrides, hoverride;
+
+	hrows = zbx_mock_get_object_member_handle(hrun, "rows");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hrows, &hrow))
+	{
+		zbx_lld_row_t	*lld_row;
+		const char	*data;
+
+		data = zbx_mock_get_object_member_string(hrow, "data");
+
+		lld_row = (zbx_lld_row_t *)zbx_malloc(NULL, sizeof(zbx_lld_row_t));
+
+		if (SUCCEED != zbx_json_open(data, &lld_row->jp_row))
+			fail_msg("invalid row \"%s\"", data);
+
+		zbx_vector_lld_item_link_ptr_create(&lld_row->item_links);
+		zbx_vector_lld_override_ptr_create(&lld_row->overrides);
+		zbx_vector_lld_row_ptr_append(lld_rows, lld_row);
+
+		if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(hrow, "overrides", &hoverrides))
+			continue;
+
+		while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hoverrides, &hoverride))
+		{
+			zbx_uint64_t	overrideid;
+			int		i;
+
+			if (ZBX_MOCK_SUCCESS != zbx_mock_uint64(hoverride, &overrideid))
+				fail_msg("invalid override identifier");
+
+			for (i = 0; i < overrides->values_num; i++)
+			{
+				if (overrides->values[i]->overrideid == overrideid)
+					break;
+			}
+
+			if (i == overrides->values_num)
+				fail_msg("unknown override " ZBX_FS_UI64, overrideid);
+
+			zbx_vector_lld_override_ptr_append(&lld_row->overrides, overrides->values[i]);
+		}
+	}
+}
+
+static void	mock_overrides_read(zbx_mock_handle_t hrun, zbx_vector_lld_override_ptr_t *overrides)
+{
+	zbx_mock_handle_t	hoverrides, hoverride, hoperations, hoperation;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(hrun, "overrides", &hoverrides))
+		return;
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hoverrides, &hoverride))
+	{
+		zbx_lld_override_t	*override;
+
+		override = (zbx_lld_override_t *)zbx_malloc(NULL, sizeof(zbx_lld_override_t));
+		override->overrideid = zbx_mock_get_object_member_uint64(hoverride, "overrideid");
+		override->step = zbx_mock_get_object_member_int(hoverride, "step");
+		override->stop = (unsigned char)zbx_mock_get_object_member_int(hoverride, "stop");
+
+		lld_filter_init(&override->filter);
+		override->filter.evaltype = zbx_mock_get_object_member_int(hoverride, "evaltype");
+		zbx_vector_lld_override_operation_create(&override->override_operations);
+		zbx_vector_lld_override_ptr_append(overrides, override);
+
+		hoperations = zbx_mock_get_object_member_handle(hoverride, "operations");
+
+		while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hoperations, &hoperation))
+		{
+			zbx_lld_override_operation_t	*op;
+
+			op = (zbx_lld_override_operation_t *)zbx_malloc(NULL, sizeof(zbx_lld_override_operation_t));
+			memset(op, 0, sizeof(zbx_lld_override_operation_t));
+			zbx_vector_db_tag_ptr_create(&op->tags);
+			zbx_vector_uint64_create(&op->templateids);
+
+			op->override_operationid = zbx_mock_get_object_member_uint64(hoperation, "id");
+			op->overrideid = override->overrideid;
+			op->operationtype = (unsigned char)zbx_mock_get_object_member_int(hoperation, "type");
+			op->value = zbx_strdup(NULL, zbx_mock_get_object_member_string(hoperation, "value"));
+			op->status = (unsigned char)zbx_mock_get_object_member_int(hoperation, "status");
+
+			zbx_vector_lld_override_operation_append(&override->override_operations, op);
+		}
+	}
+}
+
+static void	mock_lifetime_read(zbx_mock_handle_t hrun, zbx_lld_lifetime_t *lifetime,
+		zbx_lld_lifetime_t *enabled_lifetime)
+{
+	zbx_mock_handle_t	hlifetime;
+
+	lifetime->type = ZBX_LLD_LIFETIME_TYPE_AFTER;
+	lifetime->duration = 7 * SEC_PER_DAY;
+	enabled_lifetime->type = ZBX_LLD_LIFETIME_TYPE_NEVER;
+	enabled_lifetime->duration = 0;
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hrun, "lifetime", &hlifetime))
+		lifetime->duration = zbx_mock_get_object_member_int(hlifetime, "duration");
+}
+
+static int	mock_check_rows(const char *path, zbx_uint64_t lld_ruleid, zbx_uint64_t prototypes_revision,
+		zbx_lld_rows_state_t *rows_state)
+{
+	zbx_mock_handle_t		hrun, hrevision;
+	zbx_vector_lld_row_ptr_t	lld_rows;
+	zbx_vector_lld_macro_path_ptr_t	lld_macro_paths;
+	zbx_vector_lld_override_ptr_t	overrides;
+	zbx_lld_lifetime_t		lifetime, enabled_lifetime;
+	int				ret;
+
+	hrun = zbx_mock_get_parameter_handle(path);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hrun, "prototypes_revision", &hrevision) &&
+			ZBX_MOCK_SUCCESS != zbx_mock_uint64(hrevision, &prototypes_revision))
+	{
+		fail_msg("invalid prototypes revision");
+	}
+
+	mock_prototypes_revision = prototypes_revision;
+
+	zbx_vector_lld_row_ptr_create(&lld_rows);
+	zbx_vector_lld_macro_path_ptr_create(&lld_macro_paths);
+	zbx_vector_lld_override_ptr_create(&overrides);
+
+	mock_overrides_read(hrun, &overrides);
+	mock_rows_read(hrun, &lld_rows, &overrides);
+	mock_lifetime_read(hrun, &lifetime, &enabled_lifetime);
+
+	ret = lld_rows_check_unchanged(lld_ruleid, 1, &lld_rows, &lld_macro_paths, &overrides, &lifetime,
+			&enabled_lifetime, 1000, rows_state);
+
+	zbx_vector_lld_row_ptr_clear_ext(&lld_rows, lld_row_free);
+	zbx_vector_lld_row_ptr_destroy(&lld_rows);
+	zbx_vector_lld_macro_path_ptr_destroy(&lld_macro_paths);
+	zbx_vector_lld_override_ptr_clear_ext(&overrides, lld_override_free);
+	zbx_vector_lld_override_ptr_destroy(&overrides);
+
+	return ret;
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_lld_rows_state_t	rows_state;
+	zbx_uint64_t		lld_ruleid;
+	int			ret;
+
+	ZBX_UNUSED(state);
+
+	zbx_mockdb_init();
+
+	lld_ruleid = zbx_mock_get_parameter_uint64("in.lld_ruleid");
+
+	memset(&rows_state, 0, sizeof(rows_state));
+	rows_state.itemid = lld_ruleid;
+
+	zbx_mock_assert_result_eq("first check", FAIL, mock_check_rows("in.first", lld_ruleid, 1, &rows_state));
+	ret = mock_check_rows("in.second", lld_ruleid, 2, &rows_state);
+
+	zbx_mockdb_destroy();
+
+	zbx_mock_assert_result_eq("second check", zbx_mock_str_to_return_code(
+			zbx_mock_get_parameter_string("out.return")), ret);
+}
@@ -71,5 +71,7 @@ zbx_mock_error_t	zbx_timespec_to_strtime(const zbx_timespec_t *ts, char *buffer,
 
 /* miscelanious functions */
 void	zbx_set_fopen_mock_callback(FILE *(*fopen_callback)(const char *, const char *));
+void	zbx_set_mock_real_path(const char *path);
+int	zbx_mock_is_real_path(const char *path);
 
 #endif	/* ZABBIX_MOCK_DATA_H */
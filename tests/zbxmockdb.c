@@ -67,6 +67,7 @@ struct zbx_db_result
 zbx_db_result_t	__fwd_zbx_db_select(const char *fmt, ...);
 zbx_db_result_t	__wrap_zbx_db_select_n_basic(const char *query, int n);
 int	__wrap___zbx_db_execute(const char *fmt, ...);
+int	__wrap_zbx_db_vexecute(const char *fmt, va_list args);
 int	__wrap_zbx_db_commit(void);
 
 /* zbx_mockdb_t:queries hashset support */
@@ -277,6 +278,14 @@ int	__wrap___zbx_db_execute(const char *fmt, ...)
 	return 0;
 }
 
+int	__wrap_zbx_db_vexecute(const char *fmt, va_list args)
+{
+	ZBX_UNUSED(fmt);
+	ZBX_UNUSED(args);
+
+	return 0;
+}
+
 int	__wrap_zbx_db_execute_multiple_query(const char *query, const char *field_name, zbx_vector_uint64_t *ids)
 {
 	ZBX_UNUSED(query);
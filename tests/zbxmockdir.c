@@ -25,9 +25,13 @@
 
 #include "zbxcommon.h"
 
+DIR	*__real_opendir(const char *name);
+struct dirent	*__real_readdir(DIR *dirp);
+
 DIR	*__wrap_opendir(const char *name)
 {
-	ZBX_UNUSED(name);
+	if (SUCCEED == zbx_mock_is_real_path(name))
+		return __real_opendir(name);
 
 	errno = ENOENT;
 	return NULL;
@@ -35,7 +39,9 @@ DIR	*__wrap_opendir(const char *name)
 
 struct dirent	*__wrap_readdir(DIR *dirp)
 {
-	ZBX_UNUSED(dirp);
+	/* only directories under real path can be opened */
+	if (NULL != dirp)
+		return __real_readdir(dirp);
 
 	errno = EBADF;
 	return NULL;
@@ -39,6 +39,9 @@ static zbx_mock_handle_t	fragments;
 
 static FILE	*(*fopen_mock_callback)(const char *, const char *) = NULL;
 
+/* files under this path are accessed directly instead of using test case data */
+static const char	*real_path = NULL;
+
 struct zbx_mock_IO_FILE
 {
 	const char	*contents;
@@ -61,6 +64,7 @@ int	__wrap___fxstat(int __ver, int __fildes, struct stat *__stat_buf);
 #endif
 
 int	__real_open(const char *path, int oflag, ...);
+ssize_t	__real_read(int fildes, void *buf, size_t nbyte);
 int	__real_stat(const char *path, struct stat *buf);
 int	__real_fstat(int __fildes, struct stat *__stat_buf);
 #ifdef HAVE_FXSTAT
@@ -83,6 +87,14 @@ static int	is_profiler_path(const char *path)
 	return FAIL;
 }
 
+int	zbx_mock_is_real_path(const char *path)
+{
+	if (NULL == real_path || 0 != strncmp(path, real_path, strlen(real_path)))
+		return FAIL;
+
+	return SUCCEED;
+}
+
 static int	is_mock_stream(FILE *stream)
 {
 	int	i;
@@ -228,7 +240,7 @@ static int	next_fragment(void)
 
 int	__wrap_open(const char *path, int oflag, ...)
 {
-	if (SUCCEED == is_profiler_path(path))
+	if (SUCCEED == is_profiler_path(path) || SUCCEED == zbx_mock_is_real_path(path))
 	{
 		va_list	args;
 		int	fd;
@@ -258,7 +270,8 @@ ssize_t	__wrap_read(int fildes, void *buf, size_t nbyte)
 {
 	size_t	mv_len;
 
-	ZBX_UNUSED(fildes);
+	if (NULL != real_path && INT_MAX != fildes)
+		return __real_read(fildes, buf, nbyte);
 
 	if (frag_pos >= frag_data + frag_sz)
 	{
@@ -329,7 +342,7 @@ int	__wrap_stat(const char *path, struct stat *buf)
 	zbx_mock_error_t	error;
 	zbx_mock_handle_t	handle;
 
-	if (SUCCEED == is_profiler_path(path))
+	if (SUCCEED == is_profiler_path(path) || SUCCEED == zbx_mock_is_real_path(path))
 		return __real_stat(path, buf);
 
 	if (ZBX_MOCK_SUCCESS == (error = zbx_mock_file(path, &handle)))
@@ -364,7 +377,7 @@ int	__wrap___xstat(int ver, const char *pathname, struct stat *buf)
 {
 	ZBX_UNUSED(ver);
 
-	if (SUCCEED == is_profiler_path(pathname))
+	if (SUCCEED == is_profiler_path(pathname) || SUCCEED == zbx_mock_is_real_path(pathname))
 		return __real_stat(pathname, buf);
 
 	return __wrap_stat(pathname, buf);
@@ -386,3 +399,17 @@ void	zbx_set_fopen_mock_callback(FILE *(*fopen_callback)(const char *, const cha
 {
 	fopen_mock_callback = fopen_callback;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: let test access files under the specified path directly           *
+ *                                                                            *
+ * Comments: Used by tests working with files in temporary directory. Data    *
+ *           read from other than mocked file descriptors is read directly    *
+ *           while the path is set.                                           *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_set_mock_real_path(const char *path)
+{
+	real_path = path;
+}
@@ -367,12 +367,14 @@ final class CItemData {
 			'zabbix[host,,maintenance]',
 			'zabbix[host,<type>,available]',
 			'zabbix[host,discovery,interfaces]',
+			'zabbix[history_sync,<stage>]',
 			'zabbix[hosts]',
 			'zabbix[items]',
 			'zabbix[items_unsupported]',
 			'zabbix[java,,<param>]',
 			'zabbix[lld_queue]',
 			'zabbix[preprocessing_queue]',
+			'zabbix[preprocessing_regexp_cache,<parameter>]',
 			'zabbix[process,<type>,<mode>,<state>]',
 			'zabbix[proxy,<name>,<param>]',
 			'zabbix[proxy,discovery]',
@@ -388,6 +390,7 @@ final class CItemData {
 			'zabbix[stats,<ip>,<port>,queue,<from>,<to>]',
 			'zabbix[stats,<ip>,<port>]',
 			'zabbix[tcache, cache, <parameter>]',
+			'zabbix[trigger_functions,<counter>]',
 			'zabbix[triggers]',
 			'zabbix[uptime]',
 			'zabbix[vcache,buffer,<mode>]',
@@ -2841,6 +2844,13 @@ final class CItemData {
 					ITEM_TYPE_INTERNAL => 'config/items/itemtypes/internal#discovery.interfaces'
 				]
 			],
+			'zabbix[history_sync,<stage>]' => [
+				'description' => _('Total time in seconds spent by history syncers in a synchronization stage. Valid stages are: prepare, history, trends, items, triggers and export.'),
+				'value_type' => ITEM_VALUE_TYPE_FLOAT,
+				'documentation_link' => [
+					ITEM_TYPE_INTERNAL => 'config/items/itemtypes/internal#history.sync'
+				]
+			],
 			'zabbix[hosts]' => [
 				'description' => _('Number of monitored hosts'),
 				'value_type' => ITEM_VALUE_TYPE_UINT64,
@@ -2883,6 +2893,13 @@ final class CItemData {
 					ITEM_TYPE_INTERNAL => 'config/items/itemtypes/internal#preprocessing.queue'
 				]
 			],
+			'zabbix[preprocessing_regexp_cache,<parameter>]' => [
+				'description' => _('Compiled regular expression cache statistics of preprocessing workers. Valid parameters are: all, hits, phits, misses, pmisses, evictions and items.'),
+				'value_type' => null,
+				'documentation_link' => [
+					ITEM_TYPE_INTERNAL => 'config/items/itemtypes/internal#preprocessing.regexp.cache'
+				]
+			],
 			'zabbix[process,<type>,<mode>,<state>]' => [
 				'description' => _('Time a particular Zabbix process or a group of processes (identified by <type> and <mode>) spent in <state> in percentage.'),
 				'value_type' => ITEM_VALUE_TYPE_FLOAT,
@@ -2988,6 +3005,13 @@ final class CItemData {
 					ITEM_TYPE_INTERNAL => 'config/items/itemtypes/internal#tcache'
 				]
 			],
+			'zabbix[trigger_functions,<counter>]' => [
+				'description' => _('Total number of trigger functions processed by history syncers. Valid counters are: references (function references in recalculated triggers), unique (distinct functions) and evaluated (functions actually evaluated after sharing results of identical calls).'),
+				'value_type' => ITEM_VALUE_TYPE_UINT64,
+				'documentation_link' => [
+					ITEM_TYPE_INTERNAL => 'config/items/itemtypes/internal#trigger.functions'
+				]
+			],
 			'zabbix[triggers]' => [
 				'description' => _('Number of triggers in Zabbix database.'),
 				'value_type' => ITEM_VALUE_TYPE_UINT64,
@@ -17,7 +17,7 @@ define('ZABBIX_VERSION',		'7.2.0alpha1');
 define('ZABBIX_API_VERSION',	'7.2.0');
 define('ZABBIX_EXPORT_VERSION',	'7.2');
 
-define('ZABBIX_DB_VERSION',		7010013);
+define('ZABBIX_DB_VERSION',		7010037);
 
 define('DB_VERSION_SUPPORTED',						0);
 define('DB_VERSION_LOWER_THAN_MINIMUM',				1);